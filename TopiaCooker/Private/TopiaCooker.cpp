@@ -0,0 +1,177 @@
+#include <Topia.h>
+#include <StaticMesh.h>
+#include <DerivedData/DerivedDataCache.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+
+using namespace topia;
+
+/**
+ * Offline cooker: loads a glTF mesh, runs the build steps the renderer needs and writes the result as a .tmesh that
+ * FStaticMesh::LoadCooked maps without any processing. With -ddc, build results are shared with other cooks through a derived
+ * data cache, so cooking an unchanged source with the same settings again only costs hashing it.
+ */
+
+static void sPrintUsage()
+{
+    printf("Usage: TopiaCooker [options] <input.gltf|glb> <output.tmesh>\n");
+    printf("  -tangents      Generate MikkTSpace tangents\n");
+    printf("  -lods N        Number of LODs including LOD 0 (default 4, 1 = none)\n");
+    printf("  -nomeshlets    Don't build meshlets\n");
+    printf("  -noquantize    Don't build quantized vertex streams\n");
+    printf("  -precision16   16 bit normals and tangents in the quantized streams\n");
+    printf("  -ddc Dir       Cache the build results in Dir\n");
+    printf("  -ddcsize MB    Size limit of the cache (default 4096)\n");
+    printf("  -bench N       After cooking, compare N loads of the glTF file against N loads of the cooked file\n");
+}
+
+static double sMilliseconds(std::chrono::high_resolution_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Start).count();
+}
+
+static void sBenchmark(const std::wstring& Input, const std::wstring& Output, const FStaticMeshBuildSettings& Settings, FDerivedDataCache* pCache,
+    u32 NumRuns)
+{
+    double GLTFTime = 0.0, BuildTime = 0.0, CachedTime = 0.0, CookedTime = 0.0, VerifiedTime = 0.0;
+    for (u32 Run = 0; Run < NumRuns; ++Run)
+    {
+        FStaticMesh Mesh;
+        auto Start = std::chrono::high_resolution_clock::now();
+        Mesh.LoadFromGLTF(Input);
+        GLTFTime += sMilliseconds(Start);
+
+        Start = std::chrono::high_resolution_clock::now();
+        Mesh.Build(Input, Settings);
+        BuildTime += sMilliseconds(Start);
+
+        if (pCache != nullptr)
+        {
+            Start = std::chrono::high_resolution_clock::now();
+            Mesh.Build(Input, Settings, pCache);
+            CachedTime += sMilliseconds(Start);
+        }
+
+        Start = std::chrono::high_resolution_clock::now();
+        Mesh.LoadCooked(Output);
+        CookedTime += sMilliseconds(Start);
+
+        Start = std::chrono::high_resolution_clock::now();
+        Mesh.LoadCooked(Output, true);
+        VerifiedTime += sMilliseconds(Start);
+    }
+
+    printf("Average of %u runs:\n", NumRuns);
+    printf("  glTF load               %9.3f ms\n", GLTFTime / NumRuns);
+    printf("  glTF load and build     %9.3f ms\n", BuildTime / NumRuns);
+    if (pCache != nullptr)
+    {
+        printf("  Build from the cache    %9.3f ms\n", CachedTime / NumRuns);
+    }
+    printf("  Cooked load             %9.3f ms\n", CookedTime / NumRuns);
+    printf("  Cooked load, verified   %9.3f ms\n", VerifiedTime / NumRuns);
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    FStaticMeshBuildSettings Settings;
+    u32 NumBenchmarkRuns = 0;
+    u64 CacheSize = 4096;
+    std::wstring Input, Output, CacheDirectory;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const wchar_t* pArg = argv[i];
+        if (wcscmp(pArg, L"-tangents") == 0)
+        {
+            Settings.bGenerateTangents = true;
+        }
+        else if (wcscmp(pArg, L"-nomeshlets") == 0)
+        {
+            Settings.bBuildMeshlets = false;
+        }
+        else if (wcscmp(pArg, L"-noquantize") == 0)
+        {
+            Settings.bQuantize = false;
+        }
+        else if (wcscmp(pArg, L"-precision16") == 0)
+        {
+            Settings.Precision = EOctahedralPrecision::Bits16;
+        }
+        else if (wcscmp(pArg, L"-lods") == 0 && i + 1 < argc)
+        {
+            Settings.LODs.NumLODs = std::max(1u, u32(wcstoul(argv[++i], nullptr, 10)));
+        }
+        else if (wcscmp(pArg, L"-ddc") == 0 && i + 1 < argc)
+        {
+            CacheDirectory = argv[++i];
+        }
+        else if (wcscmp(pArg, L"-ddcsize") == 0 && i + 1 < argc)
+        {
+            CacheSize = wcstoull(argv[++i], nullptr, 10);
+        }
+        else if (wcscmp(pArg, L"-bench") == 0 && i + 1 < argc)
+        {
+            NumBenchmarkRuns = u32(wcstoul(argv[++i], nullptr, 10));
+        }
+        else if (pArg[0] != L'-' && Input.empty())
+        {
+            Input = pArg;
+        }
+        else if (pArg[0] != L'-' && Output.empty())
+        {
+            Output = pArg;
+        }
+        else
+        {
+            sPrintUsage();
+            return 1;
+        }
+    }
+
+    if (Input.empty() || Output.empty())
+    {
+        sPrintUsage();
+        return 1;
+    }
+
+    std::unique_ptr<FDerivedDataCache> Cache;
+    if (!CacheDirectory.empty())
+    {
+        Cache.reset(new FDerivedDataCache(CacheDirectory, CacheSize * 1024 * 1024));
+    }
+
+    FStaticMesh Mesh;
+    const auto Start = std::chrono::high_resolution_clock::now();
+    if (!Mesh.Build(Input, Settings, Cache.get()))
+    {
+        printf("Can't load %ls\n", Input.c_str());
+        return 1;
+    }
+    if (!Mesh.SaveCooked(Output))
+    {
+        printf("Can't write %ls\n", Output.c_str());
+        return 1;
+    }
+
+    u32 NumVertices = 0, NumTriangles = 0;
+    for (const FStaticMeshSection& Section : Mesh.GetSections())
+    {
+        NumVertices += Section.NumVertices;
+        NumTriangles += Section.GetNumIndices() / 3;
+    }
+    printf("Cooked %ls: %u sections, %u vertices, %u triangles, %u LODs in %.1f ms\n", Output.c_str(), u32(Mesh.GetSections().size()),
+        NumVertices, NumTriangles, Mesh.GetNumLODs(), sMilliseconds(Start));
+
+    if (NumBenchmarkRuns > 0)
+    {
+        sBenchmark(Input, Output, Settings, Cache.get(), NumBenchmarkRuns);
+    }
+    if (Cache)
+    {
+        Cache->LogStats();
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace topia
+{
+    static constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87ull;
+    static constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr u64 PRIME64_3 = 0x165667B19E3779F9ull;
+    static constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+    static inline u64 sRotateLeft(u64 Value, u32 Bits)
+    {
+        return (Value << Bits) | (Value >> (64 - Bits));
+    }
+
+    // Unaligned little endian reads, memcpy compiles to a single load
+    static inline u64 sRead64(const u8* p)
+    {
+        u64 Value;
+        memcpy(&Value, p, sizeof(Value));
+        return Value;
+    }
+
+    static inline u32 sRead32(const u8* p)
+    {
+        u32 Value;
+        memcpy(&Value, p, sizeof(Value));
+        return Value;
+    }
+
+    static inline u64 sRound(u64 Accumulator, u64 Input)
+    {
+        Accumulator += Input * PRIME64_2;
+        return sRotateLeft(Accumulator, 31) * PRIME64_1;
+    }
+
+    static inline u64 sMergeRound(u64 Accumulator, u64 Value)
+    {
+        Accumulator ^= sRound(0, Value);
+        return Accumulator * PRIME64_1 + PRIME64_4;
+    }
+
+    u64 Hash64(const void* pData, size_t Size, u64 Seed)
+    {
+        const u8* p = static_cast<const u8*>(pData);
+        const u8* pEnd = p + Size;
+        u64 Hash;
+
+        if (Size >= 32)
+        {
+            // Four independent lanes over 32 byte stripes
+            u64 V1 = Seed + PRIME64_1 + PRIME64_2;
+            u64 V2 = Seed + PRIME64_2;
+            u64 V3 = Seed;
+            u64 V4 = Seed - PRIME64_1;
+            const u8* pLimit = pEnd - 32;
+            do
+            {
+                V1 = sRound(V1, sRead64(p));
+                V2 = sRound(V2, sRead64(p + 8));
+                V3 = sRound(V3, sRead64(p + 16));
+                V4 = sRound(V4, sRead64(p + 24));
+                p += 32;
+            } while (p <= pLimit);
+
+            Hash = sRotateLeft(V1, 1) + sRotateLeft(V2, 7) + sRotateLeft(V3, 12) + sRotateLeft(V4, 18);
+            Hash = sMergeRound(Hash, V1);
+            Hash = sMergeRound(Hash, V2);
+            Hash = sMergeRound(Hash, V3);
+            Hash = sMergeRound(Hash, V4);
+        }
+        else
+        {
+            Hash = Seed + PRIME64_5;
+        }
+
+        Hash += u64(Size);
+
+        for (; p + 8 <= pEnd; p += 8)
+        {
+            Hash ^= sRound(0, sRead64(p));
+            Hash = sRotateLeft(Hash, 27) * PRIME64_1 + PRIME64_4;
+        }
+        if (p + 4 <= pEnd)
+        {
+            Hash ^= u64(sRead32(p)) * PRIME64_1;
+            Hash = sRotateLeft(Hash, 23) * PRIME64_2 + PRIME64_3;
+            p += 4;
+        }
+        for (; p < pEnd; ++p)
+        {
+            Hash ^= u64(*p) * PRIME64_5;
+            Hash = sRotateLeft(Hash, 11) * PRIME64_1;
+        }
+
+        // Avalanche
+        Hash ^= Hash >> 33;
+        Hash *= PRIME64_2;
+        Hash ^= Hash >> 29;
+        Hash *= PRIME64_3;
+        Hash ^= Hash >> 32;
+        return Hash;
+    }
+}
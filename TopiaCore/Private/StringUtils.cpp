@@ -1,95 +1,355 @@
+#include "Topia.h"
 #include "StringUtils.h"
 
-#include <locale>
+// The std::string versions wrap the views. ToLower only ever changed ASCII letters, std::tolower with the default "C" locale.
 
 std::string topia::ToLower(const std::string& str)
 {
-    std::string lower_case = str;
-    std::locale loc;
-    for (char& s : lower_case)
-        s = std::tolower(s, loc);
+    std::string lower_case(str.size(), '\0');
+    ToLowerASCII(str, &lower_case[0]);
     return lower_case;
 }
 
 std::wstring topia::ToLower(const std::wstring& str)
 {
-    std::wstring lower_case = str;
-    std::locale loc;
-    for (wchar_t& s : lower_case)
-        s = std::tolower(s, loc);
+    std::wstring lower_case(str.size(), L'\0');
+    ToLowerASCII(str, &lower_case[0]);
     return lower_case;
 }
 
 std::string topia::GetBasePath(const std::string& filePath)
 {
-    size_t lastSlash;
-    if ((lastSlash = filePath.rfind('/')) != std::string::npos)
-        return filePath.substr(0, lastSlash + 1);
-    else if ((lastSlash = filePath.rfind('\\')) != std::string::npos)
-        return filePath.substr(0, lastSlash + 1);
-    else
-        return "";
+    return std::string(GetBasePathView(filePath));
 }
 
 std::wstring topia::GetBasePath(const std::wstring& filePath)
 {
-    size_t lastSlash;
-    if ((lastSlash = filePath.rfind(L'/')) != std::wstring::npos)
-        return filePath.substr(0, lastSlash + 1);
-    else if ((lastSlash = filePath.rfind(L'\\')) != std::wstring::npos)
-        return filePath.substr(0, lastSlash + 1);
-    else
-        return L"";
+    return std::wstring(GetBasePathView(filePath));
 }
 
 std::string topia::RemoveBasePath(const std::string& filePath)
 {
-    size_t lastSlash;
-    if ((lastSlash = filePath.rfind('/')) != std::string::npos)
-        return filePath.substr(lastSlash + 1, std::string::npos);
-    else if ((lastSlash = filePath.rfind('\\')) != std::string::npos)
-        return filePath.substr(lastSlash + 1, std::string::npos);
-    else
-        return filePath;
+    return std::string(RemoveBasePathView(filePath));
 }
 
 std::wstring topia::RemoveBasePath(const std::wstring& filePath)
 {
-    size_t lastSlash;
-    if ((lastSlash = filePath.rfind(L'/')) != std::string::npos)
-        return filePath.substr(lastSlash + 1, std::string::npos);
-    else if ((lastSlash = filePath.rfind(L'\\')) != std::string::npos)
-        return filePath.substr(lastSlash + 1, std::string::npos);
-    else
-        return filePath;
+    return std::wstring(RemoveBasePathView(filePath));
 }
 
 std::string topia::GetFileExtension(const std::string& filePath)
 {
-    std::string fileName = RemoveBasePath(filePath);
-    size_t extOffset = fileName.rfind('.');
-    if (extOffset == std::wstring::npos)
-        return "";
-
-    return fileName.substr(extOffset + 1);
+    return std::string(GetFileExtensionView(filePath));
 }
 
 std::wstring topia::GetFileExtension(const std::wstring& filePath)
 {
-    std::wstring fileName = RemoveBasePath(filePath);
-    size_t extOffset = fileName.rfind(L'.');
-    if (extOffset == std::wstring::npos)
-        return L"";
-
-    return fileName.substr(extOffset + 1);
+    return std::wstring(GetFileExtensionView(filePath));
 }
 
 std::string topia::RemoveExtension(const std::string& filePath)
 {
-    return filePath.substr(0, filePath.rfind("."));
+    return std::string(RemoveExtensionView(filePath));
 }
 
 std::wstring topia::RemoveExtension(const std::wstring& filePath)
 {
-    return filePath.substr(0, filePath.rfind(L"."));
+    return std::wstring(RemoveExtensionView(filePath));
+}
+
+namespace topia
+{
+    template <typename CharType>
+    static TStringView<CharType> sGetBasePath(TStringView<CharType> path)
+    {
+        for (size_t i = path.size(); i-- > 0;)
+        {
+            if (path[i] == CharType('/') || path[i] == CharType('\\'))
+            {
+                return path.substr(0, i + 1);
+            }
+        }
+        return TStringView<CharType>();
+    }
+
+    template <typename CharType>
+    static TStringView<CharType> sGetExtension(TStringView<CharType> path)
+    {
+        const TStringView<CharType> fileName = path.substr(sGetBasePath(path).size());
+        const size_t extOffset = fileName.rfind(CharType('.'));
+        return extOffset == TStringView<CharType>::npos ? TStringView<CharType>() : fileName.substr(extOffset + 1);
+    }
+
+    template <typename CharType>
+    static TStringView<CharType> sRemoveExtension(TStringView<CharType> path)
+    {
+        // Only a dot in the file name starts an extension, not one in a directory name
+        const size_t fileStart = sGetBasePath(path).size();
+        const size_t extOffset = path.substr(fileStart).rfind(CharType('.'));
+        return extOffset == TStringView<CharType>::npos ? path : path.substr(0, fileStart + extOffset);
+    }
+
+    FStringView GetBasePathView(FStringView path) { return sGetBasePath(path); }
+    FWStringView GetBasePathView(FWStringView path) { return sGetBasePath(path); }
+    FStringView RemoveBasePathView(FStringView path) { return path.substr(sGetBasePath(path).size()); }
+    FWStringView RemoveBasePathView(FWStringView path) { return path.substr(sGetBasePath(path).size()); }
+    FStringView GetFileExtensionView(FStringView path) { return sGetExtension(path); }
+    FWStringView GetFileExtensionView(FWStringView path) { return sGetExtension(path); }
+    FStringView RemoveExtensionView(FStringView path) { return sRemoveExtension(path); }
+    FWStringView RemoveExtensionView(FWStringView path) { return sRemoveExtension(path); }
+
+    template <typename CharType>
+    static inline CharType sToLowerASCII(CharType c)
+    {
+        return (c >= CharType('A') && c <= CharType('Z')) ? CharType(c + ('a' - 'A')) : c;
+    }
+
+    void ToLowerASCII(FStringView src, char* dst)
+    {
+        size_t i = 0;
+#if defined(TOPIA_USE_SSE)
+        // Bytes of 0x80 and above are negative in the signed compares, they are never in 'A'..'Z'
+        const __m128i beforeA = _mm_set1_epi8('A' - 1);
+        const __m128i afterZ = _mm_set1_epi8('Z' + 1);
+        const __m128i caseBit = _mm_set1_epi8(0x20);
+        for (; i + 16 <= src.size(); i += 16)
+        {
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i));
+            const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, beforeA), _mm_cmplt_epi8(chars, afterZ));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(chars, _mm_and_si128(upper, caseBit)));
+        }
+#endif
+        for (; i < src.size(); ++i)
+        {
+            dst[i] = sToLowerASCII(src[i]);
+        }
+    }
+
+    void ToLowerASCII(FWStringView src, wchar_t* dst)
+    {
+        size_t i = 0;
+#if defined(TOPIA_USE_SSE)
+        if (sizeof(wchar_t) == 2)
+        {
+            // Characters of 0x8000 and above are negative, they are never in 'A'..'Z'
+            const __m128i beforeA = _mm_set1_epi16('A' - 1);
+            const __m128i afterZ = _mm_set1_epi16('Z' + 1);
+            const __m128i caseBit = _mm_set1_epi16(0x20);
+            for (; i + 8 <= src.size(); i += 8)
+            {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i));
+                const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(chars, beforeA), _mm_cmplt_epi16(chars, afterZ));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(chars, _mm_and_si128(upper, caseBit)));
+            }
+        }
+#endif
+        for (; i < src.size(); ++i)
+        {
+            dst[i] = sToLowerASCII(src[i]);
+        }
+    }
+
+    static constexpr u32 REPLACEMENT_CHARACTER = 0xFFFD;
+
+    static inline wchar_t* sWriteWide(wchar_t* dst, u32 codePoint)
+    {
+        if (sizeof(wchar_t) == 2 && codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            *dst++ = wchar_t(0xD800 + (codePoint >> 10));
+            *dst++ = wchar_t(0xDC00 + (codePoint & 0x3FF));
+        }
+        else
+        {
+            *dst++ = wchar_t(codePoint);
+        }
+        return dst;
+    }
+
+    size_t UTF8ToWide(FStringView src, wchar_t* dst)
+    {
+        const u8* in = reinterpret_cast<const u8*>(src.data());
+        const u8* const inEnd = in + src.size();
+        wchar_t* const dstStart = dst;
+
+        while (in < inEnd)
+        {
+#if defined(TOPIA_USE_SSE)
+            // Runs of ASCII, the common case for paths and identifiers, are widened 16 characters at a time
+            const __m128i zero = _mm_setzero_si128();
+            while (inEnd - in >= 16)
+            {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                if (_mm_movemask_epi8(bytes) != 0)
+                {
+                    break;
+                }
+                const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+                const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+                if (sizeof(wchar_t) == 2)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), low);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), high);
+                }
+                else
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(low, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), _mm_unpackhi_epi16(low, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_unpacklo_epi16(high, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12), _mm_unpackhi_epi16(high, zero));
+                }
+                in += 16;
+                dst += 16;
+            }
+            if (in == inEnd)
+            {
+                break;
+            }
+#endif
+            const u8 lead = *in;
+            if (lead < 0x80)
+            {
+                *dst++ = wchar_t(lead);
+                ++in;
+                continue;
+            }
+
+            u32 length, codePoint, minCodePoint;
+            if ((lead & 0xE0) == 0xC0)
+            {
+                length = 2; codePoint = lead & 0x1F; minCodePoint = 0x80;
+            }
+            else if ((lead & 0xF0) == 0xE0)
+            {
+                length = 3; codePoint = lead & 0x0F; minCodePoint = 0x800;
+            }
+            else if ((lead & 0xF8) == 0xF0)
+            {
+                length = 4; codePoint = lead & 0x07; minCodePoint = 0x10000;
+            }
+            else
+            {
+                *dst++ = wchar_t(REPLACEMENT_CHARACTER);
+                ++in;
+                continue;
+            }
+
+            // A truncated sequence is replaced byte by byte, so the next valid character is not lost
+            u32 valid = 1;
+            while (valid < length && in + valid < inEnd && (in[valid] & 0xC0) == 0x80)
+            {
+                codePoint = (codePoint << 6) | (in[valid] & 0x3F);
+                ++valid;
+            }
+            if (valid < length)
+            {
+                *dst++ = wchar_t(REPLACEMENT_CHARACTER);
+                ++in;
+                continue;
+            }
+            if (codePoint < minCodePoint || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+            {
+                codePoint = REPLACEMENT_CHARACTER;
+            }
+            dst = sWriteWide(dst, codePoint);
+            in += length;
+        }
+        return size_t(dst - dstStart);
+    }
+
+    size_t WideToUTF8(FWStringView src, char* dst)
+    {
+        const wchar_t* in = src.data();
+        const wchar_t* const inEnd = in + src.size();
+        char* const dstStart = dst;
+
+        while (in < inEnd)
+        {
+#if defined(TOPIA_USE_SSE)
+            // Runs of ASCII are narrowed 16 characters at a time
+            const __m128i zero = _mm_setzero_si128();
+            while (inEnd - in >= 16)
+            {
+                __m128i low, high;
+                if (sizeof(wchar_t) == 2)
+                {
+                    low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                    high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8));
+                }
+                else
+                {
+                    // Signed saturation keeps values of 0x8000 and above out of the ASCII range
+                    low = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4)));
+                    high = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)));
+                }
+                const __m128i nonASCII = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(-0x80));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonASCII, zero)) != 0xFFFF)
+                {
+                    break;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(low, high));
+                in += 16;
+                dst += 16;
+            }
+            if (in == inEnd)
+            {
+                break;
+            }
+#endif
+            u32 codePoint = u32(*in++);
+            if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint <= 0xDFFF)
+            {
+                if (codePoint <= 0xDBFF && in < inEnd && u32(*in) >= 0xDC00 && u32(*in) <= 0xDFFF)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (u32(*in++) - 0xDC00);
+                }
+                else
+                {
+                    codePoint = REPLACEMENT_CHARACTER;
+                }
+            }
+            else if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+            {
+                codePoint = REPLACEMENT_CHARACTER;
+            }
+
+            if (codePoint < 0x80)
+            {
+                *dst++ = char(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                *dst++ = char(0xC0 | (codePoint >> 6));
+                *dst++ = char(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                *dst++ = char(0xE0 | (codePoint >> 12));
+                *dst++ = char(0x80 | ((codePoint >> 6) & 0x3F));
+                *dst++ = char(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                *dst++ = char(0xF0 | (codePoint >> 18));
+                *dst++ = char(0x80 | ((codePoint >> 12) & 0x3F));
+                *dst++ = char(0x80 | ((codePoint >> 6) & 0x3F));
+                *dst++ = char(0x80 | (codePoint & 0x3F));
+            }
+        }
+        return size_t(dst - dstStart);
+    }
+
+    std::wstring UTF8ToWide(FStringView src)
+    {
+        std::wstring result(src.size(), L'\0');
+        result.resize(UTF8ToWide(src, &result[0]));
+        return result;
+    }
+
+    std::string WideToUTF8(FWStringView src)
+    {
+        std::string result(src.size() * UTF8_PER_WIDE_CHAR, '\0');
+        result.resize(WideToUTF8(src, &result[0]));
+        return result;
+    }
 }
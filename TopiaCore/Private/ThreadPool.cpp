@@ -0,0 +1,122 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+namespace topia
+{
+    FThreadPool::FThreadPool(u32 NumThreads)
+    {
+        if (NumThreads == 0)
+        {
+            NumThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        }
+        Threads.reserve(NumThreads);
+        for (u32 t = 0; t < NumThreads; ++t)
+        {
+            Threads.emplace_back([this]() { WorkerMain(); });
+        }
+    }
+
+    FThreadPool::~FThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            bStopping = true;
+        }
+        WorkAvailable.notify_all();
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+    }
+
+    void FThreadPool::WorkerMain()
+    {
+        for (;;)
+        {
+            std::function<void()> Task;
+            {
+                std::unique_lock<std::mutex> Lock(Mutex);
+                WorkAvailable.wait(Lock, [this]() { return bStopping || !Queue.empty(); });
+                if (Queue.empty())
+                {
+                    return;
+                }
+                Task = std::move(Queue.front());
+                Queue.pop_front();
+            }
+            Task();
+        }
+    }
+
+    namespace
+    {
+        /** Shared by the threads that run the items of one ParallelFor, a helper that starts after the last item only reads Next */
+        struct FParallelLoop
+        {
+            std::atomic<u32> Next{ 0 };
+            std::atomic<u32> NumDone{ 0 };
+            u32 NumItems = 0;
+            const std::function<void(u32)>* pFunction = nullptr;   // Valid until NumDone reaches NumItems
+            std::mutex Mutex;
+            std::condition_variable Done;
+
+            void Run()
+            {
+                for (;;)
+                {
+                    const u32 Index = Next.fetch_add(1);
+                    if (Index >= NumItems)
+                    {
+                        return;
+                    }
+                    (*pFunction)(Index);
+                    if (NumDone.fetch_add(1) + 1 == NumItems)
+                    {
+                        std::lock_guard<std::mutex> Lock(Mutex);
+                        Done.notify_all();
+                    }
+                }
+            }
+        };
+    }
+
+    void FThreadPool::ParallelFor(u32 NumItems, const std::function<void(u32)>& Function)
+    {
+        if (NumItems == 0)
+        {
+            return;
+        }
+
+        std::shared_ptr<FParallelLoop> Loop = std::make_shared<FParallelLoop>();
+        Loop->NumItems = NumItems;
+        Loop->pFunction = &Function;
+
+        // One helper per worker at most, the calling thread takes items too
+        const u32 NumHelpers = std::min(GetNumThreads(), NumItems - 1);
+        if (NumHelpers > 0)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                for (u32 h = 0; h < NumHelpers; ++h)
+                {
+                    Queue.emplace_back([Loop]() { Loop->Run(); });
+                }
+            }
+            if (NumHelpers == 1)
+            {
+                WorkAvailable.notify_one();
+            }
+            else
+            {
+                WorkAvailable.notify_all();
+            }
+        }
+
+        // Every item is taken once the calling thread runs out, wait for the ones still running elsewhere
+        Loop->Run();
+        std::unique_lock<std::mutex> Lock(Loop->Mutex);
+        Loop->Done.wait(Lock, [&Loop, NumItems]() { return Loop->NumDone.load() == NumItems; });
+    }
+}
@@ -1,23 +1,33 @@
 #pragma once
 
 #include <stdarg.h>
+#include <cstdio>
+#include <cwchar>
 #include <string>
 
-#ifndef _CONSOLE
-#include <debugapi.h>
+#if defined(_MSC_VER)
+#define TOPIA_DEBUG_BREAK() __debugbreak()
+#else
+#define TOPIA_DEBUG_BREAK() __builtin_trap()
 #endif
 
+// Print to the console, define it to 0 to send the messages to the debugger output on Windows instead
+#ifndef ENABLE_DEBUG_CONSOLE
 #define ENABLE_DEBUG_CONSOLE 1
+#endif
+
+#if !ENABLE_DEBUG_CONSOLE
+#include <Platforms.h>
+#endif
 
 namespace topia
 {
-#ifdef ENABLE_DEBUG_CONSOLE
+#if ENABLE_DEBUG_CONSOLE
 	inline void Print(const char* msg) { printf("%s", msg); }
-	inline void Print(const wchar_t* msg) { wprintf(L"%ws", msg); }
+	inline void Print(const wchar_t* msg) { wprintf(L"%ls", msg); }
 #else
 	inline void Print(const char* msg) { OutputDebugStringA(msg); }
-
-	inline void Print(const wchar_t* msg) { OutputDebugString(msg); }
+	inline void Print(const wchar_t* msg) { OutputDebugStringW(msg); }
 #endif
 
 	inline void Printf(const char* format, ...)
@@ -25,7 +35,7 @@ namespace topia
 		char buffer[256];
 		va_list ap;
 		va_start(ap, format);
-		vsprintf_s(buffer, 256, format, ap);
+		vsnprintf(buffer, 256, format, ap);
 		va_end(ap);
 		Print(buffer);
 	}
@@ -47,7 +57,7 @@ namespace topia
 		char buffer[256];
 		va_list ap;
 		va_start(ap, format);
-		vsprintf_s(buffer, 256, format, ap);
+		vsnprintf(buffer, 256, format, ap);
 		va_end(ap);
 		Print(buffer);
 		Print("\n");
@@ -79,7 +89,7 @@ namespace topia
 #undef HALT
 #endif
 
-#define HALT(...) ERROR(__VA_ARGS__) __debugbreak();
+#define HALT(...) ERROR(__VA_ARGS__) TOPIA_DEBUG_BREAK();
 
 #ifdef RELEASE
 
@@ -104,7 +114,7 @@ namespace topia
 	{                                                                                                          \
 		topia::Print("\nCheck failed in " STRINGIFY_BUILTIN(__FILE__) " @ " STRINGIFY_BUILTIN(__LINE__) "\n"); \
 		topia::PrintSubMessage("\'" #isFalse "\' is false");                                                   \
-		__debugbreak();                                                                                        \
+		TOPIA_DEBUG_BREAK();                                                                                   \
 	}
 
 #define ASSERT(isFalse, ...)                                                                                       \
@@ -114,7 +124,7 @@ namespace topia
 		topia::PrintSubMessage("\'" #isFalse "\' is false");                                                       \
 		topia::PrintSubMessage(__VA_ARGS__);                                                                       \
 		topia::Print("\n");                                                                                        \
-		__debugbreak();                                                                                            \
+		TOPIA_DEBUG_BREAK();                                                                                       \
 	}
 
 #define ASSERT_SUCCEEDED(hr, ...)                                                                                \
@@ -124,7 +134,7 @@ namespace topia
 		topia::PrintSubMessage("hr = 0x%08X", hr);                                                               \
 		topia::PrintSubMessage(__VA_ARGS__);                                                                     \
 		topia::Print("\n");                                                                                      \
-		__debugbreak();                                                                                          \
+		TOPIA_DEBUG_BREAK();                                                                                     \
 	}
 
 #define WARN_ONCE_IF(isTrue, ...)                                                                                    \
@@ -153,4 +163,4 @@ namespace topia
 
 #define BreakIfFailed(hr) \
 	if (FAILED(hr))       \
-	__debugbreak()
+	TOPIA_DEBUG_BREAK()
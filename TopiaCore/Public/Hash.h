@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Topia.h"
+
+namespace topia
+{
+    /**
+     * 64 bit hash of a block of memory with the XXH64 algorithm, for content hashes of files and cache keys. Not cryptographic.
+     * The result is the same on every platform, so it can be stored on disk.
+     */
+    u64 Hash64(const void* pData, size_t Size, u64 Seed = 0);
+}
@@ -1,13 +1,19 @@
 #pragma once
 
-#ifdef TOPIAENGINE_EXPORTS
+#if !defined(_MSC_VER)
+	#define TOPIAENGINE_API __attribute__((visibility("default")))
+#elif defined(TOPIAENGINE_EXPORTS)
 	#define TOPIAENGINE_API _declspec(dllexport)
 #else
 	#define TOPIAENGINE_API _declspec(dllimport)
 #endif
 
 #ifndef TOPIAENGINE_INLINE
-	#define TOPIA_INLINE __forceinline
+	#if defined(_MSC_VER)
+		#define TOPIA_INLINE __forceinline
+	#else
+		#define TOPIA_INLINE inline __attribute__((always_inline))
+	#endif
 #endif
 
 #define TOPIA_CONSTEXPR constexpr
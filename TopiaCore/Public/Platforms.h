@@ -1,5 +1,7 @@
 #pragma once
 
+#if defined(_WIN32)
+
 // Use the C++ standard templated min/max
 #define NOMINMAX
 
@@ -22,3 +24,5 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+
+#endif // _WIN32
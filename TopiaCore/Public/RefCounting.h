@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cassert>
 #include <type_traits>
+#include <utility>
 
 namespace topia
 {
@@ -217,9 +218,14 @@ namespace topia
 	class RefCounter : public T
 	{
 	private:
-		std::atomic<unsigned long> ref_count_ = 1;
+		std::atomic<unsigned long> ref_count_{ 1 };
 
 	public:
+		template <typename... Args>
+		explicit RefCounter(Args&&... args) : T(std::forward<Args>(args)...)
+		{
+		}
+
 		virtual unsigned long AddRef() override { return ++ref_count_; }
 
 		virtual unsigned long Release() override
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <string>
-#include "Platforms.h"
+#include "StringView.h"
 
 namespace topia
 {
@@ -15,4 +15,28 @@ namespace topia
     std::wstring GetFileExtension(const std::wstring& str);
     std::string RemoveExtension(const std::string& str);
     std::wstring RemoveExtension(const std::wstring& str);
+
+    // Views into the path, nothing is allocated. Both '/' and '\\' separate directories.
+    FStringView GetBasePathView(FStringView path);          // "dir/sub/" of "dir/sub/name.ext", with the final slash
+    FWStringView GetBasePathView(FWStringView path);
+    FStringView RemoveBasePathView(FStringView path);       // "name.ext"
+    FWStringView RemoveBasePathView(FWStringView path);
+    FStringView GetFileExtensionView(FStringView path);     // "ext", without the dot
+    FWStringView GetFileExtensionView(FWStringView path);
+    FStringView RemoveExtensionView(FStringView path);      // "dir/sub/name"
+    FWStringView RemoveExtensionView(FWStringView path);
+
+    // Lower case ASCII letters, every other character is copied unchanged, so UTF-8 text stays valid. dst holds src.size()
+    // characters and may be src.data().
+    void ToLowerASCII(FStringView src, char* dst);
+    void ToLowerASCII(FWStringView src, wchar_t* dst);
+
+    // Conversions between UTF-8 and the UTF-16 of the Windows API (UTF-32 where wchar_t is 32 bits). Invalid sequences and
+    // unpaired surrogates become U+FFFD. The buffer versions return the number of characters written: dst holds src.size()
+    // characters for UTF8ToWide and src.size() * UTF8_PER_WIDE_CHAR for WideToUTF8.
+    static constexpr size_t UTF8_PER_WIDE_CHAR = sizeof(wchar_t) == 2 ? 3 : 4;
+    size_t UTF8ToWide(FStringView src, wchar_t* dst);
+    size_t WideToUTF8(FWStringView src, char* dst);
+    std::wstring UTF8ToWide(FStringView src);
+    std::string WideToUTF8(FWStringView src);
 }
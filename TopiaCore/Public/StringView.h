@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace topia
+{
+    /**
+     * Non owning view of a range of characters, in place of std::string_view that C++14 doesn't have. The functions follow
+     * std::string_view so the type can be replaced by it later. The characters are not null terminated and stay valid only as long
+     * as the string they point into.
+     */
+    template <typename CharType>
+    class TStringView
+    {
+    public:
+        using Traits = std::char_traits<CharType>;
+
+        static constexpr size_t npos = size_t(-1);
+
+        constexpr TStringView() = default;
+        constexpr TStringView(const CharType* pInData, size_t InSize) : pData(pInData), Size(InSize) {}
+        TStringView(const CharType* pString) : pData(pString), Size(Traits::length(pString)) {}
+        TStringView(const std::basic_string<CharType>& String) : pData(String.data()), Size(String.size()) {}
+
+        explicit operator std::basic_string<CharType>() const { return std::basic_string<CharType>(pData, Size); }
+
+        constexpr const CharType* data() const { return pData; }
+        constexpr size_t size() const { return Size; }
+        constexpr size_t length() const { return Size; }
+        constexpr bool empty() const { return Size == 0; }
+        constexpr const CharType* begin() const { return pData; }
+        constexpr const CharType* end() const { return pData + Size; }
+        constexpr CharType operator[](size_t Index) const { return pData[Index]; }
+        CharType front() const { return pData[0]; }
+        CharType back() const { return pData[Size - 1]; }
+
+        void remove_prefix(size_t Count) { pData += Count; Size -= Count; }
+        void remove_suffix(size_t Count) { Size -= Count; }
+
+        /** Unlike std::string_view, a Position past the end gives an empty view instead of throwing */
+        TStringView substr(size_t Position, size_t Count = npos) const
+        {
+            Position = std::min(Position, Size);
+            return TStringView(pData + Position, std::min(Count, Size - Position));
+        }
+
+        size_t find(CharType Character, size_t Position = 0) const
+        {
+            for (size_t i = Position; i < Size; ++i)
+            {
+                if (pData[i] == Character)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        size_t rfind(CharType Character, size_t Position = npos) const
+        {
+            for (size_t i = std::min(Position, Size - 1) + 1; Size > 0 && i-- > 0;)
+            {
+                if (pData[i] == Character)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        size_t find_last_of(TStringView Characters, size_t Position = npos) const
+        {
+            for (size_t i = std::min(Position, Size - 1) + 1; Size > 0 && i-- > 0;)
+            {
+                if (Characters.find(pData[i]) != npos)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        int compare(TStringView Other) const
+        {
+            const int Result = Traits::compare(pData, Other.pData, std::min(Size, Other.Size));
+            return Result != 0 ? Result : (Size < Other.Size ? -1 : (Size > Other.Size ? 1 : 0));
+        }
+
+        bool starts_with(TStringView Prefix) const { return Size >= Prefix.Size && Traits::compare(pData, Prefix.pData, Prefix.Size) == 0; }
+        bool ends_with(TStringView Suffix) const { return Size >= Suffix.Size && Traits::compare(pData + Size - Suffix.Size, Suffix.pData, Suffix.Size) == 0; }
+
+        friend bool operator==(TStringView A, TStringView B) { return A.Size == B.Size && Traits::compare(A.pData, B.pData, A.Size) == 0; }
+        friend bool operator!=(TStringView A, TStringView B) { return !(A == B); }
+        friend bool operator<(TStringView A, TStringView B) { return A.compare(B) < 0; }
+
+    private:
+        const CharType* pData = nullptr;
+        size_t Size = 0;
+    };
+
+    using FStringView = TStringView<char>;
+    using FWStringView = TStringView<wchar_t>;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Topia.h"
+#include "Noncopyable.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace topia
+{
+    /**
+     * Worker threads that live as long as the pool, for data parallel loops. Create one up front and pass it to the functions that
+     * take a pool instead of starting and joining threads on every call. ParallelFor may be called from any thread, including from
+     * inside a ParallelFor: the calling thread runs items too and only waits for the items other threads are running.
+     */
+    class FThreadPool : public NonCopyable
+    {
+    public:
+        /** NumThreads workers besides the threads that call ParallelFor, 0 = one less than the number of cores */
+        explicit FThreadPool(u32 NumThreads = 0);
+
+        /** Joins the workers, no ParallelFor may be running */
+        ~FThreadPool();
+
+        u32 GetNumThreads() const { return u32(Threads.size()); }
+
+        /** Call Function(i) for every i in [0, NumItems) on the workers and the calling thread, returns when every call is done */
+        void ParallelFor(u32 NumItems, const std::function<void(u32)>& Function);
+
+    private:
+        void WorkerMain();
+
+        std::vector<std::thread> Threads;
+        std::mutex Mutex;
+        std::condition_variable WorkAvailable;
+        std::deque<std::function<void()>> Queue;
+        bool bStopping = false;
+    };
+
+    /** pPool->ParallelFor, or a plain loop on the calling thread when pPool is null */
+    inline void ParallelFor(FThreadPool* pPool, u32 NumItems, const std::function<void(u32)>& Function)
+    {
+        if (pPool != nullptr)
+        {
+            pPool->ParallelFor(NumItems, Function);
+            return;
+        }
+        for (u32 i = 0; i < NumItems; ++i)
+        {
+            Function(i);
+        }
+    }
+}
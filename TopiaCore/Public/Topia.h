@@ -1,6 +1,5 @@
 #pragma once
 
-#include <Platforms.h>
 #include <Asserts.h>
 #include <StringUtils.h>
 #include <MiscMacros.h>
@@ -18,12 +17,16 @@
     #define TOPIA_CPU_X64
     #define TOPIA_USE_SSE
 
-    #if (defined(__F16C__) || defined(__AVX2__)) && !defined(TOPIA_USE_F16C)
+    // MSVC has no macros for these, /arch:AVX2 implies them. GCC and clang define them with -mf16c, -mlzcnt and -mbmi (or -march).
+    #if (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))) && !defined(TOPIA_USE_F16C)
         #define TOPIA_USE_F16C
     #endif
-    #if (defined(__LZCNT__) || defined(__AVX2__)) && !defined(TOPIA_USE_LZCNT)
+    #if (defined(__LZCNT__) || (defined(_MSC_VER) && defined(__AVX2__))) && !defined(TOPIA_USE_LZCNT)
         #define TOPIA_USE_LZCNT
     #endif
+    #if (defined(__BMI__) || (defined(_MSC_VER) && defined(__AVX2__))) && !defined(TOPIA_USE_TZCNT)
+        #define TOPIA_USE_TZCNT
+    #endif
     #if defined(__AVX__) && !defined(TOPIA_USE_AVX)
         #define TOPIA_USE_AVX
     #endif
@@ -31,16 +34,23 @@
         #define TOPIA_USE_AVX2
     #endif
     #if defined(__clang__)
-        #if defined(__FMA__) && !defined(TOPIA_USE_FMADD)
+        #if defined(__FMA__) && !defined(TOPIA_USE_FMADD) && !defined(TOPIA_CROSS_PLATFORM_DETERMINISTIC)
             #define TOPIA_USE_FMADD
         #endif
     #elif defined(_MSC_VER)
-        #if defined(__AVX2__) && !defined(TOPIA_USE_FMADD) // AVX2 also enables fused multiply add
+        #if defined(__AVX2__) && !defined(TOPIA_USE_FMADD) && !defined(TOPIA_CROSS_PLATFORM_DETERMINISTIC) // AVX2 also enables fused multiply add
+            #define TOPIA_USE_FMADD
+        #endif
+    #elif defined(__GNUC__)
+        #if defined(__FMA__) && !defined(TOPIA_USE_FMADD) && !defined(TOPIA_CROSS_PLATFORM_DETERMINISTIC)
             #define TOPIA_USE_FMADD
         #endif
     #else
         #error Undefined compiler
     #endif
+    #if !defined(_MSC_VER) && !defined(__SSE4_1__)
+        #error TopiaMath needs SSE 4.1, build with -msse4.2 or -mavx2
+    #endif
 #elif defined(__aarch64__) || defined(_M_ARM64)
     #define TOPIA_CPU_ARM64
     #define TOPIA_USE_NEON
@@ -48,9 +58,30 @@
     #error Unsupported CPU arch
 #endif
 
-#define TOPIA_STACK_ALLOC(n)		alloca(n)
+// Everything that includes this header has to be built without contracting a * b + c into a fused multiply add on its own:
+// -ffp-contract=off with GCC and clang (which contract by default), /fp:precise with MSVC. The projects and the CMake build set
+// it. Code that wants FMA uses it explicitly (TOPIA_USE_FMADD). Contraction changes the rounding per call site, which breaks the
+// watertight ray triangle test (the same edge function must round the same way for both triangles of an edge) and determinism.
+
+// Cross platform deterministic mode: define TOPIA_CROSS_PLATFORM_DETERMINISTIC to get bit identical floating point results
+// between compilers, operating systems and CPUs. This disables fused multiply add (it rounds once instead of twice and is not
+// available everywhere) and makes the trigonometric functions in Trigonometry.h use our own polynomial approximations instead
+// of the C runtime. Square roots are left alone, IEEE 754 requires them to be correctly rounded on every platform.
+#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+    #ifdef TOPIA_USE_FMADD
+        #error TOPIA_USE_FMADD cannot be used together with TOPIA_CROSS_PLATFORM_DETERMINISTIC
+    #endif
+    #if defined(__FAST_MATH__) || defined(_M_FP_FAST)
+        #error TOPIA_CROSS_PLATFORM_DETERMINISTIC requires precise floating point (-fno-fast-math / -ffp-model=precise or /fp:precise)
+    #endif
+#endif
 
-#define TOPIA_INLINE __forceinline
+#if defined(_MSC_VER)
+    #include <malloc.h>
+#else
+    #include <alloca.h>
+#endif
+#define TOPIA_STACK_ALLOC(n)		alloca(n)
 
 // Standard types
 using uint = uint32_t;
@@ -74,11 +105,14 @@ static_assert(sizeof(void*) == 8, "Invalid size of pointer");
 #include <algorithm>
 #include <utility>
 #include <cmath>
+#include <cstring>
 #include <sstream>
 #include <functional>
 #include <random>
 #include <type_traits>
 
+// Builds without EASTL (the Linux test build) define TOPIA_NO_EASTL, nothing in the tree depends on it yet
+#ifndef TOPIA_NO_EASTL
 #include <EABase/eabase.h>
 #include <EASTL/algorithm.h>
 #include <EASTL/array.h>
@@ -90,6 +124,7 @@ static_assert(sizeof(void*) == 8, "Invalid size of pointer");
 #include <EASTL/type_traits.h>
 #include <EASTL/utility.h>
 #include <EASTL/vector.h>
+#endif
 
 #if defined(TOPIA_USE_SSE)
     #include <immintrin.h>
@@ -104,7 +139,17 @@ static_assert(sizeof(void*) == 8, "Invalid size of pointer");
 #include <RefCounting.h>
 
 // TODO: Use DirectX12.
+#ifndef ENABLE_RHI_D3D11
 #define ENABLE_RHI_D3D11  0
+#endif
+#ifndef ENABLE_RHI_D3D12
+#if defined(_WIN32)
 #define ENABLE_RHI_D3D12  1
+#else
+#define ENABLE_RHI_D3D12  0
+#endif
+#endif
+#ifndef ENABLE_RHI_VULKAN
 #define ENABLE_RHI_VULKAN 0
+#endif
 
@@ -0,0 +1,313 @@
+#include "Topia.h"
+#include "Compression/LZ4.h"
+
+#include <TopiaMath.h>
+#include <MathUtils.h>
+
+#include <cstring>
+#include <memory>
+
+namespace topia
+{
+	static constexpr u32 MIN_MATCH = 4;
+	static constexpr u32 LAST_LITERALS = 5;     // The last 5 bytes are always literals
+	static constexpr u32 MF_LIMIT = 12;         // The last match starts at least 12 bytes before the end
+	static constexpr u32 MAX_DISTANCE = 65535;
+	static constexpr u32 HASH_LOG = 14;
+	static constexpr u32 SKIP_TRIGGER = 6;      // Search faster through data without matches
+
+	static inline u32 sRead32(const u8* p)
+	{
+		u32 Value;
+		memcpy(&Value, p, sizeof(Value));
+		return Value;
+	}
+
+	static inline u64 sRead64(const u8* p)
+	{
+		u64 Value;
+		memcpy(&Value, p, sizeof(Value));
+		return Value;
+	}
+
+	/** Number of equal bytes at pA and pB, stopping at pALimit */
+	static inline u32 sCountEqual(const u8* pA, const u8* pB, const u8* pALimit)
+	{
+		const u8* pStart = pA;
+		while (pA + 8 <= pALimit)
+		{
+			const u64 Difference = sRead64(pA) ^ sRead64(pB);
+			if (Difference != 0)
+			{
+				const u32 Low = u32(Difference);
+				return u32(pA - pStart) + (Low != 0 ? CountTrailingZeros(Low) : 32 + CountTrailingZeros(u32(Difference >> 32))) / 8;
+			}
+			pA += 8;
+			pB += 8;
+		}
+		while (pA < pALimit && *pA == *pB)
+		{
+			++pA;
+			++pB;
+		}
+		return u32(pA - pStart);
+	}
+
+	static inline u32 sHash(u32 Sequence)
+	{
+		return (Sequence * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	/** Length above 15 continues in bytes of 255 and a final byte below 255 */
+	static inline u8* sWriteLength(u8* pOut, u32 Length)
+	{
+		for (; Length >= 255; Length -= 255)
+		{
+			*pOut++ = 255;
+		}
+		*pOut++ = u8(Length);
+		return pOut;
+	}
+
+	static inline u8* sWriteSequence(u8* pOut, const u8* pLiterals, u32 NumLiterals, u32 Offset, u32 MatchLength)
+	{
+		u8* pToken = pOut++;
+		*pToken = u8(std::min(NumLiterals, 15u) << 4);
+		if (NumLiterals >= 15)
+		{
+			pOut = sWriteLength(pOut, NumLiterals - 15);
+		}
+		memcpy(pOut, pLiterals, NumLiterals);
+		pOut += NumLiterals;
+
+		if (MatchLength > 0)
+		{
+			*pOut++ = u8(Offset);
+			*pOut++ = u8(Offset >> 8);
+			const u32 Length = MatchLength - MIN_MATCH;
+			*pToken |= u8(std::min(Length, 15u));
+			if (Length >= 15)
+			{
+				pOut = sWriteLength(pOut, Length - 15);
+			}
+		}
+		return pOut;
+	}
+
+	u32 CompressLZ4(const void* pSource, u32 Size, void* pDestination, u32 DestinationCapacity)
+	{
+		const u8* pIn = static_cast<const u8*>(pSource);
+		u8* pOut = static_cast<u8*>(pDestination);
+		u8* const pOutStart = pOut;
+
+		// Compress into a scratch buffer when the destination could be too small for the worst case
+		std::unique_ptr<u8[]> Scratch;
+		if (DestinationCapacity < GetMaxCompressedSizeLZ4(Size))
+		{
+			Scratch.reset(new u8[GetMaxCompressedSizeLZ4(Size)]);
+			pOut = Scratch.get();
+		}
+		u8* const pWriteStart = pOut;
+
+		u32 Anchor = 0;
+		if (Size >= MF_LIMIT + 1)
+		{
+			// Positions + 1, 0 is empty
+			std::unique_ptr<u32[]> HashTable(new u32[1u << HASH_LOG]());
+			const u32 MatchLimit = Size - LAST_LITERALS;
+			const u32 LastMatchStart = Size - MF_LIMIT;
+
+			u32 Position = 0;
+			while (Position <= LastMatchStart)
+			{
+				const u32 Sequence = sRead32(pIn + Position);
+				u32& Entry = HashTable[sHash(Sequence)];
+				const u32 Candidate = Entry;
+				Entry = Position + 1;
+
+				if (Candidate == 0 || Position - (Candidate - 1) > MAX_DISTANCE || sRead32(pIn + Candidate - 1) != Sequence)
+				{
+					Position += 1 + ((Position - Anchor) >> SKIP_TRIGGER);
+					continue;
+				}
+
+				u32 Match = Candidate - 1;
+				u32 Start = Position;
+				while (Start > Anchor && Match > 0 && pIn[Start - 1] == pIn[Match - 1])
+				{
+					--Start;
+					--Match;
+				}
+
+				const u32 End = Position + MIN_MATCH + sCountEqual(pIn + Position + MIN_MATCH, pIn + Match + (Position - Start) + MIN_MATCH, pIn + MatchLimit);
+
+				pOut = sWriteSequence(pOut, pIn + Anchor, Start - Anchor, Start - Match, End - Start);
+				Anchor = End;
+				Position = End;
+
+				// Remember a position inside the match, repeats of it are common
+				if (End - 2 <= LastMatchStart)
+				{
+					HashTable[sHash(sRead32(pIn + End - 2))] = End - 2 + 1;
+				}
+			}
+		}
+		pOut = sWriteSequence(pOut, pIn + Anchor, Size - Anchor, 0, 0);
+
+		const u32 CompressedSize = u32(pOut - pWriteStart);
+		if (Scratch)
+		{
+			if (CompressedSize > DestinationCapacity)
+			{
+				return 0;
+			}
+			memcpy(pOutStart, Scratch.get(), CompressedSize);
+		}
+		return CompressedSize;
+	}
+
+	bool DecompressLZ4(const void* pSource, u32 CompressedSize, void* pDestination, u32 DecompressedSize)
+	{
+		const u8* pIn = static_cast<const u8*>(pSource);
+		const u8* const pInEnd = pIn + CompressedSize;
+		u8* pOut = static_cast<u8*>(pDestination);
+		u8* const pOutStart = pOut;
+		u8* const pOutEnd = pOut + DecompressedSize;
+
+		auto ReadLength = [&](u32& ioLength) -> bool
+		{
+			u8 Byte;
+			do
+			{
+				if (pIn >= pInEnd)
+				{
+					return false;
+				}
+				Byte = *pIn++;
+				ioLength += Byte;
+			} while (Byte == 255);
+			return true;
+		};
+
+		while (pIn < pInEnd)
+		{
+			const u8 Token = *pIn++;
+
+			// Most sequences have under 15 literals and a match under 19 bytes, away from the ends of the buffers they are copied in
+			// fixed chunks that may run past them. The input can't end with the literals here, the last sequence is at least 5 bytes.
+			if (Token < 0xF0 && (Token & 15) != 15 && pInEnd - pIn >= 16 + 2 && pOutEnd - pOut >= 32)
+			{
+				const u32 NumLiterals = Token >> 4;
+				memcpy(pOut, pIn, 16);
+				pIn += NumLiterals;
+				pOut += NumLiterals;
+
+				const u32 Offset = u32(pIn[0]) | (u32(pIn[1]) << 8);
+				pIn += 2;
+				const u8* pMatch = pOut - Offset;
+				if (Offset >= 8 && Offset <= u64(pOut - pOutStart))
+				{
+					memcpy(pOut, pMatch, 8);
+					memcpy(pOut + 8, pMatch + 8, 8);
+					memcpy(pOut + 16, pMatch + 16, 2);
+					pOut += (Token & 15) + MIN_MATCH;
+					continue;
+				}
+				if (Offset == 0 || Offset > u64(pOut - pOutStart))
+				{
+					return false;
+				}
+				for (u8* const pMatchEnd = pOut + (Token & 15) + MIN_MATCH; pOut < pMatchEnd;)
+				{
+					*pOut++ = *pMatch++;
+				}
+				continue;
+			}
+
+			u32 NumLiterals = Token >> 4;
+			if (NumLiterals == 15 && !ReadLength(NumLiterals))
+			{
+				return false;
+			}
+			if (NumLiterals > u64(pInEnd - pIn) || NumLiterals > u64(pOutEnd - pOut))
+			{
+				return false;
+			}
+
+			// Away from the ends of the buffers, copy in fixed chunks of 16 bytes that may run past the literals
+			if (u64(pInEnd - pIn) >= NumLiterals + 16ull && u64(pOutEnd - pOut) >= NumLiterals + 16ull)
+			{
+				for (u32 i = 0; i < NumLiterals; i += 16)
+				{
+					memcpy(pOut + i, pIn + i, 16);
+				}
+			}
+			else
+			{
+				memcpy(pOut, pIn, NumLiterals);
+			}
+			pIn += NumLiterals;
+			pOut += NumLiterals;
+
+			// The last sequence has no match
+			if (pIn == pInEnd)
+			{
+				break;
+			}
+
+			if (pInEnd - pIn < 2)
+			{
+				return false;
+			}
+			const u32 Offset = u32(pIn[0]) | (u32(pIn[1]) << 8);
+			pIn += 2;
+			if (Offset == 0 || Offset > u64(pOut - pOutStart))
+			{
+				return false;
+			}
+
+			u32 MatchLength = Token & 15;
+			if (MatchLength == 15 && !ReadLength(MatchLength))
+			{
+				return false;
+			}
+			MatchLength += MIN_MATCH;
+			if (MatchLength > u64(pOutEnd - pOut))
+			{
+				return false;
+			}
+
+			// Chunks are safe when the source is at least a chunk back, they may run past the match but not past the buffer
+			const u8* pMatch = pOut - Offset;
+			u8* const pMatchEnd = pOut + MatchLength;
+			if (Offset >= 16 && pOutEnd - pMatchEnd >= 16)
+			{
+				do
+				{
+					memcpy(pOut, pMatch, 16);
+					pOut += 16;
+					pMatch += 16;
+				} while (pOut < pMatchEnd);
+				pOut = pMatchEnd;
+			}
+			else if (Offset >= 8 && pOutEnd - pMatchEnd >= 8)
+			{
+				do
+				{
+					memcpy(pOut, pMatch, 8);
+					pOut += 8;
+					pMatch += 8;
+				} while (pOut < pMatchEnd);
+				pOut = pMatchEnd;
+			}
+			else
+			{
+				while (pOut < pMatchEnd)
+				{
+					*pOut++ = *pMatch++;
+				}
+			}
+		}
+		return pOut == pOutEnd;
+	}
+} // namespace topia
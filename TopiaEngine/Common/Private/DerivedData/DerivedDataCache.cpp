@@ -0,0 +1,333 @@
+#include "Topia.h"
+#include "Platforms.h"
+#include "DerivedData/DerivedDataCache.h"
+#include "FileSystem/FileUtils.h"
+#include "FileSystem/MappedFile.h"
+
+#include <Hash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#if !defined(_WIN32)
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace topia
+{
+	static constexpr u32 DERIVED_DATA_MAGIC = 0x43444454; // "TDDC"
+	static constexpr u32 DERIVED_DATA_VERSION = 1;
+
+#if defined(_WIN32)
+	static constexpr wchar_t PATH_SEPARATOR = L'\\';
+#else
+	static constexpr wchar_t PATH_SEPARATOR = L'/';
+#endif
+
+	/** Stored after the data of every entry, so the data starts at the beginning of the file with the alignment of the mapping */
+	struct FDerivedDataTrailer
+	{
+		u64 KeyHash = 0;
+		u64 DataHash = 0;           // Hash64 of the data
+		u64 DataSize = 0;
+		double BuildSeconds = 0.0;
+		u32 Magic = DERIVED_DATA_MAGIC;
+		u32 Version = DERIVED_DATA_VERSION;
+	};
+
+	static double sSecondsSince(std::chrono::steady_clock::time_point Start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	}
+
+	FDerivedDataKey::FDerivedDataKey(const char* pType, u32 Version)
+		: Type(pType)
+	{
+		Hash = Hash64(Type.data(), Type.size(), Version);
+	}
+
+	FDerivedDataKey& FDerivedDataKey::Add(const void* pData, size_t Size)
+	{
+		Hash = Hash64(pData, Size, Hash);
+		return *this;
+	}
+
+	std::wstring FDerivedDataKey::GetFileName() const
+	{
+		wchar_t HashText[17];
+		swprintf(HashText, 17, L"%016llx", (unsigned long long)Hash);
+		return std::wstring(Type.begin(), Type.end()) + L"_" + HashText + L".ddc";
+	}
+
+	/** Size and last write time of a cache entry, the time only has to sort correctly */
+	struct FEntry
+	{
+		std::wstring Name;
+		u64 Size;
+		u64 WriteTime;
+	};
+
+#if defined(_WIN32)
+	/** Create every missing directory of Path */
+	static void sCreateDirectories(const std::wstring& Path)
+	{
+		for (size_t Separator = Path.find_first_of(L"\\/", 1); Separator != std::wstring::npos; Separator = Path.find_first_of(L"\\/", Separator + 1))
+		{
+			::CreateDirectoryW(Path.substr(0, Separator).c_str(), nullptr);
+		}
+		::CreateDirectoryW(Path.c_str(), nullptr);
+	}
+
+	/** Mark an entry as used now. Fails while another reader has the entry mapped, which only makes it look older than it is. */
+	static void sTouch(const std::wstring& Path)
+	{
+		HANDLE FileHandle = ::CreateFileW(Path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (FileHandle != INVALID_HANDLE_VALUE)
+		{
+			FILETIME Now;
+			::GetSystemTimeAsFileTime(&Now);
+			::SetFileTime(FileHandle, nullptr, nullptr, &Now);
+			::CloseHandle(FileHandle);
+		}
+	}
+
+	/** Every .ddc file in Directory, returns their total size */
+	static u64 sListEntries(const std::wstring& Directory, std::vector<FEntry>& OutEntries)
+	{
+		u64 TotalSize = 0;
+		WIN32_FIND_DATAW FindData;
+		HANDLE FindHandle = ::FindFirstFileW((Directory + L"*.ddc").c_str(), &FindData);
+		if (FindHandle != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				if (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				{
+					continue;
+				}
+				FEntry Entry;
+				Entry.Name = FindData.cFileName;
+				Entry.Size = (u64(FindData.nFileSizeHigh) << 32) | FindData.nFileSizeLow;
+				Entry.WriteTime = (u64(FindData.ftLastWriteTime.dwHighDateTime) << 32) | FindData.ftLastWriteTime.dwLowDateTime;
+				TotalSize += Entry.Size;
+				OutEntries.push_back(std::move(Entry));
+			} while (::FindNextFileW(FindHandle, &FindData));
+			::FindClose(FindHandle);
+		}
+		return TotalSize;
+	}
+
+	/** Entries that are mapped can't be deleted, they are in use anyway */
+	static bool sDeleteEntry(const std::wstring& Path)
+	{
+		return ::DeleteFileW(Path.c_str()) != 0;
+	}
+#else
+	/** Create every missing directory of Path */
+	static void sCreateDirectories(const std::wstring& Path)
+	{
+		const std::string Utf8Path = WideToUTF8(Path);
+		for (size_t Separator = Utf8Path.find('/', 1); Separator != std::string::npos; Separator = Utf8Path.find('/', Separator + 1))
+		{
+			::mkdir(Utf8Path.substr(0, Separator).c_str(), 0755);
+		}
+		::mkdir(Utf8Path.c_str(), 0755);
+	}
+
+	/** Mark an entry as used now */
+	static void sTouch(const std::wstring& Path)
+	{
+		::utimensat(AT_FDCWD, WideToUTF8(Path).c_str(), nullptr, 0);
+	}
+
+	/** Every .ddc file in Directory, returns their total size */
+	static u64 sListEntries(const std::wstring& Directory, std::vector<FEntry>& OutEntries)
+	{
+		const std::string Utf8Directory = WideToUTF8(Directory);
+		DIR* pDirectory = ::opendir(Utf8Directory.c_str());
+		if (pDirectory == nullptr)
+		{
+			return 0;
+		}
+
+		u64 TotalSize = 0;
+		while (const dirent* pEntry = ::readdir(pDirectory))
+		{
+			const size_t Length = strlen(pEntry->d_name);
+			struct stat Stat;
+			if (Length < 4 || strcmp(pEntry->d_name + Length - 4, ".ddc") != 0
+				|| ::stat((Utf8Directory + pEntry->d_name).c_str(), &Stat) != 0 || !S_ISREG(Stat.st_mode))
+			{
+				continue;
+			}
+			FEntry Entry;
+			Entry.Name = UTF8ToWide(pEntry->d_name);
+			Entry.Size = u64(Stat.st_size);
+			Entry.WriteTime = u64(Stat.st_mtim.tv_sec) * 1000000000ull + u64(Stat.st_mtim.tv_nsec);
+			TotalSize += Entry.Size;
+			OutEntries.push_back(std::move(Entry));
+		}
+		::closedir(pDirectory);
+		return TotalSize;
+	}
+
+	/** Readers that have the entry mapped keep their data */
+	static bool sDeleteEntry(const std::wstring& Path)
+	{
+		return ::unlink(WideToUTF8(Path).c_str()) == 0;
+	}
+#endif
+
+	FDerivedDataCache::FDerivedDataCache(const std::wstring& InDirectory, u64 InMaxSize, bool bInVerifyHashes)
+		: Directory(InDirectory)
+		, MaxSize(InMaxSize)
+		, bVerifyHashes(bInVerifyHashes)
+	{
+		if (!Directory.empty() && Directory.back() != L'\\' && Directory.back() != L'/')
+		{
+			Directory += PATH_SEPARATOR;
+		}
+		sCreateDirectories(Directory.substr(0, Directory.size() - 1));
+
+		// Measures the directory, and catches up with entries other processes added since the last run
+		Trim();
+	}
+
+	bool FDerivedDataCache::Get(const FDerivedDataKey& Key, FDerivedData& OutData)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		const std::wstring Path = Directory + Key.GetFileName();
+		OutData = FDerivedData();
+
+		auto Miss = [this]()
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			++Stats.NumMisses;
+			return false;
+		};
+
+		sTouch(Path);
+		std::shared_ptr<FMappedFile> File = std::make_shared<FMappedFile>();
+		if (!File->Open(Path) || File->GetSize() < sizeof(FDerivedDataTrailer))
+		{
+			return Miss();
+		}
+
+		FDerivedDataTrailer Trailer;
+		const u64 DataSize = File->GetSize() - sizeof(Trailer);
+		memcpy(&Trailer, File->GetData() + DataSize, sizeof(Trailer));
+		if (Trailer.Magic != DERIVED_DATA_MAGIC || Trailer.Version != DERIVED_DATA_VERSION || Trailer.KeyHash != Key.GetHash() || Trailer.DataSize != DataSize)
+		{
+			return Miss();
+		}
+		if (bVerifyHashes && Hash64(File->GetData(), size_t(DataSize)) != Trailer.DataHash)
+		{
+			DEBUGPRINT("DerivedDataCache: %ls is corrupt", Path.c_str());
+			return Miss();
+		}
+
+		OutData.pData = File->GetData();
+		OutData.Size = DataSize;
+		OutData.File = std::move(File);
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		++Stats.NumHits;
+		Stats.BytesRead += DataSize;
+		Stats.SavedSeconds += std::max(0.0, Trailer.BuildSeconds - sSecondsSince(Start));
+		return true;
+	}
+
+	bool FDerivedDataCache::Put(const FDerivedDataKey& Key, const void* pData, u64 Size, double BuildSeconds)
+	{
+		FDerivedDataTrailer Trailer;
+		Trailer.KeyHash = Key.GetHash();
+		Trailer.DataHash = Hash64(pData, size_t(Size));
+		Trailer.DataSize = Size;
+		Trailer.BuildSeconds = BuildSeconds;
+
+		FFileBlock Blocks[2];
+		Blocks[0].pData = pData;
+		Blocks[0].Size = Size;
+		Blocks[1].pData = &Trailer;
+		Blocks[1].Size = sizeof(Trailer);
+
+		// On Windows this fails when another thread or process has the entry mapped, it then already holds the same data
+		const bool bWritten = WriteFileAtomic(Directory + Key.GetFileName(), Blocks, 2);
+
+		bool bNeedsTrim = false;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Stats.BuildSeconds += BuildSeconds;
+			if (bWritten)
+			{
+				++Stats.NumPuts;
+				Stats.BytesWritten += Size + sizeof(Trailer);
+				CurrentSize += Size + sizeof(Trailer);
+				bNeedsTrim = CurrentSize > MaxSize;
+			}
+		}
+
+		if (bNeedsTrim)
+		{
+			Trim();
+		}
+		return bWritten;
+	}
+
+	u32 FDerivedDataCache::Trim()
+	{
+		std::vector<FEntry> Entries;
+		u64 TotalSize = sListEntries(Directory, Entries);
+
+		// Least recently used first
+		u32 NumEvicted = 0;
+		if (TotalSize > MaxSize)
+		{
+			std::sort(Entries.begin(), Entries.end(), [](const FEntry& A, const FEntry& B) { return A.WriteTime < B.WriteTime; });
+			for (const FEntry& Entry : Entries)
+			{
+				if (TotalSize <= MaxSize)
+				{
+					break;
+				}
+
+				if (sDeleteEntry(Directory + Entry.Name))
+				{
+					TotalSize -= Entry.Size;
+					++NumEvicted;
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		CurrentSize = TotalSize;
+		Stats.NumEvictions += NumEvicted;
+		return NumEvicted;
+	}
+
+	FDerivedDataCacheStats FDerivedDataCache::GetStats() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return Stats;
+	}
+
+	void FDerivedDataCache::ResetStats()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Stats = FDerivedDataCacheStats();
+	}
+
+	void FDerivedDataCache::LogStats() const
+	{
+		const FDerivedDataCacheStats Current = GetStats();
+		DEBUGPRINT("DerivedDataCache: %u hits, %u misses (%.1f%% hit rate), %u puts, %u evictions", Current.NumHits, Current.NumMisses,
+			Current.GetHitRate() * 100.0f, Current.NumPuts, Current.NumEvictions);
+		DEBUGPRINT("DerivedDataCache: %.1f MB read, %.1f MB written, %.2f s building, %.2f s saved", double(Current.BytesRead) / (1024.0 * 1024.0),
+			double(Current.BytesWritten) / (1024.0 * 1024.0), Current.BuildSeconds, Current.SavedSeconds);
+	}
+} // namespace topia
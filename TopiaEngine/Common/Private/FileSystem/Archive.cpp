@@ -0,0 +1,312 @@
+#include "Topia.h"
+#include "FileSystem/Archive.h"
+#include "FileSystem/FileUtils.h"
+#include "Compression/LZ4.h"
+
+#include <Hash.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+namespace topia
+{
+	bool FArchive::Open(const std::wstring& Path)
+	{
+		Close();
+		if (!File.Open(Path))
+		{
+			return false;
+		}
+
+		auto Fail = [this](const char* pError)
+		{
+			DEBUGPRINT("Archive: %s", pError);
+			Close();
+			return false;
+		};
+
+		const u8* pData = File.GetData();
+		const u64 Size = File.GetSize();
+		const FArchiveHeader* pFileHeader = reinterpret_cast<const FArchiveHeader*>(pData);
+		if (Size < sizeof(FArchiveHeader) || pFileHeader->Magic != ARCHIVE_MAGIC)
+		{
+			return Fail("Not an archive");
+		}
+		if (pFileHeader->Version != ARCHIVE_VERSION)
+		{
+			return Fail("Unsupported version, pack the archive again");
+		}
+
+		// The table of contents is checked once here, reads then only need the range checks of the request
+		const FArchiveHeader& Header = *pFileHeader;
+		const u64 EntriesSize = u64(Header.NumEntries) * sizeof(FArchiveEntry);
+		const u64 BlocksSize = u64(Header.NumBlocks) * sizeof(FArchiveBlock);
+		if (Header.BlockSize == 0 || Header.EntriesOffset > Size || EntriesSize > Size - Header.EntriesOffset || Header.BlocksOffset > Size
+			|| BlocksSize > Size - Header.BlocksOffset || Header.NamesOffset > Size || Header.NamesSize > Size - Header.NamesOffset
+			|| Header.EntriesOffset % 8 != 0 || Header.BlocksOffset % 8 != 0)
+		{
+			return Fail("Bad header");
+		}
+		if (Hash64(pData + Header.EntriesOffset, size_t(Size - Header.EntriesOffset)) != Header.TableHash)
+		{
+			return Fail("Table of contents hash mismatch");
+		}
+
+		const FArchiveEntry* pFileEntries = reinterpret_cast<const FArchiveEntry*>(pData + Header.EntriesOffset);
+		const FArchiveBlock* pFileBlocks = reinterpret_cast<const FArchiveBlock*>(pData + Header.BlocksOffset);
+		for (u32 e = 0; e < Header.NumEntries; ++e)
+		{
+			const FArchiveEntry& Entry = pFileEntries[e];
+			// Size + BlockSize - 1 could wrap around
+			const u64 NumBlocks = Entry.Size / Header.BlockSize + (Entry.Size % Header.BlockSize != 0 ? 1 : 0);
+			if ((e > 0 && Entry.PathHash < pFileEntries[e - 1].PathHash) || Entry.FirstBlock > Header.NumBlocks || NumBlocks > Header.NumBlocks - Entry.FirstBlock
+				|| Entry.NameOffset > Header.NamesSize || Entry.NameLength > Header.NamesSize - Entry.NameOffset)
+			{
+				return Fail("Bad entry");
+			}
+		}
+		for (u32 b = 0; b < Header.NumBlocks; ++b)
+		{
+			const FArchiveBlock& Block = pFileBlocks[b];
+			if (Block.CompressedSize > Header.BlockSize || Block.Offset > Size || Block.CompressedSize > Size - Block.Offset)
+			{
+				return Fail("Bad block");
+			}
+		}
+
+		pHeader = pFileHeader;
+		pEntries = pFileEntries;
+		pBlocks = pFileBlocks;
+		pNames = reinterpret_cast<const char*>(pData + Header.NamesOffset);
+		return true;
+	}
+
+	void FArchive::Close()
+	{
+		File.Close();
+		pHeader = nullptr;
+		pEntries = nullptr;
+		pBlocks = nullptr;
+		pNames = nullptr;
+	}
+
+	u32 FArchive::Find(const std::string& Path) const
+	{
+		const std::string Normalized = NormalizePath(Path);
+		return Find(Hash64(Normalized.data(), Normalized.size()), Normalized);
+	}
+
+	u32 FArchive::Find(u64 PathHash, FStringView NormalizedPath) const
+	{
+		// Paths with the same hash are next to each other, compare the names to tell them apart
+		const FArchiveEntry* pEnd = pEntries + pHeader->NumEntries;
+		const FArchiveEntry* pEntry = std::lower_bound(pEntries, pEnd, PathHash, [](const FArchiveEntry& Entry, u64 Hash) { return Entry.PathHash < Hash; });
+		for (; pEntry != pEnd && pEntry->PathHash == PathHash; ++pEntry)
+		{
+			if (FStringView(pNames + pEntry->NameOffset, pEntry->NameLength) == NormalizedPath)
+			{
+				return u32(pEntry - pEntries);
+			}
+		}
+		return INVALID_INDEX;
+	}
+
+	std::string FArchive::GetPath(u32 Entry) const
+	{
+		return std::string(pNames + pEntries[Entry].NameOffset, pEntries[Entry].NameLength);
+	}
+
+	bool FArchive::DecompressBlock(u32 Block, u32 BlockSize, u8* pDestination) const
+	{
+		const FArchiveBlock& Stored = pBlocks[Block];
+		const u8* pSource = File.GetData() + Stored.Offset;
+		if (Stored.CompressedSize == BlockSize)
+		{
+			memcpy(pDestination, pSource, BlockSize);
+			return true;
+		}
+		return DecompressLZ4(pSource, Stored.CompressedSize, pDestination, BlockSize);
+	}
+
+	bool FArchive::Read(u32 EntryIndex, u64 Offset, u64 Size, void* pDestination, FThreadPool* pPool) const
+	{
+		const FArchiveEntry& Entry = pEntries[EntryIndex];
+		if (Offset > Entry.Size || Size > Entry.Size - Offset)
+		{
+			return false;
+		}
+		if (Size == 0)
+		{
+			return true;
+		}
+
+		const u32 BlockSize = pHeader->BlockSize;
+		const u32 FirstBlock = u32(Offset / BlockSize);
+		const u32 NumBlocks = u32((Offset + Size - 1) / BlockSize) - FirstBlock + 1;
+		u8* pOut = static_cast<u8*>(pDestination);
+
+		// Blocks are independent, a failed one stops the blocks that haven't started yet
+		std::atomic<bool> bSuccess(true);
+		ParallelFor(NumBlocks > 1 ? pPool : nullptr, NumBlocks, [&](u32 b)
+		{
+			if (!bSuccess.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			const u64 BlockStart = u64(FirstBlock + b) * BlockSize;
+			const u32 BlockBytes = u32(std::min<u64>(BlockSize, Entry.Size - BlockStart));
+			const u64 CopyStart = std::max(Offset, BlockStart);
+			const u64 CopyEnd = std::min(Offset + Size, BlockStart + BlockBytes);
+			u8* pBlockOut = pOut + (CopyStart - Offset);
+
+			// Whole blocks are decompressed in place, the partial ones at the ends of the range go through a temporary
+			bool bBlockSuccess;
+			if (CopyStart == BlockStart && CopyEnd == BlockStart + BlockBytes)
+			{
+				bBlockSuccess = DecompressBlock(Entry.FirstBlock + FirstBlock + b, BlockBytes, pBlockOut);
+			}
+			else
+			{
+				std::unique_ptr<u8[]> Temporary(new u8[BlockSize]);
+				bBlockSuccess = DecompressBlock(Entry.FirstBlock + FirstBlock + b, BlockBytes, Temporary.get());
+				memcpy(pBlockOut, Temporary.get() + (CopyStart - BlockStart), size_t(CopyEnd - CopyStart));
+			}
+			if (!bBlockSuccess)
+			{
+				bSuccess = false;
+			}
+		});
+
+		if (!bSuccess)
+		{
+			DEBUGPRINT("Archive: Corrupt block in %s", GetPath(EntryIndex).c_str());
+		}
+		return bSuccess;
+	}
+
+	bool FArchive::Read(u32 Entry, std::vector<u8>& OutData, FThreadPool* pPool) const
+	{
+		OutData.resize(size_t(pEntries[Entry].Size));
+		return Read(Entry, 0, OutData.size(), OutData.data(), pPool);
+	}
+
+	bool FArchiveWriter::AddFile(const std::string& Path, std::vector<u8>&& Data)
+	{
+		FFile File;
+		File.Path = NormalizeArchivePath(Path);
+		File.PathHash = Hash64(File.Path.data(), File.Path.size());
+		for (const FFile& Existing : Files)
+		{
+			if (Existing.PathHash == File.PathHash && Existing.Path == File.Path)
+			{
+				return false;
+			}
+		}
+		File.Data = std::move(Data);
+		Files.push_back(std::move(File));
+		return true;
+	}
+
+	bool FArchiveWriter::Write(const std::wstring& Path, FThreadPool* pPool) const
+	{
+		std::vector<u32> Order(Files.size());
+		for (u32 f = 0; f < Order.size(); ++f)
+		{
+			Order[f] = f;
+		}
+		std::sort(Order.begin(), Order.end(), [this](u32 A, u32 B) { return Files[A].PathHash < Files[B].PathHash; });
+
+		// Blocks in the order of the files, so the files of a directory that are packed together are read together
+		struct FPendingBlock
+		{
+			const u8* pData;
+			u32 Size;
+			std::vector<u8> Compressed;
+		};
+		std::vector<FPendingBlock> PendingBlocks;
+		std::vector<u32> FirstBlocks(Files.size());
+		for (u32 f = 0; f < Files.size(); ++f)
+		{
+			FirstBlocks[f] = u32(PendingBlocks.size());
+			const std::vector<u8>& Data = Files[f].Data;
+			for (u64 Offset = 0; Offset < Data.size(); Offset += BlockSize)
+			{
+				FPendingBlock Block;
+				Block.pData = Data.data() + Offset;
+				Block.Size = u32(std::min<u64>(BlockSize, Data.size() - Offset));
+				PendingBlocks.push_back(std::move(Block));
+			}
+		}
+
+		if (bCompress)
+		{
+			ParallelFor(pPool, u32(PendingBlocks.size()), [&](u32 b)
+			{
+				FPendingBlock& Block = PendingBlocks[b];
+				Block.Compressed.resize(GetMaxCompressedSizeLZ4(Block.Size));
+				Block.Compressed.resize(CompressLZ4(Block.pData, Block.Size, Block.Compressed.data(), u32(Block.Compressed.size())));
+
+				// Stored blocks are recognized by their size, so a compressed block must be smaller
+				if (Block.Compressed.size() >= Block.Size)
+				{
+					Block.Compressed.clear();
+					Block.Compressed.shrink_to_fit();
+				}
+			});
+		}
+
+		FArchiveHeader Header;
+		Header.BlockSize = BlockSize;
+		Header.NumEntries = u32(Files.size());
+		Header.NumBlocks = u32(PendingBlocks.size());
+
+		std::vector<u8> Data(sizeof(FArchiveHeader));
+		std::vector<FArchiveBlock> Blocks(PendingBlocks.size());
+		for (size_t b = 0; b < PendingBlocks.size(); ++b)
+		{
+			const FPendingBlock& Pending = PendingBlocks[b];
+			const bool bStored = Pending.Compressed.empty();
+			const u8* pBlockData = bStored ? Pending.pData : Pending.Compressed.data();
+			Blocks[b].Offset = Data.size();
+			Blocks[b].CompressedSize = bStored ? Pending.Size : u32(Pending.Compressed.size());
+			Data.insert(Data.end(), pBlockData, pBlockData + Blocks[b].CompressedSize);
+		}
+
+		std::vector<FArchiveEntry> Entries(Files.size());
+		std::string Names;
+		for (size_t e = 0; e < Order.size(); ++e)
+		{
+			const FFile& File = Files[Order[e]];
+			Entries[e].PathHash = File.PathHash;
+			Entries[e].Size = File.Data.size();
+			Entries[e].FirstBlock = FirstBlocks[Order[e]];
+			Entries[e].NameOffset = u32(Names.size());
+			Entries[e].NameLength = u32(File.Path.size());
+			Names += File.Path;
+		}
+
+		auto Append = [&Data](const void* pBytes, size_t Size)
+		{
+			Data.resize((Data.size() + 7) & ~size_t(7), 0);
+			const u64 Offset = Data.size();
+			Data.insert(Data.end(), static_cast<const u8*>(pBytes), static_cast<const u8*>(pBytes) + Size);
+			return Offset;
+		};
+		Header.EntriesOffset = Append(Entries.data(), Entries.size() * sizeof(FArchiveEntry));
+		Header.BlocksOffset = Append(Blocks.data(), Blocks.size() * sizeof(FArchiveBlock));
+		Header.NamesOffset = Append(Names.data(), Names.size());
+		Header.NamesSize = u32(Names.size());
+		Header.TableHash = Hash64(Data.data() + Header.EntriesOffset, size_t(Data.size() - Header.EntriesOffset));
+		memcpy(Data.data(), &Header, sizeof(Header));
+
+		if (!WriteFileAtomic(Path, Data.data(), Data.size()))
+		{
+			DEBUGPRINT("Archive: Can't write the file");
+			return false;
+		}
+		return true;
+	}
+} // namespace topia
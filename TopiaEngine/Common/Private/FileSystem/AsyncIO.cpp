@@ -0,0 +1,674 @@
+#include "Topia.h"
+#include "FileSystem/AsyncIO.h"
+
+#if !defined(_WIN32)
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+	#include <linux/io_uring.h>
+	#include <sys/eventfd.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <cstring>
+#endif
+
+namespace topia
+{
+#if defined(_WIN32)
+	bool FAsyncFile::Open(const std::wstring& Path)
+	{
+		Close();
+
+		FileHandle = ::CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (FileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER FileSize;
+		if (!::GetFileSizeEx(FileHandle, &FileSize))
+		{
+			Close();
+			return false;
+		}
+		Size = u64(FileSize.QuadPart);
+		return true;
+	}
+
+	void FAsyncFile::Close()
+	{
+		if (FileHandle != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(FileHandle);
+			FileHandle = INVALID_HANDLE_VALUE;
+		}
+		Size = 0;
+	}
+
+	u64 FAsyncFile::Read(u64 Offset, u64 ReadSize, void* pDestination) const
+	{
+		// The offset in the OVERLAPPED makes the read positional, so threads don't share a file pointer
+		u8* pBytes = static_cast<u8*>(pDestination);
+		u64 TotalRead = 0;
+		while (TotalRead < ReadSize)
+		{
+			OVERLAPPED Overlapped = {};
+			Overlapped.Offset = DWORD(Offset + TotalRead);
+			Overlapped.OffsetHigh = DWORD((Offset + TotalRead) >> 32);
+
+			const DWORD ChunkSize = DWORD(std::min<u64>(ReadSize - TotalRead, 1u << 30));
+			DWORD BytesRead = 0;
+			if (!::ReadFile(FileHandle, pBytes + TotalRead, ChunkSize, &BytesRead, &Overlapped) || BytesRead == 0)
+			{
+				break;
+			}
+			TotalRead += BytesRead;
+		}
+		return TotalRead;
+	}
+#else
+	bool FAsyncFile::Open(const std::wstring& Path)
+	{
+		Close();
+
+		FileDescriptor = ::open(WideToUTF8(Path).c_str(), O_RDONLY | O_CLOEXEC);
+		if (FileDescriptor < 0)
+		{
+			return false;
+		}
+
+		// Directories open for reading on POSIX, but not on Windows
+		struct stat Stat;
+		if (::fstat(FileDescriptor, &Stat) != 0 || !S_ISREG(Stat.st_mode))
+		{
+			Close();
+			return false;
+		}
+		Size = u64(Stat.st_size);
+		::posix_fadvise(FileDescriptor, 0, 0, POSIX_FADV_RANDOM);
+		return true;
+	}
+
+	void FAsyncFile::Close()
+	{
+		if (FileDescriptor >= 0)
+		{
+			::close(FileDescriptor);
+			FileDescriptor = -1;
+		}
+		Size = 0;
+	}
+
+	u64 FAsyncFile::Read(u64 Offset, u64 ReadSize, void* pDestination) const
+	{
+		u8* pBytes = static_cast<u8*>(pDestination);
+		u64 TotalRead = 0;
+		while (TotalRead < ReadSize)
+		{
+			const size_t ChunkSize = size_t(std::min<u64>(ReadSize - TotalRead, 1u << 30));
+			const ssize_t BytesRead = ::pread(FileDescriptor, pBytes + TotalRead, ChunkSize, off_t(Offset + TotalRead));
+			if (BytesRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (BytesRead <= 0)
+			{
+				break;
+			}
+			TotalRead += u64(BytesRead);
+		}
+		return TotalRead;
+	}
+#endif
+
+	struct FIORequestState
+	{
+		FReadRequest Request;
+		u64 Sequence = 0;
+		std::atomic<EIOStatus> Status { EIOStatus::Pending };
+		u64 BytesRead = 0;
+
+		std::mutex Mutex;
+		std::condition_variable Done;
+	};
+
+	static bool sIsDone(EIOStatus Status)
+	{
+		return Status != EIOStatus::Pending && Status != EIOStatus::InProgress;
+	}
+
+	bool FIORequestHandle::IsDone() const
+	{
+		return sIsDone(State->Status.load());
+	}
+
+	FIOResult FIORequestHandle::Wait() const
+	{
+		std::unique_lock<std::mutex> Lock(State->Mutex);
+		State->Done.wait(Lock, [this]() { return sIsDone(State->Status.load()); });
+		return GetResult();
+	}
+
+	FIOResult FIORequestHandle::GetResult() const
+	{
+		FIOResult Result;
+		Result.Status = State->Status.load();
+		Result.BytesRead = sIsDone(Result.Status) ? State->BytesRead : 0;
+		return Result;
+	}
+
+	/** Completed, or Failed when the file can't be read or the read stopped before the end of the file */
+	static EIOStatus sReadStatus(const FReadRequest& Request, u64 BytesRead, bool bError)
+	{
+		const bool bShort = BytesRead < Request.Size && Request.Offset + BytesRead < Request.File->GetSize();
+		return bError || bShort ? EIOStatus::Failed : EIOStatus::Completed;
+	}
+
+#if defined(__linux__)
+	/** io_uring with a submission and a completion queue, driven by raw system calls so there is no liburing dependency */
+	class FIORing : public NonCopyable
+	{
+	public:
+		~FIORing()
+		{
+			if (pSQEs != nullptr)
+			{
+				::munmap(pSQEs, SQEsSize);
+			}
+			if (pCQRing != nullptr && pCQRing != pSQRing)
+			{
+				::munmap(pCQRing, CQRingSize);
+			}
+			if (pSQRing != nullptr)
+			{
+				::munmap(pSQRing, SQRingSize);
+			}
+			if (RingDescriptor >= 0)
+			{
+				::close(RingDescriptor);
+			}
+		}
+
+		/** False when the kernel doesn't support io_uring or a sandbox forbids it */
+		bool Init(u32 NumEntries)
+		{
+			io_uring_params Params;
+			memset(&Params, 0, sizeof(Params));
+			RingDescriptor = int(::syscall(__NR_io_uring_setup, NumEntries, &Params));
+			if (RingDescriptor < 0)
+			{
+				return false;
+			}
+
+			// Since 5.4 both queues share one mapping
+			SQRingSize = Params.sq_off.array + Params.sq_entries * sizeof(u32);
+			CQRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+			const bool bSingleMap = (Params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (bSingleMap)
+			{
+				SQRingSize = CQRingSize = std::max(SQRingSize, CQRingSize);
+			}
+
+			pSQRing = sMap(RingDescriptor, SQRingSize, IORING_OFF_SQ_RING);
+			pCQRing = bSingleMap ? pSQRing : sMap(RingDescriptor, CQRingSize, IORING_OFF_CQ_RING);
+			SQEsSize = Params.sq_entries * sizeof(io_uring_sqe);
+			pSQEs = static_cast<io_uring_sqe*>(sMap(RingDescriptor, SQEsSize, IORING_OFF_SQES));
+			if (pSQRing == nullptr || pCQRing == nullptr || pSQEs == nullptr)
+			{
+				return false;
+			}
+
+			u8* pSQ = static_cast<u8*>(pSQRing);
+			pSQHead = reinterpret_cast<u32*>(pSQ + Params.sq_off.head);
+			pSQTail = reinterpret_cast<u32*>(pSQ + Params.sq_off.tail);
+			pSQArray = reinterpret_cast<u32*>(pSQ + Params.sq_off.array);
+			SQMask = *reinterpret_cast<u32*>(pSQ + Params.sq_off.ring_mask);
+
+			u8* pCQ = static_cast<u8*>(pCQRing);
+			pCQHead = reinterpret_cast<u32*>(pCQ + Params.cq_off.head);
+			pCQTail = reinterpret_cast<u32*>(pCQ + Params.cq_off.tail);
+			pCQEs = reinterpret_cast<io_uring_cqe*>(pCQ + Params.cq_off.cqes);
+			CQMask = *reinterpret_cast<u32*>(pCQ + Params.cq_off.ring_mask);
+			return true;
+		}
+
+		/** Queue a read, UserData comes back with its completion. There must be a free entry. */
+		void PrepareRead(int FileDescriptor, void* pDestination, u32 Size, u64 Offset, u64 UserData)
+		{
+			// Only this thread writes the tail
+			const u32 Tail = *pSQTail;
+			const u32 Index = Tail & SQMask;
+			io_uring_sqe& Entry = pSQEs[Index];
+			memset(&Entry, 0, sizeof(Entry));
+			Entry.opcode = IORING_OP_READ;
+			Entry.fd = FileDescriptor;
+			Entry.addr = u64(reinterpret_cast<uintptr_t>(pDestination));
+			Entry.len = Size;
+			Entry.off = Offset;
+			Entry.user_data = UserData;
+			pSQArray[Index] = Index;
+			__atomic_store_n(pSQTail, Tail + 1, __ATOMIC_RELEASE);
+		}
+
+		/** Submit the prepared reads and block until at least one completion is available */
+		void SubmitAndWait()
+		{
+			for (;;)
+			{
+				const u32 NumToSubmit = *pSQTail - __atomic_load_n(pSQHead, __ATOMIC_ACQUIRE);
+				if (::syscall(__NR_io_uring_enter, RingDescriptor, NumToSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0
+					|| (errno != EINTR && errno != EAGAIN && errno != EBUSY))
+				{
+					break;
+				}
+			}
+		}
+
+		/** Callback(UserData, Result) for every completion that arrived, Result is the byte count or -errno */
+		template <typename TCallback>
+		void ReapCompletions(TCallback&& Callback)
+		{
+			u32 Head = *pCQHead;
+			const u32 Tail = __atomic_load_n(pCQTail, __ATOMIC_ACQUIRE);
+			for (; Head != Tail; ++Head)
+			{
+				const io_uring_cqe& Completion = pCQEs[Head & CQMask];
+				Callback(Completion.user_data, Completion.res);
+			}
+			__atomic_store_n(pCQHead, Head, __ATOMIC_RELEASE);
+		}
+
+	private:
+		static void* sMap(int RingDescriptor, size_t Size, u64 Offset)
+		{
+			void* pData = ::mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingDescriptor, off_t(Offset));
+			return pData == MAP_FAILED ? nullptr : pData;
+		}
+
+		int RingDescriptor = -1;
+		void* pSQRing = nullptr;
+		void* pCQRing = nullptr;
+		io_uring_sqe* pSQEs = nullptr;
+		size_t SQRingSize = 0;
+		size_t CQRingSize = 0;
+		size_t SQEsSize = 0;
+
+		u32* pSQHead = nullptr;
+		u32* pSQTail = nullptr;
+		u32* pSQArray = nullptr;
+		u32 SQMask = 0;
+		u32* pCQHead = nullptr;
+		u32* pCQTail = nullptr;
+		io_uring_cqe* pCQEs = nullptr;
+		u32 CQMask = 0;
+	};
+
+	/** Ring plus an eventfd that other threads write to wake the ring thread, a read of it is always queued in the ring */
+	struct FAsyncIO::FRingBackend
+	{
+		~FRingBackend()
+		{
+			if (WakeDescriptor >= 0)
+			{
+				::close(WakeDescriptor);
+			}
+		}
+
+		FIORing Ring;
+		int WakeDescriptor = -1;
+		u64 WakeValue = 0;
+	};
+
+	/** User data of the eventfd read, reads use their slot index + 1 */
+	static constexpr u64 RING_WAKE_USER_DATA = 0;
+#endif
+
+	bool FAsyncIO::FCompareRequests::operator()(const std::shared_ptr<FIORequestState>& A, const std::shared_ptr<FIORequestState>& B) const
+	{
+		// priority_queue pops the largest element
+		if (A->Request.Priority != B->Request.Priority)
+		{
+			return A->Request.Priority < B->Request.Priority;
+		}
+		return A->Sequence > B->Sequence;
+	}
+
+	FAsyncIO::FAsyncIO(u32 InQueueDepth, EIOBackend Backend)
+		: QueueDepth(InQueueDepth)
+	{
+		ASSERT(QueueDepth > 0);
+
+#if defined(__linux__)
+		if (Backend != EIOBackend::Threads)
+		{
+			// One entry per read in flight and one for the eventfd read
+			std::unique_ptr<FRingBackend> NewRing = std::make_unique<FRingBackend>();
+			NewRing->WakeDescriptor = ::eventfd(0, EFD_CLOEXEC);
+			if (NewRing->WakeDescriptor >= 0 && NewRing->Ring.Init(QueueDepth + 1))
+			{
+				Ring = std::move(NewRing);
+				Threads.emplace_back([this]() { RingMain(); });
+				return;
+			}
+			DEBUGPRINT("FAsyncIO: io_uring is not available, using I/O threads");
+		}
+#else
+		(void)Backend;
+#endif
+
+		for (u32 t = 0; t < QueueDepth; ++t)
+		{
+			Threads.emplace_back([this]() { WorkerMain(); });
+		}
+	}
+
+	FAsyncIO::~FAsyncIO()
+	{
+		std::vector<std::shared_ptr<FIORequestState>> Cancelled;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bStopping = true;
+			while (!Queue.empty())
+			{
+				Cancelled.push_back(Queue.top());
+				Queue.pop();
+			}
+		}
+		WorkAvailable.notify_all();
+#if defined(__linux__)
+		WakeRing();
+#endif
+
+		for (const std::shared_ptr<FIORequestState>& State : Cancelled)
+		{
+			EIOStatus Expected = EIOStatus::Pending;
+			if (State->Status.compare_exchange_strong(Expected, EIOStatus::InProgress))
+			{
+				Complete(*State, EIOStatus::Cancelled, 0);
+			}
+		}
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+	}
+
+	EIOBackend FAsyncIO::GetBackend() const
+	{
+#if defined(__linux__)
+		if (Ring != nullptr)
+		{
+			return EIOBackend::IORing;
+		}
+#endif
+		return EIOBackend::Threads;
+	}
+
+	FIORequestHandle FAsyncIO::Read(FReadRequest Request)
+	{
+		FIORequestHandle Handle;
+		ReadBatch(&Request, 1, &Handle);
+		return Handle;
+	}
+
+	void FAsyncIO::ReadBatch(FReadRequest* pRequests, u32 NumRequests, FIORequestHandle* pOutHandles)
+	{
+		std::vector<std::shared_ptr<FIORequestState>> States(NumRequests);
+		for (u32 r = 0; r < NumRequests; ++r)
+		{
+			States[r] = std::make_shared<FIORequestState>();
+			States[r]->Request = std::move(pRequests[r]);
+			ASSERT(States[r]->Request.File != nullptr);
+			if (pOutHandles != nullptr)
+			{
+				pOutHandles[r].State = States[r];
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			for (std::shared_ptr<FIORequestState>& State : States)
+			{
+				State->Sequence = NextSequence++;
+				Queue.push(std::move(State));
+			}
+			NumInFlight += NumRequests;
+		}
+
+#if defined(__linux__)
+		if (Ring != nullptr)
+		{
+			WakeRing();
+			return;
+		}
+#endif
+		if (NumRequests == 1)
+		{
+			WorkAvailable.notify_one();
+		}
+		else
+		{
+			WorkAvailable.notify_all();
+		}
+	}
+
+	bool FAsyncIO::Cancel(const FIORequestHandle& Handle)
+	{
+		ASSERT(Handle.IsValid());
+
+		// The state stays in the queue, the thread that pops it sees that it was cancelled and skips it
+		EIOStatus Expected = EIOStatus::Pending;
+		if (!Handle.State->Status.compare_exchange_strong(Expected, EIOStatus::InProgress))
+		{
+			return false;
+		}
+		Complete(*Handle.State, EIOStatus::Cancelled, 0);
+		return true;
+	}
+
+	void FAsyncIO::WaitIdle()
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		Idle.wait(Lock, [this]() { return NumInFlight == 0; });
+	}
+
+	void FAsyncIO::Complete(FIORequestState& State, EIOStatus Status, u64 BytesRead)
+	{
+		// Publish the result before the callback runs, so it can Wait on the request without blocking forever
+		State.BytesRead = BytesRead;
+		{
+			std::lock_guard<std::mutex> Lock(State.Mutex);
+			State.Status.store(Status);
+		}
+		State.Done.notify_all();
+
+		if (State.Request.OnComplete)
+		{
+			FIOResult Result;
+			Result.Status = Status;
+			Result.BytesRead = BytesRead;
+			State.Request.OnComplete(Result);
+		}
+
+		// Requests cancelled early are still in the queue, they are counted when popped. WaitIdle also waits for the callback.
+		if (Status != EIOStatus::Cancelled)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if (--NumInFlight == 0)
+			{
+				Idle.notify_all();
+			}
+		}
+	}
+
+	bool FAsyncIO::PopRequest(std::shared_ptr<FIORequestState>& OutState)
+	{
+		while (!Queue.empty())
+		{
+			OutState = Queue.top();
+			Queue.pop();
+
+			EIOStatus Expected = EIOStatus::Pending;
+			if (OutState->Status.compare_exchange_strong(Expected, EIOStatus::InProgress))
+			{
+				return true;
+			}
+
+			// Cancelled while queued
+			if (--NumInFlight == 0)
+			{
+				Idle.notify_all();
+			}
+		}
+		OutState.reset();
+		return false;
+	}
+
+	void FAsyncIO::WorkerMain()
+	{
+		for (;;)
+		{
+			std::shared_ptr<FIORequestState> State;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				WorkAvailable.wait(Lock, [this]() { return bStopping || !Queue.empty(); });
+				if (bStopping)
+				{
+					return;
+				}
+				if (!PopRequest(State))
+				{
+					continue;
+				}
+			}
+
+			const FReadRequest& Request = State->Request;
+			const u64 BytesRead = Request.File->IsOpen() ? Request.File->Read(Request.Offset, Request.Size, Request.pDestination) : 0;
+			Complete(*State, sReadStatus(Request, BytesRead, !Request.File->IsOpen()), BytesRead);
+		}
+	}
+
+#if defined(__linux__)
+	void FAsyncIO::WakeRing()
+	{
+		if (Ring != nullptr)
+		{
+			const u64 Value = 1;
+			while (::write(Ring->WakeDescriptor, &Value, sizeof(Value)) < 0 && errno == EINTR)
+			{
+			}
+		}
+	}
+
+	void FAsyncIO::RingMain()
+	{
+		FIORing& IORing = Ring->Ring;
+
+		/** Read in flight, a request larger than a single read is split and its next part is queued when the previous one completes */
+		struct FRingRead
+		{
+			std::shared_ptr<FIORequestState> State;
+			u64 BytesRead = 0;
+		};
+		std::vector<FRingRead> Reads(QueueDepth);
+		std::vector<u32> FreeSlots;
+		for (u32 Slot = QueueDepth; Slot-- > 0;)
+		{
+			FreeSlots.push_back(Slot);
+		}
+
+		auto PrepareNextPart = [&IORing, &Reads](u32 Slot)
+		{
+			const FRingRead& Read = Reads[Slot];
+			const FReadRequest& Request = Read.State->Request;
+			const u32 PartSize = u32(std::min<u64>(Request.Size - Read.BytesRead, 1u << 30));
+			IORing.PrepareRead(Request.File->FileDescriptor, static_cast<u8*>(Request.pDestination) + Read.BytesRead, PartSize,
+				Request.Offset + Read.BytesRead, u64(Slot) + 1);
+		};
+		auto Finish = [this, &Reads, &FreeSlots](u32 Slot, bool bError)
+		{
+			FRingRead& Read = Reads[Slot];
+			std::shared_ptr<FIORequestState> State = std::move(Read.State);
+			FreeSlots.push_back(Slot);
+			Complete(*State, sReadStatus(State->Request, Read.BytesRead, bError), Read.BytesRead);
+		};
+
+		IORing.PrepareRead(Ring->WakeDescriptor, &Ring->WakeValue, sizeof(Ring->WakeValue), 0, RING_WAKE_USER_DATA);
+		for (;;)
+		{
+			std::vector<u32> Started;
+			bool bStop = false;
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				bStop = bStopping;
+				std::shared_ptr<FIORequestState> State;
+				while (!bStop && !FreeSlots.empty() && PopRequest(State))
+				{
+					const u32 Slot = FreeSlots.back();
+					FreeSlots.pop_back();
+					Reads[Slot].State = std::move(State);
+					Reads[Slot].BytesRead = 0;
+					Started.push_back(Slot);
+				}
+			}
+
+			for (u32 Slot : Started)
+			{
+				const FReadRequest& Request = Reads[Slot].State->Request;
+				if (!Request.File->IsOpen() || Request.Size == 0)
+				{
+					Finish(Slot, !Request.File->IsOpen());
+				}
+				else
+				{
+					PrepareNextPart(Slot);
+				}
+			}
+
+			// The kernel writes into the destinations of the reads in flight, they must finish before the thread returns
+			if (bStop && FreeSlots.size() == QueueDepth)
+			{
+				return;
+			}
+
+			IORing.SubmitAndWait();
+			IORing.ReapCompletions([&](u64 UserData, s32 Result)
+			{
+				if (UserData == RING_WAKE_USER_DATA)
+				{
+					IORing.PrepareRead(Ring->WakeDescriptor, &Ring->WakeValue, sizeof(Ring->WakeValue), 0, RING_WAKE_USER_DATA);
+					return;
+				}
+
+				const u32 Slot = u32(UserData - 1);
+				FRingRead& Read = Reads[Slot];
+				if (Result == -EINTR || Result == -EAGAIN)
+				{
+					PrepareNextPart(Slot);
+				}
+				else if (Result > 0)
+				{
+					Read.BytesRead += u64(Result);
+					if (Read.BytesRead < Read.State->Request.Size)
+					{
+						PrepareNextPart(Slot);
+					}
+					else
+					{
+						Finish(Slot, false);
+					}
+				}
+				else
+				{
+					// 0 is the end of the file
+					Finish(Slot, Result < 0);
+				}
+			});
+		}
+	}
+#endif
+} // namespace topia
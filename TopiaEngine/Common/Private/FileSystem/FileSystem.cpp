@@ -3,4 +3,10 @@
 
 namespace topia
 {
+	std::wstring GetAssetFullPath(LPCWSTR AssetName)
+	{
+		WCHAR AssetsPath[MAX_PATH];
+		GetAssetsPath(AssetsPath, MAX_PATH);
+		return std::wstring(AssetsPath) + AssetName;
+	}
 } // namespace topia
@@ -0,0 +1,100 @@
+#include "Topia.h"
+#include "Platforms.h"
+#include "FileSystem/FileUtils.h"
+
+#if !defined(_WIN32)
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <thread>
+	#include <unistd.h>
+#endif
+
+namespace topia
+{
+	bool WriteFileAtomic(const std::wstring& Path, const void* pData, u64 Size)
+	{
+		FFileBlock Block;
+		Block.pData = pData;
+		Block.Size = Size;
+		return WriteFileAtomic(Path, &Block, 1);
+	}
+
+#if defined(_WIN32)
+	bool WriteFileAtomic(const std::wstring& Path, const FFileBlock* pBlocks, u32 NumBlocks)
+	{
+		// Unique per process and thread, so writers don't share their temporary file
+		const std::wstring TempPath = Path + L"." + std::to_wstring(::GetCurrentProcessId()) + L"." + std::to_wstring(::GetCurrentThreadId()) + L".tmp";
+
+		HANDLE FileHandle = ::CreateFileW(TempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (FileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		// WriteFile takes at most 4 GB per call
+		bool bSuccess = true;
+		for (u32 b = 0; b < NumBlocks && bSuccess; ++b)
+		{
+			const u8* pBytes = static_cast<const u8*>(pBlocks[b].pData);
+			u64 Size = pBlocks[b].Size;
+			while (Size > 0 && bSuccess)
+			{
+				const DWORD ChunkSize = DWORD(std::min<u64>(Size, 1u << 30));
+				DWORD Written = 0;
+				bSuccess = ::WriteFile(FileHandle, pBytes, ChunkSize, &Written, nullptr) && Written == ChunkSize;
+				pBytes += ChunkSize;
+				Size -= ChunkSize;
+			}
+		}
+		::CloseHandle(FileHandle);
+
+		if (!bSuccess || !::MoveFileExW(TempPath.c_str(), Path.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			::DeleteFileW(TempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+#else
+	bool WriteFileAtomic(const std::wstring& Path, const FFileBlock* pBlocks, u32 NumBlocks)
+	{
+		// Unique per process and thread, so writers don't share their temporary file
+		const std::string FinalPath = WideToUTF8(Path);
+		const std::string TempPath = FinalPath + "." + std::to_string(::getpid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		const int FileDescriptor = ::open(TempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (FileDescriptor < 0)
+		{
+			return false;
+		}
+
+		// write may write less than asked for, and at most about 2 GB per call
+		bool bSuccess = true;
+		for (u32 b = 0; b < NumBlocks && bSuccess; ++b)
+		{
+			const u8* pBytes = static_cast<const u8*>(pBlocks[b].pData);
+			u64 Size = pBlocks[b].Size;
+			while (Size > 0 && bSuccess)
+			{
+				const ssize_t Written = ::write(FileDescriptor, pBytes, size_t(std::min<u64>(Size, 1u << 30)));
+				if (Written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				bSuccess = Written > 0;
+				pBytes += bSuccess ? Written : 0;
+				Size -= bSuccess ? u64(Written) : 0;
+			}
+		}
+		bSuccess &= ::close(FileDescriptor) == 0;
+
+		// Unlike MoveFileEx this also replaces a file that is mapped, readers keep the old data
+		if (!bSuccess || ::rename(TempPath.c_str(), FinalPath.c_str()) != 0)
+		{
+			::unlink(TempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+#endif
+} // namespace topia
@@ -0,0 +1,399 @@
+#include "Topia.h"
+#include "FileSystem/FileWatcher.h"
+
+#if defined(__linux__)
+	#include <cerrno>
+	#include <cstring>
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <sys/eventfd.h>
+	#include <sys/inotify.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace topia
+{
+	void FFileWatcher::AddChange(FPath Path, EFileChangeType Type, std::chrono::steady_clock::time_point Time)
+	{
+		const auto It = PendingChanges.find(Path);
+		if (It == PendingChanges.end())
+		{
+			PendingChanges[Path] = FPendingChange{ Type, Time, Time };
+			return;
+		}
+
+		// A file that was added and then written is still new, one that was removed and then added again was replaced
+		FPendingChange& Pending = It->second;
+		if (Pending.Type == EFileChangeType::Removed && Type == EFileChangeType::Added)
+		{
+			Pending.Type = EFileChangeType::Modified;
+		}
+		else if (Pending.Type != EFileChangeType::Added || Type != EFileChangeType::Modified)
+		{
+			Pending.Type = Type;
+		}
+		Pending.LastTime = Time;
+	}
+
+#if defined(_WIN32)
+	bool FFileWatcher::Start(const std::wstring& Directory, u32 InSettleMilliseconds)
+	{
+		Stop();
+
+		DirectoryHandle = ::CreateFileW(Directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (DirectoryHandle == INVALID_HANDLE_VALUE)
+		{
+			DEBUGPRINT("FileWatcher: Can't open %ls", Directory.c_str());
+			return false;
+		}
+
+		SettleMilliseconds = InSettleMilliseconds;
+		StopEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		Thread = std::thread(&FFileWatcher::WatchThread, this);
+		return true;
+	}
+
+	void FFileWatcher::Stop()
+	{
+		if (Thread.joinable())
+		{
+			::SetEvent(StopEvent);
+			Thread.join();
+		}
+		if (StopEvent != nullptr)
+		{
+			::CloseHandle(StopEvent);
+			StopEvent = nullptr;
+		}
+		if (DirectoryHandle != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(DirectoryHandle);
+			DirectoryHandle = INVALID_HANDLE_VALUE;
+		}
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		PendingChanges.clear();
+	}
+
+	void FFileWatcher::WatchThread()
+	{
+		// The notifications are written as a list of DWORD aligned FILE_NOTIFY_INFORMATION
+		std::vector<DWORD> Buffer(16 * 1024);
+		OVERLAPPED Overlapped = {};
+		Overlapped.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		const DWORD Filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION;
+
+		for (;;)
+		{
+			::ResetEvent(Overlapped.hEvent);
+			if (!::ReadDirectoryChangesW(DirectoryHandle, Buffer.data(), DWORD(Buffer.size() * sizeof(DWORD)), TRUE, Filter, nullptr, &Overlapped, nullptr))
+			{
+				DEBUGPRINT("FileWatcher: ReadDirectoryChangesW failed with error %u", unsigned(::GetLastError()));
+				break;
+			}
+
+			HANDLE Events[2] = { Overlapped.hEvent, StopEvent };
+			DWORD NumBytes = 0;
+			if (::WaitForMultipleObjects(2, Events, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				::CancelIo(DirectoryHandle);
+				::GetOverlappedResult(DirectoryHandle, &Overlapped, &NumBytes, TRUE);
+				break;
+			}
+			if (!::GetOverlappedResult(DirectoryHandle, &Overlapped, &NumBytes, FALSE))
+			{
+				DEBUGPRINT("FileWatcher: GetOverlappedResult failed with error %u", unsigned(::GetLastError()));
+				break;
+			}
+
+			const auto Now = std::chrono::steady_clock::now();
+			std::lock_guard<std::mutex> Lock(Mutex);
+
+			// No bytes means the buffer of the system overflowed and the notifications are lost
+			if (NumBytes == 0)
+			{
+				AddChange(FPath(), EFileChangeType::Overflow, Now);
+				continue;
+			}
+
+			const u8* pEntry = reinterpret_cast<const u8*>(Buffer.data());
+			for (;;)
+			{
+				const FILE_NOTIFY_INFORMATION& Info = *reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(pEntry);
+				const FPath Path(WideToUTF8(FWStringView(Info.FileName, Info.FileNameLength / sizeof(WCHAR))));
+				switch (Info.Action)
+				{
+				case FILE_ACTION_ADDED:
+				case FILE_ACTION_RENAMED_NEW_NAME:
+					AddChange(Path, EFileChangeType::Added, Now);
+					break;
+				case FILE_ACTION_REMOVED:
+				case FILE_ACTION_RENAMED_OLD_NAME:
+					AddChange(Path, EFileChangeType::Removed, Now);
+					break;
+				default:
+					AddChange(Path, EFileChangeType::Modified, Now);
+					break;
+				}
+
+				if (Info.NextEntryOffset == 0)
+				{
+					break;
+				}
+				pEntry += Info.NextEntryOffset;
+			}
+		}
+
+		::CloseHandle(Overlapped.hEvent);
+	}
+
+#elif defined(__linux__)
+	static constexpr u32 WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+	bool FFileWatcher::Start(const std::wstring& Directory, u32 InSettleMilliseconds)
+	{
+		Stop();
+
+		RootDirectory = WideToUTF8(Directory);
+		if (!RootDirectory.empty() && RootDirectory.back() != '/')
+		{
+			RootDirectory += '/';
+		}
+		NotifyDescriptor = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		StopDescriptor = ::eventfd(0, EFD_CLOEXEC);
+		if (NotifyDescriptor >= 0 && StopDescriptor >= 0)
+		{
+			AddWatches(std::string(), false, std::chrono::steady_clock::now());
+		}
+		if (WatchedDirectories.empty())
+		{
+			DEBUGPRINT("FileWatcher: Can't watch %s", RootDirectory.c_str());
+			Stop();
+			return false;
+		}
+
+		SettleMilliseconds = InSettleMilliseconds;
+		Thread = std::thread(&FFileWatcher::WatchThread, this);
+		return true;
+	}
+
+	void FFileWatcher::Stop()
+	{
+		if (Thread.joinable())
+		{
+			const u64 Value = 1;
+			while (::write(StopDescriptor, &Value, sizeof(Value)) < 0 && errno == EINTR)
+			{
+			}
+			Thread.join();
+		}
+		if (StopDescriptor >= 0)
+		{
+			::close(StopDescriptor);
+			StopDescriptor = -1;
+		}
+		if (NotifyDescriptor >= 0)
+		{
+			::close(NotifyDescriptor);
+			NotifyDescriptor = -1;
+		}
+		WatchedDirectories.clear();
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		PendingChanges.clear();
+	}
+
+	void FFileWatcher::AddWatches(const std::string& RelativeDirectory, bool bReportFiles, std::chrono::steady_clock::time_point Time)
+	{
+		// Adding the watch of a directory that is already watched returns its descriptor again
+		const std::string Directory = RootDirectory + RelativeDirectory;
+		const int Watch = ::inotify_add_watch(NotifyDescriptor, Directory.c_str(), WATCH_MASK);
+		if (Watch < 0)
+		{
+			DEBUGPRINT("FileWatcher: Can't watch %s, errno %d", Directory.c_str(), errno);
+			return;
+		}
+		WatchedDirectories[Watch] = RelativeDirectory;
+
+		// Listed after the watch is added, a file written in between is reported twice and merged by AddChange
+		DIR* pDirectory = ::opendir(Directory.c_str());
+		if (pDirectory == nullptr)
+		{
+			return;
+		}
+		while (const dirent* pEntry = ::readdir(pDirectory))
+		{
+			if (strcmp(pEntry->d_name, ".") == 0 || strcmp(pEntry->d_name, "..") == 0)
+			{
+				continue;
+			}
+
+			// Symbolic links are not followed, a link to a parent directory would never end
+			bool bDirectory = pEntry->d_type == DT_DIR;
+			if (pEntry->d_type == DT_UNKNOWN)
+			{
+				struct stat Status;
+				bDirectory = ::fstatat(::dirfd(pDirectory), pEntry->d_name, &Status, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(Status.st_mode);
+			}
+
+			const std::string Path = RelativeDirectory + pEntry->d_name;
+			if (bReportFiles)
+			{
+				AddChange(FPath(Path), EFileChangeType::Added, Time);
+			}
+			if (bDirectory)
+			{
+				AddWatches(Path + '/', bReportFiles, Time);
+			}
+		}
+		::closedir(pDirectory);
+	}
+
+	void FFileWatcher::RemoveWatches(const std::string& RelativeDirectory)
+	{
+		// The directory moved away, its watches would report the files under the old path
+		for (auto It = WatchedDirectories.begin(); It != WatchedDirectories.end();)
+		{
+			if (It->second.compare(0, RelativeDirectory.size(), RelativeDirectory) == 0)
+			{
+				::inotify_rm_watch(NotifyDescriptor, It->first);
+				It = WatchedDirectories.erase(It);
+			}
+			else
+			{
+				++It;
+			}
+		}
+	}
+
+	void FFileWatcher::WatchThread()
+	{
+		// The events are inotify_event headers followed by the name, each padded so the next header is aligned
+		std::vector<u64> Buffer(8 * 1024);
+		pollfd Descriptors[2] = { { NotifyDescriptor, POLLIN, 0 }, { StopDescriptor, POLLIN, 0 } };
+
+		for (;;)
+		{
+			if (::poll(Descriptors, 2, -1) < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				DEBUGPRINT("FileWatcher: poll failed with errno %d", errno);
+				break;
+			}
+			if (Descriptors[1].revents != 0)
+			{
+				break;
+			}
+
+			const ssize_t NumBytes = ::read(NotifyDescriptor, Buffer.data(), Buffer.size() * sizeof(u64));
+			if (NumBytes <= 0)
+			{
+				if (NumBytes < 0 && (errno == EINTR || errno == EAGAIN))
+				{
+					continue;
+				}
+				DEBUGPRINT("FileWatcher: read failed with errno %d", errno);
+				break;
+			}
+
+			const auto Now = std::chrono::steady_clock::now();
+			std::lock_guard<std::mutex> Lock(Mutex);
+
+			const u8* pEntry = reinterpret_cast<const u8*>(Buffer.data());
+			const u8* const pEnd = pEntry + NumBytes;
+			for (; pEntry < pEnd; pEntry += sizeof(inotify_event) + reinterpret_cast<const inotify_event*>(pEntry)->len)
+			{
+				const inotify_event& Event = *reinterpret_cast<const inotify_event*>(pEntry);
+
+				// The queue of the kernel overflowed and the events are lost
+				if (Event.mask & IN_Q_OVERFLOW)
+				{
+					AddChange(FPath(), EFileChangeType::Overflow, Now);
+					continue;
+				}
+
+				// The watch is gone because its directory was removed, moved away or unwatched
+				const auto Watched = WatchedDirectories.find(Event.wd);
+				if (Event.mask & IN_IGNORED)
+				{
+					if (Watched != WatchedDirectories.end())
+					{
+						WatchedDirectories.erase(Watched);
+					}
+					continue;
+				}
+				if (Watched == WatchedDirectories.end() || Event.len == 0)
+				{
+					continue;
+				}
+
+				const std::string Path = Watched->second + Event.name;
+				if (Event.mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					AddChange(FPath(Path), EFileChangeType::Added, Now);
+					if (Event.mask & IN_ISDIR)
+					{
+						AddWatches(Path + '/', true, Now);
+					}
+				}
+				else if (Event.mask & (IN_DELETE | IN_MOVED_FROM))
+				{
+					AddChange(FPath(Path), EFileChangeType::Removed, Now);
+					if ((Event.mask & (IN_ISDIR | IN_MOVED_FROM)) == (IN_ISDIR | IN_MOVED_FROM))
+					{
+						RemoveWatches(Path + '/');
+					}
+				}
+				else
+				{
+					AddChange(FPath(Path), EFileChangeType::Modified, Now);
+				}
+			}
+		}
+	}
+#else
+	bool FFileWatcher::Start(const std::wstring&, u32)
+	{
+		DEBUGPRINT("FileWatcher: Not supported on this platform");
+		return false;
+	}
+
+	void FFileWatcher::Stop()
+	{
+	}
+
+	void FFileWatcher::WatchThread()
+	{
+	}
+#endif
+
+	void FFileWatcher::PollChanges(std::vector<FFileChange>& OutChanges)
+	{
+		const auto SettleTime = std::chrono::milliseconds(SettleMilliseconds);
+		const auto Now = std::chrono::steady_clock::now();
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (auto It = PendingChanges.begin(); It != PendingChanges.end();)
+		{
+			if (Now - It->second.LastTime >= SettleTime)
+			{
+				FFileChange Change;
+				Change.Path = It->first;
+				Change.Type = It->second.Type;
+				Change.Time = It->second.FirstTime;
+				OutChanges.push_back(Change);
+				It = PendingChanges.erase(It);
+			}
+			else
+			{
+				++It;
+			}
+		}
+	}
+} // namespace topia
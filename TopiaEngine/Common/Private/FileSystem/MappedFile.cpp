@@ -0,0 +1,132 @@
+#include "Topia.h"
+#include "FileSystem/MappedFile.h"
+
+#if !defined(_WIN32)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace topia
+{
+#if defined(_WIN32)
+	bool FMappedFile::Open(const std::wstring& Path)
+	{
+		Close();
+
+		FileHandle = ::CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (FileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER FileSize;
+		if (!::GetFileSizeEx(FileHandle, &FileSize))
+		{
+			Close();
+			return false;
+		}
+
+		Size = u64(FileSize.QuadPart);
+		if (Size == 0)
+		{
+			// CreateFileMapping fails on empty files
+			return true;
+		}
+
+		MappingHandle = ::CreateFileMappingW(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (MappingHandle == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		pData = static_cast<const u8*>(::MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (pData == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void FMappedFile::Close()
+	{
+		if (pData != nullptr)
+		{
+			::UnmapViewOfFile(pData);
+			pData = nullptr;
+		}
+
+		if (MappingHandle != nullptr)
+		{
+			::CloseHandle(MappingHandle);
+			MappingHandle = nullptr;
+		}
+
+		if (FileHandle != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(FileHandle);
+			FileHandle = INVALID_HANDLE_VALUE;
+		}
+
+		Size = 0;
+	}
+#else
+	bool FMappedFile::Open(const std::wstring& Path)
+	{
+		Close();
+
+		FileDescriptor = ::open(WideToUTF8(Path).c_str(), O_RDONLY | O_CLOEXEC);
+		if (FileDescriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat Stat;
+		if (::fstat(FileDescriptor, &Stat) != 0 || !S_ISREG(Stat.st_mode))
+		{
+			Close();
+			return false;
+		}
+
+		Size = u64(Stat.st_size);
+		if (Size == 0)
+		{
+			// mmap fails on empty files
+			return true;
+		}
+
+		void* pMapping = ::mmap(nullptr, size_t(Size), PROT_READ, MAP_PRIVATE, FileDescriptor, 0);
+		if (pMapping == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+
+		// Same hint as FILE_FLAG_SEQUENTIAL_SCAN on Windows
+		::madvise(pMapping, size_t(Size), MADV_SEQUENTIAL);
+		pData = static_cast<const u8*>(pMapping);
+		return true;
+	}
+
+	void FMappedFile::Close()
+	{
+		if (pData != nullptr)
+		{
+			::munmap(const_cast<u8*>(pData), size_t(Size));
+			pData = nullptr;
+		}
+
+		if (FileDescriptor >= 0)
+		{
+			::close(FileDescriptor);
+			FileDescriptor = -1;
+		}
+
+		Size = 0;
+	}
+#endif
+} // namespace topia
@@ -0,0 +1,271 @@
+#include "Topia.h"
+#include "FileSystem/Path.h"
+
+#include <Hash.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace topia
+{
+	size_t NormalizePath(FStringView Path, char* pOut)
+	{
+		while (!Path.empty() && (Path[0] == '/' || Path[0] == '\\' || (Path[0] == '.' && Path.size() > 1 && (Path[1] == '/' || Path[1] == '\\'))))
+		{
+			Path.remove_prefix(1);
+		}
+
+		for (size_t i = 0; i < Path.size(); ++i)
+		{
+			const char Character = Path[i];
+			if (Character == '\\')
+			{
+				pOut[i] = '/';
+			}
+			else if (Character >= 'A' && Character <= 'Z')
+			{
+				pOut[i] = char(Character - 'A' + 'a');
+			}
+			else
+			{
+				pOut[i] = Character;
+			}
+		}
+		return Path.size();
+	}
+
+	std::string NormalizePath(FStringView Path)
+	{
+		std::string Normalized(Path.size(), '\0');
+		Normalized.resize(NormalizePath(Path, &Normalized[0]));
+		return Normalized;
+	}
+
+	/**
+	 * Entries are allocated in chunks that never move, so an entry is read without the lock: whoever holds an FPath got its index
+	 * after the entry was written. The strings are packed in pages of the same lifetime.
+	 */
+	class FPathTable
+	{
+	public:
+		static FPathTable& Get()
+		{
+			static FPathTable Table;
+			return Table;
+		}
+
+		FPathTable()
+		{
+			for (std::atomic<FEntry*>& Chunk : Chunks)
+			{
+				Chunk.store(nullptr, std::memory_order_relaxed);
+			}
+			Buckets.resize(1024, 0);
+
+			// Index 0 is the empty path
+			Add(FStringView(), Hash64(nullptr, 0));
+		}
+
+		struct FEntry
+		{
+			const char* pString;
+			u32 Length;
+			u64 Hash;
+		};
+
+		const FEntry& GetEntry(u32 Id) const
+		{
+			return Chunks[Id >> CHUNK_BITS].load(std::memory_order_acquire)[Id & (CHUNK_SIZE - 1)];
+		}
+
+		u32 GetNumEntries() const
+		{
+			std::shared_lock<std::shared_timed_mutex> Lock(Mutex);
+			return NumEntries;
+		}
+
+		/** Index of the normalized path, 0 when it isn't in the table and bAdd is false */
+		u32 FindOrAdd(FStringView Normalized, bool bAdd)
+		{
+			const u64 Hash = Hash64(Normalized.data(), Normalized.size());
+			{
+				std::shared_lock<std::shared_timed_mutex> Lock(Mutex);
+				const u32 Id = FindLocked(Normalized, Hash);
+				if (Id != 0 || !bAdd || Normalized.empty())
+				{
+					return Id;
+				}
+			}
+
+			std::unique_lock<std::shared_timed_mutex> Lock(Mutex);
+			const u32 Id = FindLocked(Normalized, Hash);
+			return Id != 0 ? Id : Add(Normalized, Hash);
+		}
+
+	private:
+		static constexpr u32 CHUNK_BITS = 12;
+		static constexpr u32 CHUNK_SIZE = 1u << CHUNK_BITS;
+		static constexpr u32 MAX_CHUNKS = 4096;                 // 16M paths
+		static constexpr size_t STRING_PAGE_SIZE = 64 * 1024;
+
+		/** Open addressing with linear probing, Buckets holds indices and 0 marks an empty bucket */
+		u32 FindLocked(FStringView Normalized, u64 Hash) const
+		{
+			const size_t Mask = Buckets.size() - 1;
+			for (size_t b = size_t(Hash) & Mask; Buckets[b] != 0; b = (b + 1) & Mask)
+			{
+				const FEntry& Entry = GetEntry(Buckets[b]);
+				if (Entry.Hash == Hash && Entry.Length == Normalized.size() && memcmp(Entry.pString, Normalized.data(), Normalized.size()) == 0)
+				{
+					return Buckets[b];
+				}
+			}
+			return 0;
+		}
+
+		u32 Add(FStringView Normalized, u64 Hash)
+		{
+			const u32 Id = NumEntries;
+			ASSERT((Id >> CHUNK_BITS) < MAX_CHUNKS);
+			FEntry* pChunk = Chunks[Id >> CHUNK_BITS].load(std::memory_order_relaxed);
+			if (pChunk == nullptr)
+			{
+				ChunkStorage.emplace_back(new FEntry[CHUNK_SIZE]);
+				pChunk = ChunkStorage.back().get();
+				Chunks[Id >> CHUNK_BITS].store(pChunk, std::memory_order_release);
+			}
+
+			FEntry& Entry = pChunk[Id & (CHUNK_SIZE - 1)];
+			Entry.pString = StoreString(Normalized);
+			Entry.Length = u32(Normalized.size());
+			Entry.Hash = Hash;
+			++NumEntries;
+
+			// Keep the buckets at most half full
+			if (Id != 0)
+			{
+				if (NumEntries * 2 > Buckets.size())
+				{
+					std::vector<u32> OldBuckets(Buckets.size() * 2, 0);
+					OldBuckets.swap(Buckets);
+					for (u32 OldId : OldBuckets)
+					{
+						if (OldId != 0)
+						{
+							Insert(OldId, GetEntry(OldId).Hash);
+						}
+					}
+				}
+				Insert(Id, Hash);
+			}
+			return Id;
+		}
+
+		void Insert(u32 Id, u64 Hash)
+		{
+			const size_t Mask = Buckets.size() - 1;
+			size_t b = size_t(Hash) & Mask;
+			while (Buckets[b] != 0)
+			{
+				b = (b + 1) & Mask;
+			}
+			Buckets[b] = Id;
+		}
+
+		const char* StoreString(FStringView String)
+		{
+			if (String.size() > STRING_PAGE_SIZE / 4)
+			{
+				StringPages.emplace_back(new char[String.size()]);
+				memcpy(StringPages.back().get(), String.data(), String.size());
+				return StringPages.back().get();
+			}
+			if (String.size() > PageSpace)
+			{
+				StringPages.emplace_back(new char[STRING_PAGE_SIZE]);
+				pPage = StringPages.back().get();
+				PageSpace = STRING_PAGE_SIZE;
+			}
+			char* pString = pPage;
+			memcpy(pString, String.data(), String.size());
+			pPage += String.size();
+			PageSpace -= String.size();
+			return pString;
+		}
+
+		mutable std::shared_timed_mutex Mutex;
+		std::atomic<FEntry*> Chunks[MAX_CHUNKS];
+		std::vector<std::unique_ptr<FEntry[]>> ChunkStorage;
+		u32 NumEntries = 0;
+		std::vector<u32> Buckets;
+		std::vector<std::unique_ptr<char[]>> StringPages;
+		char* pPage = nullptr;
+		size_t PageSpace = 0;
+	};
+
+	/** Normalize into a stack buffer, the common case of a lookup doesn't allocate */
+	template <typename Func>
+	static auto sWithNormalizedPath(FStringView Path, const Func& Function) -> decltype(Function(Path))
+	{
+		char Buffer[512];
+		std::unique_ptr<char[]> LongBuffer;
+		char* pBuffer = Buffer;
+		if (Path.size() > sizeof(Buffer))
+		{
+			LongBuffer.reset(new char[Path.size()]);
+			pBuffer = LongBuffer.get();
+		}
+		return Function(FStringView(pBuffer, NormalizePath(Path, pBuffer)));
+	}
+
+	FPath::FPath(FStringView Path)
+		: Id(sWithNormalizedPath(Path, [](FStringView Normalized) { return FPathTable::Get().FindOrAdd(Normalized, true); }))
+	{
+	}
+
+	FPath FPath::Find(FStringView Path)
+	{
+		return FPath(sWithNormalizedPath(Path, [](FStringView Normalized) { return FPathTable::Get().FindOrAdd(Normalized, false); }));
+	}
+
+	u32 FPath::GetNumInternedPaths()
+	{
+		return FPathTable::Get().GetNumEntries();
+	}
+
+	u64 FPath::GetHash() const
+	{
+		return FPathTable::Get().GetEntry(Id).Hash;
+	}
+
+	FStringView FPath::GetString() const
+	{
+		const FPathTable::FEntry& Entry = FPathTable::Get().GetEntry(Id);
+		return FStringView(Entry.pString, Entry.Length);
+	}
+
+	FStringView FPath::GetDirectory() const
+	{
+		const FStringView String = GetString();
+		const size_t LastSlash = String.rfind('/');
+		return LastSlash == FStringView::npos ? FStringView() : String.substr(0, LastSlash + 1);
+	}
+
+	FStringView FPath::GetFileName() const
+	{
+		const FStringView String = GetString();
+		const size_t LastSlash = String.rfind('/');
+		return LastSlash == FStringView::npos ? String : String.substr(LastSlash + 1);
+	}
+
+	FStringView FPath::GetExtension() const
+	{
+		const FStringView FileName = GetFileName();
+		const size_t Dot = FileName.rfind('.');
+		return Dot == FStringView::npos ? FStringView() : FileName.substr(Dot + 1);
+	}
+} // namespace topia
@@ -0,0 +1,184 @@
+#include "Topia.h"
+#include "FileSystem/VirtualFileSystem.h"
+#include "FileSystem/AsyncIO.h"
+
+#include <Hash.h>
+
+#include <cstring>
+
+namespace topia
+{
+#if defined(_WIN32)
+	static constexpr wchar_t PATH_SEPARATOR = L'\\';
+#else
+	static constexpr wchar_t PATH_SEPARATOR = L'/';
+#endif
+
+	FLooseDirectoryMount::FLooseDirectoryMount(const std::wstring& InRoot)
+		: Root(InRoot)
+	{
+		if (!Root.empty() && Root.back() != L'\\' && Root.back() != L'/')
+		{
+			Root += PATH_SEPARATOR;
+		}
+	}
+
+	std::wstring FLooseDirectoryMount::GetFullPath(FStringView RelativePath) const
+	{
+		std::wstring FullPath(Root.size() + RelativePath.size(), L'\0');
+		memcpy(&FullPath[0], Root.data(), Root.size() * sizeof(wchar_t));
+		FullPath.resize(Root.size() + UTF8ToWide(RelativePath, &FullPath[Root.size()]));
+		for (size_t i = Root.size(); i < FullPath.size(); ++i)
+		{
+			if (FullPath[i] == L'/')
+			{
+				FullPath[i] = PATH_SEPARATOR;
+			}
+		}
+		return FullPath;
+	}
+
+	bool FLooseDirectoryMount::GetSize(FPath, FStringView RelativePath, u64& OutSize) const
+	{
+		FAsyncFile File;
+		if (!File.Open(GetFullPath(RelativePath)))
+		{
+			return false;
+		}
+		OutSize = File.GetSize();
+		return true;
+	}
+
+	bool FLooseDirectoryMount::Read(FPath, FStringView RelativePath, std::vector<u8>& OutData) const
+	{
+		FAsyncFile File;
+		if (!File.Open(GetFullPath(RelativePath)))
+		{
+			return false;
+		}
+		OutData.resize(size_t(File.GetSize()));
+		return File.Read(0, File.GetSize(), OutData.data()) == File.GetSize();
+	}
+
+	FArchiveMount::FArchiveMount(const std::wstring& ArchivePath)
+	{
+		Archive.Open(ArchivePath);
+	}
+
+	u32 FArchiveMount::Find(FPath Path, FStringView RelativePath) const
+	{
+		if (!Archive.IsOpen())
+		{
+			return FArchive::INVALID_INDEX;
+		}
+
+		// At the root the archive stores the interned path itself, its precomputed hash is the one of the table of contents
+		const u64 PathHash = RelativePath.size() == Path.GetString().size() ? Path.GetHash() : Hash64(RelativePath.data(), RelativePath.size());
+		return Archive.Find(PathHash, RelativePath);
+	}
+
+	bool FArchiveMount::GetSize(FPath Path, FStringView RelativePath, u64& OutSize) const
+	{
+		const u32 Entry = Find(Path, RelativePath);
+		if (Entry == FArchive::INVALID_INDEX)
+		{
+			return false;
+		}
+		OutSize = Archive.GetSize(Entry);
+		return true;
+	}
+
+	bool FArchiveMount::Read(FPath Path, FStringView RelativePath, std::vector<u8>& OutData) const
+	{
+		const u32 Entry = Find(Path, RelativePath);
+		return Entry != FArchive::INVALID_INDEX && Archive.Read(Entry, OutData);
+	}
+
+	void FMemoryMount::AddFile(FStringView RelativePath, std::vector<u8>&& Data)
+	{
+		Files[FPath(RelativePath)] = std::move(Data);
+	}
+
+	const std::vector<u8>* FMemoryMount::Find(FPath Path, FStringView RelativePath) const
+	{
+		const FPath Key = RelativePath.size() == Path.GetString().size() ? Path : FPath::Find(RelativePath);
+		const auto It = Files.find(Key);
+		return It != Files.end() && !Key.IsEmpty() ? &It->second : nullptr;
+	}
+
+	bool FMemoryMount::GetSize(FPath Path, FStringView RelativePath, u64& OutSize) const
+	{
+		const std::vector<u8>* pData = Find(Path, RelativePath);
+		if (pData == nullptr)
+		{
+			return false;
+		}
+		OutSize = pData->size();
+		return true;
+	}
+
+	bool FMemoryMount::Read(FPath Path, FStringView RelativePath, std::vector<u8>& OutData) const
+	{
+		const std::vector<u8>* pData = Find(Path, RelativePath);
+		if (pData == nullptr)
+		{
+			return false;
+		}
+		OutData = *pData;
+		return true;
+	}
+
+	void FVirtualFileSystem::Mount(FStringView Prefix, std::unique_ptr<IMountPoint> pMountPoint)
+	{
+		FMount NewMount;
+		NewMount.Prefix = NormalizePath(Prefix);
+		if (!NewMount.Prefix.empty() && NewMount.Prefix.back() != '/')
+		{
+			NewMount.Prefix += '/';
+		}
+		NewMount.pMountPoint = std::move(pMountPoint);
+		Mounts.push_back(std::move(NewMount));
+	}
+
+	void FVirtualFileSystem::UnmountAll()
+	{
+		Mounts.clear();
+	}
+
+	template <typename Func>
+	bool FVirtualFileSystem::ForEachMount(FPath Path, const Func& Function) const
+	{
+		const FStringView String = Path.GetString();
+		for (size_t m = Mounts.size(); m-- > 0;)
+		{
+			const FMount& Mount = Mounts[m];
+			if (String.starts_with(Mount.Prefix) && Function(*Mount.pMountPoint, String.substr(Mount.Prefix.size())))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool FVirtualFileSystem::Exists(FPath Path) const
+	{
+		u64 Size;
+		return GetSize(Path, Size);
+	}
+
+	bool FVirtualFileSystem::GetSize(FPath Path, u64& OutSize) const
+	{
+		return !Path.IsEmpty() && ForEachMount(Path, [&](const IMountPoint& MountPoint, FStringView RelativePath)
+		{
+			return MountPoint.GetSize(Path, RelativePath, OutSize);
+		});
+	}
+
+	bool FVirtualFileSystem::Read(FPath Path, std::vector<u8>& OutData) const
+	{
+		return !Path.IsEmpty() && ForEachMount(Path, [&](const IMountPoint& MountPoint, FStringView RelativePath)
+		{
+			return MountPoint.Read(Path, RelativePath, OutData);
+		});
+	}
+} // namespace topia
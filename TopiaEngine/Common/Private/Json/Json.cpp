@@ -0,0 +1,479 @@
+#include "Topia.h"
+#include "Json/Json.h"
+
+namespace topia
+{
+	/** Recursive descent parser that appends the values in document order */
+	class FJsonDocument::FParser
+	{
+	public:
+		FParser(FJsonDocument& InDocument, const char* pText, size_t Length) : Document(InDocument), pBegin(pText), pCur(pText), pEnd(pText + Length) {}
+
+		bool ParseDocument()
+		{
+			SkipWhitespace();
+			if (!ParseValue(0, 0))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			return pCur == pEnd || Fail("Unexpected data after the root value");
+		}
+
+	private:
+		/** Deeper nesting is rejected instead of overflowing the stack */
+		static constexpr u32 MAX_DEPTH = 256;
+
+		bool Fail(const char* Message)
+		{
+			if (Document.Error.empty())
+			{
+				Document.Error = std::string(Message) + " at offset " + std::to_string(pCur - pBegin);
+			}
+			return false;
+		}
+
+		void SkipWhitespace()
+		{
+			while (pCur < pEnd && (*pCur == ' ' || *pCur == '\t' || *pCur == '\n' || *pCur == '\r'))
+			{
+				++pCur;
+			}
+		}
+
+		bool Match(const char* Keyword, size_t Length)
+		{
+			if (size_t(pEnd - pCur) < Length || memcmp(pCur, Keyword, Length) != 0)
+			{
+				return Fail("Invalid literal");
+			}
+			pCur += Length;
+			return true;
+		}
+
+		/** Scan a string starting at the opening quote, returns the offset and length of its contents */
+		bool ScanString(u32& OutOffset, u32& OutLength)
+		{
+			ASSERT(*pCur == '"');
+			const char* pStart = ++pCur;
+			for (;;)
+			{
+				if (pCur >= pEnd)
+				{
+					return Fail("Unterminated string");
+				}
+
+				const char c = *pCur;
+				if (c == '"')
+				{
+					break;
+				}
+				else if (c == '\\')
+				{
+					// The escape itself is validated when the string is resolved, here we only need to not stop at \"
+					if (++pCur >= pEnd)
+					{
+						return Fail("Unterminated string");
+					}
+				}
+				else if (u8(c) < 0x20)
+				{
+					return Fail("Control character in string");
+				}
+				++pCur;
+			}
+
+			OutOffset = u32(pStart - pBegin);
+			OutLength = u32(pCur - pStart);
+			++pCur;
+			return true;
+		}
+
+		bool ScanNumber(double& OutNumber)
+		{
+			const char* pStart = pCur;
+			if (pCur < pEnd && *pCur == '-')
+			{
+				++pCur;
+			}
+			while (pCur < pEnd && ((*pCur >= '0' && *pCur <= '9') || *pCur == '.' || *pCur == 'e' || *pCur == 'E' || *pCur == '+' || *pCur == '-'))
+			{
+				++pCur;
+			}
+
+			// The source has no terminator, so convert from a local copy
+			char Buffer[64];
+			const size_t Length = size_t(pCur - pStart);
+			if (Length == 0 || Length >= sizeof(Buffer))
+			{
+				return Fail("Invalid number");
+			}
+			memcpy(Buffer, pStart, Length);
+			Buffer[Length] = '\0';
+
+			char* pNumberEnd = nullptr;
+			OutNumber = strtod(Buffer, &pNumberEnd);
+			return pNumberEnd == Buffer + Length || Fail("Invalid number");
+		}
+
+		bool ParseValue(u32 Depth, u32 KeyOffset, u32 KeyLength = 0)
+		{
+			if (Depth > MAX_DEPTH)
+			{
+				return Fail("Nesting too deep");
+			}
+			if (pCur >= pEnd)
+			{
+				return Fail("Unexpected end of data");
+			}
+
+			const u32 Index = u32(Document.Values.size());
+			Document.Values.push_back(FNode());
+			FNode* pNode = &Document.Values.back();
+			pNode->KeyOffset = KeyOffset;
+			pNode->KeyLength = KeyLength;
+
+			switch (*pCur)
+			{
+			case '{':
+			case '[':
+			{
+				const bool bObject = *pCur == '{';
+				const char Close = bObject ? '}' : ']';
+				pNode->Type = bObject ? EJsonType::Object : EJsonType::Array;
+				++pCur;
+
+				u32 NumChildren = 0;
+				SkipWhitespace();
+				if (pCur < pEnd && *pCur == Close)
+				{
+					++pCur;
+				}
+				else
+				{
+					for (;;)
+					{
+						u32 ChildKeyOffset = 0, ChildKeyLength = 0;
+						if (bObject)
+						{
+							if (pCur >= pEnd || *pCur != '"')
+							{
+								return Fail("Expected member name");
+							}
+							if (!ScanString(ChildKeyOffset, ChildKeyLength))
+							{
+								return false;
+							}
+							SkipWhitespace();
+							if (pCur >= pEnd || *pCur != ':')
+							{
+								return Fail("Expected ':'");
+							}
+							++pCur;
+							SkipWhitespace();
+						}
+
+						if (!ParseValue(Depth + 1, ChildKeyOffset, ChildKeyLength))
+						{
+							return false;
+						}
+						++NumChildren;
+
+						SkipWhitespace();
+						if (pCur < pEnd && *pCur == ',')
+						{
+							++pCur;
+							SkipWhitespace();
+						}
+						else if (pCur < pEnd && *pCur == Close)
+						{
+							++pCur;
+							break;
+						}
+						else
+						{
+							return Fail(bObject ? "Expected ',' or '}'" : "Expected ',' or ']'");
+						}
+					}
+				}
+
+				// Children were appended, so the node may have moved
+				pNode = &Document.Values[Index];
+				pNode->NumChildren = NumChildren;
+				break;
+			}
+
+			case '"':
+				pNode->Type = EJsonType::String;
+				if (!ScanString(pNode->StringOffset, pNode->StringLength))
+				{
+					return false;
+				}
+				break;
+
+			case 't':
+				pNode->Type = EJsonType::Bool;
+				pNode->bBool = true;
+				if (!Match("true", 4))
+				{
+					return false;
+				}
+				break;
+
+			case 'f':
+				pNode->Type = EJsonType::Bool;
+				if (!Match("false", 5))
+				{
+					return false;
+				}
+				break;
+
+			case 'n':
+				pNode->Type = EJsonType::Null;
+				if (!Match("null", 4))
+				{
+					return false;
+				}
+				break;
+
+			default:
+				pNode->Type = EJsonType::Number;
+				if (!ScanNumber(pNode->Number))
+				{
+					return false;
+				}
+				break;
+			}
+
+			Document.Values[Index].End = u32(Document.Values.size());
+			return true;
+		}
+
+		FJsonDocument& Document;
+		const char* pBegin;
+		const char* pCur;
+		const char* pEnd;
+	};
+
+	bool FJsonDocument::Parse(const char* pText, size_t Length)
+	{
+		ASSERT(Length < 0xffffffffu);
+
+		pSource = pText;
+		Values.clear();
+		Error.clear();
+
+		// A rough upper bound that avoids most reallocations, glTF JSON averages well above 8 bytes per value
+		Values.reserve(Length / 8 + 1);
+
+		FParser Parser(*this, pText, Length);
+		if (!Parser.ParseDocument())
+		{
+			Values.clear();
+			return false;
+		}
+		return true;
+	}
+
+	EJsonType FJsonValue::GetType() const
+	{
+		ASSERT(IsValid());
+		return pDocument->Values[Index].Type;
+	}
+
+	FJsonValue FJsonValue::operator[](const char* Key) const
+	{
+		if (!IsObject())
+		{
+			return FJsonValue();
+		}
+
+		const size_t KeyLength = strlen(Key);
+		for (FJsonValue Child = GetFirstChild(); Child.IsValid(); Child = Child.GetNextSibling())
+		{
+			const FJsonDocument::FNode& Node = pDocument->Values[Child.Index];
+			if (Node.KeyLength == KeyLength && memcmp(pDocument->pSource + Node.KeyOffset, Key, KeyLength) == 0)
+			{
+				return Child;
+			}
+		}
+		return FJsonValue();
+	}
+
+	u32 FJsonValue::Num() const
+	{
+		return IsArray() || IsObject() ? pDocument->Values[Index].NumChildren : 0;
+	}
+
+	FJsonValue FJsonValue::GetFirstChild() const
+	{
+		return Num() > 0 ? FJsonValue(pDocument, Index + 1, pDocument->Values[Index].End) : FJsonValue();
+	}
+
+	FJsonValue FJsonValue::GetNextSibling() const
+	{
+		if (!IsValid())
+		{
+			return FJsonValue();
+		}
+
+		// The next sibling directly follows our subtree
+		const u32 Next = pDocument->Values[Index].End;
+		return Next < ParentEnd ? FJsonValue(pDocument, Next, ParentEnd) : FJsonValue();
+	}
+
+	const char* FJsonValue::GetKey(u32& OutLength) const
+	{
+		ASSERT(IsValid());
+		const FJsonDocument::FNode& Node = pDocument->Values[Index];
+		OutLength = Node.KeyLength;
+		return pDocument->pSource + Node.KeyOffset;
+	}
+
+	bool FJsonValue::GetBool(bool Default) const
+	{
+		return IsBool() ? pDocument->Values[Index].bBool : Default;
+	}
+
+	double FJsonValue::GetNumber(double Default) const
+	{
+		return IsNumber() ? pDocument->Values[Index].Number : Default;
+	}
+
+	u32 FJsonValue::GetU32(u32 Default) const
+	{
+		const double Number = GetNumber(-1.0);
+		return Number >= 0.0 && Number <= double(0xffffffffu) ? u32(Number) : Default;
+	}
+
+	u64 FJsonValue::GetU64(u64 Default) const
+	{
+		// 2^64 itself is the first double that doesn't fit, converting it (or anything larger or negative) is undefined
+		const double Number = GetNumber(-1.0);
+		return Number >= 0.0 && Number < 18446744073709551616.0 ? u64(Number) : Default;
+	}
+
+	static void sAppendUTF8(std::string& ioString, u32 CodePoint)
+	{
+		if (CodePoint < 0x80)
+		{
+			ioString += char(CodePoint);
+		}
+		else if (CodePoint < 0x800)
+		{
+			ioString += char(0xc0 | (CodePoint >> 6));
+			ioString += char(0x80 | (CodePoint & 0x3f));
+		}
+		else if (CodePoint < 0x10000)
+		{
+			ioString += char(0xe0 | (CodePoint >> 12));
+			ioString += char(0x80 | ((CodePoint >> 6) & 0x3f));
+			ioString += char(0x80 | (CodePoint & 0x3f));
+		}
+		else
+		{
+			ioString += char(0xf0 | (CodePoint >> 18));
+			ioString += char(0x80 | ((CodePoint >> 12) & 0x3f));
+			ioString += char(0x80 | ((CodePoint >> 6) & 0x3f));
+			ioString += char(0x80 | (CodePoint & 0x3f));
+		}
+	}
+
+	static bool sParseHex4(const char* pText, const char* pEnd, u32& OutValue)
+	{
+		if (pEnd - pText < 4)
+		{
+			return false;
+		}
+
+		OutValue = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const char c = pText[i];
+			u32 Digit;
+			if (c >= '0' && c <= '9')
+				Digit = u32(c - '0');
+			else if (c >= 'a' && c <= 'f')
+				Digit = u32(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F')
+				Digit = u32(c - 'A' + 10);
+			else
+				return false;
+			OutValue = (OutValue << 4) | Digit;
+		}
+		return true;
+	}
+
+	std::string FJsonValue::GetString(const std::string& Default) const
+	{
+		if (!IsString())
+		{
+			return Default;
+		}
+
+		const FJsonDocument::FNode& Node = pDocument->Values[Index];
+		const char* pText = pDocument->pSource + Node.StringOffset;
+		const char* pEnd = pText + Node.StringLength;
+
+		std::string Result;
+		Result.reserve(Node.StringLength);
+		while (pText < pEnd)
+		{
+			const char c = *pText++;
+			if (c != '\\')
+			{
+				Result += c;
+				continue;
+			}
+
+			// The parser guarantees that a backslash is followed by a character
+			const char Escape = *pText++;
+			switch (Escape)
+			{
+			case '"':  Result += '"'; break;
+			case '\\': Result += '\\'; break;
+			case '/':  Result += '/'; break;
+			case 'b':  Result += '\b'; break;
+			case 'f':  Result += '\f'; break;
+			case 'n':  Result += '\n'; break;
+			case 'r':  Result += '\r'; break;
+			case 't':  Result += '\t'; break;
+			case 'u':
+			{
+				u32 CodePoint;
+				if (!sParseHex4(pText, pEnd, CodePoint))
+				{
+					return Default;
+				}
+				pText += 4;
+
+				// Combine a UTF-16 surrogate pair
+				u32 Low;
+				if (CodePoint >= 0xd800 && CodePoint < 0xdc00 && pEnd - pText >= 6 && pText[0] == '\\' && pText[1] == 'u'
+					&& sParseHex4(pText + 2, pEnd, Low) && Low >= 0xdc00 && Low < 0xe000)
+				{
+					CodePoint = 0x10000 + ((CodePoint - 0xd800) << 10) + (Low - 0xdc00);
+					pText += 6;
+				}
+				sAppendUTF8(Result, CodePoint);
+				break;
+			}
+			default:
+				return Default;
+			}
+		}
+		return Result;
+	}
+
+	bool FJsonValue::EqualsString(const char* String) const
+	{
+		if (!IsString())
+		{
+			return false;
+		}
+
+		const FJsonDocument::FNode& Node = pDocument->Values[Index];
+		return strlen(String) == Node.StringLength && memcmp(pDocument->pSource + Node.StringOffset, String, Node.StringLength) == 0;
+	}
+} // namespace topia
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Topia.h>
+
+namespace topia
+{
+	/**
+	 * Compression in the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), so blocks can be
+	 * produced or inspected with the reference tools. Greedy matching with a single hash table, like LZ4_compress_default.
+	 */
+
+	/** Size of the buffer CompressLZ4 needs in the worst case, incompressible data grows slightly */
+	TOPIA_INLINE u32 GetMaxCompressedSizeLZ4(u32 Size) { return Size + Size / 255 + 16; }
+
+	/** Compress Size bytes into pDestination, returns the compressed size or 0 when it doesn't fit in DestinationCapacity */
+	u32 CompressLZ4(const void* pSource, u32 Size, void* pDestination, u32 DestinationCapacity);
+
+	/**
+	 * Decompress a block of CompressedSize bytes that expands to exactly DecompressedSize bytes. Returns false on malformed
+	 * input, which never reads or writes outside the two buffers.
+	 */
+	bool DecompressLZ4(const void* pSource, u32 CompressedSize, void* pDestination, u32 DecompressedSize);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Topia.h>
+#include <Noncopyable.h>
+
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace topia
+{
+	class FMappedFile;
+
+	/**
+	 * Identifies a derived data entry: a type name (the kind of data and the file name prefix), the version of the code that builds it
+	 * and everything the result depends on, usually the content of the source asset and the build settings. Only a 64 bit Hash64 of
+	 * the inputs is kept. Bump the version whenever the build code changes its output, old entries are then never hit again and age out.
+	 */
+	class FDerivedDataKey
+	{
+	public:
+		FDerivedDataKey(const char* pType, u32 Version);
+
+		/** Bytes the result depends on */
+		FDerivedDataKey& Add(const void* pData, size_t Size);
+
+		/** A value the result depends on. Add structs field by field, their padding bytes are undefined. */
+		template <typename T>
+		FDerivedDataKey& AddValue(const T& Value)
+		{
+			static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Add the fields of a struct one by one");
+			return Add(&Value, sizeof(T));
+		}
+
+		/** File name of the entry, <Type>_<16 hex digits>.ddc */
+		std::wstring GetFileName() const;
+
+		u64 GetHash() const { return Hash; }
+
+	private:
+		std::string Type;
+		u64 Hash = 0;
+	};
+
+	/** Data of a cache hit, mapped from the cache and valid as long as File is alive */
+	struct FDerivedData
+	{
+		std::shared_ptr<FMappedFile> File;
+		const u8* pData = nullptr;
+		u64 Size = 0;
+	};
+
+	struct FDerivedDataCacheStats
+	{
+		u32 NumHits = 0;
+		u32 NumMisses = 0;
+		u32 NumPuts = 0;
+		u32 NumEvictions = 0;
+		u64 BytesRead = 0;
+		u64 BytesWritten = 0;
+		double BuildSeconds = 0.0;  // Spent building the data of misses, as reported to Put
+		double SavedSeconds = 0.0;  // Build time of the hits when they were put, minus the time Get took to fetch them
+
+		float GetHitRate() const { return NumHits + NumMisses > 0 ? float(NumHits) / float(NumHits + NumMisses) : 0.0f; }
+	};
+
+	/**
+	 * Local cache of the results of expensive import steps, one file per entry in a directory. Entries are written atomically, so
+	 * several threads and processes can share a directory: a reader sees a complete entry or none, concurrent writers of the same
+	 * key write the same data and the last rename wins.
+	 *
+	 * The directory is kept under MaxSize bytes by deleting the least recently used entries. A hit refreshes the write time of its
+	 * file, which is the time the eviction sorts by, since the last access time is often not maintained by the file system.
+	 */
+	class FDerivedDataCache : public NonCopyable
+	{
+	public:
+		/** Creates Directory if needed. With bVerifyHashes every hit reads its whole entry to check the hash stored with it. */
+		FDerivedDataCache(const std::wstring& Directory, u64 MaxSize, bool bVerifyHashes = false);
+
+		/** Returns false on a miss, which includes entries that are truncated, corrupt or from another key with the same name */
+		bool Get(const FDerivedDataKey& Key, FDerivedData& OutData);
+
+		/** Store the data of Key, BuildSeconds is the time it took to build, for the statistics. Returns false when it can't be written. */
+		bool Put(const FDerivedDataKey& Key, const void* pData, u64 Size, double BuildSeconds);
+
+		/** Delete the least recently used entries until the directory holds at most MaxSize bytes, returns the number deleted */
+		u32 Trim();
+
+		FDerivedDataCacheStats GetStats() const;
+		void ResetStats();
+
+		/** Print the statistics with DEBUGPRINT */
+		void LogStats() const;
+
+		const std::wstring& GetDirectory() const { return Directory; }
+
+	private:
+		std::wstring Directory;     // With a trailing separator
+		u64 MaxSize = 0;
+		bool bVerifyHashes = false;
+
+		mutable std::mutex Mutex;
+		u64 CurrentSize = 0;        // Estimate of the size of the directory, corrected by every Trim
+		FDerivedDataCacheStats Stats;
+	};
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Topia.h>
+#include <Noncopyable.h>
+#include <ThreadPool.h>
+
+#include "MappedFile.h"
+#include "Path.h"
+
+#include <vector>
+
+namespace topia
+{
+	/**
+	 * Archive file (.tpak): many asset files in one, so loading them costs one open instead of one per file. The file is a header,
+	 * the data blocks, then the table of contents. Every file is split into blocks of BlockSize bytes that are compressed
+	 * separately with LZ4 (or stored when that doesn't make them smaller), so any range of a file is read by decompressing only the
+	 * blocks it covers. The entries are sorted by the hash of their path, a lookup is a binary search.
+	 *
+	 * Paths are relative UTF-8 paths, normalized by NormalizeArchivePath.
+	 */
+	static constexpr u32 ARCHIVE_MAGIC = 0x4B415054; // "TPAK"
+	static constexpr u32 ARCHIVE_VERSION = 1;
+	static constexpr u32 ARCHIVE_DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	struct FArchiveHeader
+	{
+		u32 Magic = ARCHIVE_MAGIC;
+		u32 Version = ARCHIVE_VERSION;
+		u32 BlockSize = ARCHIVE_DEFAULT_BLOCK_SIZE;
+		u32 NumEntries = 0;
+		u32 NumBlocks = 0;
+		u32 NamesSize = 0;
+		u64 EntriesOffset = 0;      // FArchiveEntry[NumEntries], sorted by PathHash
+		u64 BlocksOffset = 0;       // FArchiveBlock[NumBlocks]
+		u64 NamesOffset = 0;        // Paths of the entries, not null terminated
+		u64 TableHash = 0;          // Hash64 of the file from EntriesOffset to the end, checked by FArchive::Open
+	};
+
+	struct FArchiveEntry
+	{
+		u64 PathHash = 0;           // Hash64 of the normalized path
+		u64 Size = 0;
+		u32 FirstBlock = 0;         // Followed by the other blocks of the file, Size / BlockSize rounded up in total
+		u32 NameOffset = 0;
+		u32 NameLength = 0;
+		u32 Padding = 0;
+	};
+
+	struct FArchiveBlock
+	{
+		u64 Offset = 0;
+		u32 CompressedSize = 0;     // Equal to the size of the block when it is stored uncompressed
+		u32 Padding = 0;
+	};
+
+	static_assert(sizeof(FArchiveHeader) == 56, "FArchiveHeader is stored as is");
+	static_assert(sizeof(FArchiveEntry) == 32, "FArchiveEntry is stored as is");
+
+	/** NormalizePath, archives store the paths the way FPath interns them */
+	inline std::string NormalizeArchivePath(const std::string& Path) { return NormalizePath(Path); }
+
+	/** Read access to an archive. The archive is memory mapped and every function is const, so any number of threads can read it. */
+	class FArchive : public NonCopyable
+	{
+	public:
+		static constexpr u32 INVALID_INDEX = ~0u;
+
+		/** Returns false when the file can't be opened or is not a valid archive */
+		bool Open(const std::wstring& Path);
+		void Close();
+
+		bool IsOpen() const { return pHeader != nullptr; }
+
+		/** Entry of Path, or INVALID_INDEX */
+		u32 Find(const std::string& Path) const;
+
+		/** Find with a path already normalized and its Hash64, such as the string and hash of an FPath */
+		u32 Find(u64 PathHash, FStringView NormalizedPath) const;
+
+		u32 GetNumEntries() const { return pHeader->NumEntries; }
+		u64 GetSize(u32 Entry) const { return pEntries[Entry].Size; }
+		std::string GetPath(u32 Entry) const;
+
+		/**
+		 * Read Size bytes at Offset in an entry, decompressing only the blocks the range covers. Returns false when the range is
+		 * outside the file or a block is corrupt. Any number of threads can read at once. With pPool the blocks of the range are
+		 * decompressed on the pool, otherwise one after the other on the calling thread.
+		 */
+		bool Read(u32 Entry, u64 Offset, u64 Size, void* pDestination, FThreadPool* pPool = nullptr) const;
+
+		/** The whole entry */
+		bool Read(u32 Entry, std::vector<u8>& OutData, FThreadPool* pPool = nullptr) const;
+
+	private:
+		bool DecompressBlock(u32 Block, u32 BlockSize, u8* pDestination) const;
+
+		FMappedFile File;
+		const FArchiveHeader* pHeader = nullptr;
+		const FArchiveEntry* pEntries = nullptr;
+		const FArchiveBlock* pBlocks = nullptr;
+		const char* pNames = nullptr;
+	};
+
+	/** Builds an archive in memory and writes it */
+	class FArchiveWriter : public NonCopyable
+	{
+	public:
+		explicit FArchiveWriter(u32 InBlockSize = ARCHIVE_DEFAULT_BLOCK_SIZE, bool bInCompress = true)
+			: BlockSize(InBlockSize)
+			, bCompress(bInCompress)
+		{
+		}
+
+		/** Returns false when the archive already has a file with the same normalized path */
+		bool AddFile(const std::string& Path, std::vector<u8>&& Data);
+
+		/** Compress the blocks, on pPool when given, and write the archive atomically */
+		bool Write(const std::wstring& Path, FThreadPool* pPool = nullptr) const;
+
+	private:
+		struct FFile
+		{
+			std::string Path;
+			u64 PathHash = 0;
+			std::vector<u8> Data;
+		};
+
+		u32 BlockSize;
+		bool bCompress;
+		std::vector<FFile> Files;
+	};
+}
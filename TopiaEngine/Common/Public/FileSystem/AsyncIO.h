@@ -0,0 +1,178 @@
+#pragma once
+
+#include <Topia.h>
+#include <Platforms.h>
+#include <Noncopyable.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace topia
+{
+	/** File opened for reads at any offset from any thread */
+	class FAsyncFile : public NonCopyable
+	{
+	public:
+		FAsyncFile() = default;
+		~FAsyncFile() { Close(); }
+
+		bool Open(const std::wstring& Path);
+		void Close();
+
+#if defined(_WIN32)
+		bool IsOpen() const { return FileHandle != INVALID_HANDLE_VALUE; }
+#else
+		bool IsOpen() const { return FileDescriptor >= 0; }
+#endif
+		u64 GetSize() const { return Size; }
+
+		/** Blocking read of Size bytes at Offset, returns the number of bytes read which is less at the end of the file */
+		u64 Read(u64 Offset, u64 Size, void* pDestination) const;
+
+	private:
+		friend class FAsyncIO;
+
+#if defined(_WIN32)
+		HANDLE FileHandle = INVALID_HANDLE_VALUE;
+#else
+		int FileDescriptor = -1;
+#endif
+		u64 Size = 0;
+	};
+
+	/** Requests of a higher priority start first, requests of the same priority in the order they were issued */
+	enum class EIOPriority : u8
+	{
+		Low,
+		Normal,
+		High,
+		Critical,
+	};
+
+	enum class EIOStatus : u8
+	{
+		Pending,
+		InProgress,
+		Completed,      // BytesRead may be less than requested at the end of the file
+		Failed,
+		Cancelled,
+	};
+
+	struct FIOResult
+	{
+		EIOStatus Status = EIOStatus::Pending;
+		u64 BytesRead = 0;
+	};
+
+	struct FReadRequest
+	{
+		std::shared_ptr<FAsyncFile> File;
+		u64 Offset = 0;
+		u64 Size = 0;
+		void* pDestination = nullptr;   // Size bytes, must stay valid until the request is done
+		EIOPriority Priority = EIOPriority::Normal;
+
+		/**
+		 * Called once when the request is done, on the I/O thread or on the thread that cancels it. Keep it short, it holds up other
+		 * reads. The result is published first, so it may Wait on its own handle, but it must not call FAsyncIO::WaitIdle.
+		 */
+		std::function<void(const FIOResult&)> OnComplete;
+	};
+
+	enum class EIOBackend : u8
+	{
+		Auto,           // io_uring where the kernel allows it, else threads
+		Threads,        // Blocking positional reads on a pool of threads
+		IORing,         // Linux io_uring, one thread submits the reads and reaps their completions
+	};
+
+	struct FIORequestState;
+
+	/** Handle of an issued read, to wait for it, poll it or cancel it */
+	class FIORequestHandle
+	{
+	public:
+		FIORequestHandle() = default;
+
+		bool IsValid() const { return State != nullptr; }
+		bool IsDone() const;
+
+		/** Block until the request is done */
+		FIOResult Wait() const;
+
+		/** Result so far, Status is Pending or InProgress while the request isn't done */
+		FIOResult GetResult() const;
+
+	private:
+		friend class FAsyncIO;
+		std::shared_ptr<FIORequestState> State;
+	};
+
+	/**
+	 * Asynchronous reads with up to QueueDepth reads in flight at a time, which keeps the queue of an SSD busy. On Linux the reads go
+	 * through io_uring, so a single thread keeps the device busy. Elsewhere, or when the kernel refuses io_uring, QueueDepth I/O
+	 * threads each do blocking positional reads. Pending requests are ordered by priority and can be cancelled until they are
+	 * submitted.
+	 */
+	class FAsyncIO : public NonCopyable
+	{
+	public:
+		/** Threads mostly wait for the device, so their number is the queue depth rather than a share of the cores */
+		explicit FAsyncIO(u32 QueueDepth = 4, EIOBackend Backend = EIOBackend::Auto);
+
+		/** Cancels the pending requests and waits for the ones in progress */
+		~FAsyncIO();
+
+		FIORequestHandle Read(FReadRequest Request);
+
+		/** Issue NumRequests reads at once, with a single lock of the queue. pOutHandles is optional. */
+		void ReadBatch(FReadRequest* pRequests, u32 NumRequests, FIORequestHandle* pOutHandles = nullptr);
+
+		/** Cancel a request that hasn't started, returns false when it is already in progress or done */
+		bool Cancel(const FIORequestHandle& Handle);
+
+		/** Block until every request issued so far is done */
+		void WaitIdle();
+
+		u32 GetQueueDepth() const { return QueueDepth; }
+
+		/** Threads or IORing, the backend that is actually used */
+		EIOBackend GetBackend() const;
+
+	private:
+		struct FCompareRequests
+		{
+			bool operator()(const std::shared_ptr<FIORequestState>& A, const std::shared_ptr<FIORequestState>& B) const;
+		};
+
+		void WorkerMain();
+		void Complete(FIORequestState& State, EIOStatus Status, u64 BytesRead);
+
+		/** Pop the request with the highest priority, false when the queue only held cancelled ones. Mutex must be locked. */
+		bool PopRequest(std::shared_ptr<FIORequestState>& OutState);
+
+#if defined(__linux__)
+		struct FRingBackend;
+		void RingMain();
+		void WakeRing();
+
+		std::unique_ptr<FRingBackend> Ring;
+#endif
+
+		u32 QueueDepth = 0;
+		std::vector<std::thread> Threads;
+		std::mutex Mutex;
+		std::condition_variable WorkAvailable;
+		std::condition_variable Idle;
+		std::priority_queue<std::shared_ptr<FIORequestState>, std::vector<std::shared_ptr<FIORequestState>>, FCompareRequests> Queue;
+		u64 NextSequence = 0;
+		u32 NumInFlight = 0;        // Queued or in progress
+		bool bStopping = false;
+	};
+}
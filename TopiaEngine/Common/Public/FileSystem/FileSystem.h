@@ -1,5 +1,8 @@
 #pragma once
 
+#include <Topia.h>
+#include <Platforms.h>
+
 namespace topia
 {
 	class FileSystem
@@ -30,5 +33,6 @@ namespace topia
 		}
 	}
 
-	TOPIA_INLINE std::wstring GetAssetFullPath(LPCWSTR AssetName);
+	/** AssetName appended to the directory of the executable */
+	std::wstring GetAssetFullPath(LPCWSTR AssetName);
 }
\ No newline at end of file
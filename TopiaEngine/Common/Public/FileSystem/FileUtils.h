@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Topia.h>
+
+namespace topia
+{
+	/**
+	 * Write Size bytes to Path, replacing the file if it exists. The data goes to a temporary file next to Path that is renamed
+	 * over it when complete, so readers never see a partial file and concurrent writers of the same file don't mix their data.
+	 */
+	bool WriteFileAtomic(const std::wstring& Path, const void* pData, u64 Size);
+
+	struct FFileBlock
+	{
+		const void* pData = nullptr;
+		u64 Size = 0;
+	};
+
+	/** WriteFileAtomic of the concatenation of NumBlocks blocks, without copying them into one buffer first */
+	bool WriteFileAtomic(const std::wstring& Path, const FFileBlock* pBlocks, u32 NumBlocks);
+}
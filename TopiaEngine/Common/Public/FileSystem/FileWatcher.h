@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Topia.h>
+#include <Platforms.h>
+#include <Noncopyable.h>
+
+#include "Path.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace topia
+{
+	enum class EFileChangeType : u8
+	{
+		Added,
+		Modified,
+		Removed,
+		Overflow,       // Notifications were lost, any file may have changed
+	};
+
+	struct FFileChange
+	{
+		FPath Path;     // Relative to the watched directory, empty for Overflow
+		EFileChangeType Type = EFileChangeType::Modified;
+		std::chrono::steady_clock::time_point Time;     // First notification of the change
+	};
+
+	/**
+	 * Reports the files that change below a directory, with ReadDirectoryChangesW on Windows and inotify on Linux, on a thread of
+	 * its own. inotify doesn't watch subdirectories, so each one gets a watch of its own, and the files found in a new directory
+	 * are reported as added since they may have been written before its watch was in place. Saving a file often
+	 * takes several writes (truncate, write, set attributes), so a change is only reported once the file has had no notification
+	 * for the settle time, and once however many notifications came in.
+	 */
+	class FFileWatcher : public NonCopyable
+	{
+	public:
+		~FFileWatcher() { Stop(); }
+
+		/** Watch Directory and its subdirectories, returns false when it can't be opened */
+		bool Start(const std::wstring& Directory, u32 InSettleMilliseconds = 50);
+		void Stop();
+
+#if defined(_WIN32)
+		bool IsWatching() const { return DirectoryHandle != INVALID_HANDLE_VALUE; }
+#else
+		bool IsWatching() const { return NotifyDescriptor >= 0; }
+#endif
+
+		/** Append the changes that have settled, each file once */
+		void PollChanges(std::vector<FFileChange>& OutChanges);
+
+	private:
+		struct FPendingChange
+		{
+			EFileChangeType Type;
+			std::chrono::steady_clock::time_point FirstTime;
+			std::chrono::steady_clock::time_point LastTime;
+		};
+
+		void WatchThread();
+		void AddChange(FPath Path, EFileChangeType Type, std::chrono::steady_clock::time_point Time);
+
+#if defined(_WIN32)
+		HANDLE DirectoryHandle = INVALID_HANDLE_VALUE;
+		HANDLE StopEvent = nullptr;
+#else
+		void AddWatches(const std::string& RelativeDirectory, bool bReportFiles, std::chrono::steady_clock::time_point Time);
+		void RemoveWatches(const std::string& RelativeDirectory);
+
+		int NotifyDescriptor = -1;
+		int StopDescriptor = -1;
+		std::string RootDirectory;      // With a final slash
+		std::unordered_map<int, std::string> WatchedDirectories;       // Relative to the root with a final slash, empty for the root, by watch descriptor
+#endif
+		std::thread Thread;
+		u32 SettleMilliseconds = 50;
+
+		std::mutex Mutex;
+		std::unordered_map<FPath, FPendingChange> PendingChanges;
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Topia.h>
+#include <Platforms.h>
+#include <Noncopyable.h>
+
+namespace topia
+{
+	/** Read only view of a whole file mapped into the address space. Pages are loaded by the OS on first access, so only the parts that are read cost I/O. */
+	class FMappedFile : public NonCopyable
+	{
+	public:
+		FMappedFile() = default;
+		~FMappedFile() { Close(); }
+
+		/** Map the file at Path, returns false when the file can't be opened. An empty file opens successfully with a null data pointer. */
+		bool Open(const std::wstring& Path);
+		void Close();
+
+#if defined(_WIN32)
+		bool IsOpen() const { return FileHandle != INVALID_HANDLE_VALUE; }
+#else
+		bool IsOpen() const { return FileDescriptor >= 0; }
+#endif
+		const u8* GetData() const { return pData; }
+		u64 GetSize() const { return Size; }
+
+	private:
+#if defined(_WIN32)
+		HANDLE FileHandle = INVALID_HANDLE_VALUE;
+		HANDLE MappingHandle = nullptr;
+#else
+		int FileDescriptor = -1;
+#endif
+		const u8* pData = nullptr;
+		u64 Size = 0;
+	};
+}
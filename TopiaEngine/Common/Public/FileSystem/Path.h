@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Topia.h>
+#include <StringView.h>
+
+#include <functional>
+
+namespace topia
+{
+	/**
+	 * Lower case ASCII letters, forward slashes, no leading slash or "./". Writes at most Path.size() characters to pOut and returns
+	 * how many.
+	 */
+	size_t NormalizePath(FStringView Path, char* pOut);
+	std::string NormalizePath(FStringView Path);
+
+	/**
+	 * Interned asset path: a 32 bit index into a global table that stores every path once, normalized, with its Hash64. Copying,
+	 * comparing and hashing paths are integer operations, and the parts of a path are views into the table that never allocate.
+	 * Paths are UTF-8, relative to the mount points of the virtual file system. Interning takes a lock, reading an interned path
+	 * doesn't, paths are never removed from the table.
+	 */
+	class FPath
+	{
+	public:
+		/** The empty path */
+		FPath() = default;
+
+		/** Intern Path, normalized first */
+		explicit FPath(FStringView Path);
+
+		/** Path if it was interned before, otherwise the empty path, without adding it to the table */
+		static FPath Find(FStringView Path);
+
+		static u32 GetNumInternedPaths();
+
+		u32 GetId() const { return Id; }
+		bool IsEmpty() const { return Id == 0; }
+
+		/** Hash64 of the normalized path */
+		u64 GetHash() const;
+
+		/** The normalized path, the view stays valid until the process exits */
+		FStringView GetString() const;
+		std::string ToString() const { return std::string(GetString()); }
+
+		/** "dir/sub/" of "dir/sub/name.ext", with the final slash */
+		FStringView GetDirectory() const;
+
+		/** "name.ext" of "dir/sub/name.ext" */
+		FStringView GetFileName() const;
+
+		/** "ext" of "dir/sub/name.ext", without the dot */
+		FStringView GetExtension() const;
+
+		bool operator==(FPath Other) const { return Id == Other.Id; }
+		bool operator!=(FPath Other) const { return Id != Other.Id; }
+
+		/** Order of interning, not alphabetical */
+		bool operator<(FPath Other) const { return Id < Other.Id; }
+
+	private:
+		explicit FPath(u32 InId) : Id(InId) {}
+
+		u32 Id = 0;
+	};
+}
+
+namespace std
+{
+	template <>
+	struct hash<topia::FPath>
+	{
+		size_t operator()(topia::FPath Path) const { return size_t(Path.GetHash()); }
+	};
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Topia.h>
+#include <Noncopyable.h>
+
+#include "Archive.h"
+#include "Path.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace topia
+{
+	/**
+	 * Source of files for FVirtualFileSystem. Path is the full virtual path and RelativePath the part of it below the mount point,
+	 * they are the same for a mount point at the root. Mount points are read from any thread, the functions must be thread safe.
+	 */
+	class IMountPoint : public NonCopyable
+	{
+	public:
+		virtual ~IMountPoint() = default;
+
+		/** Returns false when the file doesn't exist */
+		virtual bool GetSize(FPath Path, FStringView RelativePath, u64& OutSize) const = 0;
+
+		/** Returns false when the file doesn't exist or can't be read */
+		virtual bool Read(FPath Path, FStringView RelativePath, std::vector<u8>& OutData) const = 0;
+	};
+
+	/** Files of a directory on disk. Paths are normalized to lower case, on case sensitive file systems the names must be lower case. */
+	class FLooseDirectoryMount : public IMountPoint
+	{
+	public:
+		/** Root is the directory the relative paths start from */
+		explicit FLooseDirectoryMount(const std::wstring& InRoot);
+
+		bool GetSize(FPath Path, FStringView RelativePath, u64& OutSize) const override;
+		bool Read(FPath Path, FStringView RelativePath, std::vector<u8>& OutData) const override;
+
+	private:
+		std::wstring GetFullPath(FStringView RelativePath) const;
+
+		std::wstring Root;
+	};
+
+	/** Files of an archive packed by TopiaPacker */
+	class FArchiveMount : public IMountPoint
+	{
+	public:
+		/** Check IsOpen, the mount has no files when the archive can't be opened */
+		explicit FArchiveMount(const std::wstring& ArchivePath);
+
+		bool IsOpen() const { return Archive.IsOpen(); }
+
+		bool GetSize(FPath Path, FStringView RelativePath, u64& OutSize) const override;
+		bool Read(FPath Path, FStringView RelativePath, std::vector<u8>& OutData) const override;
+
+	private:
+		u32 Find(FPath Path, FStringView RelativePath) const;
+
+		FArchive Archive;
+	};
+
+	/** Files kept in memory, for generated data and tests. Add the files before the mount is read from other threads. */
+	class FMemoryMount : public IMountPoint
+	{
+	public:
+		void AddFile(FStringView RelativePath, std::vector<u8>&& Data);
+
+		bool GetSize(FPath Path, FStringView RelativePath, u64& OutSize) const override;
+		bool Read(FPath Path, FStringView RelativePath, std::vector<u8>& OutData) const override;
+
+	private:
+		const std::vector<u8>* Find(FPath Path, FStringView RelativePath) const;
+
+		std::unordered_map<FPath, std::vector<u8>> Files;
+	};
+
+	/**
+	 * Single namespace over loose directories, archives and memory. Every mount point has a path prefix, a file is looked up in the
+	 * mount points whose prefix starts its path, the last mounted first, so later mounts override the files of earlier ones (a
+	 * directory of edited assets mounted after the shipped archive). Mount at startup, then any thread can read.
+	 */
+	class FVirtualFileSystem : public NonCopyable
+	{
+	public:
+		/** Prefix is a directory such as "shaders/", or empty for the root */
+		void Mount(FStringView Prefix, std::unique_ptr<IMountPoint> pMountPoint);
+		void UnmountAll();
+
+		bool Exists(FPath Path) const;
+
+		/** Returns false when no mount point has the file */
+		bool GetSize(FPath Path, u64& OutSize) const;
+
+		/** Returns false when no mount point has the file or it can't be read */
+		bool Read(FPath Path, std::vector<u8>& OutData) const;
+
+	private:
+		struct FMount
+		{
+			std::string Prefix;
+			std::unique_ptr<IMountPoint> pMountPoint;
+		};
+
+		/** Function(MountPoint, RelativePath) for the mounts that can have Path, last mounted first, until it returns true */
+		template <typename Func>
+		bool ForEachMount(FPath Path, const Func& Function) const;
+
+		std::vector<FMount> Mounts;
+	};
+}
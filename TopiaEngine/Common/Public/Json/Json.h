@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Topia.h>
+
+namespace topia
+{
+	enum class EJsonType : u8
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object,
+	};
+
+	class FJsonDocument;
+
+	/** Handle to a value of a FJsonDocument, an invalid handle is returned for members or elements that don't exist so lookups can be chained. */
+	class FJsonValue
+	{
+	public:
+		FJsonValue() = default;
+		FJsonValue(const FJsonDocument* InDocument, u32 InIndex, u32 InParentEnd) : pDocument(InDocument), Index(InIndex), ParentEnd(InParentEnd) {}
+
+		bool IsValid() const { return pDocument != nullptr; }
+		EJsonType GetType() const;
+		bool IsNull() const { return IsValid() && GetType() == EJsonType::Null; }
+		bool IsBool() const { return IsValid() && GetType() == EJsonType::Bool; }
+		bool IsNumber() const { return IsValid() && GetType() == EJsonType::Number; }
+		bool IsString() const { return IsValid() && GetType() == EJsonType::String; }
+		bool IsArray() const { return IsValid() && GetType() == EJsonType::Array; }
+		bool IsObject() const { return IsValid() && GetType() == EJsonType::Object; }
+
+		/** Member of an object, invalid when this is not an object or has no such member */
+		FJsonValue operator[](const char* Key) const;
+
+		/** Number of elements of an array or members of an object */
+		u32 Num() const;
+
+		/** First element / member, and the next element / member after this one. Invalid at the end. */
+		FJsonValue GetFirstChild() const;
+		FJsonValue GetNextSibling() const;
+
+		/** Key of an object member, escapes are not resolved */
+		const char* GetKey(u32& OutLength) const;
+
+		/** Value or Default when this is not of the right type */
+		bool GetBool(bool Default = false) const;
+		double GetNumber(double Default = 0.0) const;
+		float GetFloat(float Default = 0.0f) const { return float(GetNumber(Default)); }
+		u32 GetU32(u32 Default = 0) const;
+
+		/** Value or Default when this is not a number in [0, 2^64), for byte offsets and sizes */
+		u64 GetU64(u64 Default = 0) const;
+
+		/** String with escapes resolved (UTF-8), or Default when this is not a string */
+		std::string GetString(const std::string& Default = std::string()) const;
+
+		/** Compare a string without resolving escapes, faster than GetString for keyword checks */
+		bool EqualsString(const char* String) const;
+
+	private:
+		const FJsonDocument* pDocument = nullptr;
+		u32 Index = 0;
+		u32 ParentEnd = 0; // End of the parent's subtree, to know where the siblings stop
+	};
+
+	/**
+	 * Parsed JSON text. The values are stored as a flat array in document order: the children of a container follow it directly
+	 * and every value stores the index one past its last descendant, so walking the siblings skips whole subtrees.
+	 * Strings point into the source text, which must outlive the document.
+	 */
+	class FJsonDocument
+	{
+	public:
+		/** Parse Length bytes at pText (no terminator needed). Returns false and fills the error message on malformed input. */
+		bool Parse(const char* pText, size_t Length);
+
+		FJsonValue GetRoot() const { return Values.empty() ? FJsonValue() : FJsonValue(this, 0, u32(Values.size())); }
+		const std::string& GetError() const { return Error; }
+
+	private:
+		friend class FJsonValue;
+
+		struct FNode
+		{
+			EJsonType Type;
+			bool bBool;
+			u32 End;			// Index one past the last descendant
+			u32 NumChildren;
+			u32 KeyOffset;		// Offset of the member name in the source text when the parent is an object
+			u32 KeyLength;
+			u32 StringOffset;	// Offset of the string in the source text, escapes are not resolved
+			u32 StringLength;
+			double Number;
+		};
+
+		class FParser;
+
+		const char* pSource = nullptr;
+		std::vector<FNode> Values;
+		std::string Error;
+	};
+}
@@ -0,0 +1,429 @@
+#include <StaticMesh.h>
+#include <CookedMesh.h>
+
+#include "GLTFAsset.h"
+
+#include <DerivedData/DerivedDataCache.h>
+#include <FileSystem/FileUtils.h>
+#include <FileSystem/MappedFile.h>
+#include <Hash.h>
+
+#include <chrono>
+#include <cstring>
+
+namespace topia
+{
+    /** Bump when an import step changes its output, cached meshes are then built again */
+    static constexpr u32 STATIC_MESH_DERIVED_DATA_VERSION = 2;
+
+    /** Builds the image of a cooked file in memory, every block aligned to COOKED_MESH_ALIGNMENT */
+    class FCookedMeshWriter
+    {
+    public:
+        /** Zero filled space for Size bytes, returns its offset */
+        u64 Reserve(u64 Size)
+        {
+            const u64 Offset = (Data.size() + COOKED_MESH_ALIGNMENT - 1) & ~u64(COOKED_MESH_ALIGNMENT - 1);
+            Data.resize(size_t(Offset + Size), 0);
+            return Offset;
+        }
+
+        template <typename T>
+        FCookedRange Write(const T* pElements, u32 Count)
+        {
+            FCookedRange Range;
+            if (Count > 0)
+            {
+                Range.Offset = Reserve(u64(Count) * sizeof(T));
+                Range.Count = Count;
+                memcpy(&Data[size_t(Range.Offset)], pElements, size_t(Count) * sizeof(T));
+            }
+            return Range;
+        }
+
+        template <typename T>
+        FCookedRange Write(const TMeshStream<T>& Stream)
+        {
+            return Write(Stream.GetData(), Stream.Num());
+        }
+
+        template <typename T>
+        FCookedRange Write(const std::vector<T>& Elements)
+        {
+            return Write(Elements.data(), u32(Elements.size()));
+        }
+
+        std::vector<u8> Data;
+    };
+
+    void FStaticMesh::WriteCookedData(std::vector<u8>& OutData) const
+    {
+        FCookedMeshWriter Writer;
+        FCookedMeshHeader Header;
+        Writer.Reserve(sizeof(FCookedMeshHeader));
+
+        Header.NumSections = u32(Sections.size());
+        Header.SectionsOffset = Writer.Reserve(sizeof(FCookedSection) * Sections.size());
+        Header.NumLODs = u32(LODInfos.size());
+        Header.LODInfosOffset = Writer.Write(LODInfos).Offset;
+        Bounds.mMin.StoreFloat3(&Header.BoundsMin);
+        Bounds.mMax.StoreFloat3(&Header.BoundsMax);
+
+        for (size_t s = 0; s < Sections.size(); ++s)
+        {
+            const FStaticMeshSection& Section = Sections[s];
+            FCookedSection Cooked;
+            Cooked.NumVertices = Section.NumVertices;
+            Cooked.MaterialIndex = Section.MaterialIndex;
+
+            Cooked.Positions = Writer.Write(Section.Positions);
+            Cooked.Normals = Writer.Write(Section.Normals);
+            Cooked.Tangents = Writer.Write(Section.Tangents);
+            Cooked.TexCoords[0] = Writer.Write(Section.TexCoords[0]);
+            Cooked.TexCoords[1] = Writer.Write(Section.TexCoords[1]);
+            Cooked.Colors = Writer.Write(Section.Colors);
+
+            // LODs use the index size of the section
+            const bool b32BitIndices = !Section.Indices32.IsEmpty();
+            Cooked.IndexSize = b32BitIndices ? 4 : 2;
+            Cooked.Indices = b32BitIndices ? Writer.Write(Section.Indices32) : Writer.Write(Section.Indices16);
+            std::vector<FCookedRange> LODs;
+            for (const FStaticMeshLOD& LOD : Section.LODs)
+            {
+                LODs.push_back(b32BitIndices ? Writer.Write(LOD.Indices32) : Writer.Write(LOD.Indices16));
+            }
+            Cooked.NumLODs = u32(LODs.size());
+            Cooked.LODs = Writer.Write(LODs);
+
+            const FMeshletData& Meshlets = Section.Meshlets;
+            Cooked.Meshlets = Writer.Write(Meshlets.Meshlets);
+            Cooked.MeshletBounds = Writer.Write(Meshlets.Bounds);
+            Cooked.MeshletVertices = Writer.Write(Meshlets.Vertices);
+            Cooked.MeshletTriangles = Writer.Write(Meshlets.Triangles);
+
+            const FQuantizedVertexData& Quantized = Section.Quantized;
+            Cooked.bQuantized = Quantized.IsEmpty() ? 0 : 1;
+            Cooked.QuantizedPrecision = u32(Quantized.Precision);
+            Cooked.PositionQuantization = Quantized.PositionQuantization;
+            Cooked.QuantizedPositions = Writer.Write(Quantized.Positions);
+            Cooked.QuantizedNormals = Writer.Write(Quantized.Normals);
+            Cooked.QuantizedTangents = Writer.Write(Quantized.Tangents);
+            Cooked.QuantizedTexCoords[0] = Writer.Write(Quantized.TexCoords[0]);
+            Cooked.QuantizedTexCoords[1] = Writer.Write(Quantized.TexCoords[1]);
+            Cooked.QuantizedColors = Writer.Write(Quantized.Colors);
+
+            memcpy(&Writer.Data[size_t(Header.SectionsOffset + s * sizeof(FCookedSection))], &Cooked, sizeof(Cooked));
+        }
+
+        Header.FileSize = Writer.Data.size();
+        Header.ContentHash = Hash64(Writer.Data.data() + sizeof(Header), Writer.Data.size() - sizeof(Header));
+        memcpy(Writer.Data.data(), &Header, sizeof(Header));
+        OutData = std::move(Writer.Data);
+    }
+
+    bool FStaticMesh::SaveCooked(const std::wstring& Path) const
+    {
+        std::vector<u8> Data;
+        WriteCookedData(Data);
+        if (!WriteFileAtomic(Path, Data.data(), Data.size()))
+        {
+            DEBUGPRINT("SaveCooked: Can't write the file");
+            return false;
+        }
+        return true;
+    }
+
+    /** Cooked file in memory */
+    struct FCookedData
+    {
+        const u8* pData = nullptr;
+        u64 Size = 0;
+    };
+
+    /** Point Stream at Range, false when Range is not a whole number of elements inside the file at an aligned offset */
+    template <typename T>
+    static bool sSetView(const FCookedData& File, const FCookedRange& Range, TMeshStream<T>& OutStream)
+    {
+        if (Range.Count == 0)
+        {
+            OutStream.Reset();
+            return true;
+        }
+
+        const u64 Size = u64(Range.Count) * sizeof(T);
+        if (Range.Offset % COOKED_MESH_ALIGNMENT != 0 || Size > File.Size || Range.Offset > File.Size - Size)
+        {
+            return false;
+        }
+        OutStream.SetView(reinterpret_cast<const T*>(File.pData + Range.Offset), Range.Count);
+        return true;
+    }
+
+    /** Stream that must have Count elements or none */
+    template <typename T>
+    static bool sSetView(const FCookedData& File, const FCookedRange& Range, u32 Count, TMeshStream<T>& OutStream)
+    {
+        return (Range.Count == 0 || Range.Count == Count) && sSetView(File, Range, OutStream);
+    }
+
+    /** Every index references one of NumVertices vertices */
+    template <typename T>
+    static bool sIndicesInRange(const TMeshStream<T>& Indices, u32 NumVertices)
+    {
+        T MaxIndex = 0;
+        for (u32 i = 0; i < Indices.Num(); ++i)
+        {
+            MaxIndex = std::max(MaxIndex, Indices[i]);
+        }
+        return Indices.IsEmpty() || u32(MaxIndex) < NumVertices;
+    }
+
+    static bool sLoadIndices(const FCookedData& File, const FCookedRange& Range, u32 IndexSize, u32 NumVertices, TMeshStream<u16>& OutIndices16,
+        TMeshStream<u32>& OutIndices32)
+    {
+        if (Range.Count % 3 != 0)
+            return false;
+        if (IndexSize == 2)
+            return sSetView(File, Range, OutIndices16) && sIndicesInRange(OutIndices16, NumVertices);
+        return sSetView(File, Range, OutIndices32) && sIndicesInRange(OutIndices32, NumVertices);
+    }
+
+    /** Meshlets reference ranges of the vertex and triangle lists, which reference the section's vertices and the meshlet's own */
+    static bool sMeshletsInRange(const FMeshletData& Meshlets, u32 NumVertices)
+    {
+        if (!sIndicesInRange(Meshlets.Vertices, NumVertices))
+            return false;
+
+        for (u32 m = 0; m < Meshlets.Meshlets.Num(); ++m)
+        {
+            const FMeshlet& Meshlet = Meshlets.Meshlets[m];
+            if (u64(Meshlet.VertexOffset) + Meshlet.NumVertices > Meshlets.Vertices.Num()
+                || u64(Meshlet.TriangleOffset) + Meshlet.NumTriangles > Meshlets.Triangles.Num())
+            {
+                return false;
+            }
+            for (u32 t = 0; t < Meshlet.NumTriangles; ++t)
+            {
+                const u32 Triangle = Meshlets.Triangles[Meshlet.TriangleOffset + t];
+                if ((Triangle & 0xff) >= Meshlet.NumVertices || ((Triangle >> 8) & 0xff) >= Meshlet.NumVertices
+                    || ((Triangle >> 16) & 0xff) >= Meshlet.NumVertices)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static const char* sLoadSection(const FCookedData& File, const FCookedSection& Cooked, FStaticMeshSection& OutSection)
+    {
+        const u32 NumVertices = Cooked.NumVertices;
+        OutSection.NumVertices = NumVertices;
+        OutSection.MaterialIndex = Cooked.MaterialIndex;
+
+        if (Cooked.Positions.Count != NumVertices || !sSetView(File, Cooked.Positions, OutSection.Positions)
+            || !sSetView(File, Cooked.Normals, NumVertices, OutSection.Normals)
+            || !sSetView(File, Cooked.Tangents, NumVertices, OutSection.Tangents)
+            || !sSetView(File, Cooked.TexCoords[0], NumVertices, OutSection.TexCoords[0])
+            || !sSetView(File, Cooked.TexCoords[1], NumVertices, OutSection.TexCoords[1])
+            || !sSetView(File, Cooked.Colors, NumVertices, OutSection.Colors))
+        {
+            return "Bad vertex stream";
+        }
+
+        if ((Cooked.IndexSize != 2 && Cooked.IndexSize != 4) || (Cooked.IndexSize == 2 && NumVertices > 0x10000)
+            || !sLoadIndices(File, Cooked.Indices, Cooked.IndexSize, NumVertices, OutSection.Indices16, OutSection.Indices32))
+        {
+            return "Bad index stream";
+        }
+
+        TMeshStream<FCookedRange> LODs;
+        if (Cooked.LODs.Count != Cooked.NumLODs || !sSetView(File, Cooked.LODs, LODs))
+        {
+            return "Bad LOD table";
+        }
+        OutSection.LODs.resize(Cooked.NumLODs);
+        for (u32 Level = 0; Level < Cooked.NumLODs; ++Level)
+        {
+            FStaticMeshLOD& LOD = OutSection.LODs[Level];
+            if (!sLoadIndices(File, LODs[Level], Cooked.IndexSize, NumVertices, LOD.Indices16, LOD.Indices32))
+            {
+                return "Bad LOD index stream";
+            }
+        }
+
+        FMeshletData& Meshlets = OutSection.Meshlets;
+        if (!sSetView(File, Cooked.Meshlets, Meshlets.Meshlets) || !sSetView(File, Cooked.MeshletBounds, Cooked.Meshlets.Count, Meshlets.Bounds)
+            || Meshlets.Bounds.Num() != Meshlets.Meshlets.Num() || !sSetView(File, Cooked.MeshletVertices, Meshlets.Vertices)
+            || !sSetView(File, Cooked.MeshletTriangles, Meshlets.Triangles) || !sMeshletsInRange(Meshlets, NumVertices))
+        {
+            return "Bad meshlets";
+        }
+
+        if (Cooked.bQuantized)
+        {
+            FQuantizedVertexData& Quantized = OutSection.Quantized;
+            if (Cooked.QuantizedPrecision > u32(EOctahedralPrecision::Bits16))
+            {
+                return "Bad quantization precision";
+            }
+            Quantized.Precision = EOctahedralPrecision(Cooked.QuantizedPrecision);
+            Quantized.PositionQuantization = Cooked.PositionQuantization;
+
+            if (Cooked.QuantizedPositions.Count != NumVertices || !sSetView(File, Cooked.QuantizedPositions, Quantized.Positions)
+                || !sSetView(File, Cooked.QuantizedNormals, NumVertices * GetOctahedralNormalSize(Quantized.Precision), Quantized.Normals)
+                || !sSetView(File, Cooked.QuantizedTangents, NumVertices * GetOctahedralTangentSize(Quantized.Precision), Quantized.Tangents)
+                || !sSetView(File, Cooked.QuantizedTexCoords[0], NumVertices * 2, Quantized.TexCoords[0])
+                || !sSetView(File, Cooked.QuantizedTexCoords[1], NumVertices * 2, Quantized.TexCoords[1])
+                || !sSetView(File, Cooked.QuantizedColors, NumVertices, Quantized.Colors))
+            {
+                return "Bad quantized stream";
+            }
+        }
+        return nullptr;
+    }
+
+    bool FStaticMesh::LoadCooked(const std::wstring& Path, bool bVerifyHash)
+    {
+        std::shared_ptr<FMappedFile> File = std::make_shared<FMappedFile>();
+        if (!File->Open(Path))
+        {
+            Reset();
+            DEBUGPRINT("LoadCooked: Can't open file");
+            return false;
+        }
+        return LoadCookedData(File, File->GetData(), File->GetSize(), bVerifyHash);
+    }
+
+    bool FStaticMesh::LoadCookedData(const std::shared_ptr<const void>& Owner, const u8* pData, u64 Size, bool bVerifyHash)
+    {
+        Reset();
+
+        auto Fail = [this](const char* pError)
+        {
+            DEBUGPRINT("LoadCooked: %s", pError);
+            Reset();
+            return false;
+        };
+
+        SourceData.push_back(Owner);
+        FCookedData File;
+        File.pData = pData;
+        File.Size = Size;
+
+        FCookedMeshHeader Header;
+        if (Size < sizeof(Header))
+        {
+            return Fail("Not a cooked mesh");
+        }
+        memcpy(&Header, pData, sizeof(Header));
+        if (Header.Magic != COOKED_MESH_MAGIC)
+        {
+            return Fail("Not a cooked mesh");
+        }
+        if (Header.Version != COOKED_MESH_VERSION)
+        {
+            return Fail("Unsupported version, cook the mesh again");
+        }
+        if (Header.FileSize != Size)
+        {
+            return Fail("Truncated file");
+        }
+        if (bVerifyHash && Hash64(pData + sizeof(Header), size_t(Size - sizeof(Header))) != Header.ContentHash)
+        {
+            return Fail("Content hash mismatch");
+        }
+
+        FCookedRange SectionTable;
+        SectionTable.Offset = Header.SectionsOffset;
+        SectionTable.Count = Header.NumSections;
+        TMeshStream<FCookedSection> CookedSections;
+        FCookedRange LODInfoTable;
+        LODInfoTable.Offset = Header.LODInfosOffset;
+        LODInfoTable.Count = Header.NumLODs;
+        TMeshStream<FStaticMeshLODInfo> CookedLODInfos;
+        if (!sSetView(File, SectionTable, CookedSections) || !sSetView(File, LODInfoTable, CookedLODInfos))
+        {
+            return Fail("Bad header");
+        }
+
+        Sections.resize(Header.NumSections);
+        for (u32 s = 0; s < Header.NumSections; ++s)
+        {
+            // Every section has the LODs of the LOD table except LOD 0, SelectLOD results index them
+            if (CookedSections[s].NumLODs != std::max(Header.NumLODs, 1u) - 1)
+            {
+                return Fail("Bad LOD table");
+            }
+            if (const char* pError = sLoadSection(File, CookedSections[s], Sections[s]))
+            {
+                return Fail(pError);
+            }
+        }
+
+        LODInfos.assign(CookedLODInfos.GetData(), CookedLODInfos.GetData() + CookedLODInfos.Num());
+        Bounds = AABox(Vec3(Header.BoundsMin), Vec3(Header.BoundsMax));
+        return true;
+    }
+
+    bool FStaticMesh::Build(const std::wstring& SourcePath, const FStaticMeshBuildSettings& Settings, FDerivedDataCache* pCache, FThreadPool* pPool)
+    {
+        Reset();
+        const auto Start = std::chrono::steady_clock::now();
+
+        FGLTFAsset Asset;
+        if (!Asset.Load(SourcePath))
+        {
+            DEBUGPRINT("Build: %s", Asset.Error.c_str());
+            return false;
+        }
+
+        // The cooked format is part of the result, so its version is part of the key
+        FDerivedDataKey Key("StaticMesh", STATIC_MESH_DERIVED_DATA_VERSION * 0x10000 + COOKED_MESH_VERSION);
+        if (pCache != nullptr)
+        {
+            Key.AddValue(Asset.ComputeContentHash()).AddValue(u32(Settings.RequiredAttributes)).AddValue(Settings.bGenerateTangents)
+                .AddValue(Settings.bOptimize).AddValue(Settings.OverdrawThreshold).AddValue(Settings.bBuildMeshlets).AddValue(Settings.bQuantize)
+                .AddValue(Settings.Precision).AddValue(Settings.LODs.NumLODs).AddValue(Settings.LODs.TriangleRatio).AddValue(Settings.LODs.MaxError);
+
+            FDerivedData Cached;
+            if (pCache->Get(Key, Cached) && LoadCookedData(Cached.File, Cached.pData, Cached.Size, false))
+            {
+                return true;
+            }
+        }
+
+        if (!LoadFromGLTFAsset(Asset, Settings.RequiredAttributes))
+        {
+            return false;
+        }
+        if (Settings.bGenerateTangents)
+        {
+            GenerateTangents(pPool);
+        }
+        if (Settings.bOptimize)
+        {
+            Optimize(Settings.OverdrawThreshold);
+        }
+        if (Settings.bBuildMeshlets)
+        {
+            BuildMeshlets(pPool);
+        }
+        if (Settings.bQuantize)
+        {
+            Quantize(Settings.Precision);
+        }
+        if (Settings.LODs.NumLODs > 1)
+        {
+            GenerateLODs(Settings.LODs);
+        }
+
+        if (pCache != nullptr)
+        {
+            std::vector<u8> Data;
+            WriteCookedData(Data);
+            pCache->Put(Key, Data.data(), Data.size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+        }
+        return true;
+    }
+}
@@ -0,0 +1,523 @@
+#include "GLTFAsset.h"
+
+#include <FileSystem/MappedFile.h>
+#include <Hash.h>
+#include <Json/Json.h>
+
+namespace topia
+{
+    static constexpr u32 GLB_MAGIC = 0x46546c67;        // "glTF"
+    static constexpr u32 GLB_CHUNK_JSON = 0x4e4f534a;   // "JSON"
+    static constexpr u32 GLB_CHUNK_BIN = 0x004e4942;    // "BIN\0"
+
+    static u32 sReadU32(const u8* pData)
+    {
+        u32 Value;
+        memcpy(&Value, pData, sizeof(Value));
+        return Value;
+    }
+
+    /** Offset + Length <= Size without the addition, which wraps around for hostile offsets close to 2^64 */
+    static bool sIsRangeInside(u64 Offset, u64 Length, u64 Size)
+    {
+        return Offset <= Size && Length <= Size - Offset;
+    }
+
+    /** Optional byteOffset: 0 when absent, an offset that never fits when it is not a valid integer */
+    static u64 sGetByteOffset(const FJsonValue& Value)
+    {
+        return Value.IsValid() ? Value.GetU64(~u64(0)) : 0;
+    }
+
+    static bool sDecodeBase64(const char* pText, size_t Length, std::vector<u8>& OutData)
+    {
+        static const auto sDecodeChar = [](char c) -> int
+        {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+' || c == '-') return 62;
+            if (c == '/' || c == '_') return 63;
+            return -1;
+        };
+
+        OutData.clear();
+        OutData.reserve(Length / 4 * 3);
+
+        u32 Bits = 0;
+        u32 NumBits = 0;
+        for (size_t i = 0; i < Length && pText[i] != '='; ++i)
+        {
+            const int Value = sDecodeChar(pText[i]);
+            if (Value < 0)
+            {
+                return false;
+            }
+
+            Bits = (Bits << 6) | u32(Value);
+            NumBits += 6;
+            if (NumBits >= 8)
+            {
+                NumBits -= 8;
+                OutData.push_back(u8(Bits >> NumBits));
+            }
+        }
+        return true;
+    }
+
+    /** Resolve %XX escapes of a relative URI */
+    static std::string sDecodeURI(const std::string& URI)
+    {
+        std::string Result;
+        Result.reserve(URI.size());
+        for (size_t i = 0; i < URI.size(); ++i)
+        {
+            if (URI[i] == '%' && i + 2 < URI.size() && isxdigit(u8(URI[i + 1])) && isxdigit(u8(URI[i + 2])))
+            {
+                const char Hex[3] = { URI[i + 1], URI[i + 2], '\0' };
+                Result += char(strtol(Hex, nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                Result += URI[i];
+            }
+        }
+        return Result;
+    }
+
+    static u32 sGetNumComponents(const FJsonValue& Type)
+    {
+        static const struct { const char* pName; u32 NumComponents; } sTypes[] =
+        {
+            { "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 }, { "MAT2", 4 }, { "MAT3", 9 }, { "MAT4", 16 },
+        };
+
+        for (const auto& Entry : sTypes)
+        {
+            if (Type.EqualsString(Entry.pName))
+            {
+                return Entry.NumComponents;
+            }
+        }
+        return 0;
+    }
+
+    u32 FGLTFAsset::GetComponentSize(u32 ComponentType)
+    {
+        switch (ComponentType)
+        {
+        case Byte:
+        case UnsignedByte:
+            return 1;
+        case Short:
+        case UnsignedShort:
+            return 2;
+        case UnsignedInt:
+        case Float:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    bool FGLTFAsset::Fail(const std::string& Message)
+    {
+        if (Error.empty())
+        {
+            Error = Message;
+        }
+        return false;
+    }
+
+    bool FGLTFAsset::Load(const std::wstring& Path)
+    {
+        BufferViews.clear();
+        Accessors.clear();
+        Primitives.clear();
+        SourceData.clear();
+        Buffers.clear();
+        Error.clear();
+        pDocument = nullptr;
+        DocumentLength = 0;
+
+        std::shared_ptr<FMappedFile> File = std::make_shared<FMappedFile>();
+        if (!File->Open(Path))
+        {
+            return Fail("Can't open file");
+        }
+        SourceData.push_back(File);
+
+        const u8* pData = File->GetData();
+        const u64 Size = File->GetSize();
+
+        if (Size >= 12 && sReadU32(pData) == GLB_MAGIC)
+        {
+            // Binary container: 12 byte header, then a JSON chunk and an optional BIN chunk, both 4 byte aligned
+            if (sReadU32(pData + 4) != 2)
+            {
+                return Fail("Unsupported glb version");
+            }
+
+            const u64 Length = std::min<u64>(sReadU32(pData + 8), Size);
+            if (Length < 20 || sReadU32(pData + 16) != GLB_CHUNK_JSON)
+            {
+                return Fail("glb file doesn't start with a JSON chunk");
+            }
+
+            const u64 JsonLength = sReadU32(pData + 12);
+            if (20 + JsonLength > Length)
+            {
+                return Fail("glb JSON chunk is truncated");
+            }
+
+            FBuffer BinChunk;
+            const u64 BinHeader = (20 + JsonLength + 3) & ~u64(3);
+            if (BinHeader + 8 <= Length && sReadU32(pData + BinHeader + 4) == GLB_CHUNK_BIN)
+            {
+                BinChunk.pData = pData + BinHeader + 8;
+                BinChunk.Size = sReadU32(pData + BinHeader);
+                if (BinHeader + 8 + BinChunk.Size > Length)
+                {
+                    return Fail("glb BIN chunk is truncated");
+                }
+            }
+
+            return ParseDocument(reinterpret_cast<const char*>(pData + 20), size_t(JsonLength), BinChunk, GetBasePath(Path));
+        }
+
+        // Text file, skip a UTF-8 byte order mark
+        size_t Offset = 0;
+        if (Size >= 3 && pData[0] == 0xef && pData[1] == 0xbb && pData[2] == 0xbf)
+        {
+            Offset = 3;
+        }
+        return ParseDocument(reinterpret_cast<const char*>(pData + Offset), size_t(Size - Offset), FBuffer(), GetBasePath(Path));
+    }
+
+    bool FGLTFAsset::ParseDocument(const char* pJson, size_t JsonLength, const FBuffer& BinChunk, const std::wstring& BasePath)
+    {
+        pDocument = pJson;
+        DocumentLength = JsonLength;
+
+        FJsonDocument Document;
+        if (!Document.Parse(pJson, JsonLength))
+        {
+            return Fail("Invalid JSON: " + Document.GetError());
+        }
+
+        const FJsonValue Root = Document.GetRoot();
+        const std::string Version = Root["asset"]["version"].GetString();
+        if (Version.empty() || Version[0] != '2')
+        {
+            return Fail("Not a glTF 2.0 file");
+        }
+
+        // Extensions that change how geometry is stored are not supported. KHR_mesh_quantization needs nothing special, all component types are decoded.
+        for (FJsonValue Extension = Root["extensionsRequired"].GetFirstChild(); Extension.IsValid(); Extension = Extension.GetNextSibling())
+        {
+            if (Extension.EqualsString("KHR_draco_mesh_compression") || Extension.EqualsString("EXT_meshopt_compression"))
+            {
+                return Fail("Unsupported required extension " + Extension.GetString());
+            }
+        }
+
+        // Buffers
+        for (FJsonValue Value = Root["buffers"].GetFirstChild(); Value.IsValid(); Value = Value.GetNextSibling())
+        {
+            FBuffer Buffer;
+            const u64 ByteLength = Value["byteLength"].GetU64(~u64(0));
+            const FJsonValue URIValue = Value["uri"];
+            if (!URIValue.IsValid())
+            {
+                // The first buffer of a glb file without a URI is the BIN chunk
+                if (!Buffers.empty() || BinChunk.pData == nullptr)
+                {
+                    return Fail("Buffer without URI");
+                }
+                Buffer = BinChunk;
+            }
+            else
+            {
+                const std::string URI = URIValue.GetString();
+                if (URI.compare(0, 5, "data:") == 0)
+                {
+                    const size_t DataStart = URI.find(";base64,");
+                    std::shared_ptr<std::vector<u8>> Data = std::make_shared<std::vector<u8>>();
+                    if (DataStart == std::string::npos || !sDecodeBase64(URI.data() + DataStart + 8, URI.size() - DataStart - 8, *Data))
+                    {
+                        return Fail("Invalid data URI");
+                    }
+                    Buffer.pData = Data->data();
+                    Buffer.Size = Data->size();
+                    SourceData.push_back(Data);
+                }
+                else
+                {
+                    std::shared_ptr<FMappedFile> File = std::make_shared<FMappedFile>();
+                    if (!File->Open(BasePath + UTF8ToWide(sDecodeURI(URI))))
+                    {
+                        return Fail("Can't open buffer " + URI);
+                    }
+                    Buffer.pData = File->GetData();
+                    Buffer.Size = File->GetSize();
+                    SourceData.push_back(File);
+                }
+            }
+
+            if (Buffer.Size < ByteLength)
+            {
+                return Fail("Buffer is smaller than its byteLength");
+            }
+            Buffer.Size = ByteLength;
+            Buffers.push_back(Buffer);
+        }
+
+        // Buffer views
+        for (FJsonValue Value = Root["bufferViews"].GetFirstChild(); Value.IsValid(); Value = Value.GetNextSibling())
+        {
+            FBufferView View;
+            View.Buffer = Value["buffer"].GetU32(INVALID_INDEX);
+            View.ByteOffset = sGetByteOffset(Value["byteOffset"]);
+            View.ByteLength = Value["byteLength"].GetU64(~u64(0));
+            View.ByteStride = Value["byteStride"].GetU32();
+            if (View.Buffer >= Buffers.size() || !sIsRangeInside(View.ByteOffset, View.ByteLength, Buffers[View.Buffer].Size))
+            {
+                return Fail("Buffer view out of range");
+            }
+            if (View.ByteStride != 0 && (View.ByteStride < 4 || View.ByteStride > 252))
+            {
+                return Fail("Invalid byteStride");
+            }
+            BufferViews.push_back(View);
+        }
+
+        // Accessors
+        for (FJsonValue Value = Root["accessors"].GetFirstChild(); Value.IsValid(); Value = Value.GetNextSibling())
+        {
+            FAccessor Accessor;
+            Accessor.BufferView = Value["bufferView"].GetU32(INVALID_INDEX);
+            Accessor.ByteOffset = sGetByteOffset(Value["byteOffset"]);
+            Accessor.ComponentType = Value["componentType"].GetU32();
+            Accessor.NumComponents = sGetNumComponents(Value["type"]);
+            Accessor.Count = Value["count"].GetU32();
+            Accessor.bNormalized = Value["normalized"].GetBool();
+
+            const FJsonValue Sparse = Value["sparse"];
+            if (Sparse.IsValid())
+            {
+                const FJsonValue Indices = Sparse["indices"];
+                const FJsonValue Values = Sparse["values"];
+                Accessor.SparseCount = Sparse["count"].GetU32();
+                Accessor.SparseIndicesView = Indices["bufferView"].GetU32(INVALID_INDEX);
+                Accessor.SparseIndicesOffset = sGetByteOffset(Indices["byteOffset"]);
+                Accessor.SparseIndicesComponentType = Indices["componentType"].GetU32();
+                Accessor.SparseValuesView = Values["bufferView"].GetU32(INVALID_INDEX);
+                Accessor.SparseValuesOffset = sGetByteOffset(Values["byteOffset"]);
+            }
+
+            if (!ValidateAccessor(Accessor))
+            {
+                return false;
+            }
+            Accessors.push_back(Accessor);
+        }
+
+        // Meshes
+        static const char* sAttributeNames[NumAttributes] = { "POSITION", "NORMAL", "TANGENT", "TEXCOORD_0", "TEXCOORD_1", "COLOR_0" };
+        for (FJsonValue Mesh = Root["meshes"].GetFirstChild(); Mesh.IsValid(); Mesh = Mesh.GetNextSibling())
+        {
+            for (FJsonValue Value = Mesh["primitives"].GetFirstChild(); Value.IsValid(); Value = Value.GetNextSibling())
+            {
+                FPrimitive Primitive;
+                const FJsonValue Attributes = Value["attributes"];
+                for (u32 i = 0; i < NumAttributes; ++i)
+                {
+                    Primitive.Attributes[i] = Attributes[sAttributeNames[i]].GetU32(INVALID_INDEX);
+                    if (Primitive.Attributes[i] != INVALID_INDEX && Primitive.Attributes[i] >= Accessors.size())
+                    {
+                        return Fail("Attribute accessor out of range");
+                    }
+                }
+
+                Primitive.Indices = Value["indices"].GetU32(INVALID_INDEX);
+                Primitive.Material = Value["material"].GetU32(INVALID_INDEX);
+                Primitive.Mode = Value["mode"].GetU32(MODE_TRIANGLES);
+                if (Primitive.Indices != INVALID_INDEX && Primitive.Indices >= Accessors.size())
+                {
+                    return Fail("Index accessor out of range");
+                }
+                Primitives.push_back(Primitive);
+            }
+        }
+
+        return true;
+    }
+
+    bool FGLTFAsset::ValidateAccessor(const FAccessor& Accessor)
+    {
+        const u32 ComponentSize = GetComponentSize(Accessor.ComponentType);
+        if (ComponentSize == 0 || Accessor.NumComponents == 0)
+        {
+            return Fail("Invalid accessor type");
+        }
+
+        const u64 ElementSize = Accessor.GetElementSize();
+        if (Accessor.BufferView != INVALID_INDEX && Accessor.Count > 0)
+        {
+            if (Accessor.BufferView >= BufferViews.size())
+            {
+                return Fail("Accessor buffer view out of range");
+            }
+
+            // Count < 2^32 and Stride, ElementSize <= 255, so the span can't overflow
+            const FBufferView& View = BufferViews[Accessor.BufferView];
+            const u64 Stride = View.ByteStride != 0 ? View.ByteStride : ElementSize;
+            if (!sIsRangeInside(Accessor.ByteOffset, u64(Accessor.Count - 1) * Stride + ElementSize, View.ByteLength))
+            {
+                return Fail("Accessor out of range of its buffer view");
+            }
+        }
+
+        if (Accessor.SparseCount > 0)
+        {
+            const u32 IndexType = Accessor.SparseIndicesComponentType;
+            const u64 IndexSize = GetComponentSize(IndexType);
+            if (Accessor.SparseCount > Accessor.Count
+                || (IndexType != UnsignedByte && IndexType != UnsignedShort && IndexType != UnsignedInt)
+                || Accessor.SparseIndicesView >= BufferViews.size() || Accessor.SparseValuesView >= BufferViews.size()
+                || !sIsRangeInside(Accessor.SparseIndicesOffset, Accessor.SparseCount * IndexSize, BufferViews[Accessor.SparseIndicesView].ByteLength)
+                || !sIsRangeInside(Accessor.SparseValuesOffset, Accessor.SparseCount * ElementSize, BufferViews[Accessor.SparseValuesView].ByteLength))
+            {
+                return Fail("Invalid sparse accessor");
+            }
+        }
+
+        return true;
+    }
+
+    const u8* FGLTFAsset::GetBufferViewData(u32 View, u64 ByteOffset) const
+    {
+        const FBufferView& BufferView = BufferViews[View];
+        return Buffers[BufferView.Buffer].pData + BufferView.ByteOffset + ByteOffset;
+    }
+
+    u64 FGLTFAsset::ComputeContentHash() const
+    {
+        u64 Hash = Hash64(pDocument, DocumentLength);
+        for (const FBuffer& Buffer : Buffers)
+        {
+            Hash = Hash64(Buffer.pData, size_t(Buffer.Size), Hash);
+        }
+        return Hash;
+    }
+
+    const u8* FGLTFAsset::GetAccessorData(const FAccessor& Accessor, u32& OutStride) const
+    {
+        if (Accessor.BufferView == INVALID_INDEX)
+        {
+            OutStride = 0;
+            return nullptr;
+        }
+
+        const u32 ByteStride = BufferViews[Accessor.BufferView].ByteStride;
+        OutStride = ByteStride != 0 ? ByteStride : Accessor.GetElementSize();
+        return GetBufferViewData(Accessor.BufferView, Accessor.ByteOffset);
+    }
+
+    /** Decode Count elements of NumComponents components of type T, the remaining output components are taken from Fill */
+    template <typename T>
+    static void sDecodeElements(const u8* pData, u32 Stride, u32 Count, u32 NumComponents, bool bNormalized, u32 NumComponentsOut, const float* Fill, float* pOut)
+    {
+        // Normalized integers as defined by the glTF specification: unsigned c / max, signed max(c / max, -1)
+        const bool bScale = bNormalized && !std::is_floating_point<T>::value;
+        const float Scale = bScale ? 1.0f / float(std::numeric_limits<T>::max()) : 1.0f;
+        const float Min = bScale && std::is_signed<T>::value ? -1.0f : -std::numeric_limits<float>::max();
+        const u32 NumCopied = std::min(NumComponents, NumComponentsOut);
+
+        for (u32 i = 0; i < Count; ++i, pData += Stride, pOut += NumComponentsOut)
+        {
+            T Components[16];
+            memcpy(Components, pData, NumCopied * sizeof(T));
+            for (u32 c = 0; c < NumCopied; ++c)
+            {
+                pOut[c] = std::max(float(Components[c]) * Scale, Min);
+            }
+            for (u32 c = NumCopied; c < NumComponentsOut; ++c)
+            {
+                pOut[c] = Fill[c];
+            }
+        }
+    }
+
+    static void sDecode(u32 ComponentType, const u8* pData, u32 Stride, u32 Count, u32 NumComponents, bool bNormalized, u32 NumComponentsOut, const float* Fill, float* pOut)
+    {
+        switch (ComponentType)
+        {
+        case FGLTFAsset::Byte:          sDecodeElements<s8>(pData, Stride, Count, NumComponents, bNormalized, NumComponentsOut, Fill, pOut); break;
+        case FGLTFAsset::UnsignedByte:  sDecodeElements<u8>(pData, Stride, Count, NumComponents, bNormalized, NumComponentsOut, Fill, pOut); break;
+        case FGLTFAsset::Short:         sDecodeElements<s16>(pData, Stride, Count, NumComponents, bNormalized, NumComponentsOut, Fill, pOut); break;
+        case FGLTFAsset::UnsignedShort: sDecodeElements<u16>(pData, Stride, Count, NumComponents, bNormalized, NumComponentsOut, Fill, pOut); break;
+        case FGLTFAsset::UnsignedInt:   sDecodeElements<u32>(pData, Stride, Count, NumComponents, bNormalized, NumComponentsOut, Fill, pOut); break;
+        case FGLTFAsset::Float:         sDecodeElements<float>(pData, Stride, Count, NumComponents, false, NumComponentsOut, Fill, pOut); break;
+        default:                        ASSERT(false); break;
+        }
+    }
+
+    static u32 sReadIndex(const u8* pData, u32 ComponentType)
+    {
+        switch (ComponentType)
+        {
+        case FGLTFAsset::UnsignedByte:
+            return *pData;
+        case FGLTFAsset::UnsignedShort:
+        {
+            u16 Index;
+            memcpy(&Index, pData, sizeof(Index));
+            return Index;
+        }
+        default:
+            return sReadU32(pData);
+        }
+    }
+
+    void FGLTFAsset::ReadFloats(const FAccessor& Accessor, u32 NumComponentsOut, const float* Fill, float* pOut) const
+    {
+        ASSERT(NumComponentsOut <= 16);
+
+        u32 Stride;
+        const u8* pData = GetAccessorData(Accessor, Stride);
+        if (pData != nullptr)
+        {
+            sDecode(Accessor.ComponentType, pData, Stride, Accessor.Count, Accessor.NumComponents, Accessor.bNormalized, NumComponentsOut, Fill, pOut);
+        }
+        else
+        {
+            // No buffer view, the elements are zero
+            const u32 NumCopied = std::min(Accessor.NumComponents, NumComponentsOut);
+            for (u32 i = 0; i < Accessor.Count; ++i)
+            {
+                for (u32 c = 0; c < NumComponentsOut; ++c)
+                {
+                    pOut[size_t(i) * NumComponentsOut + c] = c < NumCopied ? 0.0f : Fill[c];
+                }
+            }
+        }
+
+        if (Accessor.SparseCount > 0)
+        {
+            const u32 IndexSize = GetComponentSize(Accessor.SparseIndicesComponentType);
+            const u32 ElementSize = Accessor.GetElementSize();
+            const u8* pIndices = GetBufferViewData(Accessor.SparseIndicesView, Accessor.SparseIndicesOffset);
+            const u8* pValues = GetBufferViewData(Accessor.SparseValuesView, Accessor.SparseValuesOffset);
+            for (u32 i = 0; i < Accessor.SparseCount; ++i)
+            {
+                const u32 Index = sReadIndex(pIndices + size_t(i) * IndexSize, Accessor.SparseIndicesComponentType);
+                if (Index < Accessor.Count)
+                {
+                    sDecode(Accessor.ComponentType, pValues + size_t(i) * ElementSize, ElementSize, 1, Accessor.NumComponents, Accessor.bNormalized, NumComponentsOut, Fill, pOut + size_t(Index) * NumComponentsOut);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <Topia.h>
+
+#include <memory>
+
+namespace topia
+{
+    /** Minimal glTF 2.0 reader: the parts of the document a mesh loader needs, with the buffers memory mapped. */
+    class FGLTFAsset
+    {
+    public:
+        static constexpr u32 INVALID_INDEX = ~0u;
+
+        enum EComponentType : u32
+        {
+            Byte          = 5120,
+            UnsignedByte  = 5121,
+            Short         = 5122,
+            UnsignedShort = 5123,
+            UnsignedInt   = 5125,
+            Float         = 5126,
+        };
+
+        /** Primitive topology, only triangle lists are loaded */
+        static constexpr u32 MODE_TRIANGLES = 4;
+
+        struct FBuffer
+        {
+            const u8* pData = nullptr;
+            u64 Size = 0;
+        };
+
+        struct FBufferView
+        {
+            u32 Buffer = INVALID_INDEX;
+            u64 ByteOffset = 0;
+            u64 ByteLength = 0;
+            u32 ByteStride = 0;     // 0 means tightly packed
+        };
+
+        struct FAccessor
+        {
+            u32 BufferView = INVALID_INDEX;  // No buffer view means all zeros (before sparse substitution)
+            u64 ByteOffset = 0;
+            u32 ComponentType = Float;
+            u32 NumComponents = 1;
+            u32 Count = 0;
+            bool bNormalized = false;
+
+            /** Sparse substitution, SparseCount elements at the indices in the first view are replaced with the values in the second */
+            u32 SparseCount = 0;
+            u32 SparseIndicesView = INVALID_INDEX;
+            u64 SparseIndicesOffset = 0;
+            u32 SparseIndicesComponentType = UnsignedInt;
+            u32 SparseValuesView = INVALID_INDEX;
+            u64 SparseValuesOffset = 0;
+
+            u32 GetElementSize() const { return NumComponents * GetComponentSize(ComponentType); }
+        };
+
+        /** Attributes that the loader knows, the index is the bit of the attribute in EVertexAttributes */
+        enum EAttribute : u32
+        {
+            Position,
+            Normal,
+            Tangent,
+            TexCoord0,
+            TexCoord1,
+            Color0,
+            NumAttributes,
+        };
+
+        struct FPrimitive
+        {
+            u32 Attributes[NumAttributes];  // Accessor per attribute or INVALID_INDEX
+            u32 Indices = INVALID_INDEX;
+            u32 Material = INVALID_INDEX;
+            u32 Mode = MODE_TRIANGLES;
+        };
+
+        /** Load and validate a .gltf or .glb file. Returns false and fills the error message on failure. */
+        bool Load(const std::wstring& Path);
+
+        /**
+         * Hash64 of everything loaded from the files: the JSON document and the buffers, for keys of data derived from the asset.
+         * Reads every byte of the buffers.
+         */
+        u64 ComputeContentHash() const;
+
+        /**
+         * First element of an accessor and the distance between elements, the accessor has been validated to lie within its buffer.
+         * Returns nullptr when the accessor has no buffer view.
+         */
+        const u8* GetAccessorData(const FAccessor& Accessor, u32& OutStride) const;
+
+        /** Address of ByteOffset in a buffer view */
+        const u8* GetBufferViewData(u32 View, u64 ByteOffset) const;
+
+        /**
+         * Decode an accessor to floats, NumComponentsOut per element. Normalized integers are mapped to [0, 1] or [-1, 1], components
+         * the accessor doesn't have are taken from Fill. Sparse substitution is applied.
+         */
+        void ReadFloats(const FAccessor& Accessor, u32 NumComponentsOut, const float* Fill, float* pOut) const;
+
+        static u32 GetComponentSize(u32 ComponentType);
+
+        std::vector<FBufferView> BufferViews;
+        std::vector<FAccessor> Accessors;
+        std::vector<FPrimitive> Primitives;    // The primitives of all meshes, in order
+
+        /** Backing storage of the buffers: mapped files and decoded data URIs */
+        std::vector<std::shared_ptr<const void>> SourceData;
+
+        std::string Error;
+
+    private:
+        bool Fail(const std::string& Message);
+        bool ParseDocument(const char* pJson, size_t JsonLength, const FBuffer& BinChunk, const std::wstring& BasePath);
+        bool ValidateAccessor(const FAccessor& Accessor);
+
+        std::vector<FBuffer> Buffers;
+        const char* pDocument = nullptr;   // JSON text, in the mapped file
+        size_t DocumentLength = 0;
+    };
+}
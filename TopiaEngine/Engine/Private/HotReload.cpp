@@ -0,0 +1,287 @@
+#include "Topia.h"
+#include "HotReload.h"
+
+#include <algorithm>
+
+namespace topia
+{
+    FHotReloader::FHotReloader(u32 NumWorkers)
+    {
+        for (u32 t = 0; t < std::max(1u, NumWorkers); ++t)
+        {
+            Workers.emplace_back(&FHotReloader::WorkerThread, this);
+        }
+    }
+
+    FHotReloader::~FHotReloader()
+    {
+        Watcher.Stop();
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            bStopping = true;
+        }
+        WorkAvailable.notify_all();
+        for (std::thread& Worker : Workers)
+        {
+            Worker.join();
+        }
+    }
+
+    bool FHotReloader::Watch(const std::wstring& SourceDirectory, u32 SettleMilliseconds)
+    {
+        return Watcher.Start(SourceDirectory, SettleMilliseconds);
+    }
+
+    bool FHotReloader::DependsOn(const std::vector<FPath>& Dependencies, FPath Name) const
+    {
+        // Depth first through the dependencies of the dependencies, each node once
+        std::vector<FPath> Stack(Dependencies);
+        std::unordered_set<FPath> Visited;
+        while (!Stack.empty())
+        {
+            const FPath Path = Stack.back();
+            Stack.pop_back();
+            if (Path == Name)
+            {
+                return true;
+            }
+            const auto It = Nodes.find(Path);
+            if (It != Nodes.end() && Visited.insert(Path).second)
+            {
+                Stack.insert(Stack.end(), It->second.Dependencies.begin(), It->second.Dependencies.end());
+            }
+        }
+        return false;
+    }
+
+    bool FHotReloader::Register(FPath Name, IReloadable* pObject, const std::vector<FPath>& Dependencies)
+    {
+        // The current dependencies of Name don't matter, they are replaced
+        if (DependsOn(Dependencies, Name))
+        {
+            const FStringView NameString = Name.GetString();
+            DEBUGPRINT("HotReload: %.*s can't be registered, it would depend on itself", int(NameString.size()), NameString.data());
+            return false;
+        }
+
+        Unregister(Name);
+        for (FPath Dependency : Dependencies)
+        {
+            Nodes[Dependency].Dependents.push_back(Name);
+        }
+        FNode& Node = Nodes[Name];
+        Node.pObject = pObject;
+        Node.Dependencies = Dependencies;
+        return true;
+    }
+
+    void FHotReloader::Unregister(FPath Name)
+    {
+        const auto It = Nodes.find(Name);
+        if (It == Nodes.end() || It->second.pObject == nullptr)
+        {
+            return;
+        }
+
+        IReloadable* pObject = It->second.pObject;
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            auto IsObject = [pObject](const FResult& Result) { return Result.pObject == pObject; };
+            Queue.erase(std::remove_if(Queue.begin(), Queue.end(), IsObject), Queue.end());
+            WorkDone.wait(Lock, [this, pObject]() { return Running.count(pObject) == 0; });
+            Finished.erase(std::remove_if(Finished.begin(), Finished.end(), IsObject), Finished.end());
+        }
+
+        // The node stays while other objects depend on it
+        FNode& Node = It->second;
+        for (FPath Dependency : Node.Dependencies)
+        {
+            std::vector<FPath>& Dependents = Nodes[Dependency].Dependents;
+            Dependents.erase(std::remove(Dependents.begin(), Dependents.end(), Name), Dependents.end());
+        }
+        Node.pObject = nullptr;
+        Node.Dependencies.clear();
+        Node.bOutdated = false;
+        Node.bBuilding = false;
+        OutdatedNodes.erase(std::remove(OutdatedNodes.begin(), OutdatedNodes.end(), Name), OutdatedNodes.end());
+    }
+
+    void FHotReloader::NotifyChanged(FPath Path)
+    {
+        FFileChange Change;
+        Change.Path = Path;
+        Change.Time = std::chrono::steady_clock::now();
+        Changes.push_back(Change);
+    }
+
+    void FHotReloader::MarkOutdated(FPath Name, FNode& Node, std::chrono::steady_clock::time_point ChangeTime)
+    {
+        // Nodes without an object are source files, or objects that were unregistered and don't change anymore
+        if (Node.pObject == nullptr || Node.bOutdated)
+        {
+            return;
+        }
+
+        Node.bOutdated = true;
+        Node.ChangeTime = ChangeTime;
+        OutdatedNodes.push_back(Name);
+        MarkDependentsOutdated(Name, ChangeTime);
+    }
+
+    void FHotReloader::MarkDependentsOutdated(FPath Path, std::chrono::steady_clock::time_point ChangeTime)
+    {
+        const auto It = Nodes.find(Path);
+        if (It == Nodes.end())
+        {
+            return;
+        }
+        for (FPath Dependent : It->second.Dependents)
+        {
+            MarkOutdated(Dependent, Nodes.find(Dependent)->second, ChangeTime);
+        }
+    }
+
+    bool FHotReloader::IsReadyToBuild(const FNode& Node) const
+    {
+        // A running build may have read the sources before they changed again, it is rebuilt once that one is done
+        if (Node.bBuilding)
+        {
+            return false;
+        }
+        for (FPath Dependency : Node.Dependencies)
+        {
+            const FNode& DependencyNode = Nodes.find(Dependency)->second;
+            if (DependencyNode.bOutdated || DependencyNode.bBuilding)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void FHotReloader::Tick()
+    {
+        Watcher.PollChanges(Changes);
+        for (const FFileChange& Change : Changes)
+        {
+            if (Change.Type == EFileChangeType::Overflow)
+            {
+                DEBUGPRINT("HotReload: File notifications were lost, rebuilding everything");
+                for (auto& Pair : Nodes)
+                {
+                    MarkOutdated(Pair.first, Pair.second, Change.Time);
+                }
+            }
+            else
+            {
+                MarkDependentsOutdated(Change.Path, Change.Time);
+            }
+        }
+        Changes.clear();
+
+        std::vector<FResult> Results;
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Results.swap(Finished);
+        }
+
+        const auto Now = std::chrono::steady_clock::now();
+        for (const FResult& Result : Results)
+        {
+            FNode& Node = Nodes.find(Result.Name)->second;
+            if (Node.pObject != Result.pObject)
+            {
+                continue;
+            }
+            Node.bBuilding = false;
+
+            // The objects that depend on a failed one are still rebuilt, from its previous data
+            if (Result.bSuccess)
+            {
+                Result.pObject->Apply();
+
+                const double LatencyMs = std::chrono::duration<double, std::milli>(Now - Result.ChangeTime).count();
+                ++Stats.NumReloads;
+                Stats.LastLatencyMs = LatencyMs;
+                Stats.MaxLatencyMs = std::max(Stats.MaxLatencyMs, LatencyMs);
+                Stats.TotalLatencyMs += LatencyMs;
+            }
+            else
+            {
+                ++Stats.NumFailed;
+                const FStringView Name = Result.Name.GetString();
+                DEBUGPRINT("HotReload: Rebuilding %.*s failed, it keeps its previous data", int(Name.size()), Name.data());
+            }
+        }
+
+        // Start the outdated objects whose dependencies are all up to date
+        u32 NumStarted = 0;
+        for (size_t i = 0; i < OutdatedNodes.size();)
+        {
+            const FPath Name = OutdatedNodes[i];
+            FNode& Node = Nodes.find(Name)->second;
+            if (!IsReadyToBuild(Node))
+            {
+                ++i;
+                continue;
+            }
+
+            Node.bOutdated = false;
+            Node.bBuilding = true;
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                Queue.push_back(FResult{ Name, Node.pObject, Node.ChangeTime, false });
+            }
+            ++NumStarted;
+            OutdatedNodes[i] = OutdatedNodes.back();
+            OutdatedNodes.pop_back();
+        }
+        if (NumStarted > 0)
+        {
+            WorkAvailable.notify_all();
+        }
+    }
+
+    bool FHotReloader::IsIdle() const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        return OutdatedNodes.empty() && Queue.empty() && Running.empty() && Finished.empty();
+    }
+
+    void FHotReloader::WorkerThread()
+    {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        for (;;)
+        {
+            WorkAvailable.wait(Lock, [this]() { return bStopping || !Queue.empty(); });
+            if (bStopping)
+            {
+                return;
+            }
+
+            FResult Work = Queue.front();
+            Queue.pop_front();
+            Running.insert(Work.pObject);
+
+            Lock.unlock();
+            Work.bSuccess = Work.pObject->Rebuild();
+            Lock.lock();
+
+            Running.erase(Work.pObject);
+            Finished.push_back(Work);
+            WorkDone.notify_all();
+        }
+    }
+
+    bool FStaticMeshReloader::Rebuild()
+    {
+        Staging.Reset();
+        return Staging.Build(SourcePath, Settings, pCache);
+    }
+
+    void FStaticMeshReloader::Apply()
+    {
+        pMesh->SwapGeometry(Staging);
+        Staging.Reset();
+    }
+}
@@ -0,0 +1,378 @@
+#include <MeshOptimizer.h>
+
+#include <HashCombine.h>
+#include <TopiaMath.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace topia
+{
+    static constexpr u32 INVALID_INDEX = ~0u;
+
+    /** FIFO cache simulation: a vertex stays cached until CacheSize other vertices have been transformed after it */
+    class FVertexCacheSim
+    {
+    public:
+        FVertexCacheSim(u32 NumVertices, u32 InCacheSize) : Timestamps(NumVertices, 0), CacheSize(InCacheSize), Time(InCacheSize + 1) {}
+
+        /** Returns true when the vertex had to be transformed */
+        TOPIA_INLINE bool Access(u32 Vertex)
+        {
+            if (Time - Timestamps[Vertex] <= CacheSize)
+                return false;
+            Timestamps[Vertex] = Time++;
+            return true;
+        }
+
+        TOPIA_INLINE u32 AccessTriangle(const u32* pTriangle)
+        {
+            return u32(Access(pTriangle[0])) + u32(Access(pTriangle[1])) + u32(Access(pTriangle[2]));
+        }
+
+        /** Age of a vertex in transforms, more than CacheSize means it is not cached */
+        TOPIA_INLINE u32 GetAge(u32 Vertex) const { return Time - Timestamps[Vertex]; }
+
+        void Flush() { Time += CacheSize + 1; }
+
+    private:
+        std::vector<u32> Timestamps;
+        u32 CacheSize;
+        u32 Time;
+    };
+
+    FVertexCacheStats AnalyzeVertexCache(const u32* pIndices, u32 NumIndices, u32 NumVertices, u32 CacheSize)
+    {
+        FVertexCacheStats Stats;
+        Stats.NumTriangles = NumIndices / 3;
+
+        FVertexCacheSim Cache(NumVertices, CacheSize);
+        std::vector<bool> Referenced(NumVertices, false);
+        for (u32 i = 0; i < NumIndices; ++i)
+        {
+            const u32 Vertex = pIndices[i];
+            ASSERT(Vertex < NumVertices);
+            Stats.NumTransformed += u32(Cache.Access(Vertex));
+            if (!Referenced[Vertex])
+            {
+                Referenced[Vertex] = true;
+                ++Stats.NumVertices;
+            }
+        }
+
+        Stats.ACMR = Stats.NumTriangles > 0 ? float(Stats.NumTransformed) / float(Stats.NumTriangles) : 0.0f;
+        Stats.ATVR = Stats.NumVertices > 0 ? float(Stats.NumTransformed) / float(Stats.NumVertices) : 0.0f;
+        return Stats;
+    }
+
+    static size_t sHashVertex(const FVertexStreamRef* pStreams, u32 NumStreams, u32 Vertex)
+    {
+        size_t Hash = 0;
+        for (u32 s = 0; s < NumStreams; ++s)
+        {
+            const u8* pElement = static_cast<const u8*>(pStreams[s].pData) + size_t(Vertex) * pStreams[s].Stride;
+            u32 Offset = 0;
+            for (; Offset + sizeof(u32) <= pStreams[s].Size; Offset += sizeof(u32))
+            {
+                u32 Word;
+                memcpy(&Word, pElement + Offset, sizeof(u32));
+                hash_combine(Hash, Word);
+            }
+            for (; Offset < pStreams[s].Size; ++Offset)
+            {
+                hash_combine(Hash, pElement[Offset]);
+            }
+        }
+        return Hash;
+    }
+
+    static bool sVerticesEqual(const FVertexStreamRef* pStreams, u32 NumStreams, u32 A, u32 B)
+    {
+        for (u32 s = 0; s < NumStreams; ++s)
+        {
+            const u8* pData = static_cast<const u8*>(pStreams[s].pData);
+            if (memcmp(pData + size_t(A) * pStreams[s].Stride, pData + size_t(B) * pStreams[s].Stride, pStreams[s].Size) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    u32 GenerateVertexRemap(const FVertexStreamRef* pStreams, u32 NumStreams, u32 NumVertices, u32* pOutRemap)
+    {
+        // Open addressing table of the first vertex of every unique value, at most half full
+        u32 TableBits = 4;
+        while ((1u << TableBits) < NumVertices * 2ull)
+            ++TableBits;
+        const u32 TableMask = (1u << TableBits) - 1;
+        std::vector<u32> Table(size_t(TableMask) + 1, INVALID_INDEX);
+
+        u32 NumUnique = 0;
+        for (u32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+        {
+            // Fibonacci hashing spreads the combined hash over the table bits
+            u32 Slot = u32((u64(sHashVertex(pStreams, NumStreams, Vertex)) * 0x9E3779B97F4A7C15ull) >> (64 - TableBits));
+            for (u32 Probe = 1; ; ++Probe)
+            {
+                const u32 Entry = Table[Slot];
+                if (Entry == INVALID_INDEX)
+                {
+                    Table[Slot] = Vertex;
+                    pOutRemap[Vertex] = NumUnique++;
+                    break;
+                }
+                if (sVerticesEqual(pStreams, NumStreams, Entry, Vertex))
+                {
+                    pOutRemap[Vertex] = pOutRemap[Entry];
+                    break;
+                }
+                Slot = (Slot + Probe) & TableMask;
+            }
+        }
+        return NumUnique;
+    }
+
+    void RemapVertexStream(void* pDest, const void* pSource, u32 ElementSize, u32 NumVertices, const u32* pRemap)
+    {
+        ASSERT(pDest != pSource);
+        u8* pDestBytes = static_cast<u8*>(pDest);
+        const u8* pSourceBytes = static_cast<const u8*>(pSource);
+        for (u32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+        {
+            if (pRemap[Vertex] != INVALID_INDEX)
+            {
+                memcpy(pDestBytes + size_t(pRemap[Vertex]) * ElementSize, pSourceBytes + size_t(Vertex) * ElementSize, ElementSize);
+            }
+        }
+    }
+
+    void RemapIndices(u32* pIndices, u32 NumIndices, const u32* pRemap)
+    {
+        for (u32 i = 0; i < NumIndices; ++i)
+        {
+            pIndices[i] = pRemap[pIndices[i]];
+        }
+    }
+
+    void OptimizeVertexCache(u32* pIndices, u32 NumIndices, u32 NumVertices, u32 CacheSize)
+    {
+        const u32 NumTriangles = NumIndices / 3;
+        if (NumTriangles == 0)
+            return;
+
+        // Triangles around every vertex, LiveTriangles counts the ones not emitted yet
+        std::vector<u32> LiveTriangles(NumVertices, 0);
+        for (u32 i = 0; i < NumTriangles * 3; ++i)
+        {
+            ASSERT(pIndices[i] < NumVertices);
+            ++LiveTriangles[pIndices[i]];
+        }
+
+        std::vector<u32> AdjacencyOffsets(size_t(NumVertices) + 1);
+        AdjacencyOffsets[0] = 0;
+        for (u32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+        {
+            AdjacencyOffsets[Vertex + 1] = AdjacencyOffsets[Vertex] + LiveTriangles[Vertex];
+        }
+
+        std::vector<u32> Adjacency(NumTriangles * 3);
+        {
+            std::vector<u32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+            for (u32 i = 0; i < NumTriangles * 3; ++i)
+            {
+                Adjacency[Fill[pIndices[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<u32> Output(NumTriangles * 3);
+        u32* pOutput = Output.data();
+        std::vector<u8> Emitted(NumTriangles, 0);
+
+        // Every emitted vertex is pushed once, so the stack can't grow beyond the number of indices
+        std::vector<u32> DeadEnds(NumTriangles * 3);
+        u32 NumDeadEnds = 0;
+        std::vector<u32> Candidates;
+
+        FVertexCacheSim Cache(NumVertices, CacheSize);
+        u32 Cursor = 0;
+
+        // Next fanning vertex when none of the last triangles' vertices has anything left: the most recent vertex that still has
+        // triangles, then the first vertex in index order
+        auto SkipDeadEnd = [&]() -> u32
+        {
+            while (NumDeadEnds > 0)
+            {
+                const u32 Vertex = DeadEnds[--NumDeadEnds];
+                if (LiveTriangles[Vertex] > 0)
+                    return Vertex;
+            }
+            for (; Cursor < NumVertices; ++Cursor)
+            {
+                if (LiveTriangles[Cursor] > 0)
+                    return Cursor;
+            }
+            return INVALID_INDEX;
+        };
+
+        u32 Fan = SkipDeadEnd();
+        while (Fan != INVALID_INDEX)
+        {
+            // Emit all remaining triangles around the fanning vertex
+            Candidates.clear();
+            for (u32 a = AdjacencyOffsets[Fan]; a < AdjacencyOffsets[Fan + 1]; ++a)
+            {
+                const u32 Triangle = Adjacency[a];
+                if (Emitted[Triangle])
+                    continue;
+                Emitted[Triangle] = 1;
+
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    const u32 Vertex = pIndices[Triangle * 3 + k];
+                    *pOutput++ = Vertex;
+                    DeadEnds[NumDeadEnds++] = Vertex;
+                    Candidates.push_back(Vertex);
+                    --LiveTriangles[Vertex];
+                    Cache.Access(Vertex);
+                }
+            }
+
+            // Fan around the oldest vertex that will still be cached after its remaining triangles are emitted
+            u32 Best = INVALID_INDEX;
+            int BestPriority = -1;
+            for (const u32 Vertex : Candidates)
+            {
+                if (LiveTriangles[Vertex] == 0)
+                    continue;
+
+                int Priority = 0;
+                const u32 Age = Cache.GetAge(Vertex);
+                if (Age + 2 * LiveTriangles[Vertex] <= CacheSize)
+                    Priority = int(Age);
+                if (Priority > BestPriority)
+                {
+                    Best = Vertex;
+                    BestPriority = Priority;
+                }
+            }
+
+            Fan = Best != INVALID_INDEX ? Best : SkipDeadEnd();
+        }
+
+        ASSERT(pOutput == Output.data() + Output.size());
+        memcpy(pIndices, Output.data(), Output.size() * sizeof(u32));
+    }
+
+    /** Cache misses of a range of triangles starting from an empty cache */
+    static u32 sCountMisses(const u32* pIndices, u32 FirstTriangle, u32 EndTriangle, FVertexCacheSim& Cache)
+    {
+        Cache.Flush();
+        u32 Misses = 0;
+        for (u32 t = FirstTriangle; t < EndTriangle; ++t)
+        {
+            Misses += Cache.AccessTriangle(pIndices + t * 3);
+        }
+        return Misses;
+    }
+
+    void OptimizeOverdraw(u32* pIndices, u32 NumIndices, const Float3* pPositions, u32 NumVertices, float Threshold, u32 CacheSize)
+    {
+        const u32 NumTriangles = NumIndices / 3;
+        if (NumTriangles == 0)
+            return;
+
+        // Hard boundaries: a triangle with 3 misses starts a new patch that doesn't share vertices with the previous one, so
+        // moving it doesn't cost extra transforms
+        FVertexCacheSim Cache(NumVertices, CacheSize);
+        std::vector<u32> HardBoundaries;
+        for (u32 t = 0; t < NumTriangles; ++t)
+        {
+            if (Cache.AccessTriangle(pIndices + t * 3) == 3 || t == 0)
+                HardBoundaries.push_back(t);
+        }
+        HardBoundaries.push_back(NumTriangles);
+
+        // Soft boundaries: split a patch where the miss ratio so far is within Threshold of the patch's, this costs at most
+        // Threshold times the transforms of the patch
+        std::vector<u32> Clusters;
+        for (size_t h = 0; h + 1 < HardBoundaries.size(); ++h)
+        {
+            const u32 Start = HardBoundaries[h], End = HardBoundaries[h + 1];
+            const float TargetACMR = float(sCountMisses(pIndices, Start, End, Cache)) / float(End - Start) * Threshold;
+
+            Clusters.push_back(Start);
+            Cache.Flush();
+            u32 Misses = 0, Count = 0;
+            for (u32 t = Start; t < End; ++t)
+            {
+                Misses += Cache.AccessTriangle(pIndices + t * 3);
+                ++Count;
+                if (t + 1 < End && float(Misses) <= TargetACMR * float(Count))
+                {
+                    Clusters.push_back(t + 1);
+                    Cache.Flush();
+                    Misses = Count = 0;
+                }
+            }
+        }
+        const u32 NumClusters = u32(Clusters.size());
+        Clusters.push_back(NumTriangles);
+
+        // Area weighted centroid and normal per cluster
+        std::vector<Vec3> Centroids(NumClusters), Normals(NumClusters);
+        Vec3 MeshCentroid = Vec3::sZero();
+        float MeshArea = 0.0f;
+        for (u32 c = 0; c < NumClusters; ++c)
+        {
+            Vec3 Centroid = Vec3::sZero(), Normal = Vec3::sZero();
+            float Area = 0.0f;
+            for (u32 t = Clusters[c]; t < Clusters[c + 1]; ++t)
+            {
+                const Vec3 A(pPositions[pIndices[t * 3 + 0]]), B(pPositions[pIndices[t * 3 + 1]]), C(pPositions[pIndices[t * 3 + 2]]);
+                const Vec3 Cross = (B - A).Cross(C - A);
+                const float TwiceArea = Cross.Length();
+                Centroid += (A + B + C) * (TwiceArea / 3.0f);
+                Normal += Cross;
+                Area += TwiceArea;
+            }
+
+            MeshCentroid += Centroid;
+            MeshArea += Area;
+            Centroids[c] = Area > 0.0f ? Centroid / Area : Centroid;
+            Normals[c] = Normal.NormalizedOr(Vec3::sZero());
+        }
+        MeshCentroid = MeshArea > 0.0f ? MeshCentroid / MeshArea : MeshCentroid;
+
+        // Clusters facing away from the center are in front of the rest of the mesh from most directions, draw them first
+        std::vector<float> Keys(NumClusters);
+        std::vector<u32> Order(NumClusters);
+        for (u32 c = 0; c < NumClusters; ++c)
+        {
+            Keys[c] = (Centroids[c] - MeshCentroid).Dot(Normals[c]);
+            Order[c] = c;
+        }
+        std::stable_sort(Order.begin(), Order.end(), [&Keys](u32 A, u32 B) { return Keys[A] > Keys[B]; });
+
+        std::vector<u32> Output;
+        Output.reserve(NumTriangles * 3);
+        for (const u32 c : Order)
+        {
+            Output.insert(Output.end(), pIndices + Clusters[c] * 3, pIndices + Clusters[c + 1] * 3);
+        }
+        memcpy(pIndices, Output.data(), Output.size() * sizeof(u32));
+    }
+
+    u32 OptimizeVertexFetch(u32* pIndices, u32 NumIndices, u32 NumVertices, u32* pOutRemap)
+    {
+        std::fill(pOutRemap, pOutRemap + NumVertices, INVALID_INDEX);
+
+        u32 NumUsed = 0;
+        for (u32 i = 0; i < NumIndices; ++i)
+        {
+            u32& Remapped = pOutRemap[pIndices[i]];
+            if (Remapped == INVALID_INDEX)
+                Remapped = NumUsed++;
+            pIndices[i] = Remapped;
+        }
+        return NumUsed;
+    }
+}
@@ -0,0 +1,562 @@
+#include <MeshSimplifier.h>
+
+#include <MeshOptimizer.h>
+#include <TopiaMath.h>
+#include <AABox.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace topia
+{
+    static constexpr u32 INVALID_INDEX = ~0u;
+
+    /**
+     * Symmetric 4x4 quadric p^T A p + 2 b.p + c, the sum of squared distances to a set of weighted planes. Stored as its 10
+     * unique values instead of a full Matrix<4, 4>: accumulating and evaluating millions of them is the hot path.
+     */
+    struct FQuadric
+    {
+        float A00 = 0.0f, A11 = 0.0f, A22 = 0.0f, A01 = 0.0f, A02 = 0.0f, A12 = 0.0f;
+        float B0 = 0.0f, B1 = 0.0f, B2 = 0.0f;
+        float C = 0.0f;
+        float Weight = 0.0f;
+
+        /** Plane Normal.p + Distance = 0, Normal unit length */
+        static FQuadric sFromPlane(Vec3Arg Normal, float Distance, float InWeight)
+        {
+            const float X = Normal.GetX(), Y = Normal.GetY(), Z = Normal.GetZ();
+            FQuadric Q;
+            Q.A00 = X * X * InWeight;
+            Q.A11 = Y * Y * InWeight;
+            Q.A22 = Z * Z * InWeight;
+            Q.A01 = X * Y * InWeight;
+            Q.A02 = X * Z * InWeight;
+            Q.A12 = Y * Z * InWeight;
+            Q.B0 = X * Distance * InWeight;
+            Q.B1 = Y * Distance * InWeight;
+            Q.B2 = Z * Distance * InWeight;
+            Q.C = Distance * Distance * InWeight;
+            Q.Weight = InWeight;
+            return Q;
+        }
+
+        FQuadric& operator+=(const FQuadric& Other)
+        {
+            A00 += Other.A00; A11 += Other.A11; A22 += Other.A22;
+            A01 += Other.A01; A02 += Other.A02; A12 += Other.A12;
+            B0 += Other.B0; B1 += Other.B1; B2 += Other.B2;
+            C += Other.C;
+            Weight += Other.Weight;
+            return *this;
+        }
+
+        /** Weighted mean squared distance of P to the planes */
+        float Evaluate(Vec3Arg P) const
+        {
+            const float X = P.GetX(), Y = P.GetY(), Z = P.GetZ();
+            const float R = A00 * X * X + A11 * Y * Y + A22 * Z * Z + 2.0f * (A01 * X * Y + A02 * X * Z + A12 * Y * Z)
+                + 2.0f * (B0 * X + B1 * Y + B2 * Z) + C;
+            return Weight > 0.0f ? std::abs(R) / Weight : 0.0f;
+        }
+    };
+
+    /** How a vertex may move */
+    enum class EVertexKind : u8
+    {
+        Manifold,   // Interior vertex without seams, can collapse onto any neighbour
+        Border,     // On an open border, collapses along the border
+        Seam,       // One of two vertices at the same position on an attribute seam, both collapse along the seam
+        Locked,     // Corners of borders and seams, never moves
+    };
+
+    /** Whether a vertex of kind From may collapse onto a vertex of kind To */
+    static const bool sCanCollapse[4][4] =
+    {
+        //  Manifold  Border  Seam   Locked
+        {   true,     true,   true,  true  },   // Manifold
+        {   false,    true,   false, true  },   // Border
+        {   false,    false,  true,  true  },   // Seam
+        {   false,    false,  false, false },   // Locked
+    };
+
+    struct FCollapse
+    {
+        u32 From;
+        u32 To;
+        float Error;
+    };
+
+    /** Working state of SimplifyMesh */
+    class FSimplifier
+    {
+    public:
+        FSimplifier(const Float3* pInPositions, u32 InNumVertices) : NumVertices(InNumVertices)
+        {
+            // Work in a unit cube for precision, errors are scaled back at the end
+            AABox Bounds;
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                Bounds.Encapsulate(Vec3(pInPositions[v]));
+            }
+            const Vec3 Extent = NumVertices > 0 ? Bounds.GetExtent() * 2.0f : Vec3::sZero();
+            Scale = std::max(std::max(Extent.GetX(), Extent.GetY()), Extent.GetZ());
+            const float InvScale = Scale > 0.0f ? 1.0f / Scale : 0.0f;
+
+            Positions.resize(NumVertices);
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                Positions[v] = (Vec3(pInPositions[v]) - Bounds.mMin) * InvScale;
+            }
+
+            // Vertices with the same position form a ring through Wedges, PositionIds identifies the ring
+            FVertexStreamRef PositionStream;
+            PositionStream.pData = pInPositions;
+            PositionStream.Size = sizeof(Float3);
+            PositionStream.Stride = sizeof(Float3);
+            PositionIds.resize(NumVertices);
+            NumPositions = GenerateVertexRemap(&PositionStream, 1, NumVertices, PositionIds.data());
+
+            Wedges.resize(NumVertices);
+            std::vector<u32> LastWedge(NumPositions, INVALID_INDEX), FirstWedge(NumPositions, INVALID_INDEX);
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                const u32 Id = PositionIds[v];
+                if (FirstWedge[Id] == INVALID_INDEX)
+                    FirstWedge[Id] = v;
+                else
+                    Wedges[LastWedge[Id]] = v;
+                LastWedge[Id] = v;
+            }
+            for (u32 Id = 0; Id < NumPositions; ++Id)
+            {
+                if (LastWedge[Id] != INVALID_INDEX)
+                    Wedges[LastWedge[Id]] = FirstWedge[Id];
+            }
+        }
+
+        u32 Simplify(u32* pIndices, u32 NumIndices, u32 TargetIndexCount, float MaxError, float& OutError, u32* pOutRemap)
+        {
+            const float MaxErrorSq = MaxError * MaxError;
+            float ResultErrorSq = 0.0f;
+
+            BuildAdjacency(pIndices, NumIndices);
+            ClassifyVertices(pIndices, NumIndices);
+            ComputeQuadrics(pIndices, NumIndices);
+
+            std::vector<FCollapse> Collapses;
+            std::vector<u32> CollapseRemap(NumVertices);
+            std::vector<u8> Touched(NumPositions);
+
+            while (NumIndices > TargetIndexCount)
+            {
+                BuildAdjacency(pIndices, NumIndices);
+                GatherCollapses(pIndices, NumIndices, MaxErrorSq, Collapses);
+                if (Collapses.empty())
+                    break;
+
+                std::sort(Collapses.begin(), Collapses.end(), [](const FCollapse& A, const FCollapse& B) { return A.Error < B.Error; });
+
+                // Every collapse removes about 2 triangles, don't overshoot the target by much
+                const u32 MaxCollapses = std::max(1u, (NumIndices - TargetIndexCount) / 6);
+
+                for (u32 v = 0; v < NumVertices; ++v)
+                {
+                    CollapseRemap[v] = v;
+                }
+                std::fill(Touched.begin(), Touched.end(), u8(0));
+
+                u32 NumCollapsed = 0;
+                for (const FCollapse& Collapse : Collapses)
+                {
+                    if (NumCollapsed >= MaxCollapses)
+                        break;
+
+                    const u32 From = Collapse.From, To = Collapse.To;
+                    if (Touched[PositionIds[From]] || Touched[PositionIds[To]])
+                        continue;
+
+                    // The other side of a seam collapses along with it
+                    u32 SeamFrom = INVALID_INDEX, SeamTo = INVALID_INDEX;
+                    if (Kinds[From] == EVertexKind::Seam)
+                    {
+                        SeamFrom = Wedges[From];
+                        SeamTo = FindSeamPartner(SeamFrom, To);
+                        if (SeamTo == INVALID_INDEX)
+                            continue;
+                    }
+
+                    if (HasFlips(pIndices, From, To) || (SeamFrom != INVALID_INDEX && HasFlips(pIndices, SeamFrom, SeamTo)))
+                        continue;
+
+                    CollapseRemap[From] = To;
+                    if (SeamFrom != INVALID_INDEX)
+                        CollapseRemap[SeamFrom] = SeamTo;
+
+                    Quadrics[PositionIds[To]] += Quadrics[PositionIds[From]];
+                    ResultErrorSq = std::max(ResultErrorSq, Collapse.Error);
+                    ++NumCollapsed;
+
+                    // Lock the ring around the moved vertex, flip tests of its neighbours assume it stays in place
+                    LockRing(pIndices, From, Touched);
+                    if (SeamFrom != INVALID_INDEX)
+                        LockRing(pIndices, SeamFrom, Touched);
+                    Touched[PositionIds[To]] = 1;
+                }
+
+                if (NumCollapsed == 0)
+                    break;
+
+                NumIndices = ApplyCollapses(pIndices, NumIndices, CollapseRemap);
+
+                // Vertices move once per pass, so a single lookup follows them
+                if (pOutRemap != nullptr)
+                {
+                    for (u32 v = 0; v < NumVertices; ++v)
+                    {
+                        pOutRemap[v] = CollapseRemap[pOutRemap[v]];
+                    }
+                }
+            }
+
+            OutError = sqrt(ResultErrorSq) * Scale;
+            return NumIndices;
+        }
+
+    private:
+        /** Triangles around every vertex */
+        void BuildAdjacency(const u32* pIndices, u32 NumIndices)
+        {
+            AdjacencyOffsets.assign(size_t(NumVertices) + 1, 0);
+            for (u32 i = 0; i < NumIndices; ++i)
+            {
+                ++AdjacencyOffsets[pIndices[i] + 1];
+            }
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                AdjacencyOffsets[v + 1] += AdjacencyOffsets[v];
+            }
+            Adjacency.resize(NumIndices);
+            std::vector<u32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+            for (u32 i = 0; i < NumIndices; ++i)
+            {
+                Adjacency[Fill[pIndices[i]]++] = i / 3;
+            }
+            pCurrentIndices = pIndices;
+        }
+
+        /** Is there a triangle with the edge From -> To, in vertex indices */
+        bool HasEdge(u32 From, u32 To) const
+        {
+            for (u32 a = AdjacencyOffsets[From]; a < AdjacencyOffsets[From + 1]; ++a)
+            {
+                const u32* pTriangle = pCurrentIndices + Adjacency[a] * 3;
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    if (pTriangle[k] == From && pTriangle[(k + 1) % 3] == To)
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        /** Is there a triangle with the edge From -> To between any vertices at these positions */
+        bool HasPositionEdge(u32 From, u32 To) const
+        {
+            u32 Wedge = From;
+            do
+            {
+                for (u32 a = AdjacencyOffsets[Wedge]; a < AdjacencyOffsets[Wedge + 1]; ++a)
+                {
+                    const u32* pTriangle = pCurrentIndices + Adjacency[a] * 3;
+                    for (u32 k = 0; k < 3; ++k)
+                    {
+                        if (pTriangle[k] == Wedge && PositionIds[pTriangle[(k + 1) % 3]] == PositionIds[To])
+                            return true;
+                    }
+                }
+                Wedge = Wedges[Wedge];
+            } while (Wedge != From);
+            return false;
+        }
+
+        /** The vertex at the position of To that shares an edge with SeamFrom, INVALID_INDEX if there is none */
+        u32 FindSeamPartner(u32 SeamFrom, u32 To) const
+        {
+            u32 Wedge = To;
+            do
+            {
+                if (Wedge != To && (HasEdge(SeamFrom, Wedge) || HasEdge(Wedge, SeamFrom)))
+                    return Wedge;
+                Wedge = Wedges[Wedge];
+            } while (Wedge != To);
+            return INVALID_INDEX;
+        }
+
+        void ClassifyVertices(const u32* pIndices, u32 NumIndices)
+        {
+            // Count the edges without a twin: border edges have none at the position level, seam edges have one on the other side
+            std::vector<u8> BorderOut(NumVertices, 0), BorderIn(NumVertices, 0), SeamOut(NumVertices, 0), SeamIn(NumVertices, 0);
+            std::vector<u32> OpenNext(NumVertices, INVALID_INDEX), OpenPrevious(NumVertices, INVALID_INDEX);
+            auto Increment = [](u8& Count) { Count = u8(std::min(Count + 1, 255)); };
+            for (u32 i = 0; i < NumIndices; ++i)
+            {
+                const u32 From = pIndices[i], To = pIndices[i - i % 3 + (i + 1) % 3];
+                if (HasEdge(To, From))
+                    continue;
+                OpenNext[From] = To;
+                OpenPrevious[To] = From;
+                if (HasPositionEdge(To, From))
+                {
+                    Increment(SeamOut[From]);
+                    Increment(SeamIn[To]);
+                }
+                else
+                {
+                    Increment(BorderOut[From]);
+                    Increment(BorderIn[To]);
+                }
+            }
+
+            Kinds.resize(NumVertices);
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                const u32 Wedge = Wedges[v];
+                if (Wedge == v)
+                {
+                    // A single border passing through, anything else (a vertex where two borders touch) is locked
+                    if (BorderOut[v] == 0 && BorderIn[v] == 0 && SeamOut[v] == 0 && SeamIn[v] == 0)
+                        Kinds[v] = EVertexKind::Manifold;
+                    else if (BorderOut[v] == 1 && BorderIn[v] == 1 && SeamOut[v] == 0 && SeamIn[v] == 0)
+                        Kinds[v] = EVertexKind::Border;
+                    else
+                        Kinds[v] = EVertexKind::Locked;
+                }
+                else
+                {
+                    // Exactly two sides of a seam passing through, seam ends and corners of several charts are locked
+                    const bool bTwoWedges = Wedges[Wedge] == v;
+                    const bool bSeam = bTwoWedges && BorderOut[v] == 0 && BorderIn[v] == 0 && BorderOut[Wedge] == 0 && BorderIn[Wedge] == 0
+                        && SeamOut[v] == 1 && SeamIn[v] == 1 && SeamOut[Wedge] == 1 && SeamIn[Wedge] == 1;
+                    Kinds[v] = bSeam ? EVertexKind::Seam : EVertexKind::Locked;
+                }
+
+                // Where a border or seam turns by more than 45 degrees it has a corner, moving that along either edge cuts it off
+                if (Kinds[v] == EVertexKind::Border || Kinds[v] == EVertexKind::Seam)
+                {
+                    const Vec3 In = Positions[v] - Positions[OpenPrevious[v]];
+                    const Vec3 Out = Positions[OpenNext[v]] - Positions[v];
+                    if (In.Dot(Out) <= 0.7071f * sqrt(In.LengthSq() * Out.LengthSq()))
+                        Kinds[v] = EVertexKind::Locked;
+                }
+            }
+        }
+
+        void ComputeQuadrics(const u32* pIndices, u32 NumIndices)
+        {
+            Quadrics.assign(NumPositions, FQuadric());
+            for (u32 t = 0; t < NumIndices; t += 3)
+            {
+                const Vec3 P0 = Positions[pIndices[t]], P1 = Positions[pIndices[t + 1]], P2 = Positions[pIndices[t + 2]];
+                const Vec3 Cross = (P1 - P0).Cross(P2 - P0);
+                const float Area = Cross.Length();
+                if (Area <= 0.0f)
+                    continue;
+
+                // Area weighted plane of the triangle
+                const Vec3 Normal = Cross / Area;
+                const FQuadric Q = FQuadric::sFromPlane(Normal, -Normal.Dot(P0), Area);
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    Quadrics[PositionIds[pIndices[t + k]]] += Q;
+                }
+
+                // Borders and seams also get a plane through the edge perpendicular to the triangle, which keeps their shape
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    const u32 From = pIndices[t + k], To = pIndices[t + (k + 1) % 3];
+                    if (HasEdge(To, From))
+                        continue;
+
+                    const Vec3 Edge = Positions[To] - Positions[From];
+                    const float EdgeLengthSq = Edge.LengthSq();
+                    if (EdgeLengthSq <= 0.0f)
+                        continue;
+                    const Vec3 EdgeNormal = Edge.Cross(Normal).Normalized();
+                    const FQuadric EdgeQ = FQuadric::sFromPlane(EdgeNormal, -EdgeNormal.Dot(Positions[From]), EdgeLengthSq * 10.0f);
+                    Quadrics[PositionIds[From]] += EdgeQ;
+                    Quadrics[PositionIds[To]] += EdgeQ;
+                }
+            }
+        }
+
+        /** Error of moving From onto To, FLT_MAX when the collapse isn't allowed */
+        float GetCollapseError(u32 From, u32 To) const
+        {
+            const EVertexKind FromKind = Kinds[From], ToKind = Kinds[To];
+            if (!sCanCollapse[u32(FromKind)][u32(ToKind)])
+                return FLT_MAX;
+
+            // Borders only move along the border and seams along the seam, the edge must be open at the level that matters
+            if (FromKind == EVertexKind::Border && (HasPositionEdge(To, From) && HasPositionEdge(From, To)))
+                return FLT_MAX;
+            if (FromKind == EVertexKind::Seam && (HasEdge(To, From) && HasEdge(From, To)))
+                return FLT_MAX;
+
+            FQuadric Q = Quadrics[PositionIds[From]];
+            Q += Quadrics[PositionIds[To]];
+            return Q.Evaluate(Positions[To]);
+        }
+
+        /** The cheapest collapse of every vertex that stays within MaxErrorSq, a vertex can only move once per pass anyway */
+        void GatherCollapses(const u32* pIndices, u32 NumIndices, float MaxErrorSq, std::vector<FCollapse>& OutCollapses)
+        {
+            BestTargets.assign(NumVertices, INVALID_INDEX);
+            BestErrors.assign(NumVertices, FLT_MAX);
+            for (u32 i = 0; i < NumIndices; ++i)
+            {
+                // Interior edges are seen from both triangles, which is cheaper than finding the twin
+                const u32 A = pIndices[i], B = pIndices[i - i % 3 + (i + 1) % 3];
+                const float ErrorAB = GetCollapseError(A, B);
+                if (ErrorAB < BestErrors[A])
+                {
+                    BestErrors[A] = ErrorAB;
+                    BestTargets[A] = B;
+                }
+                const float ErrorBA = GetCollapseError(B, A);
+                if (ErrorBA < BestErrors[B])
+                {
+                    BestErrors[B] = ErrorBA;
+                    BestTargets[B] = A;
+                }
+            }
+
+            OutCollapses.clear();
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                if (BestTargets[v] != INVALID_INDEX && BestErrors[v] <= MaxErrorSq)
+                {
+                    FCollapse Collapse;
+                    Collapse.From = v;
+                    Collapse.To = BestTargets[v];
+                    Collapse.Error = BestErrors[v];
+                    OutCollapses.push_back(Collapse);
+                }
+            }
+        }
+
+        /** Would moving From onto To turn a remaining triangle around From over */
+        bool HasFlips(const u32* pIndices, u32 From, u32 To) const
+        {
+            // The summed normals of the ring stand in for the surface around From. Comparing with the old normal of every triangle
+            // alone lets a triangle turn a bit further in every pass until it stands upright.
+            Vec3 RingNormal = Vec3::sZero();
+            for (u32 a = AdjacencyOffsets[From]; a < AdjacencyOffsets[From + 1]; ++a)
+            {
+                const u32* pTriangle = pIndices + Adjacency[a] * 3;
+                const Vec3 P0 = Positions[pTriangle[0]];
+                RingNormal += (Positions[pTriangle[1]] - P0).Cross(Positions[pTriangle[2]] - P0);
+            }
+
+            const Vec3 NewPosition = Positions[To];
+            for (u32 a = AdjacencyOffsets[From]; a < AdjacencyOffsets[From + 1]; ++a)
+            {
+                const u32* pTriangle = pIndices + Adjacency[a] * 3;
+
+                // Triangles on the collapsed edge disappear
+                const u32 ToId = PositionIds[To];
+                if (PositionIds[pTriangle[0]] == ToId || PositionIds[pTriangle[1]] == ToId || PositionIds[pTriangle[2]] == ToId)
+                    continue;
+
+                const Vec3 P0 = Positions[pTriangle[0]], P1 = Positions[pTriangle[1]], P2 = Positions[pTriangle[2]];
+                const Vec3 Before = (P1 - P0).Cross(P2 - P0);
+                const Vec3 Q0 = pTriangle[0] == From ? NewPosition : P0;
+                const Vec3 Q1 = pTriangle[1] == From ? NewPosition : P1;
+                const Vec3 Q2 = pTriangle[2] == From ? NewPosition : P2;
+                const Vec3 After = (Q1 - Q0).Cross(Q2 - Q0);
+                // Turning by more than ~75 degrees also counts, such triangles are slivers that flip in the next collapse. So does
+                // losing nearly all area: the corners end up (almost) on a line and the rounded normal of After can point anywhere.
+                const float AfterLengthSq = After.LengthSq();
+                if (Before.Dot(After) <= 0.25f * sqrt(Before.LengthSq() * AfterLengthSq) || AfterLengthSq <= 1.0e-8f * Before.LengthSq()
+                    || RingNormal.Dot(After) <= 0.25f * sqrt(RingNormal.LengthSq() * AfterLengthSq))
+                    return true;
+            }
+            return false;
+        }
+
+        void LockRing(const u32* pIndices, u32 Vertex, std::vector<u8>& Touched) const
+        {
+            for (u32 a = AdjacencyOffsets[Vertex]; a < AdjacencyOffsets[Vertex + 1]; ++a)
+            {
+                const u32* pTriangle = pIndices + Adjacency[a] * 3;
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    Touched[PositionIds[pTriangle[k]]] = 1;
+                }
+            }
+        }
+
+        /** Remap the indices and drop the triangles that became degenerate, returns the new index count */
+        u32 ApplyCollapses(u32* pIndices, u32 NumIndices, const std::vector<u32>& CollapseRemap) const
+        {
+            u32 NumWritten = 0;
+            for (u32 t = 0; t < NumIndices; t += 3)
+            {
+                const u32 A = CollapseRemap[pIndices[t]], B = CollapseRemap[pIndices[t + 1]], C = CollapseRemap[pIndices[t + 2]];
+                const u32 IdA = PositionIds[A], IdB = PositionIds[B], IdC = PositionIds[C];
+                if (IdA == IdB || IdB == IdC || IdC == IdA)
+                    continue;
+                pIndices[NumWritten++] = A;
+                pIndices[NumWritten++] = B;
+                pIndices[NumWritten++] = C;
+            }
+            return NumWritten;
+        }
+
+        u32 NumVertices;
+        u32 NumPositions = 0;
+        float Scale = 0.0f;
+        std::vector<Vec3> Positions;
+        std::vector<u32> PositionIds;
+        std::vector<u32> Wedges;
+        std::vector<EVertexKind> Kinds;
+        std::vector<FQuadric> Quadrics;
+
+        std::vector<u32> AdjacencyOffsets;
+        std::vector<u32> Adjacency;
+        std::vector<u32> BestTargets;
+        std::vector<float> BestErrors;
+        const u32* pCurrentIndices = nullptr;
+    };
+
+    u32 SimplifyMesh(const u32* pIndices, u32 NumIndices, const Float3* pPositions, u32 NumVertices, u32 TargetIndexCount, float MaxError,
+        u32* pOutIndices, float* pOutError, u32* pOutRemap)
+    {
+        NumIndices -= NumIndices % 3;
+        if (pOutIndices != pIndices)
+        {
+            memcpy(pOutIndices, pIndices, NumIndices * sizeof(u32));
+        }
+        if (pOutRemap != nullptr)
+        {
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                pOutRemap[v] = v;
+            }
+        }
+
+        float Error = 0.0f;
+        if (NumIndices > TargetIndexCount)
+        {
+            FSimplifier Simplifier(pPositions, NumVertices);
+            NumIndices = Simplifier.Simplify(pOutIndices, NumIndices, TargetIndexCount, MaxError, Error, pOutRemap);
+        }
+
+        if (pOutError != nullptr)
+        {
+            *pOutError = Error;
+        }
+        return NumIndices;
+    }
+}
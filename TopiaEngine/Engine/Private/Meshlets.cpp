@@ -0,0 +1,288 @@
+#include <Meshlets.h>
+
+#include <TopiaMath.h>
+#include <Frustum.h>
+
+#include <cfloat>
+
+namespace topia
+{
+    static constexpr u32 INVALID_INDEX = ~0u;
+    static constexpr u8 NOT_IN_MESHLET = 0xff;
+
+    void FMeshletData::Reset()
+    {
+        Meshlets.Reset();
+        Bounds.Reset();
+        Vertices.Reset();
+        Triangles.Reset();
+    }
+
+    /** Bounding sphere and normal cone of the triangles of a meshlet */
+    static FMeshletBounds sComputeBounds(const u32* pMeshletVertices, const u32* pMeshletTriangles, const FMeshlet& Meshlet, const Float3* pPositions)
+    {
+        FMeshletBounds Bounds;
+        const u32* pVertices = pMeshletVertices + Meshlet.VertexOffset;
+
+        // Sphere around the center of the bounding box
+        AABox Box;
+        for (u32 v = 0; v < Meshlet.NumVertices; ++v)
+        {
+            Box.Encapsulate(Vec3(pPositions[pVertices[v]]));
+        }
+        const Vec3 Center = Box.GetCenter();
+        float RadiusSq = 0.0f;
+        for (u32 v = 0; v < Meshlet.NumVertices; ++v)
+        {
+            RadiusSq = std::max(RadiusSq, (Vec3(pPositions[pVertices[v]]) - Center).LengthSq());
+        }
+        Center.StoreFloat3(&Bounds.Center);
+        Bounds.Radius = sqrt(RadiusSq);
+
+        // Cone around the average normal, degenerate triangles have no facing and are skipped
+        Vec3 Normals[256];
+        u32 NumNormals = 0;
+        Vec3 NormalSum = Vec3::sZero();
+        for (u32 t = 0; t < Meshlet.NumTriangles; ++t)
+        {
+            const u32 Triangle = pMeshletTriangles[Meshlet.TriangleOffset + t];
+            const Vec3 A(pPositions[pVertices[Triangle & 0xff]]);
+            const Vec3 B(pPositions[pVertices[(Triangle >> 8) & 0xff]]);
+            const Vec3 C(pPositions[pVertices[(Triangle >> 16) & 0xff]]);
+            const Vec3 Normal = (B - A).Cross(C - A);
+            const float Length = Normal.Length();
+            if (Length > 0.0f)
+            {
+                Normals[NumNormals] = Normal / Length;
+                NormalSum += Normals[NumNormals];
+                ++NumNormals;
+            }
+        }
+
+        // Quantize the axis first and measure the cone around the quantized axis, so the stored cone still holds every normal
+        const Vec3 Axis = NormalSum.NormalizedOr(Vec3::sZero());
+        s8 QuantizedAxis[3];
+        for (u32 i = 0; i < 3; ++i)
+        {
+            QuantizedAxis[i] = s8(std::round(Axis[i] * 127.0f));
+        }
+        const Vec3 DecodedAxis = Vec3(float(QuantizedAxis[0]), float(QuantizedAxis[1]), float(QuantizedAxis[2])).NormalizedOr(Vec3::sZero());
+        if (NumNormals == 0 || DecodedAxis.IsNearZero())
+            return Bounds;
+
+        float MinDot = 1.0f;
+        for (u32 n = 0; n < NumNormals; ++n)
+        {
+            MinDot = std::min(MinDot, Normals[n].Dot(DecodedAxis));
+        }
+
+        // A cone of a hemisphere or more always has a triangle that can face the camera
+        if (MinDot <= 0.0f)
+            return Bounds;
+
+        const float Sine = sqrt(std::max(0.0f, 1.0f - MinDot * MinDot));
+        const float Cutoff = std::ceil(Sine * 127.0f + 1.0e-3f);
+        if (Cutoff >= 127.0f)
+            return Bounds;
+
+        for (u32 i = 0; i < 3; ++i)
+        {
+            Bounds.ConeAxis[i] = QuantizedAxis[i];
+        }
+        Bounds.ConeCutoff = s8(Cutoff);
+        return Bounds;
+    }
+
+    void BuildMeshlets(const u32* pIndices, u32 NumIndices, const Float3* pPositions, u32 NumVertices, FMeshletData& OutData, u32 MaxVertices, u32 MaxTriangles)
+    {
+        // Local indices are 8 bits with NOT_IN_MESHLET reserved, triangle counts are 8 bits
+        ASSERT(MaxVertices >= 3 && MaxVertices < NOT_IN_MESHLET && MaxTriangles >= 1 && MaxTriangles <= 255);
+
+        OutData.Reset();
+        const u32 NumTriangles = NumIndices / 3;
+        if (NumTriangles == 0)
+            return;
+
+        // Triangles around every vertex
+        std::vector<u32> AdjacencyOffsets(size_t(NumVertices) + 1, 0);
+        for (u32 i = 0; i < NumTriangles * 3; ++i)
+        {
+            ASSERT(pIndices[i] < NumVertices);
+            ++AdjacencyOffsets[pIndices[i] + 1];
+        }
+        for (u32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+        {
+            AdjacencyOffsets[Vertex + 1] += AdjacencyOffsets[Vertex];
+        }
+        std::vector<u32> Adjacency(NumTriangles * 3);
+        {
+            std::vector<u32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+            for (u32 i = 0; i < NumTriangles * 3; ++i)
+            {
+                Adjacency[Fill[pIndices[i]]++] = i / 3;
+            }
+        }
+
+        // Built in vectors, then handed to the streams of OutData
+        std::vector<FMeshlet> Meshlets;
+        std::vector<u32> MeshletVertices;
+        std::vector<u32> MeshletTriangles;
+        const u32 ExpectedMeshlets = NumTriangles / MaxTriangles + 1;
+        Meshlets.reserve(ExpectedMeshlets + ExpectedMeshlets / 4);
+        MeshletVertices.reserve(NumVertices + NumVertices / 2);
+        MeshletTriangles.reserve(NumTriangles);
+
+        std::vector<u8> Emitted(NumTriangles, 0);
+        std::vector<u8> IsCandidate(NumTriangles, 0);
+        std::vector<u8> LocalIndex(NumVertices, NOT_IN_MESHLET);
+        std::vector<u32> Candidates;
+
+        FMeshlet Meshlet;
+        Vec3 PositionSum = Vec3::sZero();
+        u32 SeedCursor = 0;
+
+        auto CountNewVertices = [&](u32 Triangle) -> u32
+        {
+            const u32 A = pIndices[Triangle * 3 + 0], B = pIndices[Triangle * 3 + 1], C = pIndices[Triangle * 3 + 2];
+            return u32(LocalIndex[A] == NOT_IN_MESHLET) + u32(LocalIndex[B] == NOT_IN_MESHLET && B != A)
+                + u32(LocalIndex[C] == NOT_IN_MESHLET && C != A && C != B);
+        };
+
+        auto ClearCandidates = [&]()
+        {
+            for (const u32 Triangle : Candidates)
+            {
+                IsCandidate[Triangle] = 0;
+            }
+            Candidates.clear();
+        };
+
+        auto FinishMeshlet = [&]()
+        {
+            for (u32 v = 0; v < Meshlet.NumVertices; ++v)
+            {
+                LocalIndex[MeshletVertices[Meshlet.VertexOffset + v]] = NOT_IN_MESHLET;
+            }
+            Meshlets.push_back(Meshlet);
+
+            Meshlet = FMeshlet();
+            Meshlet.VertexOffset = u32(MeshletVertices.size());
+            Meshlet.TriangleOffset = u32(MeshletTriangles.size());
+            PositionSum = Vec3::sZero();
+            ClearCandidates();
+        };
+
+        for (u32 NumEmitted = 0; NumEmitted < NumTriangles; ++NumEmitted)
+        {
+            // The neighbour that adds the fewest vertices, then the one closest to the center of the meshlet
+            const Vec3 Center = Meshlet.NumVertices > 0 ? PositionSum / float(Meshlet.NumVertices) : Vec3::sZero();
+            u32 Best = INVALID_INDEX, BestNewVertices = 4;
+            float BestDistanceSq = FLT_MAX;
+            u32 NumCandidates = 0;
+            for (const u32 Triangle : Candidates)
+            {
+                if (Emitted[Triangle])
+                {
+                    IsCandidate[Triangle] = 0;
+                    continue;
+                }
+                Candidates[NumCandidates++] = Triangle;
+
+                const u32 NewVertices = CountNewVertices(Triangle);
+                if (NewVertices > BestNewVertices)
+                    continue;
+
+                const Vec3 Centroid = (Vec3(pPositions[pIndices[Triangle * 3 + 0]]) + Vec3(pPositions[pIndices[Triangle * 3 + 1]])
+                    + Vec3(pPositions[pIndices[Triangle * 3 + 2]])) * (1.0f / 3.0f);
+                const float DistanceSq = (Centroid - Center).LengthSq();
+                if (NewVertices < BestNewVertices || DistanceSq < BestDistanceSq)
+                {
+                    Best = Triangle;
+                    BestNewVertices = NewVertices;
+                    BestDistanceSq = DistanceSq;
+                }
+            }
+            Candidates.resize(NumCandidates);
+
+            // Nothing connected left: continue with the next triangle in index order, disconnected pieces can share a meshlet
+            if (Best == INVALID_INDEX)
+            {
+                while (Emitted[SeedCursor])
+                    ++SeedCursor;
+                Best = SeedCursor;
+                BestNewVertices = CountNewVertices(Best);
+            }
+
+            // Best is next to the full meshlet, which makes it a good seed for the next one
+            if (Meshlet.NumVertices + BestNewVertices > MaxVertices || Meshlet.NumTriangles + 1u > MaxTriangles)
+            {
+                FinishMeshlet();
+            }
+
+            Emitted[Best] = 1;
+            u32 PackedTriangle = 0;
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const u32 Vertex = pIndices[Best * 3 + k];
+                if (LocalIndex[Vertex] == NOT_IN_MESHLET)
+                {
+                    LocalIndex[Vertex] = Meshlet.NumVertices++;
+                    MeshletVertices.push_back(Vertex);
+                    PositionSum += Vec3(pPositions[Vertex]);
+
+                    for (u32 a = AdjacencyOffsets[Vertex]; a < AdjacencyOffsets[Vertex + 1]; ++a)
+                    {
+                        const u32 Neighbour = Adjacency[a];
+                        if (!Emitted[Neighbour] && !IsCandidate[Neighbour])
+                        {
+                            IsCandidate[Neighbour] = 1;
+                            Candidates.push_back(Neighbour);
+                        }
+                    }
+                }
+                PackedTriangle |= u32(LocalIndex[Vertex]) << (8 * k);
+            }
+            MeshletTriangles.push_back(PackedTriangle);
+            ++Meshlet.NumTriangles;
+        }
+        FinishMeshlet();
+
+        std::vector<FMeshletBounds> Bounds(Meshlets.size());
+        for (size_t m = 0; m < Meshlets.size(); ++m)
+        {
+            Bounds[m] = sComputeBounds(MeshletVertices.data(), MeshletTriangles.data(), Meshlets[m], pPositions);
+        }
+
+        OutData.Meshlets.Assign(std::move(Meshlets));
+        OutData.Bounds.Assign(std::move(Bounds));
+        OutData.Vertices.Assign(std::move(MeshletVertices));
+        OutData.Triangles.Assign(std::move(MeshletTriangles));
+    }
+
+    u32 CullMeshlets(const FMeshletData& Data, const Frustum& ViewFrustum, const Float3& CameraPosition, u32* pOutVisible)
+    {
+        const Vec3 Camera(CameraPosition);
+        u32 NumVisible = 0;
+        for (u32 m = 0; m < Data.Bounds.Num(); ++m)
+        {
+            const FMeshletBounds& Bounds = Data.Bounds[m];
+            const Vec3 Center(Bounds.Center);
+            if (!ViewFrustum.Overlaps(Sphere(Center, Bounds.Radius)))
+                continue;
+
+            // Back facing when every direction from the camera into the sphere is within 90 degrees of every normal in the cone:
+            // the angle to the axis must stay below 90 - half angle, widened by the radius on both sides
+            if (Bounds.ConeCutoff < 127)
+            {
+                const Vec3 Axis = Vec3(float(Bounds.ConeAxis[0]), float(Bounds.ConeAxis[1]), float(Bounds.ConeAxis[2])).Normalized();
+                const Vec3 ToCenter = Center - Camera;
+                const float Sine = float(Bounds.ConeCutoff) * (1.0f / 127.0f);
+                if (ToCenter.Dot(Axis) >= Sine * (ToCenter.Length() + Bounds.Radius) + Bounds.Radius)
+                    continue;
+            }
+
+            pOutVisible[NumVisible++] = m;
+        }
+        return NumVisible;
+    }
+}
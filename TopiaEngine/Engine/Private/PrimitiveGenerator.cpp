@@ -0,0 +1,724 @@
+#include <PrimitiveGenerator.h>
+
+#include <TopiaMath.h>
+#include <Trigonometry.h>
+#include <Vec3.h>
+
+#include <cstring>
+
+namespace topia
+{
+    FPrimitiveDesc::FPrimitiveDesc(EPrimitiveType InType) : Type(InType)
+    {
+        switch (InType)
+        {
+        case EPrimitiveType::Icosphere:
+            Subdivisions = 8;
+            break;
+        case EPrimitiveType::Cylinder:
+            Rings = 1;
+            break;
+        case EPrimitiveType::Capsule:
+            Rings = 8;
+            break;
+        case EPrimitiveType::Torus:
+            Segments = 48;
+            Rings = 24;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /** Clamp the tessellation to the minimum that gives a closed shape */
+    static FPrimitiveDesc sSanitize(const FPrimitiveDesc& Desc)
+    {
+        FPrimitiveDesc Result = Desc;
+        Result.Segments = std::max(Desc.Segments, 3u);
+        Result.Rings = std::max(Desc.Rings, Desc.Type == EPrimitiveType::Sphere ? 2u : Desc.Type == EPrimitiveType::Torus ? 3u : 1u);
+        Result.Subdivisions = std::max(Desc.Subdivisions, 1u);
+        return Result;
+    }
+
+    FPrimitiveCounts GetPrimitiveCounts(const FPrimitiveDesc& InDesc)
+    {
+        const FPrimitiveDesc Desc = sSanitize(InDesc);
+        const u64 S = Desc.Subdivisions;
+        const u64 Segments = Desc.Segments;
+        const u64 Rings = Desc.Rings;
+
+        u64 NumVertices = 0, NumIndices = 0;
+        switch (Desc.Type)
+        {
+        case EPrimitiveType::Plane:
+            NumVertices = (S + 1) * (S + 1);
+            NumIndices = 6 * S * S;
+            break;
+        case EPrimitiveType::Cube:
+            NumVertices = 6 * (S + 1) * (S + 1);
+            NumIndices = 36 * S * S;
+            break;
+        case EPrimitiveType::Sphere:
+            // The pole rows have a vertex per triangle, one less than the other rows
+            NumVertices = (Segments + 1) * (Rings + 1) - 2;
+            NumIndices = 6 * Segments * (Rings - 1);
+            break;
+        case EPrimitiveType::Icosphere:
+            // Shared grid of 10 S^2 + 2 vertices, 3 S - 1 duplicates along the texture seam and 5 copies of each pole instead of 1
+            NumVertices = 10 * S * S + 3 * S + 9;
+            NumIndices = 60 * S * S;
+            break;
+        case EPrimitiveType::Cylinder:
+            NumVertices = (Segments + 1) * (Rings + 1) + 2 * (Segments + 1);
+            NumIndices = 6 * Segments * Rings + 6 * Segments;
+            break;
+        case EPrimitiveType::Capsule:
+            NumVertices = (Segments + 1) * 2 * (Rings + 1) - 2;
+            NumIndices = 12 * Segments * Rings;
+            break;
+        case EPrimitiveType::Torus:
+            NumVertices = (Segments + 1) * (Rings + 1);
+            NumIndices = 6 * Segments * Rings;
+            break;
+        default:
+            break;
+        }
+
+        ASSERT(NumVertices <= 0xffffffffu && NumIndices <= 0xffffffffu, "Tessellation too high");
+
+        FPrimitiveCounts Counts;
+        Counts.NumVertices = u32(NumVertices);
+        Counts.NumIndices = u32(NumIndices);
+        return Counts;
+    }
+
+    /** Writes a vertex to the streams that are set */
+    class FVertexWriter
+    {
+    public:
+        explicit FVertexWriter(const FPrimitiveStreams& InStreams) : Streams(InStreams) {}
+
+        TOPIA_INLINE void Write(u32 Index, const Float3& Position, const Float3& Normal, const Float3& Tangent, float U, float V) const
+        {
+            if (Streams.pPositions != nullptr)
+                Streams.pPositions[Index] = Position;
+            if (Streams.pNormals != nullptr)
+                Streams.pNormals[Index] = Normal;
+            if (Streams.pTangents != nullptr)
+                Streams.pTangents[Index] = Float4(Tangent.x, Tangent.y, Tangent.z, 1.0f);
+            if (Streams.pTexCoords != nullptr)
+                Streams.pTexCoords[Index] = Float2(U, V);
+        }
+
+    private:
+        FPrimitiveStreams Streams;
+    };
+
+    static Float3 sToFloat3(Vec3Arg V)
+    {
+        return Float3(V.GetX(), V.GetY(), V.GetZ());
+    }
+
+    /** Two triangles per cell of a grid with NumCellsU x NumCellsV cells where vertex (i, j) is at Base + j * (NumCellsU + 1) + i */
+    template <typename T>
+    static T* sGridIndices(T* pOut, u32 Base, u32 NumCellsU, u32 NumCellsV)
+    {
+        const u32 Stride = NumCellsU + 1;
+        for (u32 j = 0; j < NumCellsV; ++j)
+        {
+            for (u32 i = 0; i < NumCellsU; ++i)
+            {
+                const u32 a = Base + j * Stride + i, b = a + 1, c = a + Stride, d = c + 1;
+                *pOut++ = T(a); *pOut++ = T(c); *pOut++ = T(b);
+                *pOut++ = T(b); *pOut++ = T(c); *pOut++ = T(d);
+            }
+        }
+        return pOut;
+    }
+
+    /**
+     * Flat grid of (S + 1)^2 vertices at Center + (u - 0.5) * AxisU + (v - 0.5) * AxisV. cross(AxisV, AxisU) must point towards
+     * Normal, that makes the triangles of sGridIndices face front.
+     */
+    static void sGridVertices(const FVertexWriter& Writer, u32 Base, u32 S, Vec3Arg Center, Vec3Arg AxisU, Vec3Arg AxisV, Vec3Arg Normal)
+    {
+        const Float3 FaceNormal = sToFloat3(Normal);
+        const Float3 Tangent = sToFloat3(AxisU.Normalized());
+        const float Step = 1.0f / float(S);
+        for (u32 j = 0; j <= S; ++j)
+        {
+            // Offsets from the center as (2 j - S) / 2 S are exactly mirrored for j and S - j, so the cube faces that share an edge
+            // (running along it in opposite directions) produce bitwise identical positions there. Starting from +0 turns the
+            // negative zeros of a negated axis into positive ones, which would otherwise differ bitwise as well.
+            const float V = float(j) * Step;
+            const Vec3 Row = Vec3::sZero() + Center + (float(int(2 * j) - int(S)) / float(2 * S)) * AxisV;
+            for (u32 i = 0; i <= S; ++i)
+            {
+                const float U = float(i) * Step;
+                const Vec3 Position = Row + (float(int(2 * i) - int(S)) / float(2 * S)) * AxisU;
+                Writer.Write(Base + j * (S + 1) + i, sToFloat3(Position), FaceNormal, Tangent, U, V);
+            }
+        }
+    }
+
+    /** Sine and cosine of the angle of every column around the Y axis, the last column equals the first to close the seam exactly */
+    static std::vector<Float2> sColumnAngles(u32 Segments)
+    {
+        std::vector<Float2> Columns(Segments + 1);
+        for (u32 i = 0; i < Segments; ++i)
+        {
+            const float Angle = twopi * float(i) / float(Segments);
+            Columns[i] = Float2(Sin(Angle), Cos(Angle));
+        }
+        Columns[Segments] = Columns[0];
+        return Columns;
+    }
+
+    /** A row of a surface of revolution */
+    struct FProfilePoint
+    {
+        float Radius;       // Distance to the Y axis
+        float Y;
+        float NormalRadius; // Normal in the plane of the profile
+        float NormalY;
+        float V;
+    };
+
+    /** First vertex of row r of sRevolutionVertices, with bPoles the top row is one vertex shorter than the others */
+    static TOPIA_INLINE u32 sRevolutionRowStart(u32 r, u32 Segments, bool bPoles)
+    {
+        return r * (Segments + 1) - (bPoles && r > 0 ? 1 : 0);
+    }
+
+    /**
+     * Vertices of a surface of revolution: row r is Profile(r) rotated by the column angles, u runs around the Y axis. Rows must go
+     * from top to bottom on the outside of the surface for the triangles to face outwards. With bPoles the first and last rows have
+     * radius 0 and only Segments vertices, one per triangle with the u of the middle of the triangle.
+     */
+    template <typename ProfileFunc>
+    static void sRevolutionVertices(const FVertexWriter& Writer, u32 Base, const std::vector<Float2>& Columns, u32 NumRows, bool bPoles, const ProfileFunc& Profile)
+    {
+        const u32 Segments = u32(Columns.size()) - 1;
+        const float Step = 1.0f / float(Segments);
+        for (u32 r = 0; r < NumRows; ++r)
+        {
+            const FProfilePoint Point = Profile(r);
+            const bool bPole = bPoles && (r == 0 || r == NumRows - 1);
+            const u32 RowStart = sRevolutionRowStart(r, Segments, bPoles);
+            for (u32 i = 0; i < (bPole ? Segments : Segments + 1); ++i)
+            {
+                float U = float(i) * Step;
+                float S = Columns[i].x, C = Columns[i].y;
+                if (bPole)
+                {
+                    U = (float(i) + 0.5f) * Step;
+                    S = Sin(twopi * U);
+                    C = Cos(twopi * U);
+                }
+
+                Writer.Write(Base + RowStart + i,
+                    Float3(Point.Radius * C, Point.Y, -Point.Radius * S),
+                    Float3(Point.NormalRadius * C, Point.NormalY, -Point.NormalRadius * S),
+                    Float3(-S, 0.0f, -C),
+                    U, Point.V);
+            }
+        }
+    }
+
+    /** Triangles of sRevolutionVertices, the bands next to the poles have one triangle per column */
+    template <typename T>
+    static T* sRevolutionIndices(T* pOut, u32 Base, u32 Segments, u32 NumRows, bool bPoles)
+    {
+        if (!bPoles)
+        {
+            return sGridIndices(pOut, Base, Segments, NumRows - 1);
+        }
+
+        const u32 FirstRow = Base + sRevolutionRowStart(1, Segments, true);
+        for (u32 i = 0; i < Segments; ++i)
+        {
+            const u32 a = Base + i, c = FirstRow + i, d = c + 1;
+            *pOut++ = T(a); *pOut++ = T(c); *pOut++ = T(d);
+        }
+
+        pOut = sGridIndices(pOut, FirstRow, Segments, NumRows - 3);
+
+        const u32 LastRow = Base + sRevolutionRowStart(NumRows - 2, Segments, true);
+        const u32 BottomPole = Base + sRevolutionRowStart(NumRows - 1, Segments, true);
+        for (u32 i = 0; i < Segments; ++i)
+        {
+            const u32 a = LastRow + i, b = a + 1, c = BottomPole + i;
+            *pOut++ = T(a); *pOut++ = T(c); *pOut++ = T(b);
+        }
+        return pOut;
+    }
+
+    /** Icosahedron with a vertex at each pole, the subdivided faces are projected onto the sphere */
+    class FIcosphere
+    {
+    public:
+        static constexpr u32 NUM_FACES = 20;
+        static constexpr u32 NUM_EDGES = 30;
+        static constexpr u32 TOP = 10;
+        static constexpr u32 BOTTOM = 11;
+
+        /**
+         * Corners 0-4 are the upper ring at 72 degree steps starting at +X, 5-9 the lower ring rotated by 36 degrees. Faces are in groups
+         * of 5: top cap, upper band, lower band, bottom cap, all with a pole at corner 0. The texture seam runs along the edges
+         * top - 0 - 5 - bottom, the last face of each group lies on the far side of it (u > 1 near the seam).
+         */
+        explicit FIcosphere(u32 InN) : N(InN)
+        {
+            const float RingY = 1.0f / sqrt(5.0f);
+            const float RingRadius = 2.0f / sqrt(5.0f);
+            for (u32 k = 0; k < 5; ++k)
+            {
+                const float Upper = twopi * float(k) / 5.0f;
+                const float Lower = Upper + twopi / 10.0f;
+                Corners[k] = Vec3(RingRadius * Cos(Upper), RingY, -RingRadius * Sin(Upper));
+                Corners[5 + k] = Vec3(RingRadius * Cos(Lower), -RingY, -RingRadius * Sin(Lower));
+
+                const u32 Next = (k + 1) % 5;
+                SetFace(k, TOP, k, Next);
+                SetFace(5 + k, k, 5 + k, Next);
+                SetFace(10 + k, 5 + k, 5 + Next, Next);
+                SetFace(15 + k, BOTTOM, 5 + Next, 5 + k);
+            }
+            Corners[TOP] = Vec3(0.0f, 1.0f, 0.0f);
+            Corners[BOTTOM] = Vec3(0.0f, -1.0f, 0.0f);
+
+            // Number the edges and find the faces next to them
+            memset(EdgeIds, 0xff, sizeof(EdgeIds));
+            u32 NumEdges = 0;
+            for (u32 f = 0; f < NUM_FACES; ++f)
+            {
+                for (u32 e = 0; e < 3; ++e)
+                {
+                    const u32 a = std::min(Faces[f][e], Faces[f][(e + 1) % 3]), b = std::max(Faces[f][e], Faces[f][(e + 1) % 3]);
+                    if (EdgeIds[a][b] == 0xff)
+                    {
+                        EdgeIds[a][b] = EdgeIds[b][a] = u8(NumEdges);
+                        Edges[NumEdges] = { { u8(a), u8(b) }, 0, false, 0, 0 };
+                        ++NumEdges;
+                    }
+
+                    // An edge belongs to the far side of the seam when both its faces do
+                    FEdge& Edge = Edges[EdgeIds[a][b]];
+                    Edge.bWest = (Edge.NumFaces == 0 || Edge.bWest) && IsWest(f);
+                    ++Edge.NumFaces;
+                }
+            }
+            ASSERT(NumEdges == NUM_EDGES);
+
+            SetPathEdge(TOP, 0, 0);
+            SetPathEdge(0, 5, N);
+            SetPathEdge(5, BOTTOM, 2 * N);
+
+            EdgeBase = 10;
+            NumFaceInterior = (N - 1) * (N - 2) / 2;
+            FaceBase = EdgeBase + NUM_EDGES * (N - 1);
+            SeamBase = FaceBase + NUM_FACES * NumFaceInterior;
+            PoleBase = SeamBase + 3 * N - 1;
+        }
+
+        void WriteVertices(const FVertexWriter& Writer, float Radius) const
+        {
+            FVertexBatch Batch(Writer, Radius);
+
+            // Ring corners, 0 and 5 also lie on the seam
+            for (u32 c = 0; c < 10; ++c)
+            {
+                Batch.Add(c, Corners[c], false);
+            }
+            Batch.Add(SeamBase + N - 1, Corners[0], true);
+            Batch.Add(SeamBase + 2 * N - 1, Corners[5], true);
+
+            // Edges
+            for (u32 e = 0; e < NUM_EDGES; ++e)
+            {
+                const FEdge& Edge = Edges[e];
+                const Vec3 A = Corners[Edge.Corners[0]], B = Corners[Edge.Corners[1]];
+                for (u32 k = 1; k < N; ++k)
+                {
+                    const Vec3 Dir = (A * float(N - k) + B * float(k)).Normalized();
+                    Batch.Add(EdgeBase + e * (N - 1) + k - 1, Dir, Edge.bWest);
+                    if (Edge.bPath)
+                    {
+                        Batch.Add(GetSeamIndex(Edge, Edge.Corners[0], k), Dir, true);
+                    }
+                }
+            }
+
+            // Face interiors
+            for (u32 f = 0; f < NUM_FACES; ++f)
+            {
+                const Vec3 A = Corners[Faces[f][0]], B = Corners[Faces[f][1]], C = Corners[Faces[f][2]];
+                u32 Index = FaceBase + f * NumFaceInterior;
+                for (u32 j = 1; j + 1 < N; ++j)
+                {
+                    for (u32 i = 1; i + j < N; ++i)
+                    {
+                        const Vec3 Dir = (A * float(N - i - j) + B * float(i) + C * float(j)).Normalized();
+                        Batch.Add(Index++, Dir, IsWest(f));
+                    }
+                }
+            }
+
+            // A copy of the pole per cap face, with the u of the middle of the face
+            for (u32 k = 0; k < 5; ++k)
+            {
+                WritePole(Writer, PoleBase + k, Radius, (float(k) + 0.5f) / 5.0f, 0.0f);
+                WritePole(Writer, PoleBase + 5 + k, Radius, float(k + 1) / 5.0f, 1.0f);
+            }
+        }
+
+        template <typename T>
+        T* WriteIndices(T* pOut) const
+        {
+            for (u32 f = 0; f < NUM_FACES; ++f)
+            {
+                for (u32 j = 0; j < N; ++j)
+                {
+                    for (u32 i = 0; i + j < N; ++i)
+                    {
+                        const u32 a = MapVertex(f, i, j), b = MapVertex(f, i + 1, j), c = MapVertex(f, i, j + 1);
+                        *pOut++ = T(a); *pOut++ = T(b); *pOut++ = T(c);
+                        if (i + j + 1 < N)
+                        {
+                            *pOut++ = T(b); *pOut++ = T(MapVertex(f, i + 1, j + 1)); *pOut++ = T(c);
+                        }
+                    }
+                }
+            }
+            return pOut;
+        }
+
+    private:
+        struct FEdge
+        {
+            u8 Corners[2];  // Lowest corner first, edge vertices are numbered from it
+            u8 NumFaces;
+            bool bWest;
+            bool bPath;     // Lies on the seam, its vertices are duplicated
+            u8 PathFrom;    // Corner where the edge's part of the seam starts
+            u32 PathStart;  // Position of the corner PathFrom along the seam
+        };
+
+        /** Computes the texture coordinates of vertices on the sphere 4 at a time and writes them */
+        class FVertexBatch
+        {
+        public:
+            FVertexBatch(const FVertexWriter& InWriter, float InRadius) : Writer(InWriter), Radius(InRadius) {}
+            ~FVertexBatch() { Flush(); }
+
+            void Add(u32 Index, Vec3Arg Dir, bool bWest)
+            {
+                Indices[Num] = Index;
+                Dirs[Num] = Dir;
+                West[Num] = bWest;
+                if (++Num == 4)
+                    Flush();
+            }
+
+            void Flush()
+            {
+                if (Num == 0)
+                    return;
+                for (u32 k = Num; k < 4; ++k)
+                    Dirs[k] = Dirs[0];
+
+                // Equirectangular mapping, vertices on the far side of the seam continue past u = 1
+                const Vec4 X(Dirs[0].GetX(), Dirs[1].GetX(), Dirs[2].GetX(), Dirs[3].GetX());
+                const Vec4 Y(Dirs[0].GetY(), Dirs[1].GetY(), Dirs[2].GetY(), Dirs[3].GetY());
+                const Vec4 Z(Dirs[0].GetZ(), Dirs[1].GetZ(), Dirs[2].GetZ(), Dirs[3].GetZ());
+                const Vec4 U = Vec4::sATan2(-Z, X) * (1.0f / twopi);
+                const Vec4 V = Vec4::sMin(Vec4::sMax(Y, Vec4::sReplicate(-1.0f)), Vec4::sReplicate(1.0f)).ACos() * invpi;
+
+                for (u32 k = 0; k < Num; ++k)
+                {
+                    float u = U[k];
+                    if (u < 0.0f)
+                        u += 1.0f;
+                    if (West[k] && u < 0.5f)
+                        u += 1.0f;
+
+                    // Pointing along increasing u, around the Y axis
+                    const float x = X[k], y = Y[k], z = Z[k];
+                    const float InvHorizontal = 1.0f / sqrt(x * x + z * z);
+                    Writer.Write(Indices[k], Float3(x * Radius, y * Radius, z * Radius), Float3(x, y, z), Float3(z * InvHorizontal, 0.0f, -x * InvHorizontal), u, V[k]);
+                }
+                Num = 0;
+            }
+
+        private:
+            const FVertexWriter& Writer;
+            float Radius;
+            u32 Num = 0;
+            u32 Indices[4];
+            Vec3 Dirs[4];
+            bool West[4];
+        };
+
+        static bool IsWest(u32 Face) { return Face % 5 == 4; }
+
+        void SetFace(u32 Face, u32 A, u32 B, u32 C)
+        {
+            Faces[Face][0] = A;
+            Faces[Face][1] = B;
+            Faces[Face][2] = C;
+        }
+
+        void SetPathEdge(u32 From, u32 To, u32 Start)
+        {
+            FEdge& Edge = Edges[EdgeIds[From][To]];
+            Edge.bPath = true;
+            Edge.PathFrom = u8(From);
+            Edge.PathStart = Start;
+        }
+
+        /** Seam copy of the vertex k steps from corner From along a path edge */
+        u32 GetSeamIndex(const FEdge& Edge, u32 From, u32 k) const
+        {
+            const u32 Steps = From == Edge.PathFrom ? k : N - k;
+            return SeamBase + Edge.PathStart + Steps - 1;
+        }
+
+        void WritePole(const FVertexWriter& Writer, u32 Index, float Radius, float U, float V) const
+        {
+            const float Y = V == 0.0f ? 1.0f : -1.0f;
+            Writer.Write(Index, Float3(0.0f, Y * Radius, 0.0f), Float3(0.0f, Y, 0.0f), Float3(-Sin(twopi * U), 0.0f, -Cos(twopi * U)), U, V);
+        }
+
+        /** Index of the vertex k steps from corner From towards corner To, as seen from face Face */
+        u32 MapEdgeVertex(u32 Face, u32 From, u32 To, u32 k) const
+        {
+            const FEdge& Edge = Edges[EdgeIds[From][To]];
+            if (Edge.bPath && IsWest(Face))
+            {
+                return GetSeamIndex(Edge, From, k);
+            }
+            return EdgeBase + EdgeIds[From][To] * (N - 1) + (From == Edge.Corners[0] ? k : N - k) - 1;
+        }
+
+        u32 MapCorner(u32 Face, u32 Corner) const
+        {
+            if (Corner == TOP)
+                return PoleBase + Face;
+            if (Corner == BOTTOM)
+                return PoleBase + 5 + Face - 15;
+            if (IsWest(Face) && Corner == 0)
+                return SeamBase + N - 1;
+            if (IsWest(Face) && Corner == 5)
+                return SeamBase + 2 * N - 1;
+            return Corner;
+        }
+
+        /** Vertex index of grid point (i, j) of a face, i steps towards corner 1 and j towards corner 2 */
+        u32 MapVertex(u32 Face, u32 i, u32 j) const
+        {
+            const u32* F = Faces[Face];
+            if (j == 0)
+            {
+                return i == 0 ? MapCorner(Face, F[0]) : i == N ? MapCorner(Face, F[1]) : MapEdgeVertex(Face, F[0], F[1], i);
+            }
+            if (i == 0)
+            {
+                return j == N ? MapCorner(Face, F[2]) : MapEdgeVertex(Face, F[0], F[2], j);
+            }
+            if (i + j == N)
+            {
+                return MapEdgeVertex(Face, F[1], F[2], j);
+            }
+
+            // Interior, rows of increasing j
+            return FaceBase + Face * NumFaceInterior + (j - 1) * (N - 1) - (j - 1) * j / 2 + i - 1;
+        }
+
+        u32 N;
+        Vec3 Corners[12];
+        u32 Faces[NUM_FACES][3];
+        FEdge Edges[NUM_EDGES];
+        u8 EdgeIds[12][12];
+
+        u32 EdgeBase;
+        u32 NumFaceInterior;
+        u32 FaceBase;
+        u32 SeamBase;
+        u32 PoleBase;
+    };
+
+    static void sGenerateVertices(const FPrimitiveDesc& Desc, const FVertexWriter& Writer)
+    {
+        const u32 Segments = Desc.Segments;
+        const u32 Rings = Desc.Rings;
+        const u32 S = Desc.Subdivisions;
+
+        switch (Desc.Type)
+        {
+        case EPrimitiveType::Plane:
+            sGridVertices(Writer, 0, S, Vec3::sZero(), Vec3(Desc.Size.x, 0, 0), Vec3(0, 0, Desc.Size.z), Vec3(0, 1, 0));
+            break;
+
+        case EPrimitiveType::Cube:
+        {
+            // Seen from outside every face has u to the right and v down (v towards -Z on the top face, +Z on the bottom face)
+            const Vec3 X(Desc.Size.x, 0, 0), Y(0, Desc.Size.y, 0), Z(0, 0, Desc.Size.z);
+            const u32 FaceSize = (S + 1) * (S + 1);
+            sGridVertices(Writer, 0 * FaceSize, S, 0.5f * X, -Z, -Y, Vec3(1, 0, 0));
+            sGridVertices(Writer, 1 * FaceSize, S, -0.5f * X, Z, -Y, Vec3(-1, 0, 0));
+            sGridVertices(Writer, 2 * FaceSize, S, 0.5f * Y, X, Z, Vec3(0, 1, 0));
+            sGridVertices(Writer, 3 * FaceSize, S, -0.5f * Y, X, -Z, Vec3(0, -1, 0));
+            sGridVertices(Writer, 4 * FaceSize, S, 0.5f * Z, X, -Y, Vec3(0, 0, 1));
+            sGridVertices(Writer, 5 * FaceSize, S, -0.5f * Z, -X, -Y, Vec3(0, 0, -1));
+            break;
+        }
+
+        case EPrimitiveType::Sphere:
+        {
+            const float Radius = Desc.Radius;
+            sRevolutionVertices(Writer, 0, sColumnAngles(Segments), Rings + 1, true, [Radius, Rings](u32 r)
+            {
+                const float Theta = pi * float(r) / float(Rings);
+                const float S = r == Rings ? 0.0f : Sin(Theta), C = Cos(Theta);
+                return FProfilePoint { Radius * S, Radius * C, S, C, float(r) / float(Rings) };
+            });
+            break;
+        }
+
+        case EPrimitiveType::Icosphere:
+            FIcosphere(S).WriteVertices(Writer, Desc.Radius);
+            break;
+
+        case EPrimitiveType::Cylinder:
+        {
+            const float Radius = Desc.Radius, HalfHeight = 0.5f * Desc.Height;
+            const std::vector<Float2> Columns = sColumnAngles(Segments);
+            sRevolutionVertices(Writer, 0, Columns, Rings + 1, false, [Radius, HalfHeight, Rings](u32 r)
+            {
+                const float V = float(r) / float(Rings);
+                return FProfilePoint { Radius, HalfHeight - 2.0f * HalfHeight * V, 1.0f, 0.0f, V };
+            });
+
+            // Caps: a center and a ring, mapped like a plane seen from outside
+            const u32 TopBase = (Segments + 1) * (Rings + 1), BottomBase = TopBase + Segments + 1;
+            const float UVScale = 0.5f / Radius;
+            Writer.Write(TopBase, Float3(0, HalfHeight, 0), Float3(0, 1, 0), Float3(1, 0, 0), 0.5f, 0.5f);
+            Writer.Write(BottomBase, Float3(0, -HalfHeight, 0), Float3(0, -1, 0), Float3(1, 0, 0), 0.5f, 0.5f);
+            for (u32 i = 0; i < Segments; ++i)
+            {
+                const float X = Radius * Columns[i].y, Z = -Radius * Columns[i].x;
+                Writer.Write(TopBase + 1 + i, Float3(X, HalfHeight, Z), Float3(0, 1, 0), Float3(1, 0, 0), 0.5f + X * UVScale, 0.5f + Z * UVScale);
+                Writer.Write(BottomBase + 1 + i, Float3(X, -HalfHeight, Z), Float3(0, -1, 0), Float3(1, 0, 0), 0.5f + X * UVScale, 0.5f - Z * UVScale);
+            }
+            break;
+        }
+
+        case EPrimitiveType::Capsule:
+        {
+            // Two hemispheres of Rings + 1 rows, the band between their equators is the straight part. v follows the length of the profile.
+            const float Radius = Desc.Radius, HalfHeight = 0.5f * Desc.Height;
+            const float QuarterArc = halfpi * Radius;
+            const float InvLength = 1.0f / (2.0f * QuarterArc + Desc.Height);
+            sRevolutionVertices(Writer, 0, sColumnAngles(Segments), 2 * (Rings + 1), true, [=](u32 r)
+            {
+                const bool bBottom = r > Rings;
+                const u32 k = bBottom ? r - Rings - 1 : r;
+                const float Theta = halfpi * (float(k) / float(Rings) + (bBottom ? 1.0f : 0.0f));
+                const float S = r == 2 * Rings + 1 ? 0.0f : Sin(Theta), C = Cos(Theta);
+                const float Arc = Radius * Theta + (bBottom ? Desc.Height : 0.0f);
+                return FProfilePoint { Radius * S, (bBottom ? -HalfHeight : HalfHeight) + Radius * C, S, C, Arc * InvLength };
+            });
+            break;
+        }
+
+        case EPrimitiveType::Torus:
+        {
+            // The profile starts at the top of the tube and goes around it outwards first
+            const float Radius = Desc.Radius, TubeRadius = Desc.TubeRadius;
+            sRevolutionVertices(Writer, 0, sColumnAngles(Segments), Rings + 1, false, [Radius, TubeRadius, Rings](u32 r)
+            {
+                const float Psi = halfpi - twopi * float(r % Rings) / float(Rings);
+                const float S = Sin(Psi), C = Cos(Psi);
+                return FProfilePoint { Radius + TubeRadius * C, TubeRadius * S, C, S, float(r) / float(Rings) };
+            });
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    template <typename T>
+    static void sGenerateIndices(const FPrimitiveDesc& Desc, T* pOut)
+    {
+        const u32 Segments = Desc.Segments;
+        const u32 Rings = Desc.Rings;
+        const u32 S = Desc.Subdivisions;
+
+        switch (Desc.Type)
+        {
+        case EPrimitiveType::Plane:
+            sGridIndices(pOut, 0, S, S);
+            break;
+
+        case EPrimitiveType::Cube:
+            for (u32 Face = 0; Face < 6; ++Face)
+            {
+                pOut = sGridIndices(pOut, Face * (S + 1) * (S + 1), S, S);
+            }
+            break;
+
+        case EPrimitiveType::Sphere:
+            sRevolutionIndices(pOut, 0, Segments, Rings + 1, true);
+            break;
+
+        case EPrimitiveType::Icosphere:
+            FIcosphere(S).WriteIndices(pOut);
+            break;
+
+        case EPrimitiveType::Cylinder:
+        {
+            pOut = sGridIndices(pOut, 0, Segments, Rings);
+
+            const u32 TopBase = (Segments + 1) * (Rings + 1), BottomBase = TopBase + Segments + 1;
+            for (u32 i = 0; i < Segments; ++i)
+            {
+                const u32 Next = (i + 1) % Segments;
+                *pOut++ = T(TopBase); *pOut++ = T(TopBase + 1 + i); *pOut++ = T(TopBase + 1 + Next);
+                *pOut++ = T(BottomBase); *pOut++ = T(BottomBase + 1 + Next); *pOut++ = T(BottomBase + 1 + i);
+            }
+            break;
+        }
+
+        case EPrimitiveType::Capsule:
+            sRevolutionIndices(pOut, 0, Segments, 2 * (Rings + 1), true);
+            break;
+
+        case EPrimitiveType::Torus:
+            sRevolutionIndices(pOut, 0, Segments, Rings + 1, false);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void GeneratePrimitive(const FPrimitiveDesc& InDesc, const FPrimitiveStreams& Streams)
+    {
+        const FPrimitiveDesc Desc = sSanitize(InDesc);
+        ASSERT((Streams.pIndices16 != nullptr) != (Streams.pIndices32 != nullptr), "Exactly one index stream must be set");
+        ASSERT(Streams.pIndices16 == nullptr || GetPrimitiveCounts(Desc).NumVertices <= 0x10000, "Too many vertices for 16 bit indices");
+
+        sGenerateVertices(Desc, FVertexWriter(Streams));
+
+        if (Streams.pIndices16 != nullptr)
+        {
+            sGenerateIndices(Desc, Streams.pIndices16);
+        }
+        else if (Streams.pIndices32 != nullptr)
+        {
+            sGenerateIndices(Desc, Streams.pIndices32);
+        }
+    }
+}
@@ -1,48 +1,831 @@
 ﻿#include <StaticMesh.h>
 
+#include "GLTFAsset.h"
+
+#include <BVH4.h>
+
+#include <cfloat>
+#include <type_traits>
+
 namespace topia
 {
-    /** Load nothing, initialize relative variables to default. */
-    void LoadPrimitiveEmpty()
+    /** Point the stream into the source file when its layout matches T (NumComponents floats, tightly packed), otherwise decode it */
+    template <typename T, u32 NumComponents>
+    static void sLoadAttribute(const FGLTFAsset& Asset, const FGLTFAsset::FAccessor& Accessor, const float (&Fill)[4], TMeshStream<T>& OutStream)
+    {
+        static_assert(sizeof(T) == NumComponents * sizeof(float), "Stream elements must be tightly packed floats");
+
+        u32 Stride;
+        const u8* pData = Asset.GetAccessorData(Accessor, Stride);
+        if (pData != nullptr && Accessor.ComponentType == FGLTFAsset::Float && Accessor.NumComponents == NumComponents && Stride == sizeof(T)
+            && Accessor.SparseCount == 0 && reinterpret_cast<uintptr_t>(pData) % alignof(T) == 0)
+        {
+            OutStream.SetView(reinterpret_cast<const T*>(pData), Accessor.Count);
+        }
+        else
+        {
+            Asset.ReadFloats(Accessor, NumComponents, Fill, reinterpret_cast<float*>(OutStream.Allocate(Accessor.Count)));
+        }
+    }
+
+    template <typename T>
+    static u32 sFindMaxIndex(const T* pIndices, u32 NumIndices)
+    {
+        T MaxIndex = 0;
+        for (u32 i = 0; i < NumIndices; ++i)
+        {
+            MaxIndex = std::max(MaxIndex, pIndices[i]);
+        }
+        return MaxIndex;
+    }
+
+    /** Load the triangle list of a primitive, 16 bit indices stay 16 bit. Returns an error message or nullptr. */
+    static const char* sLoadIndices(const FGLTFAsset& Asset, const FGLTFAsset::FPrimitive& Primitive, FStaticMeshSection& OutSection)
+    {
+        if (Primitive.Indices == FGLTFAsset::INVALID_INDEX)
+        {
+            // Not indexed, every 3 vertices form a triangle
+            if (OutSection.NumVertices <= 0x10000)
+            {
+                u16* pIndices = OutSection.Indices16.Allocate(OutSection.NumVertices);
+                for (u32 i = 0; i < OutSection.NumVertices; ++i)
+                {
+                    pIndices[i] = u16(i);
+                }
+            }
+            else
+            {
+                u32* pIndices = OutSection.Indices32.Allocate(OutSection.NumVertices);
+                for (u32 i = 0; i < OutSection.NumVertices; ++i)
+                {
+                    pIndices[i] = i;
+                }
+            }
+            return OutSection.NumVertices % 3 == 0 ? nullptr : "Vertex count is not a multiple of 3";
+        }
+
+        const FGLTFAsset::FAccessor& Accessor = Asset.Accessors[Primitive.Indices];
+        if (Accessor.NumComponents != 1 || Accessor.SparseCount != 0)
+        {
+            return "Unsupported index accessor";
+        }
+        if (Accessor.Count % 3 != 0)
+        {
+            return "Index count is not a multiple of 3";
+        }
+
+        u32 Stride;
+        const u8* pData = Asset.GetAccessorData(Accessor, Stride);
+        if (pData == nullptr)
+        {
+            return "Index accessor without buffer view";
+        }
+
+        u32 MaxIndex;
+        switch (Accessor.ComponentType)
+        {
+        case FGLTFAsset::UnsignedByte:
+        {
+            // GPUs have no 8 bit index format
+            u16* pIndices = OutSection.Indices16.Allocate(Accessor.Count);
+            for (u32 i = 0; i < Accessor.Count; ++i)
+            {
+                pIndices[i] = pData[size_t(i) * Stride];
+            }
+            MaxIndex = sFindMaxIndex(pIndices, Accessor.Count);
+            break;
+        }
+
+        case FGLTFAsset::UnsignedShort:
+            if (Stride == sizeof(u16) && reinterpret_cast<uintptr_t>(pData) % alignof(u16) == 0)
+            {
+                OutSection.Indices16.SetView(reinterpret_cast<const u16*>(pData), Accessor.Count);
+            }
+            else
+            {
+                u16* pIndices = OutSection.Indices16.Allocate(Accessor.Count);
+                for (u32 i = 0; i < Accessor.Count; ++i)
+                {
+                    memcpy(&pIndices[i], pData + size_t(i) * Stride, sizeof(u16));
+                }
+            }
+            MaxIndex = sFindMaxIndex(OutSection.Indices16.GetData(), Accessor.Count);
+            break;
+
+        case FGLTFAsset::UnsignedInt:
+            if (Stride == sizeof(u32) && reinterpret_cast<uintptr_t>(pData) % alignof(u32) == 0)
+            {
+                OutSection.Indices32.SetView(reinterpret_cast<const u32*>(pData), Accessor.Count);
+            }
+            else
+            {
+                u32* pIndices = OutSection.Indices32.Allocate(Accessor.Count);
+                for (u32 i = 0; i < Accessor.Count; ++i)
+                {
+                    memcpy(&pIndices[i], pData + size_t(i) * Stride, sizeof(u32));
+                }
+            }
+            MaxIndex = sFindMaxIndex(OutSection.Indices32.GetData(), Accessor.Count);
+            break;
+
+        default:
+            return "Invalid index component type";
+        }
+
+        // Out of range indices would read outside the vertex buffer on the GPU
+        return Accessor.Count == 0 || MaxIndex < OutSection.NumVertices ? nullptr : "Index out of range";
+    }
+
+    static AABox sComputeBounds(const std::vector<FStaticMeshSection>& Sections)
     {
+        AABox Bounds;
+        for (const FStaticMeshSection& Section : Sections)
+        {
+            for (u32 v = 0; v < Section.Positions.Num(); ++v)
+            {
+                Bounds.Encapsulate(Vec3(Section.Positions[v]));
+            }
+        }
+        return Bounds;
     }
 
-    void LoadPrimitivePlane()
+    void FStaticMesh::Reset()
     {
+        Sections.clear();
+        SourceData.clear();
+        LODInfos.clear();
+        Bounds = AABox();
     }
 
-    void LoadPrimitiveCube()
+    void FStaticMesh::SwapGeometry(FStaticMesh& Other)
     {
+        Sections.swap(Other.Sections);
+        SourceData.swap(Other.SourceData);
+        LODInfos.swap(Other.LODInfos);
+        std::swap(Bounds, Other.Bounds);
     }
 
-    /** TODO: Load cube for now. */
-    void LoadPrimitiveSphere()
+    bool FStaticMesh::LoadFromGLTF(const std::wstring& Path, EVertexAttributes RequiredAttributes)
     {
-        LoadPrimitiveCube();
+        Reset();
+
+        FGLTFAsset Asset;
+        if (!Asset.Load(Path))
+        {
+            DEBUGPRINT("LoadFromGLTF: %s", Asset.Error.c_str());
+            return false;
+        }
+        return LoadFromGLTFAsset(Asset, RequiredAttributes);
+    }
+
+    bool FStaticMesh::LoadFromGLTFAsset(const FGLTFAsset& Asset, EVertexAttributes RequiredAttributes)
+    {
+        Reset();
+
+        static const float sFillZero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        static const float sFillTangent[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        static const float sFillColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        Sections.reserve(Asset.Primitives.size());
+        for (const FGLTFAsset::FPrimitive& Primitive : Asset.Primitives)
+        {
+            if (Primitive.Mode != FGLTFAsset::MODE_TRIANGLES || Primitive.Attributes[FGLTFAsset::Position] == FGLTFAsset::INVALID_INDEX)
+            {
+                DEBUGPRINT("LoadFromGLTF: Skipping a primitive that is not a triangle list with positions");
+                continue;
+            }
+
+            FStaticMeshSection Section;
+            Section.NumVertices = Asset.Accessors[Primitive.Attributes[FGLTFAsset::Position]].Count;
+            Section.MaterialIndex = Primitive.Material;
+
+            for (u32 Attribute = 0; Attribute < FGLTFAsset::NumAttributes; ++Attribute)
+            {
+                const u32 AccessorIndex = Primitive.Attributes[Attribute];
+                if (AccessorIndex == FGLTFAsset::INVALID_INDEX || !(RequiredAttributes & EVertexAttributes(1u << Attribute)))
+                {
+                    continue;
+                }
+
+                const FGLTFAsset::FAccessor& Accessor = Asset.Accessors[AccessorIndex];
+                if (Accessor.Count != Section.NumVertices)
+                {
+                    DEBUGPRINT("LoadFromGLTF: Attributes of a primitive have different vertex counts");
+                    Reset();
+                    return false;
+                }
+
+                switch (Attribute)
+                {
+                case FGLTFAsset::Position:  sLoadAttribute<Float3, 3>(Asset, Accessor, sFillZero, Section.Positions); break;
+                case FGLTFAsset::Normal:    sLoadAttribute<Float3, 3>(Asset, Accessor, sFillZero, Section.Normals); break;
+                case FGLTFAsset::Tangent:   sLoadAttribute<Float4, 4>(Asset, Accessor, sFillTangent, Section.Tangents); break;
+                case FGLTFAsset::TexCoord0: sLoadAttribute<Float2, 2>(Asset, Accessor, sFillZero, Section.TexCoords[0]); break;
+                case FGLTFAsset::TexCoord1: sLoadAttribute<Float2, 2>(Asset, Accessor, sFillZero, Section.TexCoords[1]); break;
+                case FGLTFAsset::Color0:    sLoadAttribute<Float4, 4>(Asset, Accessor, sFillColor, Section.Colors); break;
+                default:                    break;
+                }
+            }
+
+            if (const char* pError = sLoadIndices(Asset, Primitive, Section))
+            {
+                DEBUGPRINT("LoadFromGLTF: %s", pError);
+                Reset();
+                return false;
+            }
+
+            Sections.push_back(std::move(Section));
+        }
+
+        // The streams may point into the source files
+        SourceData = Asset.SourceData;
+        Bounds = sComputeBounds(Sections);
+        return true;
     }
 
     void FStaticMesh::LoadPrimitive(EPrimitiveType PrimitiveType)
     {
-        switch (PrimitiveType)
+        LoadPrimitive(FPrimitiveDesc(PrimitiveType));
+    }
+
+    void FStaticMesh::LoadPrimitive(const FPrimitiveDesc& Desc, EVertexAttributes RequiredAttributes)
+    {
+        Reset();
+
+        const FPrimitiveCounts Counts = GetPrimitiveCounts(Desc);
+        if (Counts.NumIndices == 0)
         {
-        case EPrimitiveType::Plane:
-            LoadPrimitivePlane();
-            break;
-        case EPrimitiveType::Cube:
-            LoadPrimitiveCube();
-            break;
-        case EPrimitiveType::Sphere:
-            LoadPrimitiveSphere();
-            break;
-        case EPrimitiveType::None:
-            LoadPrimitiveEmpty();
-            break;
-        default:
-            break;
+            return;
         }
+
+        // The counts are exact, every stream is allocated once and written in place
+        FStaticMeshSection Section;
+        Section.NumVertices = Counts.NumVertices;
+        Section.MaterialIndex = ~0u;
+
+        FPrimitiveStreams Streams;
+        Streams.pPositions = Section.Positions.Allocate(Counts.NumVertices);
+        if (!!(RequiredAttributes & EVertexAttributes::Normal))
+            Streams.pNormals = Section.Normals.Allocate(Counts.NumVertices);
+        if (!!(RequiredAttributes & EVertexAttributes::Tangent))
+            Streams.pTangents = Section.Tangents.Allocate(Counts.NumVertices);
+        if (!!(RequiredAttributes & EVertexAttributes::TexCoord0))
+            Streams.pTexCoords = Section.TexCoords[0].Allocate(Counts.NumVertices);
+
+        if (Counts.NumVertices <= 0x10000)
+            Streams.pIndices16 = Section.Indices16.Allocate(Counts.NumIndices);
+        else
+            Streams.pIndices32 = Section.Indices32.Allocate(Counts.NumIndices);
+
+        GeneratePrimitive(Desc, Streams);
+        Sections.push_back(std::move(Section));
+        Bounds = sComputeBounds(Sections);
+    }
+
+    /** Call Func on every vertex stream of a section */
+    template <typename Func>
+    static void sForEachVertexStream(FStaticMeshSection& Section, const Func& Function)
+    {
+        Function(Section.Positions);
+        Function(Section.Normals);
+        Function(Section.Tangents);
+        Function(Section.TexCoords[0]);
+        Function(Section.TexCoords[1]);
+        Function(Section.Colors);
+    }
+
+    static void sAccumulate(FVertexCacheStats& Total, const FVertexCacheStats& Stats)
+    {
+        Total.NumTriangles += Stats.NumTriangles;
+        Total.NumVertices += Stats.NumVertices;
+        Total.NumTransformed += Stats.NumTransformed;
+        Total.ACMR = Total.NumTriangles > 0 ? float(Total.NumTransformed) / float(Total.NumTriangles) : 0.0f;
+        Total.ATVR = Total.NumVertices > 0 ? float(Total.NumTransformed) / float(Total.NumVertices) : 0.0f;
+    }
+
+    FMeshOptimizeStats FStaticMesh::Optimize(float OverdrawThreshold)
+    {
+        FMeshOptimizeStats Stats;
+        for (FStaticMeshSection& Section : Sections)
+        {
+            const u32 NumVertices = Section.NumVertices;
+            const u32 NumIndices = Section.GetNumIndices();
+            Stats.NumVerticesBefore += NumVertices;
+            if (NumIndices == 0)
+            {
+                Stats.NumVerticesAfter += NumVertices;
+                continue;
+            }
+
+            std::vector<u32> Indices(NumIndices);
+            if (!Section.Indices16.IsEmpty())
+                std::copy(Section.Indices16.GetData(), Section.Indices16.GetData() + NumIndices, Indices.begin());
+            else
+                std::copy(Section.Indices32.GetData(), Section.Indices32.GetData() + NumIndices, Indices.begin());
+
+            sAccumulate(Stats.Before, AnalyzeVertexCache(Indices.data(), NumIndices, NumVertices));
+
+            // Merge vertices that are equal in every stream
+            FVertexStreamRef StreamRefs[6];
+            u32 NumStreams = 0;
+            sForEachVertexStream(Section, [&StreamRefs, &NumStreams](const auto& Stream)
+            {
+                if (!Stream.IsEmpty())
+                {
+                    const u32 ElementSize = u32(sizeof(Stream[0]));
+                    StreamRefs[NumStreams].pData = Stream.GetData();
+                    StreamRefs[NumStreams].Size = ElementSize;
+                    StreamRefs[NumStreams].Stride = ElementSize;
+                    ++NumStreams;
+                }
+            });
+
+            std::vector<u32> Remap(NumVertices);
+            const u32 NumUnique = GenerateVertexRemap(StreamRefs, NumStreams, NumVertices, Remap.data());
+            RemapIndices(Indices.data(), NumIndices, Remap.data());
+
+            OptimizeVertexCache(Indices.data(), NumIndices, NumUnique);
+            if (!Section.Positions.IsEmpty())
+            {
+                std::vector<Float3> UniquePositions(NumUnique);
+                RemapVertexStream(UniquePositions.data(), Section.Positions.GetData(), sizeof(Float3), NumVertices, Remap.data());
+                OptimizeOverdraw(Indices.data(), NumIndices, UniquePositions.data(), NumUnique, OverdrawThreshold);
+            }
+
+            // Combine the merge with the fetch order so every stream is copied once
+            std::vector<u32> FetchRemap(NumUnique);
+            const u32 NumUsed = OptimizeVertexFetch(Indices.data(), NumIndices, NumUnique, FetchRemap.data());
+            for (u32& Index : Remap)
+            {
+                Index = FetchRemap[Index];
+            }
+
+            sForEachVertexStream(Section, [&Remap, NumVertices, NumUsed](auto& Stream)
+            {
+                if (!Stream.IsEmpty())
+                {
+                    typename std::remove_reference<decltype(Stream)>::type Remapped;
+                    RemapVertexStream(Remapped.Allocate(NumUsed), Stream.GetData(), u32(sizeof(Stream[0])), NumVertices, Remap.data());
+                    Stream = std::move(Remapped);
+                }
+            });
+            Section.NumVertices = NumUsed;
+            Section.Meshlets.Reset();
+            Section.Quantized.Reset();
+            Section.LODs.clear();
+
+            Section.Indices16.Reset();
+            Section.Indices32.Reset();
+            if (NumUsed <= 0x10000)
+                std::copy(Indices.begin(), Indices.end(), Section.Indices16.Allocate(NumIndices));
+            else
+                std::copy(Indices.begin(), Indices.end(), Section.Indices32.Allocate(NumIndices));
+
+            Stats.NumVerticesAfter += NumUsed;
+            sAccumulate(Stats.After, AnalyzeVertexCache(Indices.data(), NumIndices, NumUsed));
+        }
+
+        LODInfos.clear();
+        return Stats;
+    }
+
+    /** Angle between two directions in degrees */
+    static float sAngleDegrees(Vec3Arg A, Vec3Arg B)
+    {
+        // atan2 stays accurate for small angles, acos of a dot product close to 1 is off by a few hundredths of a degree
+        return std::atan2(A.Cross(B).Length(), A.Dot(B)) * (180.0f / pi);
     }
 
-    void FStaticMesh::LoadFromGLTF()
+    FMeshQuantizeStats FStaticMesh::Quantize(EOctahedralPrecision Precision)
     {
+        FMeshQuantizeStats Stats;
+        for (FStaticMeshSection& Section : Sections)
+        {
+            FQuantizedVertexData& Quantized = Section.Quantized;
+            Quantized.Reset();
+            Quantized.Precision = Precision;
+
+            const u32 NumVertices = Section.NumVertices;
+            if (Section.Positions.IsEmpty() || NumVertices == 0)
+                continue;
+
+            FQuantizationError& Error = Stats.MaxError;
+            Quantized.PositionQuantization = ComputePositionQuantization(Section.Positions.GetData(), NumVertices);
+            QuantizePositions(Section.Positions.GetData(), NumVertices, Quantized.PositionQuantization, Quantized.Positions.Allocate(NumVertices));
+            Stats.BytesBefore += u64(NumVertices) * sizeof(Float3);
+            {
+                std::vector<Float3> Decoded(NumVertices);
+                DequantizePositions(Quantized.Positions.GetData(), NumVertices, Quantized.PositionQuantization, Decoded.data());
+                for (u32 v = 0; v < NumVertices; ++v)
+                {
+                    Error.Position = std::max(Error.Position, (Vec3(Decoded[v]) - Vec3(Section.Positions[v])).Length());
+                }
+            }
+
+            if (!Section.Normals.IsEmpty())
+            {
+                EncodeOctahedralNormals(Section.Normals.GetData(), NumVertices, Precision,
+                    Quantized.Normals.Allocate(NumVertices * GetOctahedralNormalSize(Precision)));
+                Stats.BytesBefore += u64(NumVertices) * sizeof(Float3);
+
+                std::vector<Float3> Decoded(NumVertices);
+                DecodeOctahedralNormals(Quantized.Normals.GetData(), NumVertices, Precision, Decoded.data());
+                for (u32 v = 0; v < NumVertices; ++v)
+                {
+                    Error.NormalAngle = std::max(Error.NormalAngle, sAngleDegrees(Vec3(Decoded[v]), Vec3(Section.Normals[v])));
+                }
+            }
+
+            if (!Section.Tangents.IsEmpty())
+            {
+                EncodeOctahedralTangents(Section.Tangents.GetData(), NumVertices, Precision,
+                    Quantized.Tangents.Allocate(NumVertices * GetOctahedralTangentSize(Precision)));
+                Stats.BytesBefore += u64(NumVertices) * sizeof(Float4);
+
+                std::vector<Float4> Decoded(NumVertices);
+                DecodeOctahedralTangents(Quantized.Tangents.GetData(), NumVertices, Precision, Decoded.data());
+                for (u32 v = 0; v < NumVertices; ++v)
+                {
+                    const Float4& Original = Section.Tangents[v];
+                    const bool bSameHandedness = (Decoded[v].w < 0.0f) == (Original.w < 0.0f);
+                    const float Angle = bSameHandedness ? sAngleDegrees(Vec3(Decoded[v].x, Decoded[v].y, Decoded[v].z),
+                        Vec3(Original.x, Original.y, Original.z)) : 180.0f;
+                    Error.TangentAngle = std::max(Error.TangentAngle, Angle);
+                }
+            }
+
+            for (u32 Set = 0; Set < 2; ++Set)
+            {
+                const TMeshStream<Float2>& TexCoords = Section.TexCoords[Set];
+                if (TexCoords.IsEmpty())
+                    continue;
+
+                EncodeHalfTexCoords(TexCoords.GetData(), NumVertices, Quantized.TexCoords[Set].Allocate(NumVertices * 2));
+                Stats.BytesBefore += u64(NumVertices) * sizeof(Float2);
+
+                std::vector<Float2> Decoded(NumVertices);
+                DecodeHalfTexCoords(Quantized.TexCoords[Set].GetData(), NumVertices, Decoded.data());
+                for (u32 v = 0; v < NumVertices; ++v)
+                {
+                    Error.TexCoord = std::max(Error.TexCoord, std::max(std::abs(Decoded[v].x - TexCoords[v].x), std::abs(Decoded[v].y - TexCoords[v].y)));
+                }
+            }
+
+            if (!Section.Colors.IsEmpty())
+            {
+                EncodeUnormColors(Section.Colors.GetData(), NumVertices, Quantized.Colors.Allocate(NumVertices));
+                Stats.BytesBefore += u64(NumVertices) * sizeof(Float4);
+
+                std::vector<Float4> Decoded(NumVertices);
+                DecodeUnormColors(Quantized.Colors.GetData(), NumVertices, Decoded.data());
+                for (u32 v = 0; v < NumVertices; ++v)
+                {
+                    // Only the rounding, colors outside [0, 1] are clamped on purpose
+                    const Vec4 Clamped = Vec4::sMin(Vec4::sMax(Vec4::sLoadFloat4(&Section.Colors[v]), Vec4::sZero()), Vec4::sReplicate(1.0f));
+                    Error.Color = std::max(Error.Color, (Vec4::sLoadFloat4(&Decoded[v]) - Clamped).Abs().ReduceMax());
+                }
+            }
+
+            Stats.BytesAfter += u64(NumVertices) * Quantized.GetVertexSize();
+        }
+        return Stats;
+    }
+
+    static void sBuildSectionMeshlets(FStaticMeshSection& Section)
+    {
+        const u32 NumIndices = Section.GetNumIndices();
+        if (Section.Positions.IsEmpty() || NumIndices == 0)
+        {
+            Section.Meshlets.Reset();
+            return;
+        }
+
+        if (!Section.Indices32.IsEmpty())
+        {
+            BuildMeshlets(Section.Indices32.GetData(), NumIndices, Section.Positions.GetData(), Section.NumVertices, Section.Meshlets);
+            return;
+        }
+
+        std::vector<u32> Indices(Section.Indices16.GetData(), Section.Indices16.GetData() + NumIndices);
+        BuildMeshlets(Indices.data(), NumIndices, Section.Positions.GetData(), Section.NumVertices, Section.Meshlets);
+    }
+
+    void FStaticMesh::BuildMeshlets(FThreadPool* pPool)
+    {
+        ParallelFor(pPool, u32(Sections.size()), [this](u32 Index) { sBuildSectionMeshlets(Sections[Index]); });
+    }
+
+    static bool sGenerateSectionTangents(FStaticMeshSection& Section)
+    {
+        const u32 NumVertices = Section.NumVertices;
+        const u32 NumIndices = Section.GetNumIndices();
+        if (Section.Positions.IsEmpty() || Section.Normals.IsEmpty() || Section.TexCoords[0].IsEmpty())
+            return false;
+
+        std::vector<u32> Indices(NumIndices);
+        if (!Section.Indices16.IsEmpty())
+            std::copy(Section.Indices16.GetData(), Section.Indices16.GetData() + NumIndices, Indices.begin());
+        else if (NumIndices > 0)
+            std::copy(Section.Indices32.GetData(), Section.Indices32.GetData() + NumIndices, Indices.begin());
+
+        std::vector<Float4> CornerTangents(NumIndices);
+        GenerateTangents(Indices.data(), NumIndices, Section.Positions.GetData(), Section.Normals.GetData(), Section.TexCoords[0].GetData(),
+            NumVertices, CornerTangents.data());
+
+        // MikkTSpace's bitangent points towards increasing v. Texture coordinates start at the top left here like in glTF, where the
+        // bitangent points towards decreasing v. MikkTSpace on (u, -v) gives the same tangents with the opposite sign.
+        for (Float4& Tangent : CornerTangents)
+        {
+            Tangent.w = -Tangent.w;
+        }
+
+        // Corners of a vertex that disagree get a copy of the vertex each: the first tangent keeps the vertex, the others are appended
+        FVertexStreamRef CornerStreams[2];
+        CornerStreams[0].pData = Indices.data();
+        CornerStreams[0].Size = sizeof(u32);
+        CornerStreams[0].Stride = sizeof(u32);
+        CornerStreams[1].pData = CornerTangents.data();
+        CornerStreams[1].Size = sizeof(Float4);
+        CornerStreams[1].Stride = sizeof(Float4);
+        std::vector<u32> CornerRemap(NumIndices);
+        const u32 NumUnique = GenerateVertexRemap(CornerStreams, 2, NumIndices, CornerRemap.data());
+
+        std::vector<u32> UniqueVertices(NumUnique, ~0u);
+        std::vector<u32> SourceVertices;
+        std::vector<bool> IsVertexUsed(NumVertices, false);
+        std::vector<Float4> Tangents(NumVertices, Float4(1.0f, 0.0f, 0.0f, 1.0f));
+        for (u32 i = 0; i < NumIndices; ++i)
+        {
+            u32& Vertex = UniqueVertices[CornerRemap[i]];
+            if (Vertex == ~0u)
+            {
+                const u32 Source = Indices[i];
+                if (!IsVertexUsed[Source])
+                {
+                    IsVertexUsed[Source] = true;
+                    Vertex = Source;
+                    Tangents[Source] = CornerTangents[i];
+                }
+                else
+                {
+                    Vertex = NumVertices + u32(SourceVertices.size());
+                    SourceVertices.push_back(Source);
+                    Tangents.push_back(CornerTangents[i]);
+                }
+            }
+            Indices[i] = Vertex;
+        }
+
+        const u32 NumSplit = u32(SourceVertices.size());
+        const u32 NumVerticesAfter = NumVertices + NumSplit;
+        if (NumSplit > 0)
+        {
+            sForEachVertexStream(Section, [&SourceVertices, NumVertices, NumVerticesAfter](auto& Stream)
+            {
+                if (!Stream.IsEmpty())
+                {
+                    typename std::remove_reference<decltype(Stream)>::type Extended;
+                    auto* pData = Extended.Allocate(NumVerticesAfter);
+                    std::copy(Stream.GetData(), Stream.GetData() + NumVertices, pData);
+                    for (u32 i = 0; i < u32(SourceVertices.size()); ++i)
+                    {
+                        pData[NumVertices + i] = Stream[SourceVertices[i]];
+                    }
+                    Stream = std::move(Extended);
+                }
+            });
+        }
+        std::copy(Tangents.begin(), Tangents.end(), Section.Tangents.Allocate(NumVerticesAfter));
+        Section.NumVertices = NumVerticesAfter;
+        Section.Meshlets.Reset();
+        Section.Quantized.Reset();
+        Section.LODs.clear();
+
+        if (NumSplit > 0)
+        {
+            Section.Indices16.Reset();
+            Section.Indices32.Reset();
+            if (NumVerticesAfter <= 0x10000)
+                std::copy(Indices.begin(), Indices.end(), Section.Indices16.Allocate(NumIndices));
+            else
+                std::copy(Indices.begin(), Indices.end(), Section.Indices32.Allocate(NumIndices));
+        }
+        return true;
+    }
+
+    bool FStaticMesh::GenerateTangents(FThreadPool* pPool)
+    {
+        std::vector<u8> Generated(Sections.size(), 0);
+        ParallelFor(pPool, u32(Sections.size()), [this, &Generated](u32 Index) { Generated[Index] = sGenerateSectionTangents(Sections[Index]); });
+        LODInfos.clear();
+
+        return std::count(Generated.begin(), Generated.end(), u8(1)) == std::ptrdiff_t(Sections.size());
+    }
+
+    /** Squared distance from P to the triangle ABC (Ericson, Real-Time Collision Detection 5.1.5) */
+    static float sSqDistanceToTriangle(Vec3Arg P, Vec3Arg A, Vec3Arg B, Vec3Arg C)
+    {
+        const Vec3 AB = B - A, AC = C - A, AP = P - A;
+        const float D1 = AB.Dot(AP), D2 = AC.Dot(AP);
+        if (D1 <= 0.0f && D2 <= 0.0f)
+            return AP.LengthSq();
+
+        const Vec3 BP = P - B;
+        const float D3 = AB.Dot(BP), D4 = AC.Dot(BP);
+        if (D3 >= 0.0f && D4 <= D3)
+            return BP.LengthSq();
+
+        const float VC = D1 * D4 - D3 * D2;
+        if (VC <= 0.0f && D1 >= 0.0f && D3 <= 0.0f)
+            return (A + AB * (D1 / (D1 - D3)) - P).LengthSq();
+
+        const Vec3 CP = P - C;
+        const float D5 = AB.Dot(CP), D6 = AC.Dot(CP);
+        if (D6 >= 0.0f && D5 <= D6)
+            return CP.LengthSq();
+
+        const float VB = D5 * D2 - D1 * D6;
+        if (VB <= 0.0f && D2 >= 0.0f && D6 <= 0.0f)
+            return (A + AC * (D2 / (D2 - D6)) - P).LengthSq();
+
+        const float VA = D3 * D6 - D5 * D4;
+        if (VA <= 0.0f && D4 - D3 >= 0.0f && D5 - D6 >= 0.0f)
+            return (B + (C - B) * ((D4 - D3) / ((D4 - D3) + (D5 - D6))) - P).LengthSq();
+
+        // Inside the triangle. A sliver with no area falls back to the nearest corner, which is never closer than the triangle.
+        const float Sum = VA + VB + VC;
+        if (!(Sum > 0.0f))
+            return std::min(std::min(AP.LengthSq(), BP.LengthSq()), CP.LengthSq());
+        return (A + AB * (VB / Sum) + AC * (VC / Sum) - P).LengthSq();
+    }
+
+    /**
+     * Largest distance from the vertices of LOD 0 to the surface of a LOD. The triangles of the LOD around the vertex a vertex was
+     * collapsed onto give an upper bound, the triangles of a BVH within that distance then give the exact distance.
+     */
+    static float sMeasureLODError(const FStaticMeshSection& Section, const std::vector<u32>& LOD0Vertices, const std::vector<u32>& Representatives,
+        const std::vector<u32>& Indices)
+    {
+        const u32 NumVertices = Section.NumVertices;
+        const u32 NumTriangles = u32(Indices.size() / 3);
+        std::vector<u32> FanOffsets(size_t(NumVertices) + 1, 0);
+        for (const u32 Index : Indices)
+        {
+            ++FanOffsets[Index + 1];
+        }
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            FanOffsets[v + 1] += FanOffsets[v];
+        }
+        std::vector<u32> Fans(Indices.size());
+        {
+            std::vector<u32> Fill(FanOffsets.begin(), FanOffsets.end() - 1);
+            for (u32 i = 0; i < u32(Indices.size()); ++i)
+            {
+                Fans[Fill[Indices[i]]++] = i / 3;
+            }
+        }
+
+        const Float3* pPositions = Section.Positions.GetData();
+        const auto SqDistance = [pPositions, &Indices](Vec3Arg P, u32 Triangle)
+        {
+            const u32* pTriangle = &Indices[Triangle * 3];
+            return sSqDistanceToTriangle(P, Vec3(pPositions[pTriangle[0]]), Vec3(pPositions[pTriangle[1]]), Vec3(pPositions[pTriangle[2]]));
+        };
+
+        std::vector<AABox> TriangleBounds(NumTriangles);
+        for (u32 t = 0; t < NumTriangles; ++t)
+        {
+            for (u32 k = 0; k < 3; ++k)
+            {
+                TriangleBounds[t].Encapsulate(Vec3(pPositions[Indices[t * 3 + k]]));
+            }
+        }
+        BVH4 Tree;
+        if (!Tree.Build(TriangleBounds.data(), NumTriangles))
+            return FLT_MAX;
+
+        float MaxDistanceSq = 0.0f;
+        for (const u32 Vertex : LOD0Vertices)
+        {
+            const Vec3 P(pPositions[Vertex]);
+            float DistanceSq = FLT_MAX;
+            const u32 Representative = Representatives[Vertex];
+            for (u32 f = FanOffsets[Representative]; f < FanOffsets[Representative + 1]; ++f)
+            {
+                DistanceSq = std::min(DistanceSq, SqDistance(P, Fans[f]));
+            }
+
+            // A vertex whose representative lost all its triangles searches the whole LOD
+            AABox SearchBox = Tree.GetBounds();
+            if (DistanceSq < FLT_MAX)
+                SearchBox = AABox(P - Vec3::sReplicate(sqrt(DistanceSq)), P + Vec3::sReplicate(sqrt(DistanceSq)));
+            if (DistanceSq > 0.0f)
+                Tree.CollideAABox(SearchBox, [&](u32 Triangle) { DistanceSq = std::min(DistanceSq, SqDistance(P, Triangle)); });
+            MaxDistanceSq = std::max(MaxDistanceSq, DistanceSq);
+        }
+        return sqrt(MaxDistanceSq);
+    }
+
+    void FStaticMesh::GenerateLODs(const FLODSettings& Settings)
+    {
+        for (FStaticMeshSection& Section : Sections)
+        {
+            Section.LODs.clear();
+        }
+        LODInfos.clear();
+
+        // Indices of the last LOD of every section, the vertices LOD 0 uses and the vertex every vertex was collapsed onto so far
+        std::vector<std::vector<u32>> Indices(Sections.size());
+        std::vector<std::vector<u32>> LOD0Vertices(Sections.size());
+        std::vector<std::vector<u32>> Representatives(Sections.size());
+        std::vector<u32> Remap;
+        FStaticMeshLODInfo Info;
+        for (size_t s = 0; s < Sections.size(); ++s)
+        {
+            const FStaticMeshSection& Section = Sections[s];
+            const u32 NumIndices = Section.GetNumIndices();
+            if (!Section.Indices16.IsEmpty())
+                Indices[s].assign(Section.Indices16.GetData(), Section.Indices16.GetData() + NumIndices);
+            else
+                Indices[s].assign(Section.Indices32.GetData(), Section.Indices32.GetData() + NumIndices);
+            Info.NumTriangles += NumIndices / 3;
+
+            std::vector<u8> Used(Section.NumVertices, 0);
+            for (const u32 Index : Indices[s])
+            {
+                Used[Index] = 1;
+            }
+            for (u32 v = 0; v < Section.NumVertices; ++v)
+            {
+                if (Used[v])
+                    LOD0Vertices[s].push_back(v);
+                Representatives[s].push_back(v);
+            }
+        }
+        LODInfos.push_back(Info);
+
+        for (u32 Level = 1; Level < Settings.NumLODs; ++Level)
+        {
+            const FStaticMeshLODInfo& Previous = LODInfos.back();
+            Info = FStaticMeshLODInfo();
+            for (size_t s = 0; s < Sections.size(); ++s)
+            {
+                const FStaticMeshSection& Section = Sections[s];
+                std::vector<u32>& SectionIndices = Indices[s];
+                u32 NumIndices = u32(SectionIndices.size());
+                if (!Section.Positions.IsEmpty() && NumIndices > 0)
+                {
+                    const u32 TargetIndices = u32(float(NumIndices / 3) * Settings.TriangleRatio) * 3;
+                    Remap.resize(Section.NumVertices);
+                    NumIndices = SimplifyMesh(SectionIndices.data(), NumIndices, Section.Positions.GetData(), Section.NumVertices, TargetIndices,
+                        Settings.MaxError, SectionIndices.data(), nullptr, Remap.data());
+                    SectionIndices.resize(NumIndices);
+                    OptimizeVertexCache(SectionIndices.data(), NumIndices, Section.NumVertices);
+
+                    for (u32& Representative : Representatives[s])
+                    {
+                        Representative = Remap[Representative];
+                    }
+                    Info.Error = std::max(Info.Error, sMeasureLODError(Section, LOD0Vertices[s], Representatives[s], SectionIndices));
+                }
+                Info.NumTriangles += NumIndices / 3;
+            }
+            Info.Error = std::max(Info.Error, Previous.Error);
+
+            // Stop when the error limit barely lets the mesh simplify any further, such a LOD isn't worth its memory
+            if (float(Info.NumTriangles) > float(Previous.NumTriangles) * 0.95f)
+                break;
+
+            for (size_t s = 0; s < Sections.size(); ++s)
+            {
+                FStaticMeshSection& Section = Sections[s];
+                const std::vector<u32>& SectionIndices = Indices[s];
+                FStaticMeshLOD LOD;
+                if (!Section.Indices16.IsEmpty())
+                    std::copy(SectionIndices.begin(), SectionIndices.end(), LOD.Indices16.Allocate(u32(SectionIndices.size())));
+                else
+                    std::copy(SectionIndices.begin(), SectionIndices.end(), LOD.Indices32.Allocate(u32(SectionIndices.size())));
+                Section.LODs.push_back(std::move(LOD));
+            }
+            LODInfos.push_back(Info);
+        }
+    }
+
+    void FStaticMesh::GenerateLODs(FStaticMesh* const* ppMeshes, u32 NumMeshes, const FLODSettings& Settings, FThreadPool* pPool)
+    {
+        ParallelFor(pPool, NumMeshes, [ppMeshes, &Settings](u32 Index) { ppMeshes[Index]->GenerateLODs(Settings); });
+    }
+
+    u32 FStaticMesh::SelectLOD(float Distance, float ProjectionScale, float MaxPixelError) const
+    {
+        // Errors grow with the LOD, so the first one that is too large ends the search
+        const float MaxError = MaxPixelError * std::max(Distance, 0.0f) / ProjectionScale;
+        u32 Level = 0;
+        while (Level + 1 < LODInfos.size() && LODInfos[Level + 1].Error <= MaxError)
+        {
+            ++Level;
+        }
+        return Level;
     }
 }
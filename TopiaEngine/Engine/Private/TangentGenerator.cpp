@@ -0,0 +1,577 @@
+#include <TangentGenerator.h>
+
+#include <MeshOptimizer.h>
+#include <TopiaMath.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace topia
+{
+    static constexpr s32 INVALID_INDEX = -1;
+
+    /** Triangle flags, named after their MikkTSpace counterparts */
+    static constexpr u8 ORIENT_PRESERVING = 1 << 0;    // Texture space has the same winding as the triangle
+    static constexpr u8 GROUP_WITH_ANY = 1 << 1;       // No usable texture space, takes over the orientation of its first group
+
+    /**
+     * The arithmetic below follows the reference implementation operation for operation, only 4 triangles at a time: a different
+     * order of additions or a reciprocal instead of a division changes the last bits of the result.
+     */
+    static TOPIA_INLINE UVec4 sNotZero(Vec4Arg Value)
+    {
+        return Vec4::sGreater(Value.Abs(), Vec4::sReplicate(FLT_MIN));
+    }
+
+    static TOPIA_INLINE Vec4 sDot(Vec4Arg AX, Vec4Arg AY, Vec4Arg AZ, Vec4Arg BX, Vec4Arg BY, Vec4Arg BZ)
+    {
+        return AX * BX + AY * BY + AZ * BZ;
+    }
+
+    static TOPIA_INLINE void sNormalizeIfNotZero(Vec4& X, Vec4& Y, Vec4& Z)
+    {
+        const UVec4 NotZero = UVec4::sOr(UVec4::sOr(sNotZero(X), sNotZero(Y)), sNotZero(Z));
+        const Vec4 Scale = Vec4::sReplicate(1.0f) / sDot(X, Y, Z, X, Y, Z).Sqrt();
+        X = Vec4::sSelect(X, X * Scale, NotZero);
+        Y = Vec4::sSelect(Y, Y * Scale, NotZero);
+        Z = Vec4::sSelect(Z, Z * Scale, NotZero);
+    }
+
+    /** Remove the component along the unit vector N and normalize */
+    static TOPIA_INLINE void sProjectAndNormalize(Vec4& X, Vec4& Y, Vec4& Z, Vec4Arg NX, Vec4Arg NY, Vec4Arg NZ)
+    {
+        const Vec4 Dot = sDot(NX, NY, NZ, X, Y, Z);
+        X = X - Dot * NX;
+        Y = Y - Dot * NY;
+        Z = Z - Dot * NZ;
+        sNormalizeIfNotZero(X, Y, Z);
+    }
+
+    /** Components of 4 elements, one vector per component */
+    template <typename T>
+    static TOPIA_INLINE void sGather(const T* pElements, const u32* pIndices, u32 NumComponents, Vec4* pOut)
+    {
+        const float* p0 = reinterpret_cast<const float*>(&pElements[pIndices[0]]);
+        const float* p1 = reinterpret_cast<const float*>(&pElements[pIndices[1]]);
+        const float* p2 = reinterpret_cast<const float*>(&pElements[pIndices[2]]);
+        const float* p3 = reinterpret_cast<const float*>(&pElements[pIndices[3]]);
+        for (u32 c = 0; c < NumComponents; ++c)
+        {
+            pOut[c] = Vec4(p0[c], p1[c], p2[c], p3[c]);
+        }
+    }
+
+    /** Structure of arrays of 3d vectors */
+    struct FVectors
+    {
+        std::vector<float> X, Y, Z;
+
+        void Resize(size_t Num)
+        {
+            X.resize(Num);
+            Y.resize(Num);
+            Z.resize(Num);
+        }
+
+        void Store(size_t Index, Vec4Arg InX, Vec4Arg InY, Vec4Arg InZ, u32 Count, size_t Stride)
+        {
+            for (u32 i = 0; i < Count; ++i)
+            {
+                X[Index + i * Stride] = InX[i];
+                Y[Index + i * Stride] = InY[i];
+                Z[Index + i * Stride] = InZ[i];
+            }
+        }
+
+        float Dot(size_t A, size_t B) const { return X[A] * X[B] + Y[A] * Y[B] + Z[A] * Z[B]; }
+    };
+
+    /** Triangles around one vertex that share a tangent space, see MikkTSpace Build4RuleGroups */
+    struct FGroup
+    {
+        u32 Vertex;         // Welded vertex
+        u32 Offset;         // Into FTangentGenerator::GroupTriangles
+        u32 NumTriangles;
+        bool bOrientPreserving;
+    };
+
+    class FTangentGenerator
+    {
+    public:
+        FTangentGenerator(const u32* pInIndices, u32 NumIndices, const Float3* pInPositions, const Float3* pInNormals, const Float2* pInTexCoords,
+            u32 NumVertices)
+            : pIndices(pInIndices), pPositions(pInPositions), pNormals(pInNormals), pTexCoords(pInTexCoords)
+        {
+            WeldVertices(NumIndices, NumVertices);
+        }
+
+        void Generate(u32 NumIndices, Float4* pOutTangents)
+        {
+            // Until something better is found every corner has the default tangent space of the reference implementation
+            for (u32 i = 0; i < NumIndices; ++i)
+            {
+                pOutTangents[i] = Float4(1.0f, 0.0f, 0.0f, -1.0f);
+            }
+
+            InitTriangles();
+            BuildNeighbours();
+            BuildGroups();
+            EvaluateGroups(pOutTangents);
+            CopyToDegenerateTriangles(NumIndices, pOutTangents);
+        }
+
+    private:
+        /** Vertices that are equal in position, normal and texture coordinate get the same id, triangles referencing one twice are skipped */
+        void WeldVertices(u32 NumIndices, u32 NumVertices)
+        {
+            // The reference compares floats, so -0 and 0 are the same
+            std::vector<float> Keys(size_t(NumVertices) * 8);
+            for (u32 v = 0; v < NumVertices; ++v)
+            {
+                float* pKey = &Keys[size_t(v) * 8];
+                const float Values[8] = { pPositions[v].x, pPositions[v].y, pPositions[v].z, pNormals[v].x, pNormals[v].y, pNormals[v].z,
+                    pTexCoords[v].x, pTexCoords[v].y };
+                for (u32 c = 0; c < 8; ++c)
+                {
+                    pKey[c] = Values[c] == 0.0f ? 0.0f : Values[c];
+                }
+            }
+
+            FVertexStreamRef KeyStream;
+            KeyStream.pData = Keys.data();
+            KeyStream.Size = 8 * sizeof(float);
+            KeyStream.Stride = 8 * sizeof(float);
+            Welded.resize(NumVertices);
+            NumWelded = GenerateVertexRemap(&KeyStream, 1, NumVertices, Welded.data());
+
+            // All attributes are read from the first vertex of a welded vertex in index order, which differs from the others at most
+            // in the sign of zeros
+            std::vector<u32> Representatives(NumWelded, ~0u);
+            for (u32 i = 0; i < NumIndices - NumIndices % 3; ++i)
+            {
+                u32& Representative = Representatives[Welded[pIndices[i]]];
+                if (Representative == ~0u)
+                    Representative = pIndices[i];
+            }
+
+            for (u32 t = 0; t < NumIndices / 3; ++t)
+            {
+                const u32 A = Welded[pIndices[t * 3]], B = Welded[pIndices[t * 3 + 1]], C = Welded[pIndices[t * 3 + 2]];
+                if (A != B && B != C && C != A)
+                {
+                    Triangles.push_back(t);
+                    Corners.push_back(A);
+                    Corners.push_back(B);
+                    Corners.push_back(C);
+                    CornerVertices.push_back(Representatives[A]);
+                    CornerVertices.push_back(Representatives[B]);
+                    CornerVertices.push_back(Representatives[C]);
+                }
+            }
+        }
+
+        /** Texture space of every triangle and the projected texture space and angle of every corner, see InitTriInfo and EvalTspace */
+        void InitTriangles()
+        {
+            const u32 NumTriangles = u32(Triangles.size());
+            Flags.resize(NumTriangles);
+            CornerOs.Resize(size_t(NumTriangles) * 3);
+            CornerOt.Resize(size_t(NumTriangles) * 3);
+            CornerAngles.resize(size_t(NumTriangles) * 3);
+
+            const Vec4 Zero = Vec4::sZero();
+            for (u32 t = 0; t < NumTriangles; t += 4)
+            {
+                const u32 Count = std::min(4u, NumTriangles - t);
+                u32 Vertices[3][4]; // Lanes past the last triangle repeat it
+                for (u32 i = 0; i < 4; ++i)
+                {
+                    const u32 Triangle = t + std::min(i, Count - 1);
+                    for (u32 k = 0; k < 3; ++k)
+                    {
+                        Vertices[k][i] = CornerVertices[Triangle * 3 + k];
+                    }
+                }
+
+                Vec4 P[3][3], UV[3][2], N[3][3];
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    sGather(pPositions, Vertices[k], 3, P[k]);
+                    sGather(pTexCoords, Vertices[k], 2, UV[k]);
+                    sGather(pNormals, Vertices[k], 3, N[k]);
+                }
+
+                const Vec4 T21X = UV[1][0] - UV[0][0], T21Y = UV[1][1] - UV[0][1];
+                const Vec4 T31X = UV[2][0] - UV[0][0], T31Y = UV[2][1] - UV[0][1];
+                const Vec4 D1X = P[1][0] - P[0][0], D1Y = P[1][1] - P[0][1], D1Z = P[1][2] - P[0][2];
+                const Vec4 D2X = P[2][0] - P[0][0], D2Y = P[2][1] - P[0][1], D2Z = P[2][2] - P[0][2];
+
+                const Vec4 SignedAreaSTx2 = T21X * T31Y - T21Y * T31X;
+                Vec4 OsX = T31Y * D1X - T21Y * D2X, OsY = T31Y * D1Y - T21Y * D2Y, OsZ = T31Y * D1Z - T21Y * D2Z;
+                const Vec4 NegT31X = T31X * Vec4::sReplicate(-1.0f); // Unlike 0 - x this keeps the sign of zero
+                Vec4 OtX = NegT31X * D1X + T21X * D2X, OtY = NegT31X * D1Y + T21X * D2Y, OtZ = NegT31X * D1Z + T21X * D2Z;
+
+                const UVec4 IsOrientPreserving = Vec4::sGreater(SignedAreaSTx2, Zero);
+                const UVec4 HasArea = sNotZero(SignedAreaSTx2);
+                const Vec4 AbsArea = SignedAreaSTx2.Abs();
+                const Vec4 LenOs = sDot(OsX, OsY, OsZ, OsX, OsY, OsZ).Sqrt();
+                const Vec4 LenOt = sDot(OtX, OtY, OtZ, OtX, OtY, OtZ).Sqrt();
+                const Vec4 Sign = Vec4::sSelect(Vec4::sReplicate(-1.0f), Vec4::sReplicate(1.0f), IsOrientPreserving);
+
+                // Without texture space area the vectors stay zero, and so do they when they have no length
+                const UVec4 UseOs = UVec4::sAnd(HasArea, sNotZero(LenOs));
+                const UVec4 UseOt = UVec4::sAnd(HasArea, sNotZero(LenOt));
+                const Vec4 ScaleOs = Sign / LenOs, ScaleOt = Sign / LenOt;
+                OsX = Vec4::sSelect(Zero, OsX * ScaleOs, UseOs);
+                OsY = Vec4::sSelect(Zero, OsY * ScaleOs, UseOs);
+                OsZ = Vec4::sSelect(Zero, OsZ * ScaleOs, UseOs);
+                OtX = Vec4::sSelect(Zero, OtX * ScaleOt, UseOt);
+                OtY = Vec4::sSelect(Zero, OtY * ScaleOt, UseOt);
+                OtZ = Vec4::sSelect(Zero, OtZ * ScaleOt, UseOt);
+                const Vec4 MagS = Vec4::sSelect(Zero, LenOs / AbsArea, HasArea);
+                const Vec4 MagT = Vec4::sSelect(Zero, LenOt / AbsArea, HasArea);
+                const UVec4 HasFrame = UVec4::sAnd(sNotZero(MagS), sNotZero(MagT));
+
+                for (u32 i = 0; i < Count; ++i)
+                {
+                    Flags[t + i] = (IsOrientPreserving[i] ? ORIENT_PRESERVING : 0) | (HasFrame[i] ? 0 : GROUP_WITH_ANY);
+                }
+
+                // Per corner: texture space projected onto the plane of the vertex normal, and the angle of the triangle at the corner
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    const Vec4* pNormal = N[k];
+                    Vec4 CornerOsX = OsX, CornerOsY = OsY, CornerOsZ = OsZ;
+                    Vec4 CornerOtX = OtX, CornerOtY = OtY, CornerOtZ = OtZ;
+                    sProjectAndNormalize(CornerOsX, CornerOsY, CornerOsZ, pNormal[0], pNormal[1], pNormal[2]);
+                    sProjectAndNormalize(CornerOtX, CornerOtY, CornerOtZ, pNormal[0], pNormal[1], pNormal[2]);
+                    CornerOs.Store(size_t(t) * 3 + k, CornerOsX, CornerOsY, CornerOsZ, Count, 3);
+                    CornerOt.Store(size_t(t) * 3 + k, CornerOtX, CornerOtY, CornerOtZ, Count, 3);
+
+                    const Vec4* pPrevious = P[(k + 2) % 3];
+                    const Vec4* pCorner = P[k];
+                    const Vec4* pNext = P[(k + 1) % 3];
+                    Vec4 V1X = pPrevious[0] - pCorner[0], V1Y = pPrevious[1] - pCorner[1], V1Z = pPrevious[2] - pCorner[2];
+                    Vec4 V2X = pNext[0] - pCorner[0], V2Y = pNext[1] - pCorner[1], V2Z = pNext[2] - pCorner[2];
+                    sProjectAndNormalize(V1X, V1Y, V1Z, pNormal[0], pNormal[1], pNormal[2]);
+                    sProjectAndNormalize(V2X, V2Y, V2Z, pNormal[0], pNormal[1], pNormal[2]);
+                    const Vec4 Cos = Vec4::sMin(Vec4::sMax(sDot(V1X, V1Y, V1Z, V2X, V2Y, V2Z), Vec4::sReplicate(-1.0f)), Vec4::sReplicate(1.0f));
+
+                    // The reference uses the double precision acos, a vectorized approximation would not match
+                    for (u32 i = 0; i < Count; ++i)
+                    {
+                        CornerAngles[size_t(t + i) * 3 + k] = float(std::acos(double(Cos[i])));
+                    }
+                }
+            }
+        }
+
+        /** Triangle across every edge, pairs are formed in triangle order like BuildNeighborsFast does */
+        void BuildNeighbours()
+        {
+            const u32 NumTriangles = u32(Triangles.size());
+
+            // Triangles around every welded vertex, in triangle order
+            AdjacencyOffsets.assign(size_t(NumWelded) + 1, 0);
+            for (const u32 Vertex : Corners)
+            {
+                ++AdjacencyOffsets[Vertex + 1];
+            }
+            for (u32 v = 0; v < NumWelded; ++v)
+            {
+                AdjacencyOffsets[v + 1] += AdjacencyOffsets[v];
+            }
+            Adjacency.resize(Corners.size());
+            {
+                std::vector<u32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+                for (u32 c = 0; c < u32(Corners.size()); ++c)
+                {
+                    Adjacency[Fill[Corners[c]]++] = c / 3;
+                }
+            }
+
+            Neighbours.assign(size_t(NumTriangles) * 3, INVALID_INDEX);
+            for (u32 t = 0; t < NumTriangles; ++t)
+            {
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    if (Neighbours[t * 3 + k] != INVALID_INDEX)
+                        continue;
+
+                    // The first later triangle with the reversed edge still free
+                    const u32 A = Corners[t * 3 + k], B = Corners[t * 3 + (k + 1) % 3];
+                    for (u32 a = AdjacencyOffsets[B]; a < AdjacencyOffsets[B + 1]; ++a)
+                    {
+                        const u32 Other = Adjacency[a];
+                        if (Other <= t)
+                            continue;
+
+                        const u32 Edge = FindEdge(Other, B, A);
+                        if (Edge != 3 && Neighbours[Other * 3 + Edge] == INVALID_INDEX)
+                        {
+                            Neighbours[t * 3 + k] = s32(Other);
+                            Neighbours[Other * 3 + Edge] = s32(t);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        /** Edge From -> To of a triangle, 3 if it has none */
+        u32 FindEdge(u32 Triangle, u32 From, u32 To) const
+        {
+            const u32* pCorners = &Corners[Triangle * 3];
+            for (u32 k = 0; k < 3; ++k)
+            {
+                if (pCorners[k] == From && pCorners[(k + 1) % 3] == To)
+                    return k;
+            }
+            return 3;
+        }
+
+        /** Corner of a triangle at a welded vertex */
+        u32 FindCorner(u32 Triangle, u32 Vertex) const
+        {
+            const u32* pCorners = &Corners[Triangle * 3];
+            return pCorners[0] == Vertex ? 0 : (pCorners[1] == Vertex ? 1 : 2);
+        }
+
+        /** Connected fans of triangles with the same orientation around every vertex, see Build4RuleGroups and AssignRecur */
+        void BuildGroups()
+        {
+            const u32 NumTriangles = u32(Triangles.size());
+            AssignedGroups.assign(size_t(NumTriangles) * 3, INVALID_INDEX);
+            GroupTriangles.reserve(size_t(NumTriangles) * 3);
+
+            std::vector<u32> Stack;
+            for (u32 t = 0; t < NumTriangles; ++t)
+            {
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    if ((Flags[t] & GROUP_WITH_ANY) != 0 || AssignedGroups[t * 3 + k] != INVALID_INDEX)
+                        continue;
+
+                    FGroup Group;
+                    Group.Vertex = Corners[t * 3 + k];
+                    Group.Offset = u32(GroupTriangles.size());
+                    Group.NumTriangles = 0;
+                    Group.bOrientPreserving = (Flags[t] & ORIENT_PRESERVING) != 0;
+                    const s32 GroupIndex = s32(Groups.size());
+
+                    // Depth first, the left neighbour's fan before the right one's, which decides where the flexible triangles go
+                    Stack.clear();
+                    Stack.push_back(t);
+                    while (!Stack.empty())
+                    {
+                        const u32 Triangle = Stack.back();
+                        Stack.pop_back();
+
+                        const u32 Corner = FindCorner(Triangle, Group.Vertex);
+                        const s32 Assigned = AssignedGroups[Triangle * 3 + Corner];
+                        if (Assigned != INVALID_INDEX)
+                            continue;
+
+                        // The first group to reach a flexible triangle decides its orientation
+                        if ((Flags[Triangle] & GROUP_WITH_ANY) != 0 && AssignedGroups[Triangle * 3] == INVALID_INDEX
+                            && AssignedGroups[Triangle * 3 + 1] == INVALID_INDEX && AssignedGroups[Triangle * 3 + 2] == INVALID_INDEX)
+                        {
+                            Flags[Triangle] = u8((Flags[Triangle] & ~ORIENT_PRESERVING) | (Group.bOrientPreserving ? ORIENT_PRESERVING : 0));
+                        }
+                        if (((Flags[Triangle] & ORIENT_PRESERVING) != 0) != Group.bOrientPreserving)
+                            continue;
+
+                        GroupTriangles.push_back(Triangle);
+                        ++Group.NumTriangles;
+                        AssignedGroups[Triangle * 3 + Corner] = GroupIndex;
+
+                        const s32 Left = Neighbours[Triangle * 3 + Corner];
+                        const s32 Right = Neighbours[Triangle * 3 + (Corner + 2) % 3];
+                        if (Right != INVALID_INDEX)
+                            Stack.push_back(u32(Right));
+                        if (Left != INVALID_INDEX)
+                            Stack.push_back(u32(Left));
+                    }
+                    Groups.push_back(Group);
+                }
+            }
+        }
+
+        /** Angle weighted average of the projected texture spaces of Members, see EvalTspace */
+        Float3 EvaluateTangent(const u32* pMembers, u32 NumMembers, u32 Vertex) const
+        {
+            float X = 0.0f, Y = 0.0f, Z = 0.0f;
+            for (u32 m = 0; m < NumMembers; ++m)
+            {
+                const u32 Triangle = pMembers[m];
+                if ((Flags[Triangle] & GROUP_WITH_ANY) != 0)
+                    continue;
+
+                const size_t Corner = size_t(Triangle) * 3 + FindCorner(Triangle, Vertex);
+                const float Angle = CornerAngles[Corner];
+                X = X + Angle * CornerOs.X[Corner];
+                Y = Y + Angle * CornerOs.Y[Corner];
+                Z = Z + Angle * CornerOs.Z[Corner];
+            }
+
+            if (std::abs(X) > FLT_MIN || std::abs(Y) > FLT_MIN || std::abs(Z) > FLT_MIN)
+            {
+                const float Scale = 1.0f / std::sqrt(X * X + Y * Y + Z * Z);
+                X = X * Scale;
+                Y = Y * Scale;
+                Z = Z * Scale;
+            }
+            return Float3(X, Y, Z);
+        }
+
+        /**
+         * Tangent of every corner of every group, see GenerateTSpaces. The triangles of a corner's subgroup are the ones of its group
+         * whose texture space is not exactly opposite, so in practice there is one subgroup per group and its tangent is computed once.
+         */
+        void EvaluateGroups(Float4* pOutTangents)
+        {
+            static const float sThresholdCos = -1.0f; // cos(180 degrees), the default angular threshold
+            std::vector<u32> Sorted, Members, SubGroupOffsets, SubGroupMembers;
+            std::vector<Float3> SubGroupTangents;
+            std::vector<size_t> GroupCorners;
+
+            for (const FGroup& Group : Groups)
+            {
+                const u32* pTriangles = &GroupTriangles[Group.Offset];
+                const float Sign = Group.bOrientPreserving ? 1.0f : -1.0f;
+
+                GroupCorners.resize(Group.NumTriangles);
+                for (u32 i = 0; i < Group.NumTriangles; ++i)
+                {
+                    GroupCorners[i] = size_t(pTriangles[i]) * 3 + FindCorner(pTriangles[i], Group.Vertex);
+                }
+
+                auto IsSimilar = [this, &GroupCorners, pTriangles](u32 i, u32 j)
+                {
+                    const bool bAny = ((Flags[pTriangles[i]] | Flags[pTriangles[j]]) & GROUP_WITH_ANY) != 0;
+                    return bAny || i == j
+                        || (CornerOs.Dot(GroupCorners[i], GroupCorners[j]) > sThresholdCos && CornerOt.Dot(GroupCorners[i], GroupCorners[j]) > sThresholdCos);
+                };
+
+                Sorted.assign(pTriangles, pTriangles + Group.NumTriangles);
+                std::sort(Sorted.begin(), Sorted.end());
+
+                bool bAllSimilar = true;
+                for (u32 i = 0; i < Group.NumTriangles && bAllSimilar; ++i)
+                {
+                    for (u32 j = i + 1; j < Group.NumTriangles && bAllSimilar; ++j)
+                    {
+                        bAllSimilar = IsSimilar(i, j) && IsSimilar(j, i);
+                    }
+                }
+
+                if (bAllSimilar)
+                {
+                    const Float3 Tangent = EvaluateTangent(Sorted.data(), Group.NumTriangles, Group.Vertex);
+                    for (u32 i = 0; i < Group.NumTriangles; ++i)
+                    {
+                        pOutTangents[Triangles[pTriangles[i]] * 3 + GroupCorners[i] % 3] = Float4(Tangent.x, Tangent.y, Tangent.z, Sign);
+                    }
+                    continue;
+                }
+
+                // Subgroups with the same members share their tangent
+                SubGroupOffsets.assign(1, 0);
+                SubGroupMembers.clear();
+                SubGroupTangents.clear();
+                for (u32 i = 0; i < Group.NumTriangles; ++i)
+                {
+                    Members.clear();
+                    for (u32 j = 0; j < Group.NumTriangles; ++j)
+                    {
+                        if (IsSimilar(i, j))
+                            Members.push_back(pTriangles[j]);
+                    }
+                    std::sort(Members.begin(), Members.end());
+
+                    u32 SubGroup = 0;
+                    const u32 NumSubGroups = u32(SubGroupTangents.size());
+                    for (; SubGroup < NumSubGroups; ++SubGroup)
+                    {
+                        const u32 Begin = SubGroupOffsets[SubGroup], End = SubGroupOffsets[SubGroup + 1];
+                        if (End - Begin == Members.size() && std::equal(Members.begin(), Members.end(), SubGroupMembers.begin() + Begin))
+                            break;
+                    }
+                    if (SubGroup == NumSubGroups)
+                    {
+                        SubGroupMembers.insert(SubGroupMembers.end(), Members.begin(), Members.end());
+                        SubGroupOffsets.push_back(u32(SubGroupMembers.size()));
+                        SubGroupTangents.push_back(EvaluateTangent(Members.data(), u32(Members.size()), Group.Vertex));
+                    }
+
+                    const Float3& Tangent = SubGroupTangents[SubGroup];
+                    pOutTangents[Triangles[pTriangles[i]] * 3 + GroupCorners[i] % 3] = Float4(Tangent.x, Tangent.y, Tangent.z, Sign);
+                }
+            }
+        }
+
+        /** Corners of skipped triangles get the tangent of the first corner of a kept triangle at the same vertex, see DegenEpilogue */
+        void CopyToDegenerateTriangles(u32 NumIndices, Float4* pOutTangents) const
+        {
+            if (Triangles.size() * 3 == NumIndices - NumIndices % 3)
+                return;
+
+            std::vector<u32> FirstCorner(NumWelded, ~0u);
+            for (u32 c = u32(Corners.size()); c-- > 0;)
+            {
+                FirstCorner[Corners[c]] = Triangles[c / 3] * 3 + c % 3;
+            }
+
+            u32 Next = 0;
+            for (u32 t = 0; t < NumIndices / 3; ++t)
+            {
+                if (Next < Triangles.size() && Triangles[Next] == t)
+                {
+                    ++Next;
+                    continue;
+                }
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    const u32 Source = FirstCorner[Welded[pIndices[t * 3 + k]]];
+                    if (Source != ~0u)
+                        pOutTangents[t * 3 + k] = pOutTangents[Source];
+                }
+            }
+        }
+
+        const u32* pIndices;
+        const Float3* pPositions;
+        const Float3* pNormals;
+        const Float2* pTexCoords;
+
+        std::vector<u32> Welded;
+        u32 NumWelded = 0;
+
+        /** Triangles that don't reference a welded vertex twice: their source triangle, welded corners and vertices to read */
+        std::vector<u32> Triangles;
+        std::vector<u32> Corners;
+        std::vector<u32> CornerVertices;
+
+        std::vector<u8> Flags;
+        FVectors CornerOs;
+        FVectors CornerOt;
+        std::vector<float> CornerAngles;
+
+        std::vector<u32> AdjacencyOffsets;
+        std::vector<u32> Adjacency;
+        std::vector<s32> Neighbours;
+
+        std::vector<s32> AssignedGroups;
+        std::vector<FGroup> Groups;
+        std::vector<u32> GroupTriangles;
+    };
+
+    void GenerateTangents(const u32* pIndices, u32 NumIndices, const Float3* pPositions, const Float3* pNormals, const Float2* pTexCoords,
+        u32 NumVertices, Float4* pOutTangents)
+    {
+        FTangentGenerator Generator(pIndices, NumIndices, pPositions, pNormals, pTexCoords, NumVertices);
+        Generator.Generate(NumIndices, pOutTangents);
+    }
+}
@@ -0,0 +1,327 @@
+#include <VertexQuantization.h>
+
+#include <TopiaMath.h>
+#include <AABox.h>
+
+#include <cfloat>
+#include <cstring>
+
+namespace topia
+{
+    /** Vec4 with the same component of 4 vectors, lanes past Count repeat the last vector */
+    template <typename T>
+    static TOPIA_INLINE void sLoadSoA(const T* pVectors, u32 Count, u32 NumComponents, Vec4* pOutComponents)
+    {
+        const float* pFloats = reinterpret_cast<const float*>(pVectors);
+        const u32 Last = Count - 1;
+        for (u32 c = 0; c < NumComponents; ++c)
+        {
+            pOutComponents[c] = Vec4(pFloats[c], pFloats[std::min(1u, Last) * (sizeof(T) / 4) + c],
+                pFloats[std::min(2u, Last) * (sizeof(T) / 4) + c], pFloats[std::min(3u, Last) * (sizeof(T) / 4) + c]);
+        }
+    }
+
+    /** Round half away from zero and convert, lanes hold s32 (UVec4::ToFloat converts them back as signed) */
+    static TOPIA_INLINE UVec4 sRoundToInt(Vec4Arg Value)
+    {
+        return (Value + Value.GetSign() * 0.5f).ToInt();
+    }
+
+    /** Fold the unit vectors (X, Y, Z) onto the octahedron and unfold it into the square [-1, 1]^2 */
+    static TOPIA_INLINE void sOctahedralEncode(Vec4 X, Vec4 Y, Vec4 Z, Vec4& OutU, Vec4& OutV)
+    {
+        const Vec4 L1 = Vec4::sMax(X.Abs() + Y.Abs() + Z.Abs(), Vec4::sReplicate(1.0e-20f));
+        const Vec4 InvL1 = L1.Reciprocal();
+        X *= InvL1;
+        Y *= InvL1;
+        Z *= InvL1;
+
+        // The lower hemisphere is mirrored into the corners of the square
+        const Vec4 One = Vec4::sReplicate(1.0f);
+        const UVec4 IsLower = Vec4::sLess(Z, Vec4::sZero());
+        OutU = Vec4::sSelect(X, (One - Y.Abs()) * X.GetSign(), IsLower);
+        OutV = Vec4::sSelect(Y, (One - X.Abs()) * Y.GetSign(), IsLower);
+    }
+
+    static TOPIA_INLINE void sOctahedralDecode(Vec4 U, Vec4 V, Vec4& OutX, Vec4& OutY, Vec4& OutZ)
+    {
+        Vec4 Z = Vec4::sReplicate(1.0f) - U.Abs() - V.Abs();
+        const Vec4 Fold = Vec4::sMax(-Z, Vec4::sZero());
+        U -= U.GetSign() * Fold;
+        V -= V.GetSign() * Fold;
+
+        const Vec4 InvLength = (U * U + V * V + Z * Z).Sqrt().Reciprocal();
+        OutX = U * InvLength;
+        OutY = V * InvLength;
+        OutZ = Z * InvLength;
+    }
+
+    /** Encode 4 directions into snorm octahedral components, 2 per vertex followed by NumExtra values of pExtra */
+    template <typename TComponent>
+    static TOPIA_INLINE void sStoreOctahedral(Vec4Arg U, Vec4Arg V, const UVec4* pExtra, u32 NumExtra, u32 Count, TComponent* pOut)
+    {
+        const float MaxValue = float((1 << (8 * sizeof(TComponent) - 1)) - 1);
+        u32 QU[4], QV[4], QExtra[4] = { 0, 0, 0, 0 };
+        sRoundToInt(U * MaxValue).StoreInt4(QU);
+        sRoundToInt(V * MaxValue).StoreInt4(QV);
+        if (NumExtra > 0)
+        {
+            pExtra->StoreInt4(QExtra);
+        }
+
+        const u32 Stride = 2 + NumExtra;
+        for (u32 i = 0; i < Count; ++i)
+        {
+            pOut[i * Stride + 0] = TComponent(s32(QU[i]));
+            pOut[i * Stride + 1] = TComponent(s32(QV[i]));
+            for (u32 e = 0; e < NumExtra; ++e)
+            {
+                pOut[i * Stride + 2 + e] = e == 0 ? TComponent(s32(QExtra[i])) : TComponent(0);
+            }
+        }
+    }
+
+    template <typename TComponent>
+    static TOPIA_INLINE void sLoadOctahedral(const TComponent* pIn, u32 Stride, u32 Count, Vec4& OutU, Vec4& OutV, Vec4& OutExtra)
+    {
+        const Vec4 InvMaxValue = Vec4::sReplicate(1.0f / float((1 << (8 * sizeof(TComponent) - 1)) - 1));
+        s32 U[4], V[4], Extra[4];
+        for (u32 i = 0; i < 4; ++i)
+        {
+            const TComponent* pElement = pIn + std::min(i, Count - 1) * Stride;
+            U[i] = pElement[0];
+            V[i] = pElement[1];
+            Extra[i] = Stride > 2 ? pElement[2] : 0;
+        }
+
+        // The most negative snorm value is -1 as well
+        const Vec4 MinusOne = Vec4::sReplicate(-1.0f);
+        OutU = Vec4::sMax(UVec4::sLoadInt4(reinterpret_cast<const u32*>(U)).ToFloat() * InvMaxValue, MinusOne);
+        OutV = Vec4::sMax(UVec4::sLoadInt4(reinterpret_cast<const u32*>(V)).ToFloat() * InvMaxValue, MinusOne);
+        OutExtra = UVec4::sLoadInt4(reinterpret_cast<const u32*>(Extra)).ToFloat();
+    }
+
+    u32 FQuantizedVertexData::GetVertexSize() const
+    {
+        if (Positions.IsEmpty())
+            return 0;
+
+        const u32 NumVertices = Positions.Num();
+        return u32(sizeof(FQuantizedPosition) + Normals.Num() / NumVertices + Tangents.Num() / NumVertices
+            + (TexCoords[0].Num() + TexCoords[1].Num()) * sizeof(HalfFloat) / NumVertices + (Colors.IsEmpty() ? 0 : sizeof(u32)));
+    }
+
+    void FQuantizedVertexData::Reset()
+    {
+        Positions.Reset();
+        Normals.Reset();
+        Tangents.Reset();
+        TexCoords[0].Reset();
+        TexCoords[1].Reset();
+        Colors.Reset();
+    }
+
+    FPositionQuantization ComputePositionQuantization(const Float3* pPositions, u32 NumVertices)
+    {
+        FPositionQuantization Quantization;
+        if (NumVertices == 0)
+        {
+            Quantization.Offset = Float3(0.0f, 0.0f, 0.0f);
+            Quantization.Scale = Float3(0.0f, 0.0f, 0.0f);
+            return Quantization;
+        }
+
+        AABox Bounds;
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            Bounds.Encapsulate(Vec3(pPositions[v]));
+        }
+        Bounds.mMin.StoreFloat3(&Quantization.Offset);
+        Bounds.GetSize().StoreFloat3(&Quantization.Scale);
+        return Quantization;
+    }
+
+    void QuantizePositions(const Float3* pPositions, u32 NumVertices, const FPositionQuantization& Quantization, FQuantizedPosition* pOutPositions)
+    {
+        const Vec3 Offset(Quantization.Offset);
+        const Vec3 Scale(Quantization.Scale);
+
+        // Flat axes have a scale of 0 and quantize to 0
+        const Vec3 Multiplier = Vec3::sSelect(Vec3::sReplicate(65535.0f) / Vec3::sMax(Scale, Vec3::sReplicate(FLT_MIN)), Vec3::sZero(),
+            Vec3::sEquals(Scale, Vec3::sZero()));
+        const Vec4 Max = Vec4::sReplicate(65535.0f);
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            const Vec4 Value(Vec4((Vec3(pPositions[v]) - Offset) * Multiplier, 0.0f));
+            u32 Q[4];
+            (Vec4::sMin(Vec4::sMax(Value, Vec4::sZero()), Max) + Vec4::sReplicate(0.5f)).ToInt().StoreInt4(Q);
+            pOutPositions[v].X = u16(Q[0]);
+            pOutPositions[v].Y = u16(Q[1]);
+            pOutPositions[v].Z = u16(Q[2]);
+            pOutPositions[v].W = 0;
+        }
+    }
+
+    void DequantizePositions(const FQuantizedPosition* pPositions, u32 NumVertices, const FPositionQuantization& Quantization, Float3* pOutPositions)
+    {
+        const Vec4 Offset(Vec3(Quantization.Offset), 0.0f);
+        const Vec4 Scale(Vec3(Quantization.Scale) * (1.0f / 65535.0f), 0.0f);
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            // 4 u16 in the low 64 bits, widened to u32
+            u64 Packed;
+            memcpy(&Packed, &pPositions[v], sizeof(Packed));
+            const UVec4 Value = UVec4(u32(Packed), u32(Packed >> 32), 0, 0).Expand4Uint16Lo();
+            const Vec4 Position = Vec4::sFusedMultiplyAdd(Value.ToFloat(), Scale, Offset);
+            Vec3(Position).StoreFloat3(&pOutPositions[v]);
+        }
+    }
+
+    template <typename TComponent>
+    static void sEncodeNormals(const Float3* pNormals, u32 NumVertices, TComponent* pOut)
+    {
+        for (u32 v = 0; v < NumVertices; v += 4)
+        {
+            const u32 Count = std::min(4u, NumVertices - v);
+            Vec4 XYZ[3], U, V;
+            sLoadSoA(pNormals + v, Count, 3, XYZ);
+            sOctahedralEncode(XYZ[0], XYZ[1], XYZ[2], U, V);
+            sStoreOctahedral(U, V, nullptr, 0, Count, pOut + v * 2);
+        }
+    }
+
+    template <typename TComponent>
+    static void sDecodeNormals(const TComponent* pIn, u32 NumVertices, Float3* pOutNormals)
+    {
+        for (u32 v = 0; v < NumVertices; v += 4)
+        {
+            const u32 Count = std::min(4u, NumVertices - v);
+            Vec4 U, V, Unused, X, Y, Z;
+            sLoadOctahedral(pIn + v * 2, 2, Count, U, V, Unused);
+            sOctahedralDecode(U, V, X, Y, Z);
+            for (u32 i = 0; i < Count; ++i)
+            {
+                pOutNormals[v + i] = Float3(X[i], Y[i], Z[i]);
+            }
+        }
+    }
+
+    template <typename TComponent>
+    static void sEncodeTangents(const Float4* pTangents, u32 NumVertices, TComponent* pOut)
+    {
+        const float MaxValue = float((1 << (8 * sizeof(TComponent) - 1)) - 1);
+        for (u32 v = 0; v < NumVertices; v += 4)
+        {
+            const u32 Count = std::min(4u, NumVertices - v);
+            Vec4 XYZW[4], U, V;
+            sLoadSoA(pTangents + v, Count, 4, XYZW);
+            sOctahedralEncode(XYZW[0], XYZW[1], XYZW[2], U, V);
+            const UVec4 Handedness = sRoundToInt(Vec4::sSelect(Vec4::sReplicate(MaxValue), Vec4::sReplicate(-MaxValue),
+                Vec4::sLess(XYZW[3], Vec4::sZero())));
+            sStoreOctahedral(U, V, &Handedness, 2, Count, pOut + v * 4);
+        }
+    }
+
+    template <typename TComponent>
+    static void sDecodeTangents(const TComponent* pIn, u32 NumVertices, Float4* pOutTangents)
+    {
+        for (u32 v = 0; v < NumVertices; v += 4)
+        {
+            const u32 Count = std::min(4u, NumVertices - v);
+            Vec4 U, V, Handedness, X, Y, Z;
+            sLoadOctahedral(pIn + v * 4, 4, Count, U, V, Handedness);
+            sOctahedralDecode(U, V, X, Y, Z);
+            const Vec4 W = Vec4::sSelect(Vec4::sReplicate(1.0f), Vec4::sReplicate(-1.0f), Vec4::sLess(Handedness, Vec4::sZero()));
+            for (u32 i = 0; i < Count; ++i)
+            {
+                pOutTangents[v + i] = Float4(X[i], Y[i], Z[i], W[i]);
+            }
+        }
+    }
+
+    void EncodeOctahedralNormals(const Float3* pNormals, u32 NumVertices, EOctahedralPrecision Precision, void* pOutNormals)
+    {
+        if (Precision == EOctahedralPrecision::Bits8)
+            sEncodeNormals(pNormals, NumVertices, static_cast<s8*>(pOutNormals));
+        else
+            sEncodeNormals(pNormals, NumVertices, static_cast<s16*>(pOutNormals));
+    }
+
+    void DecodeOctahedralNormals(const void* pNormals, u32 NumVertices, EOctahedralPrecision Precision, Float3* pOutNormals)
+    {
+        if (Precision == EOctahedralPrecision::Bits8)
+            sDecodeNormals(static_cast<const s8*>(pNormals), NumVertices, pOutNormals);
+        else
+            sDecodeNormals(static_cast<const s16*>(pNormals), NumVertices, pOutNormals);
+    }
+
+    void EncodeOctahedralTangents(const Float4* pTangents, u32 NumVertices, EOctahedralPrecision Precision, void* pOutTangents)
+    {
+        if (Precision == EOctahedralPrecision::Bits8)
+            sEncodeTangents(pTangents, NumVertices, static_cast<s8*>(pOutTangents));
+        else
+            sEncodeTangents(pTangents, NumVertices, static_cast<s16*>(pOutTangents));
+    }
+
+    void DecodeOctahedralTangents(const void* pTangents, u32 NumVertices, EOctahedralPrecision Precision, Float4* pOutTangents)
+    {
+        if (Precision == EOctahedralPrecision::Bits8)
+            sDecodeTangents(static_cast<const s8*>(pTangents), NumVertices, pOutTangents);
+        else
+            sDecodeTangents(static_cast<const s16*>(pTangents), NumVertices, pOutTangents);
+    }
+
+    void EncodeHalfTexCoords(const Float2* pTexCoords, u32 NumVertices, HalfFloat* pOutTexCoords)
+    {
+        // Two texture coordinates per conversion
+        u32 v = 0;
+        for (; v + 2 <= NumVertices; v += 2)
+        {
+            const Vec4 Value = Vec4::sLoadFloat4(reinterpret_cast<const Float4*>(pTexCoords + v));
+            u32 Halves[4];
+            HalfFloatConversion::FromFloat4<HalfFloatConversion::ROUND_TO_NEAREST>(Value).StoreInt4(Halves);
+            memcpy(pOutTexCoords + v * 2, Halves, 4 * sizeof(HalfFloat));
+        }
+        for (; v < NumVertices; ++v)
+        {
+            pOutTexCoords[v * 2 + 0] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_NEAREST>(pTexCoords[v].x);
+            pOutTexCoords[v * 2 + 1] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_NEAREST>(pTexCoords[v].y);
+        }
+    }
+
+    void DecodeHalfTexCoords(const HalfFloat* pTexCoords, u32 NumVertices, Float2* pOutTexCoords)
+    {
+        for (u32 v = 0; v < NumVertices; v += 2)
+        {
+            const u32 Count = std::min(2u, NumVertices - v);
+            u32 Halves[4] = { 0, 0, 0, 0 };
+            memcpy(Halves, pTexCoords + v * 2, Count * 2 * sizeof(HalfFloat));
+            const Vec4 Value = HalfFloatConversion::ToFloat(UVec4::sLoadInt4(Halves));
+            for (u32 i = 0; i < Count; ++i)
+            {
+                pOutTexCoords[v + i] = Float2(Value[i * 2], Value[i * 2 + 1]);
+            }
+        }
+    }
+
+    void EncodeUnormColors(const Float4* pColors, u32 NumVertices, u32* pOutColors)
+    {
+        const Vec4 One = Vec4::sReplicate(1.0f);
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            const Vec4 Color = Vec4::sMin(Vec4::sMax(Vec4::sLoadFloat4(&pColors[v]), Vec4::sZero()), One);
+            u32 Q[4];
+            (Color * 255.0f + Vec4::sReplicate(0.5f)).ToInt().StoreInt4(Q);
+            pOutColors[v] = Q[0] | (Q[1] << 8) | (Q[2] << 16) | (Q[3] << 24);
+        }
+    }
+
+    void DecodeUnormColors(const u32* pColors, u32 NumVertices, Float4* pOutColors)
+    {
+        const Vec4 Scale = Vec4::sReplicate(1.0f / 255.0f);
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            (UVec4::sReplicate(pColors[v]).Expand4Byte0().ToFloat() * Scale).StoreFloat4(&pOutColors[v]);
+        }
+    }
+}
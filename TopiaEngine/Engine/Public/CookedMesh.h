@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float3.h>
+
+#include "VertexQuantization.h"
+
+namespace topia
+{
+    /**
+     * Cooked static mesh file (.tmesh), written by FStaticMesh::SaveCooked and mapped by FStaticMesh::LoadCooked. The file is a
+     * header, a section table and data blocks. Every block starts at a multiple of COOKED_MESH_ALIGNMENT and holds one stream in its
+     * in-memory layout, so a loaded mesh points into the mapped file instead of copying. Little endian, like every platform we ship on.
+     *
+     * Bump COOKED_MESH_VERSION whenever the layout of the file or of a stored type changes, loading refuses other versions.
+     */
+    static constexpr u32 COOKED_MESH_MAGIC = 0x48534D54; // "TMSH"
+    static constexpr u32 COOKED_MESH_VERSION = 1;
+    static constexpr u32 COOKED_MESH_ALIGNMENT = 64;
+
+    /** Block of Count elements at Offset bytes from the start of the file, Count 0 when the stream is absent */
+    struct FCookedRange
+    {
+        u64 Offset = 0;
+        u32 Count = 0;
+        u32 Padding = 0;
+    };
+
+    struct FCookedMeshHeader
+    {
+        u32 Magic = COOKED_MESH_MAGIC;
+        u32 Version = COOKED_MESH_VERSION;
+        u64 FileSize = 0;
+        u64 ContentHash = 0;        // Hash64 of the file after the header
+        u32 NumSections = 0;
+        u32 NumLODs = 0;            // Entries in the LOD info table, 0 when the mesh has no LODs
+        u64 SectionsOffset = 0;     // FCookedSection[NumSections]
+        u64 LODInfosOffset = 0;     // FStaticMeshLODInfo[NumLODs]
+        Float3 BoundsMin;
+        Float3 BoundsMax;
+    };
+
+    struct FCookedSection
+    {
+        u32 NumVertices = 0;
+        u32 MaterialIndex = 0;
+        u32 IndexSize = 0;          // 2 or 4 bytes, for the triangle list and every LOD
+        u32 NumLODs = 0;            // LODs after LOD 0
+
+        FCookedRange Positions;
+        FCookedRange Normals;
+        FCookedRange Tangents;
+        FCookedRange TexCoords[2];
+        FCookedRange Colors;
+        FCookedRange Indices;
+        FCookedRange LODs;          // FCookedRange[NumLODs], each an index list
+
+        FCookedRange Meshlets;
+        FCookedRange MeshletBounds;
+        FCookedRange MeshletVertices;
+        FCookedRange MeshletTriangles;
+
+        u32 bQuantized = 0;
+        u32 QuantizedPrecision = 0; // EOctahedralPrecision
+        FPositionQuantization PositionQuantization;
+        FCookedRange QuantizedPositions;
+        FCookedRange QuantizedNormals;
+        FCookedRange QuantizedTangents;
+        FCookedRange QuantizedTexCoords[2];
+        FCookedRange QuantizedColors;
+    };
+
+    static_assert(sizeof(FCookedMeshHeader) == 72, "FCookedMeshHeader is stored as is");
+    static_assert(sizeof(FCookedSection) % 8 == 0, "FCookedSection is stored as is");
+}
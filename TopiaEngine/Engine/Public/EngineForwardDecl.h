@@ -4,6 +4,8 @@ namespace topia
 {
     class FShader;
     class FMaterial;
+    class FGLTFAsset;
+    class FDerivedDataCache;
 
 
 }
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <Topia.h>
+#include <Noncopyable.h>
+#include <FileSystem/FileWatcher.h>
+#include <FileSystem/Path.h>
+
+#include "EngineForwardDecl.h"
+#include "StaticMesh.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace topia
+{
+    /** Runtime object that FHotReloader rebuilds when its sources change */
+    class IReloadable
+    {
+    public:
+        virtual ~IReloadable() = default;
+
+        /**
+         * Rebuild from the sources on a worker thread, into data of its own: the object is in use by the frame meanwhile. Returns
+         * false when the build fails, the object then keeps its current data.
+         */
+        virtual bool Rebuild() = 0;
+
+        /** Swap the rebuilt data in, on the thread of FHotReloader::Tick at a frame boundary */
+        virtual void Apply() = 0;
+    };
+
+    struct FHotReloadStats
+    {
+        u32 NumReloads = 0;
+        u32 NumFailed = 0;
+
+        /** From the first notification of the change to Apply */
+        double LastLatencyMs = 0.0;
+        double MaxLatencyMs = 0.0;
+        double TotalLatencyMs = 0.0;
+
+        double GetAverageLatencyMs() const { return NumReloads > 0 ? TotalLatencyMs / NumReloads : 0.0; }
+    };
+
+    /**
+     * Reloads objects while the engine runs. Objects are registered under a name with the paths they are built from, which are
+     * source files below the watched directory or names of other objects (source file, then cooked artifact, then runtime
+     * object), Register refuses dependencies that would make a cycle. When a file changes, every object below it in the graph is
+     * outdated and only those are rebuilt: an object is rebuilt on a worker thread once none of its dependencies is outdated, and
+     * applied at the next Tick, so a chain is rebuilt in order and an object that depends on several changed ones is rebuilt once.
+     * Register, Unregister and Tick are called from one thread, normally the main thread once per frame.
+     */
+    class FHotReloader : public NonCopyable
+    {
+    public:
+        explicit FHotReloader(u32 NumWorkers = 2);
+        ~FHotReloader();
+
+        /** Watch a directory, the paths of source files are relative to it */
+        bool Watch(const std::wstring& SourceDirectory, u32 SettleMilliseconds = 50);
+
+        /**
+         * pObject must stay alive until Unregister. Registering a name again replaces its object and dependencies. Returns false
+         * and leaves the graph as it was when Name is among the dependencies or below them, a cycle would never be up to date.
+         */
+        bool Register(FPath Name, IReloadable* pObject, const std::vector<FPath>& Dependencies);
+
+        /** Waits for a rebuild of the object in progress */
+        void Unregister(FPath Name);
+
+        /** Treat Path as changed without a notification, for files written by the engine itself */
+        void NotifyChanged(FPath Path);
+
+        /** Collect the changes, start the rebuilds they need and apply the finished ones. Call at a frame boundary. */
+        void Tick();
+
+        /** No rebuild queued, running or waiting for Tick */
+        bool IsIdle() const;
+
+        const FHotReloadStats& GetStats() const { return Stats; }
+
+    private:
+        struct FNode
+        {
+            IReloadable* pObject = nullptr;
+            std::vector<FPath> Dependencies;
+            std::vector<FPath> Dependents;
+            std::chrono::steady_clock::time_point ChangeTime;     // Of the first change it is outdated by
+            bool bOutdated = false;     // Has to be rebuilt, also while building when it changed again
+            bool bBuilding = false;     // Queued or running, until its result is handled by Tick
+        };
+
+        struct FResult
+        {
+            FPath Name;
+            IReloadable* pObject;
+            std::chrono::steady_clock::time_point ChangeTime;
+            bool bSuccess;
+        };
+
+        void MarkDependentsOutdated(FPath Path, std::chrono::steady_clock::time_point ChangeTime);
+        void MarkOutdated(FPath Name, FNode& Node, std::chrono::steady_clock::time_point ChangeTime);
+        bool IsReadyToBuild(const FNode& Node) const;
+        bool DependsOn(const std::vector<FPath>& Dependencies, FPath Name) const;
+        void WorkerThread();
+
+        FFileWatcher Watcher;
+        std::unordered_map<FPath, FNode> Nodes;
+        std::vector<FPath> OutdatedNodes;
+        std::vector<FFileChange> Changes;
+        FHotReloadStats Stats;
+
+        mutable std::mutex Mutex;
+        std::condition_variable WorkAvailable;
+        std::condition_variable WorkDone;
+        std::deque<FResult> Queue;
+        std::unordered_set<IReloadable*> Running;
+        std::vector<FResult> Finished;
+        std::vector<std::thread> Workers;
+        bool bStopping = false;
+    };
+
+    /** Rebuilds an FStaticMesh from its glTF file with FStaticMesh::Build, the old geometry is released in Apply */
+    class FStaticMeshReloader : public IReloadable
+    {
+    public:
+        FStaticMeshReloader(FStaticMesh* pInMesh, const std::wstring& InSourcePath, const FStaticMeshBuildSettings& InSettings, FDerivedDataCache* pInCache = nullptr)
+            : pMesh(pInMesh)
+            , SourcePath(InSourcePath)
+            , Settings(InSettings)
+            , pCache(pInCache)
+        {
+        }
+
+        bool Rebuild() override;
+        void Apply() override;
+
+    private:
+        FStaticMesh* pMesh;
+        FStaticMesh Staging;
+        std::wstring SourcePath;
+        FStaticMeshBuildSettings Settings;
+        FDerivedDataCache* pCache;
+    };
+}
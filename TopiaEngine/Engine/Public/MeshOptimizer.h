@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float3.h>
+
+namespace topia
+{
+    /**
+     * Import time processing of indexed triangle lists. Everything works on u32 indices and plain arrays so the steps can run
+     * in tools without a device. The usual order is GenerateVertexRemap, OptimizeVertexCache, OptimizeOverdraw, OptimizeVertexFetch.
+     */
+
+    /** Post transform cache efficiency of a triangle list, simulated with a FIFO cache */
+    struct FVertexCacheStats
+    {
+        u32 NumTriangles = 0;
+        u32 NumVertices = 0;        // Vertices referenced by the indices
+        u32 NumTransformed = 0;     // Cache misses
+        float ACMR = 0.0f;          // Average cache miss ratio: transformed vertices per triangle, 0.5 is the best a large grid can get
+        float ATVR = 0.0f;          // Average transform to vertex ratio: transformed vertices per referenced vertex, 1 is optimal
+    };
+
+    FVertexCacheStats AnalyzeVertexCache(const u32* pIndices, u32 NumIndices, u32 NumVertices, u32 CacheSize = 16);
+
+    /** One attribute of a vertex buffer, NumVertices elements of Size bytes, Stride bytes apart */
+    struct FVertexStreamRef
+    {
+        const void* pData = nullptr;
+        u32 Size = 0;
+        u32 Stride = 0;
+    };
+
+    /**
+     * Find vertices that are bitwise identical in all streams. pOutRemap[v] receives the new index of vertex v, unique vertices are
+     * numbered in order of first appearance. Returns the number of unique vertices.
+     */
+    u32 GenerateVertexRemap(const FVertexStreamRef* pStreams, u32 NumStreams, u32 NumVertices, u32* pOutRemap);
+
+    /** Move the elements of a stream to their remapped position, pDest must have room for the unique vertices and differ from pSource */
+    void RemapVertexStream(void* pDest, const void* pSource, u32 ElementSize, u32 NumVertices, const u32* pRemap);
+
+    /** Replace every index with its remapped value, in place */
+    void RemapIndices(u32* pIndices, u32 NumIndices, const u32* pRemap);
+
+    /**
+     * Reorder triangles for the post transform cache with Tipsify (Sander et al. 2007): fan around the last vertex while its
+     * neighbours are likely still cached, jump back along the dead end stack otherwise. Linear time, in place.
+     */
+    void OptimizeVertexCache(u32* pIndices, u32 NumIndices, u32 NumVertices, u32 CacheSize = 16);
+
+    /**
+     * Reorder clusters of a cache optimized triangle list so surfaces facing outwards from the mesh center come first, which
+     * reduces overdraw from any view direction. Clusters are split further as long as their cache miss ratio stays within
+     * Threshold times the one of the patch they come from, so 1.05 allows about 5% more vertex transforms. Both are measured from an
+     * empty cache, reuse across patch boundaries of the input order can be lost on top of that.
+     */
+    void OptimizeOverdraw(u32* pIndices, u32 NumIndices, const Float3* pPositions, u32 NumVertices, float Threshold = 1.05f, u32 CacheSize = 16);
+
+    /**
+     * Renumber vertices in the order the indices first use them so vertex fetch walks memory forward. The indices are rewritten in
+     * place, pOutRemap works with RemapVertexStream. Returns the number of referenced vertices, unreferenced ones are dropped.
+     */
+    u32 OptimizeVertexFetch(u32* pIndices, u32 NumIndices, u32 NumVertices, u32* pOutRemap);
+}
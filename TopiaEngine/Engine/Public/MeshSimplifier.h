@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float3.h>
+
+namespace topia
+{
+    /**
+     * Reduce a triangle list with quadric error metric edge collapses (Garland and Heckbert 1997). Vertices only collapse onto
+     * their neighbours, so the result indexes the same vertex streams and no attribute has to be interpolated. Vertices that share a
+     * position but not their other attributes (attribute seams) collapse in pairs along the seam, vertices on open borders only
+     * along the border, and vertices where seams or borders meet or turn sharply are locked.
+     *
+     * Stops at TargetIndexCount or before a collapse whose error exceeds MaxError, which is relative to the largest extent of the
+     * mesh (0.01 = 1%). pOutIndices needs room for NumIndices indices and may be pIndices. Returns the number of indices written,
+     * pOutError receives the largest error of the collapses that were made, as a distance in the units of the positions. The error is
+     * the root of a quadric, an area weighted mean of squared distances to planes, so it estimates the distance to the original surface
+     * but doesn't bound it. pOutRemap (NumVertices entries) receives the vertex every vertex was collapsed onto, itself when it stayed.
+     */
+    u32 SimplifyMesh(const u32* pIndices, u32 NumIndices, const Float3* pPositions, u32 NumVertices, u32 TargetIndexCount, float MaxError,
+        u32* pOutIndices, float* pOutError = nullptr, u32* pOutRemap = nullptr);
+}
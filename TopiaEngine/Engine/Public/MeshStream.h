@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Topia.h>
+
+#include <vector>
+
+namespace topia
+{
+    /**
+     * One vertex, index or meshlet stream. The elements either live in the stream itself or, when the source or cooked file already has
+     * the right layout, are a view into the mapped file that the mesh keeps alive (see FStaticMesh::SourceData).
+     */
+    template <typename T>
+    class TMeshStream
+    {
+    public:
+        TMeshStream() = default;
+        TMeshStream(const TMeshStream&) = delete;
+        TMeshStream& operator=(const TMeshStream&) = delete;
+        TMeshStream(TMeshStream&&) = default; // Moving a std::vector keeps its buffer, so pData stays valid
+        TMeshStream& operator=(TMeshStream&&) = default;
+
+        const T* GetData() const { return pData; }
+        u32 Num() const { return Count; }
+        bool IsEmpty() const { return Count == 0; }
+        const T& operator[](u32 Index) const { ASSERT(Index < Count); return pData[Index]; }
+
+        /** True when the elements are read directly from a mapped file */
+        bool IsView() const { return Count > 0 && Storage.empty(); }
+
+        /** Reference InCount elements owned by someone else */
+        void SetView(const T* pInData, u32 InCount)
+        {
+            Storage.clear();
+            pData = pInData;
+            Count = InCount;
+        }
+
+        /** Allocate InCount uninitialized elements owned by the stream */
+        T* Allocate(u32 InCount)
+        {
+            Storage.resize(InCount);
+            pData = Storage.data();
+            Count = InCount;
+            return Storage.data();
+        }
+
+        /** Take over the elements of a vector */
+        void Assign(std::vector<T>&& InStorage)
+        {
+            Storage = std::move(InStorage);
+            pData = Storage.data();
+            Count = u32(Storage.size());
+        }
+
+        void Reset()
+        {
+            Storage.clear();
+            pData = nullptr;
+            Count = 0;
+        }
+
+    private:
+        const T* pData = nullptr;
+        u32 Count = 0;
+        std::vector<T> Storage;
+    };
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float3.h>
+
+#include "MeshStream.h"
+
+namespace topia
+{
+    class Frustum;
+
+    static constexpr u32 MESHLET_MAX_VERTICES = 64;
+    static constexpr u32 MESHLET_MAX_TRIANGLES = 124;
+
+    /** Ranges of a meshlet in FMeshletData::Vertices and FMeshletData::Triangles */
+    struct FMeshlet
+    {
+        u32 VertexOffset = 0;
+        u32 TriangleOffset = 0;
+        u8 NumVertices = 0;
+        u8 NumTriangles = 0;
+        u16 Padding = 0;
+    };
+
+    static_assert(sizeof(FMeshlet) == 12, "FMeshlet is uploaded as is");
+
+    /**
+     * Culling bounds of a meshlet: a bounding sphere and a cone that holds the normals of all its triangles. The cone is quantized
+     * conservatively: the axis is ConeAxis / |ConeAxis| and ConeCutoff / 127 is at least the sine of the half angle of the cone.
+     * ConeCutoff = 127 disables cone culling.
+     */
+    struct FMeshletBounds
+    {
+        Float3 Center;
+        float Radius = 0.0f;
+        s8 ConeAxis[3] = { 0, 0, 0 };
+        s8 ConeCutoff = 127;
+    };
+
+    static_assert(sizeof(FMeshletBounds) == 20, "FMeshletBounds is uploaded as is");
+
+    /** Meshlets of one section, every array is tightly packed and can be uploaded directly */
+    struct FMeshletData
+    {
+        TMeshStream<FMeshlet> Meshlets;
+        TMeshStream<FMeshletBounds> Bounds;     // One per meshlet
+        TMeshStream<u32> Vertices;              // Section vertex of every meshlet vertex
+        TMeshStream<u32> Triangles;             // Local vertex indices of a triangle, 8 bits each starting at the low byte
+
+        bool IsEmpty() const { return Meshlets.IsEmpty(); }
+        void Reset();
+    };
+
+    /**
+     * Split a triangle list into meshlets of at most MaxVertices vertices and MaxTriangles triangles. Meshlets are grown greedily
+     * from a seed triangle by adding the neighbour that brings the fewest new vertices, closest to the meshlet center, so a
+     * cache optimized index order (see OptimizeVertexCache) is not required but gives slightly better seeds.
+     */
+    void BuildMeshlets(const u32* pIndices, u32 NumIndices, const Float3* pPositions, u32 NumVertices, FMeshletData& OutData,
+        u32 MaxVertices = MESHLET_MAX_VERTICES, u32 MaxTriangles = MESHLET_MAX_TRIANGLES);
+
+    /**
+     * CPU reference of cluster culling. Writes the indices of the meshlets that overlap the frustum and have at least one triangle
+     * facing the camera, returns their number. Frustum and camera position must be in the space of the mesh.
+     */
+    u32 CullMeshlets(const FMeshletData& Data, const Frustum& ViewFrustum, const Float3& CameraPosition, u32* pOutVisible);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float2.h>
+#include <Float3.h>
+#include <Float4.h>
+
+namespace topia
+{
+    enum class EPrimitiveType : u8
+    {
+        None,
+        Plane,
+        Cube,
+        Sphere,
+        Icosphere,
+        Cylinder,
+        Capsule,
+        Torus,
+    };
+
+    /**
+     * Shape and tessellation of a generated primitive. Shapes are centered on the origin with Y up, round shapes revolve around Y.
+     * Triangles are counter clockwise seen from the front (like glTF), texture coordinates start at the top left and tangents have
+     * w = 1 with bitangent = cross(normal, tangent) pointing towards decreasing v.
+     */
+    struct FPrimitiveDesc
+    {
+        FPrimitiveDesc() = default;
+
+        /** Default size and tessellation for Type */
+        explicit FPrimitiveDesc(EPrimitiveType InType);
+
+        EPrimitiveType Type = EPrimitiveType::None;
+
+        Float3 Size = Float3(1.0f, 1.0f, 1.0f);    // Plane: x and z extent, cube: edge lengths
+        float Radius = 0.5f;                        // Sphere, icosphere, cylinder and capsule radius, torus distance from the center to the middle of the tube
+        float TubeRadius = 0.25f;                   // Torus
+        float Height = 1.0f;                        // Cylinder height, length of the straight part of a capsule
+
+        u32 Segments = 32;      // Subdivisions around the Y axis (sphere, cylinder, capsule, torus)
+        u32 Rings = 16;         // Sphere: top to bottom, capsule: per hemisphere, cylinder: along the height, torus: around the tube
+        u32 Subdivisions = 1;   // Plane and cube: cells along each edge, icosphere: segments per edge of the icosahedron
+    };
+
+    /** Exact output size of a primitive, known before generating it */
+    struct FPrimitiveCounts
+    {
+        u32 NumVertices = 0;
+        u32 NumIndices = 0;
+    };
+
+    /**
+     * Destination of GeneratePrimitive, each stream must have room for the counts of GetPrimitiveCounts. Vertex streams that are
+     * null are skipped. Exactly one index stream must be set, 16 bit indices can be used when NumVertices <= 65536.
+     */
+    struct FPrimitiveStreams
+    {
+        Float3* pPositions = nullptr;
+        Float3* pNormals = nullptr;
+        Float4* pTangents = nullptr;
+        Float2* pTexCoords = nullptr;
+        u16* pIndices16 = nullptr;
+        u32* pIndices32 = nullptr;
+    };
+
+    FPrimitiveCounts GetPrimitiveCounts(const FPrimitiveDesc& Desc);
+
+    /** Write the vertices and triangle list of a primitive, tessellation values below the minimum of the shape are clamped */
+    void GeneratePrimitive(const FPrimitiveDesc& Desc, const FPrimitiveStreams& Streams);
+}
@@ -1,33 +1,143 @@
 #pragma once
 
 #include <Topia.h>
+#include <Float2.h>
+#include <Float3.h>
+#include <Float4.h>
+#include <TopiaMath.h>
+#include <AABox.h>
+#include <ThreadPool.h>
 #include <RHIForwardDecl.h>
 
 #include "EngineForwardDecl.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshStream.h"
+#include "Meshlets.h"
+#include "PrimitiveGenerator.h"
+#include "TangentGenerator.h"
+#include "VertexQuantization.h"
 
+#ifndef TOPIA_NO_EASTL
 #include <EASTL/fixed_vector.h>
+#endif
+
+#include <memory>
 
 namespace topia
 {
-    enum class EPrimitiveType : u8
+    /** Vertex attributes a mesh can have, the material decides which ones are loaded. */
+    enum class EVertexAttributes : u32
+    {
+        None      = 0,
+        Position  = 1 << 0,
+        Normal    = 1 << 1,
+        Tangent   = 1 << 2,
+        TexCoord0 = 1 << 3,
+        TexCoord1 = 1 << 4,
+        Color0    = 1 << 5,
+        All       = Position | Normal | Tangent | TexCoord0 | TexCoord1 | Color0,
+    };
+
+    ENUM_CLASS_FLAG_OPERATORS(EVertexAttributes)
+
+    /** Simplified triangle list of a section, indexes the vertices of the section */
+    struct FStaticMeshLOD
+    {
+        /** Only one of the two is used, the same one as in the section */
+        TMeshStream<u16> Indices16;
+        TMeshStream<u32> Indices32;
+
+        u32 GetNumIndices() const { return Indices16.Num() + Indices32.Num(); }
+    };
+
+    /** Part of a mesh drawn with a single material */
+    struct FStaticMeshSection
+    {
+        u32 NumVertices = 0;
+        u32 MaterialIndex = 0;  // Index of the material in the source file, ~0u when it has none
+
+        TMeshStream<Float3> Positions;
+        TMeshStream<Float3> Normals;
+        TMeshStream<Float4> Tangents;   // w is the handedness of the bitangent
+        TMeshStream<Float2> TexCoords[2];
+        TMeshStream<Float4> Colors;
+
+        /** Triangle list, only one of the two is used */
+        TMeshStream<u16> Indices16;
+        TMeshStream<u32> Indices32;
+
+        /** Clusters of the triangle list for GPU culling, see FStaticMesh::BuildMeshlets */
+        FMeshletData Meshlets;
+
+        /** GPU vertex format, see FStaticMesh::Quantize */
+        FQuantizedVertexData Quantized;
+
+        /** Triangle lists of LOD 1 and up, LOD 0 is the triangle list above. See FStaticMesh::GenerateLODs */
+        std::vector<FStaticMeshLOD> LODs;
+
+        u32 GetNumIndices() const { return Indices16.Num() + Indices32.Num(); }
+    };
+
+    /** Result of FStaticMesh::Optimize, summed over all sections */
+    struct FMeshOptimizeStats
+    {
+        u32 NumVerticesBefore = 0;
+        u32 NumVerticesAfter = 0;
+        FVertexCacheStats Before;
+        FVertexCacheStats After;
+    };
+
+    /** Result of FStaticMesh::Quantize, over all sections */
+    struct FMeshQuantizeStats
+    {
+        u64 BytesBefore = 0;    // Float vertex streams
+        u64 BytesAfter = 0;     // Quantized vertex streams
+        FQuantizationError MaxError;
+    };
+
+    /** Settings of FStaticMesh::GenerateLODs */
+    struct FLODSettings
+    {
+        u32 NumLODs = 4;            // Including LOD 0, fewer are generated when the mesh stops simplifying
+        float TriangleRatio = 0.5f; // Triangles of a LOD relative to the previous one
+        float MaxError = 0.02f;     // Largest error of one step, relative to the size of the section
+    };
+
+    /** Import steps of FStaticMesh::Build, each one is the FStaticMesh function of the same name */
+    struct FStaticMeshBuildSettings
+    {
+        EVertexAttributes RequiredAttributes = EVertexAttributes::All;
+        bool bGenerateTangents = false;
+        bool bOptimize = true;
+        float OverdrawThreshold = 1.05f;
+        bool bBuildMeshlets = true;
+        bool bQuantize = true;
+        EOctahedralPrecision Precision = EOctahedralPrecision::Bits8;
+        FLODSettings LODs;          // NumLODs 1 for none
+    };
+
+    /** Per LOD of a mesh, summed over its sections */
+    struct FStaticMeshLODInfo
     {
-        None,
-        Plane,
-        Cube,
-        Sphere,
+        float Error = 0.0f;         // Largest distance from the vertices of LOD 0 to the surface of this LOD in mesh units, never less than the previous LOD's
+        u32 NumTriangles = 0;
     };
 
     class FStaticMesh
     {
         /** Data */
     protected:
-        // vertex buffer;
-        // index buffer;
-        // local positions;
-        // local normal, tangnet, bitangent;
-        // uv0, uv1, etc;
-        // vertex color;
-        //
+        std::vector<FStaticMeshSection> Sections;
+
+        /** Keeps the mapped source files alive while sections reference them */
+        std::vector<std::shared_ptr<const void>> SourceData;
+
+        /** One per LOD including LOD 0, empty until GenerateLODs */
+        std::vector<FStaticMeshLODInfo> LODInfos;
+
+        /** Bounding box of the positions of all sections */
+        AABox Bounds;
 
     private:
         FShader* pShader = nullptr;
@@ -35,7 +145,99 @@ namespace topia
 
         /** Loader */
     public:
-        void LoadFromGLTF();
+        /**
+         * Load all triangle primitives of a glTF 2.0 file (.gltf or .glb) as sections, in mesh space (node transforms are not applied).
+         * Only RequiredAttributes are decoded, normally the vertex inputs of the material's shader. Streams whose layout in the file
+         * already matches are not copied: the file is memory mapped and the stream points into it.
+         * Returns false and leaves the mesh empty when the file can't be loaded.
+         */
+        bool LoadFromGLTF(const std::wstring& Path, EVertexAttributes RequiredAttributes = EVertexAttributes::All);
+
+        /**
+         * Save the mesh with everything built for it (meshlets, quantized streams, LODs) in the cooked format of CookedMesh.h.
+         * The file is replaced atomically. Returns false when it can't be written.
+         */
+        bool SaveCooked(const std::wstring& Path) const;
+
+        /**
+         * Load a mesh saved by SaveCooked. The file is memory mapped and every stream points into it, nothing is decoded or copied.
+         * The content hash is only checked with bVerifyHash since that reads the whole file. Index values, meshlet ranges and LOD
+         * counts are always checked, a cache hit skips the hash but must not make anything read outside the streams.
+         * Returns false and leaves the mesh empty when the file is missing, has another version or is malformed.
+         */
+        bool LoadCooked(const std::wstring& Path, bool bVerifyHash = false);
+
+        /**
+         * Load a glTF file and run the import steps of Settings on it. With a cache, the result is looked up by the content of the
+         * file and the settings: a hit is loaded like LoadCooked from the mapped entry, a miss is built and stored in the cache.
+         * Returns false and leaves the mesh empty when the file can't be loaded. The sections are processed on pPool when given.
+         */
+        bool Build(const std::wstring& SourcePath, const FStaticMeshBuildSettings& Settings, FDerivedDataCache* pCache = nullptr, FThreadPool* pPool = nullptr);
+
+        /** Load a primitive with the default size and tessellation of its type */
         void LoadPrimitive(EPrimitiveType PrimitiveType);
+
+        /** Generate a primitive as a single section. Positions are always generated, of the other attributes only normals, tangents and TexCoord0. */
+        void LoadPrimitive(const FPrimitiveDesc& Desc, EVertexAttributes RequiredAttributes = EVertexAttributes::All);
+
+        /**
+         * Import time optimization of every section: merge bitwise identical vertices, reorder triangles for the post transform
+         * cache and for overdraw, then store the vertices in the order the triangles use them. Streams that were views into the
+         * source file become owned by the mesh.
+         */
+        FMeshOptimizeStats Optimize(float OverdrawThreshold = 1.05f);
+
+        /**
+         * Build the quantized vertex streams of every section: positions as 16 bit fractions of the section bounds, octahedral
+         * normals and tangents, half float texture coordinates and 8 bit colors. The float streams are kept for CPU use.
+         */
+        FMeshQuantizeStats Quantize(EOctahedralPrecision Precision = EOctahedralPrecision::Bits8);
+
+        /**
+         * Replace the tangents of every section with MikkTSpace tangents computed from the normals and TexCoord0, sections are
+         * distributed over pPool (on the calling thread without one). Vertices whose triangles need different tangents,
+         * as on mirrored texture coordinates, are split. Clears meshlets, quantized streams and LODs, so call it before those.
+         * Returns false when a section has no normals or texture coordinates, it keeps its tangents.
+         */
+        bool GenerateTangents(FThreadPool* pPool = nullptr);
+
+        /** Split every section into meshlets, sections are distributed over pPool (on the calling thread without one) */
+        void BuildMeshlets(FThreadPool* pPool = nullptr);
+
+        /**
+         * Build a LOD chain with SimplifyMesh: every LOD simplifies the previous one to Settings.TriangleRatio of its triangles,
+         * sections are simplified separately so they keep their material. Replaces the existing LODs. The error of a LOD is measured
+         * after simplifying as the largest distance from a vertex of LOD 0 to the triangles of the LOD in the same section, found with
+         * a BVH of the LOD's triangles.
+         */
+        void GenerateLODs(const FLODSettings& Settings = FLODSettings());
+
+        /** GenerateLODs of many meshes, distributed over pPool (on the calling thread without one) */
+        static void GenerateLODs(FStaticMesh* const* ppMeshes, u32 NumMeshes, const FLODSettings& Settings = FLODSettings(), FThreadPool* pPool = nullptr);
+
+        /**
+         * Coarsest LOD whose error projects to at most MaxPixelError pixels at Distance from the camera. ProjectionScale converts a
+         * size at distance 1 to pixels: viewport height / (2 * tan(vertical fov / 2)) for a perspective projection.
+         */
+        u32 SelectLOD(float Distance, float ProjectionScale, float MaxPixelError) const;
+
+        void Reset();
+
+        /** Exchange the geometry (sections, LODs, bounds) with Other, the shader and material stay. Used to swap a rebuilt mesh in. */
+        void SwapGeometry(FStaticMesh& Other);
+
+        const std::vector<FStaticMeshSection>& GetSections() const { return Sections; }
+        const std::vector<FStaticMeshLODInfo>& GetLODInfos() const { return LODInfos; }
+        const AABox& GetBounds() const { return Bounds; }
+        u32 GetNumLODs() const { return std::max(1u, u32(LODInfos.size())); }
+
+    protected:
+        bool LoadFromGLTFAsset(const FGLTFAsset& Asset, EVertexAttributes RequiredAttributes);
+
+        /** The cooked file of SaveCooked, in memory */
+        void WriteCookedData(std::vector<u8>& OutData) const;
+
+        /** LoadCooked from Size bytes at pData, Owner keeps them alive */
+        bool LoadCookedData(const std::shared_ptr<const void>& Owner, const u8* pData, u64 Size, bool bVerifyHash);
     };
 }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float2.h>
+#include <Float3.h>
+#include <Float4.h>
+
+namespace topia
+{
+    /**
+     * Tangent space of every triangle corner as computed by MikkTSpace (genTangSpaceDefault) for the same triangles: xyz is the
+     * tangent, w the sign of the bitangent (bitangent = w * cross(normal, tangent) points towards increasing v, glTF and
+     * FPrimitiveDesc use the opposite sign). Corners of one vertex usually agree, they don't where the vertex is shared by
+     * triangles with mirrored texture coordinates or otherwise unconnected fans.
+     *
+     * Vertices with equal position, normal and texture coordinate are treated as one, like MikkTSpace does. The steps follow the
+     * reference implementation; TopiaTests can optionally compare the two when it is configured with TOPIA_MIKKTSPACE_DIR.
+     * pOutTangents receives NumIndices tangents.
+     */
+    void GenerateTangents(const u32* pIndices, u32 NumIndices, const Float3* pPositions, const Float3* pNormals, const Float2* pTexCoords,
+        u32 NumVertices, Float4* pOutTangents);
+}
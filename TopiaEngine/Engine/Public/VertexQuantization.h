@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Topia.h>
+#include <Float2.h>
+#include <Float3.h>
+#include <Float4.h>
+#include <TopiaMath.h>
+#include <HalfFloat.h>
+
+#include "MeshStream.h"
+
+namespace topia
+{
+    /** Bits per component of octahedral encoded normals and tangents */
+    enum class EOctahedralPrecision : u8
+    {
+        Bits8,  // R8G8_SNORM normals, R8G8B8A8_SNORM tangents. Up to ~1 degree of error, enough for most meshes
+        Bits16, // R16G16_SNORM normals, R16G16B16A16_SNORM tangents
+    };
+
+    /** Position as 16 bit fractions of the bounding box (R16G16B16A16_UNORM), W is unused */
+    struct FQuantizedPosition
+    {
+        u16 X = 0;
+        u16 Y = 0;
+        u16 Z = 0;
+        u16 W = 0;
+    };
+
+    static_assert(sizeof(FQuantizedPosition) == 8, "FQuantizedPosition is uploaded as is");
+
+    /** Decoded position = Offset + Value * Scale, with Value the unorm value in [0, 1]. Scale is the size of the bounding box */
+    struct FPositionQuantization
+    {
+        Float3 Offset;
+        Float3 Scale;
+    };
+
+    /** Compressed copy of the vertex streams of a section for the GPU, see FStaticMesh::Quantize. Empty streams stay empty */
+    struct FQuantizedVertexData
+    {
+        EOctahedralPrecision Precision = EOctahedralPrecision::Bits8;
+        FPositionQuantization PositionQuantization;
+
+        TMeshStream<FQuantizedPosition> Positions;
+        TMeshStream<u8> Normals;                // GetOctahedralNormalSize(Precision) bytes per vertex
+        TMeshStream<u8> Tangents;               // GetOctahedralTangentSize(Precision) bytes per vertex
+        TMeshStream<HalfFloat> TexCoords[2];    // 2 per vertex
+        TMeshStream<u32> Colors;                // R8G8B8A8_UNORM
+
+        bool IsEmpty() const { return Positions.IsEmpty(); }
+
+        /** Bytes per vertex over all streams */
+        u32 GetVertexSize() const;
+
+        void Reset();
+    };
+
+    /** Largest difference between original and decoded attributes */
+    struct FQuantizationError
+    {
+        float Position = 0.0f;      // Distance in mesh units
+        float NormalAngle = 0.0f;   // Degrees
+        float TangentAngle = 0.0f;  // Degrees, a flipped handedness counts as 180
+        float TexCoord = 0.0f;
+        float Color = 0.0f;
+    };
+
+    /** Bytes per encoded normal or tangent */
+    inline u32 GetOctahedralNormalSize(EOctahedralPrecision Precision) { return Precision == EOctahedralPrecision::Bits8 ? 2 : 4; }
+    inline u32 GetOctahedralTangentSize(EOctahedralPrecision Precision) { return Precision == EOctahedralPrecision::Bits8 ? 4 : 8; }
+
+    /** Bounding box of the positions as quantization range */
+    FPositionQuantization ComputePositionQuantization(const Float3* pPositions, u32 NumVertices);
+
+    /**
+     * Encode and decode kernels. Normals and tangents are processed 4 per iteration as Vec4 components, texture coordinates 2 per
+     * half float conversion, positions and colors one at a time with a Vec4 each. Normals and the xyz of tangents are expected to
+     * be unit length. Tangents keep the handedness of the bitangent (the sign of w) in the third component.
+     */
+    void QuantizePositions(const Float3* pPositions, u32 NumVertices, const FPositionQuantization& Quantization, FQuantizedPosition* pOutPositions);
+    void DequantizePositions(const FQuantizedPosition* pPositions, u32 NumVertices, const FPositionQuantization& Quantization, Float3* pOutPositions);
+
+    void EncodeOctahedralNormals(const Float3* pNormals, u32 NumVertices, EOctahedralPrecision Precision, void* pOutNormals);
+    void DecodeOctahedralNormals(const void* pNormals, u32 NumVertices, EOctahedralPrecision Precision, Float3* pOutNormals);
+
+    void EncodeOctahedralTangents(const Float4* pTangents, u32 NumVertices, EOctahedralPrecision Precision, void* pOutTangents);
+    void DecodeOctahedralTangents(const void* pTangents, u32 NumVertices, EOctahedralPrecision Precision, Float4* pOutTangents);
+
+    /** Two half floats per element (R16G16_FLOAT) */
+    void EncodeHalfTexCoords(const Float2* pTexCoords, u32 NumVertices, HalfFloat* pOutTexCoords);
+    void DecodeHalfTexCoords(const HalfFloat* pTexCoords, u32 NumVertices, Float2* pOutTexCoords);
+
+    /** R8G8B8A8_UNORM, components are clamped to [0, 1] */
+    void EncodeUnormColors(const Float4* pColors, u32 NumVertices, u32* pOutColors);
+    void DecodeUnormColors(const u32* pColors, u32 NumVertices, Float4* pOutColors);
+}
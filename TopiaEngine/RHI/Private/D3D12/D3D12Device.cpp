@@ -0,0 +1,485 @@
+#include "D3D12RHI.h"
+
+#if ENABLE_RHI_D3D12
+
+namespace topia
+{
+    DXGI_FORMAT GetDXGIFormat(EPixelFormat Format)
+    {
+        static const DXGI_FORMAT Formats[] =
+        {
+            DXGI_FORMAT_UNKNOWN,
+            DXGI_FORMAT_R8G8B8A8_UNORM,
+            DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+            DXGI_FORMAT_B8G8R8A8_UNORM,
+            DXGI_FORMAT_R8G8B8A8_SNORM,
+            DXGI_FORMAT_R16G16_FLOAT,
+            DXGI_FORMAT_R16G16B16A16_FLOAT,
+            DXGI_FORMAT_R16G16B16A16_SNORM,
+            DXGI_FORMAT_R16_UINT,
+            DXGI_FORMAT_R32_UINT,
+            DXGI_FORMAT_R32_FLOAT,
+            DXGI_FORMAT_R32G32_FLOAT,
+            DXGI_FORMAT_R32G32B32_FLOAT,
+            DXGI_FORMAT_R32G32B32A32_FLOAT,
+            DXGI_FORMAT_D32_FLOAT,
+            DXGI_FORMAT_D24_UNORM_S8_UINT,
+        };
+        static_assert(_countof(Formats) == size_t(EPixelFormat::Num), "Every format needs a DXGI format");
+        return Formats[u32(Format)];
+    }
+
+    D3D12_RESOURCE_STATES GetD3D12ResourceState(EResourceState State)
+    {
+        static const D3D12_RESOURCE_STATES States[] =
+        {
+            D3D12_RESOURCE_STATE_COMMON,
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+            D3D12_RESOURCE_STATE_INDEX_BUFFER,
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_DEPTH_WRITE,
+            D3D12_RESOURCE_STATE_DEPTH_READ,
+            D3D12_RESOURCE_STATE_COPY_SOURCE,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_PRESENT,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+        };
+        static_assert(_countof(States) == size_t(EResourceState::Num), "Every state needs a D3D12 state");
+        return States[u32(State)];
+    }
+
+    void FD3D12DescriptorHeap::Initialize(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE Type, u32 InNumDescriptors)
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
+        HeapDesc.Type           = Type;
+        HeapDesc.NumDescriptors = InNumDescriptors;
+        HeapDesc.Flags          = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        ASSERT_SUCCEEDED(pDevice->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&Heap)));
+
+        Start = Heap->GetCPUDescriptorHandleForHeapStart();
+        DescriptorSize = pDevice->GetDescriptorHandleIncrementSize(Type);
+        NumDescriptors = InNumDescriptors;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE FD3D12DescriptorHeap::Allocate()
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        u32 Index;
+        if (!FreeIndices.empty())
+        {
+            Index = FreeIndices.back();
+            FreeIndices.pop_back();
+        }
+        else if (NumAllocated < NumDescriptors)
+        {
+            Index = NumAllocated++;
+        }
+        else
+        {
+            return D3D12_CPU_DESCRIPTOR_HANDLE{ 0 };
+        }
+        return D3D12_CPU_DESCRIPTOR_HANDLE{ Start.ptr + SIZE_T(Index) * DescriptorSize };
+    }
+
+    void FD3D12DescriptorHeap::Free(D3D12_CPU_DESCRIPTOR_HANDLE Handle)
+    {
+        if (Handle.ptr != 0)
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            FreeIndices.push_back(u32((Handle.ptr - Start.ptr) / DescriptorSize));
+        }
+    }
+
+    void* FD3D12Buffer::Map()
+    {
+        // Upload buffers are only written by the CPU, readback buffers are read
+        const D3D12_RANGE NoRead = { 0, 0 };
+        void* pData = nullptr;
+        if (Desc.Memory == EMemoryType::Default || FAILED(Resource->Map(0, Desc.Memory == EMemoryType::Upload ? &NoRead : nullptr, &pData)))
+        {
+            return nullptr;
+        }
+        return pData;
+    }
+
+    void FD3D12Buffer::Unmap()
+    {
+        const D3D12_RANGE NoWrite = { 0, 0 };
+        Resource->Unmap(0, Desc.Memory == EMemoryType::Readback ? &NoWrite : nullptr);
+    }
+
+    FD3D12Texture::FD3D12Texture(FD3D12Device* pInDevice, const FTextureDesc& InDesc, ID3D12Resource* pInResource)
+        : FRHITexture(InDesc)
+        , pDevice(pInDevice)
+        , Resource(pInResource)
+    {
+        if ((Desc.Usage & ETextureUsage::RenderTarget) != 0)
+        {
+            RenderTargetView = pDevice->RenderTargetViewHeap.Allocate();
+            pDevice->GetDevice()->CreateRenderTargetView(Resource.Get(), nullptr, RenderTargetView);
+        }
+        if ((Desc.Usage & ETextureUsage::DepthStencil) != 0)
+        {
+            DepthStencilView = pDevice->DepthStencilViewHeap.Allocate();
+            pDevice->GetDevice()->CreateDepthStencilView(Resource.Get(), nullptr, DepthStencilView);
+        }
+    }
+
+    FD3D12Texture::~FD3D12Texture()
+    {
+        pDevice->RenderTargetViewHeap.Free(RenderTargetView);
+        pDevice->DepthStencilViewHeap.Free(DepthStencilView);
+    }
+
+    FD3D12Fence::FD3D12Fence(ID3D12Fence* pInFence)
+        : Fence(pInFence)
+        , Event(::CreateEventW(nullptr, FALSE, FALSE, nullptr))
+    {
+    }
+
+    FD3D12Fence::~FD3D12Fence()
+    {
+        ::CloseHandle(Event);
+    }
+
+    void FD3D12Fence::Wait(u64 Value)
+    {
+        if (Fence->GetCompletedValue() < Value)
+        {
+            ASSERT_SUCCEEDED(Fence->SetEventOnCompletion(Value, Event));
+            ::WaitForSingleObject(Event, INFINITE);
+        }
+    }
+
+    FD3D12Device::FD3D12Device()
+    {
+#if defined(_DEBUG)
+        TRefCountPtr<ID3D12Debug> DebugInterface;
+        ASSERT_SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&DebugInterface)));
+        DebugInterface->EnableDebugLayer();
+#endif
+
+        UINT CreateFactoryFlags = 0;
+#if defined(_DEBUG)
+        CreateFactoryFlags |= DXGI_CREATE_FACTORY_DEBUG;
+#endif
+
+        ASSERT_SUCCEEDED(CreateDXGIFactory2(CreateFactoryFlags, IID_PPV_ARGS(&DXGIFactory4)));
+
+        // Enumrate Adapters.
+        {
+            u64 MaxDedicatedMem = 0;
+            TRefCountPtr<IDXGIAdapter1> pDXGIAdapter1;
+            for (u32 i = 0; DXGIFactory4->EnumAdapters1(i, &pDXGIAdapter1) != DXGI_ERROR_NOT_FOUND; ++i)
+            {
+                DXGI_ADAPTER_DESC1 AdapterDesc1;
+                pDXGIAdapter1->GetDesc1(&AdapterDesc1);
+
+                if ((AdapterDesc1.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0 && SUCCEEDED(D3D12CreateDevice(pDXGIAdapter1.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr)) &&
+                    AdapterDesc1.DedicatedVideoMemory > MaxDedicatedMem)
+                {
+                    MaxDedicatedMem = AdapterDesc1.DedicatedVideoMemory;
+                    ASSERT_SUCCEEDED(pDXGIAdapter1->QueryInterface(IID_PPV_ARGS(&DXGIAdapter4)))
+                }
+            }
+        }
+
+        // Create DirectX12 Device.
+        {
+            ASSERT_SUCCEEDED(D3D12CreateDevice(DXGIAdapter4.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&Context.Device)))
+
+#if defined(_DEBUG)
+                TRefCountPtr<ID3D12InfoQueue> pInfoQueue;
+            if (SUCCEEDED(Context.Device->QueryInterface(IID_PPV_ARGS(&pInfoQueue))))
+            {
+                pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE);
+                pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
+                pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, TRUE);
+
+                D3D12_MESSAGE_SEVERITY Severities[] = { D3D12_MESSAGE_SEVERITY_INFO };
+
+                D3D12_MESSAGE_ID DenyIds[] = { D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE, D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE, D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE };
+
+                D3D12_INFO_QUEUE_FILTER InfoQueueFilter = {};
+                InfoQueueFilter.DenyList.NumSeverities = _countof(Severities);
+                InfoQueueFilter.DenyList.pSeverityList = Severities;
+                InfoQueueFilter.DenyList.NumIDs        = _countof(DenyIds);
+                InfoQueueFilter.DenyList.pIDList       = DenyIds;
+
+                ASSERT_SUCCEEDED(pInfoQueue->PushStorageFilter(&InfoQueueFilter));
+            }
+#endif
+        }
+
+        // Create Command Queues.
+        {
+            D3D12_COMMAND_QUEUE_DESC CommandQueueDesc;
+
+            /** Graphics Command Queue. */
+            CommandQueueDesc.Type     = D3D12_COMMAND_LIST_TYPE_DIRECT;
+            CommandQueueDesc.Flags    = D3D12_COMMAND_QUEUE_FLAG_NONE;
+            CommandQueueDesc.NodeMask = 0;
+            CommandQueueDesc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+            ASSERT_SUCCEEDED(Context.Device->CreateCommandQueue(&CommandQueueDesc, IID_PPV_ARGS(&Context.GraphicsCommandQueue)));
+
+            /** Graphics Compute Queue. */
+            CommandQueueDesc.Type     = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+            CommandQueueDesc.Flags    = D3D12_COMMAND_QUEUE_FLAG_NONE;
+            CommandQueueDesc.NodeMask = 0;
+            CommandQueueDesc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+            ASSERT_SUCCEEDED(Context.Device->CreateCommandQueue(&CommandQueueDesc, IID_PPV_ARGS(&Context.ComputeCommandQueue)));
+
+            /** Graphics Copy Queue. */
+            CommandQueueDesc.Type     = D3D12_COMMAND_LIST_TYPE_COPY;
+            CommandQueueDesc.Flags    = D3D12_COMMAND_QUEUE_FLAG_NONE;
+            CommandQueueDesc.NodeMask = 0;
+            CommandQueueDesc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+            ASSERT_SUCCEEDED(Context.Device->CreateCommandQueue(&CommandQueueDesc, IID_PPV_ARGS(&Context.CopyCommandQueue)));
+
+            Queues[u32(ERHIQueueType::Graphics)].reset(new FD3D12Queue(this, ERHIQueueType::Graphics, Context.GraphicsCommandQueue.Get()));
+            Queues[u32(ERHIQueueType::Compute)].reset(new FD3D12Queue(this, ERHIQueueType::Compute, Context.ComputeCommandQueue.Get()));
+            Queues[u32(ERHIQueueType::Copy)].reset(new FD3D12Queue(this, ERHIQueueType::Copy, Context.CopyCommandQueue.Get()));
+        }
+
+        // Create Descriptor Heaps and the Root Signature.
+        {
+            RenderTargetViewHeap.Initialize(Context.Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 1024);
+            DepthStencilViewHeap.Initialize(Context.Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 256);
+
+            CD3DX12_ROOT_PARAMETER RootParameters[NUM_ROOT_PARAMETERS];
+            RootParameters[ROOT_PARAMETER_CONSTANTS].InitAsConstants(RHI_MAX_CONSTANTS, 0);
+            for (u32 Slot = 0; Slot < RHI_MAX_CONSTANT_BUFFERS; ++Slot)
+            {
+                RootParameters[ROOT_PARAMETER_CONSTANT_BUFFERS + Slot].InitAsConstantBufferView(1 + Slot);
+            }
+            for (u32 Slot = 0; Slot < RHI_MAX_SHADER_RESOURCES; ++Slot)
+            {
+                RootParameters[ROOT_PARAMETER_SHADER_RESOURCES + Slot].InitAsShaderResourceView(Slot);
+            }
+
+            CD3DX12_ROOT_SIGNATURE_DESC RootSignatureDesc(NUM_ROOT_PARAMETERS, RootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+            TRefCountPtr<ID3DBlob> Signature;
+            TRefCountPtr<ID3DBlob> Error;
+            ASSERT_SUCCEEDED(D3D12SerializeRootSignature(&RootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &Signature, &Error));
+            ASSERT_SUCCEEDED(Context.Device->CreateRootSignature(0, Signature->GetBufferPointer(), Signature->GetBufferSize(), IID_PPV_ARGS(&RootSignature)));
+        }
+
+        // Create Swap Chain.
+        {
+            TRefCountPtr<IDXGISwapChain1> pSwapChain1;
+
+            DXGI_SWAP_CHAIN_DESC1 SwapChainDesc1 = {};
+            SwapChainDesc1.Width       = GfxSettings.WindowWidth;
+            SwapChainDesc1.Height      = GfxSettings.WindowHeight;
+            SwapChainDesc1.Format      = DXGI_FORMAT_R8G8B8A8_UNORM;
+            SwapChainDesc1.Stereo      = FALSE;
+            SwapChainDesc1.SampleDesc  = { 1, 0 };
+            SwapChainDesc1.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+            SwapChainDesc1.BufferCount = BACK_BUFFER_SIZE;
+            SwapChainDesc1.Scaling     = DXGI_SCALING_STRETCH;
+            SwapChainDesc1.SwapEffect  = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+            SwapChainDesc1.AlphaMode   = DXGI_ALPHA_MODE_UNSPECIFIED;
+            SwapChainDesc1.Flags       = GfxSettings.bEnableTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+
+            ASSERT_SUCCEEDED(DXGIFactory4->CreateSwapChainForHwnd(Context.GraphicsCommandQueue.Get(), static_cast<HWND>(GfxSettings.WindowHandle), &SwapChainDesc1, nullptr, nullptr, &pSwapChain1))
+            ASSERT_SUCCEEDED(DXGIFactory4->MakeWindowAssociation(static_cast<HWND>(GfxSettings.WindowHandle), DXGI_MWA_NO_ALT_ENTER))
+            ASSERT_SUCCEEDED(pSwapChain1->QueryInterface(IID_PPV_ARGS(&DXGISwapChain4)))
+
+            FTextureDesc BackBufferDesc;
+            BackBufferDesc.Width  = GfxSettings.WindowWidth;
+            BackBufferDesc.Height = GfxSettings.WindowHeight;
+            BackBufferDesc.Format = EPixelFormat::R8G8B8A8_UNORM;
+            BackBufferDesc.Usage  = ETextureUsage::RenderTarget;
+            for (u32 i = 0; i < BACK_BUFFER_SIZE; ++i)
+            {
+                TRefCountPtr<ID3D12Resource> Resource;
+                ASSERT_SUCCEEDED(DXGISwapChain4->GetBuffer(i, IID_PPV_ARGS(&Resource)));
+                BackBuffers[i] = TRefCountPtr<FRHITexture>::Create(new RefCounter<FD3D12Texture>(this, BackBufferDesc, Resource.Get()));
+            }
+        }
+    }
+
+    FD3D12Device::~FD3D12Device()
+    {
+        WaitIdle();
+        for (TRefCountPtr<FRHITexture>& BackBuffer : BackBuffers)
+        {
+            BackBuffer = nullptr;
+        }
+    }
+
+    TRefCountPtr<FRHIBuffer> FD3D12Device::CreateBuffer(const FBufferDesc& Desc)
+    {
+        D3D12_HEAP_TYPE HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        D3D12_RESOURCE_STATES InitialState = D3D12_RESOURCE_STATE_COMMON;
+        if (Desc.Memory == EMemoryType::Upload)
+        {
+            HeapType = D3D12_HEAP_TYPE_UPLOAD;
+            InitialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+        }
+        else if (Desc.Memory == EMemoryType::Readback)
+        {
+            HeapType = D3D12_HEAP_TYPE_READBACK;
+            InitialState = D3D12_RESOURCE_STATE_COPY_DEST;
+        }
+
+        const CD3DX12_HEAP_PROPERTIES HeapProperties(HeapType);
+        const D3D12_RESOURCE_FLAGS Flags = (Desc.Usage & EBufferUsage::UnorderedAccess) != 0 ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+        const CD3DX12_RESOURCE_DESC ResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(Desc.Size, Flags);
+
+        TRefCountPtr<ID3D12Resource> Resource;
+        if (Desc.Size == 0 || FAILED(Context.Device->CreateCommittedResource(&HeapProperties, D3D12_HEAP_FLAG_NONE, &ResourceDesc, InitialState, nullptr, IID_PPV_ARGS(&Resource))))
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHIBuffer>::Create(new RefCounter<FD3D12Buffer>(Desc, Resource.Get()));
+    }
+
+    TRefCountPtr<FRHITexture> FD3D12Device::CreateTexture(const FTextureDesc& Desc)
+    {
+        D3D12_RESOURCE_FLAGS Flags = D3D12_RESOURCE_FLAG_NONE;
+        if ((Desc.Usage & ETextureUsage::RenderTarget) != 0)
+        {
+            Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+        }
+        if ((Desc.Usage & ETextureUsage::DepthStencil) != 0)
+        {
+            Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        }
+        if ((Desc.Usage & ETextureUsage::UnorderedAccess) != 0)
+        {
+            Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        }
+
+        const DXGI_FORMAT Format = GetDXGIFormat(Desc.Format);
+        const CD3DX12_HEAP_PROPERTIES HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+        const CD3DX12_RESOURCE_DESC ResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(Format, Desc.Width, Desc.Height, 1, u16(Desc.MipLevels), 1, 0, Flags);
+
+        // Clears to the optimized value are the fastest
+        D3D12_CLEAR_VALUE ClearValue = {};
+        ClearValue.Format = Format;
+        if (IsDepthFormat(Desc.Format))
+        {
+            ClearValue.DepthStencil.Depth = 1.0f;
+        }
+        else
+        {
+            memcpy(ClearValue.Color, Desc.ClearColor, sizeof(ClearValue.Color));
+        }
+        const bool bHasClearValue = (Desc.Usage & (ETextureUsage::RenderTarget | ETextureUsage::DepthStencil)) != 0;
+
+        TRefCountPtr<ID3D12Resource> Resource;
+        if (FAILED(Context.Device->CreateCommittedResource(&HeapProperties, D3D12_HEAP_FLAG_NONE, &ResourceDesc, D3D12_RESOURCE_STATE_COMMON,
+            bHasClearValue ? &ClearValue : nullptr, IID_PPV_ARGS(&Resource))))
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHITexture>::Create(new RefCounter<FD3D12Texture>(this, Desc, Resource.Get()));
+    }
+
+    TRefCountPtr<FRHIGraphicsPipeline> FD3D12Device::CreateGraphicsPipeline(const FGraphicsPipelineDesc& Desc)
+    {
+        D3D12_INPUT_ELEMENT_DESC InputElements[RHI_MAX_VERTEX_ELEMENTS];
+        for (u32 i = 0; i < Desc.NumVertexElements; ++i)
+        {
+            const FVertexElement& Element = Desc.VertexElements[i];
+            InputElements[i].SemanticName         = Element.SemanticName;
+            InputElements[i].SemanticIndex        = Element.SemanticIndex;
+            InputElements[i].Format               = GetDXGIFormat(Element.Format);
+            InputElements[i].InputSlot            = Element.Stream;
+            InputElements[i].AlignedByteOffset    = Element.Offset;
+            InputElements[i].InputSlotClass       = Element.bPerInstance ? D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+            InputElements[i].InstanceDataStepRate = Element.bPerInstance ? 1 : 0;
+        }
+
+        static const D3D12_PRIMITIVE_TOPOLOGY_TYPE TopologyTypes[] =
+        {
+            D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE, D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE, D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT
+        };
+        static const D3D12_CULL_MODE CullModes[] = { D3D12_CULL_MODE_NONE, D3D12_CULL_MODE_FRONT, D3D12_CULL_MODE_BACK };
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC PipelineDesc = {};
+        PipelineDesc.pRootSignature        = RootSignature.Get();
+        PipelineDesc.VS                    = { Desc.VertexShader.pData, SIZE_T(Desc.VertexShader.Size) };
+        PipelineDesc.PS                    = { Desc.PixelShader.pData, SIZE_T(Desc.PixelShader.Size) };
+        PipelineDesc.BlendState            = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+        PipelineDesc.SampleMask            = UINT_MAX;
+        PipelineDesc.RasterizerState       = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        PipelineDesc.RasterizerState.CullMode = CullModes[u32(Desc.CullMode)];
+        PipelineDesc.DepthStencilState     = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+        PipelineDesc.DepthStencilState.DepthEnable    = Desc.bDepthTest && Desc.DepthStencilFormat != EPixelFormat::Unknown;
+        PipelineDesc.DepthStencilState.DepthWriteMask = Desc.bDepthWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+        PipelineDesc.InputLayout           = { InputElements, Desc.NumVertexElements };
+        PipelineDesc.PrimitiveTopologyType = TopologyTypes[u32(Desc.Topology)];
+        PipelineDesc.NumRenderTargets      = Desc.NumRenderTargets;
+        PipelineDesc.DSVFormat             = GetDXGIFormat(Desc.DepthStencilFormat);
+        PipelineDesc.SampleDesc            = { 1, 0 };
+        for (u32 i = 0; i < Desc.NumRenderTargets; ++i)
+        {
+            PipelineDesc.RTVFormats[i] = GetDXGIFormat(Desc.RenderTargetFormats[i]);
+            if (Desc.bAlphaBlend)
+            {
+                D3D12_RENDER_TARGET_BLEND_DESC& Blend = PipelineDesc.BlendState.RenderTarget[i];
+                Blend.BlendEnable = TRUE;
+                Blend.SrcBlend    = D3D12_BLEND_SRC_ALPHA;
+                Blend.DestBlend   = D3D12_BLEND_INV_SRC_ALPHA;
+                Blend.BlendOp     = D3D12_BLEND_OP_ADD;
+            }
+        }
+
+        TRefCountPtr<ID3D12PipelineState> PipelineState;
+        if (FAILED(Context.Device->CreateGraphicsPipelineState(&PipelineDesc, IID_PPV_ARGS(&PipelineState))))
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHIGraphicsPipeline>::Create(new RefCounter<FD3D12GraphicsPipeline>(Desc, PipelineState.Get()));
+    }
+
+    TRefCountPtr<FRHIFence> FD3D12Device::CreateFence(u64 InitialValue)
+    {
+        TRefCountPtr<ID3D12Fence> Fence;
+        if (FAILED(Context.Device->CreateFence(InitialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&Fence))))
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHIFence>::Create(new RefCounter<FD3D12Fence>(Fence.Get()));
+    }
+
+    FRHIQueue* FD3D12Device::GetQueue(ERHIQueueType Type)
+    {
+        return Queues[u32(Type)].get();
+    }
+
+    FRHITexture* FD3D12Device::GetBackBuffer()
+    {
+        return BackBuffers[DXGISwapChain4->GetCurrentBackBufferIndex()].Get();
+    }
+
+    void FD3D12Device::Present()
+    {
+        const bool bTearing = GfxSettings.bEnableTearing;
+        ASSERT_SUCCEEDED(DXGISwapChain4->Present(bTearing ? 0 : 1, bTearing ? DXGI_PRESENT_ALLOW_TEARING : 0));
+    }
+
+    void FD3D12Device::WaitIdle()
+    {
+        for (std::unique_ptr<FD3D12Queue>& Queue : Queues)
+        {
+            if (Queue)
+            {
+                Queue->Flush();
+            }
+        }
+    }
+
+    FRHIDevice* CreateD3D12Device()
+    {
+        return new FD3D12Device();
+    }
+}
+
+#endif // ENABLE_RHI_D3D12
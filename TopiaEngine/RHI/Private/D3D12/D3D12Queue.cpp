@@ -0,0 +1,284 @@
+#include "D3D12RHI.h"
+
+#if ENABLE_RHI_D3D12
+
+namespace topia
+{
+    static const D3D12_COMMAND_LIST_TYPE sCommandListTypes[] = { D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_TYPE_COMPUTE, D3D12_COMMAND_LIST_TYPE_COPY };
+
+    static ID3D12Resource* sGetResource(FRHIResource* pResource)
+    {
+        return pResource->GetResourceType() == ERHIResourceType::Buffer ? static_cast<FD3D12Buffer*>(pResource)->Resource.Get() : static_cast<FD3D12Texture*>(pResource)->Resource.Get();
+    }
+
+    FD3D12Queue::FD3D12Queue(FD3D12Device* pInDevice, ERHIQueueType InType, ID3D12CommandQueue* pInQueue)
+        : FRHIQueue(InType)
+        , pDevice(pInDevice)
+        , CommandQueue(pInQueue)
+        , FenceEvent(::CreateEventW(nullptr, FALSE, FALSE, nullptr))
+    {
+        ASSERT_SUCCEEDED(pDevice->GetDevice()->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&Fence)));
+    }
+
+    FD3D12Queue::~FD3D12Queue()
+    {
+        Flush();
+        ::CloseHandle(FenceEvent);
+    }
+
+    FD3D12Queue::FCommandContext* FD3D12Queue::AcquireContext()
+    {
+        const u64 CompletedValue = Fence->GetCompletedValue();
+        for (const std::unique_ptr<FCommandContext>& Context : Contexts)
+        {
+            if (Context->FenceValue <= CompletedValue)
+            {
+                ASSERT_SUCCEEDED(Context->Allocator->Reset());
+                ASSERT_SUCCEEDED(Context->CommandList->Reset(Context->Allocator.Get(), nullptr));
+                return Context.get();
+            }
+        }
+
+        // Every allocator is in use by the GPU
+        std::unique_ptr<FCommandContext> Context(new FCommandContext());
+        const D3D12_COMMAND_LIST_TYPE Type = sCommandListTypes[u32(GetType())];
+        ASSERT_SUCCEEDED(pDevice->GetDevice()->CreateCommandAllocator(Type, IID_PPV_ARGS(&Context->Allocator)));
+        ASSERT_SUCCEEDED(pDevice->GetDevice()->CreateCommandList(0, Type, Context->Allocator.Get(), nullptr, IID_PPV_ARGS(&Context->CommandList)));
+        Contexts.push_back(std::move(Context));
+        return Contexts.back().get();
+    }
+
+    void FD3D12Queue::Translate(const FRHICommandList& List, ID3D12GraphicsCommandList* pCommandList)
+    {
+        static const D3D_PRIMITIVE_TOPOLOGY Topologies[] =
+        {
+            D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, D3D_PRIMITIVE_TOPOLOGY_LINELIST, D3D_PRIMITIVE_TOPOLOGY_POINTLIST
+        };
+
+        // Consecutive transitions go to the GPU as one batch
+        D3D12_RESOURCE_BARRIER Barriers[16];
+        u32 NumBarriers = 0;
+        ID3D12PipelineState* pCurrentPipeline = nullptr;
+        bool bRootSignatureSet = false;
+
+        for (FRHICommandReader Reader(List); Reader.IsValid(); Reader.Next())
+        {
+            const ERHICommand Type = Reader.GetType();
+            if (NumBarriers > 0 && (Type != ERHICommand::Transition || NumBarriers == _countof(Barriers)))
+            {
+                pCommandList->ResourceBarrier(NumBarriers, Barriers);
+                NumBarriers = 0;
+            }
+
+            switch (Type)
+            {
+            case ERHICommand::Transition:
+            {
+                const FRHICmdTransition& Cmd = Reader.Get<FRHICmdTransition>();
+                Barriers[NumBarriers++] = CD3DX12_RESOURCE_BARRIER::Transition(sGetResource(Cmd.pResource), GetD3D12ResourceState(Cmd.Before), GetD3D12ResourceState(Cmd.After));
+                break;
+            }
+
+            case ERHICommand::SetPipeline:
+            {
+                const FD3D12GraphicsPipeline* pPipeline = static_cast<const FD3D12GraphicsPipeline*>(Reader.Get<FRHICmdSetPipeline>().pPipeline);
+                if (!bRootSignatureSet)
+                {
+                    pCommandList->SetGraphicsRootSignature(pDevice->GetRootSignature());
+                    bRootSignatureSet = true;
+                }
+                if (pPipeline->PipelineState.Get() != pCurrentPipeline)
+                {
+                    pCurrentPipeline = pPipeline->PipelineState.Get();
+                    pCommandList->SetPipelineState(pCurrentPipeline);
+                    pCommandList->IASetPrimitiveTopology(Topologies[u32(pPipeline->GetDesc().Topology)]);
+                }
+                break;
+            }
+
+            case ERHICommand::SetRenderTargets:
+            {
+                const FRHICmdSetRenderTargets& Cmd = Reader.Get<FRHICmdSetRenderTargets>();
+                D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetViews[RHI_MAX_RENDER_TARGETS];
+                for (u32 i = 0; i < Cmd.NumRenderTargets; ++i)
+                {
+                    RenderTargetViews[i] = static_cast<const FD3D12Texture*>(Cmd.pRenderTargets[i])->RenderTargetView;
+                }
+                const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilView = Cmd.pDepthStencil ? &static_cast<const FD3D12Texture*>(Cmd.pDepthStencil)->DepthStencilView : nullptr;
+                pCommandList->OMSetRenderTargets(Cmd.NumRenderTargets, RenderTargetViews, FALSE, pDepthStencilView);
+                break;
+            }
+
+            case ERHICommand::ClearRenderTarget:
+            {
+                const FRHICmdClearRenderTarget& Cmd = Reader.Get<FRHICmdClearRenderTarget>();
+                pCommandList->ClearRenderTargetView(static_cast<const FD3D12Texture*>(Cmd.pTexture)->RenderTargetView, Cmd.Color, 0, nullptr);
+                break;
+            }
+
+            case ERHICommand::ClearDepthStencil:
+            {
+                const FRHICmdClearDepthStencil& Cmd = Reader.Get<FRHICmdClearDepthStencil>();
+                pCommandList->ClearDepthStencilView(static_cast<const FD3D12Texture*>(Cmd.pTexture)->DepthStencilView, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL,
+                    Cmd.Depth, Cmd.Stencil, 0, nullptr);
+                break;
+            }
+
+            case ERHICommand::SetViewport:
+            {
+                const FRHICmdSetViewport& Cmd = Reader.Get<FRHICmdSetViewport>();
+                const D3D12_VIEWPORT Viewport = { Cmd.X, Cmd.Y, Cmd.Width, Cmd.Height, Cmd.MinDepth, Cmd.MaxDepth };
+                pCommandList->RSSetViewports(1, &Viewport);
+                break;
+            }
+
+            case ERHICommand::SetScissor:
+            {
+                const FRHICmdSetScissor& Cmd = Reader.Get<FRHICmdSetScissor>();
+                const D3D12_RECT Rect = { LONG(Cmd.Left), LONG(Cmd.Top), LONG(Cmd.Right), LONG(Cmd.Bottom) };
+                pCommandList->RSSetScissorRects(1, &Rect);
+                break;
+            }
+
+            case ERHICommand::SetVertexBuffer:
+            {
+                const FRHICmdSetBuffer& Cmd = Reader.Get<FRHICmdSetBuffer>();
+                const FD3D12Buffer* pBuffer = static_cast<const FD3D12Buffer*>(Cmd.pBuffer);
+                D3D12_VERTEX_BUFFER_VIEW View;
+                View.BufferLocation = pBuffer->GPUAddress + Cmd.Offset;
+                View.SizeInBytes    = UINT(pBuffer->GetDesc().Size - Cmd.Offset);
+                View.StrideInBytes  = pBuffer->GetDesc().Stride;
+                pCommandList->IASetVertexBuffers(Cmd.Slot, 1, &View);
+                break;
+            }
+
+            case ERHICommand::SetIndexBuffer:
+            {
+                const FRHICmdSetIndexBuffer& Cmd = Reader.Get<FRHICmdSetIndexBuffer>();
+                const FD3D12Buffer* pBuffer = static_cast<const FD3D12Buffer*>(Cmd.pBuffer);
+                D3D12_INDEX_BUFFER_VIEW View;
+                View.BufferLocation = pBuffer->GPUAddress + Cmd.Offset;
+                View.SizeInBytes    = UINT(pBuffer->GetDesc().Size - Cmd.Offset);
+                View.Format         = Cmd.Format == EIndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+                pCommandList->IASetIndexBuffer(&View);
+                break;
+            }
+
+            case ERHICommand::SetConstantBuffer:
+            {
+                const FRHICmdSetBuffer& Cmd = Reader.Get<FRHICmdSetBuffer>();
+                pCommandList->SetGraphicsRootConstantBufferView(ROOT_PARAMETER_CONSTANT_BUFFERS + Cmd.Slot, static_cast<const FD3D12Buffer*>(Cmd.pBuffer)->GPUAddress + Cmd.Offset);
+                break;
+            }
+
+            case ERHICommand::SetShaderResource:
+            {
+                const FRHICmdSetBuffer& Cmd = Reader.Get<FRHICmdSetBuffer>();
+                pCommandList->SetGraphicsRootShaderResourceView(ROOT_PARAMETER_SHADER_RESOURCES + Cmd.Slot, static_cast<const FD3D12Buffer*>(Cmd.pBuffer)->GPUAddress + Cmd.Offset);
+                break;
+            }
+
+            case ERHICommand::SetConstants:
+            {
+                const FRHICmdSetConstants& Cmd = Reader.Get<FRHICmdSetConstants>();
+                pCommandList->SetGraphicsRoot32BitConstants(ROOT_PARAMETER_CONSTANTS, Cmd.NumValues, Cmd.GetValues(), Cmd.FirstValue);
+                break;
+            }
+
+            case ERHICommand::Draw:
+            {
+                const FRHICmdDraw& Cmd = Reader.Get<FRHICmdDraw>();
+                pCommandList->DrawInstanced(Cmd.VertexCount, Cmd.InstanceCount, Cmd.FirstVertex, Cmd.FirstInstance);
+                break;
+            }
+
+            case ERHICommand::DrawIndexed:
+            {
+                const FRHICmdDrawIndexed& Cmd = Reader.Get<FRHICmdDrawIndexed>();
+                pCommandList->DrawIndexedInstanced(Cmd.IndexCount, Cmd.InstanceCount, Cmd.FirstIndex, Cmd.BaseVertex, Cmd.FirstInstance);
+                break;
+            }
+
+            case ERHICommand::CopyBuffer:
+            {
+                const FRHICmdCopyBuffer& Cmd = Reader.Get<FRHICmdCopyBuffer>();
+                pCommandList->CopyBufferRegion(static_cast<const FD3D12Buffer*>(Cmd.pDest)->Resource.Get(), Cmd.DestOffset,
+                    static_cast<const FD3D12Buffer*>(Cmd.pSource)->Resource.Get(), Cmd.SourceOffset, Cmd.Size);
+                break;
+            }
+
+            case ERHICommand::CopyBufferToTexture:
+            {
+                const FRHICmdCopyBufferToTexture& Cmd = Reader.Get<FRHICmdCopyBufferToTexture>();
+                const FTextureDesc& Desc = Cmd.pDest->GetDesc();
+
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint;
+                Footprint.Offset = Cmd.SourceOffset;
+                Footprint.Footprint = CD3DX12_SUBRESOURCE_FOOTPRINT(GetDXGIFormat(Desc.Format), Desc.Width, Desc.Height, 1, Cmd.RowPitch);
+
+                const CD3DX12_TEXTURE_COPY_LOCATION Dest(static_cast<const FD3D12Texture*>(Cmd.pDest)->Resource.Get(), 0);
+                const CD3DX12_TEXTURE_COPY_LOCATION Source(static_cast<const FD3D12Buffer*>(Cmd.pSource)->Resource.Get(), Footprint);
+                pCommandList->CopyTextureRegion(&Dest, 0, 0, 0, &Source, nullptr);
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+
+        if (NumBarriers > 0)
+        {
+            pCommandList->ResourceBarrier(NumBarriers, Barriers);
+        }
+    }
+
+    void FD3D12Queue::Submit(FRHICommandList* const* ppLists, u32 NumLists)
+    {
+        PendingContexts.clear();
+        PendingLists.clear();
+        for (u32 i = 0; i < NumLists; ++i)
+        {
+            FCommandContext* pContext = AcquireContext();
+            Translate(*ppLists[i], pContext->CommandList.Get());
+            ASSERT_SUCCEEDED(pContext->CommandList->Close());
+
+            // Not reused by the lists that follow before the fence value is set
+            pContext->FenceValue = ~0ull;
+            PendingContexts.push_back(pContext);
+            PendingLists.push_back(pContext->CommandList.Get());
+        }
+
+        CommandQueue->ExecuteCommandLists(NumLists, PendingLists.data());
+
+        const u64 FenceValue = NextFenceValue++;
+        ASSERT_SUCCEEDED(CommandQueue->Signal(Fence.Get(), FenceValue));
+        for (FCommandContext* pContext : PendingContexts)
+        {
+            pContext->FenceValue = FenceValue;
+        }
+    }
+
+    void FD3D12Queue::Signal(FRHIFence* pFence, u64 Value)
+    {
+        ASSERT_SUCCEEDED(CommandQueue->Signal(static_cast<FD3D12Fence*>(pFence)->Fence.Get(), Value));
+    }
+
+    void FD3D12Queue::Wait(FRHIFence* pFence, u64 Value)
+    {
+        ASSERT_SUCCEEDED(CommandQueue->Wait(static_cast<FD3D12Fence*>(pFence)->Fence.Get(), Value));
+    }
+
+    void FD3D12Queue::Flush()
+    {
+        const u64 FenceValue = NextFenceValue++;
+        ASSERT_SUCCEEDED(CommandQueue->Signal(Fence.Get(), FenceValue));
+        if (Fence->GetCompletedValue() < FenceValue)
+        {
+            ASSERT_SUCCEEDED(Fence->SetEventOnCompletion(FenceValue, FenceEvent));
+            ::WaitForSingleObject(FenceEvent, INFINITE);
+        }
+    }
+}
+
+#endif // ENABLE_RHI_D3D12
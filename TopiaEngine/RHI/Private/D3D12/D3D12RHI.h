@@ -0,0 +1,208 @@
+#pragma once
+
+#include <RHI.h>
+
+#if ENABLE_RHI_D3D12
+
+#include <Platforms.h>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <d3dcompiler.h>
+
+#include "d3dx12.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define D3D12_GPU_VIRTUAL_ADDRESS_NULL		( (D3D12_GPU_VIRTUAL_ADDRESS)  0 )
+#define D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN	( (D3D12_GPU_VIRTUAL_ADDRESS) -1 )
+
+namespace topia
+{
+	static constexpr u32 BACK_BUFFER_SIZE = 2;
+
+	/** Root parameters of the root signature every graphics pipeline uses, see FGraphicsPipelineDesc */
+	static constexpr u32 ROOT_PARAMETER_CONSTANTS = 0;
+	static constexpr u32 ROOT_PARAMETER_CONSTANT_BUFFERS = 1;
+	static constexpr u32 ROOT_PARAMETER_SHADER_RESOURCES = ROOT_PARAMETER_CONSTANT_BUFFERS + RHI_MAX_CONSTANT_BUFFERS;
+	static constexpr u32 NUM_ROOT_PARAMETERS = ROOT_PARAMETER_SHADER_RESOURCES + RHI_MAX_SHADER_RESOURCES;
+
+	DXGI_FORMAT GetDXGIFormat(EPixelFormat Format);
+	D3D12_RESOURCE_STATES GetD3D12ResourceState(EResourceState State);
+
+	FRHIDevice* CreateD3D12Device();
+
+	struct FGfxContext
+	{
+		TRefCountPtr<ID3D12Device>  Device;
+		TRefCountPtr<ID3D12Device1> Device1;
+		TRefCountPtr<ID3D12Device2> Device2;
+
+		TRefCountPtr<ID3D12CommandQueue> GraphicsCommandQueue;
+		TRefCountPtr<ID3D12CommandQueue> ComputeCommandQueue;
+		TRefCountPtr<ID3D12CommandQueue> CopyCommandQueue;
+
+		TRefCountPtr<ID3D12CommandSignature> DrawIndirectSignature;
+		TRefCountPtr<ID3D12CommandSignature> DispatchIndirectSignature;
+
+		TRefCountPtr<ID3D12QueryHeap> TimerQueryHeap;
+		// TRefCountPtr<FBuffer> TimerQueryResolveBuffer;
+	};
+
+	/** CPU descriptors of one type, for the render and depth target views */
+	class FD3D12DescriptorHeap
+	{
+	public:
+		void Initialize(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE Type, u32 NumDescriptors);
+
+		/** Returns a null handle when the heap is full */
+		D3D12_CPU_DESCRIPTOR_HANDLE Allocate();
+		void Free(D3D12_CPU_DESCRIPTOR_HANDLE Handle);
+
+	private:
+		TRefCountPtr<ID3D12DescriptorHeap> Heap;
+		D3D12_CPU_DESCRIPTOR_HANDLE Start = {};
+		u32 DescriptorSize = 0;
+		u32 NumDescriptors = 0;
+		u32 NumAllocated = 0;
+		std::vector<u32> FreeIndices;
+		std::mutex Mutex;
+	};
+
+	class FD3D12Device;
+
+	class FD3D12Buffer : public FRHIBuffer
+	{
+	public:
+		FD3D12Buffer(const FBufferDesc& InDesc, ID3D12Resource* pInResource)
+			: FRHIBuffer(InDesc)
+			, Resource(pInResource)
+			, GPUAddress(pInResource->GetGPUVirtualAddress())
+		{
+		}
+
+		void* Map() override;
+		void Unmap() override;
+
+		TRefCountPtr<ID3D12Resource> Resource;
+		D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
+	};
+
+	class FD3D12Texture : public FRHITexture
+	{
+	public:
+		FD3D12Texture(FD3D12Device* pInDevice, const FTextureDesc& InDesc, ID3D12Resource* pInResource);
+		~FD3D12Texture() override;
+
+		FD3D12Device* pDevice;
+		TRefCountPtr<ID3D12Resource> Resource;
+		D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView = {};
+		D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView = {};
+	};
+
+	class FD3D12GraphicsPipeline : public FRHIGraphicsPipeline
+	{
+	public:
+		FD3D12GraphicsPipeline(const FGraphicsPipelineDesc& InDesc, ID3D12PipelineState* pInPipelineState)
+			: FRHIGraphicsPipeline(InDesc)
+			, PipelineState(pInPipelineState)
+		{
+		}
+
+		TRefCountPtr<ID3D12PipelineState> PipelineState;
+	};
+
+	class FD3D12Fence : public FRHIFence
+	{
+	public:
+		explicit FD3D12Fence(ID3D12Fence* pInFence);
+		~FD3D12Fence() override;
+
+		u64 GetCompletedValue() override { return Fence->GetCompletedValue(); }
+		void Wait(u64 Value) override;
+
+		TRefCountPtr<ID3D12Fence> Fence;
+		HANDLE Event;
+	};
+
+	/**
+	 * Translates the submitted command lists into D3D12 command lists. Their allocators are reused once the fence of the queue
+	 * shows the GPU is done with them.
+	 */
+	class FD3D12Queue : public FRHIQueue
+	{
+	public:
+		FD3D12Queue(FD3D12Device* pInDevice, ERHIQueueType InType, ID3D12CommandQueue* pInQueue);
+		~FD3D12Queue() override;
+
+		void Submit(FRHICommandList* const* ppLists, u32 NumLists) override;
+		void Signal(FRHIFence* pFence, u64 Value) override;
+		void Wait(FRHIFence* pFence, u64 Value) override;
+
+		/** Block until the work submitted so far is done */
+		void Flush();
+
+		ID3D12CommandQueue* GetCommandQueue() const { return CommandQueue.Get(); }
+
+	private:
+		struct FCommandContext
+		{
+			TRefCountPtr<ID3D12CommandAllocator> Allocator;
+			TRefCountPtr<ID3D12GraphicsCommandList> CommandList;
+			u64 FenceValue = 0;
+		};
+
+		FCommandContext* AcquireContext();
+		void Translate(const FRHICommandList& List, ID3D12GraphicsCommandList* pCommandList);
+
+		FD3D12Device* pDevice;
+		TRefCountPtr<ID3D12CommandQueue> CommandQueue;
+		TRefCountPtr<ID3D12Fence> Fence;
+		HANDLE FenceEvent;
+		u64 NextFenceValue = 1;
+		std::vector<std::unique_ptr<FCommandContext>> Contexts;
+		std::vector<FCommandContext*> PendingContexts;
+		std::vector<ID3D12CommandList*> PendingLists;
+	};
+
+	class FD3D12Device : public FRHIDevice
+	{
+	public:
+		FD3D12Device();
+		~FD3D12Device() override;
+
+		ERHIBackend GetBackend() const override { return ERHIBackend::D3D12; }
+
+		TRefCountPtr<FRHIBuffer> CreateBuffer(const FBufferDesc& Desc) override;
+		TRefCountPtr<FRHITexture> CreateTexture(const FTextureDesc& Desc) override;
+		TRefCountPtr<FRHIGraphicsPipeline> CreateGraphicsPipeline(const FGraphicsPipelineDesc& Desc) override;
+		TRefCountPtr<FRHIFence> CreateFence(u64 InitialValue = 0) override;
+
+		FRHIQueue* GetQueue(ERHIQueueType Type) override;
+
+		FRHITexture* GetBackBuffer() override;
+		void Present() override;
+
+		void WaitIdle() override;
+
+		ID3D12Device* GetDevice() const { return Context.Device.Get(); }
+		ID3D12RootSignature* GetRootSignature() const { return RootSignature.Get(); }
+
+		FD3D12DescriptorHeap RenderTargetViewHeap;
+		FD3D12DescriptorHeap DepthStencilViewHeap;
+
+	private:
+		FGfxContext Context;
+		TRefCountPtr<IDXGIFactory4> DXGIFactory4;
+		TRefCountPtr<IDXGIAdapter4> DXGIAdapter4;
+		TRefCountPtr<IDXGISwapChain4> DXGISwapChain4;
+		TRefCountPtr<ID3D12RootSignature> RootSignature;
+
+		std::unique_ptr<FD3D12Queue> Queues[u32(ERHIQueueType::Num)];
+		TRefCountPtr<FRHITexture> BackBuffers[BACK_BUFFER_SIZE];
+	};
+}
+
+#endif // ENABLE_RHI_D3D12
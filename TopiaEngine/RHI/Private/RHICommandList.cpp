@@ -0,0 +1,18 @@
+#include <RHICommandList.h>
+
+#include <algorithm>
+
+namespace topia
+{
+    void FRHICommandList::Grow(u64 MinCapacity)
+    {
+        const u64 NewCapacity = std::max<u64>(std::max<u64>(MinCapacity, Capacity * 2), 4096);
+        std::unique_ptr<u64[]> NewData(new u64[NewCapacity / sizeof(u64)]);
+        if (Size > 0)
+        {
+            memcpy(NewData.get(), Data.get(), Size);
+        }
+        Data = std::move(NewData);
+        Capacity = NewCapacity;
+    }
+}
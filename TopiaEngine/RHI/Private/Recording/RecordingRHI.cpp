@@ -0,0 +1,927 @@
+#include <RecordingRHI.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+
+namespace topia
+{
+    static const char* const sResourceStateNames[] = { "Common", "VertexBuffer", "IndexBuffer", "ConstantBuffer", "ShaderResource", "UnorderedAccess",
+        "IndirectArgument", "RenderTarget", "DepthWrite", "DepthRead", "CopySource", "CopyDest", "Present", "GenericRead" };
+    static_assert(sizeof(sResourceStateNames) / sizeof(sResourceStateNames[0]) == size_t(EResourceState::Num), "Every state needs a name");
+
+    static const char* const sCommandNames[] = { "Transition", "SetPipeline", "SetRenderTargets", "ClearRenderTarget", "ClearDepthStencil", "SetViewport",
+        "SetScissor", "SetVertexBuffer", "SetIndexBuffer", "SetConstantBuffer", "SetShaderResource", "SetConstants", "Draw", "DrawIndexed", "CopyBuffer",
+        "CopyBufferToTexture" };
+    static_assert(sizeof(sCommandNames) / sizeof(sCommandNames[0]) == size_t(ERHICommand::Num), "Every command needs a name");
+
+    static const char* const sQueueNames[] = { "Graphics", "Compute", "Copy", "CPU" };
+
+    /** Offsets of buffers copied to textures, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT */
+    static constexpr u64 TEXTURE_PLACEMENT_ALIGNMENT = 512;
+
+    /** D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT */
+    static constexpr u64 CONSTANT_BUFFER_ALIGNMENT = 256;
+
+    class FRecordingBuffer : public FRHIBuffer
+    {
+    public:
+        FRecordingBuffer(FRecordingDevice* pInDevice, const FBufferDesc& InDesc)
+            : FRHIBuffer(InDesc)
+            , pDevice(pInDevice)
+        {
+            // Only the CPU side of upload and readback buffers has memory, the GPU side is never run
+            if (Desc.Memory != EMemoryType::Default)
+            {
+                Memory.reset(new u8[Desc.Size]());
+            }
+            State = Desc.Memory == EMemoryType::Upload ? EResourceState::GenericRead : Desc.Memory == EMemoryType::Readback ? EResourceState::CopyDest : EResourceState::Common;
+            pDevice->AddResource(this);
+        }
+
+        ~FRecordingBuffer() override
+        {
+            pDevice->RemoveResource(this);
+        }
+
+        void* Map() override { return Memory.get(); }
+        void Unmap() override {}
+
+        FRecordingDevice* pDevice;
+        std::unique_ptr<u8[]> Memory;
+        EResourceState State;
+    };
+
+    class FRecordingTexture : public FRHITexture
+    {
+    public:
+        FRecordingTexture(FRecordingDevice* pInDevice, const FTextureDesc& InDesc, EResourceState InitialState)
+            : FRHITexture(InDesc)
+            , pDevice(pInDevice)
+            , State(InitialState)
+        {
+            pDevice->AddResource(this);
+        }
+
+        ~FRecordingTexture() override
+        {
+            pDevice->RemoveResource(this);
+        }
+
+        FRecordingDevice* pDevice;
+        EResourceState State;
+    };
+
+    class FRecordingGraphicsPipeline : public FRHIGraphicsPipeline
+    {
+    public:
+        FRecordingGraphicsPipeline(FRecordingDevice* pInDevice, const FGraphicsPipelineDesc& InDesc)
+            : FRHIGraphicsPipeline(InDesc)
+            , pDevice(pInDevice)
+        {
+            pDevice->AddResource(this);
+        }
+
+        ~FRecordingGraphicsPipeline() override
+        {
+            pDevice->RemoveResource(this);
+        }
+
+        FRecordingDevice* pDevice;
+    };
+
+    class FRecordingFence : public FRHIFence
+    {
+    public:
+        FRecordingFence(FRecordingDevice* pInDevice, u64 InitialValue)
+            : pDevice(pInDevice)
+            , Value(InitialValue)
+        {
+            pDevice->AddResource(this);
+        }
+
+        ~FRecordingFence() override
+        {
+            pDevice->RemoveResource(this);
+        }
+
+        u64 GetCompletedValue() override { return Value; }
+
+        void Wait(u64 WaitValue) override
+        {
+            const u64 CompletedValue = Value;
+            if (CompletedValue < WaitValue)
+            {
+                char Message[128];
+                snprintf(Message, sizeof(Message), "Waits for fence value %llu, it is at %llu and nothing signals it", (unsigned long long)WaitValue,
+                    (unsigned long long)CompletedValue);
+                pDevice->ReportError(FRHIValidationError{ ERHIQueueType::Num, 0, 0, ERHICommand::Num, Message });
+            }
+        }
+
+        FRecordingDevice* pDevice;
+        std::atomic<u64> Value;
+    };
+
+    class FRecordingQueue : public FRHIQueue
+    {
+    public:
+        FRecordingQueue(FRecordingDevice* pInDevice, ERHIQueueType InType)
+            : FRHIQueue(InType)
+            , pDevice(pInDevice)
+        {
+        }
+
+        void Submit(FRHICommandList* const* ppLists, u32 NumLists) override;
+        void Signal(FRHIFence* pFence, u64 Value) override;
+        void Wait(FRHIFence* pFence, u64 Value) override;
+
+        FRecordingRHIStats Stats;
+        std::vector<u8> Capture;
+
+    private:
+        /** GPU state, which every command list starts without */
+        struct FDrawState
+        {
+            FRecordingGraphicsPipeline* pPipeline;
+            FRecordingTexture* pRenderTargets[RHI_MAX_RENDER_TARGETS];
+            FRecordingTexture* pDepthStencil;
+            u32 NumRenderTargets;
+            bool bViewport;
+            bool bScissor;
+            FRecordingBuffer* pVertexBuffers[RHI_MAX_VERTEX_STREAMS];
+            u64 VertexBufferOffsets[RHI_MAX_VERTEX_STREAMS];
+            FRecordingBuffer* pIndexBuffer;
+            u64 IndexBufferOffset;
+            EIndexFormat IndexFormat;
+            FRecordingBuffer* pConstantBuffers[RHI_MAX_CONSTANT_BUFFERS];
+            FRecordingBuffer* pShaderResources[RHI_MAX_SHADER_RESOURCES];
+        };
+
+        void Validate(const FRHICommandList& List);
+        void ValidateCommand(const FRHICommandReader& Reader, FDrawState& State);
+        void ValidateDraw(FDrawState& State, u32 VertexCount, u32 InstanceCount, u32 FirstVertex, u32 FirstInstance, bool bIndexed);
+
+        template <typename T>
+        T* CheckResource(FRHIResource* pResource, const char* Name);
+        void CheckState(const char* Name, EResourceState State, EResourceState Expected);
+        void CheckBufferState(const char* Name, const FRecordingBuffer* pBuffer, EResourceState Expected);
+        void CheckBufferRange(const char* Name, const FRecordingBuffer* pBuffer, u64 Offset, u64 Size);
+        void Error(const char* Format, ...);
+
+        FRecordingDevice* pDevice;
+        u64 NumSubmits = 0;
+        u32 CommandIndex = 0;
+        ERHICommand Command = ERHICommand::Num;
+    };
+
+    void FRecordingQueue::Error(const char* Format, ...)
+    {
+        char Message[256];
+        va_list Args;
+        va_start(Args, Format);
+        vsnprintf(Message, sizeof(Message), Format, Args);
+        va_end(Args);
+        pDevice->AddErrorLocked(FRHIValidationError{ GetType(), NumSubmits, CommandIndex, Command, Message });
+    }
+
+    template <typename T>
+    T* FRecordingQueue::CheckResource(FRHIResource* pResource, const char* Name)
+    {
+        if (pResource == nullptr)
+        {
+            Error("%s is null", Name);
+            return nullptr;
+        }
+        if (pDevice->LiveResources.count(pResource) == 0)
+        {
+            Error("%s was released or is from another device", Name);
+            return nullptr;
+        }
+        return static_cast<T*>(pResource);
+    }
+
+    void FRecordingQueue::CheckState(const char* Name, EResourceState State, EResourceState Expected)
+    {
+        if (State != Expected)
+        {
+            Error("%s is in state %s instead of %s", Name, sResourceStateNames[u32(State)], sResourceStateNames[u32(Expected)]);
+        }
+    }
+
+    void FRecordingQueue::CheckBufferState(const char* Name, const FRecordingBuffer* pBuffer, EResourceState Expected)
+    {
+        // Upload buffers are read in GenericRead, which includes every read state
+        if (pBuffer->GetDesc().Memory == EMemoryType::Upload && Expected != EResourceState::CopyDest && Expected != EResourceState::UnorderedAccess)
+        {
+            return;
+        }
+        CheckState(Name, pBuffer->State, Expected);
+    }
+
+    void FRecordingQueue::CheckBufferRange(const char* Name, const FRecordingBuffer* pBuffer, u64 Offset, u64 Size)
+    {
+        const u64 BufferSize = pBuffer->GetDesc().Size;
+        if (Offset > BufferSize || Size > BufferSize - Offset)
+        {
+            Error("%s reads bytes %llu to %llu of a buffer of %llu bytes", Name, (unsigned long long)Offset, (unsigned long long)(Offset + Size),
+                (unsigned long long)BufferSize);
+        }
+    }
+
+    void FRecordingQueue::ValidateDraw(FDrawState& State, u32 VertexCount, u32 InstanceCount, u32 FirstVertex, u32 FirstInstance, bool bIndexed)
+    {
+        if (State.pPipeline == nullptr)
+        {
+            Error("No pipeline is set");
+            return;
+        }
+        if (!State.bViewport)
+        {
+            Error("No viewport is set");
+        }
+        if (!State.bScissor)
+        {
+            Error("No scissor rectangle is set, everything is clipped");
+        }
+
+        const FGraphicsPipelineDesc& Desc = State.pPipeline->GetDesc();
+        if (State.NumRenderTargets != Desc.NumRenderTargets)
+        {
+            Error("%u render targets are set, the pipeline writes %u", State.NumRenderTargets, Desc.NumRenderTargets);
+        }
+        for (u32 i = 0; i < std::min(State.NumRenderTargets, Desc.NumRenderTargets); ++i)
+        {
+            if (const FRecordingTexture* pTarget = State.pRenderTargets[i])
+            {
+                if (pTarget->GetDesc().Format != Desc.RenderTargetFormats[i])
+                {
+                    Error("Render target %u has format %u, the pipeline writes %u", i, u32(pTarget->GetDesc().Format), u32(Desc.RenderTargetFormats[i]));
+                }
+                CheckState("Render target", pTarget->State, EResourceState::RenderTarget);
+            }
+        }
+        if (Desc.DepthStencilFormat != EPixelFormat::Unknown)
+        {
+            if (State.pDepthStencil == nullptr)
+            {
+                Error("The pipeline uses depth and no depth target is set");
+            }
+            else
+            {
+                if (State.pDepthStencil->GetDesc().Format != Desc.DepthStencilFormat)
+                {
+                    Error("The depth target has format %u, the pipeline uses %u", u32(State.pDepthStencil->GetDesc().Format), u32(Desc.DepthStencilFormat));
+                }
+                const EResourceState DepthState = State.pDepthStencil->State;
+                if (DepthState != EResourceState::DepthWrite && (Desc.bDepthWrite || DepthState != EResourceState::DepthRead))
+                {
+                    CheckState("Depth target", DepthState, Desc.bDepthWrite ? EResourceState::DepthWrite : EResourceState::DepthRead);
+                }
+            }
+        }
+        else if (State.pDepthStencil != nullptr)
+        {
+            Error("A depth target is set and the pipeline has no depth format");
+        }
+
+        // The vertices an indexed draw reads depend on the indices, only its instances are checked
+        for (u32 i = 0; i < Desc.NumVertexElements; ++i)
+        {
+            const FVertexElement& Element = Desc.VertexElements[i];
+            const FRecordingBuffer* pBuffer = Element.Stream < RHI_MAX_VERTEX_STREAMS ? State.pVertexBuffers[Element.Stream] : nullptr;
+            if (pBuffer == nullptr)
+            {
+                Error("Vertex element %s%u reads stream %u, which has no buffer", Element.SemanticName, Element.SemanticIndex, Element.Stream);
+                continue;
+            }
+            CheckBufferState("Vertex buffer", pBuffer, EResourceState::VertexBuffer);
+
+            const u32 Count = Element.bPerInstance ? InstanceCount : VertexCount;
+            if (Count > 0 && (Element.bPerInstance || !bIndexed))
+            {
+                const u64 Last = u64(Element.bPerInstance ? FirstInstance : FirstVertex) + Count - 1;
+                const u64 Offset = State.VertexBufferOffsets[Element.Stream] + Last * pBuffer->GetDesc().Stride + Element.Offset;
+                CheckBufferRange("Vertex element", pBuffer, Offset, GetPixelFormatSize(Element.Format));
+            }
+        }
+
+        for (u32 Slot = 0; Slot < RHI_MAX_CONSTANT_BUFFERS; ++Slot)
+        {
+            if (State.pConstantBuffers[Slot] != nullptr)
+            {
+                CheckBufferState("Constant buffer", State.pConstantBuffers[Slot], EResourceState::ConstantBuffer);
+            }
+        }
+        for (u32 Slot = 0; Slot < RHI_MAX_SHADER_RESOURCES; ++Slot)
+        {
+            if (State.pShaderResources[Slot] != nullptr)
+            {
+                CheckBufferState("Shader resource", State.pShaderResources[Slot], EResourceState::ShaderResource);
+            }
+        }
+    }
+
+    void FRecordingQueue::ValidateCommand(const FRHICommandReader& Reader, FDrawState& State)
+    {
+        if (GetType() != ERHIQueueType::Graphics && Command != ERHICommand::Transition && Command != ERHICommand::CopyBuffer && Command != ERHICommand::CopyBufferToTexture)
+        {
+            Error("%s is not allowed on the %s queue", sCommandNames[u32(Command)], sQueueNames[u32(GetType())]);
+            return;
+        }
+
+        switch (Command)
+        {
+        case ERHICommand::Transition:
+        {
+            const FRHICmdTransition& Cmd = Reader.Get<FRHICmdTransition>();
+            if (Cmd.Before == Cmd.After)
+            {
+                Error("Transition from %s to itself", sResourceStateNames[u32(Cmd.Before)]);
+            }
+
+            EResourceState* pState = nullptr;
+            bool bAllowed = true;
+            if (FRHIResource* pResource = CheckResource<FRHIResource>(Cmd.pResource, "Transitioned resource"))
+            {
+                if (pResource->GetResourceType() == ERHIResourceType::Buffer)
+                {
+                    FRecordingBuffer* pBuffer = static_cast<FRecordingBuffer*>(pResource);
+                    const EBufferUsage Usage = pBuffer->GetDesc().Usage;
+                    if (pBuffer->GetDesc().Memory != EMemoryType::Default)
+                    {
+                        Error("Upload and readback buffers can't change state");
+                        return;
+                    }
+                    switch (Cmd.After)
+                    {
+                    case EResourceState::VertexBuffer:      bAllowed = (Usage & EBufferUsage::Vertex) != 0; break;
+                    case EResourceState::IndexBuffer:       bAllowed = (Usage & EBufferUsage::Index) != 0; break;
+                    case EResourceState::ConstantBuffer:    bAllowed = (Usage & EBufferUsage::Constant) != 0; break;
+                    case EResourceState::ShaderResource:    bAllowed = (Usage & EBufferUsage::ShaderResource) != 0; break;
+                    case EResourceState::UnorderedAccess:   bAllowed = (Usage & EBufferUsage::UnorderedAccess) != 0; break;
+                    case EResourceState::IndirectArgument:  bAllowed = (Usage & EBufferUsage::Indirect) != 0; break;
+                    case EResourceState::RenderTarget:
+                    case EResourceState::DepthWrite:
+                    case EResourceState::DepthRead:
+                    case EResourceState::Present:           bAllowed = false; break;
+                    default: break;
+                    }
+                    pState = &pBuffer->State;
+                }
+                else if (pResource->GetResourceType() == ERHIResourceType::Texture)
+                {
+                    FRecordingTexture* pTexture = static_cast<FRecordingTexture*>(pResource);
+                    const ETextureUsage Usage = pTexture->GetDesc().Usage;
+                    switch (Cmd.After)
+                    {
+                    case EResourceState::ShaderResource:    bAllowed = (Usage & ETextureUsage::ShaderResource) != 0; break;
+                    case EResourceState::UnorderedAccess:   bAllowed = (Usage & ETextureUsage::UnorderedAccess) != 0; break;
+                    case EResourceState::RenderTarget:      bAllowed = (Usage & ETextureUsage::RenderTarget) != 0; break;
+                    case EResourceState::DepthWrite:
+                    case EResourceState::DepthRead:         bAllowed = (Usage & ETextureUsage::DepthStencil) != 0; break;
+                    case EResourceState::VertexBuffer:
+                    case EResourceState::IndexBuffer:
+                    case EResourceState::ConstantBuffer:
+                    case EResourceState::IndirectArgument:  bAllowed = false; break;
+                    default: break;
+                    }
+                    pState = &pTexture->State;
+                }
+                else
+                {
+                    Error("Only buffers and textures have states");
+                }
+            }
+
+            if (pState != nullptr)
+            {
+                if (!bAllowed)
+                {
+                    Error("The resource can't be in state %s, its usage doesn't include it", sResourceStateNames[u32(Cmd.After)]);
+                }
+                CheckState("Transitioned resource", *pState, Cmd.Before);
+
+                // The state after is tracked even from a wrong state before, so one mistake is reported once
+                *pState = Cmd.After;
+            }
+            ++Stats.NumTransitions;
+            break;
+        }
+
+        case ERHICommand::SetPipeline:
+            State.pPipeline = CheckResource<FRecordingGraphicsPipeline>(Reader.Get<FRHICmdSetPipeline>().pPipeline, "Pipeline");
+            break;
+
+        case ERHICommand::SetRenderTargets:
+        {
+            const FRHICmdSetRenderTargets& Cmd = Reader.Get<FRHICmdSetRenderTargets>();
+            State.NumRenderTargets = Cmd.NumRenderTargets;
+            for (u32 i = 0; i < RHI_MAX_RENDER_TARGETS; ++i)
+            {
+                State.pRenderTargets[i] = nullptr;
+                if (i < Cmd.NumRenderTargets)
+                {
+                    FRecordingTexture* pTarget = CheckResource<FRecordingTexture>(Cmd.pRenderTargets[i], "Render target");
+                    if (pTarget != nullptr && (pTarget->GetDesc().Usage & ETextureUsage::RenderTarget) == 0)
+                    {
+                        Error("Render target %u was created without ETextureUsage::RenderTarget", i);
+                    }
+                    State.pRenderTargets[i] = pTarget;
+                }
+            }
+
+            State.pDepthStencil = nullptr;
+            if (Cmd.pDepthStencil != nullptr)
+            {
+                FRecordingTexture* pDepth = CheckResource<FRecordingTexture>(Cmd.pDepthStencil, "Depth target");
+                if (pDepth != nullptr && (pDepth->GetDesc().Usage & ETextureUsage::DepthStencil) == 0)
+                {
+                    Error("The depth target was created without ETextureUsage::DepthStencil");
+                }
+                State.pDepthStencil = pDepth;
+            }
+            break;
+        }
+
+        case ERHICommand::ClearRenderTarget:
+            if (const FRecordingTexture* pTarget = CheckResource<FRecordingTexture>(Reader.Get<FRHICmdClearRenderTarget>().pTexture, "Cleared render target"))
+            {
+                CheckState("Cleared render target", pTarget->State, EResourceState::RenderTarget);
+            }
+            break;
+
+        case ERHICommand::ClearDepthStencil:
+        {
+            const FRHICmdClearDepthStencil& Cmd = Reader.Get<FRHICmdClearDepthStencil>();
+            if (const FRecordingTexture* pTarget = CheckResource<FRecordingTexture>(Cmd.pTexture, "Cleared depth target"))
+            {
+                CheckState("Cleared depth target", pTarget->State, EResourceState::DepthWrite);
+            }
+            if (!(Cmd.Depth >= 0.0f && Cmd.Depth <= 1.0f))
+            {
+                Error("Clear depth %f is outside [0, 1]", Cmd.Depth);
+            }
+            break;
+        }
+
+        case ERHICommand::SetViewport:
+        {
+            const FRHICmdSetViewport& Cmd = Reader.Get<FRHICmdSetViewport>();
+            if (!(Cmd.Width > 0.0f && Cmd.Height > 0.0f))
+            {
+                Error("Empty viewport of %f x %f", Cmd.Width, Cmd.Height);
+            }
+            if (!(Cmd.MinDepth >= 0.0f && Cmd.MinDepth <= Cmd.MaxDepth && Cmd.MaxDepth <= 1.0f))
+            {
+                Error("Viewport depth range [%f, %f] is not inside [0, 1]", Cmd.MinDepth, Cmd.MaxDepth);
+            }
+            State.bViewport = true;
+            break;
+        }
+
+        case ERHICommand::SetScissor:
+        {
+            const FRHICmdSetScissor& Cmd = Reader.Get<FRHICmdSetScissor>();
+            if (Cmd.Left > Cmd.Right || Cmd.Top > Cmd.Bottom)
+            {
+                Error("Scissor rectangle (%u, %u) - (%u, %u) is inverted", Cmd.Left, Cmd.Top, Cmd.Right, Cmd.Bottom);
+            }
+            State.bScissor = true;
+            break;
+        }
+
+        case ERHICommand::SetVertexBuffer:
+        {
+            const FRHICmdSetBuffer& Cmd = Reader.Get<FRHICmdSetBuffer>();
+            if (Cmd.Slot >= RHI_MAX_VERTEX_STREAMS)
+            {
+                Error("Vertex stream %u, there are %u", Cmd.Slot, RHI_MAX_VERTEX_STREAMS);
+                break;
+            }
+            FRecordingBuffer* pBuffer = CheckResource<FRecordingBuffer>(Cmd.pBuffer, "Vertex buffer");
+            if (pBuffer != nullptr)
+            {
+                if ((pBuffer->GetDesc().Usage & EBufferUsage::Vertex) == 0)
+                {
+                    Error("Vertex buffer was created without EBufferUsage::Vertex");
+                }
+                if (pBuffer->GetDesc().Stride == 0)
+                {
+                    Error("Vertex buffer has no stride");
+                }
+                CheckBufferRange("Vertex buffer", pBuffer, Cmd.Offset, 0);
+            }
+            State.pVertexBuffers[Cmd.Slot] = pBuffer;
+            State.VertexBufferOffsets[Cmd.Slot] = Cmd.Offset;
+            break;
+        }
+
+        case ERHICommand::SetIndexBuffer:
+        {
+            const FRHICmdSetIndexBuffer& Cmd = Reader.Get<FRHICmdSetIndexBuffer>();
+            FRecordingBuffer* pBuffer = CheckResource<FRecordingBuffer>(Cmd.pBuffer, "Index buffer");
+            if (pBuffer != nullptr)
+            {
+                if ((pBuffer->GetDesc().Usage & EBufferUsage::Index) == 0)
+                {
+                    Error("Index buffer was created without EBufferUsage::Index");
+                }
+                if (Cmd.Offset % (Cmd.Format == EIndexFormat::UInt16 ? 2 : 4) != 0)
+                {
+                    Error("Index buffer offset %llu is not a multiple of the index size", (unsigned long long)Cmd.Offset);
+                }
+            }
+            State.pIndexBuffer = pBuffer;
+            State.IndexBufferOffset = Cmd.Offset;
+            State.IndexFormat = Cmd.Format;
+            break;
+        }
+
+        case ERHICommand::SetConstantBuffer:
+        {
+            const FRHICmdSetBuffer& Cmd = Reader.Get<FRHICmdSetBuffer>();
+            if (Cmd.Slot >= RHI_MAX_CONSTANT_BUFFERS)
+            {
+                Error("Constant buffer slot %u, there are %u", Cmd.Slot, RHI_MAX_CONSTANT_BUFFERS);
+                break;
+            }
+            FRecordingBuffer* pBuffer = CheckResource<FRecordingBuffer>(Cmd.pBuffer, "Constant buffer");
+            if (pBuffer != nullptr)
+            {
+                if ((pBuffer->GetDesc().Usage & EBufferUsage::Constant) == 0)
+                {
+                    Error("Constant buffer was created without EBufferUsage::Constant");
+                }
+                if (Cmd.Offset % CONSTANT_BUFFER_ALIGNMENT != 0)
+                {
+                    Error("Constant buffer offset %llu is not a multiple of %llu", (unsigned long long)Cmd.Offset, (unsigned long long)CONSTANT_BUFFER_ALIGNMENT);
+                }
+                CheckBufferRange("Constant buffer", pBuffer, Cmd.Offset, 1);
+            }
+            State.pConstantBuffers[Cmd.Slot] = pBuffer;
+            break;
+        }
+
+        case ERHICommand::SetShaderResource:
+        {
+            const FRHICmdSetBuffer& Cmd = Reader.Get<FRHICmdSetBuffer>();
+            if (Cmd.Slot >= RHI_MAX_SHADER_RESOURCES)
+            {
+                Error("Shader resource slot %u, there are %u", Cmd.Slot, RHI_MAX_SHADER_RESOURCES);
+                break;
+            }
+            FRecordingBuffer* pBuffer = CheckResource<FRecordingBuffer>(Cmd.pBuffer, "Shader resource");
+            if (pBuffer != nullptr)
+            {
+                if ((pBuffer->GetDesc().Usage & EBufferUsage::ShaderResource) == 0)
+                {
+                    Error("Shader resource was created without EBufferUsage::ShaderResource");
+                }
+                CheckBufferRange("Shader resource", pBuffer, Cmd.Offset, 1);
+            }
+            State.pShaderResources[Cmd.Slot] = pBuffer;
+            break;
+        }
+
+        case ERHICommand::SetConstants:
+        {
+            const FRHICmdSetConstants& Cmd = Reader.Get<FRHICmdSetConstants>();
+            if (Cmd.FirstValue + Cmd.NumValues > RHI_MAX_CONSTANTS)
+            {
+                Error("Constants %u to %u, there are %u", Cmd.FirstValue, Cmd.FirstValue + Cmd.NumValues, RHI_MAX_CONSTANTS);
+            }
+            break;
+        }
+
+        case ERHICommand::Draw:
+        {
+            const FRHICmdDraw& Cmd = Reader.Get<FRHICmdDraw>();
+            ValidateDraw(State, Cmd.VertexCount, Cmd.InstanceCount, Cmd.FirstVertex, Cmd.FirstInstance, false);
+            ++Stats.NumDraws;
+            break;
+        }
+
+        case ERHICommand::DrawIndexed:
+        {
+            const FRHICmdDrawIndexed& Cmd = Reader.Get<FRHICmdDrawIndexed>();
+            ValidateDraw(State, 0, Cmd.InstanceCount, 0, Cmd.FirstInstance, true);
+            if (State.pIndexBuffer == nullptr)
+            {
+                Error("No index buffer is set");
+            }
+            else
+            {
+                CheckBufferState("Index buffer", State.pIndexBuffer, EResourceState::IndexBuffer);
+                const u64 IndexSize = State.IndexFormat == EIndexFormat::UInt16 ? 2 : 4;
+                CheckBufferRange("Indices", State.pIndexBuffer, State.IndexBufferOffset + Cmd.FirstIndex * IndexSize, Cmd.IndexCount * IndexSize);
+            }
+            ++Stats.NumDraws;
+            break;
+        }
+
+        case ERHICommand::CopyBuffer:
+        {
+            const FRHICmdCopyBuffer& Cmd = Reader.Get<FRHICmdCopyBuffer>();
+            const FRecordingBuffer* pDest = CheckResource<FRecordingBuffer>(Cmd.pDest, "Copy destination");
+            const FRecordingBuffer* pSource = CheckResource<FRecordingBuffer>(Cmd.pSource, "Copy source");
+            if (pDest != nullptr)
+            {
+                if (pDest->GetDesc().Memory == EMemoryType::Upload)
+                {
+                    Error("Copy to an upload buffer");
+                }
+                CheckBufferState("Copy destination", pDest, EResourceState::CopyDest);
+                CheckBufferRange("Copy destination", pDest, Cmd.DestOffset, Cmd.Size);
+            }
+            if (pSource != nullptr)
+            {
+                CheckBufferState("Copy source", pSource, EResourceState::CopySource);
+                CheckBufferRange("Copy source", pSource, Cmd.SourceOffset, Cmd.Size);
+            }
+            if (pDest != nullptr && pDest == pSource)
+            {
+                Error("Copy of a buffer to itself");
+            }
+            break;
+        }
+
+        case ERHICommand::CopyBufferToTexture:
+        {
+            const FRHICmdCopyBufferToTexture& Cmd = Reader.Get<FRHICmdCopyBufferToTexture>();
+            const FRecordingTexture* pDest = CheckResource<FRecordingTexture>(Cmd.pDest, "Copy destination");
+            const FRecordingBuffer* pSource = CheckResource<FRecordingBuffer>(Cmd.pSource, "Copy source");
+            if (Cmd.RowPitch % RHI_TEXTURE_ROW_PITCH_ALIGNMENT != 0)
+            {
+                Error("Row pitch %u is not a multiple of %u", Cmd.RowPitch, RHI_TEXTURE_ROW_PITCH_ALIGNMENT);
+            }
+            if (Cmd.SourceOffset % TEXTURE_PLACEMENT_ALIGNMENT != 0)
+            {
+                Error("Source offset %llu is not a multiple of %llu", (unsigned long long)Cmd.SourceOffset, (unsigned long long)TEXTURE_PLACEMENT_ALIGNMENT);
+            }
+            if (pDest != nullptr)
+            {
+                CheckState("Copy destination", pDest->State, EResourceState::CopyDest);
+            }
+            if (pDest != nullptr && pSource != nullptr)
+            {
+                const FTextureDesc& Desc = pDest->GetDesc();
+                const u64 RowSize = u64(Desc.Width) * GetPixelFormatSize(Desc.Format);
+                if (Cmd.RowPitch < RowSize)
+                {
+                    Error("Row pitch %u is smaller than a row of %llu bytes", Cmd.RowPitch, (unsigned long long)RowSize);
+                }
+                CheckBufferState("Copy source", pSource, EResourceState::CopySource);
+                CheckBufferRange("Copy source", pSource, Cmd.SourceOffset, u64(Cmd.RowPitch) * (Desc.Height - 1) + RowSize);
+            }
+            break;
+        }
+
+        default:
+            Error("Unknown command %u", u32(Command));
+            break;
+        }
+    }
+
+    void FRecordingQueue::Validate(const FRHICommandList& List)
+    {
+        FDrawState State = {};
+        CommandIndex = 0;
+        for (FRHICommandReader Reader(List); Reader.IsValid(); Reader.Next(), ++CommandIndex)
+        {
+            Command = Reader.GetType();
+            ValidateCommand(Reader, State);
+        }
+        Command = ERHICommand::Num;
+    }
+
+    void FRecordingQueue::Submit(FRHICommandList* const* ppLists, u32 NumLists)
+    {
+        // The checks look up resources and report errors, which other threads do too
+        std::unique_lock<std::mutex> Lock(pDevice->Mutex, std::defer_lock);
+        if (pDevice->Settings.bValidate)
+        {
+            Lock.lock();
+        }
+
+        u64 NumDraws = 0;
+        u64 NumTransitions = 0;
+        u64 NumCommands = 0;
+        u64 NumBytes = 0;
+        for (u32 i = 0; i < NumLists; ++i)
+        {
+            const FRHICommandList& List = *ppLists[i];
+            if (pDevice->Settings.bCapture)
+            {
+                Capture.insert(Capture.end(), List.GetData(), List.GetData() + List.GetSize());
+            }
+
+            if (pDevice->Settings.bValidate)
+            {
+                Validate(List);
+            }
+            else
+            {
+                for (FRHICommandReader Reader(List); Reader.IsValid(); Reader.Next())
+                {
+                    const ERHICommand Type = Reader.GetType();
+                    NumDraws += Type == ERHICommand::Draw || Type == ERHICommand::DrawIndexed;
+                    NumTransitions += Type == ERHICommand::Transition;
+                }
+            }
+            NumCommands += List.GetNumCommands();
+            NumBytes += List.GetSize();
+        }
+
+        if (!Lock.owns_lock())
+        {
+            Lock.lock();
+        }
+        Stats.NumDraws += NumDraws;
+        Stats.NumTransitions += NumTransitions;
+        Stats.NumCommands += NumCommands;
+        Stats.NumBytes += NumBytes;
+        Stats.NumCommandLists += NumLists;
+        ++Stats.NumSubmits;
+        ++NumSubmits;
+    }
+
+    void FRecordingQueue::Signal(FRHIFence* pFence, u64 Value)
+    {
+        // The work submitted before is done already
+        std::lock_guard<std::mutex> Lock(pDevice->Mutex);
+        CommandIndex = 0;
+        if (FRecordingFence* pRecordingFence = CheckResource<FRecordingFence>(pFence, "Signaled fence"))
+        {
+            pRecordingFence->Value = Value;
+        }
+    }
+
+    void FRecordingQueue::Wait(FRHIFence* pFence, u64 Value)
+    {
+        // Another queue can still signal it with work submitted later
+        std::lock_guard<std::mutex> Lock(pDevice->Mutex);
+        CommandIndex = 0;
+        CheckResource<FRecordingFence>(pFence, "Waited fence");
+    }
+
+    FRecordingDevice::FRecordingDevice(const FRecordingRHISettings& InSettings)
+        : Settings(InSettings)
+    {
+        for (u32 Type = 0; Type < u32(ERHIQueueType::Num); ++Type)
+        {
+            Queues[Type].reset(new FRecordingQueue(this, ERHIQueueType(Type)));
+        }
+
+        FTextureDesc BackBufferDesc;
+        BackBufferDesc.Width = std::max(GfxSettings.WindowWidth, 1u);
+        BackBufferDesc.Height = std::max(GfxSettings.WindowHeight, 1u);
+        BackBufferDesc.Format = EPixelFormat::R8G8B8A8_UNORM;
+        BackBufferDesc.Usage = ETextureUsage::RenderTarget;
+        for (TRefCountPtr<FRHITexture>& BackBuffer : BackBuffers)
+        {
+            BackBuffer = TRefCountPtr<FRHITexture>::Create(new RefCounter<FRecordingTexture>(this, BackBufferDesc, EResourceState::Present));
+        }
+    }
+
+    FRecordingDevice::~FRecordingDevice()
+    {
+        for (TRefCountPtr<FRHITexture>& BackBuffer : BackBuffers)
+        {
+            BackBuffer = nullptr;
+        }
+        if (!LiveResources.empty())
+        {
+            DEBUGPRINT("RecordingRHI: %u resources are still alive, they can't be released anymore", unsigned(LiveResources.size()));
+        }
+    }
+
+    TRefCountPtr<FRHIBuffer> FRecordingDevice::CreateBuffer(const FBufferDesc& Desc)
+    {
+        if (Desc.Size == 0)
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHIBuffer>::Create(new RefCounter<FRecordingBuffer>(this, Desc));
+    }
+
+    TRefCountPtr<FRHITexture> FRecordingDevice::CreateTexture(const FTextureDesc& Desc)
+    {
+        if (Desc.Width == 0 || Desc.Height == 0 || Desc.MipLevels == 0 || Desc.Format == EPixelFormat::Unknown)
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHITexture>::Create(new RefCounter<FRecordingTexture>(this, Desc, EResourceState::Common));
+    }
+
+    TRefCountPtr<FRHIGraphicsPipeline> FRecordingDevice::CreateGraphicsPipeline(const FGraphicsPipelineDesc& Desc)
+    {
+        if (Desc.VertexShader.pData == nullptr || Desc.NumVertexElements > RHI_MAX_VERTEX_ELEMENTS || Desc.NumRenderTargets > RHI_MAX_RENDER_TARGETS)
+        {
+            return nullptr;
+        }
+        return TRefCountPtr<FRHIGraphicsPipeline>::Create(new RefCounter<FRecordingGraphicsPipeline>(this, Desc));
+    }
+
+    TRefCountPtr<FRHIFence> FRecordingDevice::CreateFence(u64 InitialValue)
+    {
+        return TRefCountPtr<FRHIFence>::Create(new RefCounter<FRecordingFence>(this, InitialValue));
+    }
+
+    FRHIQueue* FRecordingDevice::GetQueue(ERHIQueueType Type)
+    {
+        return Queues[u32(Type)].get();
+    }
+
+    FRHITexture* FRecordingDevice::GetBackBuffer()
+    {
+        return BackBuffers[BackBufferIndex].Get();
+    }
+
+    void FRecordingDevice::Present()
+    {
+        const FRecordingTexture* pBackBuffer = static_cast<const FRecordingTexture*>(BackBuffers[BackBufferIndex].Get());
+        if (Settings.bValidate && pBackBuffer->State != EResourceState::Present)
+        {
+            ReportError(FRHIValidationError{ ERHIQueueType::Graphics, 0, 0, ERHICommand::Num,
+                std::string("Present of a back buffer in state ") + sResourceStateNames[u32(pBackBuffer->State)] });
+        }
+        BackBufferIndex = (BackBufferIndex + 1) % 2;
+    }
+
+    FRecordingRHIStats FRecordingDevice::GetStats() const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        FRecordingRHIStats Total;
+        for (const std::unique_ptr<FRecordingQueue>& Queue : Queues)
+        {
+            Total.NumSubmits += Queue->Stats.NumSubmits;
+            Total.NumCommandLists += Queue->Stats.NumCommandLists;
+            Total.NumCommands += Queue->Stats.NumCommands;
+            Total.NumDraws += Queue->Stats.NumDraws;
+            Total.NumTransitions += Queue->Stats.NumTransitions;
+            Total.NumBytes += Queue->Stats.NumBytes;
+        }
+        Total.NumErrors = NumErrors;
+        return Total;
+    }
+
+    std::vector<FRHIValidationError> FRecordingDevice::GetErrors() const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        return Errors;
+    }
+
+    void FRecordingDevice::ClearErrors()
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Errors.clear();
+    }
+
+    const std::vector<u8>& FRecordingDevice::GetCapture(ERHIQueueType Type) const
+    {
+        return Queues[u32(Type)]->Capture;
+    }
+
+    void FRecordingDevice::ClearCapture()
+    {
+        for (const std::unique_ptr<FRecordingQueue>& Queue : Queues)
+        {
+            Queue->Capture.clear();
+        }
+    }
+
+    void FRecordingDevice::AddResource(const FRHIResource* pResource)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        LiveResources.insert(pResource);
+    }
+
+    void FRecordingDevice::RemoveResource(const FRHIResource* pResource)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        LiveResources.erase(pResource);
+    }
+
+    void FRecordingDevice::ReportError(FRHIValidationError&& Error)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        AddErrorLocked(std::move(Error));
+    }
+
+    void FRecordingDevice::AddErrorLocked(FRHIValidationError&& Error)
+    {
+        if (Settings.bPrintErrors)
+        {
+            const char* CommandName = Error.Command < ERHICommand::Num ? sCommandNames[u32(Error.Command)] : "-";
+            DEBUGPRINT("RecordingRHI: %s queue, submit %llu, command %u (%s): %s", sQueueNames[u32(Error.Queue)], (unsigned long long)Error.SubmitIndex,
+                Error.CommandIndex, CommandName, Error.Message.c_str());
+        }
+
+        ++NumErrors;
+        if (Errors.size() < MAX_ERRORS)
+        {
+            Errors.push_back(std::move(Error));
+        }
+    }
+}
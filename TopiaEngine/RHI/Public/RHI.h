@@ -1,17 +1,17 @@
-/** This RHI module only includes DirectX12 API for now. */
+/** Rendering hardware interface: the engine records and submits its GPU work through FRHIDevice, which a backend implements. */
 
 #pragma once
 
 #include "RHIForwardDecl.h"
-
-#define D3D12_GPU_VIRTUAL_ADDRESS_NULL		( (D3D12_GPU_VIRTUAL_ADDRESS)  0 )
-#define D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN	( (D3D12_GPU_VIRTUAL_ADDRESS) -1 )
+#include "RHICommandList.h"
+#include "RHIResources.h"
 
 namespace topia
 {
 	struct FGfxSettings
 	{
-		HWND WindowHandle;
+		/** Native handle of the window to present to, the HWND on Windows */
+		void* WindowHandle;
 		u32 WindowHeight;
 		u32 WindowWidth;
 
@@ -21,62 +21,65 @@ namespace topia
 
 	extern FGfxSettings GfxSettings;
 
-	extern void InitializeGfxSettings(HWND Handle, u32 Width, u32 Height, bool bDebug, bool bTearing);
+	extern void InitializeGfxSettings(void* Handle, u32 Width, u32 Height, bool bDebug, bool bTearing);
 
-	struct FGfxContext
+	class FRHIQueue
 	{
-		TRefCountPtr<ID3D12Device>  Device;
-		TRefCountPtr<ID3D12Device1> Device1;
-		TRefCountPtr<ID3D12Device2> Device2;
+	public:
+		virtual ~FRHIQueue() = default;
 
-		TRefCountPtr<ID3D12CommandQueue> GraphicsCommandQueue;
-		TRefCountPtr<ID3D12CommandQueue> ComputeCommandQueue;
-		TRefCountPtr<ID3D12CommandQueue> CopyCommandQueue;
+		ERHIQueueType GetType() const { return Type; }
 
-		TRefCountPtr<ID3D12CommandSignature> DrawIndirectSignature;
-		TRefCountPtr<ID3D12CommandSignature> DispatchIndirectSignature;
+		/** Execute the lists in order. They can be reset and recorded again right away, the backend keeps what it needs. */
+		virtual void Submit(FRHICommandList* const* ppLists, u32 NumLists) = 0;
+		void Submit(FRHICommandList& List)
+		{
+			FRHICommandList* pList = &List;
+			Submit(&pList, 1);
+		}
 
-		TRefCountPtr<ID3D12QueryHeap> TimerQueryHeap;
-		// TRefCountPtr<FBuffer> TimerQueryResolveBuffer;
-	};
+		/** Set the fence to Value once the work submitted before is done */
+		virtual void Signal(FRHIFence* pFence, u64 Value) = 0;
 
-	struct FVertexBuffer
-	{
-		// buffer ptr
-	};
+		/** Don't start the work submitted after until the fence reaches Value */
+		virtual void Wait(FRHIFence* pFence, u64 Value) = 0;
 
-	struct FIndexBuffer
-	{
-		// buffer ptr
-	};
+	protected:
+		explicit FRHIQueue(ERHIQueueType InType) : Type(InType) {}
 
-	struct FPipelineStateObjectDesc
-	{
-		// input layout
-		// root signature, d3d12
-		// vs, ps, hs, ds, etc
-		// rasterizate state
-		// blend state
-		// sample mask
-		// primitive topology type
-		// render target nums
-		// rtv format
+	private:
+		ERHIQueueType Type;
 	};
 
-	struct FPipelineStateObject
+	class FRHIDevice
 	{
-		// pso ptr
+	public:
+		virtual ~FRHIDevice() = default;
 
-		FPipelineStateObjectDesc Desc;
-	};
+		virtual ERHIBackend GetBackend() const = 0;
 
-	struct FRenderTarget
-	{
+		/** Return null when the resource can't be created */
+		virtual TRefCountPtr<FRHIBuffer> CreateBuffer(const FBufferDesc& Desc) = 0;
+		virtual TRefCountPtr<FRHITexture> CreateTexture(const FTextureDesc& Desc) = 0;
+		virtual TRefCountPtr<FRHIGraphicsPipeline> CreateGraphicsPipeline(const FGraphicsPipelineDesc& Desc) = 0;
+		virtual TRefCountPtr<FRHIFence> CreateFence(u64 InitialValue = 0) = 0;
 
+		virtual FRHIQueue* GetQueue(ERHIQueueType Type) = 0;
+
+		/** Render target of the frame, the size of the window in GfxSettings */
+		virtual FRHITexture* GetBackBuffer() = 0;
+		virtual void Present() = 0;
+
+		/** Wait until every queue is done with its work */
+		virtual void WaitIdle() = 0;
 	};
 
-	extern FGfxContext GfxContext;
+	/** Create a device of the backend from GfxSettings, null when it isn't available */
+	extern FRHIDevice* CreateRHIDevice(ERHIBackend Backend);
+
+	extern FRHIDevice* GfxDevice;
 
-	extern void Initialize_RHI();
+	extern void Initialize_RHI(ERHIBackend Backend = ERHIBackend::D3D12);
+	extern void Shutdown_RHI();
 
 } // namespace topia::gfx
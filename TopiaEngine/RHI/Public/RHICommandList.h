@@ -0,0 +1,351 @@
+#pragma once
+
+#include <Noncopyable.h>
+
+#include "RHIResources.h"
+
+#include <cstring>
+#include <memory>
+
+namespace topia
+{
+	enum class ERHICommand : u16
+	{
+		Transition,
+		SetPipeline,
+		SetRenderTargets,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		SetViewport,
+		SetScissor,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetConstantBuffer,
+		SetShaderResource,
+		SetConstants,
+		Draw,
+		DrawIndexed,
+		CopyBuffer,
+		CopyBufferToTexture,
+		Num
+	};
+
+	/** Start of every command in the stream, Size includes the header and what follows the command */
+	struct FRHICommandHeader
+	{
+		ERHICommand Type;
+		u16 Size;
+		u32 Padding;
+	};
+
+	struct FRHICmdTransition
+	{
+		FRHICommandHeader Header;
+		FRHIResource* pResource;
+		EResourceState Before;
+		EResourceState After;
+	};
+
+	struct FRHICmdSetPipeline
+	{
+		FRHICommandHeader Header;
+		FRHIGraphicsPipeline* pPipeline;
+	};
+
+	struct FRHICmdSetRenderTargets
+	{
+		FRHICommandHeader Header;
+		FRHITexture* pRenderTargets[RHI_MAX_RENDER_TARGETS];
+		FRHITexture* pDepthStencil;
+		u32 NumRenderTargets;
+	};
+
+	struct FRHICmdClearRenderTarget
+	{
+		FRHICommandHeader Header;
+		FRHITexture* pTexture;
+		float Color[4];
+	};
+
+	struct FRHICmdClearDepthStencil
+	{
+		FRHICommandHeader Header;
+		FRHITexture* pTexture;
+		float Depth;
+		u8 Stencil;
+	};
+
+	struct FRHICmdSetViewport
+	{
+		FRHICommandHeader Header;
+		float X, Y, Width, Height, MinDepth, MaxDepth;
+	};
+
+	struct FRHICmdSetScissor
+	{
+		FRHICommandHeader Header;
+		u32 Left, Top, Right, Bottom;
+	};
+
+	/** SetVertexBuffer, SetConstantBuffer and SetShaderResource */
+	struct FRHICmdSetBuffer
+	{
+		FRHICommandHeader Header;
+		FRHIBuffer* pBuffer;
+		u64 Offset;
+		u32 Slot;
+	};
+
+	struct FRHICmdSetIndexBuffer
+	{
+		FRHICommandHeader Header;
+		FRHIBuffer* pBuffer;
+		u64 Offset;
+		EIndexFormat Format;
+	};
+
+	/** Followed by NumValues u32 */
+	struct FRHICmdSetConstants
+	{
+		FRHICommandHeader Header;
+		u32 FirstValue;
+		u32 NumValues;
+
+		const u32* GetValues() const { return reinterpret_cast<const u32*>(this + 1); }
+	};
+
+	struct FRHICmdDraw
+	{
+		FRHICommandHeader Header;
+		u32 VertexCount, InstanceCount, FirstVertex, FirstInstance;
+	};
+
+	struct FRHICmdDrawIndexed
+	{
+		FRHICommandHeader Header;
+		u32 IndexCount, InstanceCount, FirstIndex;
+		s32 BaseVertex;
+		u32 FirstInstance;
+	};
+
+	struct FRHICmdCopyBuffer
+	{
+		FRHICommandHeader Header;
+		FRHIBuffer* pDest;
+		FRHIBuffer* pSource;
+		u64 DestOffset, SourceOffset, Size;
+	};
+
+	/** Copies mip 0, the source rows are RowPitch apart */
+	struct FRHICmdCopyBufferToTexture
+	{
+		FRHICommandHeader Header;
+		FRHITexture* pDest;
+		FRHIBuffer* pSource;
+		u64 SourceOffset;
+		u32 RowPitch;
+	};
+
+	/**
+	 * Commands recorded into memory without any backend involved, an FRHIQueue translates them at Submit: D3D12 into a
+	 * ID3D12GraphicsCommandList, the recording backend validates them. Recording only appends to a buffer that is kept across
+	 * Reset, so a list that is reused every frame doesn't allocate. A list is recorded by one thread at a time and can be
+	 * submitted again as it is.
+	 * Resource states are explicit: every transition gives the state the resource is in before it. Resources start in Common,
+	 * the back buffer in Present, and upload and readback buffers stay in GenericRead and CopyDest.
+	 */
+	class FRHICommandList : public NonCopyable
+	{
+	public:
+		void Reset()
+		{
+			Size = 0;
+			NumCommands = 0;
+		}
+
+		void Transition(FRHIBuffer* pBuffer, EResourceState Before, EResourceState After) { AddTransition(pBuffer, Before, After); }
+		void Transition(FRHITexture* pTexture, EResourceState Before, EResourceState After) { AddTransition(pTexture, Before, After); }
+
+		void SetPipeline(FRHIGraphicsPipeline* pPipeline)
+		{
+			Allocate<FRHICmdSetPipeline>(ERHICommand::SetPipeline).pPipeline = pPipeline;
+		}
+
+		void SetRenderTargets(FRHITexture* const* ppRenderTargets, u32 NumRenderTargets, FRHITexture* pDepthStencil)
+		{
+			ASSERT(NumRenderTargets <= RHI_MAX_RENDER_TARGETS);
+			FRHICmdSetRenderTargets& Command = Allocate<FRHICmdSetRenderTargets>(ERHICommand::SetRenderTargets);
+			for (u32 i = 0; i < RHI_MAX_RENDER_TARGETS; ++i)
+			{
+				Command.pRenderTargets[i] = i < NumRenderTargets ? ppRenderTargets[i] : nullptr;
+			}
+			Command.pDepthStencil = pDepthStencil;
+			Command.NumRenderTargets = NumRenderTargets;
+		}
+
+		void ClearRenderTarget(FRHITexture* pTexture, const float Color[4])
+		{
+			FRHICmdClearRenderTarget& Command = Allocate<FRHICmdClearRenderTarget>(ERHICommand::ClearRenderTarget);
+			Command.pTexture = pTexture;
+			memcpy(Command.Color, Color, sizeof(Command.Color));
+		}
+
+		void ClearDepthStencil(FRHITexture* pTexture, float Depth = 1.0f, u8 Stencil = 0)
+		{
+			FRHICmdClearDepthStencil& Command = Allocate<FRHICmdClearDepthStencil>(ERHICommand::ClearDepthStencil);
+			Command.pTexture = pTexture;
+			Command.Depth = Depth;
+			Command.Stencil = Stencil;
+		}
+
+		void SetViewport(float X, float Y, float Width, float Height, float MinDepth = 0.0f, float MaxDepth = 1.0f)
+		{
+			FRHICmdSetViewport& Command = Allocate<FRHICmdSetViewport>(ERHICommand::SetViewport);
+			Command.X = X;
+			Command.Y = Y;
+			Command.Width = Width;
+			Command.Height = Height;
+			Command.MinDepth = MinDepth;
+			Command.MaxDepth = MaxDepth;
+		}
+
+		void SetScissor(u32 Left, u32 Top, u32 Right, u32 Bottom)
+		{
+			FRHICmdSetScissor& Command = Allocate<FRHICmdSetScissor>(ERHICommand::SetScissor);
+			Command.Left = Left;
+			Command.Top = Top;
+			Command.Right = Right;
+			Command.Bottom = Bottom;
+		}
+
+		/** The stride is the one of the buffer desc */
+		void SetVertexBuffer(u32 Stream, FRHIBuffer* pBuffer, u64 Offset = 0) { AddSetBuffer(ERHICommand::SetVertexBuffer, Stream, pBuffer, Offset); }
+
+		void SetIndexBuffer(FRHIBuffer* pBuffer, EIndexFormat Format, u64 Offset = 0)
+		{
+			FRHICmdSetIndexBuffer& Command = Allocate<FRHICmdSetIndexBuffer>(ERHICommand::SetIndexBuffer);
+			Command.pBuffer = pBuffer;
+			Command.Offset = Offset;
+			Command.Format = Format;
+		}
+
+		/** Offset is a multiple of 256 */
+		void SetConstantBuffer(u32 Slot, FRHIBuffer* pBuffer, u64 Offset = 0) { AddSetBuffer(ERHICommand::SetConstantBuffer, Slot, pBuffer, Offset); }
+		void SetShaderResource(u32 Slot, FRHIBuffer* pBuffer, u64 Offset = 0) { AddSetBuffer(ERHICommand::SetShaderResource, Slot, pBuffer, Offset); }
+
+		/** Set root constants FirstValue to FirstValue + NumValues of b0 */
+		void SetConstants(const void* pValues, u32 NumValues, u32 FirstValue = 0)
+		{
+			ASSERT(NumValues <= RHI_MAX_CONSTANTS);
+			FRHICmdSetConstants& Command = Allocate<FRHICmdSetConstants>(ERHICommand::SetConstants, NumValues * sizeof(u32));
+			Command.FirstValue = FirstValue;
+			Command.NumValues = NumValues;
+			memcpy(&Command + 1, pValues, NumValues * sizeof(u32));
+		}
+
+		void Draw(u32 VertexCount, u32 InstanceCount = 1, u32 FirstVertex = 0, u32 FirstInstance = 0)
+		{
+			FRHICmdDraw& Command = Allocate<FRHICmdDraw>(ERHICommand::Draw);
+			Command.VertexCount = VertexCount;
+			Command.InstanceCount = InstanceCount;
+			Command.FirstVertex = FirstVertex;
+			Command.FirstInstance = FirstInstance;
+		}
+
+		void DrawIndexed(u32 IndexCount, u32 InstanceCount = 1, u32 FirstIndex = 0, s32 BaseVertex = 0, u32 FirstInstance = 0)
+		{
+			FRHICmdDrawIndexed& Command = Allocate<FRHICmdDrawIndexed>(ERHICommand::DrawIndexed);
+			Command.IndexCount = IndexCount;
+			Command.InstanceCount = InstanceCount;
+			Command.FirstIndex = FirstIndex;
+			Command.BaseVertex = BaseVertex;
+			Command.FirstInstance = FirstInstance;
+		}
+
+		void CopyBuffer(FRHIBuffer* pDest, u64 DestOffset, FRHIBuffer* pSource, u64 SourceOffset, u64 NumBytes)
+		{
+			FRHICmdCopyBuffer& Command = Allocate<FRHICmdCopyBuffer>(ERHICommand::CopyBuffer);
+			Command.pDest = pDest;
+			Command.pSource = pSource;
+			Command.DestOffset = DestOffset;
+			Command.SourceOffset = SourceOffset;
+			Command.Size = NumBytes;
+		}
+
+		/** RowPitch is a multiple of RHI_TEXTURE_ROW_PITCH_ALIGNMENT */
+		void CopyBufferToTexture(FRHITexture* pDest, FRHIBuffer* pSource, u64 SourceOffset, u32 RowPitch)
+		{
+			FRHICmdCopyBufferToTexture& Command = Allocate<FRHICmdCopyBufferToTexture>(ERHICommand::CopyBufferToTexture);
+			Command.pDest = pDest;
+			Command.pSource = pSource;
+			Command.SourceOffset = SourceOffset;
+			Command.RowPitch = RowPitch;
+		}
+
+		/** The commands, each starts with an FRHICommandHeader */
+		const u8* GetData() const { return reinterpret_cast<const u8*>(Data.get()); }
+		u64 GetSize() const { return Size; }
+		u32 GetNumCommands() const { return NumCommands; }
+
+	private:
+		template <typename T>
+		T& Allocate(ERHICommand Type, u32 ExtraSize = 0)
+		{
+			// Commands start 8 byte aligned for their pointers
+			const u32 CommandSize = (u32(sizeof(T)) + ExtraSize + 7) & ~7u;
+			if (Size + CommandSize > Capacity)
+			{
+				Grow(Size + CommandSize);
+			}
+
+			T& Command = *reinterpret_cast<T*>(reinterpret_cast<u8*>(Data.get()) + Size);
+			Command.Header.Type = Type;
+			Command.Header.Size = u16(CommandSize);
+			Size += CommandSize;
+			++NumCommands;
+			return Command;
+		}
+
+		void AddTransition(FRHIResource* pResource, EResourceState Before, EResourceState After)
+		{
+			FRHICmdTransition& Command = Allocate<FRHICmdTransition>(ERHICommand::Transition);
+			Command.pResource = pResource;
+			Command.Before = Before;
+			Command.After = After;
+		}
+
+		void AddSetBuffer(ERHICommand Type, u32 Slot, FRHIBuffer* pBuffer, u64 Offset)
+		{
+			FRHICmdSetBuffer& Command = Allocate<FRHICmdSetBuffer>(Type);
+			Command.pBuffer = pBuffer;
+			Command.Offset = Offset;
+			Command.Slot = Slot;
+		}
+
+		void Grow(u64 MinCapacity);
+
+		std::unique_ptr<u64[]> Data;
+		u64 Size = 0;
+		u64 Capacity = 0;
+		u32 NumCommands = 0;
+	};
+
+	/** Walks the commands of a list */
+	class FRHICommandReader
+	{
+	public:
+		explicit FRHICommandReader(const FRHICommandList& List) : pCommand(List.GetData()), pEnd(List.GetData() + List.GetSize()) {}
+
+		bool IsValid() const { return pCommand < pEnd; }
+		void Next() { pCommand += Get<FRHICommandHeader>().Size; }
+
+		ERHICommand GetType() const { return Get<FRHICommandHeader>().Type; }
+
+		template <typename T>
+		const T& Get() const { return *reinterpret_cast<const T*>(pCommand); }
+
+	private:
+		const u8* pCommand;
+		const u8* pEnd;
+	};
+}
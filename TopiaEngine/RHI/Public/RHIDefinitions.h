@@ -0,0 +1,191 @@
+#pragma once
+
+#include <Topia.h>
+
+namespace topia
+{
+	/** Root constants, constant buffers and buffer shader resources a pipeline can bind, see FRHICommandList */
+	static constexpr u32 RHI_MAX_CONSTANTS = 16;
+	static constexpr u32 RHI_MAX_CONSTANT_BUFFERS = 2;
+	static constexpr u32 RHI_MAX_SHADER_RESOURCES = 2;
+	static constexpr u32 RHI_MAX_RENDER_TARGETS = 8;
+	static constexpr u32 RHI_MAX_VERTEX_STREAMS = 4;
+	static constexpr u32 RHI_MAX_VERTEX_ELEMENTS = 16;
+
+	/** Rows of a buffer copied to a texture start at multiples of this */
+	static constexpr u32 RHI_TEXTURE_ROW_PITCH_ALIGNMENT = 256;
+
+	enum class ERHIBackend : u8
+	{
+		D3D12,
+		Recording,      // Validates and records command streams in memory, without a GPU
+	};
+
+	enum class ERHIQueueType : u8
+	{
+		Graphics,
+		Compute,
+		Copy,
+		Num
+	};
+
+	enum class EPixelFormat : u8
+	{
+		Unknown,
+		R8G8B8A8_UNORM,
+		R8G8B8A8_SRGB,
+		B8G8R8A8_UNORM,
+		R8G8B8A8_SNORM,
+		R16G16_FLOAT,
+		R16G16B16A16_FLOAT,
+		R16G16B16A16_SNORM,
+		R16_UINT,
+		R32_UINT,
+		R32_FLOAT,
+		R32G32_FLOAT,
+		R32G32B32_FLOAT,
+		R32G32B32A32_FLOAT,
+		D32_FLOAT,
+		D24_UNORM_S8_UINT,
+		Num
+	};
+
+	/** Bytes per pixel or vertex element */
+	inline u32 GetPixelFormatSize(EPixelFormat Format)
+	{
+		static const u8 Sizes[] = { 0, 4, 4, 4, 4, 4, 8, 8, 2, 4, 4, 8, 12, 16, 4, 4 };
+		static_assert(sizeof(Sizes) == size_t(EPixelFormat::Num), "Every format needs a size");
+		return Sizes[u32(Format)];
+	}
+
+	inline bool IsDepthFormat(EPixelFormat Format)
+	{
+		return Format == EPixelFormat::D32_FLOAT || Format == EPixelFormat::D24_UNORM_S8_UINT;
+	}
+
+	enum class EResourceState : u8
+	{
+		Common,
+		VertexBuffer,
+		IndexBuffer,
+		ConstantBuffer,
+		ShaderResource,
+		UnorderedAccess,
+		IndirectArgument,
+		RenderTarget,
+		DepthWrite,
+		DepthRead,
+		CopySource,
+		CopyDest,
+		Present,
+		GenericRead,    // Upload buffers, which stay in it
+		Num
+	};
+
+	enum class EMemoryType : u8
+	{
+		Default,        // GPU memory, written by copies from upload buffers
+		Upload,         // CPU writes, GPU reads, always in EResourceState::GenericRead
+		Readback,       // GPU writes with copies, CPU reads, always in EResourceState::CopyDest
+	};
+
+	enum class EBufferUsage : u8
+	{
+		None            = 0,
+		Vertex          = 1 << 0,
+		Index           = 1 << 1,
+		Constant        = 1 << 2,
+		ShaderResource  = 1 << 3,
+		UnorderedAccess = 1 << 4,
+		Indirect        = 1 << 5,
+	};
+	ENUM_CLASS_FLAG_OPERATORS(EBufferUsage)
+
+	enum class ETextureUsage : u8
+	{
+		None            = 0,
+		ShaderResource  = 1 << 0,
+		RenderTarget    = 1 << 1,
+		DepthStencil    = 1 << 2,
+		UnorderedAccess = 1 << 3,
+	};
+	ENUM_CLASS_FLAG_OPERATORS(ETextureUsage)
+
+	enum class EIndexFormat : u8
+	{
+		UInt16,
+		UInt32,
+	};
+
+	enum class EPrimitiveTopology : u8
+	{
+		TriangleList,
+		TriangleStrip,
+		LineList,
+		PointList,
+	};
+
+	enum class ECullMode : u8
+	{
+		None,
+		Front,
+		Back,
+	};
+
+	struct FBufferDesc
+	{
+		u64 Size = 0;
+		u32 Stride = 0;     // Of a vertex for vertex buffers, of an element for structured shader resources
+		EBufferUsage Usage = EBufferUsage::None;
+		EMemoryType Memory = EMemoryType::Default;
+	};
+
+	struct FTextureDesc
+	{
+		u32 Width = 1;
+		u32 Height = 1;
+		u32 MipLevels = 1;
+		EPixelFormat Format = EPixelFormat::R8G8B8A8_UNORM;
+		ETextureUsage Usage = ETextureUsage::ShaderResource;
+		float ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };     // Fastest clear of render targets, depth targets clear fastest to 1
+	};
+
+	struct FShaderBytecode
+	{
+		const void* pData = nullptr;
+		u64 Size = 0;
+	};
+
+	struct FVertexElement
+	{
+		const char* SemanticName = nullptr;     // A string literal, the pipeline keeps the pointer
+		u32 SemanticIndex = 0;
+		EPixelFormat Format = EPixelFormat::R32G32B32_FLOAT;
+		u32 Stream = 0;
+		u32 Offset = 0;
+		bool bPerInstance = false;
+	};
+
+	/**
+	 * Graphics pipeline. The shaders see RHI_MAX_CONSTANTS 32 bit root constants in b0, RHI_MAX_CONSTANT_BUFFERS constant buffers
+	 * from b1 and RHI_MAX_SHADER_RESOURCES buffers from t0. The bytecode only has to live until CreateGraphicsPipeline returns.
+	 */
+	struct FGraphicsPipelineDesc
+	{
+		FShaderBytecode VertexShader;
+		FShaderBytecode PixelShader;
+
+		FVertexElement VertexElements[RHI_MAX_VERTEX_ELEMENTS];
+		u32 NumVertexElements = 0;
+
+		EPrimitiveTopology Topology = EPrimitiveTopology::TriangleList;
+		ECullMode CullMode = ECullMode::Back;
+		bool bDepthTest = true;
+		bool bDepthWrite = true;
+		bool bAlphaBlend = false;
+
+		EPixelFormat RenderTargetFormats[RHI_MAX_RENDER_TARGETS] = {};
+		u32 NumRenderTargets = 1;
+		EPixelFormat DepthStencilFormat = EPixelFormat::Unknown;
+	};
+}
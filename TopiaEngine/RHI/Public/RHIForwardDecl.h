@@ -2,13 +2,14 @@
 
 #include <Topia.h>
 
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-
-#include "d3dx12.h"
-
 namespace topia
 {
-
+	class FRHIDevice;
+	class FRHIQueue;
+	class FRHICommandList;
+	class FRHIResource;
+	class FRHIBuffer;
+	class FRHITexture;
+	class FRHIGraphicsPipeline;
+	class FRHIFence;
 }
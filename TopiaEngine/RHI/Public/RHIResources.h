@@ -0,0 +1,90 @@
+#pragma once
+
+#include "RHIDefinitions.h"
+
+namespace topia
+{
+	enum class ERHIResourceType : u8
+	{
+		Buffer,
+		Texture,
+		GraphicsPipeline,
+		Fence,
+	};
+
+	/**
+	 * Objects created by an FRHIDevice, reference counted with TRefCountPtr and implemented with RefCounter by the backend.
+	 * Command lists hold plain pointers: a resource has to be kept alive until the GPU is done with the commands that use it.
+	 */
+	class FRHIResource
+	{
+	public:
+		virtual ~FRHIResource() = default;
+
+		virtual unsigned long AddRef() = 0;
+		virtual unsigned long Release() = 0;
+
+		ERHIResourceType GetResourceType() const { return ResourceType; }
+
+	protected:
+		explicit FRHIResource(ERHIResourceType InResourceType) : ResourceType(InResourceType) {}
+
+	private:
+		ERHIResourceType ResourceType;
+	};
+
+	class FRHIBuffer : public FRHIResource
+	{
+	public:
+		const FBufferDesc& GetDesc() const { return Desc; }
+
+		/** Upload and Readback buffers only. The pointer stays valid until Unmap, reads of upload buffers are slow. */
+		virtual void* Map() = 0;
+		virtual void Unmap() = 0;
+
+	protected:
+		explicit FRHIBuffer(const FBufferDesc& InDesc) : FRHIResource(ERHIResourceType::Buffer), Desc(InDesc) {}
+
+		FBufferDesc Desc;
+	};
+
+	class FRHITexture : public FRHIResource
+	{
+	public:
+		const FTextureDesc& GetDesc() const { return Desc; }
+
+	protected:
+		explicit FRHITexture(const FTextureDesc& InDesc) : FRHIResource(ERHIResourceType::Texture), Desc(InDesc) {}
+
+		FTextureDesc Desc;
+	};
+
+	class FRHIGraphicsPipeline : public FRHIResource
+	{
+	public:
+		/** The shader bytecode of the desc is not kept */
+		const FGraphicsPipelineDesc& GetDesc() const { return Desc; }
+
+	protected:
+		explicit FRHIGraphicsPipeline(const FGraphicsPipelineDesc& InDesc) : FRHIResource(ERHIResourceType::GraphicsPipeline), Desc(InDesc)
+		{
+			Desc.VertexShader = FShaderBytecode();
+			Desc.PixelShader = FShaderBytecode();
+		}
+
+		FGraphicsPipelineDesc Desc;
+	};
+
+	/** Value that queues signal when they reach a point of their work, and that the CPU or other queues wait for */
+	class FRHIFence : public FRHIResource
+	{
+	public:
+		virtual u64 GetCompletedValue() = 0;
+
+		/** Block the calling thread until the fence reaches Value */
+		virtual void Wait(u64 Value) = 0;
+
+	protected:
+		FRHIFence() : FRHIResource(ERHIResourceType::Fence) {}
+	};
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "RHI.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace topia
+{
+	struct FRecordingRHISettings
+	{
+		/** Check the commands at Submit, see FRecordingDevice */
+		bool bValidate = true;
+
+		/** Append the submitted command streams to the capture of their queue */
+		bool bCapture = false;
+
+		/** Print the validation errors as they are found */
+		bool bPrintErrors = true;
+	};
+
+	struct FRHIValidationError
+	{
+		ERHIQueueType Queue;    // Num for the CPU
+		u64 SubmitIndex;        // Counted per queue
+		u32 CommandIndex;       // In its command list
+		ERHICommand Command;
+		std::string Message;
+	};
+
+	struct FRecordingRHIStats
+	{
+		u64 NumSubmits = 0;
+		u64 NumCommandLists = 0;
+		u64 NumCommands = 0;
+		u64 NumDraws = 0;
+		u64 NumTransitions = 0;
+		u64 NumBytes = 0;
+		u64 NumErrors = 0;
+	};
+
+	class FRecordingQueue;
+
+	/**
+	 * Backend without a GPU: queues run the commands they are given at Submit on the CPU, which only tracks what the GPU would
+	 * see. With bValidate it reports the mistakes the D3D12 debug layer would, and some it can't see without running:
+	 * - resources that were released, or belong to another device
+	 * - transitions from another state than the one the resource is in, and resources used in the wrong state or without the
+	 *   usage flag for it, tracked across command lists and submits
+	 * - draws without pipeline, viewport, vertex or index buffers it needs, or render targets that don't match the pipeline
+	 * - index, vertex, constant and copy ranges outside their buffer, misaligned offsets and pitches
+	 * - graphics commands on copy queues
+	 * Fences are signaled at Submit since the work is done by then, so a CPU wait for a value no queue signaled, which would
+	 * never return, is reported too. The checks of a submit run under a lock of the device.
+	 */
+	class FRecordingDevice : public FRHIDevice
+	{
+	public:
+		explicit FRecordingDevice(const FRecordingRHISettings& InSettings = FRecordingRHISettings());
+		~FRecordingDevice() override;
+
+		ERHIBackend GetBackend() const override { return ERHIBackend::Recording; }
+
+		TRefCountPtr<FRHIBuffer> CreateBuffer(const FBufferDesc& Desc) override;
+		TRefCountPtr<FRHITexture> CreateTexture(const FTextureDesc& Desc) override;
+		TRefCountPtr<FRHIGraphicsPipeline> CreateGraphicsPipeline(const FGraphicsPipelineDesc& Desc) override;
+		TRefCountPtr<FRHIFence> CreateFence(u64 InitialValue = 0) override;
+
+		FRHIQueue* GetQueue(ERHIQueueType Type) override;
+
+		FRHITexture* GetBackBuffer() override;
+		void Present() override;
+
+		void WaitIdle() override {}
+
+		const FRecordingRHISettings& GetSettings() const { return Settings; }
+
+		/** Of all the queues */
+		FRecordingRHIStats GetStats() const;
+		std::vector<FRHIValidationError> GetErrors() const;
+		void ClearErrors();
+
+		/** Command streams submitted to the queue since the last ClearCapture, with bCapture */
+		const std::vector<u8>& GetCapture(ERHIQueueType Type) const;
+		void ClearCapture();
+
+		/** For the resources, which register while they are alive */
+		void AddResource(const FRHIResource* pResource);
+		void RemoveResource(const FRHIResource* pResource);
+
+		void ReportError(FRHIValidationError&& Error);
+
+	private:
+		friend class FRecordingQueue;
+
+		/** Errors kept for GetErrors, NumErrors of the stats counts them all */
+		static constexpr u32 MAX_ERRORS = 1024;
+
+		void AddErrorLocked(FRHIValidationError&& Error);
+
+		FRecordingRHISettings Settings;
+		std::unique_ptr<FRecordingQueue> Queues[u32(ERHIQueueType::Num)];
+		TRefCountPtr<FRHITexture> BackBuffers[2];
+		u32 BackBufferIndex = 0;
+
+		mutable std::mutex Mutex;
+		std::unordered_set<const FRHIResource*> LiveResources;
+		std::vector<FRHIValidationError> Errors;
+		u64 NumErrors = 0;
+	};
+}
@@ -0,0 +1,380 @@
+#include "BVH4.h"
+
+#include <atomic>
+
+namespace topia
+{
+	// Definitions of the constants, they are taken by reference (std::min) so C++14 needs them
+	constexpr u32 BVH4::cInvalidChild;
+	constexpr u32 BVH4::cLeafFlag;
+	constexpr uint BVH4::cLeafCountBits;
+	constexpr uint BVH4::cMaxLeafSize;
+	constexpr uint BVH4::cStackSize;
+	constexpr uint BVH4::cMaxPrimitives;
+
+	namespace
+	{
+		/// Node of the intermediate binary tree
+		class BinaryNode
+		{
+		public:
+			bool IsLeaf() const { return mChild[0] == BVH4::cInvalidChild; }
+
+			AABox mBounds;
+			u32 mChild[2]; ///< Children or cInvalidChild for a leaf
+			u32 mStart; ///< First primitive (leaf only)
+			u32 mCount; ///< Number of primitives (leaf only)
+		};
+
+		/// Primitive as seen by the builder, primitives are reordered in place so that every pass over a range reads memory sequentially
+		class BuildPrimitive
+		{
+		public:
+			AABox mBounds;
+			Vec3 mCentroid;
+			u32 mIndex; ///< Index in the array passed to BVH4::Build
+		};
+
+		/// Binned SAH builder for the binary tree
+		class BinaryBuilder
+		{
+		public:
+			/// Ranges with at least this many primitives build their two subtrees on the thread pool
+			static constexpr u32 cMinPrimitivesPerTask = 16384;
+
+			/// Beyond this depth every split uses the median, which bounds the depth of the tree (and the traversal stack) for degenerate input
+			static constexpr uint cMaxSAHDepth = 48;
+
+			/// Max number of bins
+			static constexpr uint cMaxBins = 64;
+
+			BinaryBuilder(const AABox *inBounds, uint inNumPrimitives, const BVH4BuildSettings &inSettings) :
+				mMaxLeafSize(std::max(1u, std::min(inSettings.mMaxLeafSize, BVH4::cMaxLeafSize))),
+				mNumBins(std::max(2u, std::min(inSettings.mNumBins, cMaxBins))),
+				mThreadPool(inSettings.mThreadPool),
+				mPrimitives(inNumPrimitives),
+				mNodes(std::max(1u, 2 * inNumPrimitives - 1))
+			{
+				for (uint i = 0; i < inNumPrimitives; ++i)
+				{
+					BuildPrimitive &primitive = mPrimitives[i];
+					primitive.mBounds = inBounds[i];
+					primitive.mCentroid = inBounds[i].GetCenter();
+					primitive.mIndex = i;
+				}
+			}
+
+			/// Allocate a node, can be called from multiple threads
+			u32 AllocateNode()
+			{
+				const u32 index = mNumNodes.fetch_add(1, std::memory_order_relaxed);
+				ASSERT(index < mNodes.size());
+				return index;
+			}
+
+			/// Build the subtree for primitives mPrimitives[inStart, inStart + inCount) into node inNode
+			void Build(u32 inNode, u32 inStart, u32 inCount, uint inDepth)
+			{
+				BinaryNode &node = mNodes[inNode];
+
+				// Calculate bounds of the primitives and of their centroids
+				AABox bounds, centroid_bounds;
+				for (const BuildPrimitive *p = &mPrimitives[inStart], *end = p + inCount; p < end; ++p)
+				{
+					bounds.Encapsulate(p->mBounds);
+					centroid_bounds.Encapsulate(p->mCentroid);
+				}
+				node.mBounds = bounds;
+
+				if (inCount <= mMaxLeafSize)
+				{
+					MakeLeaf(node, inStart, inCount);
+					return;
+				}
+
+				const u32 num_left = Partition(inStart, inCount, centroid_bounds, inDepth);
+				node.mChild[0] = AllocateNode();
+				node.mChild[1] = AllocateNode();
+				const u32 left = node.mChild[0], right = node.mChild[1];
+
+				if (mThreadPool != nullptr && inCount >= 2 * cMinPrimitivesPerTask)
+				{
+					// The subtrees don't share primitives or nodes, build them on the pool. Smaller ranges further down run inline.
+					mThreadPool->ParallelFor(2, [this, left, right, inStart, inCount, num_left, inDepth](u32 inSide)
+					{
+						if (inSide == 0)
+							Build(left, inStart, num_left, inDepth + 1);
+						else
+							Build(right, inStart + num_left, inCount - num_left, inDepth + 1);
+					});
+				}
+				else
+				{
+					Build(left, inStart, num_left, inDepth + 1);
+					Build(right, inStart + num_left, inCount - num_left, inDepth + 1);
+				}
+			}
+
+			const std::vector<BinaryNode> &GetNodes() const { return mNodes; }
+			const std::vector<BuildPrimitive> &GetPrimitives() const { return mPrimitives; }
+
+		private:
+			void MakeLeaf(BinaryNode &ioNode, u32 inStart, u32 inCount) const
+			{
+				ioNode.mChild[0] = ioNode.mChild[1] = BVH4::cInvalidChild;
+				ioNode.mStart = inStart;
+				ioNode.mCount = inCount;
+			}
+
+			/// Reorder the range so that the primitives that go left come first, returns the number of primitives that go left (always in [1, inCount - 1])
+			u32 Partition(u32 inStart, u32 inCount, const AABox &inCentroidBounds, uint inDepth)
+			{
+				BuildPrimitive *begin = &mPrimitives[inStart], *end = begin + inCount;
+				const Vec3 centroid_size = inCentroidBounds.GetSize();
+
+				if (inDepth < cMaxSAHDepth)
+				{
+					// Bin the centroids along all axis in a single pass over the primitives, an axis without extent gets scale 0 so everything lands in bin 0
+					const Vec3 min = inCentroidBounds.mMin;
+					const Vec3 scale = Vec3::sSelect(Vec3::sReplicate(float(mNumBins)) / centroid_size, Vec3::sZero(), Vec3::sLessOrEqual(centroid_size, Vec3::sZero()));
+					AABox bin_bounds[3][cMaxBins];
+					u32 bin_count[3][cMaxBins] = {};
+					for (const BuildPrimitive *p = begin; p < end; ++p)
+					{
+						const UVec4 bin = GetBins(p->mCentroid, min, scale);
+						const AABox &bounds = p->mBounds;
+						for (uint axis = 0; axis < 3; ++axis)
+						{
+							const uint b = bin[axis];
+							bin_bounds[axis][b].Encapsulate(bounds);
+							++bin_count[axis][b];
+						}
+					}
+
+					// Find the split with the lowest cost (left area * left count + right area * right count)
+					float best_cost = std::numeric_limits<float>::max();
+					uint best_axis = 0, best_split = 0;
+					for (uint axis = 0; axis < 3; ++axis)
+					{
+						// Sweep from the right to get the cost of all right sides, then from the left to evaluate the splits
+						float right_cost[cMaxBins];
+						AABox right_bounds;
+						u32 right_count = 0;
+						for (uint bin = mNumBins - 1; bin > 0; --bin)
+						{
+							right_bounds.Encapsulate(bin_bounds[axis][bin]);
+							right_count += bin_count[axis][bin];
+							right_cost[bin] = right_count > 0? right_bounds.GetSurfaceArea() * float(right_count) : 0.0f;
+						}
+						AABox left_bounds;
+						u32 left_count = 0;
+						for (uint split = 1; split < mNumBins; ++split)
+						{
+							left_bounds.Encapsulate(bin_bounds[axis][split - 1]);
+							left_count += bin_count[axis][split - 1];
+							if (left_count == 0 || left_count == inCount)
+								continue;
+							const float cost = left_bounds.GetSurfaceArea() * float(left_count) + right_cost[split];
+							if (cost < best_cost)
+							{
+								best_cost = cost;
+								best_axis = axis;
+								best_split = split;
+							}
+						}
+					}
+
+					if (best_split != 0)
+					{
+						const BuildPrimitive *middle = std::partition(begin, end, [this, min, scale, best_axis, best_split](const BuildPrimitive &inPrimitive) { return GetBins(inPrimitive.mCentroid, min, scale)[best_axis] < best_split; });
+						return u32(middle - begin);
+					}
+				}
+
+				// All centroids in one bin or the tree is getting too deep: split at the median of the largest axis
+				const uint axis = uint(centroid_size.GetHighestComponentIndex());
+				BuildPrimitive *middle = begin + inCount / 2;
+				std::nth_element(begin, middle, end, [axis](const BuildPrimitive &inLHS, const BuildPrimitive &inRHS) { return inLHS.mCentroid[axis] < inRHS.mCentroid[axis]; });
+				return inCount / 2;
+			}
+
+			/// Get the bin index of a centroid for all axis
+			TOPIA_INLINE UVec4 GetBins(Vec3Arg inCentroid, Vec3Arg inMin, Vec3Arg inScale) const
+			{
+				return UVec4::sMin(((inCentroid - inMin) * inScale).ToInt(), UVec4::sReplicate(mNumBins - 1));
+			}
+
+			uint mMaxLeafSize;
+			uint mNumBins;
+			FThreadPool *mThreadPool;
+			std::vector<BuildPrimitive> mPrimitives;
+			std::vector<BinaryNode> mNodes;
+			std::atomic<u32> mNumNodes { 1 }; // Node 0 is the root
+		};
+
+		constexpr u32 BinaryBuilder::cMinPrimitivesPerTask;
+		constexpr uint BinaryBuilder::cMaxSAHDepth;
+		constexpr uint BinaryBuilder::cMaxBins;
+
+		/// Convert a child of a binary node into a BVH4 child reference
+		u32 sCollapse(const std::vector<BinaryNode> &inBinaryNodes, u32 inBinaryNode, std::vector<BVH4::Node> &ioNodes);
+
+		/// Create a BVH4 node for the binary node inBinaryNode (which must not be a leaf), returns its index
+		u32 sCollapseNode(const std::vector<BinaryNode> &inBinaryNodes, u32 inBinaryNode, std::vector<BVH4::Node> &ioNodes)
+		{
+			// Gather up to 4 children by repeatedly opening the internal child with the largest surface area
+			u32 children[4] = { inBinaryNodes[inBinaryNode].mChild[0], inBinaryNodes[inBinaryNode].mChild[1] };
+			uint num_children = 2;
+			while (num_children < 4)
+			{
+				int best = -1;
+				float best_area = -1.0f;
+				for (uint i = 0; i < num_children; ++i)
+				{
+					const BinaryNode &child = inBinaryNodes[children[i]];
+					if (!child.IsLeaf() && child.mBounds.GetSurfaceArea() > best_area)
+					{
+						best = int(i);
+						best_area = child.mBounds.GetSurfaceArea();
+					}
+				}
+				if (best < 0)
+					break;
+				const BinaryNode &opened = inBinaryNodes[children[best]];
+				children[best] = opened.mChild[0];
+				children[num_children++] = opened.mChild[1];
+			}
+
+			// Allocate the node before the children so that children always have a higher index
+			const u32 node_index = u32(ioNodes.size());
+			ioNodes.emplace_back();
+
+			const AABox empty;
+			float min_x[4], min_y[4], min_z[4], max_x[4], max_y[4], max_z[4];
+			u32 child_refs[4];
+			for (uint i = 0; i < 4; ++i)
+			{
+				const AABox &bounds = i < num_children? inBinaryNodes[children[i]].mBounds : empty;
+				min_x[i] = bounds.mMin.GetX();
+				min_y[i] = bounds.mMin.GetY();
+				min_z[i] = bounds.mMin.GetZ();
+				max_x[i] = bounds.mMax.GetX();
+				max_y[i] = bounds.mMax.GetY();
+				max_z[i] = bounds.mMax.GetZ();
+				child_refs[i] = i < num_children? sCollapse(inBinaryNodes, children[i], ioNodes) : BVH4::cInvalidChild;
+			}
+
+			// ioNodes may have been reallocated by the recursion
+			BVH4::Node &node = ioNodes[node_index];
+			node.mMinX = Vec4(min_x[0], min_x[1], min_x[2], min_x[3]);
+			node.mMinY = Vec4(min_y[0], min_y[1], min_y[2], min_y[3]);
+			node.mMinZ = Vec4(min_z[0], min_z[1], min_z[2], min_z[3]);
+			node.mMaxX = Vec4(max_x[0], max_x[1], max_x[2], max_x[3]);
+			node.mMaxY = Vec4(max_y[0], max_y[1], max_y[2], max_y[3]);
+			node.mMaxZ = Vec4(max_z[0], max_z[1], max_z[2], max_z[3]);
+			for (uint i = 0; i < 4; ++i)
+				node.mChild[i] = child_refs[i];
+			return node_index;
+		}
+
+		u32 sCollapse(const std::vector<BinaryNode> &inBinaryNodes, u32 inBinaryNode, std::vector<BVH4::Node> &ioNodes)
+		{
+			const BinaryNode &node = inBinaryNodes[inBinaryNode];
+			if (node.IsLeaf())
+			{
+				ASSERT(node.mStart < BVH4::cMaxPrimitives && node.mCount <= BVH4::cMaxLeafSize); // Build rejects larger inputs
+				return BVH4::cLeafFlag | (node.mStart << BVH4::cLeafCountBits) | node.mCount;
+			}
+			return sCollapseNode(inBinaryNodes, inBinaryNode, ioNodes);
+		}
+
+		/// Get the bounds of all 4 children of a node
+		AABox sGetNodeBounds(const BVH4::Node &inNode)
+		{
+			return AABox(
+				Vec3(inNode.mMinX.ReduceMin(), inNode.mMinY.ReduceMin(), inNode.mMinZ.ReduceMin()),
+				Vec3(inNode.mMaxX.ReduceMax(), inNode.mMaxY.ReduceMax(), inNode.mMaxZ.ReduceMax()));
+		}
+	} // namespace
+
+	bool BVH4::Build(const AABox *inBounds, uint inNumPrimitives, const BVH4BuildSettings &inSettings)
+	{
+		mNodes.clear();
+		mPrimitiveIndices.clear();
+		mBounds.SetEmpty();
+
+		// A leaf stores its first primitive in the bits below cLeafFlag, more primitives would silently wrap into other leaves
+		if (inNumPrimitives > cMaxPrimitives)
+			return false;
+
+		mPrimitiveIndices.resize(inNumPrimitives);
+		if (inNumPrimitives == 0)
+			return true;
+
+		BinaryBuilder builder(inBounds, inNumPrimitives, inSettings);
+		builder.Build(0, 0, inNumPrimitives, 0);
+		const std::vector<BuildPrimitive> &primitives = builder.GetPrimitives();
+		for (uint i = 0; i < inNumPrimitives; ++i)
+			mPrimitiveIndices[i] = primitives[i].mIndex;
+		const std::vector<BinaryNode> &binary_nodes = builder.GetNodes();
+		mBounds = binary_nodes[0].mBounds;
+
+		// A binary tree with N leaves collapses into roughly N / 3 nodes
+		mNodes.reserve(inNumPrimitives / 3 + 1);
+		if (binary_nodes[0].IsLeaf())
+		{
+			// Everything fits in a single leaf, make a root with one child
+			const AABox empty;
+			Node root;
+			root.mMinX = Vec4(mBounds.mMin.GetX(), empty.mMin.GetX(), empty.mMin.GetX(), empty.mMin.GetX());
+			root.mMinY = Vec4(mBounds.mMin.GetY(), empty.mMin.GetY(), empty.mMin.GetY(), empty.mMin.GetY());
+			root.mMinZ = Vec4(mBounds.mMin.GetZ(), empty.mMin.GetZ(), empty.mMin.GetZ(), empty.mMin.GetZ());
+			root.mMaxX = Vec4(mBounds.mMax.GetX(), empty.mMax.GetX(), empty.mMax.GetX(), empty.mMax.GetX());
+			root.mMaxY = Vec4(mBounds.mMax.GetY(), empty.mMax.GetY(), empty.mMax.GetY(), empty.mMax.GetY());
+			root.mMaxZ = Vec4(mBounds.mMax.GetZ(), empty.mMax.GetZ(), empty.mMax.GetZ(), empty.mMax.GetZ());
+			root.mChild[0] = sCollapse(binary_nodes, 0, mNodes);
+			root.mChild[1] = root.mChild[2] = root.mChild[3] = cInvalidChild;
+			mNodes.push_back(root);
+		}
+		else
+			sCollapseNode(binary_nodes, 0, mNodes);
+		return true;
+	}
+
+	void BVH4::Refit(const AABox *inBounds)
+	{
+		if (mNodes.empty())
+			return;
+
+		// Children have a higher index than their parent, so walking backwards visits all children before their parent
+		for (size_t n = mNodes.size(); n-- > 0; )
+		{
+			Node &node = mNodes[n];
+			for (uint i = 0; i < 4; ++i)
+			{
+				const u32 child = node.mChild[i];
+				if (child == cInvalidChild)
+					continue;
+
+				AABox bounds;
+				if (child & cLeafFlag)
+				{
+					const u32 start = (child & ~cLeafFlag) >> cLeafCountBits;
+					for (u32 p = start, end = start + (child & cMaxLeafSize); p < end; ++p)
+						bounds.Encapsulate(inBounds[mPrimitiveIndices[p]]);
+				}
+				else
+					bounds = sGetNodeBounds(mNodes[child]);
+
+				node.mMinX[i] = bounds.mMin.GetX();
+				node.mMinY[i] = bounds.mMin.GetY();
+				node.mMinZ[i] = bounds.mMin.GetZ();
+				node.mMaxX[i] = bounds.mMax.GetX();
+				node.mMaxY[i] = bounds.mMax.GetY();
+				node.mMaxZ[i] = bounds.mMax.GetZ();
+			}
+		}
+
+		mBounds = sGetNodeBounds(mNodes[0]);
+	}
+} // namespace topia
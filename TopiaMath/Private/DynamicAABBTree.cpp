@@ -0,0 +1,384 @@
+#include "DynamicAABBTree.h"
+
+namespace topia
+{
+	namespace
+	{
+		/// Batches smaller than this are inserted in the order given
+		constexpr uint cMinLeavesToSort = 32;
+
+		/// Spread the lower 10 bits of inValue so that there are 2 zero bits between every bit
+		TOPIA_INLINE u32 sExpandBits(u32 inValue)
+		{
+			inValue = (inValue * 0x00010001u) & 0xFF0000FFu;
+			inValue = (inValue * 0x00000101u) & 0x0F00F00Fu;
+			inValue = (inValue * 0x00000011u) & 0xC30C30C3u;
+			inValue = (inValue * 0x00000005u) & 0x49249249u;
+			return inValue;
+		}
+
+		/// Get the 30 bit Morton code of a point in [0, 1023]^3
+		TOPIA_INLINE u32 sMortonCode(Vec3Arg inPoint)
+		{
+			const UVec4 quantized = Vec3::sMin(Vec3::sMax(inPoint, Vec3::sZero()), Vec3::sReplicate(1023.0f)).ToInt();
+			return (sExpandBits(quantized.GetX()) << 2) | (sExpandBits(quantized.GetY()) << 1) | sExpandBits(quantized.GetZ());
+		}
+	} // namespace
+
+	u32 DynamicAABBTree::AllocateNode()
+	{
+		if (mFreeList == cInvalidProxy)
+		{
+			mNodes.emplace_back();
+			return u32(mNodes.size() - 1);
+		}
+
+		const u32 index = mFreeList;
+		mFreeList = mNodes[index].mParent;
+		return index;
+	}
+
+	void DynamicAABBTree::FreeNode(u32 inNode)
+	{
+		Node &node = mNodes[inNode];
+		node.mParent = mFreeList;
+		node.mHeight = -1;
+		node.mMoved = false;
+		mFreeList = inNode;
+	}
+
+	void DynamicAABBTree::UpdateFromChildren(Node &ioNode) const
+	{
+		const Node &child1 = mNodes[ioNode.mChild[0]];
+		const Node &child2 = mNodes[ioNode.mChild[1]];
+		ioNode.mBounds = child1.mBounds;
+		ioNode.mBounds.Encapsulate(child2.mBounds);
+		ioNode.mHeight = 1 + std::max(child1.mHeight, child2.mHeight);
+	}
+
+	void DynamicAABBTree::InsertLeaf(u32 inLeaf)
+	{
+		if (mRoot == cInvalidProxy)
+		{
+			mRoot = inLeaf;
+			mNodes[inLeaf].mParent = cInvalidProxy;
+			return;
+		}
+
+		// Find the best sibling by descending into the child with the lowest cost
+		const AABox leaf_bounds = mNodes[inLeaf].mBounds;
+		u32 index = mRoot;
+		while (!mNodes[index].IsLeaf())
+		{
+			const Node &node = mNodes[index];
+			AABox combined = node.mBounds;
+			combined.Encapsulate(leaf_bounds);
+			const float combined_area = combined.GetSurfaceArea();
+
+			// Cost of creating a new parent for this node and the new leaf
+			const float cost = 2.0f * combined_area;
+
+			// Minimum cost of pushing the leaf further down the tree
+			const float inheritance_cost = 2.0f * (combined_area - node.mBounds.GetSurfaceArea());
+
+			float child_cost[2];
+			for (uint i = 0; i < 2; ++i)
+			{
+				const Node &child = mNodes[node.mChild[i]];
+				AABox child_combined = child.mBounds;
+				child_combined.Encapsulate(leaf_bounds);
+				child_cost[i] = child_combined.GetSurfaceArea() + inheritance_cost;
+				if (!child.IsLeaf())
+					child_cost[i] -= child.mBounds.GetSurfaceArea();
+			}
+
+			if (cost < child_cost[0] && cost < child_cost[1])
+				break;
+
+			index = node.mChild[child_cost[0] < child_cost[1]? 0 : 1];
+		}
+		const u32 sibling = index;
+
+		// Create a new parent for the sibling and the leaf
+		const u32 old_parent = mNodes[sibling].mParent;
+		const u32 new_parent = AllocateNode();
+		Node &parent = mNodes[new_parent];
+		parent.mParent = old_parent;
+		parent.mChild[0] = sibling;
+		parent.mChild[1] = inLeaf;
+		parent.mUserData = 0;
+		parent.mMoved = false;
+		UpdateFromChildren(parent);
+		if (old_parent != cInvalidProxy)
+		{
+			Node &grand_parent = mNodes[old_parent];
+			grand_parent.mChild[grand_parent.mChild[0] == sibling? 0 : 1] = new_parent;
+		}
+		else
+			mRoot = new_parent;
+		mNodes[sibling].mParent = new_parent;
+		mNodes[inLeaf].mParent = new_parent;
+
+		// Walk back up the tree fixing heights and bounds
+		for (index = mNodes[inLeaf].mParent; index != cInvalidProxy; index = mNodes[index].mParent)
+		{
+			index = Balance(index);
+			UpdateFromChildren(mNodes[index]);
+		}
+	}
+
+	void DynamicAABBTree::RemoveLeaf(u32 inLeaf)
+	{
+		if (inLeaf == mRoot)
+		{
+			mRoot = cInvalidProxy;
+			return;
+		}
+
+		// Replace the parent of the leaf by its sibling
+		const u32 parent = mNodes[inLeaf].mParent;
+		const u32 grand_parent = mNodes[parent].mParent;
+		const u32 sibling = mNodes[parent].mChild[mNodes[parent].mChild[0] == inLeaf? 1 : 0];
+		FreeNode(parent);
+		mNodes[sibling].mParent = grand_parent;
+		if (grand_parent == cInvalidProxy)
+		{
+			mRoot = sibling;
+			return;
+		}
+		Node &grand_parent_node = mNodes[grand_parent];
+		grand_parent_node.mChild[grand_parent_node.mChild[0] == parent? 0 : 1] = sibling;
+
+		// Walk back up the tree fixing heights and bounds
+		for (u32 index = grand_parent; index != cInvalidProxy; index = mNodes[index].mParent)
+		{
+			index = Balance(index);
+			UpdateFromChildren(mNodes[index]);
+		}
+	}
+
+	u32 DynamicAABBTree::Balance(u32 inNode)
+	{
+		Node &a = mNodes[inNode];
+		if (a.IsLeaf() || a.mHeight < 2)
+			return inNode;
+
+		// Find the tallest child, nothing to do when the children differ at most 1 in height
+		const int balance = mNodes[a.mChild[1]].mHeight - mNodes[a.mChild[0]].mHeight;
+		if (balance >= -1 && balance <= 1)
+			return inNode;
+		const uint tall = balance > 1? 1 : 0;
+
+		// Rotate the tall child up: it takes the place of a, a becomes its first child
+		const u32 up_index = a.mChild[tall];
+		Node &up = mNodes[up_index];
+		const u32 grand_child1 = up.mChild[0], grand_child2 = up.mChild[1];
+		up.mParent = a.mParent;
+		a.mParent = up_index;
+		if (up.mParent != cInvalidProxy)
+		{
+			Node &parent = mNodes[up.mParent];
+			parent.mChild[parent.mChild[0] == inNode? 0 : 1] = up_index;
+		}
+		else
+			mRoot = up_index;
+
+		// The tallest grand child stays with the rotated up node, the other one moves to a
+		const bool keep_first = mNodes[grand_child1].mHeight > mNodes[grand_child2].mHeight;
+		const u32 keep = keep_first? grand_child1 : grand_child2;
+		const u32 give = keep_first? grand_child2 : grand_child1;
+		up.mChild[0] = inNode;
+		up.mChild[1] = keep;
+		a.mChild[tall] = give;
+		mNodes[give].mParent = inNode;
+		UpdateFromChildren(a);
+		UpdateFromChildren(up);
+		return up_index;
+	}
+
+	void DynamicAABBTree::AddToMoveBuffer(u32 inLeaf)
+	{
+		Node &leaf = mNodes[inLeaf];
+		if (!leaf.mMoved)
+		{
+			leaf.mMoved = true;
+			mMoveBuffer.push_back(inLeaf);
+		}
+	}
+
+	bool DynamicAABBTree::NeedsReinsert(const Node &inLeaf, const AABox &inBounds) const
+	{
+		if (!inLeaf.mBounds.Contains(inBounds))
+			return true;
+
+		AABox huge = inBounds;
+		huge.ExpandBy(Vec3::sReplicate(4.0f * mMargin));
+		return !huge.Contains(inLeaf.mBounds);
+	}
+
+	void DynamicAABBTree::InsertLeaves(u32 *ioLeaves, uint inCount)
+	{
+		if (inCount >= cMinLeavesToSort)
+		{
+			// Sort the leaves along a Morton curve through the bounds of their centers
+			AABox center_bounds;
+			for (const u32 *leaf = ioLeaves, *end = ioLeaves + inCount; leaf < end; ++leaf)
+				center_bounds.Encapsulate(mNodes[*leaf].mBounds.GetCenter());
+			const Vec3 scale = Vec3::sReplicate(1023.0f) / Vec3::sMax(center_bounds.GetSize(), Vec3::sReplicate(1.0e-20f));
+
+			mSortKeys.resize(inCount);
+			for (uint i = 0; i < inCount; ++i)
+				mSortKeys[i] = (u64(sMortonCode((mNodes[ioLeaves[i]].mBounds.GetCenter() - center_bounds.mMin) * scale)) << 32) | ioLeaves[i];
+			std::sort(mSortKeys.begin(), mSortKeys.end());
+			for (uint i = 0; i < inCount; ++i)
+				ioLeaves[i] = u32(mSortKeys[i]);
+		}
+
+		for (const u32 *leaf = ioLeaves, *end = ioLeaves + inCount; leaf < end; ++leaf)
+			InsertLeaf(*leaf);
+	}
+
+	u32 DynamicAABBTree::CreateProxy(const AABox &inBounds, u32 inUserData)
+	{
+		u32 proxy;
+		CreateProxies(&inBounds, &inUserData, 1, &proxy);
+		return proxy;
+	}
+
+	void DynamicAABBTree::CreateProxies(const AABox *inBounds, const u32 *inUserData, uint inCount, u32 *outProxies)
+	{
+		for (uint i = 0; i < inCount; ++i)
+		{
+			const u32 proxy = AllocateNode();
+			Node &leaf = mNodes[proxy];
+			leaf.mBounds = CalculateFatBounds(inBounds[i]);
+			leaf.mChild[0] = leaf.mChild[1] = cInvalidProxy;
+			leaf.mUserData = inUserData[i];
+			leaf.mHeight = 0;
+			leaf.mMoved = false;
+			outProxies[i] = proxy;
+			AddToMoveBuffer(proxy);
+		}
+
+		mReinsertLeaves.assign(outProxies, outProxies + inCount);
+		InsertLeaves(mReinsertLeaves.data(), inCount);
+		mNumProxies += inCount;
+	}
+
+	void DynamicAABBTree::DestroyProxy(u32 inProxy)
+	{
+		DestroyProxies(&inProxy, 1);
+	}
+
+	void DynamicAABBTree::DestroyProxies(const u32 *inProxies, uint inCount)
+	{
+		bool any_moved = false;
+		for (const u32 *proxy = inProxies, *end = inProxies + inCount; proxy < end; ++proxy)
+		{
+			ASSERT(mNodes[*proxy].IsLeaf() && mNodes[*proxy].mHeight == 0);
+			any_moved |= mNodes[*proxy].mMoved;
+			RemoveLeaf(*proxy);
+			FreeNode(*proxy);
+		}
+		mNumProxies -= inCount;
+
+		// Destroyed proxies are marked unused by FreeNode, drop them from the move buffer
+		if (any_moved)
+			mMoveBuffer.erase(std::remove_if(mMoveBuffer.begin(), mMoveBuffer.end(), [this](u32 inProxy) { return mNodes[inProxy].mHeight < 0; }), mMoveBuffer.end());
+	}
+
+	bool DynamicAABBTree::MoveProxy(u32 inProxy, const AABox &inBounds)
+	{
+		return MoveProxies(&inProxy, &inBounds, 1) != 0;
+	}
+
+	uint DynamicAABBTree::MoveProxies(const u32 *inProxies, const AABox *inBounds, uint inCount)
+	{
+		// Remove all proxies that left their fat box, the tree is only rebalanced for the ones that are left
+		mReinsertLeaves.clear();
+		for (uint i = 0; i < inCount; ++i)
+		{
+			const u32 proxy = inProxies[i];
+			Node &leaf = mNodes[proxy];
+			ASSERT(leaf.IsLeaf() && leaf.mHeight == 0);
+			const bool removed = leaf.mParent == cInvalidProxy && proxy != mRoot;
+			if (!removed && !NeedsReinsert(leaf, inBounds[i]))
+				continue;
+
+			// A proxy that is listed more than once is only removed the first time, the last bounds are used
+			leaf.mBounds = CalculateFatBounds(inBounds[i]);
+			if (!removed)
+			{
+				RemoveLeaf(proxy);
+				leaf.mParent = cInvalidProxy;
+				mReinsertLeaves.push_back(proxy);
+			}
+		}
+
+		const uint num_reinserted = uint(mReinsertLeaves.size());
+		InsertLeaves(mReinsertLeaves.data(), num_reinserted);
+		for (u32 proxy : mReinsertLeaves)
+			AddToMoveBuffer(proxy);
+		return num_reinserted;
+	}
+
+	bool DynamicAABBTree::IsValid() const
+	{
+		if (mRoot == cInvalidProxy)
+			return mNumProxies == 0;
+		if (mNodes[mRoot].mParent != cInvalidProxy)
+			return false;
+
+		uint num_leaves = 0;
+		u32 stack[cStackSize];
+		stack[0] = mRoot;
+		uint top = 1;
+		while (top > 0)
+		{
+			const u32 index = stack[--top];
+			const Node &node = mNodes[index];
+			if (node.mHeight < 0)
+				return false;
+			if (node.IsLeaf())
+			{
+				if (node.mHeight != 0)
+					return false;
+				++num_leaves;
+				continue;
+			}
+
+			const Node &child1 = mNodes[node.mChild[0]];
+			const Node &child2 = mNodes[node.mChild[1]];
+			if (child1.mParent != index || child2.mParent != index || node.mMoved)
+				return false;
+
+			AABox bounds = child1.mBounds;
+			bounds.Encapsulate(child2.mBounds);
+			if (bounds.mMin != node.mBounds.mMin || bounds.mMax != node.mBounds.mMax
+				|| node.mHeight != 1 + std::max(child1.mHeight, child2.mHeight) || std::abs(child1.mHeight - child2.mHeight) > 1)
+				return false;
+
+			if (top + 2 > cStackSize)
+				return false;
+			stack[top++] = node.mChild[0];
+			stack[top++] = node.mChild[1];
+		}
+		return num_leaves == mNumProxies;
+	}
+
+	void DynamicAABBTree::FindNewPairs(std::vector<ProxyPair> &ioPairs)
+	{
+		for (u32 proxy : mMoveBuffer)
+			QueryAABox(mNodes[proxy].mBounds, [this, proxy, &ioPairs](u32 inOther)
+			{
+				// When both proxies moved, only report the pair from the one with the lowest index
+				if (inOther == proxy || (mNodes[inOther].mMoved && inOther < proxy))
+					return;
+				ioPairs.push_back({ std::min(proxy, inOther), std::max(proxy, inOther) });
+			});
+
+		for (u32 proxy : mMoveBuffer)
+			mNodes[proxy].mMoved = false;
+		mMoveBuffer.clear();
+	}
+} // namespace topia
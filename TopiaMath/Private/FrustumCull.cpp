@@ -0,0 +1,133 @@
+#include "FrustumCull.h"
+#include "Vec8.h"
+#include "UVec8.h"
+
+#include <cstring>
+
+namespace topia
+{
+	namespace
+	{
+		/// Planes replicated over 8 lanes
+		class Planes8
+		{
+		public:
+			explicit Planes8(const Frustum &inFrustum)
+			{
+				for (uint i = 0; i < Frustum::NumPlanes; ++i)
+				{
+					const Plane &plane = inFrustum.GetPlane(i);
+					const Vec3 normal = plane.GetNormal();
+					const Vec3 abs_normal = normal.Abs();
+					mNormalX[i] = Vec8::sReplicate(normal.GetX());
+					mNormalY[i] = Vec8::sReplicate(normal.GetY());
+					mNormalZ[i] = Vec8::sReplicate(normal.GetZ());
+					mAbsNormalX[i] = Vec8::sReplicate(abs_normal.GetX());
+					mAbsNormalY[i] = Vec8::sReplicate(abs_normal.GetY());
+					mAbsNormalZ[i] = Vec8::sReplicate(abs_normal.GetZ());
+					mConstant[i] = Vec8::sReplicate(plane.GetConstant());
+				}
+			}
+
+			/// Returns a bit mask with a bit set for every box that is visible
+			TOPIA_INLINE int GetVisible(Vec8Arg inCenterX, Vec8Arg inCenterY, Vec8Arg inCenterZ, Vec8Arg inExtentX, Vec8Arg inExtentY, Vec8Arg inExtentZ) const
+			{
+				UVec8 culled = UVec8::sReplicate(0);
+				for (uint i = 0; i < Frustum::NumPlanes; ++i)
+				{
+					// Distance of the center to the plane and the projected radius of the box on the plane normal
+					const Vec8 distance = Vec8::sFusedMultiplyAdd(inCenterZ, mNormalZ[i], Vec8::sFusedMultiplyAdd(inCenterY, mNormalY[i], Vec8::sFusedMultiplyAdd(inCenterX, mNormalX[i], mConstant[i])));
+					const Vec8 radius = Vec8::sFusedMultiplyAdd(inExtentZ, mAbsNormalZ[i], Vec8::sFusedMultiplyAdd(inExtentY, mAbsNormalY[i], inExtentX * mAbsNormalX[i]));
+					culled = UVec8::sOr(culled, Vec8::sLess(distance, -radius));
+				}
+				return ~culled.GetTrues() & 0xff;
+			}
+
+			Vec8 mNormalX[Frustum::NumPlanes];
+			Vec8 mNormalY[Frustum::NumPlanes];
+			Vec8 mNormalZ[Frustum::NumPlanes];
+			Vec8 mAbsNormalX[Frustum::NumPlanes];
+			Vec8 mAbsNormalY[Frustum::NumPlanes];
+			Vec8 mAbsNormalZ[Frustum::NumPlanes];
+			Vec8 mConstant[Frustum::NumPlanes];
+		};
+
+		/// Cull boxes [inBegin, inEnd) and write the visible indices to outVisible, returns the number of visible boxes
+		uint sCullRange(const Planes8 &inPlanes, const AABoxSoA &inBounds, uint inBegin, uint inEnd, u32 *outVisible)
+		{
+			uint num_visible = 0;
+			uint i = inBegin;
+			for (; i + 8 <= inEnd; i += 8)
+			{
+				const int visible = inPlanes.GetVisible(
+					Vec8::sLoadFloat8(inBounds.mCenterX + i), Vec8::sLoadFloat8(inBounds.mCenterY + i), Vec8::sLoadFloat8(inBounds.mCenterZ + i),
+					Vec8::sLoadFloat8(inBounds.mExtentX + i), Vec8::sLoadFloat8(inBounds.mExtentY + i), Vec8::sLoadFloat8(inBounds.mExtentZ + i));
+
+				// Compact without branching on the mask: always store, only advance when visible.
+				// The extra store lands at most at index i + 7 - inBegin, which is still within this range.
+				for (uint lane = 0; lane < 8; ++lane)
+				{
+					outVisible[num_visible] = i + lane;
+					num_visible += (visible >> lane) & 1;
+				}
+			}
+
+			// Copy the remaining boxes into a padded batch
+			if (i < inEnd)
+			{
+				const uint count = inEnd - i;
+				alignas(32) float batch[6][8] = {};
+				for (uint lane = 0; lane < count; ++lane)
+				{
+					batch[0][lane] = inBounds.mCenterX[i + lane];
+					batch[1][lane] = inBounds.mCenterY[i + lane];
+					batch[2][lane] = inBounds.mCenterZ[i + lane];
+					batch[3][lane] = inBounds.mExtentX[i + lane];
+					batch[4][lane] = inBounds.mExtentY[i + lane];
+					batch[5][lane] = inBounds.mExtentZ[i + lane];
+				}
+				const int visible = inPlanes.GetVisible(
+					Vec8::sLoadFloat8Aligned(batch[0]), Vec8::sLoadFloat8Aligned(batch[1]), Vec8::sLoadFloat8Aligned(batch[2]),
+					Vec8::sLoadFloat8Aligned(batch[3]), Vec8::sLoadFloat8Aligned(batch[4]), Vec8::sLoadFloat8Aligned(batch[5]));
+				for (uint lane = 0; lane < count; ++lane)
+					if ((visible >> lane) & 1)
+						outVisible[num_visible++] = i + lane;
+			}
+
+			return num_visible;
+		}
+	} // namespace
+
+	uint FrustumCull(const Frustum &inFrustum, const AABoxSoA &inBounds, u32 *outVisible, FThreadPool *inPool)
+	{
+		const Planes8 planes(inFrustum);
+
+		// Not worth handing small batches to other threads
+		constexpr uint cMinBoxesPerRange = 4096;
+		constexpr uint cMaxRanges = 64;
+		const uint num_pool_threads = inPool != nullptr ? inPool->GetNumThreads() + 1 : 1;
+		const uint num_ranges = std::max(1u, std::min(std::min(num_pool_threads, cMaxRanges), inBounds.mCount / cMinBoxesPerRange));
+		if (num_ranges == 1)
+			return sCullRange(planes, inBounds, 0, inBounds.mCount, outVisible);
+
+		// Each range writes its visible indices at the start of its own part of outVisible, ranges are a multiple of 8 boxes
+		const uint boxes_per_range = ((inBounds.mCount + num_ranges - 1) / num_ranges + 7) & ~7u;
+		uint num_visible[cMaxRanges];
+		inPool->ParallelFor(num_ranges, [&planes, &inBounds, &num_visible, outVisible, boxes_per_range](u32 inRange)
+		{
+			const uint begin = std::min(inRange * boxes_per_range, inBounds.mCount);
+			const uint end = std::min(begin + boxes_per_range, inBounds.mCount);
+			num_visible[inRange] = sCullRange(planes, inBounds, begin, end, outVisible + begin);
+		});
+
+		// Move the results of the ranges next to each other
+		uint total = num_visible[0];
+		for (uint r = 1; r < num_ranges; ++r)
+		{
+			const uint begin = std::min(r * boxes_per_range, inBounds.mCount);
+			memmove(outVisible + total, outVisible + begin, num_visible[r] * sizeof(u32));
+			total += num_visible[r];
+		}
+		return total;
+	}
+} // namespace topia
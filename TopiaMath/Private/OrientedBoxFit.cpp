@@ -0,0 +1,92 @@
+#include "OrientedBoxFit.h"
+#include "EigenValueSymmetric3x3.h"
+
+namespace topia
+{
+	void FitOrientedBoxes(const Vec3 *inPoints, const u32 *inOffsets, uint inNumSets, Mat44 *outOrientations, Vec3 *outHalfExtents)
+	{
+		for (uint batch_start = 0; batch_start < inNumSets; batch_start += 8)
+		{
+			const uint batch_size = std::min(inNumSets - batch_start, 8u);
+
+			// Gather the covariance matrices, unused lanes stay zero which decomposes into the identity
+			SymMat33x8 covariance;
+			covariance.mXX = covariance.mYY = covariance.mZZ = Vec8::sZero();
+			covariance.mXY = covariance.mXZ = covariance.mYZ = Vec8::sZero();
+			for (uint lane = 0; lane < batch_size; ++lane)
+			{
+				const uint set = batch_start + lane;
+				const u32 begin = inOffsets[set], end = inOffsets[set + 1];
+				if (begin == end)
+					continue;
+
+				Vec3 mean = Vec3::sZero();
+				for (u32 i = begin; i < end; ++i)
+					mean += inPoints[i];
+				mean /= float(end - begin);
+
+				// Accumulate (xx, yy, zz) and (xy, yz, zx)
+				Vec3 diagonal = Vec3::sZero(), off_diagonal = Vec3::sZero();
+				for (u32 i = begin; i < end; ++i)
+				{
+					const Vec3 d = inPoints[i] - mean;
+					diagonal += d * d;
+					off_diagonal += d * d.Swizzle<SWIZZLE_Y, SWIZZLE_Z, SWIZZLE_X>();
+				}
+
+				covariance.mXX[lane] = diagonal.GetX();
+				covariance.mYY[lane] = diagonal.GetY();
+				covariance.mZZ[lane] = diagonal.GetZ();
+				covariance.mXY[lane] = off_diagonal.GetX();
+				covariance.mYZ[lane] = off_diagonal.GetY();
+				covariance.mXZ[lane] = off_diagonal.GetZ();
+			}
+
+			Vec8 eig_vec[3][3], eig_val[3];
+			EigenValueSymmetric3x3x8(covariance, eig_vec, eig_val);
+
+			// Project the points on the eigen vectors to find the extent of each box
+			for (uint lane = 0; lane < batch_size; ++lane)
+			{
+				const uint set = batch_start + lane;
+				const u32 begin = inOffsets[set], end = inOffsets[set + 1];
+
+				Mat44 rotation = Mat44::sIdentity();
+				for (uint c = 0; c < 3; ++c)
+					rotation.SetColumn3(c, Vec3(eig_vec[c][0][lane], eig_vec[c][1][lane], eig_vec[c][2][lane]));
+
+				if (begin == end)
+				{
+					outOrientations[set] = rotation;
+					outHalfExtents[set] = Vec3::sZero();
+					continue;
+				}
+
+				Vec3 local_min = Vec3::sReplicate(finfinity), local_max = Vec3::sReplicate(-finfinity);
+				for (u32 i = begin; i < end; ++i)
+				{
+					const Vec3 local = rotation.Multiply3x3Transposed(inPoints[i]);
+					local_min = Vec3::sMin(local_min, local);
+					local_max = Vec3::sMax(local_max, local);
+				}
+
+				rotation.SetTranslation(rotation.Multiply3x3(0.5f * (local_min + local_max)));
+				outOrientations[set] = rotation;
+				outHalfExtents[set] = 0.5f * (local_max - local_min);
+			}
+		}
+	}
+
+	void FitOrientedBoxes(const Vec3 *inPoints, const u32 *inOffsets, uint inNumSets, OrientedBox *outBoxes)
+	{
+		for (uint batch_start = 0; batch_start < inNumSets; batch_start += 8)
+		{
+			const uint batch_size = std::min(inNumSets - batch_start, 8u);
+			Mat44 orientations[8];
+			Vec3 half_extents[8];
+			FitOrientedBoxes(inPoints, inOffsets + batch_start, batch_size, orientations, half_extents);
+			for (uint i = 0; i < batch_size; ++i)
+				outBoxes[batch_start + i] = OrientedBox(orientations[i], half_extents[i]);
+		}
+	}
+} // namespace topia
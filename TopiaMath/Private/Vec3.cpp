@@ -1,55 +1,68 @@
 #include "TopiaMath.h"
 
 #include "Vec3.h"
-#include <unordered_set>
 
 namespace topia {
 
-static void sCreateVertices(std::unordered_set<Vec3> &ioVertices, Vec3Arg inDir1, Vec3Arg inDir2, Vec3Arg inDir3, int inLevel)
+void Vec3::sCreateUnitSphere(int inLevel, std::vector<Vec3> &outVertices)
 {
-	Vec3 center1 = (inDir1 + inDir2).Normalized();
-	Vec3 center2 = (inDir2 + inDir3).Normalized();
-	Vec3 center3 = (inDir3 + inDir1).Normalized();
+	ASSERT(inLevel >= 0 && inLevel <= cMaxUnitSphereLevel);
 
-	ioVertices.insert(center1);
-	ioVertices.insert(center2);
-	ioVertices.insert(center3);
+	// Every face of the octahedron becomes a triangular grid with n segments per edge. Point (i, j) lies i steps towards the
+	// second corner and j steps towards the third, it is stored at i + j * (n + 1).
+	const int n = 2 << inLevel;
+	const int stride = n + 1;
+	std::vector<Vec3> grid(size_t(stride) * stride);
 
-	if (inLevel > 0)
+	outVertices.clear();
+	outVertices.reserve(size_t(sGetUnitSphereVertexCount(inLevel)));
+
+	for (int octant = 0; octant < 8; ++octant)
 	{
-		int new_level = inLevel - 1;
-		sCreateVertices(ioVertices, inDir1, center1, center3, new_level);
-		sCreateVertices(ioVertices, center1, center2, center3, new_level);
-		sCreateVertices(ioVertices, center1, inDir2, center2, new_level);
-		sCreateVertices(ioVertices, center3, center2, inDir3, new_level);
+		const float sign_x = (octant & 1)? -1.0f : 1.0f;
+		const float sign_y = (octant & 2)? -1.0f : 1.0f;
+		const float sign_z = (octant & 4)? -1.0f : 1.0f;
+
+		grid[0] = Vec3(sign_x, 0, 0);
+		grid[n] = Vec3(0, sign_y, 0);
+		grid[n * stride] = Vec3(0, 0, sign_z);
+
+		// Split every triangle into 4 by the normalized midpoints of its edges. A midpoint only depends on the two ends of its edge
+		// (a + b == b + a), so points on an edge shared by two octants come out bit identical.
+		for (int step = n / 2; step > 0; step /= 2)
+		{
+			const int size = 2 * step;
+			for (int j = 0; j < n; j += size)
+				for (int i = 0; i + j < n; i += size)
+				{
+					const Vec3 &p0 = grid[i + j * stride];
+					const Vec3 &p1 = grid[i + size + j * stride];
+					const Vec3 &p2 = grid[i + (j + size) * stride];
+					grid[i + step + j * stride] = (p0 + p1).Normalized();
+					grid[i + (j + step) * stride] = (p0 + p2).Normalized();
+					grid[i + step + (j + step) * stride] = (p1 + p2).Normalized();
+				}
+		}
+
+		// Points where a coordinate is 0 are shared with neighbouring octants, they belong to the octant on the positive side
+		for (int j = 0; j <= n; ++j)
+			for (int i = 0; i + j <= n; ++i)
+				if ((i + j < n || sign_x > 0.0f) && (i > 0 || sign_y > 0.0f) && (j > 0 || sign_z > 0.0f))
+					outVertices.push_back(grid[i + j * stride]);
 	}
+
+	ASSERT(outVertices.size() == sGetUnitSphereVertexCount(inLevel));
 }
 
-const std::vector<Vec3> Vec3::sUnitSphere = []() { 
-
-	const int level = 3;
-
-	std::unordered_set<Vec3> verts;
-	
-	// Add unit axis
-	verts.insert(Vec3::sAxisX());
-	verts.insert(-Vec3::sAxisX());
-	verts.insert(Vec3::sAxisY());
-	verts.insert(-Vec3::sAxisY());
-	verts.insert(Vec3::sAxisZ());
-	verts.insert(-Vec3::sAxisZ());
-
-	// Subdivide
-	sCreateVertices(verts, Vec3::sAxisX(), Vec3::sAxisY(), Vec3::sAxisZ(), level);
-	sCreateVertices(verts, -Vec3::sAxisX(), Vec3::sAxisY(), Vec3::sAxisZ(), level);
-	sCreateVertices(verts, Vec3::sAxisX(), -Vec3::sAxisY(), Vec3::sAxisZ(), level);
-	sCreateVertices(verts, -Vec3::sAxisX(), -Vec3::sAxisY(), Vec3::sAxisZ(), level);
-	sCreateVertices(verts, Vec3::sAxisX(), Vec3::sAxisY(), -Vec3::sAxisZ(), level);
-	sCreateVertices(verts, -Vec3::sAxisX(), Vec3::sAxisY(), -Vec3::sAxisZ(), level);
-	sCreateVertices(verts, Vec3::sAxisX(), -Vec3::sAxisY(), -Vec3::sAxisZ(), level);
-	sCreateVertices(verts, -Vec3::sAxisX(), -Vec3::sAxisY(), -Vec3::sAxisZ(), level);
-
-	return std::vector<Vec3>(verts.begin(), verts.end());
-}();
-
-}
\ No newline at end of file
+const std::vector<Vec3> &Vec3::sUnitSphere()
+{
+	// Built on first use rather than during static initialization
+	static const std::vector<Vec3> sVertices = []() {
+		std::vector<Vec3> vertices;
+		sCreateUnitSphere(3, vertices);
+		return vertices;
+	}();
+	return sVertices;
+}
+
+}
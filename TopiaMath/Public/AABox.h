@@ -0,0 +1,137 @@
+#pragma once
+
+#include "TopiaMath.h"
+
+namespace topia
+{
+	/// Axis aligned box
+	class TOPIA_NODISCARD AABox
+	{
+	public:
+		/// Constructor, creates an invalid (empty) box so that Encapsulate can be used to grow it
+		AABox() : mMin(Vec3::sReplicate(std::numeric_limits<float>::max())), mMax(Vec3::sReplicate(-std::numeric_limits<float>::max())) {}
+		AABox(Vec3Arg inMin, Vec3Arg inMax) : mMin(inMin), mMax(inMax) {}
+		AABox(Vec3Arg inCenter, float inRadius) : mMin(inCenter - Vec3::sReplicate(inRadius)), mMax(inCenter + Vec3::sReplicate(inRadius)) {}
+
+		/// Create box from 2 points
+		static AABox sFromTwoPoints(Vec3Arg inP1, Vec3Arg inP2) { return AABox(Vec3::sMin(inP1, inP2), Vec3::sMax(inP1, inP2)); }
+
+		/// Get the largest possible bounding box
+		static AABox sBiggest() { return AABox(Vec3::sReplicate(-0.5f * std::numeric_limits<float>::max()), Vec3::sReplicate(0.5f * std::numeric_limits<float>::max())); }
+
+		/// Comparison operators
+		bool operator==(const AABox &inRHS) const { return mMin == inRHS.mMin && mMax == inRHS.mMax; }
+		bool operator!=(const AABox &inRHS) const { return mMin != inRHS.mMin || mMax != inRHS.mMax; }
+
+		/// Reset the bounding box to an empty bounding box
+		void SetEmpty()
+		{
+			mMin = Vec3::sReplicate(std::numeric_limits<float>::max());
+			mMax = Vec3::sReplicate(-std::numeric_limits<float>::max());
+		}
+
+		/// Check if the bounding box is valid (max >= min)
+		bool IsValid() const { return mMin.GetX() <= mMax.GetX() && mMin.GetY() <= mMax.GetY() && mMin.GetZ() <= mMax.GetZ(); }
+
+		/// Encapsulate point in bounding box
+		void Encapsulate(Vec3Arg inPos)
+		{
+			mMin = Vec3::sMin(mMin, inPos);
+			mMax = Vec3::sMax(mMax, inPos);
+		}
+
+		/// Encapsulate bounding box in bounding box
+		void Encapsulate(const AABox &inRHS)
+		{
+			mMin = Vec3::sMin(mMin, inRHS.mMin);
+			mMax = Vec3::sMax(mMax, inRHS.mMax);
+		}
+
+		/// Intersect this bounding box with inOther, returns the intersection (which is invalid when the boxes don't overlap)
+		AABox Intersect(const AABox &inOther) const { return AABox(Vec3::sMax(mMin, inOther.mMin), Vec3::sMin(mMax, inOther.mMax)); }
+
+		/// Make sure that each edge of the bounding box has a minimal length
+		void EnsureMinimalEdgeLength(float inMinEdgeLength)
+		{
+			const Vec3 min_length = Vec3::sReplicate(inMinEdgeLength);
+			mMax = Vec3::sSelect(mMax, mMin + min_length, Vec3::sLess(mMax - mMin, min_length));
+		}
+
+		/// Widen the box on both sides by inVector
+		void ExpandBy(Vec3Arg inVector)
+		{
+			mMin -= inVector;
+			mMax += inVector;
+		}
+
+		/// Get center of bounding box
+		Vec3 GetCenter() const { return 0.5f * (mMin + mMax); }
+
+		/// Get extent of bounding box (half of the size)
+		Vec3 GetExtent() const { return 0.5f * (mMax - mMin); }
+
+		/// Get size of bounding box
+		Vec3 GetSize() const { return mMax - mMin; }
+
+		/// Get surface area of bounding box
+		float GetSurfaceArea() const
+		{
+			const Vec3 extent = mMax - mMin;
+			return 2.0f * (extent.GetX() * extent.GetY() + extent.GetX() * extent.GetZ() + extent.GetY() * extent.GetZ());
+		}
+
+		/// Get volume of bounding box
+		float GetVolume() const
+		{
+			const Vec3 extent = mMax - mMin;
+			return extent.GetX() * extent.GetY() * extent.GetZ();
+		}
+
+		/// Check if this box contains another box
+		bool Contains(const AABox &inOther) const { return UVec4::sAnd(Vec3::sLessOrEqual(mMin, inOther.mMin), Vec3::sGreaterOrEqual(mMax, inOther.mMax)).TestAllXYZTrue(); }
+
+		/// Check if this box contains a point
+		bool Contains(Vec3Arg inOther) const { return UVec4::sAnd(Vec3::sLessOrEqual(mMin, inOther), Vec3::sGreaterOrEqual(mMax, inOther)).TestAllXYZTrue(); }
+
+		/// Check if this box overlaps with another box
+		bool Overlaps(const AABox &inOther) const { return !UVec4::sOr(Vec3::sGreater(mMin, inOther.mMax), Vec3::sLess(mMax, inOther.mMin)).TestAnyXYZTrue(); }
+
+		/// Translate bounding box
+		void Translate(Vec3Arg inTranslation)
+		{
+			mMin += inTranslation;
+			mMax += inTranslation;
+		}
+
+		/// Transform bounding box, the result encloses the transformed box (Arvo's method: per axis the min / max of each matrix element times the box extremes)
+		AABox Transformed(Mat44Arg inMatrix) const
+		{
+			Vec3 new_min = inMatrix.GetTranslation(), new_max = new_min;
+			for (uint c = 0; c < 3; ++c)
+			{
+				const Vec3 axis = inMatrix.GetColumn3(c);
+				const Vec3 a = axis * mMin[c];
+				const Vec3 b = axis * mMax[c];
+				new_min += Vec3::sMin(a, b);
+				new_max += Vec3::sMax(a, b);
+			}
+			return AABox(new_min, new_max);
+		}
+
+		/// Scale this bounding box, can handle non-uniform and negative scaling
+		AABox Scaled(Vec3Arg inScale) const { return AABox::sFromTwoPoints(mMin * inScale, mMax * inScale); }
+
+		/// Get the closest point on or in this box to inPoint
+		Vec3 GetClosestPoint(Vec3Arg inPoint) const { return Vec3::sMin(Vec3::sMax(inPoint, mMin), mMax); }
+
+		/// Get the squared distance between inPoint and this box (will be 0 if inPoint is inside the box)
+		float GetSqDistanceTo(Vec3Arg inPoint) const { return (GetClosestPoint(inPoint) - inPoint).LengthSq(); }
+
+		/// Get the vertex of the box that is furthest along inDirection
+		Vec3 GetSupport(Vec3Arg inDirection) const { return Vec3::sSelect(mMax, mMin, Vec3::sLess(inDirection, Vec3::sZero())); }
+
+		/// Bounding box min and max
+		Vec3 mMin;
+		Vec3 mMax;
+	};
+} // namespace topia
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AABox.h"
+
+namespace topia
+{
+	// Kernels that test 4 boxes, or 4 planes, at the same time. The 4 boxes are passed as structure of arrays,
+	// lane i of inBoxMinX .. inBoxMaxZ is box i. Results are UVec4 masks (lane = 0xffffffff when true) that can be fed to
+	// UVec4::CountTrues / GetTrues / sSort4True to compact the hits.
+
+	/// Test 4 boxes against a single box, returns the lanes that overlap
+	TOPIA_INLINE UVec4 AABox4VsBox(const AABox &inBox1, Vec4Arg inBox2MinX, Vec4Arg inBox2MinY, Vec4Arg inBox2MinZ, Vec4Arg inBox2MaxX, Vec4Arg inBox2MaxY, Vec4Arg inBox2MaxZ)
+	{
+		// Splat the single box
+		const Vec4 box1_minx = inBox1.mMin.SplatX();
+		const Vec4 box1_miny = inBox1.mMin.SplatY();
+		const Vec4 box1_minz = inBox1.mMin.SplatZ();
+		const Vec4 box1_maxx = inBox1.mMax.SplatX();
+		const Vec4 box1_maxy = inBox1.mMax.SplatY();
+		const Vec4 box1_maxz = inBox1.mMax.SplatZ();
+
+		// The boxes are separated when they are separated along any axis
+		const UVec4 nooverlapx = UVec4::sOr(Vec4::sGreater(box1_minx, inBox2MaxX), Vec4::sGreater(inBox2MinX, box1_maxx));
+		const UVec4 nooverlapy = UVec4::sOr(Vec4::sGreater(box1_miny, inBox2MaxY), Vec4::sGreater(inBox2MinY, box1_maxy));
+		const UVec4 nooverlapz = UVec4::sOr(Vec4::sGreater(box1_minz, inBox2MaxZ), Vec4::sGreater(inBox2MinZ, box1_maxz));
+		return UVec4::sNot(UVec4::sOr(UVec4::sOr(nooverlapx, nooverlapy), nooverlapz));
+	}
+
+	/// Get the squared distance between a point and 4 boxes (0 when the point is inside a box)
+	TOPIA_INLINE Vec4 AABox4DistanceSqToPoint(Vec3Arg inPoint, Vec4Arg inBoxMinX, Vec4Arg inBoxMinY, Vec4Arg inBoxMinZ, Vec4Arg inBoxMaxX, Vec4Arg inBoxMaxY, Vec4Arg inBoxMaxZ)
+	{
+		// Closest point on each box
+		const Vec4 px = inPoint.SplatX(), py = inPoint.SplatY(), pz = inPoint.SplatZ();
+		const Vec4 dx = Vec4::sMin(Vec4::sMax(px, inBoxMinX), inBoxMaxX) - px;
+		const Vec4 dy = Vec4::sMin(Vec4::sMax(py, inBoxMinY), inBoxMaxY) - py;
+		const Vec4 dz = Vec4::sMin(Vec4::sMax(pz, inBoxMinZ), inBoxMaxZ) - pz;
+		return Vec4::sFusedMultiplyAdd(dz, dz, Vec4::sFusedMultiplyAdd(dy, dy, dx * dx));
+	}
+
+	/// Test 4 boxes against a sphere, returns the lanes that overlap
+	TOPIA_INLINE UVec4 AABox4VsSphere(Vec3Arg inCenter, float inRadiusSq, Vec4Arg inBoxMinX, Vec4Arg inBoxMinY, Vec4Arg inBoxMinZ, Vec4Arg inBoxMaxX, Vec4Arg inBoxMaxY, Vec4Arg inBoxMaxZ)
+	{
+		const Vec4 distance_sq = AABox4DistanceSqToPoint(inCenter, inBoxMinX, inBoxMinY, inBoxMinZ, inBoxMaxX, inBoxMaxY, inBoxMaxZ);
+		return Vec4::sLessOrEqual(distance_sq, Vec4::sReplicate(inRadiusSq));
+	}
+
+	/// Test a single box against 4 planes (x . normal + constant = 0, one plane per lane), returns the lanes for which the
+	/// box is entirely on the negative side of the plane. For a frustum with inward pointing normals any true lane means the box is culled.
+	TOPIA_INLINE UVec4 AABoxBehindPlanes4(const AABox &inBox, Vec4Arg inNormalX, Vec4Arg inNormalY, Vec4Arg inNormalZ, Vec4Arg inConstant)
+	{
+		// For every plane take the box vertex that is furthest along the normal (the 'positive vertex')
+		const Vec4 zero = Vec4::sZero();
+		const Vec4 px = Vec4::sSelect(inBox.mMax.SplatX(), inBox.mMin.SplatX(), Vec4::sLess(inNormalX, zero));
+		const Vec4 py = Vec4::sSelect(inBox.mMax.SplatY(), inBox.mMin.SplatY(), Vec4::sLess(inNormalY, zero));
+		const Vec4 pz = Vec4::sSelect(inBox.mMax.SplatZ(), inBox.mMin.SplatZ(), Vec4::sLess(inNormalZ, zero));
+
+		// If even that vertex is behind the plane, the whole box is
+		const Vec4 distance = Vec4::sFusedMultiplyAdd(pz, inNormalZ, Vec4::sFusedMultiplyAdd(py, inNormalY, Vec4::sFusedMultiplyAdd(px, inNormalX, inConstant)));
+		return Vec4::sLess(distance, zero);
+	}
+
+	/// Transform 4 boxes by a matrix, the resulting boxes enclose the transformed boxes
+	TOPIA_INLINE void AABox4Transform(Mat44Arg inMatrix, Vec4 &ioBoxMinX, Vec4 &ioBoxMinY, Vec4 &ioBoxMinZ, Vec4 &ioBoxMaxX, Vec4 &ioBoxMaxY, Vec4 &ioBoxMaxZ)
+	{
+		const Vec3 translation = inMatrix.GetTranslation();
+		Vec4 new_min[3] = { translation.SplatX(), translation.SplatY(), translation.SplatZ() };
+		Vec4 new_max[3] = { new_min[0], new_min[1], new_min[2] };
+		const Vec4 box_min[3] = { ioBoxMinX, ioBoxMinY, ioBoxMinZ };
+		const Vec4 box_max[3] = { ioBoxMaxX, ioBoxMaxY, ioBoxMaxZ };
+
+		// Same as AABox::Transformed, per row take the min / max of the matrix element times the box extremes
+		for (uint c = 0; c < 3; ++c)
+			for (uint r = 0; r < 3; ++r)
+			{
+				const Vec4 m = Vec4::sReplicate(inMatrix(r, c));
+				const Vec4 a = m * box_min[c];
+				const Vec4 b = m * box_max[c];
+				new_min[r] += Vec4::sMin(a, b);
+				new_max[r] += Vec4::sMax(a, b);
+			}
+
+		ioBoxMinX = new_min[0];
+		ioBoxMinY = new_min[1];
+		ioBoxMinZ = new_min[2];
+		ioBoxMaxX = new_max[0];
+		ioBoxMaxY = new_max[1];
+		ioBoxMaxZ = new_max[2];
+	}
+} // namespace topia
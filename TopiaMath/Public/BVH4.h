@@ -0,0 +1,180 @@
+#pragma once
+
+#include "AABox.h"
+#include "AABox4.h"
+#include "RayAABox.h"
+#include "Frustum.h"
+
+#include <ThreadPool.h>
+
+namespace topia
+{
+	/// Settings for BVH4::Build
+	class BVH4BuildSettings
+	{
+	public:
+		uint mMaxLeafSize = 4; ///< Ranges with this many primitives or less become a leaf, at most BVH4::cMaxLeafSize
+		uint mNumBins = 16; ///< Number of bins per axis for the SAH split search
+		FThreadPool *mThreadPool = nullptr; ///< When given, the subtrees of large ranges near the top of the tree are built on the pool
+	};
+
+	/// Bounding volume hierarchy over a set of primitives that are given by their bounding boxes.
+	///
+	/// Every node has 4 children stored as structure of arrays, so a node is tested with a single call to the 4-wide kernels
+	/// (RayAABox4, AABox4VsBox, Frustum::OverlapsAABox4). The tree is built as a binary tree with a binned surface area heuristic
+	/// and then collapsed to 4-wide nodes. Nodes are stored depth first, a child always has a higher index than its parent,
+	/// which Refit uses to update the bounds in a single backwards pass after primitives moved.
+	///
+	/// Queries report primitive indices (the index into the array of boxes passed to Build) to a visitor.
+	class BVH4
+	{
+	public:
+		/// Child reference for an unused child slot
+		static constexpr u32 cInvalidChild = 0xffffffff;
+
+		/// A child reference with this bit set is a leaf: cLeafFlag | (first primitive << cLeafCountBits) | number of primitives
+		static constexpr u32 cLeafFlag = 0x80000000;
+		static constexpr uint cLeafCountBits = 4;
+		static constexpr uint cMaxLeafSize = (1 << cLeafCountBits) - 1;
+
+		/// Maximum depth of the traversal stack
+		static constexpr uint cStackSize = 256;
+
+		/// A node with 4 children, lane i of the bounds belongs to mChild[i]. Unused slots have an inverted box that never overlaps anything.
+		class Node
+		{
+		public:
+			Vec4 mMinX;
+			Vec4 mMinY;
+			Vec4 mMinZ;
+			Vec4 mMaxX;
+			Vec4 mMaxY;
+			Vec4 mMaxZ;
+			u32 mChild[4]; ///< Index of the child node, a leaf (see cLeafFlag) or cInvalidChild
+		};
+
+		/// Maximum number of primitives, the first primitive of a leaf has to fit in the bits of a child reference below cLeafFlag
+		static constexpr uint cMaxPrimitives = 1u << (31 - cLeafCountBits);
+
+		/// Build the tree, the hierarchy references primitives by their index in inBounds.
+		/// @return false (and an empty tree) when there are more than cMaxPrimitives primitives
+		bool Build(const AABox *inBounds, uint inNumPrimitives, const BVH4BuildSettings &inSettings = BVH4BuildSettings());
+
+		/// Update the bounds of all nodes after the primitives moved, inBounds must contain the same number of primitives as passed to Build.
+		/// The structure of the tree stays the same, so when primitives move a lot the tree should be rebuilt at some point.
+		void Refit(const AABox *inBounds);
+
+		/// Get the bounds of all primitives
+		const AABox &GetBounds() const { return mBounds; }
+
+		/// Access to the tree
+		const std::vector<Node> &GetNodes() const { return mNodes; }
+		const std::vector<u32> &GetPrimitiveIndices() const { return mPrimitiveIndices; }
+
+		/// Cast a ray from inOrigin along inDirection, up to inOrigin + inMaxFraction * inDirection.
+		/// ioVisitor is called as float(u32 inPrimitive, float inClosest) for every primitive whose box is hit before the closest hit so far,
+		/// it should return the fraction of its hit when it is closer than inClosest, otherwise inClosest. Nodes are visited front to back.
+		/// For an any hit query the visitor can return -FLT_MAX to stop the traversal, it is not called again after that.
+		/// @return The fraction of the closest hit, or inMaxFraction when nothing was hit.
+		template <class Visitor>
+		float CastRay(Vec3Arg inOrigin, Vec3Arg inDirection, float inMaxFraction, Visitor &&ioVisitor) const
+		{
+			float closest = inMaxFraction;
+			if (mNodes.empty())
+				return closest;
+
+			const RayInvDirection inv_direction(inDirection);
+			u32 node_stack[cStackSize];
+			float fraction_stack[cStackSize];
+			node_stack[0] = 0;
+			fraction_stack[0] = -std::numeric_limits<float>::max();
+			uint top = 1;
+			while (top > 0)
+			{
+				--top;
+				if (fraction_stack[top] >= closest)
+					continue; // Something closer was found after this node was pushed
+
+				const u32 child = node_stack[top];
+				if (child & cLeafFlag)
+				{
+					const u32 *primitive = &mPrimitiveIndices[(child & ~cLeafFlag) >> cLeafCountBits];
+					for (const u32 *end = primitive + (child & cMaxLeafSize); primitive < end && closest > -std::numeric_limits<float>::max(); ++primitive)
+						closest = ioVisitor(*primitive, closest);
+				}
+				else
+				{
+					// Push the children that were hit, furthest first so the nearest one is visited next
+					const Node &node = mNodes[child];
+					Vec4 fraction = RayAABox4(inOrigin, inv_direction, node.mMinX, node.mMinY, node.mMinZ, node.mMaxX, node.mMaxY, node.mMaxZ);
+					UVec4 children = UVec4::sLoadInt4(node.mChild);
+					Vec4::sSort4Reverse(fraction, children);
+					for (uint i = 0; i < 4; ++i)
+						if (fraction[i] < closest && children[i] != cInvalidChild)
+						{
+							ASSERT(top < cStackSize);
+							node_stack[top] = children[i];
+							fraction_stack[top] = fraction[i];
+							++top;
+						}
+				}
+			}
+			return closest;
+		}
+
+		/// Find the primitives whose box overlaps inBox, ioVisitor is called as void(u32 inPrimitive) once for every primitive in a leaf
+		/// whose bounds overlap. That includes every overlapping primitive, the visitor tests the primitive itself when it needs an exact answer.
+		template <class Visitor>
+		void CollideAABox(const AABox &inBox, Visitor &&ioVisitor) const
+		{
+			WalkTree([&inBox](const Node &inNode) { return AABox4VsBox(inBox, inNode.mMinX, inNode.mMinY, inNode.mMinZ, inNode.mMaxX, inNode.mMaxY, inNode.mMaxZ); }, ioVisitor);
+		}
+
+		/// Find the primitives whose box is (partially) inside the frustum, ioVisitor is called as void(u32 inPrimitive) once for every
+		/// primitive in a leaf whose bounds are (partially) inside, like CollideAABox
+		template <class Visitor>
+		void CollideFrustum(const Frustum &inFrustum, Visitor &&ioVisitor) const
+		{
+			WalkTree([&inFrustum](const Node &inNode) { return inFrustum.OverlapsAABox4(inNode.mMinX, inNode.mMinY, inNode.mMinZ, inNode.mMaxX, inNode.mMaxY, inNode.mMaxZ); }, ioVisitor);
+		}
+
+	private:
+		/// Visit all primitives in leaves that can be reached through children for which inTest returns true
+		template <class Test, class Visitor>
+		void WalkTree(const Test &inTest, Visitor &ioVisitor) const
+		{
+			if (mNodes.empty())
+				return;
+
+			u32 node_stack[cStackSize];
+			node_stack[0] = 0;
+			uint top = 1;
+			while (top > 0)
+			{
+				const u32 child = node_stack[--top];
+				if (child & cLeafFlag)
+				{
+					const u32 *primitive = &mPrimitiveIndices[(child & ~cLeafFlag) >> cLeafCountBits];
+					for (const u32 *end = primitive + (child & cMaxLeafSize); primitive < end; ++primitive)
+						ioVisitor(*primitive);
+				}
+				else
+				{
+					const Node &node = mNodes[child];
+					int hits = inTest(node).GetTrues();
+					while (hits != 0)
+					{
+						const uint i = CountTrailingZeros(u32(hits));
+						hits &= hits - 1;
+						ASSERT(top < cStackSize);
+						node_stack[top++] = node.mChild[i];
+					}
+				}
+			}
+		}
+
+		std::vector<Node> mNodes; ///< mNodes[0] is the root
+		std::vector<u32> mPrimitiveIndices; ///< Leaves reference ranges of this array
+		AABox mBounds;
+	};
+} // namespace topia
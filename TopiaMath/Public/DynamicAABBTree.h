@@ -0,0 +1,197 @@
+#pragma once
+
+#include "AABox.h"
+#include "RayAABox.h"
+
+namespace topia
+{
+	/// Binary AABB tree that supports inserting, removing and moving proxies (objects described by a bounding box) without rebuilding.
+	///
+	/// Leaves store a 'fat' box: the bounds of the proxy widened by a margin. Moving a proxy within its fat box costs nothing, only when
+	/// it leaves the fat box is the leaf removed and reinserted. Insertion descends the tree choosing the child with the smallest increase
+	/// in surface area, and every node on the way back up is rebalanced with a tree rotation when its children differ more than 1 in height.
+	///
+	/// Use this for objects that move, the static BVH4 is faster to query but needs a full rebuild when anything changes.
+	class DynamicAABBTree
+	{
+	public:
+		/// Index of a proxy (a leaf of the tree), or of an unused proxy
+		static constexpr u32 cInvalidProxy = 0xffffffff;
+
+		/// Maximum depth of the traversal stack
+		static constexpr uint cStackSize = 256;
+
+		/// A pair of overlapping proxies, mProxyA < mProxyB
+		class ProxyPair
+		{
+		public:
+			bool operator==(const ProxyPair &inRHS) const { return mProxyA == inRHS.mProxyA && mProxyB == inRHS.mProxyB; }
+			bool operator<(const ProxyPair &inRHS) const { return mProxyA < inRHS.mProxyA || (mProxyA == inRHS.mProxyA && mProxyB < inRHS.mProxyB); }
+
+			u32 mProxyA;
+			u32 mProxyB;
+		};
+
+		/// Constructor, inMargin is the distance by which the bounds of a proxy are widened in every direction
+		explicit DynamicAABBTree(float inMargin = 0.1f) : mMargin(inMargin) {}
+
+		/// Add a proxy, inUserData can be retrieved with GetUserData. Returns the proxy index.
+		u32 CreateProxy(const AABox &inBounds, u32 inUserData);
+
+		/// Remove a proxy, its index can be handed out again by CreateProxy
+		void DestroyProxy(u32 inProxy);
+
+		/// Update the bounds of a proxy. Returns true when the proxy left its fat box and was reinserted.
+		bool MoveProxy(u32 inProxy, const AABox &inBounds);
+
+		/// Add inCount proxies, proxy i gets bounds inBounds[i] and user data inUserData[i] and its index is written to outProxies[i].
+		/// The proxies are inserted in spatial (Morton) order so that consecutive inserts walk the same part of the tree.
+		void CreateProxies(const AABox *inBounds, const u32 *inUserData, uint inCount, u32 *outProxies);
+
+		/// Remove inCount proxies
+		void DestroyProxies(const u32 *inProxies, uint inCount);
+
+		/// Update the bounds of inCount proxies, proxy inProxies[i] gets bounds inBounds[i]. Proxies that left their fat box are
+		/// all removed first and then reinserted in spatial order. A proxy can be listed more than once, the last bounds are used.
+		/// Returns the number of proxies that were reinserted.
+		uint MoveProxies(const u32 *inProxies, const AABox *inBounds, uint inCount);
+
+		/// Find all pairs of overlapping fat boxes in which at least one proxy was created or reinserted since the previous call.
+		/// Pairs are appended to ioPairs (each pair once) so that the caller can reuse its storage from frame to frame.
+		void FindNewPairs(std::vector<ProxyPair> &ioPairs);
+
+		/// Find all proxies whose fat box overlaps inBox, ioVisitor is called as void(u32 inProxy)
+		template <class Visitor>
+		void QueryAABox(const AABox &inBox, Visitor &&ioVisitor) const
+		{
+			if (mRoot == cInvalidProxy)
+				return;
+
+			u32 stack[cStackSize];
+			stack[0] = mRoot;
+			uint top = 1;
+			while (top > 0)
+			{
+				const u32 index = stack[--top];
+				const Node &node = mNodes[index];
+				if (!node.mBounds.Overlaps(inBox))
+					continue;
+
+				if (node.IsLeaf())
+					ioVisitor(index);
+				else
+				{
+					ASSERT(top + 2 <= cStackSize);
+					stack[top++] = node.mChild[0];
+					stack[top++] = node.mChild[1];
+				}
+			}
+		}
+
+		/// Cast a ray from inOrigin along inDirection, up to inOrigin + inMaxFraction * inDirection, with the same visitor as BVH4::CastRay:
+		/// ioVisitor is called as float(u32 inProxy, float inClosest) for every proxy whose fat box is hit before the closest hit so far and
+		/// returns the fraction of its hit when it is closer than inClosest, otherwise inClosest. -FLT_MAX stops the traversal.
+		/// @return The fraction of the closest hit, or inMaxFraction when nothing was hit.
+		template <class Visitor>
+		float CastRay(Vec3Arg inOrigin, Vec3Arg inDirection, float inMaxFraction, Visitor &&ioVisitor) const
+		{
+			float closest = inMaxFraction;
+			if (mRoot == cInvalidProxy)
+				return closest;
+
+			const RayInvDirection inv_direction(inDirection);
+			u32 node_stack[cStackSize];
+			float fraction_stack[cStackSize];
+			node_stack[0] = mRoot;
+			fraction_stack[0] = RayAABox(inOrigin, inv_direction, mNodes[mRoot].mBounds.mMin, mNodes[mRoot].mBounds.mMax);
+			uint top = 1;
+			while (top > 0)
+			{
+				--top;
+				if (fraction_stack[top] >= closest)
+					continue; // Missed, or something closer was found after this node was pushed
+
+				const u32 index = node_stack[top];
+				const Node &node = mNodes[index];
+				if (node.IsLeaf())
+				{
+					closest = ioVisitor(index, closest);
+					continue;
+				}
+
+				// Push the furthest child first so the nearest one is visited next
+				float fraction[2];
+				for (uint i = 0; i < 2; ++i)
+				{
+					const AABox &child_bounds = mNodes[node.mChild[i]].mBounds;
+					fraction[i] = RayAABox(inOrigin, inv_direction, child_bounds.mMin, child_bounds.mMax);
+				}
+				const uint first = fraction[0] <= fraction[1]? 0 : 1;
+				ASSERT(top + 2 <= cStackSize);
+				node_stack[top] = node.mChild[1 - first];
+				fraction_stack[top++] = fraction[1 - first];
+				node_stack[top] = node.mChild[first];
+				fraction_stack[top++] = fraction[first];
+			}
+			return closest;
+		}
+
+		/// Access to the proxies
+		const AABox &GetFatBounds(u32 inProxy) const { ASSERT(mNodes[inProxy].IsLeaf()); return mNodes[inProxy].mBounds; }
+		u32 GetUserData(u32 inProxy) const { ASSERT(mNodes[inProxy].IsLeaf()); return mNodes[inProxy].mUserData; }
+
+		/// Get the number of proxies
+		uint GetNumProxies() const { return mNumProxies; }
+
+		/// Get the height of the tree (0 for a tree with a single proxy)
+		int GetHeight() const { return mRoot != cInvalidProxy? mNodes[mRoot].mHeight : 0; }
+
+		/// Get the bounds of all proxies
+		AABox GetBounds() const { return mRoot != cInvalidProxy? mNodes[mRoot].mBounds : AABox(); }
+
+		/// Check the structure of the tree: links between parents and children, the bounds and height of every internal node match its children,
+		/// the heights of the children of a node differ at most 1 and every proxy is reachable from the root exactly once. Used by the tests.
+		bool IsValid() const;
+
+	private:
+		/// A node of the tree, leaves and internal nodes share the same storage
+		class Node
+		{
+		public:
+			bool IsLeaf() const { return mChild[0] == cInvalidProxy; }
+
+			AABox mBounds; ///< Fat bounds for a leaf, union of the children for an internal node
+			u32 mParent; ///< Parent node, or the next free node when the node is unused
+			u32 mChild[2]; ///< Children, cInvalidProxy for a leaf
+			u32 mUserData; ///< User data (leaf only)
+			int mHeight; ///< 0 for a leaf, -1 when the node is unused
+			bool mMoved; ///< If the leaf is in mMoveBuffer
+		};
+
+		u32 AllocateNode();
+		void FreeNode(u32 inNode);
+		void InsertLeaf(u32 inLeaf);
+		void RemoveLeaf(u32 inLeaf);
+		u32 Balance(u32 inNode);
+		void UpdateFromChildren(Node &ioNode) const;
+		void AddToMoveBuffer(u32 inLeaf);
+
+		/// Get the fat box for the bounds of a proxy
+		AABox CalculateFatBounds(const AABox &inBounds) const { AABox fat = inBounds; fat.ExpandBy(Vec3::sReplicate(mMargin)); return fat; }
+
+		/// Check if a leaf needs to be reinserted for new bounds: when they left the fat box, or when the fat box became much too large because the proxy shrunk
+		bool NeedsReinsert(const Node &inLeaf, const AABox &inBounds) const;
+
+		/// Insert leaves in spatial order, reorders ioLeaves
+		void InsertLeaves(u32 *ioLeaves, uint inCount);
+
+		std::vector<Node> mNodes;
+		u32 mRoot = cInvalidProxy;
+		u32 mFreeList = cInvalidProxy;
+		uint mNumProxies = 0;
+		float mMargin;
+		std::vector<u32> mMoveBuffer; ///< Proxies that were created or reinserted since the last FindNewPairs
+		std::vector<u32> mReinsertLeaves; ///< Scratch buffer for MoveProxies
+		std::vector<u64> mSortKeys; ///< Scratch buffer for InsertLeaves
+	};
+} // namespace topia
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Topia.h>
+#include "Vec8.h"
+
+namespace topia
+{
+	/// 8 real symmetric 3x3 matrices stored as structure of arrays, lane i of every member belongs to matrix i.
+	/// Only the upper triangle is stored.
+	class TOPIA_NODISCARD SymMat33x8
+	{
+	public:
+		Vec8 mXX;
+		Vec8 mYY;
+		Vec8 mZZ;
+		Vec8 mXY;
+		Vec8 mXZ;
+		Vec8 mYZ;
+	};
+
+	static_assert(std::is_trivial<SymMat33x8>(), "Is supposed to be a trivial type!");
+
+	namespace detail
+	{
+		/// Apply a single Jacobi rotation in the (p, q) plane that zeroes ioPQ, r is the remaining axis.
+		/// The tangent of the rotation angle is computed as 2 a_pq sign(h) / (|h| + sqrt(h^2 + 4 a_pq^2)) with h = a_qq - a_pp,
+		/// which equals the Numerical Recipes formulation but never divides by a_pq, so no lane needs a branch when a_pq = 0.
+		TOPIA_INLINE void sJacobiRotate3x3x8(Vec8 &ioPP, Vec8 &ioQQ, Vec8 &ioPQ, Vec8 &ioRP, Vec8 &ioRQ, Vec8 *ioVecP, Vec8 *ioVecQ)
+		{
+			const Vec8 h = ioQQ - ioPP;
+			const Vec8 two_pq = ioPQ + ioPQ;
+			const Vec8 denom = h.Abs() + Vec8::sFusedMultiplyAdd(h, h, two_pq * two_pq).Sqrt() + Vec8::sReplicate(std::numeric_limits<float>::min());
+			const Vec8 t = two_pq * h.GetSign() / denom;
+			const Vec8 c = Vec8::sFusedMultiplyAdd(t, t, Vec8::sReplicate(1.0f)).Sqrt().Reciprocal();
+			const Vec8 s = t * c;
+
+			// Update diagonal, t * a_pq is the amount of 'mass' moved between the two diagonal elements
+			const Vec8 t_pq = t * ioPQ;
+			ioPP = ioPP - t_pq;
+			ioQQ = ioQQ + t_pq;
+			ioPQ = Vec8::sZero();
+
+			// Rotate the remaining off diagonal pair
+			const Vec8 rp = ioRP, rq = ioRQ;
+			ioRP = c * rp - s * rq;
+			ioRQ = s * rp + c * rq;
+
+			// Accumulate rotation in the eigen vectors (columns p and q)
+			for (uint r = 0; r < 3; ++r)
+			{
+				const Vec8 vp = ioVecP[r], vq = ioVecQ[r];
+				ioVecP[r] = c * vp - s * vq;
+				ioVecQ[r] = s * vp + c * vq;
+			}
+		}
+	} // namespace detail
+
+	/// Determine the eigen vectors and values of 8 real symmetric 3x3 matrices at the same time.
+	///
+	/// This is a cyclic Jacobi method with a fixed number of sweeps and no convergence test, so all lanes execute the
+	/// same instructions and nothing branches on the data. Each sweep rotates the (x, y), (x, z) and (y, z) planes once.
+	/// Jacobi converges quadratically, after 4 sweeps the off diagonal elements of a 3x3 matrix are at float precision.
+	///
+	/// @see EigenValueSymmetric for the generic N x N version
+	///
+	/// @param inMatrix are the matrices of which to return the eigen values and vectors
+	/// @param outEigVec will contain the normalized eigen vectors, outEigVec[c][r] is row r of column (eigen vector) c.
+	/// The columns form a rotation matrix (determinant +1).
+	/// @param outEigVal will contain the eigen values, outEigVal[c] belongs to eigen vector c. They are not sorted.
+	template <int NumSweeps = 4>
+	TOPIA_INLINE void EigenValueSymmetric3x3x8(const SymMat33x8 &inMatrix, Vec8 outEigVec[3][3], Vec8 outEigVal[3])
+	{
+		Vec8 a00 = inMatrix.mXX, a11 = inMatrix.mYY, a22 = inMatrix.mZZ;
+		Vec8 a01 = inMatrix.mXY, a02 = inMatrix.mXZ, a12 = inMatrix.mYZ;
+
+		const Vec8 zero = Vec8::sZero();
+		const Vec8 one = Vec8::sReplicate(1.0f);
+		outEigVec[0][0] = one;  outEigVec[0][1] = zero; outEigVec[0][2] = zero;
+		outEigVec[1][0] = zero; outEigVec[1][1] = one;  outEigVec[1][2] = zero;
+		outEigVec[2][0] = zero; outEigVec[2][1] = zero; outEigVec[2][2] = one;
+
+		for (int sweep = 0; sweep < NumSweeps; ++sweep)
+		{
+			// Plane (0, 1), remaining axis 2: a20 = a02, a21 = a12
+			detail::sJacobiRotate3x3x8(a00, a11, a01, a02, a12, outEigVec[0], outEigVec[1]);
+
+			// Plane (0, 2), remaining axis 1: a10 = a01, a12
+			detail::sJacobiRotate3x3x8(a00, a22, a02, a01, a12, outEigVec[0], outEigVec[2]);
+
+			// Plane (1, 2), remaining axis 0: a01, a02
+			detail::sJacobiRotate3x3x8(a11, a22, a12, a01, a02, outEigVec[1], outEigVec[2]);
+		}
+
+		outEigVal[0] = a00;
+		outEigVal[1] = a11;
+		outEigVal[2] = a22;
+	}
+} // namespace topia
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <Topia.h>
+#include "Vec8.h"
+#include "UVec8.h"
+#include "MathUtils.h"
+
+namespace topia
+{
+	/// Batched versions of FindRoot that solve 8 polynomials per call, one per lane, without branching on the data.
+	///
+	/// All functions return the number of real roots per lane and write the roots in ascending order.
+	/// Output slots that don't hold a root are set to +infinity, so e.g. the first root >= 0 of a ray intersection
+	/// can be found with a min / select over the outputs without looking at the count.
+	/// Degenerate polynomials (leading coefficient exactly zero) are solved as the polynomial of one degree lower.
+
+	namespace detail
+	{
+		/// Cube root, bit trick estimate (divide the exponent by 3) refined with 3 Newton iterations
+		TOPIA_INLINE Vec8 sCubeRoot8(Vec8Arg inV)
+		{
+			const Vec8 x = inV.Abs();
+			Vec8 y = Vec8::sFusedMultiplyAdd(x.ReinterpretAsInt().ToFloat(), Vec8::sReplicate(1.0f / 3.0f), Vec8::sReplicate(709921077.0f)).ToInt().ReinterpretAsFloat();
+			for (int i = 0; i < 3; ++i)
+				y = (y + y + x / (y * y)) * (1.0f / 3.0f);
+			y = Vec8::sSelect(y, Vec8::sZero(), Vec8::sEquals(x, Vec8::sZero()));
+			return y * inV.GetSign();
+		}
+
+		/// Arc cosine for inV in [-1, 1], Abramowitz and Stegun 4.4.46 (absolute error < 2e-8)
+		TOPIA_INLINE Vec8 sACos8(Vec8Arg inV)
+		{
+			const Vec8 x = Vec8::sMin(inV.Abs(), Vec8::sReplicate(1.0f));
+			Vec8 p = Vec8::sReplicate(-0.0012624911f);
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(0.0066700901f));
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(-0.0170881256f));
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(0.0308918810f));
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(-0.0501743046f));
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(0.0889789874f));
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(-0.2145988016f));
+			p = Vec8::sFusedMultiplyAdd(p, x, Vec8::sReplicate(1.5707963050f));
+			const Vec8 r = (Vec8::sReplicate(1.0f) - x).Sqrt() * p;
+			return Vec8::sSelect(r, Vec8::sReplicate(TOPIA_PI) - r, Vec8::sLess(inV, Vec8::sZero()));
+		}
+
+		/// Sine and cosine for inV in [0, pi / 3] (Taylor series, absolute error < 1e-8 on that range)
+		TOPIA_INLINE void sSinCosSmall8(Vec8Arg inV, Vec8 &outSin, Vec8 &outCos)
+		{
+			const Vec8 x2 = inV * inV;
+			Vec8 s = Vec8::sReplicate(-1.0f / 39916800.0f);
+			s = Vec8::sFusedMultiplyAdd(s, x2, Vec8::sReplicate(1.0f / 362880.0f));
+			s = Vec8::sFusedMultiplyAdd(s, x2, Vec8::sReplicate(-1.0f / 5040.0f));
+			s = Vec8::sFusedMultiplyAdd(s, x2, Vec8::sReplicate(1.0f / 120.0f));
+			s = Vec8::sFusedMultiplyAdd(s, x2, Vec8::sReplicate(-1.0f / 6.0f));
+			outSin = Vec8::sFusedMultiplyAdd(s * x2, inV, inV);
+
+			Vec8 c = Vec8::sReplicate(-1.0f / 3628800.0f);
+			c = Vec8::sFusedMultiplyAdd(c, x2, Vec8::sReplicate(1.0f / 40320.0f));
+			c = Vec8::sFusedMultiplyAdd(c, x2, Vec8::sReplicate(-1.0f / 720.0f));
+			c = Vec8::sFusedMultiplyAdd(c, x2, Vec8::sReplicate(1.0f / 24.0f));
+			c = Vec8::sFusedMultiplyAdd(c, x2, Vec8::sReplicate(-0.5f));
+			outCos = Vec8::sFusedMultiplyAdd(c, x2, Vec8::sReplicate(1.0f));
+		}
+
+		/// Sort ioA and ioB so that ioA <= ioB
+		TOPIA_INLINE void sSortPair8(Vec8 &ioA, Vec8 &ioB)
+		{
+			const Vec8 lo = Vec8::sMin(ioA, ioB);
+			ioB = Vec8::sMax(ioA, ioB);
+			ioA = lo;
+		}
+
+		/// One guarded Newton step on a polynomial with coefficients inCoeff[0] * x^N + ... + inCoeff[N]. The step is only taken when it reduces |f(x)|.
+		template <int N>
+		TOPIA_INLINE Vec8 sPolishRoot8(const Vec8 *inCoeff, Vec8Arg inX)
+		{
+			Vec8 f = inCoeff[0], df = Vec8::sZero();
+			for (int i = 1; i <= N; ++i)
+			{
+				df = Vec8::sFusedMultiplyAdd(df, inX, f);
+				f = Vec8::sFusedMultiplyAdd(f, inX, inCoeff[i]);
+			}
+			const Vec8 x = inX - f / df;
+
+			Vec8 f_new = inCoeff[0];
+			for (int i = 1; i <= N; ++i)
+				f_new = Vec8::sFusedMultiplyAdd(f_new, x, inCoeff[i]);
+
+			return Vec8::sSelect(inX, x, Vec8::sLess(f_new.Abs(), f.Abs()));
+		}
+
+		/// True for the lanes where inX is a root of the polynomial inCoeff[0] * x^N + ... + inCoeff[N] up to rounding, |f(x)| is compared with the sum of the magnitudes of its terms
+		template <int N>
+		TOPIA_INLINE UVec8 sIsRoot8(const Vec8 *inCoeff, Vec8Arg inX)
+		{
+			const Vec8 abs_x = inX.Abs();
+			Vec8 f = inCoeff[0], magnitude = inCoeff[0].Abs();
+			for (int i = 1; i <= N; ++i)
+			{
+				f = Vec8::sFusedMultiplyAdd(f, inX, inCoeff[i]);
+				magnitude = Vec8::sFusedMultiplyAdd(magnitude, abs_x, inCoeff[i].Abs());
+			}
+			return Vec8::sLessOrEqual(f.Abs(), magnitude * 1.0e-4f);
+		}
+
+		/// Count the lanes that don't contain +infinity
+		TOPIA_INLINE Vec8 sCountFinite8(Vec8Arg inX)
+		{
+			return Vec8::sSelect(Vec8::sReplicate(1.0f), Vec8::sZero(), Vec8::sEquals(inX, Vec8::sReplicate(std::numeric_limits<float>::infinity())));
+		}
+	} // namespace detail
+
+	/// Find the roots of \f$inA \: x^2 + inB \: x + inC = 0\f$ for 8 equations at once.
+	/// Uses q = -(b + sign(b) sqrt(b^2 - 4 a c)) / 2, x1 = q / a, x2 = c / q which avoids the cancellation of the textbook formula.
+	/// @return The number of roots per lane: 2 (possibly equal) when a != 0 and the discriminant is not negative, 1 for a linear equation and 0 otherwise.
+	TOPIA_INLINE UVec8 FindRoot8(Vec8Arg inA, Vec8Arg inB, Vec8Arg inC, Vec8 &outX1, Vec8 &outX2)
+	{
+		const Vec8 zero = Vec8::sZero();
+		const Vec8 inf = Vec8::sReplicate(std::numeric_limits<float>::infinity());
+
+		// Quadratic
+		const Vec8 det = inB * inB - Vec8::sReplicate(4.0f) * inA * inC;
+		const UVec8 has_roots = Vec8::sGreaterOrEqual(det, zero);
+		const Vec8 q = Vec8::sFusedMultiplyAdd(inB.GetSign(), Vec8::sMax(det, zero).Sqrt(), inB) * -0.5f;
+		Vec8 x1 = q / inA;
+		Vec8 x2 = Vec8::sSelect(inC / q, x1, Vec8::sEquals(q, zero)); // q = 0 implies b = c = 0, a double root at 0
+		detail::sSortPair8(x1, x2);
+		x1 = Vec8::sSelect(inf, x1, has_roots);
+		x2 = Vec8::sSelect(inf, x2, has_roots);
+
+		// Linear
+		const UVec8 is_linear = Vec8::sEquals(inA, zero);
+		const UVec8 is_constant = Vec8::sEquals(inB, zero);
+		const Vec8 linear = Vec8::sSelect(-inC / inB, inf, is_constant);
+		outX1 = Vec8::sSelect(x1, linear, is_linear);
+		outX2 = Vec8::sSelect(x2, inf, is_linear);
+
+		const UVec8 quadratic_count = UVec8::sSelect(UVec8::sReplicate(0), UVec8::sReplicate(2), has_roots);
+		const UVec8 linear_count = UVec8::sSelect(UVec8::sReplicate(1), UVec8::sReplicate(0), is_constant);
+		return UVec8::sSelect(quadratic_count, linear_count, is_linear);
+	}
+
+	/// Find the real roots of \f$inA \: x^3 + inB \: x^2 + inC \: x + inD = 0\f$ for 8 equations at once.
+	/// The equation is reduced to the depressed cubic t^3 + p t + q = 0. With one real root it is found with Cardano's formula
+	/// (choosing the sign that avoids cancellation), with three real roots (or a discriminant within rounding of zero) the trigonometric solution is used.
+	/// Each root is refined with a guarded Newton step on the original polynomial.
+	/// @return The number of roots per lane: 3 (possibly repeated), 2 (a double root found once) or 1, or the result of FindRoot8 when a = 0.
+	TOPIA_INLINE UVec8 FindCubicRoot8(Vec8Arg inA, Vec8Arg inB, Vec8Arg inC, Vec8Arg inD, Vec8 outX[3])
+	{
+		const Vec8 zero = Vec8::sZero();
+		const Vec8 inf = Vec8::sReplicate(std::numeric_limits<float>::infinity());
+
+		// Normalize to x^3 + b x^2 + c x + d and substitute x = t - b / 3
+		const Vec8 inv_a = inA.Reciprocal();
+		const Vec8 coeff[4] = { Vec8::sReplicate(1.0f), inB * inv_a, inC * inv_a, inD * inv_a };
+		const Vec8 b3 = coeff[1] * (1.0f / 3.0f);
+		const Vec8 p = coeff[2] - coeff[1] * b3;
+		const Vec8 q = coeff[3] - b3 * coeff[2] + b3 * b3 * b3 * 2.0f;
+		const Vec8 half_q = q * 0.5f;
+		const Vec8 third_p = p * (1.0f / 3.0f);
+		const Vec8 third_p_cubed = third_p * third_p * third_p;
+		const Vec8 disc = half_q * half_q + third_p_cubed;
+
+		// A double root has a discriminant of zero that rounds to either sign, the one root branch would drop it when it rounds up.
+		// Within rounding of zero the trigonometric solution is used as well, but its roots are only kept when they are roots of the
+		// original polynomial: a far away single root also makes the discriminant small relative to its terms.
+		const Vec8 disc_tolerance = (half_q * half_q + third_p_cubed.Abs()) * 1.0e-5f;
+		const UVec8 three_roots = Vec8::sLessOrEqual(disc, disc_tolerance);
+		const UVec8 near_zero = UVec8::sAnd(three_roots, Vec8::sGreater(disc, zero));
+
+		// One real root: t = u - p / (3 u) with u = cbrt(-q / 2 - sign(q) sqrt(disc))
+		const Vec8 u = detail::sCubeRoot8(-Vec8::sFusedMultiplyAdd(half_q.GetSign(), Vec8::sMax(disc, zero).Sqrt(), half_q));
+		const Vec8 t_single = Vec8::sSelect(u - third_p / u, zero, Vec8::sEquals(u, zero));
+
+		// Three real roots: t = 2 r cos(phi - 2 pi k / 3) with r = sqrt(-p / 3) and cos(3 phi) = -q / (2 r^3), phi in [0, pi / 3]
+		const Vec8 r = Vec8::sMax(-third_p, zero).Sqrt();
+		const Vec8 r3 = r * r * r;
+		const Vec8 cos_3phi = Vec8::sSelect(zero, -half_q / r3, UVec8::sAnd(three_roots, Vec8::sGreater(r3, zero))); // r = 0 is a triple root, t = 0
+		Vec8 sin_phi, cos_phi;
+		detail::sSinCosSmall8(detail::sACos8(cos_3phi) * (1.0f / 3.0f), sin_phi, cos_phi);
+		const Vec8 sqrt3_sin_phi = sin_phi * 1.7320508075688772f;
+		const Vec8 t0 = -r * (cos_phi + sqrt3_sin_phi);
+		const Vec8 t1 = r * (sqrt3_sin_phi - cos_phi);
+		const Vec8 t2 = r * cos_phi * 2.0f;
+
+		// Undo the substitution and polish, near a zero discriminant the trigonometric roots that aren't roots are dropped
+		const Vec8 x_single = detail::sPolishRoot8<3>(coeff, t_single - b3);
+		Vec8 x[3] = {
+			detail::sPolishRoot8<3>(coeff, t0 - b3),
+			detail::sPolishRoot8<3>(coeff, t1 - b3),
+			detail::sPolishRoot8<3>(coeff, t2 - b3) };
+		UVec8 any_valid = UVec8::sReplicate(0);
+		for (int i = 0; i < 3; ++i)
+		{
+			const UVec8 valid = UVec8::sOr(Vec8::sLessOrEqual(disc, zero), UVec8::sAnd(near_zero, detail::sIsRoot8<3>(coeff, x[i])));
+			x[i] = Vec8::sSelect(inf, x[i], valid);
+			any_valid = UVec8::sOr(any_valid, valid);
+		}
+		x[0] = Vec8::sSelect(x_single, x[0], any_valid);
+
+		// The polished roots may need to be reordered
+		detail::sSortPair8(x[0], x[1]);
+		detail::sSortPair8(x[1], x[2]);
+		detail::sSortPair8(x[0], x[1]);
+		const UVec8 count = (detail::sCountFinite8(x[0]) + detail::sCountFinite8(x[1]) + detail::sCountFinite8(x[2])).ToInt();
+
+		// Fall back to the quadratic when the leading coefficient is zero
+		const UVec8 is_quadratic = Vec8::sEquals(inA, zero);
+		Vec8 qx1, qx2;
+		const UVec8 quadratic_count = FindRoot8(inB, inC, inD, qx1, qx2);
+		outX[0] = Vec8::sSelect(x[0], qx1, is_quadratic);
+		outX[1] = Vec8::sSelect(x[1], qx2, is_quadratic);
+		outX[2] = Vec8::sSelect(x[2], inf, is_quadratic);
+		return UVec8::sSelect(count, quadratic_count, is_quadratic);
+	}
+
+	/// Find the real roots of \f$inA \: x^4 + inB \: x^3 + inC \: x^2 + inD \: x + inE = 0\f$ for 8 equations at once.
+	/// Uses Ferrari's method on the depressed quartic y^4 + p y^2 + q y + r = 0: the largest root m of the resolvent cubic
+	/// 8 m^3 + 8 p m^2 + (2 p^2 - 8 r) m - q^2 = 0 splits it into two quadratics. When q = 0 the quartic is solved as a quadratic in y^2.
+	/// Each root is refined with a guarded Newton step on the original polynomial.
+	/// @return The number of roots per lane (0 to 4, repeated roots are counted multiple times), or the result of FindCubicRoot8 when a = 0.
+	TOPIA_INLINE UVec8 FindQuarticRoot8(Vec8Arg inA, Vec8Arg inB, Vec8Arg inC, Vec8Arg inD, Vec8Arg inE, Vec8 outX[4])
+	{
+		const Vec8 zero = Vec8::sZero();
+		const Vec8 one = Vec8::sReplicate(1.0f);
+		const Vec8 inf = Vec8::sReplicate(std::numeric_limits<float>::infinity());
+
+		// Normalize to x^4 + b x^3 + c x^2 + d x + e and substitute x = y - b / 4
+		const Vec8 inv_a = inA.Reciprocal();
+		const Vec8 coeff[5] = { one, inB * inv_a, inC * inv_a, inD * inv_a, inE * inv_a };
+		const Vec8 b4 = coeff[1] * 0.25f;
+		const Vec8 b4_sq = b4 * b4;
+		const Vec8 p = coeff[2] - b4_sq * 6.0f;
+		const Vec8 q = coeff[3] - coeff[2] * b4 * 2.0f + b4_sq * b4 * 8.0f;
+		const Vec8 r = coeff[4] - coeff[3] * b4 + coeff[2] * b4_sq - b4_sq * b4_sq * 3.0f;
+
+		// Largest root of the resolvent cubic, it is positive when q != 0
+		Vec8 resolvent[3];
+		(void)FindCubicRoot8(Vec8::sReplicate(8.0f), p * 8.0f, p * p * 2.0f - r * 8.0f, -q * q, resolvent);
+		Vec8 m = resolvent[0];
+		for (int i = 1; i < 3; ++i)
+			m = Vec8::sSelect(m, resolvent[i], Vec8::sLess(resolvent[i], inf)); // The roots are sorted, the last finite one is the largest
+		m = Vec8::sMax(m, zero);
+		const UVec8 is_biquadratic = UVec8::sOr(Vec8::sEquals(q, zero), Vec8::sEquals(m, zero));
+
+		// General case: y^2 -/+ s y + (p / 2 + m +/- q / (2 s)) = 0 with s = sqrt(2 m)
+		const Vec8 s = (m + m).Sqrt();
+		const Vec8 k = Vec8::sSelect(q / (s + s), zero, is_biquadratic);
+		const Vec8 half_p_plus_m = Vec8::sFusedMultiplyAdd(p, Vec8::sReplicate(0.5f), m);
+		// The root counts aren't needed, missing roots come back as +infinity and are handled as such below
+		Vec8 y[4];
+		(void)FindRoot8(one, -s, half_p_plus_m + k, y[0], y[1]);
+		(void)FindRoot8(one, s, half_p_plus_m - k, y[2], y[3]);
+
+		// Biquadratic case: z^2 + p z + r = 0 with z = y^2
+		Vec8 z1, z2;
+		(void)FindRoot8(one, p, r, z1, z2);
+		const UVec8 z1_valid = Vec8::sGreaterOrEqual(z1, zero), z2_valid = Vec8::sGreaterOrEqual(z2, zero); // Also false for the +infinity of a missing root
+		const Vec8 sqrt_z1 = Vec8::sMax(z1, zero).Sqrt(), sqrt_z2 = Vec8::sMax(z2, zero).Sqrt();
+		const UVec8 z2_present = UVec8::sAnd(z2_valid, Vec8::sLess(z2, inf));
+		y[0] = Vec8::sSelect(y[0], Vec8::sSelect(inf, -sqrt_z2, z2_present), is_biquadratic);
+		y[1] = Vec8::sSelect(y[1], Vec8::sSelect(inf, -sqrt_z1, z1_valid), is_biquadratic);
+		y[2] = Vec8::sSelect(y[2], Vec8::sSelect(inf, sqrt_z1, z1_valid), is_biquadratic);
+		y[3] = Vec8::sSelect(y[3], Vec8::sSelect(inf, sqrt_z2, z2_present), is_biquadratic);
+
+		// Undo the substitution and polish, missing roots stay +infinity
+		Vec8 x[4];
+		Vec8 count = zero;
+		for (int i = 0; i < 4; ++i)
+		{
+			const UVec8 missing = Vec8::sEquals(y[i], inf);
+			x[i] = Vec8::sSelect(detail::sPolishRoot8<4>(coeff, y[i] - b4), inf, missing);
+			count = count + detail::sCountFinite8(x[i]);
+		}
+
+		// Sorting network for 4 elements
+		detail::sSortPair8(x[0], x[1]);
+		detail::sSortPair8(x[2], x[3]);
+		detail::sSortPair8(x[0], x[2]);
+		detail::sSortPair8(x[1], x[3]);
+		detail::sSortPair8(x[1], x[2]);
+
+		// Fall back to the cubic when the leading coefficient is zero
+		const UVec8 is_cubic = Vec8::sEquals(inA, zero);
+		Vec8 cx[3];
+		const UVec8 cubic_count = FindCubicRoot8(inB, inC, inD, inE, cx);
+		for (int i = 0; i < 3; ++i)
+			outX[i] = Vec8::sSelect(x[i], cx[i], is_cubic);
+		outX[3] = Vec8::sSelect(x[3], inf, is_cubic);
+		return UVec8::sSelect(count.ToInt(), cubic_count, is_cubic);
+	}
+} // namespace topia
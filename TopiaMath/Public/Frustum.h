@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Plane.h"
+#include "Sphere.h"
+#include "AABox4.h"
+
+namespace topia
+{
+	/// View frustum described by 6 planes whose normals point inwards (a point is inside when it is on the positive side of all planes)
+	class TOPIA_NODISCARD Frustum
+	{
+	public:
+		/// Plane indices
+		enum EPlane : uint
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			NumPlanes
+		};
+
+		Frustum() = default;
+
+		/// Extract the planes from a view projection matrix (Gribb / Hartmann). The matrix maps world space to clip space for column vectors
+		/// (clip = inViewProjection * world), with clip space z in [0, w] like D3D. Reversed z projections work as well, near and far just swap.
+		explicit Frustum(Mat44Arg inViewProjection)
+		{
+			const Mat44 rows = inViewProjection.Transposed();
+			const Vec4 row0 = rows.GetColumn4(0), row1 = rows.GetColumn4(1), row2 = rows.GetColumn4(2), row3 = rows.GetColumn4(3);
+			mPlanes[Left] = Plane(row3 + row0).Normalized();
+			mPlanes[Right] = Plane(row3 - row0).Normalized();
+			mPlanes[Bottom] = Plane(row3 + row1).Normalized();
+			mPlanes[Top] = Plane(row3 - row1).Normalized();
+			mPlanes[Near] = Plane(row2).Normalized();
+			mPlanes[Far] = Plane(row3 - row2).Normalized();
+			UpdatePlanes4();
+		}
+
+		/// Construct from 6 planes (normals pointing inwards)
+		explicit Frustum(const Plane *inPlanes)
+		{
+			for (uint i = 0; i < NumPlanes; ++i)
+				mPlanes[i] = inPlanes[i];
+			UpdatePlanes4();
+		}
+
+		/// Access to the planes
+		const Plane &GetPlane(uint inIndex) const { ASSERT(inIndex < NumPlanes); return mPlanes[inIndex]; }
+
+		/// Test if a point is inside the frustum
+		bool Contains(Vec3Arg inPoint) const
+		{
+			for (const Plane &plane : mPlanes)
+				if (plane.SignedDistance(inPoint) < 0.0f)
+					return false;
+			return true;
+		}
+
+		/// Test if a sphere is (partially) inside the frustum
+		bool Overlaps(const Sphere &inSphere) const
+		{
+			for (const Plane &plane : mPlanes)
+				if (plane.SignedDistance(inSphere.mCenter) < -inSphere.mRadius)
+					return false;
+			return true;
+		}
+
+		/// Test if a box is (partially) inside the frustum. This is conservative: a large box near a corner of the frustum
+		/// can be reported as overlapping while it is outside, which is fine for culling.
+		bool Overlaps(const AABox &inBox) const
+		{
+			const UVec4 behind0 = AABoxBehindPlanes4(inBox, mNormalX[0], mNormalY[0], mNormalZ[0], mConstant[0]);
+			const UVec4 behind1 = AABoxBehindPlanes4(inBox, mNormalX[1], mNormalY[1], mNormalZ[1], mConstant[1]);
+			return !UVec4::sOr(behind0, behind1).TestAnyTrue();
+		}
+
+		/// Test 4 boxes (structure of arrays) against the frustum, returns the lanes that are (partially) inside. Invalid boxes (min > max) are never inside.
+		UVec4 OverlapsAABox4(Vec4Arg inBoxMinX, Vec4Arg inBoxMinY, Vec4Arg inBoxMinZ, Vec4Arg inBoxMaxX, Vec4Arg inBoxMaxY, Vec4Arg inBoxMaxZ) const
+		{
+			const Vec4 zero = Vec4::sZero();
+			UVec4 behind = UVec4::sZero();
+			for (const Plane &plane : mPlanes)
+			{
+				// Distance of the vertex of each box that is furthest along the plane normal
+				const Vec3 normal = plane.GetNormal();
+				const Vec4 nx = normal.SplatX(), ny = normal.SplatY(), nz = normal.SplatZ();
+				const Vec4 px = Vec4::sSelect(inBoxMaxX, inBoxMinX, Vec4::sLess(nx, zero));
+				const Vec4 py = Vec4::sSelect(inBoxMaxY, inBoxMinY, Vec4::sLess(ny, zero));
+				const Vec4 pz = Vec4::sSelect(inBoxMaxZ, inBoxMinZ, Vec4::sLess(nz, zero));
+				const Vec4 distance = Vec4::sFusedMultiplyAdd(pz, nz, Vec4::sFusedMultiplyAdd(py, ny, Vec4::sFusedMultiplyAdd(px, nx, Vec4::sReplicate(plane.GetConstant()))));
+				behind = UVec4::sOr(behind, Vec4::sLess(distance, zero));
+			}
+			return UVec4::sNot(behind);
+		}
+
+	private:
+		/// Store the planes as structure of arrays for AABoxBehindPlanes4, the second group holds Near, Far, Near, Far
+		void UpdatePlanes4()
+		{
+			for (uint group = 0; group < 2; ++group)
+				for (uint lane = 0; lane < 4; ++lane)
+				{
+					const Plane &plane = mPlanes[group == 0 ? lane : Near + (lane & 1)];
+					const Vec3 normal = plane.GetNormal();
+					mNormalX[group][lane] = normal.GetX();
+					mNormalY[group][lane] = normal.GetY();
+					mNormalZ[group][lane] = normal.GetZ();
+					mConstant[group][lane] = plane.GetConstant();
+				}
+		}
+
+		Plane mPlanes[NumPlanes];
+		Vec4 mNormalX[2];
+		Vec4 mNormalY[2];
+		Vec4 mNormalZ[2];
+		Vec4 mConstant[2];
+	};
+} // namespace topia
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Frustum.h"
+
+#include <ThreadPool.h>
+
+namespace topia
+{
+	/// Bounds of many boxes stored as structure of arrays, box i is centered at (mCenterX[i], mCenterY[i], mCenterZ[i])
+	/// and has half size (mExtentX[i], mExtentY[i], mExtentZ[i]). All arrays hold mCount floats.
+	class TOPIA_NODISCARD AABoxSoA
+	{
+	public:
+		const float *mCenterX = nullptr;
+		const float *mCenterY = nullptr;
+		const float *mCenterZ = nullptr;
+		const float *mExtentX = nullptr;
+		const float *mExtentY = nullptr;
+		const float *mExtentZ = nullptr;
+		uint mCount = 0;
+	};
+
+	/// Cull boxes against a frustum. Tests 8 boxes per iteration against all 6 planes using AVX.
+	/// A box is culled when it is completely behind one of the planes: center . normal + constant < -(extent . |normal|).
+	/// @param outVisible receives the indices of the visible boxes in increasing order, must have room for inBounds.mCount entries
+	/// @param inPool when given, large inputs are split into one range per thread of the pool plus the calling thread (nullptr = the calling thread only)
+	/// @return The number of visible boxes
+	uint FrustumCull(const Frustum &inFrustum, const AABoxSoA &inBounds, u32 *outVisible, FThreadPool *inPool = nullptr);
+} // namespace topia
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "Vector.h"
+
 namespace topia
 {
 
+template <uint Rows, uint Cols>
+class Matrix;
+
+
 /// This function performs Gauss-Jordan elimination to solve a matrix equation. 
 /// A must be an NxN matrix and B must be an NxM matrix forming the equation A * x = B
 /// on output B will contain x and A will be destroyed.
@@ -25,7 +31,7 @@ bool GaussianElimination(MatrixA& ioA, MatrixB& ioB, float inTolerance = 1.0e-16
 
     // Create array for bookkeeping on pivoting
     int* ipiv = (int*)TOPIA_STACK_ALLOC(n * sizeof(int));
-    memset(ipiv, 0, n * sizeof(int));
+    std::memset(ipiv, 0, n * sizeof(int));
 
     for (uint i = 0; i < n; ++i)
     {
@@ -40,7 +46,7 @@ bool GaussianElimination(MatrixA& ioA, MatrixB& ioB, float inTolerance = 1.0e-16
                 {
                     if (ipiv[k] == 0)
                     {
-                        float element = abs(ioA(j, k));
+                        float element = std::abs(ioA(j, k));
                         if (element >= largest_element)
                         {
                             largest_element = element;
@@ -61,14 +67,14 @@ bool GaussianElimination(MatrixA& ioA, MatrixB& ioB, float inTolerance = 1.0e-16
         if (pivot_row != pivot_col)
         {
             for (uint j = 0; j < n; ++j)
-                swap(ioA(pivot_row, j), ioA(pivot_col, j));
+                std::swap(ioA(pivot_row, j), ioA(pivot_col, j));
             for (uint j = 0; j < m; ++j)
-                swap(ioB(pivot_row, j), ioB(pivot_col, j));
+                std::swap(ioB(pivot_row, j), ioB(pivot_col, j));
         }
 
         // Get diagonal element that we are about to set to 1
         float diagonal_element = ioA(pivot_col, pivot_col);
-        if (abs(diagonal_element) < inTolerance)
+        if (std::abs(diagonal_element) < inTolerance)
             return false;
 
         // Divide the whole row by the pivot element, making ioA(pivot_col, pivot_col) = 1
@@ -96,4 +102,87 @@ bool GaussianElimination(MatrixA& ioA, MatrixB& ioB, float inTolerance = 1.0e-16
     return true;
 }
 
-}
\ No newline at end of file
+/// Largest system GaussianEliminationBlocked accepts, above this the matrix no longer comfortably fits in L1 / L2 cache
+/// and a proper blocked LU factorization would be needed.
+constexpr uint cGaussianEliminationBlockedMaxSize = 64;
+
+/// Variant of GaussianElimination for dense N x N systems with N known at compile time (up to 64 x 64).
+/// Solves A * x = B, on output B will contain x and A will be destroyed.
+///
+/// GaussianElimination uses full pivoting and touches the column major matrices row by row, which strides through memory
+/// and doesn't vectorize. This version uses partial (row) pivoting and formulates every elimination step as an update of
+/// whole columns: after scaling the pivot row, column k becomes column k - A(p, k) * f where f is the pivot column with
+/// a zero at the pivot row. The update of all columns of A and B is then a branch free multiply add over contiguous
+/// memory that processes 4 rows per instruction, and 2 columns are updated per iteration to hide latency.
+/// Row pivoting is equivalent to reordering the equations, so the solution needs no unpermuting afterwards.
+template <uint N, uint M>
+bool GaussianEliminationBlocked(Matrix<N, N> &ioA, Matrix<N, M> &ioB, float inTolerance = 1.0e-16f)
+{
+    static_assert(N <= cGaussianEliminationBlockedMaxSize, "Use GaussianElimination for larger systems");
+
+    float f[N];
+
+    for (uint p = 0; p < N; ++p)
+    {
+        // Find the largest element on or below the diagonal in the pivot column, this is a contiguous scan
+        const float *pivot_column = ioA.mCol[p].mF32;
+        uint pivot_row = p;
+        float largest_element = std::abs(pivot_column[p]);
+        for (uint r = p + 1; r < N; ++r)
+        {
+            float element = std::abs(pivot_column[r]);
+            if (element > largest_element)
+            {
+                largest_element = element;
+                pivot_row = r;
+            }
+        }
+        if (largest_element < inTolerance)
+            return false;
+
+        // Exchange rows so that the pivot element ends up on the diagonal
+        if (pivot_row != p)
+        {
+            for (uint c = 0; c < N; ++c)
+                std::swap(ioA.mCol[c].mF32[pivot_row], ioA.mCol[c].mF32[p]);
+            for (uint c = 0; c < M; ++c)
+                std::swap(ioB.mCol[c].mF32[pivot_row], ioB.mCol[c].mF32[p]);
+        }
+
+        // Divide the pivot row by the pivot element, columns left of p have already been reduced to unit vectors
+        const float inv_pivot = 1.0f / ioA.mCol[p].mF32[p];
+        for (uint c = p; c < N; ++c)
+            ioA.mCol[c].mF32[p] *= inv_pivot;
+        for (uint c = 0; c < M; ++c)
+            ioB.mCol[c].mF32[p] *= inv_pivot;
+
+        // Copy the negated pivot column and clear the pivot row, this keeps the pivot row intact in the update below
+        for (uint r = 0; r < N; ++r)
+            f[r] = -ioA.mCol[p].mF32[r];
+        f[p] = 0.0f;
+
+        // Eliminate the pivot column from all other rows, two columns at a time.
+        // Columns left of p are unit vectors with a zero in row p so they would not change and are skipped.
+        uint c = p;
+        for (; c + 1 < N; c += 2)
+        {
+            detail::sMultiplyAdd<N>(ioA.mCol[c].mF32, f, ioA.mCol[c].mF32[p]);
+            detail::sMultiplyAdd<N>(ioA.mCol[c + 1].mF32, f, ioA.mCol[c + 1].mF32[p]);
+        }
+        if (c < N)
+            detail::sMultiplyAdd<N>(ioA.mCol[c].mF32, f, ioA.mCol[c].mF32[p]);
+
+        for (c = 0; c + 1 < M; c += 2)
+        {
+            detail::sMultiplyAdd<N>(ioB.mCol[c].mF32, f, ioB.mCol[c].mF32[p]);
+            detail::sMultiplyAdd<N>(ioB.mCol[c + 1].mF32, f, ioB.mCol[c + 1].mF32[p]);
+        }
+        if (c < M)
+            detail::sMultiplyAdd<N>(ioB.mCol[c].mF32, f, ioB.mCol[c].mF32[p]);
+    }
+
+    // Success
+    return true;
+}
+
+}
@@ -51,7 +51,7 @@ namespace topia
 		inline HalfFloat FromFloatFallback(float inV)
 		{
 			// Reinterpret the float as an uint32
-			static_assert(sizeof(float) == sizeof(u32));
+			static_assert(sizeof(float) == sizeof(u32), "Float must be 32 bits");
 			union FloatToInt
 			{
 				float f;
@@ -114,7 +114,7 @@ namespace topia
 			// Calculate the remaining bits that we're discarding
 			uint remainder = mantissa & ((1 << shift) - 1);
 
-			if constexpr (RoundingMode == ROUND_TO_NEAREST)
+			if (RoundingMode == ROUND_TO_NEAREST) // Compile time constant, plain if so the header also compiles as C++14
 			{
 				// Round to nearest
 				uint round_threshold = 1 << (shift - 1);
@@ -162,6 +162,26 @@ namespace topia
 #endif
 		}
 
+		/// Convert 4 floats to half floats (lower 64 bits)
+		template <int RoundingMode>
+		TOPIA_INLINE UVec4 FromFloat4(Vec4Arg inV)
+		{
+#ifdef TOPIA_USE_F16C
+			switch (RoundingMode)
+			{
+			case ROUND_TO_NEG_INF:
+				return _mm_cvtps_ph(inV.mValue, _MM_FROUND_TO_NEG_INF);
+			case ROUND_TO_POS_INF:
+				return _mm_cvtps_ph(inV.mValue, _MM_FROUND_TO_POS_INF);
+			default:
+				return _mm_cvtps_ph(inV.mValue, _MM_FROUND_TO_NEAREST_INT);
+			}
+#else
+			return UVec4(u32(FromFloatFallback<RoundingMode>(inV.GetX())) | (u32(FromFloatFallback<RoundingMode>(inV.GetY())) << 16),
+				u32(FromFloatFallback<RoundingMode>(inV.GetZ())) | (u32(FromFloatFallback<RoundingMode>(inV.GetW())) << 16), 0, 0);
+#endif
+		}
+
 		/// Convert 4 half floats (lower 64 bits) to floats, fallback version when no intrinsics available
 		inline Vec4 ToFloatFallback(UVec4Arg inValue)
 		{
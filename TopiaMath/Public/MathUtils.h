@@ -2,6 +2,10 @@
 
 #include <Topia.h>
 
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
 /// The constant \f$\pi\f$
 #define TOPIA_PI 3.14159265358979323846f
 
@@ -88,14 +92,16 @@ namespace topia
 	inline uint CountTrailingZeros(u32 inValue)
 	{
 #if defined(TOPIA_CPU_X64)
-#ifdef TOPIA_USE_LZCNT
+#if defined(TOPIA_USE_TZCNT)
 		return _tzcnt_u32(inValue);
-#else
+#elif defined(_MSC_VER)
 		if (inValue == 0)
 			return 32;
 		unsigned long result;
 		_BitScanForward(&result, inValue);
 		return result;
+#else
+		return inValue == 0 ? 32 : __builtin_ctz(inValue);
 #endif
 #elif defined(TOPIA_CPU_ARM64)
 		return __builtin_clz(__builtin_bitreverse32(inValue));
@@ -108,14 +114,16 @@ namespace topia
 	inline uint CountLeadingZeros(u32 inValue)
 	{
 #if defined(TOPIA_CPU_X64)
-#ifdef TOPIA_USE_LZCNT
+#if defined(TOPIA_USE_LZCNT)
 		return _lzcnt_u32(inValue);
-#else
+#elif defined(_MSC_VER)
 		if (inValue == 0)
 			return 32;
 		unsigned long result;
 		_BitScanReverse(&result, inValue);
 		return 31 - result;
+#else
+		return inValue == 0 ? 32 : __builtin_clz(inValue);
 #endif
 #elif defined(TOPIA_CPU_ARM64)
 		return __builtin_clz(inValue);
@@ -127,8 +135,10 @@ namespace topia
 	/// Count the number of 1 bits in a value
 	inline uint CountBits(u32 inValue)
 	{
-#if defined(TOPIA_CPU_X64)
+#if defined(TOPIA_CPU_X64) && defined(_MSC_VER)
 		return _mm_popcnt_u32(inValue);
+#elif defined(TOPIA_CPU_X64)
+		return __builtin_popcount(inValue);
 #elif defined(TOPIA_CPU_ARM64)
 		return __builtin_popcount(inValue);
 #else
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vector.h"
+#include "Mat44.h"
 #include "GaussianElimination.h"
 
 namespace topia
@@ -52,7 +53,7 @@ namespace topia
 			SetZero();
 
 			// Set diagonal to 1
-			for (uint rc = 0, min_rc = min(Rows, Cols); rc < min_rc; ++rc)
+			for (uint rc = 0, min_rc = std::min(Rows, Cols); rc < min_rc; ++rc)
 				mCol[rc].mF32[rc] = 1.0f;
 		}
 
@@ -73,7 +74,7 @@ namespace topia
 			SetZero();
 
 			// Set diagonal
-			for (uint rc = 0, min_rc = min(Rows, Cols); rc < min_rc; ++rc)
+			for (uint rc = 0, min_rc = std::min(Rows, Cols); rc < min_rc; ++rc)
 				mCol[rc].mF32[rc] = inV[rc];
 		}
 
@@ -137,15 +138,10 @@ namespace topia
 		template <uint OtherCols>
 		inline const Matrix<Rows, OtherCols> operator*(const Matrix<Cols, OtherCols> &inM) const
 		{
+			// Every result column is a weighted sum of our columns
 			Matrix<Rows, OtherCols> m;
 			for (uint c = 0; c < OtherCols; ++c)
-				for (uint r = 0; r < Rows; ++r)
-				{
-					float dot = 0.0f;
-					for (uint i = 0; i < Cols; ++i)
-						dot += mCol[i].mF32[r] * inM.mCol[c].mF32[i];
-					m.mCol[c].mF32[r] = dot;
-				}
+				detail::sWeightedSum<Rows, Cols>(mCol, inM.mCol[c].mF32, m.mCol[c].mF32);
 			return m;
 		}
 
@@ -153,13 +149,7 @@ namespace topia
 		inline const Vector<Rows> operator*(const Vector<Cols> &inV) const
 		{
 			Vector<Rows> v;
-			for (uint r = 0; r < Rows; ++r)
-			{
-				float dot = 0.0f;
-				for (uint c = 0; c < Cols; ++c)
-					dot += mCol[c].mF32[r] * inV.mF32[c];
-				v.mF32[r] = dot;
-			}
+			detail::sWeightedSum<Rows, Cols>(mCol, inV.mF32, v.mF32);
 			return v;
 		}
 
@@ -199,8 +189,24 @@ namespace topia
 		inline const Matrix<Cols, Rows> Transposed() const
 		{
 			Matrix<Cols, Rows> m;
+
+			// Transpose 4x4 blocks with Mat44, the remaining rows / columns are done per element
+			constexpr uint cBlockRows = detail::Vec4Rows<Rows>::cValue, cBlockCols = detail::Vec4Rows<Cols>::cValue;
+			for (uint r = 0; r < cBlockRows; r += 4)
+				for (uint c = 0; c < cBlockCols; c += 4)
+				{
+					Mat44 block(
+						Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(mCol[c].mF32 + r)),
+						Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(mCol[c + 1].mF32 + r)),
+						Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(mCol[c + 2].mF32 + r)),
+						Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(mCol[c + 3].mF32 + r)));
+					block = block.Transposed();
+					for (uint i = 0; i < 4; ++i)
+						block.GetColumn4(i).StoreFloat4(reinterpret_cast<Float4 *>(m.mCol[r + i].mF32 + c));
+				}
+
 			for (uint r = 0; r < Rows; ++r)
-				for (uint c = 0; c < Cols; ++c)
+				for (uint c = r < cBlockRows? cBlockCols : 0; c < Cols; ++c)
 					m.mCol[r].mF32[c] = mCol[c].mF32[r];
 			return m;
 		}
@@ -208,12 +214,11 @@ namespace topia
 		/// Inverse matrix
 		bool SetInversed(const Matrix &inM)
 		{
-			if constexpr (Rows != Cols)
-				ASSERT(false, "Matrix must be square.");
+			static_assert(Rows == Cols, "Matrix must be square.");
 
 			Matrix copy(inM);
 			SetIdentity();
-			return GaussianElimination(copy, *this);
+			return sSolve(copy, *this, std::integral_constant<bool, (Rows > 4 && Rows <= cGaussianEliminationBlockedMaxSize)>());
 		}
 
 		inline const Matrix Inversed() const
@@ -224,7 +229,7 @@ namespace topia
 		}
 
 		/// To String
-		friend ostream &operator<<(ostream &inStream, const Matrix &inM)
+		friend std::ostream &operator<<(std::ostream &inStream, const Matrix &inM)
 		{
 			for (uint i = 0; i < Cols - 1; ++i)
 				inStream << inM.mCol[i] << ", ";
@@ -237,6 +242,11 @@ namespace topia
 		Vector<Rows> &GetColumn(int inIdx) { return mCol[inIdx]; }
 
 		Vector<Rows> mCol[Cols]; ///< Column
+
+	private:
+		/// Solve for SetInversed, the blocked variant is only instantiated for the sizes it accepts
+		static bool sSolve(Matrix &ioA, Matrix &ioB, std::true_type) { return GaussianEliminationBlocked(ioA, ioB); }
+		static bool sSolve(Matrix &ioA, Matrix &ioB, std::false_type) { return GaussianElimination(ioA, ioB); }
 	};
 
 	/// Specialization of SetInversed for 2x2 matrix
@@ -262,4 +272,54 @@ namespace topia
 		return true;
 	}
 
+	/// Specialization of SetInversed for 3x3 matrix
+	template <>
+	inline bool Matrix<3, 3>::SetInversed(const Matrix<3, 3> &inM)
+	{
+		// Fetch elements
+		const float a = inM.mCol[0].mF32[0], b = inM.mCol[1].mF32[0], c = inM.mCol[2].mF32[0];
+		const float d = inM.mCol[0].mF32[1], e = inM.mCol[1].mF32[1], f = inM.mCol[2].mF32[1];
+		const float g = inM.mCol[0].mF32[2], h = inM.mCol[1].mF32[2], i = inM.mCol[2].mF32[2];
+
+		// Cofactors of the first row
+		const float A = e * i - f * h;
+		const float B = f * g - d * i;
+		const float C = d * h - e * g;
+
+		// Calculate determinant
+		float det = a * A + b * B + c * C;
+		if (det == 0.0f)
+			return false;
+		float inv_det = 1.0f / det;
+
+		// Construct inverse (transposed cofactor matrix divided by the determinant)
+		mCol[0].mF32[0] = A * inv_det;
+		mCol[0].mF32[1] = B * inv_det;
+		mCol[0].mF32[2] = C * inv_det;
+		mCol[1].mF32[0] = (c * h - b * i) * inv_det;
+		mCol[1].mF32[1] = (a * i - c * g) * inv_det;
+		mCol[1].mF32[2] = (b * g - a * h) * inv_det;
+		mCol[2].mF32[0] = (b * f - c * e) * inv_det;
+		mCol[2].mF32[1] = (c * d - a * f) * inv_det;
+		mCol[2].mF32[2] = (a * e - b * d) * inv_det;
+		return true;
+	}
+
+	/// Specialization of SetInversed for 4x4 matrix, uses the SIMD inverse of Mat44
+	template <>
+	inline bool Matrix<4, 4>::SetInversed(const Matrix<4, 4> &inM)
+	{
+		Mat44 m = Mat44::sLoadFloat4x4(reinterpret_cast<const Float4 *>(inM.mCol[0].mF32)).Inversed();
+
+		// A singular matrix results in a division by zero, which makes one of the elements infinite or NaN
+		UVec4 finite = UVec4::sReplicate(0xffffffff);
+		for (uint c = 0; c < 4; ++c)
+		{
+			Vec4 col = m.GetColumn4(c);
+			finite = UVec4::sAnd(finite, Vec4::sEquals(col * 0.0f, Vec4::sZero()));
+			col.StoreFloat4(reinterpret_cast<Float4 *>(mCol[c].mF32));
+		}
+		return finite.TestAllTrue();
+	}
+
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "AABox.h"
+
+namespace topia
+{
+	/// Oriented box, a box with half size mHalfExtents centered at the translation of mOrientation and rotated by its 3x3 part
+	class TOPIA_NODISCARD OrientedBox
+	{
+	public:
+		OrientedBox() = default;
+		OrientedBox(Mat44Arg inOrientation, Vec3Arg inHalfExtents) : mOrientation(inOrientation), mHalfExtents(inHalfExtents) {}
+
+		/// Construct from axis aligned box and transform. Only works for a rotation + translation matrix, for scaled matrices use AABox::Transformed.
+		OrientedBox(Mat44Arg inOrientation, const AABox &inBox) : mOrientation(inOrientation * Mat44::sTranslation(inBox.GetCenter())), mHalfExtents(inBox.GetExtent()) {}
+
+		/// Get the axis aligned box that encloses this box
+		AABox GetAABox() const { return AABox(-mHalfExtents, mHalfExtents).Transformed(mOrientation); }
+
+		/// Test if a point is inside the box
+		bool Contains(Vec3Arg inPoint) const
+		{
+			const Vec3 local = mOrientation.Multiply3x3Transposed(inPoint - mOrientation.GetTranslation());
+			return Vec3::sLessOrEqual(local.Abs(), mHalfExtents).TestAllXYZTrue();
+		}
+
+		/// Test if this box overlaps inBox, using the separating axis test with the 15 candidate axis.
+		/// @see Real-Time Collision Detection - Christer Ericson, chapter 4.4.1.
+		/// inEpsilon is added to the absolute rotation terms to make the test robust against (nearly) parallel edges whose cross products are degenerate.
+		bool Overlaps(const OrientedBox &inBox, float inEpsilon = 1.0e-6f) const
+		{
+			// Rotation of inBox expressed in our frame and the translation between the boxes in our frame
+			const Mat44 rotation = mOrientation.Multiply3x3LeftTransposed(inBox.mOrientation);
+			const Vec3 translation = mOrientation.Multiply3x3Transposed(inBox.mOrientation.GetTranslation() - mOrientation.GetTranslation());
+
+			float r[3][3], abs_r[3][3];
+			for (uint i = 0; i < 3; ++i)
+				for (uint j = 0; j < 3; ++j)
+				{
+					r[i][j] = rotation(i, j);
+					abs_r[i][j] = abs(r[i][j]) + inEpsilon;
+				}
+
+			const Vec3 &a = mHalfExtents, &b = inBox.mHalfExtents;
+			const float t[3] = { translation.GetX(), translation.GetY(), translation.GetZ() };
+
+			// Our axis
+			for (uint i = 0; i < 3; ++i)
+				if (abs(t[i]) > a[i] + b[0] * abs_r[i][0] + b[1] * abs_r[i][1] + b[2] * abs_r[i][2])
+					return false;
+
+			// Axis of inBox
+			for (uint j = 0; j < 3; ++j)
+				if (abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > a[0] * abs_r[0][j] + a[1] * abs_r[1][j] + a[2] * abs_r[2][j] + b[j])
+					return false;
+
+			// Cross products of our axis i with axis j of inBox
+			for (uint i = 0; i < 3; ++i)
+			{
+				const uint i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+				for (uint j = 0; j < 3; ++j)
+				{
+					const uint j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+					const float ra = a[i1] * abs_r[i2][j] + a[i2] * abs_r[i1][j];
+					const float rb = b[j1] * abs_r[i][j2] + b[j2] * abs_r[i][j1];
+					if (abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		/// Test if this box overlaps an axis aligned box
+		bool Overlaps(const AABox &inBox, float inEpsilon = 1.0e-6f) const { return Overlaps(OrientedBox(Mat44::sTranslation(inBox.GetCenter()), inBox.GetExtent()), inEpsilon); }
+
+		/// Transform the box by a rotation + translation matrix
+		OrientedBox Transformed(Mat44Arg inMatrix) const { return OrientedBox(inMatrix * mOrientation, mHalfExtents); }
+
+		Mat44 mOrientation; ///< Rotation and translation (center) of the box
+		Vec3 mHalfExtents; ///< Half the size of the box along its local axis
+	};
+} // namespace topia
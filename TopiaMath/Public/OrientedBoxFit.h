@@ -0,0 +1,17 @@
+#pragma once
+
+#include "TopiaMath.h"
+#include "OrientedBox.h"
+
+namespace topia
+{
+	/// Fit an oriented bounding box to each of inNumSets point sets, the box axis are the eigen vectors of the covariance matrix of the points.
+	/// Point set i consists of inPoints[inOffsets[i]] .. inPoints[inOffsets[i + 1] - 1], so inOffsets must contain inNumSets + 1 entries.
+	/// The covariance matrices are decomposed 8 at a time with EigenValueSymmetric3x3x8.
+	/// @param outOrientations receives for every set a rotation matrix with the center of the box as translation
+	/// @param outHalfExtents receives for every set the half size of the box along its local axis
+	void FitOrientedBoxes(const Vec3 *inPoints, const u32 *inOffsets, uint inNumSets, Mat44 *outOrientations, Vec3 *outHalfExtents);
+
+	/// Same as above, but outputs OrientedBox
+	void FitOrientedBoxes(const Vec3 *inPoints, const u32 *inOffsets, uint inNumSets, OrientedBox *outBoxes);
+} // namespace topia
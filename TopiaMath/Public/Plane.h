@@ -0,0 +1,72 @@
+#pragma once
+
+#include "AABox.h"
+
+namespace topia
+{
+	/// An infinite plane described by the formula X . Normal + Constant = 0.
+	/// The normal points to the positive side, the distance of a point to the plane is positive on that side.
+	class TOPIA_NODISCARD Plane
+	{
+	public:
+		Plane() = default;
+		explicit Plane(Vec4Arg inNormalAndConstant) : mNormalAndConstant(inNormalAndConstant) {}
+		Plane(Vec3Arg inNormal, float inConstant) : mNormalAndConstant(inNormal, inConstant) {}
+
+		/// Create from point and normal
+		static Plane sFromPointAndNormal(Vec3Arg inPoint, Vec3Arg inNormal) { return Plane(Vec4(inNormal, -inNormal.Dot(inPoint))); }
+
+		/// Create from 3 counter clockwise points
+		static Plane sFromPointsCCW(Vec3Arg inV1, Vec3Arg inV2, Vec3Arg inV3) { return sFromPointAndNormal(inV1, (inV2 - inV1).Cross(inV3 - inV1).Normalized()); }
+
+		/// Normal
+		Vec3 GetNormal() const { return Vec3(mNormalAndConstant); }
+		void SetNormal(Vec3Arg inNormal) { mNormalAndConstant = Vec4(inNormal, mNormalAndConstant.GetW()); }
+
+		/// Constant
+		float GetConstant() const { return mNormalAndConstant.GetW(); }
+		void SetConstant(float inConstant) { mNormalAndConstant.SetW(inConstant); }
+
+		/// Store as 4 floats
+		Vec4 GetNormalAndConstant() const { return mNormalAndConstant; }
+
+		/// Rescale the plane so that the normal has unit length, needed for planes that are extracted from a projection matrix
+		Plane Normalized() const { return Plane(mNormalAndConstant / GetNormal().Length()); }
+
+		/// Offset the plane (positive value means move it in the direction of the plane normal)
+		Plane Offset(float inDistance) const { return Plane(mNormalAndConstant - Vec4(Vec3::sZero(), inDistance)); }
+
+		/// Transform the plane by a rigid transform (rotation and translation only). The normal is transformed with the 3x3 part,
+		/// which is only correct when that part is orthonormal: a non-uniform scale needs the inverse transpose, use Scaled for the scale.
+		Plane Transformed(Mat44Arg inTransform) const
+		{
+			const Vec3 transformed_normal = inTransform.Multiply3x3(GetNormal());
+			return Plane(transformed_normal, GetConstant() - inTransform.GetTranslation().Dot(transformed_normal));
+		}
+
+		/// Scale the plane, can handle non-uniform and negative scaling
+		Plane Scaled(Vec3Arg inScale) const
+		{
+			const Vec3 scaled_normal = GetNormal() / inScale;
+			const float scaled_normal_length = scaled_normal.Length();
+			return Plane(scaled_normal / scaled_normal_length, GetConstant() / scaled_normal_length);
+		}
+
+		/// Distance point to plane
+		float SignedDistance(Vec3Arg inPoint) const { return inPoint.Dot(GetNormal()) + GetConstant(); }
+
+		/// Project inPoint onto the plane
+		Vec3 ProjectPointOnPlane(Vec3Arg inPoint) const { return inPoint - GetNormal() * SignedDistance(inPoint); }
+
+		/// Signed distance of the box vertex that is furthest in the direction of the normal.
+		/// When this is negative the whole box is on the negative side of the plane.
+		float GetMaxSignedDistance(const AABox &inBox) const { return SignedDistance(inBox.GetSupport(GetNormal())); }
+
+		/// Signed distance of the box vertex that is furthest against the direction of the normal.
+		/// When this is positive the whole box is on the positive side of the plane.
+		float GetMinSignedDistance(const AABox &inBox) const { return SignedDistance(inBox.GetSupport(-GetNormal())); }
+
+	private:
+		Vec4 mNormalAndConstant; ///< XYZ = normal, W = constant, plane: x . normal + constant = 0
+	};
+} // namespace topia
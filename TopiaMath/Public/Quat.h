@@ -2,6 +2,7 @@
 
 #include "Vec3.h"
 #include "Vec4.h"
+#include "Trigonometry.h"
 
 namespace topia
 {
@@ -192,7 +193,7 @@ namespace topia
 		/// q(axis, angle) = [cos(angle / 2), axis * sin(angle / 2)])
 		TOPIA_INLINE float GetRotationAngle(Vec3Arg inAxis) const
 		{
-			return GetW() == 0.0f ? TOPIA_PI : 2.0f * atan(GetXYZ().Dot(inAxis) / GetW());
+			return GetW() == 0.0f ? TOPIA_PI : 2.0f * ATan(GetXYZ().Dot(inAxis) / GetW());
 		}
 
 		/// Swing Twist Decomposition: any quaternion can be split up as:
@@ -71,7 +71,7 @@ namespace topia
 	{
 		ASSERT(inAxis.IsNormalized());
 		float half_angle = 0.5f * inAngle;
-		return Quat(Vec4(inAxis * sin(half_angle), cos(half_angle)));
+		return Quat(Vec4(inAxis * Sin(half_angle), Cos(half_angle)));
 	}
 
 	void Quat::GetAxisAngle(Vec3& outAxis, float& outAngle) const
@@ -86,7 +86,7 @@ namespace topia
 		}
 		else
 		{
-			outAngle = 2.0f * acos(abs_w);
+			outAngle = 2.0f * ACos(abs_w);
 			outAxis = w_pos.GetXYZ().NormalizedOr(Vec3::sZero());
 		}
 	}
@@ -141,7 +141,7 @@ namespace topia
 		float r1 = sqrt(1.0f - x0), r2 = sqrt(x0);
 		std::uniform_real_distribution<float> zero_to_two_pi(0.0f, 2.0f * TOPIA_PI);
 		float t1 = zero_to_two_pi(inRandom), t2 = zero_to_two_pi(inRandom);
-		return Quat(sin(t1) * r1, cos(t1) * r1, sin(t2) * r2, cos(t2) * r2);
+		return Quat(Sin(t1) * r1, Cos(t1) * r1, Sin(t2) * r2, Cos(t2) * r2);
 	}
 
 	Quat Quat::sEulerAngles(Vec3Arg inAngles)
@@ -151,12 +151,12 @@ namespace topia
 		float y = half.GetY();
 		float z = half.GetZ();
 
-		float cx = cos(x);
-		float sx = sin(x);
-		float cy = cos(y);
-		float sy = sin(y);
-		float cz = cos(z);
-		float sz = sin(z);
+		float cx = Cos(x);
+		float sx = Sin(x);
+		float cy = Cos(y);
+		float sy = Sin(y);
+		float cz = Cos(z);
+		float sz = Sin(z);
 
 		return Quat(cz * sx * cy - sz * cx * sy, cz * cx * sy + sz * sx * cy, sz * cx * cy - cz * sx * sy,
 		            cz * cx * cy + sz * sx * sy);
@@ -179,7 +179,7 @@ namespace topia
 		float t3 = 2.0f * (GetW() * GetZ() + GetX() * GetY());
 		float t4 = 1.0f - 2.0f * (y_sq + GetZ() * GetZ());
 
-		return Vec3(atan2(t0, t1), asin(t2), atan2(t3, t4));
+		return Vec3(ATan2(t0, t1), ASin(t2), ATan2(t3, t4));
 	}
 
 	Quat Quat::GetTwist(Vec3Arg inAxis) const
@@ -236,10 +236,10 @@ namespace topia
 		if (1.0f - cos_omega > delta)
 		{
 			// Standard case (slerp)
-			float omega = acos(cos_omega);
-			float sin_omega = sin(omega);
-			scale0 = sin((1.0f - inFraction) * omega) / sin_omega;
-			scale1 = sign_scale1 * sin(inFraction * omega) / sin_omega;
+			float omega = ACos(cos_omega);
+			float sin_omega = Sin(omega);
+			scale0 = Sin((1.0f - inFraction) * omega) / sin_omega;
+			scale1 = sign_scale1 * Sin(inFraction * omega) / sin_omega;
 		}
 		else
 		{
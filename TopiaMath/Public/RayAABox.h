@@ -0,0 +1,97 @@
+#pragma once
+
+#include "AABox.h"
+
+namespace topia
+{
+	/// Helper structure holding the reciprocal of a ray direction for ray vs box (slab) tests
+	class TOPIA_NODISCARD RayInvDirection
+	{
+	public:
+		RayInvDirection() = default;
+		explicit RayInvDirection(Vec3Arg inDirection) { Set(inDirection); }
+
+		/// Set reciprocal from ray direction
+		void Set(Vec3Arg inDirection)
+		{
+			// If the ray is parallel to an axis, the slab test for that axis only checks if the origin lies between the planes
+			mIsParallel = Vec3::sLessOrEqual(inDirection.Abs(), Vec3::sReplicate(1.0e-20f));
+
+			// Calculate the reciprocal of the direction, replacing the parallel components with 1 to avoid dividing by 0
+			mInvDirection = Vec3::sSelect(inDirection, Vec3::sReplicate(1.0f), mIsParallel).Reciprocal();
+		}
+
+		Vec3 mInvDirection; ///< 1 / ray direction
+		UVec4 mIsParallel; ///< for each component if it is parallel to the coordinate axis
+	};
+
+	/// Intersect a ray with a box.
+	/// @return The fraction along the ray where the ray enters the box (negative when the origin is inside the box), or FLT_MAX when there is no hit
+	TOPIA_INLINE float RayAABox(Vec3Arg inOrigin, const RayInvDirection &inInvDirection, Vec3Arg inBoundsMin, Vec3Arg inBoundsMax)
+	{
+		const Vec3 flt_min = Vec3::sReplicate(-std::numeric_limits<float>::max());
+		const Vec3 flt_max = Vec3::sReplicate(std::numeric_limits<float>::max());
+
+		// Test against all three axis simultaneously
+		const Vec3 t1 = (inBoundsMin - inOrigin) * inInvDirection.mInvDirection;
+		const Vec3 t2 = (inBoundsMax - inOrigin) * inInvDirection.mInvDirection;
+
+		// Compute the max of min(t1, t2) and the min of max(t1, t2) ignoring the axis that the ray is parallel to
+		const Vec3 t_min = Vec3::sSelect(Vec3::sMin(t1, t2), flt_min, inInvDirection.mIsParallel);
+		const Vec3 t_max = Vec3::sSelect(Vec3::sMax(t1, t2), flt_max, inInvDirection.mIsParallel);
+		const float t_enter = t_min.ReduceMax();
+		const float t_exit = t_max.ReduceMin();
+
+		// Miss when the slabs don't overlap, the box is behind the ray or the ray is parallel to a slab it doesn't start in
+		const UVec4 outside_parallel = UVec4::sAnd(inInvDirection.mIsParallel, UVec4::sOr(Vec3::sLess(inOrigin, inBoundsMin), Vec3::sGreater(inOrigin, inBoundsMax)));
+		if (t_enter > t_exit || t_exit < 0.0f || outside_parallel.TestAnyXYZTrue())
+			return std::numeric_limits<float>::max();
+		return t_enter;
+	}
+
+	/// Intersect a ray with 4 boxes (structure of arrays, lane i of inBoundsMinX .. inBoundsMaxZ is box i).
+	/// @return Per box the fraction along the ray where the ray enters the box (negative when the origin is inside the box), or FLT_MAX when there is no hit.
+	/// Invalid boxes (min > max) never hit.
+	TOPIA_INLINE Vec4 RayAABox4(Vec3Arg inOrigin, const RayInvDirection &inInvDirection, Vec4Arg inBoundsMinX, Vec4Arg inBoundsMinY, Vec4Arg inBoundsMinZ, Vec4Arg inBoundsMaxX, Vec4Arg inBoundsMaxY, Vec4Arg inBoundsMaxZ)
+	{
+		const Vec4 flt_min = Vec4::sReplicate(-std::numeric_limits<float>::max());
+		const Vec4 flt_max = Vec4::sReplicate(std::numeric_limits<float>::max());
+
+		// Splat the ray
+		const Vec4 originx = inOrigin.SplatX(), originy = inOrigin.SplatY(), originz = inOrigin.SplatZ();
+		const UVec4 parallelx = inInvDirection.mIsParallel.SplatX(), parallely = inInvDirection.mIsParallel.SplatY(), parallelz = inInvDirection.mIsParallel.SplatZ();
+		const Vec4 invdirx = inInvDirection.mInvDirection.SplatX(), invdiry = inInvDirection.mInvDirection.SplatY(), invdirz = inInvDirection.mInvDirection.SplatZ();
+
+		// Slab distances per axis
+		const Vec4 t1x = (inBoundsMinX - originx) * invdirx;
+		const Vec4 t1y = (inBoundsMinY - originy) * invdiry;
+		const Vec4 t1z = (inBoundsMinZ - originz) * invdirz;
+		const Vec4 t2x = (inBoundsMaxX - originx) * invdirx;
+		const Vec4 t2y = (inBoundsMaxY - originy) * invdiry;
+		const Vec4 t2z = (inBoundsMaxZ - originz) * invdirz;
+
+		// Compute the max of min(t1, t2) and the min of max(t1, t2) ignoring the axis that the ray is parallel to
+		const Vec4 t_min = Vec4::sMax(Vec4::sMax(
+			Vec4::sSelect(Vec4::sMin(t1x, t2x), flt_min, parallelx),
+			Vec4::sSelect(Vec4::sMin(t1y, t2y), flt_min, parallely)),
+			Vec4::sSelect(Vec4::sMin(t1z, t2z), flt_min, parallelz));
+		const Vec4 t_max = Vec4::sMin(Vec4::sMin(
+			Vec4::sSelect(Vec4::sMax(t1x, t2x), flt_max, parallelx),
+			Vec4::sSelect(Vec4::sMax(t1y, t2y), flt_max, parallely)),
+			Vec4::sSelect(Vec4::sMax(t1z, t2z), flt_max, parallelz));
+
+		// Miss when the slabs don't overlap or the box is behind the ray
+		UVec4 no_intersection = UVec4::sOr(Vec4::sGreater(t_min, t_max), Vec4::sLess(t_max, Vec4::sZero()));
+
+		// Miss when the box is invalid
+		no_intersection = UVec4::sOr(no_intersection, UVec4::sOr(UVec4::sOr(Vec4::sGreater(inBoundsMinX, inBoundsMaxX), Vec4::sGreater(inBoundsMinY, inBoundsMaxY)), Vec4::sGreater(inBoundsMinZ, inBoundsMaxZ)));
+
+		// Miss when the ray is parallel to a slab and doesn't start inside it
+		const UVec4 no_parallel_overlapx = UVec4::sAnd(parallelx, UVec4::sOr(Vec4::sLess(originx, inBoundsMinX), Vec4::sGreater(originx, inBoundsMaxX)));
+		const UVec4 no_parallel_overlapy = UVec4::sAnd(parallely, UVec4::sOr(Vec4::sLess(originy, inBoundsMinY), Vec4::sGreater(originy, inBoundsMaxY)));
+		const UVec4 no_parallel_overlapz = UVec4::sAnd(parallelz, UVec4::sOr(Vec4::sLess(originz, inBoundsMinZ), Vec4::sGreater(originz, inBoundsMaxZ)));
+		no_intersection = UVec4::sOr(no_intersection, UVec4::sOr(UVec4::sOr(no_parallel_overlapx, no_parallel_overlapy), no_parallel_overlapz));
+
+		return Vec4::sSelect(t_min, flt_max, no_intersection);
+	}
+} // namespace topia
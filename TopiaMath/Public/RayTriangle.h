@@ -0,0 +1,140 @@
+#pragma once
+
+#include "TopiaMath.h"
+
+namespace topia
+{
+	/// Ray prepared for the watertight ray vs triangle test (Woop, Benthin, Wald - Watertight Ray/Triangle Intersection, 2013).
+	///
+	/// The triangle is transformed into a space where the ray starts at the origin and points along +z, the hit test then only needs the
+	/// 2D edge functions of the triangle. Every vertex is transformed the same way regardless of the triangle it belongs to, so two
+	/// triangles that share an edge compute the same edge function with opposite sign and a ray can't slip through the edge.
+	/// A ray that hits an edge or vertex exactly is reported as a hit for all triangles sharing it.
+	class TOPIA_NODISCARD WatertightRay
+	{
+	public:
+		WatertightRay() = default;
+		WatertightRay(Vec3Arg inOrigin, Vec3Arg inDirection) { Set(inOrigin, inDirection); }
+
+		/// Set the ray, the hit fraction of the intersection tests is relative to inDirection (hit point = inOrigin + fraction * inDirection)
+		void Set(Vec3Arg inOrigin, Vec3Arg inDirection)
+		{
+			mOrigin = inOrigin;
+
+			// The largest direction component becomes z, swap x and y when it is negative to preserve the winding of the triangle
+			mAxisZ = uint(inDirection.Abs().GetHighestComponentIndex());
+			mAxisX = mAxisZ == 2? 0 : mAxisZ + 1;
+			mAxisY = mAxisX == 2? 0 : mAxisX + 1;
+			if (inDirection[mAxisZ] < 0.0f)
+				std::swap(mAxisX, mAxisY);
+
+			// Shear that maps the direction onto (0, 0, 1)
+			mShearZ = 1.0f / inDirection[mAxisZ];
+			mShearX = inDirection[mAxisX] * mShearZ;
+			mShearY = inDirection[mAxisY] * mShearZ;
+		}
+
+		Vec3 mOrigin;
+		uint mAxisX; ///< Component of the direction that maps to x
+		uint mAxisY; ///< Component of the direction that maps to y
+		uint mAxisZ; ///< Component of the direction with the largest absolute value
+		float mShearX;
+		float mShearY;
+		float mShearZ;
+	};
+
+	/// 4 triangles stored as structure of arrays, lane i is triangle i. Unused lanes should contain a degenerate triangle (e.g. all zeros), which is never hit.
+	class TriangleBlock4
+	{
+	public:
+		/// Set lane inLane to triangle inV0, inV1, inV2
+		void SetTriangle(uint inLane, Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2)
+		{
+			mV0X[inLane] = inV0.GetX(); mV0Y[inLane] = inV0.GetY(); mV0Z[inLane] = inV0.GetZ();
+			mV1X[inLane] = inV1.GetX(); mV1Y[inLane] = inV1.GetY(); mV1Z[inLane] = inV1.GetZ();
+			mV2X[inLane] = inV2.GetX(); mV2Y[inLane] = inV2.GetY(); mV2Z[inLane] = inV2.GetZ();
+		}
+
+		Vec4 mV0X, mV0Y, mV0Z;
+		Vec4 mV1X, mV1Y, mV1Z;
+		Vec4 mV2X, mV2Y, mV2Z;
+	};
+
+	/// Intersect a ray with a triangle, both sides of the triangle are hit.
+	/// The optional outU and outV receive the barycentric coordinates of the hit: hit = inV0 + u * (inV1 - inV0) + v * (inV2 - inV0).
+	/// @return The fraction along the ray of the hit (>= 0), or FLT_MAX when there is no hit
+	TOPIA_INLINE float RayTriangle(const WatertightRay &inRay, Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2, float *outU = nullptr, float *outV = nullptr)
+	{
+		// Transpose the vertices relative to the ray origin so that component i of every vertex is in column i.
+		// Working on vectors instead of floats also keeps the compiler from contracting the edge functions into fused multiply adds,
+		// which would break watertightness, and gives exactly the same results as RayTriangle4 / RayTriangle8.
+		const Mat44 components = Mat44(Vec4(inV0 - inRay.mOrigin, 0), Vec4(inV1 - inRay.mOrigin, 0), Vec4(inV2 - inRay.mOrigin, 0), Vec4::sZero()).Transposed();
+
+		// Shear the vertices
+		const Vec4 z = components.GetColumn4(inRay.mAxisZ);
+		const Vec4 x = components.GetColumn4(inRay.mAxisX) - Vec4::sReplicate(inRay.mShearX) * z;
+		const Vec4 y = components.GetColumn4(inRay.mAxisY) - Vec4::sReplicate(inRay.mShearY) * z;
+
+		// Edge functions (u, v, w), the ray misses when they don't all have the same sign
+		const Vec4 uvw = x.Swizzle<SWIZZLE_Z, SWIZZLE_X, SWIZZLE_Y, SWIZZLE_W>() * y.Swizzle<SWIZZLE_Y, SWIZZLE_Z, SWIZZLE_X, SWIZZLE_W>()
+			- y.Swizzle<SWIZZLE_Z, SWIZZLE_X, SWIZZLE_Y, SWIZZLE_W>() * x.Swizzle<SWIZZLE_Y, SWIZZLE_Z, SWIZZLE_X, SWIZZLE_W>();
+		const Vec4 zero = Vec4::sZero();
+		if (Vec4::sLess(uvw, zero).TestAnyXYZTrue() && Vec4::sGreater(uvw, zero).TestAnyXYZTrue())
+			return std::numeric_limits<float>::max();
+
+		// A triangle seen edge on has determinant 0
+		const float det = uvw.GetX() + uvw.GetY() + uvw.GetZ();
+		if (det == 0.0f)
+			return std::numeric_limits<float>::max();
+
+		// Scaled hit distance, miss when the triangle is behind the ray
+		const Vec4 weighted_z = uvw * z;
+		const float t = (weighted_z.GetX() + weighted_z.GetY() + weighted_z.GetZ()) * inRay.mShearZ;
+		if ((det > 0.0f? t : -t) < 0.0f)
+			return std::numeric_limits<float>::max();
+
+		if (outU != nullptr)
+			*outU = uvw.GetY() / det;
+		if (outV != nullptr)
+			*outV = uvw.GetZ() / det;
+		return t / det;
+	}
+
+	/// Intersect a ray with 4 triangles, both sides of the triangles are hit.
+	/// @return Per triangle the fraction along the ray of the hit (>= 0), or FLT_MAX when there is no hit
+	TOPIA_INLINE Vec4 RayTriangle4(const WatertightRay &inRay, const TriangleBlock4 &inTriangles)
+	{
+		// Per axis the x, y and z components of the vertices relative to the ray origin
+		const Vec4 origin[3] = { inRay.mOrigin.SplatX(), inRay.mOrigin.SplatY(), inRay.mOrigin.SplatZ() };
+		const Vec4 a[3] = { inTriangles.mV0X - origin[0], inTriangles.mV0Y - origin[1], inTriangles.mV0Z - origin[2] };
+		const Vec4 b[3] = { inTriangles.mV1X - origin[0], inTriangles.mV1Y - origin[1], inTriangles.mV1Z - origin[2] };
+		const Vec4 c[3] = { inTriangles.mV2X - origin[0], inTriangles.mV2Y - origin[1], inTriangles.mV2Z - origin[2] };
+
+		// Shear and scale the vertices
+		const Vec4 shear_x = Vec4::sReplicate(inRay.mShearX), shear_y = Vec4::sReplicate(inRay.mShearY);
+		const Vec4 az = a[inRay.mAxisZ], bz = b[inRay.mAxisZ], cz = c[inRay.mAxisZ];
+		const Vec4 ax = a[inRay.mAxisX] - shear_x * az, ay = a[inRay.mAxisY] - shear_y * az;
+		const Vec4 bx = b[inRay.mAxisX] - shear_x * bz, by = b[inRay.mAxisY] - shear_y * bz;
+		const Vec4 cx = c[inRay.mAxisX] - shear_x * cz, cy = c[inRay.mAxisY] - shear_y * cz;
+
+		// Edge functions, the ray misses when they don't all have the same sign
+		const Vec4 zero = Vec4::sZero();
+		const Vec4 u = cx * by - cy * bx;
+		const Vec4 v = ax * cy - ay * cx;
+		const Vec4 w = bx * ay - by * ax;
+		const UVec4 any_negative = UVec4::sOr(UVec4::sOr(Vec4::sLess(u, zero), Vec4::sLess(v, zero)), Vec4::sLess(w, zero));
+		const UVec4 any_positive = UVec4::sOr(UVec4::sOr(Vec4::sGreater(u, zero), Vec4::sGreater(v, zero)), Vec4::sGreater(w, zero));
+		UVec4 miss = UVec4::sAnd(any_negative, any_positive);
+
+		// Triangles seen edge on have determinant 0
+		const Vec4 det = u + v + w;
+		miss = UVec4::sOr(miss, Vec4::sEquals(det, zero));
+
+		// Scaled hit distance, miss when the triangle is behind the ray
+		const Vec4 t = (u * az + v * bz + w * cz) * Vec4::sReplicate(inRay.mShearZ);
+		const Vec4 t_times_sign = Vec4::sXor(t, Vec4::sAnd(det, Vec4::sReplicate(-0.0f)));
+		miss = UVec4::sOr(miss, Vec4::sLess(t_times_sign, zero));
+
+		return Vec4::sSelect(t / det, Vec4::sReplicate(std::numeric_limits<float>::max()), miss);
+	}
+} // namespace topia
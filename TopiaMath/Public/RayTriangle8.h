@@ -0,0 +1,188 @@
+#pragma once
+
+#include <Topia.h>
+#include "RayTriangle.h"
+#include "Vec8.h"
+#include "UVec8.h"
+
+namespace topia
+{
+	// 8-wide versions of RayTriangle: one ray against 8 triangles (e.g. a leaf of a BVH) and 8 rays against one triangle (e.g. a packet of
+	// coherent primary or baking rays). They compute exactly the same edge functions as RayTriangle, so they are just as watertight.
+
+	/// Lane value returned by RayTriangle8Closest when nothing closer was hit
+	constexpr uint cNoTriangleHit = 8;
+
+	/// 8 triangles stored as structure of arrays, lane i is triangle i. Unused lanes should contain a degenerate triangle (e.g. all zeros), which is never hit.
+	class TriangleBlock8
+	{
+	public:
+		/// Set lane inLane to triangle inV0, inV1, inV2
+		void SetTriangle(uint inLane, Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2)
+		{
+			mV0X[inLane] = inV0.GetX(); mV0Y[inLane] = inV0.GetY(); mV0Z[inLane] = inV0.GetZ();
+			mV1X[inLane] = inV1.GetX(); mV1Y[inLane] = inV1.GetY(); mV1Z[inLane] = inV1.GetZ();
+			mV2X[inLane] = inV2.GetX(); mV2Y[inLane] = inV2.GetY(); mV2Z[inLane] = inV2.GetZ();
+		}
+
+		Vec8 mV0X, mV0Y, mV0Z;
+		Vec8 mV1X, mV1Y, mV1Z;
+		Vec8 mV2X, mV2Y, mV2Z;
+	};
+
+	/// 8 rays prepared for RayTriangle8, lane i is ray i. Every ray can have its own axis permutation.
+	class TOPIA_NODISCARD WatertightRay8
+	{
+	public:
+		WatertightRay8() = default;
+
+		/// Set from 8 prepared rays
+		explicit WatertightRay8(const WatertightRay *inRays)
+		{
+			mAxisX = inRays[0].mAxisX;
+			mAxisY = inRays[0].mAxisY;
+			mAxisZ = inRays[0].mAxisZ;
+			mSameAxis = true;
+			for (uint i = 0; i < 8; ++i)
+			{
+				const WatertightRay &ray = inRays[i];
+				mOriginX[i] = ray.mOrigin.GetX();
+				mOriginY[i] = ray.mOrigin.GetY();
+				mOriginZ[i] = ray.mOrigin.GetZ();
+				const uint axis[3] = { ray.mAxisX, ray.mAxisY, ray.mAxisZ };
+				for (uint j = 0; j < 3; ++j)
+				{
+					mAxisIsY[j][i] = axis[j] == 1? 0xffffffff : 0;
+					mAxisIsZ[j][i] = axis[j] == 2? 0xffffffff : 0;
+				}
+				mShearX[i] = ray.mShearX;
+				mShearY[i] = ray.mShearY;
+				mShearZ[i] = ray.mShearZ;
+				mSameAxis &= ray.mAxisX == mAxisX && ray.mAxisY == mAxisY && ray.mAxisZ == mAxisZ;
+			}
+		}
+
+		/// Get the component of inV (x, y, z) that maps to inAxis (0 = x, 1 = y, 2 = z) in ray space per lane
+		TOPIA_INLINE Vec8 Permute(uint inAxis, const Vec8 *inV) const
+		{
+			return Vec8::sSelect(Vec8::sSelect(inV[0], inV[1], mAxisIsY[inAxis]), inV[2], mAxisIsZ[inAxis]);
+		}
+
+		Vec8 mOriginX, mOriginY, mOriginZ;
+		UVec8 mAxisIsY[3]; ///< Per ray space axis the lanes where it comes from y
+		UVec8 mAxisIsZ[3]; ///< Per ray space axis the lanes where it comes from z
+		Vec8 mShearX, mShearY, mShearZ;
+		uint mAxisX; ///< Axis permutation of the first ray
+		uint mAxisY;
+		uint mAxisZ;
+		bool mSameAxis; ///< If all rays have the same axis permutation (e.g. a coherent packet), RayTriangle8 then skips the per lane permutation
+	};
+
+	namespace detail
+	{
+		/// Shared tail of the 8-wide tests: from the sheared vertices to the hit fraction (FLT_MAX for a miss)
+		TOPIA_INLINE Vec8 sRayTriangle8(Vec8Arg inAX, Vec8Arg inAY, Vec8Arg inAZ, Vec8Arg inBX, Vec8Arg inBY, Vec8Arg inBZ, Vec8Arg inCX, Vec8Arg inCY, Vec8Arg inCZ, Vec8Arg inShearZ)
+		{
+			// Edge functions, the ray misses when they don't all have the same sign
+			const Vec8 zero = Vec8::sZero();
+			const Vec8 u = inCX * inBY - inCY * inBX;
+			const Vec8 v = inAX * inCY - inAY * inCX;
+			const Vec8 w = inBX * inAY - inBY * inAX;
+			const UVec8 any_negative = UVec8::sOr(UVec8::sOr(Vec8::sLess(u, zero), Vec8::sLess(v, zero)), Vec8::sLess(w, zero));
+			const UVec8 any_positive = UVec8::sOr(UVec8::sOr(Vec8::sGreater(u, zero), Vec8::sGreater(v, zero)), Vec8::sGreater(w, zero));
+			UVec8 miss = UVec8::sAnd(any_negative, any_positive);
+
+			// Triangles seen edge on have determinant 0
+			const Vec8 det = u + v + w;
+			miss = UVec8::sOr(miss, Vec8::sEquals(det, zero));
+
+			// Scaled hit distance, miss when the triangle is behind the ray (t and det have a different sign)
+			const Vec8 t = (u * inAZ + v * inBZ + w * inCZ) * inShearZ;
+			const UVec8 behind = UVec8::sOr(UVec8::sAnd(Vec8::sLess(t, zero), Vec8::sGreater(det, zero)), UVec8::sAnd(Vec8::sGreater(t, zero), Vec8::sLess(det, zero)));
+			miss = UVec8::sOr(miss, behind);
+
+			return Vec8::sSelect(t / det, Vec8::sReplicate(std::numeric_limits<float>::max()), miss);
+		}
+	} // namespace detail
+
+	/// Intersect one ray with 8 triangles, both sides of the triangles are hit.
+	/// @return Per triangle the fraction along the ray of the hit (>= 0), or FLT_MAX when there is no hit
+	TOPIA_INLINE Vec8 RayTriangle8(const WatertightRay &inRay, const TriangleBlock8 &inTriangles)
+	{
+		// Per axis the x, y and z components of the vertices relative to the ray origin
+		const Vec8 origin[3] = { Vec8::sReplicate(inRay.mOrigin.GetX()), Vec8::sReplicate(inRay.mOrigin.GetY()), Vec8::sReplicate(inRay.mOrigin.GetZ()) };
+		const Vec8 a[3] = { inTriangles.mV0X - origin[0], inTriangles.mV0Y - origin[1], inTriangles.mV0Z - origin[2] };
+		const Vec8 b[3] = { inTriangles.mV1X - origin[0], inTriangles.mV1Y - origin[1], inTriangles.mV1Z - origin[2] };
+		const Vec8 c[3] = { inTriangles.mV2X - origin[0], inTriangles.mV2Y - origin[1], inTriangles.mV2Z - origin[2] };
+
+		// Shear the vertices, the permutation is the same for all lanes
+		const Vec8 shear_x = Vec8::sReplicate(inRay.mShearX), shear_y = Vec8::sReplicate(inRay.mShearY);
+		const Vec8 az = a[inRay.mAxisZ], bz = b[inRay.mAxisZ], cz = c[inRay.mAxisZ];
+		return detail::sRayTriangle8(
+			a[inRay.mAxisX] - shear_x * az, a[inRay.mAxisY] - shear_y * az, az,
+			b[inRay.mAxisX] - shear_x * bz, b[inRay.mAxisY] - shear_y * bz, bz,
+			c[inRay.mAxisX] - shear_x * cz, c[inRay.mAxisY] - shear_y * cz, cz,
+			Vec8::sReplicate(inRay.mShearZ));
+	}
+
+	/// Intersect 8 rays with one triangle, both sides of the triangle are hit.
+	/// @return Per ray the fraction along the ray of the hit (>= 0), or FLT_MAX when there is no hit
+	TOPIA_INLINE Vec8 RayTriangle8(const WatertightRay8 &inRays, Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2)
+	{
+		// Vertices relative to the ray origins
+		const Vec8 a[3] = { Vec8::sReplicate(inV0.GetX()) - inRays.mOriginX, Vec8::sReplicate(inV0.GetY()) - inRays.mOriginY, Vec8::sReplicate(inV0.GetZ()) - inRays.mOriginZ };
+		const Vec8 b[3] = { Vec8::sReplicate(inV1.GetX()) - inRays.mOriginX, Vec8::sReplicate(inV1.GetY()) - inRays.mOriginY, Vec8::sReplicate(inV1.GetZ()) - inRays.mOriginZ };
+		const Vec8 c[3] = { Vec8::sReplicate(inV2.GetX()) - inRays.mOriginX, Vec8::sReplicate(inV2.GetY()) - inRays.mOriginY, Vec8::sReplicate(inV2.GetZ()) - inRays.mOriginZ };
+
+		// Permute and shear the vertices
+		if (inRays.mSameAxis)
+		{
+			const Vec8 az = a[inRays.mAxisZ], bz = b[inRays.mAxisZ], cz = c[inRays.mAxisZ];
+			return detail::sRayTriangle8(
+				a[inRays.mAxisX] - inRays.mShearX * az, a[inRays.mAxisY] - inRays.mShearY * az, az,
+				b[inRays.mAxisX] - inRays.mShearX * bz, b[inRays.mAxisY] - inRays.mShearY * bz, bz,
+				c[inRays.mAxisX] - inRays.mShearX * cz, c[inRays.mAxisY] - inRays.mShearY * cz, cz,
+				inRays.mShearZ);
+		}
+		const Vec8 az = inRays.Permute(2, a), bz = inRays.Permute(2, b), cz = inRays.Permute(2, c);
+		return detail::sRayTriangle8(
+			inRays.Permute(0, a) - inRays.mShearX * az, inRays.Permute(1, a) - inRays.mShearY * az, az,
+			inRays.Permute(0, b) - inRays.mShearX * bz, inRays.Permute(1, b) - inRays.mShearY * bz, bz,
+			inRays.Permute(0, c) - inRays.mShearX * cz, inRays.Permute(1, c) - inRays.mShearY * cz, cz,
+			inRays.mShearZ);
+	}
+
+	/// Closest hit: intersect one ray with 8 triangles and update ioClosest when a triangle is hit before it.
+	/// @return The lane of the closest triangle that was hit, or cNoTriangleHit when ioClosest didn't change
+	TOPIA_INLINE uint RayTriangle8Closest(const WatertightRay &inRay, const TriangleBlock8 &inTriangles, float &ioClosest)
+	{
+		const Vec8 fraction = RayTriangle8(inRay, inTriangles);
+		const float closest = fraction.ReduceMin();
+		if (closest >= ioClosest)
+			return cNoTriangleHit;
+		ioClosest = closest;
+		return CountTrailingZeros(u32(Vec8::sEquals(fraction, Vec8::sReplicate(closest)).GetTrues()));
+	}
+
+	/// Any hit: test if one ray hits any of 8 triangles before inMaxFraction
+	TOPIA_INLINE bool RayTriangle8Any(const WatertightRay &inRay, const TriangleBlock8 &inTriangles, float inMaxFraction)
+	{
+		return Vec8::sLess(RayTriangle8(inRay, inTriangles), Vec8::sReplicate(inMaxFraction)).TestAnyTrue();
+	}
+
+	/// Closest hit: intersect 8 rays with one triangle and update ioClosest for the rays that hit it before their current closest hit.
+	/// @return The lanes for which ioClosest was updated
+	TOPIA_INLINE UVec8 RayTriangle8Closest(const WatertightRay8 &inRays, Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2, Vec8 &ioClosest)
+	{
+		const Vec8 fraction = RayTriangle8(inRays, inV0, inV1, inV2);
+		const UVec8 closer = Vec8::sLess(fraction, ioClosest);
+		ioClosest = Vec8::sMin(fraction, ioClosest);
+		return closer;
+	}
+
+	/// Any hit: test which of 8 rays hit a triangle before their inMaxFraction
+	TOPIA_INLINE UVec8 RayTriangle8Any(const WatertightRay8 &inRays, Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2, Vec8Arg inMaxFraction)
+	{
+		return Vec8::sLess(RayTriangle8(inRays, inV0, inV1, inV2), inMaxFraction);
+	}
+} // namespace topia
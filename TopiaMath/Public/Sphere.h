@@ -0,0 +1,70 @@
+#pragma once
+
+#include "AABox.h"
+
+namespace topia
+{
+	/// Bounding sphere
+	class TOPIA_NODISCARD Sphere
+	{
+	public:
+		Sphere() = default;
+		Sphere(Vec3Arg inCenter, float inRadius) : mCenter(inCenter), mRadius(inRadius) {}
+
+		/// Calculate the bounding box of the sphere
+		AABox GetAABox() const { return AABox(mCenter, mRadius); }
+
+		/// Test if a point is inside the sphere
+		bool Contains(Vec3Arg inPoint) const { return (inPoint - mCenter).LengthSq() <= Square(mRadius); }
+
+		/// Test if this sphere fully contains inOther
+		bool Contains(const Sphere &inOther) const { return inOther.mRadius <= mRadius && (inOther.mCenter - mCenter).LengthSq() <= Square(mRadius - inOther.mRadius); }
+
+		/// Test if two spheres overlap
+		bool Overlaps(const Sphere &inOther) const { return (inOther.mCenter - mCenter).LengthSq() <= Square(mRadius + inOther.mRadius); }
+
+		/// Check if this sphere overlaps with a box
+		bool Overlaps(const AABox &inOther) const { return inOther.GetSqDistanceTo(mCenter) <= Square(mRadius); }
+
+		/// Grow the sphere so that it encloses inPoint, keeps the side of the sphere opposite to the point fixed (Ritter's method)
+		void Encapsulate(Vec3Arg inPoint)
+		{
+			const Vec3 d = inPoint - mCenter;
+			const float dist_sq = d.LengthSq();
+			if (dist_sq > Square(mRadius))
+			{
+				const float dist = sqrt(dist_sq);
+				const float new_radius = 0.5f * (dist + mRadius);
+				mCenter += d * ((new_radius - mRadius) / dist);
+				mRadius = new_radius;
+			}
+		}
+
+		/// Grow the sphere so that it encloses inOther
+		void Encapsulate(const Sphere &inOther)
+		{
+			const Vec3 d = inOther.mCenter - mCenter;
+			const float dist = d.Length();
+			if (dist + inOther.mRadius <= mRadius)
+				return; // Already enclosed
+			if (dist + mRadius <= inOther.mRadius)
+			{
+				*this = inOther; // Other encloses this
+				return;
+			}
+			const float new_radius = 0.5f * (dist + mRadius + inOther.mRadius);
+			mCenter += d * ((new_radius - mRadius) / dist);
+			mRadius = new_radius;
+		}
+
+		/// Transform the sphere, for non-uniform scale the radius is scaled by the largest axis
+		Sphere Transformed(Mat44Arg inMatrix) const
+		{
+			const float max_scale_sq = std::max(std::max(inMatrix.GetAxisX().LengthSq(), inMatrix.GetAxisY().LengthSq()), inMatrix.GetAxisZ().LengthSq());
+			return Sphere(inMatrix * mCenter, mRadius * sqrt(max_scale_sq));
+		}
+
+		Vec3 mCenter;
+		float mRadius;
+	};
+} // namespace topia
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Vec4.h"
+
+namespace topia
+{
+	// Scalar trigonometric functions. Use these instead of std::sin etc. in code that needs to be deterministic:
+	// with TOPIA_CROSS_PLATFORM_DETERMINISTIC they go through the polynomial approximations of Vec4, which give the same result
+	// on every platform, otherwise they forward to the C runtime.
+
+	/// Sine of x (input in radians)
+	TOPIA_INLINE float Sin(float inX)
+	{
+	#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+		Vec4 s, c;
+		Vec4::sReplicate(inX).SinCos(s, c);
+		return s.GetX();
+	#else
+		return std::sin(inX);
+	#endif
+	}
+
+	/// Cosine of x (input in radians)
+	TOPIA_INLINE float Cos(float inX)
+	{
+	#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+		Vec4 s, c;
+		Vec4::sReplicate(inX).SinCos(s, c);
+		return c.GetX();
+	#else
+		return std::cos(inX);
+	#endif
+	}
+
+	/// Arc sine of x (returns value in the range [-PI / 2, PI / 2])
+	TOPIA_INLINE float ASin(float inX)
+	{
+	#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+		return Vec4::sReplicate(inX).ASin().GetX();
+	#else
+		return std::asin(inX);
+	#endif
+	}
+
+	/// Arc cosine of x (returns value in the range [0, PI])
+	TOPIA_INLINE float ACos(float inX)
+	{
+	#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+		return Vec4::sReplicate(inX).ACos().GetX();
+	#else
+		return std::acos(inX);
+	#endif
+	}
+
+	/// Arc tangent of x (returns value in the range [-PI / 2, PI / 2])
+	TOPIA_INLINE float ATan(float inX)
+	{
+	#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+		return Vec4::sReplicate(inX).ATan().GetX();
+	#else
+		return std::atan(inX);
+	#endif
+	}
+
+	/// Arc tangent of y / x using the signs of the arguments to determine the correct quadrant (returns value in the range [-PI, PI])
+	TOPIA_INLINE float ATan2(float inY, float inX)
+	{
+	#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+		return Vec4::sATan2(Vec4::sReplicate(inY), Vec4::sReplicate(inX)).GetX();
+	#else
+		return std::atan2(inY, inX);
+	#endif
+	}
+} // namespace topia
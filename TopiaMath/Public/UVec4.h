@@ -89,13 +89,13 @@ public:
     TOPIA_INLINE u32 GetZ() const { return mU32[2]; }
     TOPIA_INLINE u32 GetW() const { return mU32[3]; }
     #elif defined(TOPIA_USE_NEON)
-    TOPIA_INLINE uint32 GetX() const
+    TOPIA_INLINE u32 GetX() const
     {
         return vgetq_lane_u32(mValue, 0);
     }
-    TOPIA_INLINE uint32 GetY() const { return vgetq_lane_u32(mValue, 1); }
-    TOPIA_INLINE uint32 GetZ() const { return vgetq_lane_u32(mValue, 2); }
-    TOPIA_INLINE uint32 GetW() const { return vgetq_lane_u32(mValue, 3); }
+    TOPIA_INLINE u32 GetY() const { return vgetq_lane_u32(mValue, 1); }
+    TOPIA_INLINE u32 GetZ() const { return vgetq_lane_u32(mValue, 2); }
+    TOPIA_INLINE u32 GetW() const { return vgetq_lane_u32(mValue, 3); }
     #else
     #error Undefined
     #endif
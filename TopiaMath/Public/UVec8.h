@@ -68,6 +68,9 @@ namespace topia
         /// Test if all components are true (true is when highest bit of component is set)
         TOPIA_INLINE bool TestAllTrue() const;
 
+        /// Store if X is true in bit 0, Y in bit 1 etc. (true is when highest bit of component is set)
+        TOPIA_INLINE int GetTrues() const;
+
         /// Fetch the lower 128 bit from a 256 bit variable
         TOPIA_INLINE UVec4 LowerVec4() const;
 
@@ -77,6 +80,9 @@ namespace topia
         /// Converts int to float
         TOPIA_INLINE Vec8 ToFloat() const;
 
+        /// Reinterpret UVec8 as a Vec8 (doesn't change the bits)
+        TOPIA_INLINE Vec8 ReinterpretAsFloat() const;
+
         /// Shift all components by Count bits to the left (filling with zeros from the left)
         template <const uint Count>
         TOPIA_INLINE UVec8 LogicalShiftLeft() const;
@@ -9,7 +9,7 @@ namespace topia
 		return sEquals(*this, inV2).TestAllTrue();
 	}
 
-	UVec8 UVec8::sReplicate(uint32 inV)
+	UVec8 UVec8::sReplicate(u32 inV)
 	{
 		return _mm256_set1_epi32(int(inV));
 	}
@@ -58,7 +58,7 @@ namespace topia
 		return _mm256_castps_si256(_mm256_and_ps(_mm256_castsi256_ps(inV1.mValue), _mm256_castsi256_ps(inV2.mValue)));
 	}
 
-	template <uint32 SwizzleX, uint32 SwizzleY, uint32 SwizzleZ, uint32 SwizzleW>
+	template <u32 SwizzleX, u32 SwizzleY, u32 SwizzleZ, u32 SwizzleW>
 	UVec8 UVec8::Swizzle() const
 	{
 		static_assert(SwizzleX <= 3, "SwizzleX template parameter out of range");
@@ -79,6 +79,11 @@ namespace topia
 		return _mm256_movemask_ps(_mm256_castsi256_ps(mValue)) == 0xff;
 	}
 
+	int UVec8::GetTrues() const
+	{
+		return _mm256_movemask_ps(_mm256_castsi256_ps(mValue));
+	}
+
 	UVec4 UVec8::LowerVec4() const
 	{
 		return _mm256_castsi256_si128(mValue);
@@ -94,6 +99,11 @@ namespace topia
 		return _mm256_cvtepi32_ps(mValue);
 	}
 
+	Vec8 UVec8::ReinterpretAsFloat() const
+	{
+		return _mm256_castsi256_ps(mValue);
+	}
+
 	template <const uint Count>
 	UVec8 UVec8::LogicalShiftLeft() const
 	{
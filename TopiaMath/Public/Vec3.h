@@ -103,8 +103,19 @@ public:
     /// inPhi \f$\in [0, 2 \pi]\f$ is the angle in the xy-plane starting from the x axis and rotating counter clockwise around the z-axis
     static TOPIA_INLINE Vec3 sUnitSpherical(float inTheta, float inPhi);
 
-    /// A set of vectors uniformly spanning the surface of a unit sphere, usable for debug purposes
-    static const std::vector<Vec3> sUnitSphere;
+    /// A set of vectors uniformly spanning the surface of a unit sphere, usable for debug purposes.
+    /// This is sCreateUnitSphere at level 3 (1026 vectors), built on first use.
+    static const std::vector<Vec3> &sUnitSphere();
+
+    /// Highest level sCreateUnitSphere accepts, the next one has more than 2^32 vectors
+    static constexpr int cMaxUnitSphereLevel = 13;
+
+    /// Number of vectors sCreateUnitSphere produces for inLevel (0 <= inLevel < 30, computed in 64 bit so it doesn't wrap above cMaxUnitSphereLevel)
+    static constexpr u64 sGetUnitSphereVertexCount(int inLevel) { return (u64(4) << (2 * inLevel + 2)) + 2; }
+
+    /// Fill outVertices with the vertices of an octahedron whose faces are recursively split into 4 triangles inLevel + 1 times,
+    /// projected onto the unit sphere. The order of the vertices only depends on inLevel, which must be at most cMaxUnitSphereLevel.
+    static void sCreateUnitSphere(int inLevel, std::vector<Vec3> &outVertices);
 
     /// Get random unit vector
     template <class Random>
@@ -1,4 +1,5 @@
 #include "Vec4.h"
+#include "Trigonometry.h"
 #include "UVec4.h"
 
 #include <random>
@@ -265,8 +266,8 @@ namespace topia
 
 	Vec3 Vec3::sUnitSpherical(float inTheta, float inPhi)
 	{
-		float sint = sin(inTheta);
-		return Vec3(sint * cos(inPhi), sint * sin(inPhi), cos(inTheta));
+		float sint = Sin(inTheta);
+		return Vec3(sint * Cos(inPhi), sint * Sin(inPhi), Cos(inTheta));
 	}
 
 	template <class Random>
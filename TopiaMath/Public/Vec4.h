@@ -240,6 +240,23 @@ namespace topia
 		/// Get vector that contains the sign of each element (returns 1.0f if positive, -1.0f if negative)
 		TOPIA_INLINE Vec4 GetSign() const;
 
+		/// Calculate the sine and cosine for each element of this vector (input in radians)
+		TOPIA_INLINE void SinCos(Vec4 &outSin, Vec4 &outCos) const;
+
+		/// Calculate the arc sine for each element of this vector (returns value in the range [-PI / 2, PI / 2])
+		/// Input values are clamped to the range [-1, 1], so unlike std::asin this never returns NaN for values slightly outside of it
+		TOPIA_INLINE Vec4 ASin() const;
+
+		/// Calculate the arc cosine for each element of this vector (returns value in the range [0, PI])
+		/// Input values are clamped to the range [-1, 1], so unlike std::acos this never returns NaN for values slightly outside of it
+		TOPIA_INLINE Vec4 ACos() const;
+
+		/// Calculate the arc tangent for each element of this vector (returns value in the range [-PI / 2, PI / 2])
+		TOPIA_INLINE Vec4 ATan() const;
+
+		/// Calculate the arc tangent of y / x using the signs of the arguments to determine the correct quadrant (returns value in the range [-PI, PI])
+		static TOPIA_INLINE Vec4 sATan2(Vec4Arg inY, Vec4Arg inX);
+
 		/// To String
 		friend std::ostream &operator<<(std::ostream &inStream, Vec4Arg inV)
 		{
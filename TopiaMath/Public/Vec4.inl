@@ -1,5 +1,6 @@
 #include "Vec3.h"
 #include "UVec4.h"
+#include "MathUtils.h"
 
 namespace topia
 {
@@ -619,6 +620,125 @@ Vec4 Vec4::GetSign() const
     #endif
 }
 
+// The trigonometric functions below are based on sinf.c, asinf.c and atanf.c from the Cephes library by Stephen L. Moshier.
+// They only use add, multiply, divide and square root, so with TOPIA_CROSS_PLATFORM_DETERMINISTIC they give the same bits everywhere.
+void Vec4::SinCos(Vec4 &outSin, Vec4 &outCos) const
+{
+    // Work on |x| and remember the sign for sin only, cos is symmetric around 0
+    UVec4 sin_sign = UVec4::sAnd(ReinterpretAsInt(), UVec4::sReplicate(0x80000000U));
+    Vec4 x = sXor(*this, sin_sign.ReinterpretAsFloat());
+
+    // Find the nearest multiple of PI / 2
+    UVec4 quadrant = sFusedMultiplyAdd(x, sReplicate(2.0f / TOPIA_PI), sReplicate(0.5f)).ToInt();
+    Vec4 float_quadrant = quadrant.ToFloat();
+
+    // Subtract quadrant * PI / 2 in three steps (Cody-Waite reduction). The first two constants have their low bits cleared so
+    // that their product with quadrant is exact, the last one adds the remainder of PI / 2. x ends up in [-PI / 4, PI / 4].
+    x = x - float_quadrant * 1.5703125f;
+    x = x - float_quadrant * 0.0004837512969970703125f;
+    x = x - float_quadrant * 7.549789948768648e-8f;
+    Vec4 x2 = x * x;
+
+    // Minimax polynomials on [-PI / 4, PI / 4]
+    Vec4 taylor_cos = sFusedMultiplyAdd(sReplicate(2.443315711809948e-5f), x2, sReplicate(-1.388731625493765e-3f));
+    taylor_cos = sFusedMultiplyAdd(taylor_cos, x2, sReplicate(4.166664568298827e-2f));
+    taylor_cos = sFusedMultiplyAdd(taylor_cos, x2, sReplicate(-0.5f));
+    taylor_cos = sFusedMultiplyAdd(taylor_cos, x2, sReplicate(1.0f));
+    Vec4 taylor_sin = sFusedMultiplyAdd(sReplicate(-1.9515295891e-4f), x2, sReplicate(8.3321608736e-3f));
+    taylor_sin = sFusedMultiplyAdd(taylor_sin, x2, sReplicate(-1.6666654611e-1f));
+    taylor_sin = sFusedMultiplyAdd(taylor_sin * x2, x, x);
+
+    // With x' the reduced angle:
+    // quadrant & 3 | sin(x)   | cos(x)
+    // 0            |  sin(x') |  cos(x')
+    // 1            |  cos(x') | -sin(x')
+    // 2            | -sin(x') | -cos(x')
+    // 3            | -cos(x') |  sin(x')
+    // Bit 0 swaps sin and cos, bit 1 flips the sign of sin, bit 0 ^ bit 1 flips the sign of cos
+    UVec4 bit0 = quadrant.LogicalShiftLeft<31>();
+    UVec4 bit1 = UVec4::sAnd(quadrant.LogicalShiftLeft<30>(), UVec4::sReplicate(0x80000000U));
+    Vec4 s = sSelect(taylor_sin, taylor_cos, bit0);
+    Vec4 c = sSelect(taylor_cos, taylor_sin, bit0);
+    outSin = sXor(s, UVec4::sXor(sin_sign, bit1).ReinterpretAsFloat());
+    outCos = sXor(c, UVec4::sXor(bit0, bit1).ReinterpretAsFloat());
+}
+
+Vec4 Vec4::ASin() const
+{
+    // Work on |x| clamped to 1 and put the sign back at the end
+    UVec4 asin_sign = UVec4::sAnd(ReinterpretAsInt(), UVec4::sReplicate(0x80000000U));
+    Vec4 a = sMin(sXor(*this, asin_sign.ReinterpretAsFloat()), sReplicate(1.0f));
+
+    // For |x| > 0.5 use asin(x) = PI / 2 - 2 asin(sqrt((1 - x) / 2)) to stay in the range where the polynomial is accurate
+    UVec4 greater = sGreater(a, sReplicate(0.5f));
+    Vec4 z2 = 0.5f * (sReplicate(1.0f) - a);
+    Vec4 z = sSelect(a * a, z2, greater);
+    Vec4 x = sSelect(a, z2.Sqrt(), greater);
+
+    Vec4 p = sFusedMultiplyAdd(sReplicate(4.2163199048e-2f), z, sReplicate(2.4181311049e-2f));
+    p = sFusedMultiplyAdd(p, z, sReplicate(4.5470025998e-2f));
+    p = sFusedMultiplyAdd(p, z, sReplicate(7.4953002686e-2f));
+    p = sFusedMultiplyAdd(p, z, sReplicate(1.6666752422e-1f));
+    p = sFusedMultiplyAdd(p * z, x, x);
+
+    p = sSelect(p, sReplicate(0.5f * TOPIA_PI) - (p + p), greater);
+    return sXor(p, asin_sign.ReinterpretAsFloat());
+}
+
+Vec4 Vec4::ACos() const
+{
+    // acos(x) = PI / 2 - asin(x)
+    return sReplicate(0.5f * TOPIA_PI) - ASin();
+}
+
+Vec4 Vec4::ATan() const
+{
+    // Work on |x| and put the sign back at the end
+    UVec4 atan_sign = UVec4::sAnd(ReinterpretAsInt(), UVec4::sReplicate(0x80000000U));
+    Vec4 x = sXor(*this, atan_sign.ReinterpretAsFloat());
+    Vec4 y = sZero();
+
+    // Map x to [0, tan(PI / 8)]:
+    // x > tan(3 PI / 8): atan(x) = PI / 2 + atan(-1 / x)
+    // x > tan(PI / 8): atan(x) = PI / 4 + atan((x - 1) / (x + 1))
+    UVec4 greater1 = sGreater(x, sReplicate(0.4142135623730950f));
+    UVec4 greater2 = sGreater(x, sReplicate(2.414213562373095f));
+    Vec4 x1 = (x - sReplicate(1.0f)) / (x + sReplicate(1.0f));
+    Vec4 x2 = sReplicate(-1.0f) / sMax(x, sReplicate(std::numeric_limits<float>::min())); // Only used when x > 2.4, the max prevents a division by zero in the other lanes
+    x = sSelect(x, x1, greater1);
+    y = sSelect(y, sReplicate(0.25f * TOPIA_PI), greater1);
+    x = sSelect(x, x2, greater2);
+    y = sSelect(y, sReplicate(0.5f * TOPIA_PI), greater2);
+
+    Vec4 z = x * x;
+    Vec4 p = sFusedMultiplyAdd(sReplicate(8.05374449538e-2f), z, sReplicate(-1.38776856032e-1f));
+    p = sFusedMultiplyAdd(p, z, sReplicate(1.99777106478e-1f));
+    p = sFusedMultiplyAdd(p, z, sReplicate(-3.33329491539e-1f));
+    y = y + sFusedMultiplyAdd(p * z, x, x);
+
+    return sXor(y, atan_sign.ReinterpretAsFloat());
+}
+
+Vec4 Vec4::sATan2(Vec4Arg inY, Vec4Arg inX)
+{
+    UVec4 sign_mask = UVec4::sReplicate(0x80000000U);
+    UVec4 y_sign = UVec4::sAnd(inY.ReinterpretAsInt(), sign_mask);
+    UVec4 x_sign = UVec4::sAnd(inX.ReinterpretAsInt(), sign_mask);
+    Vec4 y_abs = sXor(inY, y_sign.ReinterpretAsFloat());
+    Vec4 x_abs = sXor(inX, x_sign.ReinterpretAsFloat());
+
+    // Divide the smallest by the largest so the ratio is in [0, 1], if x is the smallest the result is PI / 2 - atan(x / y)
+    UVec4 x_is_numerator = sLess(x_abs, y_abs);
+    Vec4 numerator = sSelect(y_abs, x_abs, x_is_numerator);
+    Vec4 denominator = sMax(sSelect(x_abs, y_abs, x_is_numerator), sReplicate(std::numeric_limits<float>::min())); // atan2(0, 0) = 0
+    Vec4 atan = (numerator / denominator).ATan();
+    atan = sSelect(atan, sReplicate(0.5f * TOPIA_PI) - atan, x_is_numerator);
+
+    // Map to the right quadrant: x < 0 gives PI - atan, y < 0 negates the result
+    atan = sSelect(atan, sReplicate(TOPIA_PI) - atan, x_sign);
+    return sXor(atan, y_sign.ReinterpretAsFloat());
+}
+
 Vec4 Vec4::Normalized() const
 {
     #if defined(TOPIA_USE_SSE)
@@ -43,18 +43,30 @@ namespace topia
         /// Component wise max
         static TOPIA_INLINE Vec8 sMax(Vec8Arg inV1, Vec8Arg inV2);
 
+        /// Equals
+        static TOPIA_INLINE UVec8 sEquals(Vec8Arg inV1, Vec8Arg inV2);
+
         /// Less than
         static TOPIA_INLINE UVec8 sLess(Vec8Arg inV1, Vec8Arg inV2);
 
+        /// Less than or equal
+        static TOPIA_INLINE UVec8 sLessOrEqual(Vec8Arg inV1, Vec8Arg inV2);
+
         /// Greater than
         static TOPIA_INLINE UVec8 sGreater(Vec8Arg inV1, Vec8Arg inV2);
 
+        /// Greater than or equal
+        static TOPIA_INLINE UVec8 sGreaterOrEqual(Vec8Arg inV1, Vec8Arg inV2);
+
         /// Load from memory
         static TOPIA_INLINE Vec8 sLoadFloat8(const float* inV);
 
         /// Load 8 floats from memory, 32 bytes aligned
         static TOPIA_INLINE Vec8 sLoadFloat8Aligned(const float* inV);
 
+        /// Store 8 floats to memory
+        TOPIA_INLINE void StoreFloat8(float* outV) const;
+
         /// Get float component by index
         TOPIA_INLINE float operator[](uint inCoordinate) const
         {
@@ -76,6 +88,9 @@ namespace topia
         /// Add two float vectors
         TOPIA_INLINE Vec8 operator+(Vec8Arg inV2) const;
 
+        /// Negate
+        TOPIA_INLINE Vec8 operator-() const;
+
         /// Subtract two float vectors
         TOPIA_INLINE Vec8 operator-(Vec8Arg inV2) const;
 
@@ -92,6 +107,18 @@ namespace topia
         /// Get absolute value of all components
         TOPIA_INLINE Vec8 Abs() const;
 
+        /// Component wise square root
+        TOPIA_INLINE Vec8 Sqrt() const;
+
+        /// Get vector that contains the sign of each element (returns 1.0f if positive, -1.0f if negative)
+        TOPIA_INLINE Vec8 GetSign() const;
+
+        /// Convert each component from a float to an int
+        TOPIA_INLINE UVec8 ToInt() const;
+
+        /// Reinterpret Vec8 as a UVec8 (doesn't change the bits)
+        TOPIA_INLINE UVec8 ReinterpretAsInt() const;
+
         /// Fetch the lower 128 bit from a 256 bit variable
         TOPIA_INLINE Vec4 LowerVec4() const;
 
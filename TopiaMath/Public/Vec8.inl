@@ -55,16 +55,31 @@ namespace topia
 		return _mm256_max_ps(inV1.mValue, inV2.mValue);
 	}
 
+	UVec8 Vec8::sEquals(Vec8Arg inV1, Vec8Arg inV2)
+	{
+		return _mm256_castps_si256(_mm256_cmp_ps(inV1.mValue, inV2.mValue, _CMP_EQ_OQ));
+	}
+
 	UVec8 Vec8::sLess(Vec8Arg inV1, Vec8Arg inV2)
 	{
 		return _mm256_castps_si256(_mm256_cmp_ps(inV1.mValue, inV2.mValue, _CMP_LT_OQ));
 	}
 
+	UVec8 Vec8::sLessOrEqual(Vec8Arg inV1, Vec8Arg inV2)
+	{
+		return _mm256_castps_si256(_mm256_cmp_ps(inV1.mValue, inV2.mValue, _CMP_LE_OQ));
+	}
+
 	UVec8 Vec8::sGreater(Vec8Arg inV1, Vec8Arg inV2)
 	{
 		return _mm256_castps_si256(_mm256_cmp_ps(inV1.mValue, inV2.mValue, _CMP_GT_OQ));
 	}
 
+	UVec8 Vec8::sGreaterOrEqual(Vec8Arg inV1, Vec8Arg inV2)
+	{
+		return _mm256_castps_si256(_mm256_cmp_ps(inV1.mValue, inV2.mValue, _CMP_GE_OQ));
+	}
+
 	Vec8 Vec8::sLoadFloat8(const float *inV)
 	{
 		return _mm256_loadu_ps(inV);
@@ -75,6 +90,11 @@ namespace topia
 		return _mm256_load_ps(inV);
 	}
 
+	void Vec8::StoreFloat8(float *outV) const
+	{
+		_mm256_storeu_ps(outV, mValue);
+	}
+
 	Vec8 Vec8::operator*(Vec8Arg inV2) const
 	{
 		return _mm256_mul_ps(mValue, inV2.mValue);
@@ -90,6 +110,11 @@ namespace topia
 		return _mm256_add_ps(mValue, inV2.mValue);
 	}
 
+	Vec8 Vec8::operator-() const
+	{
+		return _mm256_sub_ps(_mm256_setzero_ps(), mValue);
+	}
+
 	Vec8 Vec8::operator-(Vec8Arg inV2) const
 	{
 		return _mm256_sub_ps(mValue, inV2.mValue);
@@ -105,7 +130,7 @@ namespace topia
 		return Vec8::sReplicate(1.0f) / mValue;
 	}
 
-	template <uint32 SwizzleX, uint32 SwizzleY, uint32 SwizzleZ, uint32 SwizzleW>
+	template <u32 SwizzleX, u32 SwizzleY, u32 SwizzleZ, u32 SwizzleW>
 	Vec8 Vec8::Swizzle() const
 	{
 		static_assert(SwizzleX <= 3, "SwizzleX template parameter out of range");
@@ -121,6 +146,28 @@ namespace topia
 		return _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), mValue), mValue);
 	}
 
+	Vec8 Vec8::Sqrt() const
+	{
+		return _mm256_sqrt_ps(mValue);
+	}
+
+	Vec8 Vec8::GetSign() const
+	{
+		__m256 minus_one = _mm256_set1_ps(-1.0f);
+		__m256 one = _mm256_set1_ps(1.0f);
+		return _mm256_or_ps(_mm256_and_ps(mValue, minus_one), one);
+	}
+
+	UVec8 Vec8::ToInt() const
+	{
+		return _mm256_cvttps_epi32(mValue);
+	}
+
+	UVec8 Vec8::ReinterpretAsInt() const
+	{
+		return _mm256_castps_si256(mValue);
+	}
+
 	Vec4 Vec8::LowerVec4() const
 	{
 		return _mm256_castps256_ps128(mValue);
@@ -1,9 +1,94 @@
 #pragma once
 
 #include <Topia.h>
+#include "Vec4.h"
 
 namespace topia
 {
+    namespace detail
+    {
+        /// Number of floats of a Vector<Rows> that can be processed with Vec4 operations, the remainder is handled with scalar code
+        template <uint Rows>
+        struct Vec4Rows
+        {
+            static constexpr uint cValue = Rows & ~3u;
+        };
+
+        template <uint Rows>
+        constexpr uint Vec4Rows<Rows>::cValue;
+
+        /// Block part of sWeightedSum, for Rows >= 4
+        template <uint Rows, uint Count, class ColumnVector>
+        TOPIA_INLINE void sWeightedSumBlocks(const ColumnVector *inV, const float *inWeights, float *outV, std::true_type)
+        {
+            constexpr uint cBlocks = Vec4Rows<Rows>::cValue / 4;
+            Vec4 acc[cBlocks];
+            for (uint b = 0; b < cBlocks; ++b)
+                acc[b] = Vec4::sZero();
+            for (uint i = 0; i < Count; ++i)
+            {
+                const Vec4 w = Vec4::sReplicate(inWeights[i]);
+                for (uint b = 0; b < cBlocks; ++b)
+                    acc[b] = Vec4::sFusedMultiplyAdd(Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(inV[i].mF32 + 4 * b)), w, acc[b]);
+            }
+            for (uint b = 0; b < cBlocks; ++b)
+                acc[b].StoreFloat4(reinterpret_cast<Float4 *>(outV + 4 * b));
+        }
+
+        template <uint Rows, uint Count, class ColumnVector>
+        TOPIA_INLINE void sWeightedSumBlocks(const ColumnVector *, const float *, float *, std::false_type)
+        {
+        }
+
+        /// outV[r] = sum_i inV[i][r] * inWeights[i] for r < Rows, i < Count.
+        /// The 4 row blocks are kept in registers while walking over the inputs, Rows and Count are compile time constants so the loops fully unroll.
+        template <uint Rows, uint Count, class ColumnVector>
+        TOPIA_INLINE void sWeightedSum(const ColumnVector *inV, const float *inWeights, float *outV)
+        {
+            sWeightedSumBlocks<Rows, Count>(inV, inWeights, outV, std::integral_constant<bool, (Vec4Rows<Rows>::cValue > 0)>());
+
+            for (uint r = Vec4Rows<Rows>::cValue; r < Rows; ++r)
+            {
+                float sum = 0.0f;
+                for (uint i = 0; i < Count; ++i)
+                    sum += inV[i].mF32[r] * inWeights[i];
+                outV[r] = sum;
+            }
+        }
+
+        /// ioV[r] += inA * inX[r] for r < Rows
+        template <uint Rows>
+        TOPIA_INLINE void sMultiplyAdd(float *ioV, const float *inX, float inA)
+        {
+            const Vec4 a = Vec4::sReplicate(inA);
+            for (uint r = 0; r < Vec4Rows<Rows>::cValue; r += 4)
+            {
+                Float4 *v = reinterpret_cast<Float4 *>(ioV + r);
+                Vec4::sFusedMultiplyAdd(Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(inX + r)), a, Vec4::sLoadFloat4(v)).StoreFloat4(v);
+            }
+            for (uint r = Vec4Rows<Rows>::cValue; r < Rows; ++r)
+                ioV[r] += inA * inX[r];
+        }
+
+        /// outDot = sum of inA[r] * inB[r] over the 4 row blocks with 4 partial sums, returns the first row left to scalar code.
+        /// Only worth it when there are at least 2 blocks, see Vector::Dot.
+        template <uint Rows>
+        TOPIA_INLINE uint sDotBlocks(const float *inA, const float *inB, float &outDot, std::true_type)
+        {
+            Vec4 acc = Vec4::sZero();
+            for (uint r = 0; r < Vec4Rows<Rows>::cValue; r += 4)
+                acc = Vec4::sFusedMultiplyAdd(Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(inA + r)), Vec4::sLoadFloat4(reinterpret_cast<const Float4 *>(inB + r)), acc);
+            outDot = acc.GetX() + acc.GetY() + acc.GetZ() + acc.GetW();
+            return Vec4Rows<Rows>::cValue;
+        }
+
+        template <uint Rows>
+        TOPIA_INLINE uint sDotBlocks(const float *, const float *, float &, std::false_type)
+        {
+            return 0;
+        }
+    } // namespace detail
+
     /// Templatized vector class
     template <uint Rows>
     class TOPIA_NODISCARD Vector
@@ -167,7 +252,8 @@ namespace topia
         inline float Dot(const Vector &inV2) const
         {
             float dot = 0.0f;
-            for (uint r = 0; r < Rows; ++r)
+            uint r = detail::sDotBlocks<Rows>(mF32, inV2.mF32, dot, std::integral_constant<bool, (detail::Vec4Rows<Rows>::cValue >= 8)>());
+            for (; r < Rows; ++r)
                 dot += mF32[r] * inV2.mF32[r];
             return dot;
         }
@@ -0,0 +1,222 @@
+#include <Topia.h>
+#include <Platforms.h>
+#include <FileSystem/Archive.h>
+#include <FileSystem/AsyncIO.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+
+using namespace topia;
+
+/**
+ * Packs a directory into an archive (.tpak) that FArchive reads, lists archives and compares loading the files of a
+ * directory one by one with loading them from its archive.
+ */
+
+static void sPrintUsage()
+{
+    printf("Usage: TopiaPacker [options] <directory> <output.tpak>\n");
+    printf("       TopiaPacker -list <archive.tpak>\n");
+    printf("       TopiaPacker -bench <directory> <archive.tpak>\n");
+    printf("  -nocompress    Store the blocks uncompressed\n");
+    printf("  -blocksize KB  Size of the compressed blocks (default 64)\n");
+}
+
+static double sMilliseconds(std::chrono::high_resolution_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Start).count();
+}
+
+/** Paths relative to Root of every file below Directory, Directory ends with a separator */
+static void sFindFiles(const std::wstring& Root, const std::wstring& Directory, std::vector<std::wstring>& OutFiles)
+{
+    WIN32_FIND_DATAW FindData;
+    HANDLE FindHandle = ::FindFirstFileW((Root + Directory + L"*").c_str(), &FindData);
+    if (FindHandle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    do
+    {
+        const std::wstring Name = FindData.cFileName;
+        if (Name == L"." || Name == L"..")
+        {
+            continue;
+        }
+        if (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            sFindFiles(Root, Directory + Name + L"\\", OutFiles);
+        }
+        else
+        {
+            OutFiles.push_back(Directory + Name);
+        }
+    } while (::FindNextFileW(FindHandle, &FindData));
+    ::FindClose(FindHandle);
+}
+
+/** Open, read and close, the way a loader reads a loose file */
+static bool sReadLooseFile(const std::wstring& Path, std::vector<u8>& OutData)
+{
+    FAsyncFile File;
+    if (!File.Open(Path))
+    {
+        return false;
+    }
+    OutData.resize(size_t(File.GetSize()));
+    return File.Read(0, File.GetSize(), OutData.data()) == File.GetSize();
+}
+
+static int sPack(const std::wstring& Root, const std::wstring& Output, u32 BlockSize, bool bCompress)
+{
+    std::vector<std::wstring> Files;
+    sFindFiles(Root, L"", Files);
+
+    const auto Start = std::chrono::high_resolution_clock::now();
+    FArchiveWriter Writer(BlockSize, bCompress);
+    u64 TotalSize = 0;
+    for (const std::wstring& File : Files)
+    {
+        std::vector<u8> Data;
+        if (!sReadLooseFile(Root + File, Data))
+        {
+            printf("Can't read %ls\n", File.c_str());
+            return 1;
+        }
+        TotalSize += Data.size();
+        if (!Writer.AddFile(WideToUTF8(File), std::move(Data)))
+        {
+            printf("Two files have the path %ls once normalized\n", File.c_str());
+            return 1;
+        }
+    }
+    FThreadPool Pool;
+    if (!Writer.Write(Output, &Pool))
+    {
+        printf("Can't write %ls\n", Output.c_str());
+        return 1;
+    }
+
+    FAsyncFile Archive;
+    Archive.Open(Output);
+    printf("Packed %u files, %.1f MB into %.1f MB (%.1f%%) in %.1f ms\n", u32(Files.size()), double(TotalSize) / (1024.0 * 1024.0),
+        double(Archive.GetSize()) / (1024.0 * 1024.0), TotalSize > 0 ? 100.0 * double(Archive.GetSize()) / double(TotalSize) : 0.0, sMilliseconds(Start));
+    return 0;
+}
+
+static int sList(const std::wstring& Path)
+{
+    FArchive Archive;
+    if (!Archive.Open(Path))
+    {
+        printf("Can't open %ls\n", Path.c_str());
+        return 1;
+    }
+    for (u32 e = 0; e < Archive.GetNumEntries(); ++e)
+    {
+        printf("%12llu  %s\n", (unsigned long long)Archive.GetSize(e), Archive.GetPath(e).c_str());
+    }
+    return 0;
+}
+
+static int sBenchmark(const std::wstring& Root, const std::wstring& ArchivePath)
+{
+    std::vector<std::wstring> Files;
+    sFindFiles(Root, L"", Files);
+    std::vector<std::string> Paths;
+    for (const std::wstring& File : Files)
+    {
+        Paths.push_back(WideToUTF8(File));
+    }
+
+    std::vector<u8> Data;
+    u64 LooseBytes = 0, PackedBytes = 0;
+    auto Start = std::chrono::high_resolution_clock::now();
+    for (const std::wstring& File : Files)
+    {
+        sReadLooseFile(Root + File, Data);
+        LooseBytes += Data.size();
+    }
+    const double LooseTime = sMilliseconds(Start);
+
+    Start = std::chrono::high_resolution_clock::now();
+    FArchive Archive;
+    if (!Archive.Open(ArchivePath))
+    {
+        printf("Can't open %ls\n", ArchivePath.c_str());
+        return 1;
+    }
+    for (const std::string& Path : Paths)
+    {
+        const u32 Entry = Archive.Find(Path);
+        if (Entry == FArchive::INVALID_INDEX || !Archive.Read(Entry, Data))
+        {
+            printf("Can't read %s from the archive\n", Path.c_str());
+            return 1;
+        }
+        PackedBytes += Data.size();
+    }
+    const double PackedTime = sMilliseconds(Start);
+
+    printf("%u files, %.1f MB\n", u32(Files.size()), double(LooseBytes) / (1024.0 * 1024.0));
+    printf("  Loose   %9.1f ms  %7.1f us per file\n", LooseTime, 1000.0 * LooseTime / std::max<size_t>(1, Files.size()));
+    printf("  Packed  %9.1f ms  %7.1f us per file\n", PackedTime, 1000.0 * PackedTime / std::max<size_t>(1, Files.size()));
+    return PackedBytes == LooseBytes ? 0 : 1;
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    u32 BlockSize = ARCHIVE_DEFAULT_BLOCK_SIZE;
+    bool bCompress = true;
+    bool bList = false, bBenchmark = false;
+    std::vector<std::wstring> Arguments;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const wchar_t* pArg = argv[i];
+        if (wcscmp(pArg, L"-nocompress") == 0)
+        {
+            bCompress = false;
+        }
+        else if (wcscmp(pArg, L"-blocksize") == 0 && i + 1 < argc)
+        {
+            BlockSize = std::max(1u, u32(wcstoul(argv[++i], nullptr, 10))) * 1024;
+        }
+        else if (wcscmp(pArg, L"-list") == 0)
+        {
+            bList = true;
+        }
+        else if (wcscmp(pArg, L"-bench") == 0)
+        {
+            bBenchmark = true;
+        }
+        else if (pArg[0] != L'-')
+        {
+            Arguments.push_back(pArg);
+        }
+        else
+        {
+            sPrintUsage();
+            return 1;
+        }
+    }
+
+    if (bList && Arguments.size() == 1)
+    {
+        return sList(Arguments[0]);
+    }
+    if (Arguments.size() != 2 || bList)
+    {
+        sPrintUsage();
+        return 1;
+    }
+
+    std::wstring Root = Arguments[0];
+    if (Root.back() != L'\\' && Root.back() != L'/')
+    {
+        Root += L'\\';
+    }
+    return bBenchmark ? sBenchmark(Root, Arguments[1]) : sPack(Root, Arguments[1], BlockSize, bCompress);
+}
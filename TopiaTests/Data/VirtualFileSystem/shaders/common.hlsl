@@ -0,0 +1 @@
+float4 Loose;
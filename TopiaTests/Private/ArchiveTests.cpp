@@ -0,0 +1,342 @@
+#include "TestFramework.h"
+
+#include <Compression/LZ4.h>
+#include <FileSystem/Archive.h>
+#include <FileSystem/FileUtils.h>
+#include <FileSystem/MappedFile.h>
+#include <Hash.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+using namespace topia;
+
+static std::vector<u8> sRandomData(size_t Size, u32 Seed)
+{
+    std::vector<u8> Data(Size);
+    std::mt19937 Random(Seed);
+    for (u8& Byte : Data)
+    {
+        Byte = u8(Random());
+    }
+    return Data;
+}
+
+/** Text with repeats at every distance, including runs where the match overlaps itself */
+static std::vector<u8> sCompressibleData(size_t Size, u32 Seed)
+{
+    static const char* sWords[] = { "mesh", "texture", "shader", "a", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "material", "/", "." };
+    std::vector<u8> Data;
+    std::mt19937 Random(Seed);
+    while (Data.size() < Size)
+    {
+        const char* pWord = sWords[Random() % 8];
+        Data.insert(Data.end(), pWord, pWord + strlen(pWord));
+        if (Random() % 5 == 0)
+        {
+            Data.push_back(u8(Random()));
+        }
+    }
+    Data.resize(Size);
+    return Data;
+}
+
+static bool sRoundTripLZ4(const std::vector<u8>& Data)
+{
+    const u32 Size = u32(Data.size());
+    std::vector<u8> Compressed(GetMaxCompressedSizeLZ4(Size));
+    const u32 CompressedSize = CompressLZ4(Data.data(), Size, Compressed.data(), u32(Compressed.size()));
+    if (CompressedSize == 0 && Size > 0)
+    {
+        return false;
+    }
+
+    // Exactly sized output, so a decoder that writes past the end shows up under the sanitizers
+    std::vector<u8> Decompressed(Size);
+    return DecompressLZ4(Compressed.data(), CompressedSize, Decompressed.data(), Size) && Decompressed == Data;
+}
+
+TOPIA_TEST(Archive, LZ4RoundTrip)
+{
+    for (size_t Size : { 0, 1, 5, 12, 13, 17, 100, 4096, 65536, 200000 })
+    {
+        TEST_CHECK(sRoundTripLZ4(sRandomData(Size, u32(Size))));
+        TEST_CHECK(sRoundTripLZ4(sCompressibleData(Size, u32(Size))));
+        TEST_CHECK(sRoundTripLZ4(std::vector<u8>(Size, 0x41)));
+    }
+
+    // Compressible data gets smaller, damaged or truncated input fails instead of writing out of bounds
+    const std::vector<u8> Data = sCompressibleData(65536, 3);
+    std::vector<u8> Compressed(GetMaxCompressedSizeLZ4(65536));
+    Compressed.resize(CompressLZ4(Data.data(), 65536, Compressed.data(), u32(Compressed.size())));
+    TEST_CHECK(Compressed.size() < Data.size() / 2);
+
+    std::vector<u8> Decompressed(Data.size());
+    TEST_CHECK(!DecompressLZ4(Compressed.data(), u32(Compressed.size()) - 1, Decompressed.data(), u32(Decompressed.size())));
+    TEST_CHECK(!DecompressLZ4(Compressed.data(), u32(Compressed.size()), Decompressed.data(), u32(Decompressed.size()) - 1));
+    std::vector<u8> Zeros(Compressed.size(), 0);
+    TEST_CHECK(!DecompressLZ4(Zeros.data(), u32(Zeros.size()), Decompressed.data(), u32(Decompressed.size())));
+    std::mt19937 Random(5);
+    for (u32 Trial = 0; Trial < 200; ++Trial)
+    {
+        std::vector<u8> Damaged = Compressed;
+        Damaged[Random() % Damaged.size()] ^= u8(1 + Random() % 255);
+        DecompressLZ4(Damaged.data(), u32(Damaged.size()), Decompressed.data(), u32(Decompressed.size()));
+    }
+}
+
+struct FArchiveTestFile
+{
+    std::string Path;
+    std::vector<u8> Data;
+};
+
+static std::vector<FArchiveTestFile> sArchiveTestFiles(u32 BlockSize)
+{
+    std::vector<FArchiveTestFile> Files;
+    Files.push_back({ "Meshes/Empty.tmesh", std::vector<u8>() });
+    Files.push_back({ "Meshes/Small.tmesh", sRandomData(10, 1) });
+    Files.push_back({ "Meshes/OneBlock.tmesh", sCompressibleData(BlockSize, 2) });
+    Files.push_back({ "Textures/Blocks.ttex", sCompressibleData(BlockSize * 5, 3) });
+    Files.push_back({ "Textures/Random.ttex", sRandomData(BlockSize * 3 + 17, 4) });
+    Files.push_back({ "Shaders/Mixed.bin", sCompressibleData(BlockSize * 2 + 1, 5) });
+    Files.back().Data.insert(Files.back().Data.end(), BlockSize, 0);
+    return Files;
+}
+
+TOPIA_TEST(Archive, WriteThenRead)
+{
+    const u32 BlockSize = 1024;
+    const std::vector<FArchiveTestFile> Files = sArchiveTestFiles(BlockSize);
+    FThreadPool Pool(2);
+
+    for (bool bCompress : { true, false })
+    {
+        FArchiveWriter Writer(BlockSize, bCompress);
+        for (const FArchiveTestFile& File : Files)
+        {
+            TEST_CHECK(Writer.AddFile(File.Path, std::vector<u8>(File.Data)));
+        }
+        TEST_CHECK(!Writer.AddFile("./Meshes\\Small.tmesh", std::vector<u8>(1)));
+
+        const std::wstring Path = UTF8ToWide(GetTestTempDirectory() + (bCompress ? "Compressed.tpak" : "Stored.tpak"));
+        TEST_CHECK(Writer.Write(Path, &Pool));
+
+        FArchive Archive;
+        TEST_CHECK(Archive.Open(Path) && Archive.GetNumEntries() == Files.size());
+        TEST_CHECK(Archive.Find("Meshes/Missing.tmesh") == FArchive::INVALID_INDEX);
+        for (const FArchiveTestFile& File : Files)
+        {
+            const u32 Entry = Archive.Find(File.Path);
+            TEST_CHECK(Entry != FArchive::INVALID_INDEX && Archive.GetPath(Entry) == NormalizeArchivePath(File.Path) && Archive.GetSize(Entry) == File.Data.size());
+            if (Entry == FArchive::INVALID_INDEX)
+            {
+                continue;
+            }
+
+            std::vector<u8> Data;
+            TEST_CHECK(Archive.Read(Entry, Data) && Data == File.Data);
+
+            // Ranges that start and end inside blocks and on their boundaries
+            const u64 Size = File.Data.size();
+            for (u64 Offset : { u64(0), u64(1), u64(BlockSize - 1), u64(BlockSize), u64(BlockSize + 7), Size / 2, Size })
+            {
+                for (u64 RangeSize : { u64(0), u64(1), u64(BlockSize), u64(BlockSize + 2), u64(3 * BlockSize - 5), Size })
+                {
+                    if (Offset > Size || RangeSize > Size - Offset)
+                    {
+                        std::vector<u8> Range(size_t(RangeSize) + 1);
+                        TEST_CHECK(!Archive.Read(Entry, Offset, RangeSize, Range.data()));
+                        continue;
+                    }
+                    for (FThreadPool* pPool : { static_cast<FThreadPool*>(nullptr), &Pool })
+                    {
+                        std::vector<u8> Range(size_t(RangeSize) + 1, 0xCD);
+                        TEST_CHECK(Archive.Read(Entry, Offset, RangeSize, Range.data(), pPool));
+                        TEST_CHECK(RangeSize == 0 || memcmp(Range.data(), File.Data.data() + Offset, size_t(RangeSize)) == 0);
+                        TEST_CHECK(Range[size_t(RangeSize)] == 0xCD);
+                    }
+                }
+            }
+        }
+
+        // The lookup normalizes the path like the writer
+        TEST_CHECK(Archive.Find("./TEXTURES\\Blocks.ttex") == Archive.Find("Textures/Blocks.ttex"));
+    }
+}
+
+TOPIA_TEST(Archive, RejectsDamagedArchives)
+{
+    const u32 BlockSize = 1024;
+    FArchiveWriter Writer(BlockSize);
+    for (FArchiveTestFile& File : sArchiveTestFiles(BlockSize))
+    {
+        Writer.AddFile(File.Path, std::move(File.Data));
+    }
+    const std::wstring Path = UTF8ToWide(GetTestTempDirectory() + "Damaged.tpak");
+    TEST_CHECK(Writer.Write(Path));
+
+    std::vector<u8> Original;
+    {
+        FMappedFile Mapped;
+        TEST_CHECK(Mapped.Open(Path));
+        Original.assign(Mapped.GetData(), Mapped.GetData() + Mapped.GetSize());
+    }
+    FArchiveHeader Header;
+    memcpy(&Header, Original.data(), sizeof(Header));
+
+    // Changes the table of contents and stores its new hash, so only the checks of the values catch the damage
+    auto WithEntry = [&](u32 Index, const std::function<void(FArchiveEntry&)>& Change)
+    {
+        std::vector<u8> Data = Original;
+        FArchiveEntry* pEntry = reinterpret_cast<FArchiveEntry*>(&Data[size_t(Header.EntriesOffset) + Index * sizeof(FArchiveEntry)]);
+        Change(*pEntry);
+        FArchiveHeader* pHeader = reinterpret_cast<FArchiveHeader*>(Data.data());
+        pHeader->TableHash = Hash64(Data.data() + Header.EntriesOffset, size_t(Data.size() - Header.EntriesOffset));
+        return Data;
+    };
+    auto Opens = [&Path](const std::vector<u8>& Data)
+    {
+        FArchive Archive;
+        return WriteFileAtomic(Path, Data.data(), Data.size()) && Archive.Open(Path) && Archive.IsOpen();
+    };
+
+    TEST_CHECK(Opens(Original));
+    TEST_CHECK(!Opens(std::vector<u8>(Original.begin(), Original.begin() + 20)));
+    TEST_CHECK(!Opens(std::vector<u8>(Original.begin(), Original.end() - 1)));
+    std::vector<u8> Damaged = Original;
+    Damaged[size_t(Header.EntriesOffset) + 3] ^= 1;
+    TEST_CHECK(!Opens(Damaged));
+
+    // A size near 2^64 wrapped Size + BlockSize - 1 around to a single block, which passed the check of the block table
+    TEST_CHECK(!Opens(WithEntry(Header.NumEntries - 1, [](FArchiveEntry& Entry) { Entry.Size = ~u64(0) - 100; })));
+    TEST_CHECK(!Opens(WithEntry(Header.NumEntries - 1, [](FArchiveEntry& Entry) { Entry.Size = ~u64(0); })));
+    TEST_CHECK(!Opens(WithEntry(0, [&Header](FArchiveEntry& Entry) { Entry.FirstBlock = Header.NumBlocks + 1; })));
+    TEST_CHECK(!Opens(WithEntry(0, [&Header](FArchiveEntry& Entry) { Entry.NameOffset = Header.NamesSize; Entry.NameLength = 1; })));
+    TEST_CHECK(!Opens(WithEntry(1, [](FArchiveEntry& Entry) { Entry.PathHash = 0; })));
+
+    // Damaged block data opens, the reads of the blocks fail
+    FArchive Archive;
+    const std::vector<u8> Data = sCompressibleData(BlockSize * 5, 3);
+    Damaged = Original;
+    TEST_CHECK(WriteFileAtomic(Path, Damaged.data(), Damaged.size()) && Archive.Open(Path));
+    const u32 Entry = Archive.Find("Textures/Blocks.ttex");
+    TEST_CHECK(Entry != FArchive::INVALID_INDEX);
+    if (Entry == FArchive::INVALID_INDEX)
+    {
+        return;
+    }
+    const FArchiveEntry* pEntries = reinterpret_cast<const FArchiveEntry*>(&Original[size_t(Header.EntriesOffset)]);
+    const FArchiveBlock* pBlocks = reinterpret_cast<const FArchiveBlock*>(&Original[size_t(Header.BlocksOffset)]);
+    const FArchiveBlock& Block = pBlocks[pEntries[Entry].FirstBlock + 2];
+    TEST_CHECK(Block.CompressedSize < BlockSize);
+    memset(&Damaged[size_t(Block.Offset)], 0, Block.CompressedSize);
+    Archive.Close();
+    TEST_CHECK(WriteFileAtomic(Path, Damaged.data(), Damaged.size()) && Archive.Open(Path));
+
+    std::vector<u8> Range(BlockSize);
+    TEST_CHECK(Archive.Read(Entry, BlockSize, BlockSize, Range.data()) && memcmp(Range.data(), Data.data() + BlockSize, BlockSize) == 0);
+    TEST_CHECK(!Archive.Read(Entry, 2 * BlockSize + 10, 20, Range.data()));
+    std::vector<u8> Whole;
+    TEST_CHECK(!Archive.Read(Entry, Whole));
+    FThreadPool Pool(2);
+    TEST_CHECK(!Archive.Read(Entry, Whole, &Pool));
+}
+
+/** An archive with one large file of BlockSize blocks, a quarter of them incompressible so they are stored */
+static std::vector<u8> sWriteLargeArchive(const std::wstring& Path, u32 BlockSize, u32 NumBlocks, FThreadPool* pPool)
+{
+    std::vector<u8> Data;
+    for (u32 b = 0; b < NumBlocks; ++b)
+    {
+        const std::vector<u8> Block = b % 4 == 3 ? sRandomData(BlockSize, b) : sCompressibleData(BlockSize, b);
+        Data.insert(Data.end(), Block.begin(), Block.end());
+    }
+    FArchiveWriter Writer(BlockSize);
+    Writer.AddFile("Large.bin", std::vector<u8>(Data));
+    TEST_CHECK(Writer.Write(Path, pPool));
+    return Data;
+}
+
+TOPIA_TEST(Archive, ThreadPoolReadsManyBlocks)
+{
+    const u32 BlockSize = 4096;
+    FThreadPool Pool(3);
+    const std::wstring Path = UTF8ToWide(GetTestTempDirectory() + "Large.tpak");
+    const std::vector<u8> Data = sWriteLargeArchive(Path, BlockSize, 97, &Pool);
+
+    // Blocks are compressed on the pool in any order, the archive doesn't depend on it
+    std::vector<u8> Pooled, Serial;
+    {
+        FMappedFile Mapped;
+        TEST_CHECK(Mapped.Open(Path));
+        Pooled.assign(Mapped.GetData(), Mapped.GetData() + Mapped.GetSize());
+    }
+    const std::wstring SerialPath = UTF8ToWide(GetTestTempDirectory() + "LargeSerial.tpak");
+    sWriteLargeArchive(SerialPath, BlockSize, 97, nullptr);
+    {
+        FMappedFile Mapped;
+        TEST_CHECK(Mapped.Open(SerialPath));
+        Serial.assign(Mapped.GetData(), Mapped.GetData() + Mapped.GetSize());
+    }
+    TEST_CHECK(Pooled == Serial);
+
+    FArchive Archive;
+    TEST_CHECK(Archive.Open(Path));
+    const u32 Entry = Archive.Find("Large.bin");
+    TEST_CHECK(Entry != FArchive::INVALID_INDEX);
+    if (Entry == FArchive::INVALID_INDEX)
+    {
+        return;
+    }
+    std::vector<u8> Whole;
+    TEST_CHECK(Archive.Read(Entry, Whole, &Pool) && Whole == Data);
+
+    // Ranges of many blocks with partial blocks at both ends, the pool decompresses them at the same time
+    std::mt19937 Random(46);
+    for (u32 Trial = 0; Trial < 50; ++Trial)
+    {
+        const u64 Offset = Random() % Data.size();
+        const u64 Size = Random() % (Data.size() - Offset + 1);
+        std::vector<u8> Range(size_t(Size) + 1, 0xCD);
+        TEST_CHECK(Archive.Read(Entry, Offset, Size, Range.data(), &Pool));
+        TEST_CHECK(Size == 0 || memcmp(Range.data(), Data.data() + Offset, size_t(Size)) == 0);
+        TEST_CHECK(Range[size_t(Size)] == 0xCD);
+    }
+}
+
+TOPIA_BENCHMARK(Archive, MultiBlockRead)
+{
+    const u32 BlockSize = ARCHIVE_DEFAULT_BLOCK_SIZE;
+    const u32 NumBlocks = 1024;
+    FThreadPool Pool;
+    const std::wstring Path = UTF8ToWide(GetTestTempDirectory() + "Benchmark.tpak");
+    const std::vector<u8> Data = sWriteLargeArchive(Path, BlockSize, NumBlocks, &Pool);
+
+    FArchive Archive;
+    TEST_CHECK(Archive.Open(Path));
+    const u32 Entry = Archive.Find("Large.bin");
+    TEST_CHECK(Entry != FArchive::INVALID_INDEX);
+    if (Entry == FArchive::INVALID_INDEX)
+    {
+        return;
+    }
+
+    // Best of a few reads of the whole file, the first one also faults the mapping in
+    std::vector<u8> Read(Data.size());
+    for (FThreadPool* pPool : { static_cast<FThreadPool*>(nullptr), &Pool })
+    {
+        double Best = 1.0e30;
+        for (u32 Run = 0; Run < 5; ++Run)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            TEST_CHECK(Archive.Read(Entry, 0, Read.size(), Read.data(), pPool));
+            Best = std::min(Best, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+        }
+        TEST_CHECK(Read == Data);
+        printf("  %u blocks of %u KB, %s: %.2f ms, %.0f MB/s\n", NumBlocks, BlockSize / 1024,
+            pPool != nullptr ? "pool" : "calling thread", Best * 1000.0, double(Data.size()) / Best / (1024.0 * 1024.0));
+    }
+    printf("  %u threads in the pool besides the calling thread\n", Pool.GetNumThreads());
+}
@@ -0,0 +1,254 @@
+#include "TestFramework.h"
+
+#include <FileSystem/AsyncIO.h>
+#include <FileSystem/FileUtils.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+
+using namespace topia;
+
+/** The thread pool everywhere and io_uring where the kernel allows it */
+static std::vector<EIOBackend> sBackends()
+{
+    std::vector<EIOBackend> Backends = { EIOBackend::Threads };
+    if (FAsyncIO(1).GetBackend() == EIOBackend::IORing)
+    {
+        Backends.push_back(EIOBackend::IORing);
+    }
+    return Backends;
+}
+
+static std::shared_ptr<FAsyncFile> sOpenTestFile(std::vector<u8>& OutData)
+{
+    OutData.resize((1 << 20) + 123);
+    std::mt19937 Random(7);
+    for (u8& Byte : OutData)
+    {
+        Byte = u8(Random());
+    }
+    const std::wstring Path = UTF8ToWide(GetTestTempDirectory() + "AsyncIO.bin");
+    std::shared_ptr<FAsyncFile> File = std::make_shared<FAsyncFile>();
+    const bool bOpen = WriteFileAtomic(Path, OutData.data(), OutData.size()) && File->Open(Path);
+    TEST_CHECK(bOpen && File->GetSize() == OutData.size());
+    return File;
+}
+
+/** A read whose callback holds up its I/O thread until Release, so the requests after it stay queued */
+struct FBlockingRead
+{
+    FIORequestHandle Handle;
+    std::promise<void> Started;
+    std::promise<void> Release;
+
+    FBlockingRead(FAsyncIO& IO, const std::shared_ptr<FAsyncFile>& File, u8* pDestination)
+    {
+        FReadRequest Request;
+        Request.File = File;
+        Request.Size = 16;
+        Request.pDestination = pDestination;
+        std::shared_future<void> Released = Release.get_future().share();
+        Request.OnComplete = [this, Released](const FIOResult&)
+        {
+            Started.set_value();
+            Released.wait();
+        };
+        Handle = IO.Read(std::move(Request));
+        Started.get_future().wait();
+    }
+};
+
+TOPIA_TEST(AsyncIO, ReadsMatchTheFile)
+{
+    std::vector<u8> Data;
+    const std::shared_ptr<FAsyncFile> File = sOpenTestFile(Data);
+    const u64 FileSize = Data.size();
+
+    for (EIOBackend Backend : sBackends())
+    {
+        FAsyncIO IO(4, Backend);
+        TEST_CHECK(IO.GetBackend() == Backend && IO.GetQueueDepth() == 4);
+
+        // Many more reads than the queue depth, of every size up to the whole file
+        std::mt19937 Random(11);
+        const u32 NumReads = 300;
+        std::vector<FReadRequest> Requests(NumReads);
+        std::vector<std::vector<u8>> Destinations(NumReads);
+        for (u32 r = 0; r < NumReads; ++r)
+        {
+            Requests[r].File = File;
+            Requests[r].Size = r == 0 ? FileSize : Random() % (r % 10 == 0 ? FileSize : 9000);
+            Requests[r].Offset = Random() % (FileSize - Requests[r].Size + 1);
+            Requests[r].Priority = EIOPriority(r % 4);
+            Destinations[r].resize(size_t(Requests[r].Size));
+            Requests[r].pDestination = Destinations[r].data();
+        }
+        std::vector<FIORequestHandle> Handles(NumReads);
+        IO.ReadBatch(Requests.data(), NumReads, Handles.data());
+        IO.WaitIdle();
+
+        for (u32 r = 0; r < NumReads; ++r)
+        {
+            const FIOResult Result = Handles[r].GetResult();
+            TEST_CHECK(Handles[r].IsDone() && Result.Status == EIOStatus::Completed && Result.BytesRead == Destinations[r].size());
+            const u8* pExpected = Data.data() + size_t(Requests[r].Offset);
+            TEST_CHECK(Destinations[r].empty() || memcmp(Destinations[r].data(), pExpected, Destinations[r].size()) == 0);
+        }
+
+        // Reads past the end stop at the end of the file, reads of a closed file fail
+        std::vector<u8> Tail(1000, 0);
+        FReadRequest Request;
+        Request.File = File;
+        Request.Offset = FileSize - 100;
+        Request.Size = Tail.size();
+        Request.pDestination = Tail.data();
+        FIOResult Result = IO.Read(Request).Wait();
+        TEST_CHECK(Result.Status == EIOStatus::Completed && Result.BytesRead == 100);
+        TEST_CHECK(memcmp(Tail.data(), Data.data() + FileSize - 100, 100) == 0);
+
+        Request.Offset = FileSize + 5;
+        Result = IO.Read(Request).Wait();
+        TEST_CHECK(Result.Status == EIOStatus::Completed && Result.BytesRead == 0);
+
+        Request.File = std::make_shared<FAsyncFile>();
+        Request.Offset = 0;
+        Result = IO.Read(Request).Wait();
+        TEST_CHECK(Result.Status == EIOStatus::Failed && Result.BytesRead == 0);
+    }
+
+    FAsyncFile Missing;
+    TEST_CHECK(!Missing.Open(UTF8ToWide(GetTestTempDirectory() + "AsyncIOMissing.bin")) && !Missing.IsOpen());
+    TEST_CHECK(!Missing.Open(UTF8ToWide(GetTestTempDirectory())) && !Missing.IsOpen());
+}
+
+TOPIA_TEST(AsyncIO, CallbackCanWaitOnItsRequest)
+{
+    std::vector<u8> Data;
+    const std::shared_ptr<FAsyncFile> File = sOpenTestFile(Data);
+
+    for (EIOBackend Backend : sBackends())
+    {
+        FAsyncIO IO(2, Backend);
+        std::vector<u8> Destination(4096);
+
+        // The callback waits for the handle to be stored, then waits on it, which returns at once because the result is published first
+        std::mutex HandleMutex;
+        FIORequestHandle Handle;
+        FIOResult CallbackResult, WaitResult;
+        FReadRequest Request;
+        Request.File = File;
+        Request.Offset = 100;
+        Request.Size = Destination.size();
+        Request.pDestination = Destination.data();
+        Request.OnComplete = [&](const FIOResult& Result)
+        {
+            std::lock_guard<std::mutex> Lock(HandleMutex);
+            CallbackResult = Result;
+            WaitResult = Handle.Wait();
+        };
+        {
+            std::lock_guard<std::mutex> Lock(HandleMutex);
+            Handle = IO.Read(std::move(Request));
+        }
+
+        // WaitIdle returns after the callback
+        IO.WaitIdle();
+        TEST_CHECK(CallbackResult.Status == EIOStatus::Completed && CallbackResult.BytesRead == Destination.size());
+        TEST_CHECK(WaitResult.Status == EIOStatus::Completed && WaitResult.BytesRead == Destination.size());
+        TEST_CHECK(memcmp(Destination.data(), Data.data() + 100, Destination.size()) == 0);
+    }
+}
+
+TOPIA_TEST(AsyncIO, PrioritiesAndCancellation)
+{
+    std::vector<u8> Data;
+    const std::shared_ptr<FAsyncFile> File = sOpenTestFile(Data);
+
+    for (EIOBackend Backend : sBackends())
+    {
+        // A queue depth of 1 and a blocked read keep everything else queued
+        FAsyncIO IO(1, Backend);
+        u8 Destination[5][16];
+        FBlockingRead Blocking(IO, File, Destination[0]);
+        TEST_CHECK(!IO.Cancel(Blocking.Handle));
+
+        std::mutex OrderMutex;
+        std::vector<EIOPriority> Order;
+        std::vector<EIOStatus> Statuses;
+        FReadRequest Requests[4];
+        const EIOPriority Priorities[4] = { EIOPriority::Low, EIOPriority::High, EIOPriority::Normal, EIOPriority::Critical };
+        for (u32 r = 0; r < 4; ++r)
+        {
+            const EIOPriority Priority = Priorities[r];
+            Requests[r].File = File;
+            Requests[r].Size = 16;
+            Requests[r].pDestination = Destination[r + 1];
+            Requests[r].Priority = Priority;
+            Requests[r].OnComplete = [&OrderMutex, &Order, &Statuses, Priority](const FIOResult& Result)
+            {
+                std::lock_guard<std::mutex> Lock(OrderMutex);
+                Order.push_back(Priority);
+                Statuses.push_back(Result.Status);
+            };
+        }
+        FIORequestHandle Handles[4];
+        IO.ReadBatch(Requests, 4, Handles);
+
+        // The callback of a cancelled request runs on the thread that cancels it, and only once
+        TEST_CHECK(IO.Cancel(Handles[2]));
+        TEST_CHECK(!IO.Cancel(Handles[2]));
+        TEST_CHECK(Handles[2].IsDone() && Handles[2].GetResult().Status == EIOStatus::Cancelled);
+        TEST_CHECK(Order.size() == 1 && Order[0] == EIOPriority::Normal && Statuses[0] == EIOStatus::Cancelled);
+
+        Blocking.Release.set_value();
+        IO.WaitIdle();
+        TEST_CHECK(Blocking.Handle.GetResult().Status == EIOStatus::Completed);
+        const std::vector<EIOPriority> Expected = { EIOPriority::Normal, EIOPriority::Critical, EIOPriority::High, EIOPriority::Low };
+        TEST_CHECK(Order == Expected);
+        for (u32 r : { 0u, 1u, 3u })
+        {
+            TEST_CHECK(Handles[r].Wait().Status == EIOStatus::Completed && memcmp(Destination[r + 1], Data.data(), 16) == 0);
+        }
+    }
+}
+
+TOPIA_TEST(AsyncIO, DestructionCancelsQueuedRequests)
+{
+    std::vector<u8> Data;
+    const std::shared_ptr<FAsyncFile> File = sOpenTestFile(Data);
+
+    for (EIOBackend Backend : sBackends())
+    {
+        std::vector<u8> Destination(16 * 9);
+        FIORequestHandle Handles[8];
+        std::unique_ptr<FBlockingRead> Blocking;
+        std::thread Releaser;
+        {
+            FAsyncIO IO(1, Backend);
+            Blocking.reset(new FBlockingRead(IO, File, Destination.data()));
+            FReadRequest Requests[8];
+            for (u32 r = 0; r < 8; ++r)
+            {
+                Requests[r].File = File;
+                Requests[r].Size = 16;
+                Requests[r].pDestination = Destination.data() + 16 * (r + 1);
+            }
+            IO.ReadBatch(Requests, 8, Handles);
+
+            // The destructor cancels the queue, then waits for the read in progress
+            Releaser = std::thread([&Blocking]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                Blocking->Release.set_value();
+            });
+        }
+        Releaser.join();
+
+        TEST_CHECK(Blocking->Handle.GetResult().Status == EIOStatus::Completed);
+        for (const FIORequestHandle& Handle : Handles)
+        {
+            TEST_CHECK(Handle.IsDone() && Handle.GetResult().Status == EIOStatus::Cancelled);
+        }
+    }
+}
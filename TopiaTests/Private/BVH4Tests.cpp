@@ -0,0 +1,212 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <BVH4.h>
+#include <Quat.h>
+
+#include <cfloat>
+
+using namespace topia;
+
+/** Random boxes in a cube of size 100, clustered around a few centers so the tree has to handle uneven densities */
+static std::vector<AABox> sRandomScene(std::mt19937& Random, uint Count)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> Size(0.01f, 2.0f);
+    Vec3 Clusters[8];
+    for (Vec3& Cluster : Clusters)
+        Cluster = Vec3(50.0f * Unit(Random), 50.0f * Unit(Random), 50.0f * Unit(Random));
+
+    std::vector<AABox> Boxes(Count);
+    for (uint i = 0; i < Count; ++i)
+    {
+        const Vec3 Center = (i % 3 == 0) ? Vec3(50.0f * Unit(Random), 50.0f * Unit(Random), 50.0f * Unit(Random))
+                                         : Clusters[i % 8] + Vec3(5.0f * Unit(Random), 5.0f * Unit(Random), 5.0f * Unit(Random));
+        const Vec3 Extent(Size(Random), Size(Random), Size(Random));
+        Boxes[i] = AABox(Center - Extent, Center + Extent);
+    }
+    return Boxes;
+}
+
+/** Fraction where the ray enters the box, or FLT_MAX. The origin inside the box counts as a hit at 0. */
+static float sRayBox(Vec3Arg Origin, Vec3Arg Direction, const AABox& Box)
+{
+    const float Fraction = RayAABox(Origin, RayInvDirection(Direction), Box.mMin, Box.mMax);
+    return Fraction == FLT_MAX ? FLT_MAX : std::max(Fraction, 0.0f);
+}
+
+/** Every query of the tree against brute force over Boxes */
+static void sCheckQueries(const BVH4& Tree, const std::vector<AABox>& Boxes, std::mt19937& Random)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    const uint Count = uint(Boxes.size());
+
+    // Every primitive is in exactly one leaf
+    std::vector<u32> Indices = Tree.GetPrimitiveIndices();
+    std::sort(Indices.begin(), Indices.end());
+    bool bPermutation = Indices.size() == Count;
+    for (uint i = 0; bPermutation && i < Count; ++i)
+        bPermutation = Indices[i] == i;
+    TEST_CHECK(bPermutation);
+
+    // Closest hit and any hit rays, the visitor does the exact test for the primitives in the leaves the ray reaches
+    for (uint r = 0; r < 200; ++r)
+    {
+        const Vec3 Origin(60.0f * Unit(Random), 60.0f * Unit(Random), 60.0f * Unit(Random));
+        Vec3 Direction(Unit(Random), Unit(Random), Unit(Random));
+        if (r % 10 == 0)
+            Direction = Vec3(0.0f, 0.0f, 1.0f); // Parallel to two axis
+        Direction *= 150.0f;
+
+        float Expected = 1.0f;
+        for (const AABox& Box : Boxes)
+            Expected = std::min(Expected, sRayBox(Origin, Direction, Box));
+
+        uint NumVisited = 0;
+        const float Closest = Tree.CastRay(Origin, Direction, 1.0f, [&](u32 Primitive, float Closest)
+        {
+            ++NumVisited;
+            return std::min(Closest, sRayBox(Origin, Direction, Boxes[Primitive]));
+        });
+        TEST_CHECK(Closest == Expected);
+        TEST_CHECK(NumVisited <= Count);
+
+        const float AnyHit = Tree.CastRay(Origin, Direction, 1.0f, [&](u32 Primitive, float Closest)
+        {
+            return sRayBox(Origin, Direction, Boxes[Primitive]) < Closest ? -FLT_MAX : Closest;
+        });
+        TEST_CHECK(AnyHit == (Expected < 1.0f ? -FLT_MAX : 1.0f));
+    }
+
+    // Box queries report every overlapping primitive once, the others only when they share a leaf with one
+    for (uint q = 0; q < 200; ++q)
+    {
+        const Vec3 Center(60.0f * Unit(Random), 60.0f * Unit(Random), 60.0f * Unit(Random));
+        const Vec3 Extent = Vec3::sReplicate(q % 2 == 0 ? 2.0f : 15.0f);
+        const AABox Query(Center - Extent, Center + Extent);
+
+        std::vector<u32> Visits(Count, 0);
+        Tree.CollideAABox(Query, [&Visits](u32 Primitive) { ++Visits[Primitive]; });
+        bool bCorrect = true;
+        for (uint i = 0; i < Count; ++i)
+            bCorrect = bCorrect && Visits[i] <= 1 && (!Query.Overlaps(Boxes[i]) || Visits[i] == 1);
+        TEST_CHECK(bCorrect);
+    }
+
+    // Frustum queries, a rotated box shaped frustum
+    for (uint q = 0; q < 50; ++q)
+    {
+        const Mat44 Rotation = Mat44::sRotation(Quat::sRotation(Vec3(Unit(Random), Unit(Random), 1.0f).Normalized(), TOPIA_PI * Unit(Random)));
+        const Vec3 Center(40.0f * Unit(Random), 40.0f * Unit(Random), 40.0f * Unit(Random));
+        Plane Planes[Frustum::NumPlanes];
+        for (uint p = 0; p < Frustum::NumPlanes; ++p)
+        {
+            const Vec3 Normal = (p % 2 == 0 ? 1.0f : -1.0f) * Rotation.GetColumn3(p / 2);
+            Planes[p] = Plane::sFromPointAndNormal(Center - (10.0f + 5.0f * float(p)) * Normal, Normal);
+        }
+        const Frustum ViewFrustum(Planes);
+
+        std::vector<u32> Visits(Count, 0);
+        Tree.CollideFrustum(ViewFrustum, [&Visits](u32 Primitive) { ++Visits[Primitive]; });
+        bool bCorrect = true;
+        for (uint i = 0; i < Count; ++i)
+            bCorrect = bCorrect && Visits[i] <= 1 && (!ViewFrustum.Overlaps(Boxes[i]) || Visits[i] == 1);
+        TEST_CHECK(bCorrect);
+    }
+}
+
+/** Bounds of every child contain the bounds of the primitives below it */
+static bool sBoundsContainPrimitives(const BVH4& Tree, const std::vector<AABox>& Boxes, u32 Child, AABox& outBounds)
+{
+    outBounds = AABox();
+    if (Child & BVH4::cLeafFlag)
+    {
+        const u32 Start = (Child & ~BVH4::cLeafFlag) >> BVH4::cLeafCountBits;
+        for (u32 p = Start; p < Start + (Child & BVH4::cMaxLeafSize); ++p)
+            outBounds.Encapsulate(Boxes[Tree.GetPrimitiveIndices()[p]]);
+        return true;
+    }
+
+    const BVH4::Node& Node = Tree.GetNodes()[Child];
+    for (uint i = 0; i < 4; ++i)
+    {
+        if (Node.mChild[i] == BVH4::cInvalidChild)
+            continue;
+        AABox ChildBounds;
+        if (Node.mChild[i] <= Child || !sBoundsContainPrimitives(Tree, Boxes, Node.mChild[i], ChildBounds))
+            return false;
+        const AABox NodeBounds(Vec3(Node.mMinX[i], Node.mMinY[i], Node.mMinZ[i]), Vec3(Node.mMaxX[i], Node.mMaxY[i], Node.mMaxZ[i]));
+        if (!NodeBounds.Contains(ChildBounds))
+            return false;
+        outBounds.Encapsulate(ChildBounds);
+    }
+    return true;
+}
+
+TOPIA_TEST(BVH4, QueriesMatchBruteForce)
+{
+    std::mt19937 Random(32);
+    for (uint Count : { 1u, 3u, 17u, 5000u })
+    {
+        std::vector<AABox> Boxes = sRandomScene(Random, Count);
+        BVH4 Tree;
+        TEST_CHECK(Tree.Build(Boxes.data(), Count));
+        AABox Bounds;
+        TEST_CHECK(sBoundsContainPrimitives(Tree, Boxes, 0, Bounds));
+        sCheckQueries(Tree, Boxes, Random);
+
+        // Move every box, the refitted tree has the same structure and must still find everything
+        std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+        for (AABox& Box : Boxes)
+        {
+            Box.Translate(Vec3(10.0f * Unit(Random), 10.0f * Unit(Random), 10.0f * Unit(Random)));
+            Box.ExpandBy(Vec3::sReplicate(0.5f * (Unit(Random) + 1.0f)));
+        }
+        Tree.Refit(Boxes.data());
+        TEST_CHECK(sBoundsContainPrimitives(Tree, Boxes, 0, Bounds));
+        TEST_CHECK(Tree.GetBounds().Contains(Bounds) && Bounds.Contains(Tree.GetBounds()));
+        sCheckQueries(Tree, Boxes, Random);
+    }
+}
+
+TOPIA_TEST(BVH4, DegenerateInput)
+{
+    // Identical boxes have no SAH split, the median split has to take over
+    std::mt19937 Random(33);
+    std::vector<AABox> Boxes(1000, AABox(Vec3::sReplicate(1.0f), Vec3::sReplicate(2.0f)));
+    BVH4 Tree;
+    TEST_CHECK(Tree.Build(Boxes.data(), uint(Boxes.size())));
+    sCheckQueries(Tree, Boxes, Random);
+
+    // Empty input builds an empty tree that reports nothing
+    TEST_CHECK(Tree.Build(nullptr, 0));
+    TEST_CHECK(Tree.GetNodes().empty());
+    TEST_CHECK(Tree.CastRay(Vec3::sZero(), Vec3::sAxisX(), 1.0f, [](u32, float) { return 0.0f; }) == 1.0f);
+
+    // More primitives than a leaf reference can address fail in every build configuration, the input isn't read
+    TEST_CHECK(!Tree.Build(nullptr, BVH4::cMaxPrimitives + 1));
+    TEST_CHECK(Tree.GetNodes().empty() && Tree.GetPrimitiveIndices().empty());
+}
+
+TOPIA_TEST(BVH4, ThreadPoolBuildIsIdentical)
+{
+    // Large enough for the top levels to be built on the pool
+    std::mt19937 Random(34);
+    const std::vector<AABox> Boxes = sRandomScene(Random, 100000);
+    BVH4 Serial, Pooled;
+    TEST_CHECK(Serial.Build(Boxes.data(), uint(Boxes.size())));
+
+    FThreadPool Pool(3);
+    BVH4BuildSettings Settings;
+    Settings.mThreadPool = &Pool;
+    TEST_CHECK(Pooled.Build(Boxes.data(), uint(Boxes.size()), Settings));
+
+    // The nodes are collapsed depth first after the build, so the order in which threads allocated binary nodes doesn't show
+    TEST_CHECK(Serial.GetPrimitiveIndices() == Pooled.GetPrimitiveIndices());
+    TEST_CHECK(Serial.GetNodes().size() == Pooled.GetNodes().size());
+    bool bSame = Serial.GetNodes().size() == Pooled.GetNodes().size();
+    for (size_t n = 0; bSame && n < Serial.GetNodes().size(); ++n)
+        bSame = memcmp(&Serial.GetNodes()[n], &Pooled.GetNodes()[n], sizeof(BVH4::Node)) == 0;
+    TEST_CHECK(bSame);
+    sCheckQueries(Pooled, Boxes, Random);
+}
@@ -0,0 +1,352 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <AABox4.h>
+#include <OrientedBox.h>
+#include <Plane.h>
+#include <Quat.h>
+#include <RayAABox.h>
+#include <Sphere.h>
+
+#include <cfloat>
+
+using namespace topia;
+
+/** 4 boxes as structure of arrays, the layout the AABox4 kernels take */
+struct FBoxes4
+{
+    AABox Box[4];
+    Vec4 MinX = Vec4::sZero(), MinY = Vec4::sZero(), MinZ = Vec4::sZero(), MaxX = Vec4::sZero(), MaxY = Vec4::sZero(), MaxZ = Vec4::sZero();
+
+    void Pack()
+    {
+        for (uint i = 0; i < 4; ++i)
+        {
+            MinX[i] = Box[i].mMin.GetX();
+            MinY[i] = Box[i].mMin.GetY();
+            MinZ[i] = Box[i].mMin.GetZ();
+            MaxX[i] = Box[i].mMax.GetX();
+            MaxY[i] = Box[i].mMax.GetY();
+            MaxZ[i] = Box[i].mMax.GetZ();
+        }
+    }
+};
+
+/** Random box in [-4, 4]^3, every 8th one is flat along an axis and every 16th one is a point */
+static AABox sRandomBox(std::mt19937& Random)
+{
+    std::uniform_real_distribution<float> Coordinate(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> Size(0.0f, 2.0f);
+    const uint Kind = Random() % 16;
+    const Vec3 Min(Coordinate(Random), Coordinate(Random), Coordinate(Random));
+    Vec3 Extent(Size(Random), Size(Random), Size(Random));
+    if (Kind == 0)
+        Extent = Vec3::sZero();
+    else if (Kind == 1)
+        Extent.SetComponent(Random() % 3, 0.0f);
+    return AABox(Min, Min + Extent);
+}
+
+static Mat44 sRandomRotationTranslation(std::mt19937& Random)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    const Vec3 Translation(3.0f * Unit(Random), 3.0f * Unit(Random), 3.0f * Unit(Random));
+
+    // Some boxes share the orientation of the other box or are axis aligned, which makes the cross product axis degenerate
+    switch (Random() % 8)
+    {
+    case 0: return Mat44::sTranslation(Translation);
+    case 1: return Mat44::sRotationTranslation(Quat::sRotation(Vec3::sAxisZ(), 0.5f * TOPIA_PI), Translation);
+    default: break;
+    }
+    Vec3 Axis(Unit(Random), Unit(Random), Unit(Random));
+    if (Axis.LengthSq() < 1.0e-4f)
+        Axis = Vec3::sAxisX();
+    return Mat44::sRotationTranslation(Quat::sRotation(Axis.Normalized(), TOPIA_PI * Unit(Random)), Translation);
+}
+
+/** Corners of an oriented box in double precision */
+static void sCorners(const OrientedBox& Box, double outCorners[8][3])
+{
+    for (uint i = 0; i < 8; ++i)
+    {
+        const Vec3 Local((i & 1) ? Box.mHalfExtents.GetX() : -Box.mHalfExtents.GetX(), (i & 2) ? Box.mHalfExtents.GetY() : -Box.mHalfExtents.GetY(),
+            (i & 4) ? Box.mHalfExtents.GetZ() : -Box.mHalfExtents.GetZ());
+        for (uint c = 0; c < 3; ++c)
+        {
+            outCorners[i][c] = double(Box.mOrientation(c, 3));
+            for (uint k = 0; k < 3; ++k)
+                outCorners[i][c] += double(Box.mOrientation(c, k)) * double(Local[k]);
+        }
+    }
+}
+
+/**
+ * Largest gap between the projections of the corners of two boxes on the 15 candidate axis, in double precision from the world space
+ * corners instead of the relative rotation that OrientedBox::Overlaps uses. Positive when the boxes are separated, minus the penetration
+ * depth otherwise. Cross products of (nearly) parallel edges are skipped, the face axis cover that case.
+ */
+static double sSeparation(const OrientedBox& BoxA, const OrientedBox& BoxB)
+{
+    double CornersA[8][3], CornersB[8][3];
+    sCorners(BoxA, CornersA);
+    sCorners(BoxB, CornersB);
+
+    double Axis[15][3];
+    uint NumAxis = 0;
+    for (uint i = 0; i < 3; ++i)
+        for (uint c = 0; c < 3; ++c)
+        {
+            Axis[i][c] = BoxA.mOrientation(c, i);
+            Axis[3 + i][c] = BoxB.mOrientation(c, i);
+        }
+    NumAxis = 6;
+    for (uint i = 0; i < 3; ++i)
+        for (uint j = 0; j < 3; ++j)
+        {
+            const double* U = Axis[i];
+            const double* V = Axis[3 + j];
+            const double Cross[3] = { U[1] * V[2] - U[2] * V[1], U[2] * V[0] - U[0] * V[2], U[0] * V[1] - U[1] * V[0] };
+            const double Length = std::sqrt(Cross[0] * Cross[0] + Cross[1] * Cross[1] + Cross[2] * Cross[2]);
+            if (Length < 1.0e-3)
+                continue;
+            for (uint c = 0; c < 3; ++c)
+                Axis[NumAxis][c] = Cross[c] / Length;
+            ++NumAxis;
+        }
+
+    double Separation = -DBL_MAX;
+    for (uint a = 0; a < NumAxis; ++a)
+    {
+        double MinA = DBL_MAX, MaxA = -DBL_MAX, MinB = DBL_MAX, MaxB = -DBL_MAX;
+        for (uint i = 0; i < 8; ++i)
+        {
+            const double ProjectionA = CornersA[i][0] * Axis[a][0] + CornersA[i][1] * Axis[a][1] + CornersA[i][2] * Axis[a][2];
+            const double ProjectionB = CornersB[i][0] * Axis[a][0] + CornersB[i][1] * Axis[a][1] + CornersB[i][2] * Axis[a][2];
+            MinA = std::min(MinA, ProjectionA);
+            MaxA = std::max(MaxA, ProjectionA);
+            MinB = std::min(MinB, ProjectionB);
+            MaxB = std::max(MaxB, ProjectionB);
+        }
+        Separation = std::max(Separation, std::max(MinB - MaxA, MinA - MaxB));
+    }
+    return Separation;
+}
+
+/** Squared distance from a point to a box in double precision */
+static double sDistanceSq(const AABox& Box, Vec3Arg Point)
+{
+    double DistanceSq = 0.0;
+    for (uint c = 0; c < 3; ++c)
+    {
+        const double D = std::max(std::max(double(Box.mMin[c]) - double(Point[c]), double(Point[c]) - double(Box.mMax[c])), 0.0);
+        DistanceSq += D * D;
+    }
+    return DistanceSq;
+}
+
+TOPIA_TEST(BoundingVolume, AABox4VsBox)
+{
+    std::mt19937 Random(30);
+    uint NumOverlaps = 0;
+    for (uint Iteration = 0; Iteration < 20000; ++Iteration)
+    {
+        FBoxes4 Boxes;
+        for (AABox& Box : Boxes.Box)
+            Box = sRandomBox(Random);
+
+        // Touching boxes overlap, make a lane share a face with the query box now and then
+        const AABox Query = sRandomBox(Random);
+        if (Iteration % 4 == 0)
+            Boxes.Box[Iteration % 16 / 4] = AABox(Vec3(Query.mMax.GetX(), Query.mMin.GetY(), Query.mMin.GetZ()), Query.mMax + Vec3(1.0f, 0.0f, 0.0f));
+        Boxes.Pack();
+
+        const UVec4 Overlaps = AABox4VsBox(Query, Boxes.MinX, Boxes.MinY, Boxes.MinZ, Boxes.MaxX, Boxes.MaxY, Boxes.MaxZ);
+        for (uint i = 0; i < 4; ++i)
+        {
+            TEST_CHECK((Overlaps[i] != 0) == Query.Overlaps(Boxes.Box[i]));
+            NumOverlaps += Overlaps[i] != 0;
+        }
+    }
+    TEST_CHECK(NumOverlaps > 5000);
+}
+
+TOPIA_TEST(BoundingVolume, AABox4VsSphere)
+{
+    std::mt19937 Random(31);
+    std::uniform_real_distribution<float> Coordinate(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> Radius(0.0f, 2.0f);
+    for (uint Iteration = 0; Iteration < 20000; ++Iteration)
+    {
+        FBoxes4 Boxes;
+        for (AABox& Box : Boxes.Box)
+            Box = sRandomBox(Random);
+        Boxes.Pack();
+
+        const Sphere Ball(Vec3(Coordinate(Random), Coordinate(Random), Coordinate(Random)), Radius(Random));
+        const Vec4 DistanceSq = AABox4DistanceSqToPoint(Ball.mCenter, Boxes.MinX, Boxes.MinY, Boxes.MinZ, Boxes.MaxX, Boxes.MaxY, Boxes.MaxZ);
+        const UVec4 Overlaps = AABox4VsSphere(Ball.mCenter, Square(Ball.mRadius), Boxes.MinX, Boxes.MinY, Boxes.MinZ, Boxes.MaxX, Boxes.MaxY, Boxes.MaxZ);
+        for (uint i = 0; i < 4; ++i)
+        {
+            // The 4-wide kernel contracts with fused multiply adds, the scalar one doesn't, they agree up to rounding
+            const double Reference = sDistanceSq(Boxes.Box[i], Ball.mCenter);
+            TEST_CHECK(std::abs(DistanceSq[i] - Reference) <= 1.0e-5 * (1.0 + Reference));
+            TEST_CHECK(std::abs(Boxes.Box[i].GetSqDistanceTo(Ball.mCenter) - Reference) <= 1.0e-5 * (1.0 + Reference));
+            TEST_CHECK(Boxes.Box[i].Contains(Ball.mCenter) == (DistanceSq[i] == 0.0f));
+            if (std::abs(Reference - Square(double(Ball.mRadius))) > 1.0e-4)
+            {
+                const bool bExpected = Reference < Square(double(Ball.mRadius));
+                TEST_CHECK((Overlaps[i] != 0) == bExpected);
+                TEST_CHECK(Ball.Overlaps(Boxes.Box[i]) == bExpected);
+            }
+        }
+    }
+}
+
+TOPIA_TEST(BoundingVolume, AABoxBehindPlanes4)
+{
+    std::mt19937 Random(32);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    for (uint Iteration = 0; Iteration < 20000; ++Iteration)
+    {
+        const AABox Box = sRandomBox(Random);
+        Plane Planes[4];
+        for (uint i = 0; i < 4; ++i)
+        {
+            Vec3 Normal(Unit(Random), Unit(Random), Unit(Random));
+            // Axis aligned normals have zero components, the positive vertex must still be picked correctly
+            if (i == 3)
+                Normal = Unit(Random) < 0.0f ? -Vec3::sAxisX() : Vec3::sAxisX();
+            if (Normal.LengthSq() < 1.0e-4f)
+                Normal = Vec3::sAxisY();
+            Planes[i] = Plane::sFromPointAndNormal(Vec3(4.0f * Unit(Random), 4.0f * Unit(Random), 4.0f * Unit(Random)), Normal.Normalized());
+        }
+
+        Vec4 NormalX = Vec4::sZero(), NormalY = Vec4::sZero(), NormalZ = Vec4::sZero(), Constant = Vec4::sZero();
+        for (uint i = 0; i < 4; ++i)
+        {
+            NormalX[i] = Planes[i].GetNormal().GetX();
+            NormalY[i] = Planes[i].GetNormal().GetY();
+            NormalZ[i] = Planes[i].GetNormal().GetZ();
+            Constant[i] = Planes[i].GetConstant();
+        }
+        const UVec4 Behind = AABoxBehindPlanes4(Box, NormalX, NormalY, NormalZ, Constant);
+
+        for (uint i = 0; i < 4; ++i)
+        {
+            // All 8 corners in double precision against the scalar positive vertex
+            double MaxDistance = -DBL_MAX;
+            for (uint Corner = 0; Corner < 8; ++Corner)
+            {
+                const Vec3 Point((Corner & 1) ? Box.mMax.GetX() : Box.mMin.GetX(), (Corner & 2) ? Box.mMax.GetY() : Box.mMin.GetY(), (Corner & 4) ? Box.mMax.GetZ() : Box.mMin.GetZ());
+                double Distance = double(Planes[i].GetConstant());
+                for (uint c = 0; c < 3; ++c)
+                    Distance += double(Point[c]) * double(Planes[i].GetNormal()[c]);
+                MaxDistance = std::max(MaxDistance, Distance);
+            }
+            TEST_CHECK(std::abs(Planes[i].GetMaxSignedDistance(Box) - MaxDistance) < 1.0e-5);
+            if (std::abs(MaxDistance) > 1.0e-5)
+                TEST_CHECK((Behind[i] != 0) == (MaxDistance < 0.0));
+        }
+    }
+}
+
+TOPIA_TEST(BoundingVolume, AABox4Transform)
+{
+    std::mt19937 Random(33);
+    for (uint Iteration = 0; Iteration < 5000; ++Iteration)
+    {
+        FBoxes4 Boxes;
+        for (AABox& Box : Boxes.Box)
+            Box = sRandomBox(Random);
+        Boxes.Pack();
+
+        // Rotation, translation and a non-uniform, possibly mirroring, scale
+        const Mat44 Transform = sRandomRotationTranslation(Random) * Mat44::sScale(Vec3(1.5f, -0.5f, 2.0f));
+        AABox4Transform(Transform, Boxes.MinX, Boxes.MinY, Boxes.MinZ, Boxes.MaxX, Boxes.MaxY, Boxes.MaxZ);
+        for (uint i = 0; i < 4; ++i)
+        {
+            const AABox Reference = Boxes.Box[i].Transformed(Transform);
+            TEST_CHECK(Vec3(Boxes.MinX[i], Boxes.MinY[i], Boxes.MinZ[i]).IsClose(Reference.mMin, 1.0e-10f));
+            TEST_CHECK(Vec3(Boxes.MaxX[i], Boxes.MaxY[i], Boxes.MaxZ[i]).IsClose(Reference.mMax, 1.0e-10f));
+        }
+    }
+}
+
+TOPIA_TEST(BoundingVolume, RayAABox4)
+{
+    std::mt19937 Random(34);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    uint NumHits = 0;
+    for (uint Iteration = 0; Iteration < 50000; ++Iteration)
+    {
+        FBoxes4 Boxes;
+        for (AABox& Box : Boxes.Box)
+            Box = sRandomBox(Random);
+
+        // An invalid box never hits
+        if (Iteration % 8 == 0)
+            Boxes.Box[Iteration % 32 / 8] = AABox(Vec3::sReplicate(1.0f), Vec3::sReplicate(-1.0f));
+        Boxes.Pack();
+
+        // Zero direction components take the parallel path, some rays start inside a box
+        const Vec3 Origin(5.0f * Unit(Random), 5.0f * Unit(Random), 5.0f * Unit(Random));
+        Vec3 Direction(8.0f * Unit(Random), 8.0f * Unit(Random), 8.0f * Unit(Random));
+        for (uint c = 0; c < 3; ++c)
+            if (Random() % 4 == 0)
+                Direction.SetComponent(c, 0.0f);
+        const RayInvDirection InvDirection(Direction);
+
+        const Vec4 Fraction = RayAABox4(Origin, InvDirection, Boxes.MinX, Boxes.MinY, Boxes.MinZ, Boxes.MaxX, Boxes.MaxY, Boxes.MaxZ);
+        for (uint i = 0; i < 4; ++i)
+        {
+            const AABox& Box = Boxes.Box[i];
+            const float Scalar = Box.IsValid() ? RayAABox(Origin, InvDirection, Box.mMin, Box.mMax) : FLT_MAX;
+            TEST_CHECK(Fraction[i] == Scalar);
+            if (Fraction[i] == FLT_MAX)
+                continue;
+
+            // A hit enters the box at the returned fraction, or starts inside it
+            ++NumHits;
+            const Vec3 Entry = Origin + std::max(Fraction[i], 0.0f) * Direction;
+            const float Tolerance = 1.0e-4f * (1.0f + Direction.Length());
+            TEST_CHECK(AABox(Box.mMin - Vec3::sReplicate(Tolerance), Box.mMax + Vec3::sReplicate(Tolerance)).Contains(Entry));
+            TEST_CHECK((Fraction[i] <= 0.0f) == Box.Contains(Origin) || std::abs(Fraction[i]) < 1.0e-5f);
+        }
+    }
+    TEST_CHECK(NumHits > 1000);
+}
+
+TOPIA_TEST(BoundingVolume, OrientedBoxOverlaps)
+{
+    std::mt19937 Random(35);
+    std::uniform_real_distribution<float> Size(0.1f, 2.0f);
+    uint NumCompared = 0, NumOverlaps = 0;
+    for (uint Iteration = 0; Iteration < 20000; ++Iteration)
+    {
+        const OrientedBox BoxA(sRandomRotationTranslation(Random), Vec3(Size(Random), Size(Random), Size(Random)));
+        OrientedBox BoxB(sRandomRotationTranslation(Random), Vec3(Size(Random), Size(Random), Size(Random)));
+        if (Iteration % 8 == 0)
+            BoxB.mOrientation = Mat44::sTranslation(BoxB.mOrientation.GetTranslation()) * BoxA.mOrientation.GetRotation();
+
+        const bool bOverlaps = BoxA.Overlaps(BoxB);
+        TEST_CHECK(bOverlaps == BoxB.Overlaps(BoxA));
+
+        // Within rounding of touching either answer is fine, the epsilon makes the test lean towards overlapping
+        const double Separation = sSeparation(BoxA, BoxB);
+        if (std::abs(Separation) < 1.0e-3)
+            continue;
+        ++NumCompared;
+        NumOverlaps += bOverlaps;
+        TEST_CHECK(bOverlaps == (Separation < 0.0));
+
+        // The AABox overload is the oriented box with an identity rotation
+        const AABox Aligned = BoxB.GetAABox();
+        const OrientedBox AlignedBox(Mat44::sTranslation(Aligned.GetCenter()), Aligned.GetExtent());
+        const double AlignedSeparation = sSeparation(BoxA, AlignedBox);
+        if (std::abs(AlignedSeparation) > 1.0e-3)
+            TEST_CHECK(BoxA.Overlaps(Aligned) == (AlignedSeparation < 0.0));
+    }
+    TEST_CHECK(NumCompared > 19000);
+    TEST_CHECK(NumOverlaps > 2000 && NumOverlaps < NumCompared - 2000);
+}
@@ -0,0 +1,241 @@
+#include "TestFramework.h"
+
+#include <CookedMesh.h>
+#include <StaticMesh.h>
+#include <DerivedData/DerivedDataCache.h>
+#include <FileSystem/FileUtils.h>
+#include <FileSystem/MappedFile.h>
+
+#include <cstddef>
+#include <cstring>
+
+using namespace topia;
+
+/** Path in the directory of the suite, which the cache constructor creates */
+static std::wstring sTempPath(const char* pName)
+{
+    const std::wstring Directory = UTF8ToWide(GetTestTempDirectory() + "CookedMesh/");
+    FDerivedDataCache CreateDirectory(Directory, ~u64(0));
+    return Directory + UTF8ToWide(pName);
+}
+
+static std::vector<u8> sReadFile(const std::wstring& Path)
+{
+    FMappedFile File;
+    if (!File.Open(Path))
+    {
+        return std::vector<u8>();
+    }
+    return std::vector<u8>(File.GetData(), File.GetData() + File.GetSize());
+}
+
+/** A mesh with every stream the cooked format stores */
+static void sBuildMesh(FStaticMesh& Mesh)
+{
+    FPrimitiveDesc Desc(EPrimitiveType::Torus);
+    Mesh.LoadPrimitive(Desc);
+    Mesh.Optimize();
+    Mesh.BuildMeshlets();
+    Mesh.Quantize();
+    Mesh.GenerateLODs();
+}
+
+/** Same elements, and with bView the elements are read from the mapped file in place */
+template <typename T>
+static bool sStreamsEqual(const TMeshStream<T>& A, const TMeshStream<T>& B, bool bView)
+{
+    if (A.Num() != B.Num() || (A.Num() > 0 && memcmp(A.GetData(), B.GetData(), A.Num() * sizeof(T)) != 0))
+    {
+        return false;
+    }
+    return !bView || B.IsEmpty() || (B.IsView() && reinterpret_cast<uintptr_t>(B.GetData()) % COOKED_MESH_ALIGNMENT == 0);
+}
+
+static bool sMeshesEqual(const FStaticMesh& A, const FStaticMesh& B, bool bView)
+{
+    bool bEqual = A.GetSections().size() == B.GetSections().size() && A.GetLODInfos().size() == B.GetLODInfos().size();
+    bEqual = bEqual && memcmp(&A.GetBounds(), &B.GetBounds(), sizeof(AABox)) == 0;
+    for (size_t l = 0; bEqual && l < A.GetLODInfos().size(); ++l)
+    {
+        bEqual = memcmp(&A.GetLODInfos()[l], &B.GetLODInfos()[l], sizeof(FStaticMeshLODInfo)) == 0;
+    }
+    for (size_t s = 0; bEqual && s < A.GetSections().size(); ++s)
+    {
+        const FStaticMeshSection& SA = A.GetSections()[s];
+        const FStaticMeshSection& SB = B.GetSections()[s];
+        bEqual = SA.NumVertices == SB.NumVertices && SA.MaterialIndex == SB.MaterialIndex && SA.LODs.size() == SB.LODs.size()
+            && sStreamsEqual(SA.Positions, SB.Positions, bView) && sStreamsEqual(SA.Normals, SB.Normals, bView)
+            && sStreamsEqual(SA.Tangents, SB.Tangents, bView) && sStreamsEqual(SA.TexCoords[0], SB.TexCoords[0], bView)
+            && sStreamsEqual(SA.TexCoords[1], SB.TexCoords[1], bView) && sStreamsEqual(SA.Colors, SB.Colors, bView)
+            && sStreamsEqual(SA.Indices16, SB.Indices16, bView) && sStreamsEqual(SA.Indices32, SB.Indices32, bView)
+            && sStreamsEqual(SA.Meshlets.Meshlets, SB.Meshlets.Meshlets, bView) && sStreamsEqual(SA.Meshlets.Bounds, SB.Meshlets.Bounds, bView)
+            && sStreamsEqual(SA.Meshlets.Vertices, SB.Meshlets.Vertices, bView) && sStreamsEqual(SA.Meshlets.Triangles, SB.Meshlets.Triangles, bView)
+            && SA.Quantized.Precision == SB.Quantized.Precision
+            && memcmp(&SA.Quantized.PositionQuantization, &SB.Quantized.PositionQuantization, sizeof(FPositionQuantization)) == 0
+            && sStreamsEqual(SA.Quantized.Positions, SB.Quantized.Positions, bView) && sStreamsEqual(SA.Quantized.Normals, SB.Quantized.Normals, bView)
+            && sStreamsEqual(SA.Quantized.Tangents, SB.Quantized.Tangents, bView)
+            && sStreamsEqual(SA.Quantized.TexCoords[0], SB.Quantized.TexCoords[0], bView)
+            && sStreamsEqual(SA.Quantized.TexCoords[1], SB.Quantized.TexCoords[1], bView)
+            && sStreamsEqual(SA.Quantized.Colors, SB.Quantized.Colors, bView);
+        for (size_t l = 0; bEqual && l < SA.LODs.size(); ++l)
+        {
+            bEqual = sStreamsEqual(SA.LODs[l].Indices16, SB.LODs[l].Indices16, bView) && sStreamsEqual(SA.LODs[l].Indices32, SB.LODs[l].Indices32, bView);
+        }
+    }
+    return bEqual;
+}
+
+TOPIA_TEST(CookedMesh, SaveAndLoadRoundTrip)
+{
+    FStaticMesh Mesh;
+    sBuildMesh(Mesh);
+    TEST_CHECK(Mesh.GetNumLODs() > 1 && !Mesh.GetSections()[0].Meshlets.Meshlets.IsEmpty());
+
+    const std::wstring Path = sTempPath("RoundTrip.tmesh");
+    TEST_CHECK(Mesh.SaveCooked(Path));
+
+    // Every stream of the loaded mesh is an aligned view into the mapped file, nothing is copied
+    for (bool bVerifyHash : { false, true })
+    {
+        FStaticMesh Loaded;
+        TEST_CHECK(Loaded.LoadCooked(Path, bVerifyHash));
+        TEST_CHECK(sMeshesEqual(Mesh, Loaded, true));
+    }
+
+    // Saving a loaded mesh gives the same file
+    FStaticMesh Loaded;
+    TEST_CHECK(Loaded.LoadCooked(Path));
+    TEST_CHECK(Loaded.SaveCooked(sTempPath("RoundTrip2.tmesh")));
+    TEST_CHECK(sReadFile(Path) == sReadFile(sTempPath("RoundTrip2.tmesh")));
+}
+
+TOPIA_TEST(CookedMesh, RejectsDamagedFiles)
+{
+    FStaticMesh Mesh;
+    sBuildMesh(Mesh);
+    const std::wstring Path = sTempPath("Damaged.tmesh");
+    TEST_CHECK(Mesh.SaveCooked(Path));
+    const std::vector<u8> Original = sReadFile(Path);
+    TEST_CHECK(Original.size() > sizeof(FCookedMeshHeader));
+    if (Original.size() <= sizeof(FCookedMeshHeader))
+    {
+        return;
+    }
+
+    FCookedMeshHeader Header;
+    memcpy(&Header, Original.data(), sizeof(Header));
+    FCookedSection Section;
+    memcpy(&Section, Original.data() + Header.SectionsOffset, sizeof(Section));
+
+    // Loads the modified file, which must fail and leave the mesh empty
+    auto Rejects = [&Path](const std::vector<u8>& Data, bool bVerifyHash)
+    {
+        FStaticMesh Loaded;
+        Loaded.LoadPrimitive(EPrimitiveType::Cube);
+        const bool bLoaded = WriteFileAtomic(Path, Data.data(), Data.size()) && Loaded.LoadCooked(Path, bVerifyHash);
+        return !bLoaded && Loaded.GetSections().empty();
+    };
+    auto WithHeader = [&Original](const FCookedMeshHeader& Changed)
+    {
+        std::vector<u8> Data = Original;
+        memcpy(Data.data(), &Changed, sizeof(Changed));
+        return Data;
+    };
+    auto WithSection = [&Original, &Header](const FCookedSection& Changed)
+    {
+        std::vector<u8> Data = Original;
+        memcpy(Data.data() + Header.SectionsOffset, &Changed, sizeof(Changed));
+        return Data;
+    };
+
+    TEST_CHECK(Rejects(std::vector<u8>(Original.begin(), Original.begin() + 10), false));
+    TEST_CHECK(Rejects(std::vector<u8>(Original.begin(), Original.end() - 1), false));
+
+    FCookedMeshHeader Changed = Header;
+    Changed.Magic ^= 1;
+    TEST_CHECK(Rejects(WithHeader(Changed), false));
+    Changed = Header;
+    Changed.Version += 1;
+    TEST_CHECK(Rejects(WithHeader(Changed), false));
+    Changed = Header;
+    Changed.SectionsOffset = ~u64(0) - 63;
+    TEST_CHECK(Rejects(WithHeader(Changed), false));
+    Changed = Header;
+    Changed.NumSections = 0x7fffffff;
+    TEST_CHECK(Rejects(WithHeader(Changed), false));
+
+    FCookedSection ChangedSection = Section;
+    ChangedSection.Positions.Count += 1;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+    ChangedSection = Section;
+    ChangedSection.Normals.Offset += 4;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+    ChangedSection = Section;
+    ChangedSection.Indices.Count -= 1;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+    ChangedSection = Section;
+    ChangedSection.IndexSize = 3;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+    ChangedSection = Section;
+    ChangedSection.MeshletBounds.Count -= 1;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+    ChangedSection = Section;
+    ChangedSection.QuantizedPrecision = 7;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+
+    // Values that would make a renderer read outside the streams are checked without the hash as well, a cache hit relies on that
+    auto WithValue = [&Original](u64 Offset, u32 Value, u32 Size)
+    {
+        std::vector<u8> Data = Original;
+        memcpy(Data.data() + Offset, &Value, Size);
+        return Data;
+    };
+    TEST_CHECK(Rejects(WithValue(Section.Indices.Offset + Section.IndexSize, Section.NumVertices, Section.IndexSize), false));
+    FCookedRange LOD1;
+    memcpy(&LOD1, Original.data() + Section.LODs.Offset, sizeof(LOD1));
+    TEST_CHECK(Section.NumLODs > 0 && LOD1.Count > 0);
+    TEST_CHECK(Rejects(WithValue(LOD1.Offset, Section.NumVertices, Section.IndexSize), false));
+    TEST_CHECK(Rejects(WithValue(Section.MeshletVertices.Offset + 4, Section.NumVertices, 4), false));
+    TEST_CHECK(Rejects(WithValue(Section.Meshlets.Offset + offsetof(FMeshlet, VertexOffset), Section.MeshletVertices.Count - 1, 4), false));
+    TEST_CHECK(Rejects(WithValue(Section.Meshlets.Offset + offsetof(FMeshlet, TriangleOffset), ~0u, 4), false));
+    TEST_CHECK(Rejects(WithValue(Section.MeshletTriangles.Offset + 1, 0xff, 1), false));
+    ChangedSection = Section;
+    ChangedSection.NumLODs -= 1;
+    ChangedSection.LODs.Count -= 1;
+    TEST_CHECK(Rejects(WithSection(ChangedSection), false));
+
+    // A flipped byte in the data is only found by the hash
+    std::vector<u8> Flipped = Original;
+    Flipped[size_t(Section.Positions.Offset)] ^= 1;
+    TEST_CHECK(Rejects(Flipped, true));
+    FStaticMesh Loaded;
+    TEST_CHECK(WriteFileAtomic(Path, Flipped.data(), Flipped.size()) && Loaded.LoadCooked(Path));
+
+    TEST_CHECK(!Loaded.LoadCooked(sTempPath("Missing.tmesh")) && Loaded.GetSections().empty());
+}
+
+TOPIA_TEST(CookedMesh, BuildUsesTheCache)
+{
+    const std::wstring Directory = sTempPath("Cache/");
+    FDerivedDataCache Clear(Directory, 0);
+    FDerivedDataCache Cache(Directory, 1 << 20);
+    const std::wstring Source = UTF8ToWide(GetTestDataDirectory() + "GLTF/Valid.gltf");
+
+    FStaticMeshBuildSettings Settings;
+    Settings.LODs.NumLODs = 1;
+    FStaticMesh Built, Cached, Uncached;
+    TEST_CHECK(Built.Build(Source, Settings, &Cache));
+    TEST_CHECK(Cached.Build(Source, Settings, &Cache));
+    TEST_CHECK(Uncached.Build(Source, Settings));
+    const FDerivedDataCacheStats Stats = Cache.GetStats();
+    TEST_CHECK(Stats.NumMisses == 1 && Stats.NumHits == 1 && Stats.NumPuts == 1);
+    TEST_CHECK(sMeshesEqual(Uncached, Built, false));
+    TEST_CHECK(sMeshesEqual(Uncached, Cached, true));
+
+    // Other settings are another entry
+    Settings.bQuantize = false;
+    FStaticMesh Other;
+    TEST_CHECK(Other.Build(Source, Settings, &Cache));
+    TEST_CHECK(Cache.GetStats().NumMisses == 2);
+    TEST_CHECK(Other.GetSections().size() == 1 && Other.GetSections()[0].Quantized.Positions.IsEmpty());
+}
@@ -0,0 +1,165 @@
+#include "TestFramework.h"
+
+#include <DerivedData/DerivedDataCache.h>
+#include <FileSystem/FileUtils.h>
+#include <FileSystem/MappedFile.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace topia;
+
+/** An empty cache directory for the test: a cache of size 0 deletes every entry it finds */
+static std::wstring sEmptyCacheDirectory(const char* pName)
+{
+    const std::wstring Directory = UTF8ToWide(GetTestTempDirectory() + "DerivedDataCache/" + pName + "/");
+    FDerivedDataCache Clear(Directory, 0);
+    return Directory;
+}
+
+static std::vector<u8> sData(u32 Size, u8 Seed)
+{
+    std::vector<u8> Data(Size);
+    for (u32 i = 0; i < Size; ++i)
+    {
+        Data[i] = u8(Seed + i * 7);
+    }
+    return Data;
+}
+
+/** File timestamps have the resolution of a scheduler tick, make sure consecutive accesses get different times */
+static void sWaitForNextTimestamp()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+TOPIA_TEST(DerivedDataCache, PutThenGet)
+{
+    FDerivedDataCache Cache(sEmptyCacheDirectory("PutThenGet"), 1 << 20);
+    const std::vector<u8> Data = sData(1000, 1);
+    const u32 Setting = 5;
+    FDerivedDataKey Key("Mesh", 1);
+    Key.Add("source", 6).AddValue(Setting);
+
+    FDerivedData Result;
+    TEST_CHECK(!Cache.Get(Key, Result) && Result.pData == nullptr);
+    TEST_CHECK(Cache.Put(Key, Data.data(), Data.size(), 0.5));
+    TEST_CHECK(Cache.Get(Key, Result));
+    TEST_CHECK(Result.Size == Data.size() && memcmp(Result.pData, Data.data(), Data.size()) == 0);
+
+    // Another version, other inputs or another type are other entries
+    FDerivedData Other;
+    TEST_CHECK(!Cache.Get(FDerivedDataKey("Mesh", 2).Add("source", 6).AddValue(Setting), Other));
+    TEST_CHECK(!Cache.Get(FDerivedDataKey("Mesh", 1).Add("source", 6).AddValue(Setting + 1), Other));
+    TEST_CHECK(!Cache.Get(FDerivedDataKey("Texture", 1).Add("source", 6).AddValue(Setting), Other));
+
+    // A new cache on the same directory finds the entry
+    FDerivedDataCache Reopened(Cache.GetDirectory(), 1 << 20);
+    TEST_CHECK(Reopened.Get(Key, Other) && Other.Size == Data.size());
+
+    const FDerivedDataCacheStats Stats = Cache.GetStats();
+    TEST_CHECK(Stats.NumHits == 1 && Stats.NumMisses == 4 && Stats.NumPuts == 1 && Stats.NumEvictions == 0);
+    TEST_CHECK(Stats.BytesRead == Data.size() && Stats.BytesWritten > Data.size());
+    TEST_CHECK_CLOSE(Stats.BuildSeconds, 0.5, 1.0e-9);
+}
+
+TOPIA_TEST(DerivedDataCache, DamagedEntriesMiss)
+{
+    const std::wstring Directory = sEmptyCacheDirectory("DamagedEntriesMiss");
+    FDerivedDataCache Cache(Directory, 1 << 20), VerifyingCache(Directory, 1 << 20, true);
+    const std::vector<u8> Data = sData(4096, 2);
+    const FDerivedDataKey Key = FDerivedDataKey("Mesh", 1).Add(Data.data(), Data.size());
+    const std::wstring Path = Directory + Key.GetFileName();
+    TEST_CHECK(Cache.Put(Key, Data.data(), Data.size(), 0.0));
+
+    std::vector<u8> File;
+    {
+        FMappedFile Mapped;
+        TEST_CHECK(Mapped.Open(Path));
+        File.assign(Mapped.GetData(), Mapped.GetData() + Mapped.GetSize());
+    }
+    FDerivedData Result;
+
+    // A flipped data byte is only found when hashes are verified
+    File[100] ^= 1;
+    TEST_CHECK(WriteFileAtomic(Path, File.data(), File.size()));
+    TEST_CHECK(Cache.Get(Key, Result));
+    Result = FDerivedData();
+    TEST_CHECK(!VerifyingCache.Get(Key, Result));
+    File[100] ^= 1;
+
+    // Truncated entries and entries of another key under the same name always miss
+    TEST_CHECK(WriteFileAtomic(Path, File.data(), File.size() - 1));
+    TEST_CHECK(!Cache.Get(Key, Result));
+    TEST_CHECK(WriteFileAtomic(Path, File.data(), 10));
+    TEST_CHECK(!Cache.Get(Key, Result));
+    TEST_CHECK(WriteFileAtomic(Path, File.data() + 1, File.size() - 1));
+    TEST_CHECK(!Cache.Get(Key, Result));
+
+    TEST_CHECK(WriteFileAtomic(Path, File.data(), File.size()));
+    TEST_CHECK(VerifyingCache.Get(Key, Result) && memcmp(Result.pData, Data.data(), Data.size()) == 0);
+}
+
+TOPIA_TEST(DerivedDataCache, TrimEvictsLeastRecentlyUsed)
+{
+    // Room for two entries of 1000 bytes and their trailers, not for three
+    FDerivedDataCache Cache(sEmptyCacheDirectory("TrimEvictsLeastRecentlyUsed"), 2500);
+    const std::vector<u8> Data = sData(1000, 3);
+    const FDerivedDataKey KeyA = FDerivedDataKey("Mesh", 1).AddValue(1);
+    const FDerivedDataKey KeyB = FDerivedDataKey("Mesh", 1).AddValue(2);
+    const FDerivedDataKey KeyC = FDerivedDataKey("Mesh", 1).AddValue(3);
+
+    TEST_CHECK(Cache.Put(KeyA, Data.data(), Data.size(), 0.0));
+    sWaitForNextTimestamp();
+    TEST_CHECK(Cache.Put(KeyB, Data.data(), Data.size(), 0.0));
+    sWaitForNextTimestamp();
+
+    // The hit makes A more recent than B
+    FDerivedData Result;
+    TEST_CHECK(Cache.Get(KeyA, Result));
+    Result = FDerivedData();
+    sWaitForNextTimestamp();
+
+    TEST_CHECK(Cache.Put(KeyC, Data.data(), Data.size(), 0.0));
+    TEST_CHECK(Cache.GetStats().NumEvictions == 1);
+    TEST_CHECK(Cache.Get(KeyA, Result));
+    TEST_CHECK(!Cache.Get(KeyB, Result));
+    TEST_CHECK(Cache.Get(KeyC, Result));
+}
+
+TOPIA_TEST(DerivedDataCache, WriteFileAtomicReplacesTheFile)
+{
+    const std::wstring Directory = sEmptyCacheDirectory("WriteFileAtomic");
+    const std::wstring Path = Directory + L"File.bin";
+    const std::vector<u8> First = sData(3000, 4), Second = sData(100, 5);
+
+    TEST_CHECK(WriteFileAtomic(Path, First.data(), First.size()));
+
+    // A mapping of the old file keeps its data while the file is replaced by the concatenation of the blocks
+    FMappedFile Old;
+    TEST_CHECK(Old.Open(Path) && Old.GetSize() == First.size());
+    FFileBlock Blocks[3];
+    Blocks[0].pData = Second.data();
+    Blocks[0].Size = 40;
+    Blocks[1].pData = nullptr;
+    Blocks[1].Size = 0;
+    Blocks[2].pData = Second.data() + 40;
+    Blocks[2].Size = Second.size() - 40;
+    const bool bReplaced = WriteFileAtomic(Path, Blocks, 3);
+#if defined(_WIN32)
+    TEST_CHECK(!bReplaced);
+    Old.Close();
+    TEST_CHECK(WriteFileAtomic(Path, Blocks, 3));
+#else
+    TEST_CHECK(bReplaced);
+    TEST_CHECK(memcmp(Old.GetData(), First.data(), First.size()) == 0);
+    Old.Close();
+#endif
+
+    FMappedFile New;
+    TEST_CHECK(New.Open(Path) && New.GetSize() == Second.size() && memcmp(New.GetData(), Second.data(), Second.size()) == 0);
+
+    // A file in a directory that doesn't exist can't be written
+    TEST_CHECK(!WriteFileAtomic(Directory + L"Missing/File.bin", First.data(), First.size()));
+}
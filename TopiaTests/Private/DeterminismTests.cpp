@@ -0,0 +1,72 @@
+#include "TestFramework.h"
+
+// Only meaningful when the whole build (TopiaCore, TopiaMath and this file) uses the deterministic mode, CMake builds a
+// separate TopiaDeterminismTests runner for it. In other builds this file registers nothing.
+#ifdef TOPIA_CROSS_PLATFORM_DETERMINISTIC
+
+#include <Hash.h>
+#include <TopiaMath.h>
+#include <Quat.h>
+#include <Trigonometry.h>
+
+#include <cstdio>
+
+using namespace topia;
+
+/**
+ * Hash of a 16 body simulation integrated for 1M steps with Vec3, Quat, Mat44 and the Trigonometry.h wrappers. The state is
+ * hashed every 1024 steps. Every compiler, optimization level and instruction set must reproduce cGoldenHash exactly, if it
+ * changes on purpose (a math change), update it and say why in the commit.
+ */
+static constexpr u64 cGoldenHash = 0x63a657925fb24eeeull;
+
+TOPIA_TEST(Determinism, OneMillionStepHash)
+{
+    const uint NumBodies = 16;
+    Vec3 Position[NumBodies], Velocity[NumBodies], AngularVelocity[NumBodies];
+    Quat Rotation[NumBodies];
+    for (uint i = 0; i < NumBodies; ++i)
+    {
+        Position[i] = Vec3(float(i), 0.5f * i, -0.25f * i);
+        Velocity[i] = Vec3(0.1f, 0.2f * Sin(float(i)), 0.3f);
+        Rotation[i] = Quat::sRotation(Vec3(0.3f, 0.8f, 0.52f).Normalized(), 0.1f * i);
+        AngularVelocity[i] = Vec3(0.5f, -0.3f, 0.2f * i);
+    }
+
+    u64 Hash = 0;
+    const float DeltaTime = 1.0f / 240.0f;
+    for (int Step = 0; Step < 1000000; ++Step)
+    {
+        for (uint i = 0; i < NumBodies; ++i)
+        {
+            const Mat44 M = Mat44::sRotation(Rotation[i]);
+            const Vec3 Spring = -Position[i] * 2.0f - Velocity[i] * 0.1f + M.GetAxisY() * Cos(Step * 0.001f + i);
+            Velocity[i] += Spring * DeltaTime;
+            Position[i] += Velocity[i] * DeltaTime;
+
+            const Quat Delta(Vec4(AngularVelocity[i] * (0.5f * DeltaTime), 0.0f));
+            Rotation[i] = (Rotation[i] + Delta * Rotation[i]).Normalized();
+
+            const Vec3 Euler = Rotation[i].GetEulerAngles();
+            AngularVelocity[i] += Vec3(Sin(Euler.GetX()), ACos(Cos(Euler.GetY())), ATan2(Euler.GetZ(), 1.0f)) * 0.001f - AngularVelocity[i] * 0.0001f;
+        }
+
+        if ((Step & 1023) == 0)
+        {
+            for (uint i = 0; i < NumBodies; ++i)
+            {
+                const float State[] = { Position[i].GetX(), Position[i].GetY(), Position[i].GetZ(), Rotation[i].GetX(), Rotation[i].GetY(),
+                    Rotation[i].GetZ(), Rotation[i].GetW() };
+                Hash = Hash64(State, sizeof(State), Hash);
+            }
+        }
+    }
+
+    if (Hash != cGoldenHash)
+    {
+        printf("  hash %016llx, expected %016llx\n", (unsigned long long)Hash, (unsigned long long)cGoldenHash);
+    }
+    TEST_CHECK(Hash == cGoldenHash);
+}
+
+#endif // TOPIA_CROSS_PLATFORM_DETERMINISTIC
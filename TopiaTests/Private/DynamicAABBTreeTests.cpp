@@ -0,0 +1,251 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <DynamicAABBTree.h>
+
+#include <cfloat>
+
+using namespace topia;
+
+namespace
+{
+    /** The proxies a test created, with the bounds they were last given, indexed by proxy */
+    class FProxyMirror
+    {
+    public:
+        std::vector<AABox> Bounds;
+        std::vector<u32> UserData;
+        std::vector<bool> Alive;
+        std::vector<bool> Moved; ///< Created or reinserted since the last FindNewPairs
+
+        /** Record a proxy that was just created */
+        void Add(u32 Proxy, const AABox& Box, u32 Data)
+        {
+            if (Proxy >= Bounds.size())
+            {
+                Bounds.resize(Proxy + 1);
+                UserData.resize(Proxy + 1);
+                Alive.resize(Proxy + 1, false);
+                Moved.resize(Proxy + 1, false);
+            }
+            TEST_CHECK(!Alive[Proxy]);
+            Bounds[Proxy] = Box;
+            UserData[Proxy] = Data;
+            Alive[Proxy] = true;
+            Moved[Proxy] = true;
+        }
+
+        std::vector<u32> GetAlive() const
+        {
+            std::vector<u32> Proxies;
+            for (u32 i = 0; i < Alive.size(); ++i)
+                if (Alive[i])
+                    Proxies.push_back(i);
+            return Proxies;
+        }
+    };
+}
+
+static AABox sRandomBox(std::mt19937& Random)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> Size(0.05f, 3.0f);
+    const Vec3 Center(50.0f * Unit(Random), 50.0f * Unit(Random), 50.0f * Unit(Random));
+    const Vec3 Extent(Size(Random), Size(Random), Size(Random));
+    return AABox(Center - Extent, Center + Extent);
+}
+
+/** Small moves mostly stay inside the fat box, large ones force a reinsert */
+static AABox sMovedBox(std::mt19937& Random, const AABox& Box)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    AABox Moved = Box;
+    const float Distance = (Random() % 4 == 0) ? 20.0f : 0.05f;
+    Moved.Translate(Vec3(Distance * Unit(Random), Distance * Unit(Random), Distance * Unit(Random)));
+    return Moved;
+}
+
+static bool sSameBox(const AABox& A, const AABox& B)
+{
+    return A.mMin == B.mMin && A.mMax == B.mMax;
+}
+
+/** Structure, fat boxes, box and ray queries against brute force over the mirror */
+static void sCheckTree(const DynamicAABBTree& Tree, const FProxyMirror& Mirror, std::mt19937& Random)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    const std::vector<u32> Proxies = Mirror.GetAlive();
+
+    TEST_CHECK(Tree.IsValid());
+    TEST_CHECK(Tree.GetNumProxies() == Proxies.size());
+    bool bContained = true;
+    for (u32 Proxy : Proxies)
+        bContained = bContained && Tree.GetFatBounds(Proxy).Contains(Mirror.Bounds[Proxy]) && Tree.GetUserData(Proxy) == Mirror.UserData[Proxy];
+    TEST_CHECK(bContained);
+
+    // The height of a tree in which siblings differ at most 1 in height is at most 1.44 log2(n + 2)
+    TEST_CHECK(Tree.GetHeight() <= int(1.45f * std::log2(float(Proxies.size() + 2))));
+
+    for (uint q = 0; q < 20; ++q)
+    {
+        const Vec3 Center(60.0f * Unit(Random), 60.0f * Unit(Random), 60.0f * Unit(Random));
+        const AABox Query(Center - Vec3::sReplicate(8.0f), Center + Vec3::sReplicate(8.0f));
+        std::vector<u32> Found;
+        Tree.QueryAABox(Query, [&Found](u32 Proxy) { Found.push_back(Proxy); });
+        std::sort(Found.begin(), Found.end());
+        std::vector<u32> Expected;
+        for (u32 Proxy : Proxies)
+            if (Query.Overlaps(Tree.GetFatBounds(Proxy)))
+                Expected.push_back(Proxy);
+        TEST_CHECK(Found == Expected);
+    }
+
+    // The visitor tests the real bounds, which the fat boxes contain, so the closest hit is exact
+    for (uint r = 0; r < 20; ++r)
+    {
+        const Vec3 Origin(60.0f * Unit(Random), 60.0f * Unit(Random), 60.0f * Unit(Random));
+        const Vec3 Direction = 150.0f * Vec3(Unit(Random), Unit(Random), Unit(Random));
+        const RayInvDirection InvDirection(Direction);
+        const auto RayBox = [&](u32 Proxy)
+        {
+            const float Fraction = RayAABox(Origin, InvDirection, Mirror.Bounds[Proxy].mMin, Mirror.Bounds[Proxy].mMax);
+            return Fraction == FLT_MAX ? FLT_MAX : std::max(Fraction, 0.0f);
+        };
+
+        float Expected = 1.0f;
+        for (u32 Proxy : Proxies)
+            Expected = std::min(Expected, RayBox(Proxy));
+        const float Closest = Tree.CastRay(Origin, Direction, 1.0f, [&](u32 Proxy, float Closest) { return std::min(Closest, RayBox(Proxy)); });
+        TEST_CHECK(Closest == Expected);
+
+        const float AnyHit = Tree.CastRay(Origin, Direction, 1.0f, [&](u32 Proxy, float Closest) { return RayBox(Proxy) < Closest ? -FLT_MAX : Closest; });
+        TEST_CHECK(AnyHit == (Expected < 1.0f ? -FLT_MAX : 1.0f));
+    }
+}
+
+/** FindNewPairs reports exactly the overlapping fat boxes of which at least one proxy moved, each pair once */
+static void sCheckNewPairs(DynamicAABBTree& Tree, FProxyMirror& Mirror)
+{
+    std::vector<DynamicAABBTree::ProxyPair> Pairs;
+    Tree.FindNewPairs(Pairs);
+    std::sort(Pairs.begin(), Pairs.end());
+
+    std::vector<DynamicAABBTree::ProxyPair> Expected;
+    const std::vector<u32> Proxies = Mirror.GetAlive();
+    for (size_t a = 0; a < Proxies.size(); ++a)
+        for (size_t b = a + 1; b < Proxies.size(); ++b)
+            if ((Mirror.Moved[Proxies[a]] || Mirror.Moved[Proxies[b]]) && Tree.GetFatBounds(Proxies[a]).Overlaps(Tree.GetFatBounds(Proxies[b])))
+                Expected.push_back({ Proxies[a], Proxies[b] });
+    TEST_CHECK(Pairs == Expected);
+
+    std::fill(Mirror.Moved.begin(), Mirror.Moved.end(), false);
+    Pairs.clear();
+    Tree.FindNewPairs(Pairs);
+    TEST_CHECK(Pairs.empty());
+}
+
+TOPIA_TEST(DynamicAABBTree, RandomOperations)
+{
+    std::mt19937 Random(133);
+    DynamicAABBTree Tree(0.2f);
+    FProxyMirror Mirror;
+
+    for (uint Step = 0; Step < 300; ++Step)
+    {
+        std::vector<u32> Alive = Mirror.GetAlive();
+        const u32 Operation = Random() % 6;
+        const uint Count = (Random() % 2 == 0) ? 1 : 1 + Random() % 60;
+        if (Operation <= 1 || Alive.size() < 10)
+        {
+            // Create, one at a time or as a batch that is inserted in Morton order
+            std::vector<AABox> Boxes(Count);
+            std::vector<u32> UserData(Count), Created(Count);
+            for (uint i = 0; i < Count; ++i)
+            {
+                Boxes[i] = sRandomBox(Random);
+                UserData[i] = Random();
+            }
+            if (Count == 1)
+                Created[0] = Tree.CreateProxy(Boxes[0], UserData[0]);
+            else
+                Tree.CreateProxies(Boxes.data(), UserData.data(), Count, Created.data());
+            for (uint i = 0; i < Count; ++i)
+                Mirror.Add(Created[i], Boxes[i], UserData[i]);
+        }
+        else if (Operation <= 3)
+        {
+            // Move, a batch may list a proxy more than once
+            std::vector<u32> Moving(Count);
+            std::vector<AABox> Boxes(Count);
+            std::vector<AABox> OldFat;
+            for (uint i = 0; i < Count; ++i)
+            {
+                Moving[i] = Alive[Random() % Alive.size()];
+                Boxes[i] = sMovedBox(Random, Mirror.Bounds[Moving[i]]);
+                OldFat.push_back(Tree.GetFatBounds(Moving[i]));
+            }
+            if (Count == 1)
+                Mirror.Moved[Moving[0]] = Tree.MoveProxy(Moving[0], Boxes[0]) || Mirror.Moved[Moving[0]];
+            else
+            {
+                uint NumReinserted = 0;
+                const uint Result = Tree.MoveProxies(Moving.data(), Boxes.data(), Count);
+                for (uint i = 0; i < Count; ++i)
+                {
+                    const bool bFirst = std::find(Moving.begin(), Moving.begin() + i, Moving[i]) == Moving.begin() + i;
+                    if (bFirst && !sSameBox(OldFat[i], Tree.GetFatBounds(Moving[i])))
+                    {
+                        ++NumReinserted;
+                        Mirror.Moved[Moving[i]] = true;
+                    }
+                }
+                TEST_CHECK(Result == NumReinserted);
+            }
+            for (uint i = 0; i < Count; ++i)
+                Mirror.Bounds[Moving[i]] = Boxes[i];
+        }
+        else if (Operation == 4)
+        {
+            // Destroy distinct proxies
+            std::shuffle(Alive.begin(), Alive.end(), Random);
+            const uint NumDestroy = std::min<uint>(Count, uint(Alive.size()) / 2);
+            if (NumDestroy == 1)
+                Tree.DestroyProxy(Alive[0]);
+            else
+                Tree.DestroyProxies(Alive.data(), NumDestroy);
+            for (uint i = 0; i < NumDestroy; ++i)
+            {
+                Mirror.Alive[Alive[i]] = false;
+                Mirror.Moved[Alive[i]] = false;
+            }
+        }
+        else
+            sCheckNewPairs(Tree, Mirror);
+
+        if (Step % 10 == 0)
+            sCheckTree(Tree, Mirror, Random);
+    }
+    sCheckTree(Tree, Mirror, Random);
+    sCheckNewPairs(Tree, Mirror);
+
+    // Remove everything
+    const std::vector<u32> Alive = Mirror.GetAlive();
+    Tree.DestroyProxies(Alive.data(), uint(Alive.size()));
+    TEST_CHECK(Tree.IsValid() && Tree.GetNumProxies() == 0 && Tree.GetHeight() == 0);
+    TEST_CHECK(Tree.CastRay(Vec3::sZero(), Vec3::sAxisX(), 1.0f, [](u32, float) { return 0.0f; }) == 1.0f);
+}
+
+TOPIA_TEST(DynamicAABBTree, SortedInsertStaysBalanced)
+{
+    // Boxes along a line inserted one by one is the worst case for an unbalanced tree
+    DynamicAABBTree Tree(0.0f);
+    FProxyMirror Mirror;
+    std::mt19937 Random(134);
+    for (u32 i = 0; i < 2000; ++i)
+    {
+        const AABox Box(Vec3(float(i), 0.0f, 0.0f), Vec3(float(i) + 0.5f, 1.0f, 1.0f));
+        Mirror.Add(Tree.CreateProxy(Box, i), Box, i);
+    }
+    sCheckTree(Tree, Mirror, Random);
+    sCheckNewPairs(Tree, Mirror);
+}
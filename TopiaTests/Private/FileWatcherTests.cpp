@@ -0,0 +1,149 @@
+#include "TestFramework.h"
+
+#include <DerivedData/DerivedDataCache.h>
+#include <FileSystem/FileUtils.h>
+#include <FileSystem/FileWatcher.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <thread>
+
+using namespace topia;
+
+static const u32 SETTLE_MILLISECONDS = 20;
+
+/** A directory no earlier run has used, the changes of the test are the only ones in it */
+static std::string sRunDirectory(const char* pName)
+{
+    const std::string Directory = GetTestTempDirectory() + "FileWatcher/" + pName + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + "/";
+    FDerivedDataCache CreateDirectory(UTF8ToWide(Directory), ~u64(0));
+    return Directory;
+}
+
+static bool sWriteFile(const std::string& Path, const char* pText)
+{
+    return WriteFileAtomic(UTF8ToWide(Path), pText, strlen(pText));
+}
+
+/** Writes in place, unlike WriteFileAtomic that renames a new file over the old one */
+static bool sAppendFile(const std::string& Path, const char* pText)
+{
+    FILE* pFile = fopen(Path.c_str(), "ab");
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+    const bool bWritten = fwrite(pText, 1, strlen(pText), pFile) == strlen(pText);
+    return fclose(pFile) == 0 && bWritten;
+}
+
+/** Polls until every path of Expected is reported or a few seconds passed, then a while longer for changes that should not come */
+static std::map<std::string, EFileChangeType> sCollectChanges(FFileWatcher& Watcher, const std::vector<std::string>& Expected)
+{
+    std::map<std::string, EFileChangeType> Changes;
+    std::map<std::string, u32> NumReported;
+    auto Poll = [&]()
+    {
+        std::vector<FFileChange> NewChanges;
+        Watcher.PollChanges(NewChanges);
+        for (const FFileChange& Change : NewChanges)
+        {
+            Changes[Change.Path.ToString()] = Change.Type;
+            ++NumReported[Change.Path.ToString()];
+        }
+    };
+    auto HasExpected = [&]()
+    {
+        for (const std::string& Path : Expected)
+        {
+            if (Changes.count(Path) == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!HasExpected() && std::chrono::steady_clock::now() < Deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        Poll();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MILLISECONDS * 5));
+    Poll();
+
+    // Each file once, however many notifications it had
+    for (const auto& Pair : NumReported)
+    {
+        TEST_CHECK(Pair.second == 1);
+    }
+    return Changes;
+}
+
+TOPIA_TEST(FileWatcher, ReportsSettledChanges)
+{
+    const std::string Directory = sRunDirectory("Changes");
+    TEST_CHECK(sWriteFile(Directory + "Existing.txt", "existing") && sWriteFile(Directory + "Removed.txt", "removed"));
+
+    FFileWatcher Watcher;
+    TEST_CHECK(!Watcher.IsWatching());
+    TEST_CHECK(Watcher.Start(UTF8ToWide(Directory), SETTLE_MILLISECONDS) && Watcher.IsWatching());
+
+    // Several writes to one file are one change, reported after the file settled
+    for (u32 i = 0; i < 5; ++i)
+    {
+        TEST_CHECK(sAppendFile(Directory + "Existing.txt", " more"));
+    }
+    TEST_CHECK(sWriteFile(Directory + "Added.txt", "added"));
+    TEST_CHECK(sAppendFile(Directory + "Added.txt", " and written"));
+    TEST_CHECK(remove((Directory + "Removed.txt").c_str()) == 0);
+
+    std::map<std::string, EFileChangeType> Changes = sCollectChanges(Watcher, { "existing.txt", "added.txt", "removed.txt" });
+    TEST_CHECK(Changes.count("existing.txt") && Changes["existing.txt"] == EFileChangeType::Modified);
+    TEST_CHECK(Changes.count("added.txt") && Changes["added.txt"] == EFileChangeType::Added);
+    TEST_CHECK(Changes.count("removed.txt") && Changes["removed.txt"] == EFileChangeType::Removed);
+
+    // Nothing new after the changes were polled, and nothing at all once stopped
+    Changes = sCollectChanges(Watcher, {});
+    TEST_CHECK(Changes.empty());
+    Watcher.Stop();
+    TEST_CHECK(!Watcher.IsWatching());
+    TEST_CHECK(sAppendFile(Directory + "Existing.txt", " after stop"));
+    TEST_CHECK(sCollectChanges(Watcher, {}).empty());
+
+    TEST_CHECK(!Watcher.Start(UTF8ToWide(Directory + "Missing/"), SETTLE_MILLISECONDS) && !Watcher.IsWatching());
+}
+
+TOPIA_TEST(FileWatcher, Subdirectories)
+{
+    const std::string Directory = sRunDirectory("Subdirectories");
+    FDerivedDataCache CreateExisting(UTF8ToWide(Directory + "Existing/Deeper/"), ~u64(0));
+
+    FFileWatcher Watcher;
+    TEST_CHECK(Watcher.Start(UTF8ToWide(Directory), SETTLE_MILLISECONDS));
+
+    // Directories that existed at Start and ones created after it, whose files may be written before they are watched
+    TEST_CHECK(sWriteFile(Directory + "Existing/Deeper/A.txt", "a"));
+    FDerivedDataCache CreateNew(UTF8ToWide(Directory + "New/Deeper/"), ~u64(0));
+    TEST_CHECK(sWriteFile(Directory + "New/Deeper/B.txt", "b"));
+    std::map<std::string, EFileChangeType> Changes = sCollectChanges(Watcher, { "existing/deeper/a.txt", "new", "new/deeper", "new/deeper/b.txt" });
+    TEST_CHECK(Changes.count("existing/deeper/a.txt") && Changes["existing/deeper/a.txt"] == EFileChangeType::Added);
+    TEST_CHECK(Changes.count("new") && Changes["new"] == EFileChangeType::Added);
+    TEST_CHECK(Changes.count("new/deeper/b.txt") && Changes["new/deeper/b.txt"] == EFileChangeType::Added);
+
+    // The new directory is watched too
+    TEST_CHECK(sAppendFile(Directory + "New/Deeper/B.txt", " written"));
+    Changes = sCollectChanges(Watcher, { "new/deeper/b.txt" });
+    TEST_CHECK(Changes.size() == 1 && Changes["new/deeper/b.txt"] == EFileChangeType::Modified);
+
+    // A renamed directory reports its files under the new name only
+    TEST_CHECK(rename((Directory + "New").c_str(), (Directory + "Renamed").c_str()) == 0);
+    TEST_CHECK(sAppendFile(Directory + "Renamed/Deeper/B.txt", " renamed"));
+    Changes = sCollectChanges(Watcher, { "new", "renamed", "renamed/deeper/b.txt" });
+    TEST_CHECK(Changes.count("new") && Changes["new"] == EFileChangeType::Removed);
+    TEST_CHECK(Changes.count("renamed") && Changes["renamed"] == EFileChangeType::Added);
+    TEST_CHECK(Changes.count("renamed/deeper/b.txt") && Changes.count("new/deeper/b.txt") == 0);
+}
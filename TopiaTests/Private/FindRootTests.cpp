@@ -0,0 +1,342 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <FindRoot.h>
+#include <FindRoot8.h>
+
+#include <vector>
+
+using namespace topia;
+
+static const float cMissing = std::numeric_limits<float>::infinity();
+
+/** Polynomial given by its roots, the coefficients are expanded in double and are exact for the small integers used here */
+struct FKnownPolynomial
+{
+    float Leading;
+    std::vector<double> RealRoots;      ///< Repeated roots are listed once per multiplicity
+    std::vector<double> ComplexPairs;   ///< x^2 + b x + c factors without real roots, as b, c
+
+    std::vector<float> Coefficients() const
+    {
+        std::vector<double> Coeff(1, double(Leading));
+        auto Multiply = [&Coeff](const std::vector<double>& Factor)
+        {
+            std::vector<double> Product(Coeff.size() + Factor.size() - 1, 0.0);
+            for (size_t i = 0; i < Coeff.size(); ++i)
+                for (size_t j = 0; j < Factor.size(); ++j)
+                    Product[i + j] += Coeff[i] * Factor[j];
+            Coeff = Product;
+        };
+        for (double Root : RealRoots)
+            Multiply({ 1.0, -Root });
+        for (size_t i = 0; i < ComplexPairs.size(); i += 2)
+            Multiply({ 1.0, ComplexPairs[i], ComplexPairs[i + 1] });
+        return std::vector<float>(Coeff.begin(), Coeff.end());
+    }
+};
+
+/** Real roots of a polynomial (coefficients from the highest power down) in double: bisection between the roots of its derivative */
+static std::vector<double> sReferenceRoots(std::vector<double> Coeff)
+{
+    while (!Coeff.empty() && Coeff[0] == 0.0)
+        Coeff.erase(Coeff.begin());
+    std::vector<double> Roots;
+    if (Coeff.size() < 2)
+        return Roots;
+    if (Coeff.size() == 2)
+    {
+        Roots.push_back(-Coeff[1] / Coeff[0]);
+        return Roots;
+    }
+
+    auto Evaluate = [&Coeff](double X)
+    {
+        double F = 0.0;
+        for (double C : Coeff)
+            F = F * X + C;
+        return F;
+    };
+
+    // Cauchy bound, all real roots are in [-Bound, Bound]
+    double Bound = 0.0;
+    for (size_t i = 1; i < Coeff.size(); ++i)
+        Bound = std::max(Bound, std::abs(Coeff[i] / Coeff[0]));
+    Bound += 1.0;
+
+    std::vector<double> Derivative;
+    for (size_t i = 0; i + 1 < Coeff.size(); ++i)
+        Derivative.push_back(Coeff[i] * double(Coeff.size() - 1 - i));
+    std::vector<double> Ends = sReferenceRoots(Derivative);
+    Ends.insert(Ends.begin(), -Bound);
+    Ends.push_back(Bound);
+
+    for (size_t i = 0; i + 1 < Ends.size(); ++i)
+    {
+        double Low = Ends[i], High = Ends[i + 1];
+        const double FLow = Evaluate(Low);
+        if ((FLow < 0.0) == (Evaluate(High) < 0.0))
+            continue;
+        for (int Iteration = 0; Iteration < 200; ++Iteration)
+        {
+            const double Mid = 0.5 * (Low + High);
+            ((Evaluate(Mid) < 0.0) == (FLow < 0.0) ? Low : High) = Mid;
+        }
+        Roots.push_back(0.5 * (Low + High));
+    }
+    return Roots;
+}
+
+/** Solves Coeff (Degree + 1 coefficients per lane) with FindRoot8, FindCubicRoot8 or FindQuarticRoot8, the roots of each lane in Roots[Lane] */
+static void sSolve8(uint Degree, const float Coeff[5][8], uint Count[8], float Roots[8][4])
+{
+    Vec8 C[5];
+    for (uint i = 0; i <= Degree; ++i)
+        C[i] = Vec8::sLoadFloat8(Coeff[i]);
+
+    Vec8 X[4] = { Vec8::sReplicate(cMissing), Vec8::sReplicate(cMissing), Vec8::sReplicate(cMissing), Vec8::sReplicate(cMissing) };
+    UVec8 NumRoots;
+    if (Degree == 2)
+        NumRoots = FindRoot8(C[0], C[1], C[2], X[0], X[1]);
+    else if (Degree == 3)
+        NumRoots = FindCubicRoot8(C[0], C[1], C[2], C[3], X);
+    else
+        NumRoots = FindQuarticRoot8(C[0], C[1], C[2], C[3], C[4], X);
+
+    for (uint Lane = 0; Lane < 8; ++Lane)
+    {
+        Count[Lane] = NumRoots[Lane];
+        for (uint i = 0; i < 4; ++i)
+            Roots[Lane][i] = X[i][Lane];
+    }
+}
+
+/** The count matches the finite outputs, the roots come first in ascending order and the remaining slots are +infinity */
+static bool sIsWellFormed(uint Degree, uint Count, const float Roots[4])
+{
+    if (Count > Degree)
+        return false;
+    for (uint i = 0; i < Degree; ++i)
+    {
+        if ((i < Count) != (Roots[i] != cMissing) || std::isnan(Roots[i]))
+            return false;
+        if (i > 0 && Roots[i] < Roots[i - 1])
+            return false;
+    }
+    return true;
+}
+
+/** Solves the polynomials 8 at a time and checks every distinct root is found and every root found is one of them */
+static void sCheckKnown(uint Degree, const std::vector<FKnownPolynomial>& Polynomials, float Tolerance)
+{
+    for (size_t First = 0; First < Polynomials.size(); First += 8)
+    {
+        float Coeff[5][8] = {};
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            // Unused lanes solve the first polynomial again
+            const FKnownPolynomial& Polynomial = Polynomials[First + Lane < Polynomials.size() ? First + Lane : 0];
+            const std::vector<float> C = Polynomial.Coefficients();
+            for (uint i = 0; i < C.size(); ++i)
+                Coeff[Degree + 1 - C.size() + i][Lane] = C[i];
+        }
+
+        uint Count[8];
+        float Roots[8][4];
+        sSolve8(Degree, Coeff, Count, Roots);
+
+        for (uint Lane = 0; Lane < 8 && First + Lane < Polynomials.size(); ++Lane)
+        {
+            const std::vector<double>& Expected = Polynomials[First + Lane].RealRoots;
+            TEST_CHECK(sIsWellFormed(Degree, Count[Lane], Roots[Lane]));
+
+            // Repeated roots may come back fewer times than their multiplicity, the distinct ones must all be there
+            bool bSimple = true;
+            for (size_t i = 1; i < Expected.size(); ++i)
+                bSimple = bSimple && std::abs(Expected[i] - Expected[i - 1]) > 0.5;
+            TEST_CHECK(bSimple ? Count[Lane] == Expected.size() : Count[Lane] <= Expected.size());
+
+            for (double Root : Expected)
+            {
+                bool bFound = false;
+                for (uint i = 0; i < Count[Lane]; ++i)
+                    bFound = bFound || std::abs(Roots[Lane][i] - Root) <= Tolerance * (1.0 + std::abs(Root));
+                TEST_CHECK(bFound);
+            }
+            for (uint i = 0; i < Count[Lane]; ++i)
+            {
+                bool bExpected = false;
+                for (double Root : Expected)
+                    bExpected = bExpected || std::abs(Roots[Lane][i] - Root) <= Tolerance * (1.0 + std::abs(Root));
+                TEST_CHECK(bExpected);
+            }
+        }
+    }
+}
+
+/** Random polynomials per lane against the double precision reference, lanes with nearly repeated roots are skipped */
+static void sCheckRandom(uint Degree, uint Seed)
+{
+    std::mt19937 Random(Seed);
+    std::uniform_real_distribution<float> Value(-1.0f, 1.0f);
+
+    uint NumCompared = 0;
+    for (uint Iteration = 0; Iteration < 2000; ++Iteration)
+    {
+        float Coeff[5][8];
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            for (uint i = 0; i <= Degree; ++i)
+                Coeff[i][Lane] = Value(Random);
+
+            // Keep the leading coefficient away from zero, except for the lanes that test the fall back to the lower degree
+            Coeff[0][Lane] = Lane == 7 ? 0.0f : std::copysign(0.25f + std::abs(Coeff[0][Lane]), Coeff[0][Lane]);
+        }
+
+        uint Count[8];
+        float Roots[8][4];
+        sSolve8(Degree, Coeff, Count, Roots);
+
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            std::vector<double> C;
+            for (uint i = 0; i <= Degree; ++i)
+                C.push_back(Coeff[i][Lane]);
+            const std::vector<double> Expected = sReferenceRoots(C);
+
+            // Near a double root the float solver can't tell two close roots from none
+            bool bSeparated = true;
+            for (size_t i = 1; i < Expected.size(); ++i)
+                bSeparated = bSeparated && Expected[i] - Expected[i - 1] > 0.05;
+            std::vector<double> Derivative;
+            for (uint i = 0; i < Degree; ++i)
+                Derivative.push_back(C[i] * double(Degree - i));
+            for (double Extremum : sReferenceRoots(Derivative))
+            {
+                double F = 0.0;
+                for (double Ci : C)
+                    F = F * Extremum + Ci;
+                bSeparated = bSeparated && std::abs(F) > 1.0e-3;
+            }
+
+            TEST_CHECK(sIsWellFormed(Degree, Count[Lane], Roots[Lane]));
+            if (!bSeparated)
+                continue;
+
+            ++NumCompared;
+            TEST_CHECK(Count[Lane] == Expected.size());
+            for (uint i = 0; i < Count[Lane] && i < Expected.size(); ++i)
+                TEST_CHECK(std::abs(Roots[Lane][i] - Expected[i]) <= 1.0e-3 * (1.0 + std::abs(Expected[i])));
+        }
+    }
+    TEST_CHECK(NumCompared > 8 * 2000 * 9 / 10);
+}
+
+TOPIA_TEST(FindRoot, Quadratic)
+{
+    std::vector<FKnownPolynomial> Polynomials = {
+        { 1.0f, { 1.0, 2.0 }, {} },
+        { -2.0f, { -3.0, 0.5 }, {} },
+        { 1.0f, { 1.0, 1.0 }, {} },         // Double root
+        { 3.0f, { 0.0, 0.0 }, {} },         // Double root at 0, q = 0
+        { 1.0f, {}, { 0.0, 1.0 } },         // x^2 + 1
+        { -1.0f, {}, { 2.0, 5.0 } },        // No real roots
+        { 1.0f, { -4.0, 4.0 }, {} },        // b = 0
+        { 1.0f, { 0.0, 7.0 }, {} } };       // c = 0
+    sCheckKnown(2, Polynomials, 1.0e-6f);
+
+    // Leading coefficient zero: polynomials with fewer coefficients fill the last slots, linear and constant equations
+    const std::vector<FKnownPolynomial> Linear = {
+        { 0.0f, {}, {} },                   // 0 = 0 has no isolated roots
+        { 2.0f, {}, {} },                   // 2 = 0
+        { 4.0f, { 0.25 }, {} },
+        { -1.0f, { -3.0 }, {} } };
+    sCheckKnown(2, Linear, 1.0e-6f);
+
+    // Every lane against the scalar FindRoot
+    std::mt19937 Random(28);
+    std::uniform_real_distribution<float> Value(-1.0f, 1.0f);
+    for (uint Iteration = 0; Iteration < 10000; ++Iteration)
+    {
+        float Coeff[5][8];
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            for (uint i = 0; i < 3; ++i)
+                Coeff[i][Lane] = Value(Random);
+            if (Lane >= 6)
+                Coeff[0][Lane] = 0.0f;
+            if (Lane == 7 && Iteration % 2 == 0)
+                Coeff[1][Lane] = 0.0f;
+        }
+
+        uint Count[8];
+        float Roots[8][4];
+        sSolve8(2, Coeff, Count, Roots);
+
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            const float A = Coeff[0][Lane], B = Coeff[1][Lane], C = Coeff[2][Lane];
+            TEST_CHECK(sIsWellFormed(2, Count[Lane], Roots[Lane]));
+
+            // The discriminant decides the count, skip the lanes where rounding can tip it either way
+            if (A != 0.0f && std::abs(B * B - 4.0f * A * C) < 1.0e-5f)
+                continue;
+
+            float X1 = cMissing, X2 = cMissing;
+            int ScalarCount = FindRoot(A, B, C, X1, X2);
+            if (ScalarCount == 1 && A != 0.0f)
+                ScalarCount = 2; // The scalar version reports the double root of b = c = 0 once
+            if (X2 < X1)
+                std::swap(X1, X2);
+            TEST_CHECK(Count[Lane] == uint(ScalarCount));
+            if (ScalarCount > 0)
+                TEST_CHECK(std::abs(Roots[Lane][0] - X1) <= 1.0e-5f * (1.0f + std::abs(X1)));
+            if (ScalarCount > 1)
+                TEST_CHECK(std::abs(Roots[Lane][1] - X2) <= 1.0e-5f * (1.0f + std::abs(X2)));
+        }
+    }
+}
+
+TOPIA_TEST(FindRoot, Cubic)
+{
+    const std::vector<FKnownPolynomial> Polynomials = {
+        { 1.0f, { 1.0, 2.0, 3.0 }, {} },
+        { -2.0f, { -5.0, 0.0, 4.0 }, {} },
+        { 1.0f, { -1.0, 0.0, 1.0 }, {} },   // b = d = 0
+        { 1.0f, { 2.0 }, { 0.0, 1.0 } },    // One real root
+        { 4.0f, { -0.5 }, { 1.0, 3.0 } },
+        { 1.0f, { 1.0, 1.0, 2.0 }, {} },    // Double root
+        { 1.0f, { -3.0, 2.0, 2.0 }, {} },
+        { 1.0f, { 2.0, 2.0, 2.0 }, {} },    // Triple root
+        { 1.0f, { 0.0, 0.0, 0.0 }, {} },
+        { 1.0f, { 1.0, 2.0 }, {} },         // Leading coefficient zero, 0 x^3 + x^2 - 3 x + 2
+        { 1.0f, {}, { 0.0, 1.0 } },         // 0 x^3 + x^2 + 1
+        { 1.0f, { 1.0 }, {} },              // 0 x^3 + 0 x^2 + x - 1
+        { 0.0f, {}, {} } };                 // All coefficients zero
+    sCheckKnown(3, Polynomials, 1.0e-3f);
+
+    sCheckRandom(3, 29);
+}
+
+TOPIA_TEST(FindRoot, Quartic)
+{
+    const std::vector<FKnownPolynomial> Polynomials = {
+        { 1.0f, { 1.0, 2.0, 3.0, 4.0 }, {} },
+        { -0.5f, { -3.0, -1.0, 0.5, 6.0 }, {} },
+        { 1.0f, { -2.0, -1.0, 1.0, 2.0 }, {} },     // Biquadratic
+        { 1.0f, { -2.0, 1.0 }, { 0.0, 1.0 } },      // Two real roots
+        { 2.0f, { 0.0, 3.0 }, { -2.0, 5.0 } },
+        { 1.0f, {}, { 0.0, 1.0, 0.0, 4.0 } },       // No real roots, biquadratic
+        { 1.0f, {}, { 0.0, 1.0, 2.0, 5.0 } },       // No real roots, q != 0
+        { -3.0f, {}, { -1.0, 1.0, 4.0, 5.0 } },
+        { 1.0f, { 1.0, 1.0, 3.0, -2.0 }, {} },      // Double root
+        { 1.0f, { -1.0, -1.0, 1.0, 1.0 }, {} },     // Two double roots
+        { 1.0f, { 1.0, 1.0 }, { 0.0, 1.0 } },       // Double root and a complex pair
+        { 1.0f, { -1.0, 1.0, 1.0, 1.0 }, {} },      // Triple root
+        { 1.0f, { 0.0, 0.0, 0.0, 0.0 }, {} },
+        { 1.0f, { 1.0, 2.0, 3.0 }, {} },            // Leading coefficient zero, 0 x^4 + x^3 - 6 x^2 + 11 x - 6
+        { 1.0f, {}, { 0.0, 1.0 } } };               // 0 x^4 + 0 x^3 + x^2 + 1
+    sCheckKnown(4, Polynomials, 2.0e-2f);
+
+    sCheckRandom(4, 30);
+}
@@ -0,0 +1,127 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <FrustumCull.h>
+#include <Quat.h>
+
+using namespace topia;
+
+/** D3D style perspective projection looking down +z, clip space z is 0 at the near plane and w at the far plane */
+static Mat44 sPerspective(float TanHalfFov, float Near, float Far)
+{
+    const float Scale = 1.0f / TanHalfFov;
+    const float ZScale = Far / (Far - Near);
+    return Mat44(Vec4(Scale, 0.0f, 0.0f, 0.0f), Vec4(0.0f, Scale, 0.0f, 0.0f), Vec4(0.0f, 0.0f, ZScale, 1.0f), Vec4(0.0f, 0.0f, -Near * ZScale, 0.0f));
+}
+
+/** Smallest distance in double precision by which the box reaches past the planes, negative when the box must be culled */
+static double sCullMargin(const Frustum& ViewFrustum, const float* Center, const float* Extent)
+{
+    double Margin = std::numeric_limits<double>::max();
+    for (uint p = 0; p < Frustum::NumPlanes; ++p)
+    {
+        const Plane& FrustumPlane = ViewFrustum.GetPlane(p);
+        const Vec3 Normal = FrustumPlane.GetNormal();
+        double Distance = FrustumPlane.GetConstant(), Radius = 0.0;
+        for (uint a = 0; a < 3; ++a)
+        {
+            Distance += double(Center[a]) * Normal[a];
+            Radius += double(Extent[a]) * std::abs(Normal[a]);
+        }
+        Margin = std::min(Margin, Distance + Radius);
+    }
+    return Margin;
+}
+
+TOPIA_TEST(FrustumCull, PointsMatchClipSpace)
+{
+    const Mat44 Projection = sPerspective(1.0f, 1.0f, 100.0f);
+    const Frustum ViewFrustum(Projection);
+
+    std::mt19937 Random(31);
+    std::uniform_real_distribution<float> Coordinate(-120.0f, 120.0f);
+    for (uint i = 0; i < 100000; ++i)
+    {
+        const Vec3 Point(Coordinate(Random), Coordinate(Random), Coordinate(Random));
+        const Vec4 Clip = Projection * Vec4(Point, 1.0f);
+        const float W = Clip.GetW();
+
+        // Points this close to a plane can't be classified reliably in float
+        const float Margin = std::min({ W - std::abs(Clip.GetX()), W - std::abs(Clip.GetY()), Clip.GetZ(), W - Clip.GetZ() });
+        if (std::abs(Margin) < 1.0e-3f)
+        {
+            continue;
+        }
+        TEST_CHECK(ViewFrustum.Contains(Point) == (Margin > 0.0f));
+    }
+}
+
+TOPIA_TEST(FrustumCull, MatchesScalarReference)
+{
+    // Rotated and translated camera, the count is not a multiple of 8 so the padded tail batch is used
+    const Mat44 View = Mat44::sInverseRotationTranslation(Quat::sRotation(Vec3(0.2f, 1.0f, 0.1f).Normalized(), 0.7f), Vec3(5.0f, -3.0f, 2.0f));
+    const Frustum ViewFrustum(sPerspective(0.6f, 0.5f, 200.0f) * View);
+
+    const uint Count = 20003;
+    std::vector<float> Centers[3], Extents[3];
+    std::mt19937 Random(2031);
+    std::uniform_real_distribution<float> Position(-250.0f, 250.0f), Size(0.0f, 8.0f);
+    for (uint a = 0; a < 3; ++a)
+    {
+        Centers[a].resize(Count);
+        Extents[a].resize(Count);
+    }
+    for (uint i = 0; i < Count; ++i)
+    {
+        for (uint a = 0; a < 3; ++a)
+        {
+            Centers[a][i] = Position(Random);
+            Extents[a][i] = Size(Random);
+        }
+    }
+
+    AABoxSoA Bounds;
+    Bounds.mCenterX = Centers[0].data();
+    Bounds.mCenterY = Centers[1].data();
+    Bounds.mCenterZ = Centers[2].data();
+    Bounds.mExtentX = Extents[0].data();
+    Bounds.mExtentY = Extents[1].data();
+    Bounds.mExtentZ = Extents[2].data();
+    Bounds.mCount = Count;
+
+    std::vector<u32> Visible(Count);
+    const uint NumVisible = FrustumCull(ViewFrustum, Bounds, Visible.data());
+    Visible.resize(NumVisible);
+    TEST_CHECK(NumVisible > 0 && NumVisible < Count);
+
+    // Visible indices are increasing and every box that is clearly inside or outside is classified correctly
+    std::vector<bool> IsVisible(Count, false);
+    for (uint v = 0; v < NumVisible; ++v)
+    {
+        TEST_CHECK(v == 0 || Visible[v] > Visible[v - 1]);
+        IsVisible[Visible[v]] = true;
+    }
+    for (uint i = 0; i < Count; ++i)
+    {
+        const float Center[] = { Centers[0][i], Centers[1][i], Centers[2][i] };
+        const float Extent[] = { Extents[0][i], Extents[1][i], Extents[2][i] };
+        const double Margin = sCullMargin(ViewFrustum, Center, Extent);
+        if (std::abs(Margin) > 1.0e-3)
+        {
+            TEST_CHECK(IsVisible[i] == (Margin > 0.0));
+        }
+    }
+
+    // Runs on a pool produce exactly the single threaded result
+    for (u32 NumThreads : { 1u, 2u, 7u })
+    {
+        FThreadPool Pool(NumThreads);
+        std::vector<u32> Threaded(Count);
+        Threaded.resize(FrustumCull(ViewFrustum, Bounds, Threaded.data(), &Pool));
+        TEST_CHECK(Threaded == Visible);
+    }
+
+    // An empty input writes nothing
+    Bounds.mCount = 0;
+    TEST_CHECK(FrustumCull(ViewFrustum, Bounds, nullptr) == 0);
+}
@@ -0,0 +1,76 @@
+#include "TestFramework.h"
+
+#include <GLTFAsset.h>
+#include <Json/Json.h>
+
+#include <cstring>
+
+using namespace topia;
+
+static bool sLoad(FGLTFAsset& Asset, const char* Name)
+{
+    return Asset.Load(UTF8ToWide(GetTestDataDirectory() + "GLTF/" + Name));
+}
+
+TOPIA_TEST(GLTFAsset, JsonGetU64IsRangeChecked)
+{
+    const char* pText = "[0, 4096, 18446744073709549568, 18446744073709551616, -1, 1e30, \"12\"]";
+    FJsonDocument Document;
+    TEST_CHECK(Document.Parse(pText, strlen(pText)));
+
+    const u64 Default = 7;
+    const u64 Expected[] = { 0, 4096, 18446744073709549568ull, Default, Default, Default, Default };
+    u32 i = 0;
+    for (FJsonValue Value = Document.GetRoot().GetFirstChild(); Value.IsValid(); Value = Value.GetNextSibling(), ++i)
+    {
+        TEST_CHECK(Value.GetU64(Default) == Expected[i]);
+    }
+    TEST_CHECK(i == 7);
+}
+
+TOPIA_TEST(GLTFAsset, LoadsValidFile)
+{
+    FGLTFAsset Asset;
+    TEST_CHECK(sLoad(Asset, "Valid.gltf"));
+    TEST_CHECK(Asset.Error.empty());
+    TEST_CHECK(Asset.Primitives.size() == 1 && Asset.Accessors.size() == 2);
+    if (Asset.Accessors.size() != 2)
+    {
+        return;
+    }
+
+    const float Fill[3] = {};
+    float Positions[9];
+    Asset.ReadFloats(Asset.Accessors[0], 3, Fill, Positions);
+    const float Expected[9] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    TEST_CHECK(memcmp(Positions, Expected, sizeof(Expected)) == 0);
+}
+
+TOPIA_TEST(GLTFAsset, RejectsMalformedFiles)
+{
+    // Offsets near 2^64 used to wrap around in the range checks and pass, so the loader read before the buffer
+    static const char* sFiles[] =
+    {
+        "AccessorCountOverflow.gltf",
+        "AccessorOffsetWraps.gltf",
+        "BufferLengthNegative.gltf",
+        "SparseIndicesOffsetWraps.gltf",
+        "SparseValuesOffsetWraps.gltf",
+        "ViewLengthWraps.gltf",
+        "ViewOffsetNegative.gltf",
+        "ViewOffsetTooLarge.gltf",
+        "ViewOffsetWraps.gltf",
+    };
+
+    for (const char* pFile : sFiles)
+    {
+        FGLTFAsset Asset;
+        const bool bLoaded = sLoad(Asset, pFile);
+        if (bLoaded || Asset.Error.empty() || Asset.Error == "Can't open file")
+        {
+            printf("  %s: %s\n", pFile, bLoaded ? "loaded" : Asset.Error.c_str());
+        }
+        TEST_CHECK(!bLoaded);
+        TEST_CHECK(!Asset.Error.empty() && Asset.Error != "Can't open file");
+    }
+}
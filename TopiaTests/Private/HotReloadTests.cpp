@@ -0,0 +1,194 @@
+#include "TestFramework.h"
+
+#include <HotReload.h>
+#include <DerivedData/DerivedDataCache.h>
+#include <FileSystem/FileUtils.h>
+#include <FileSystem/MappedFile.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace topia;
+
+/** Records the order of the rebuilds in a log shared by the objects of a test */
+struct FTestLog
+{
+    std::mutex Mutex;
+    std::vector<std::string> Rebuilds;
+    std::vector<std::string> Applies;
+};
+
+class FTestReloadable : public IReloadable
+{
+public:
+    FTestReloadable(FTestLog& InLog, const char* pInName) : Log(InLog), Name(pInName) {}
+
+    bool Rebuild() override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::lock_guard<std::mutex> Lock(Log.Mutex);
+        Log.Rebuilds.push_back(Name);
+        return !bFail;
+    }
+
+    void Apply() override
+    {
+        std::lock_guard<std::mutex> Lock(Log.Mutex);
+        Log.Applies.push_back(Name);
+    }
+
+    std::atomic<bool> bFail{ false };
+
+private:
+    FTestLog& Log;
+    std::string Name;
+};
+
+/** Ticks like the frame loop would until nothing is left to rebuild */
+static void sTickUntilIdle(FHotReloader& Reloader)
+{
+    const auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    do
+    {
+        Reloader.Tick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } while (!Reloader.IsIdle() && std::chrono::steady_clock::now() < Deadline);
+    TEST_CHECK(Reloader.IsIdle());
+}
+
+static size_t sIndexOf(const std::vector<std::string>& Names, const char* pName)
+{
+    return size_t(std::find(Names.begin(), Names.end(), std::string(pName)) - Names.begin());
+}
+
+TOPIA_TEST(HotReload, RebuildsWhatDependsOnTheChange)
+{
+    // Source -> Cooked -> Runtime, a diamond below Cooked and an object of another source
+    FTestLog Log;
+    FTestReloadable Cooked(Log, "Cooked"), Runtime(Log, "Runtime"), Left(Log, "Left"), Right(Log, "Right"), Joined(Log, "Joined"), Other(Log, "Other");
+    FHotReloader Reloader(2);
+    TEST_CHECK(Reloader.Register(FPath("Cooked"), &Cooked, { FPath("Source.gltf") }));
+    TEST_CHECK(Reloader.Register(FPath("Runtime"), &Runtime, { FPath("Cooked") }));
+    TEST_CHECK(Reloader.Register(FPath("Left"), &Left, { FPath("Cooked") }));
+    TEST_CHECK(Reloader.Register(FPath("Right"), &Right, { FPath("Cooked") }));
+    TEST_CHECK(Reloader.Register(FPath("Joined"), &Joined, { FPath("Left"), FPath("Right"), FPath("Source.gltf") }));
+    TEST_CHECK(Reloader.Register(FPath("Other"), &Other, { FPath("Other.gltf") }));
+
+    Reloader.NotifyChanged(FPath("source.gltf"));
+    sTickUntilIdle(Reloader);
+
+    // Every object below the change once, each after its dependencies, the other object not at all
+    TEST_CHECK(Log.Rebuilds.size() == 5 && Log.Applies.size() == 5 && sIndexOf(Log.Rebuilds, "Other") == Log.Rebuilds.size());
+    TEST_CHECK(sIndexOf(Log.Applies, "Cooked") < sIndexOf(Log.Applies, "Runtime") && sIndexOf(Log.Applies, "Cooked") < sIndexOf(Log.Applies, "Left"));
+    TEST_CHECK(sIndexOf(Log.Applies, "Left") < sIndexOf(Log.Applies, "Joined") && sIndexOf(Log.Applies, "Right") < sIndexOf(Log.Applies, "Joined"));
+    TEST_CHECK(Reloader.GetStats().NumReloads == 5 && Reloader.GetStats().NumFailed == 0);
+    TEST_CHECK(Reloader.GetStats().MaxLatencyMs >= Reloader.GetStats().GetAverageLatencyMs());
+
+    // Several changes before a Tick rebuild once, a change of an object name rebuilds what is below it
+    Log.Rebuilds.clear();
+    Log.Applies.clear();
+    Reloader.NotifyChanged(FPath("Other.gltf"));
+    Reloader.NotifyChanged(FPath("Other.gltf"));
+    Reloader.NotifyChanged(FPath("Left"));
+    sTickUntilIdle(Reloader);
+    TEST_CHECK(Log.Rebuilds.size() == 2 && sIndexOf(Log.Rebuilds, "Other") < 2 && sIndexOf(Log.Rebuilds, "Joined") < 2);
+}
+
+TOPIA_TEST(HotReload, FailedRebuildKeepsItsData)
+{
+    FTestLog Log;
+    FTestReloadable Cooked(Log, "Cooked"), Runtime(Log, "Runtime");
+    FHotReloader Reloader(1);
+    TEST_CHECK(Reloader.Register(FPath("Cooked"), &Cooked, { FPath("Source.gltf") }));
+    TEST_CHECK(Reloader.Register(FPath("Runtime"), &Runtime, { FPath("Cooked") }));
+
+    // The failed object is not applied, the ones below it are still rebuilt from its previous data
+    Cooked.bFail = true;
+    Reloader.NotifyChanged(FPath("Source.gltf"));
+    sTickUntilIdle(Reloader);
+    TEST_CHECK(Log.Rebuilds.size() == 2 && Log.Applies.size() == 1 && Log.Applies[0] == "Runtime");
+    TEST_CHECK(Reloader.GetStats().NumReloads == 1 && Reloader.GetStats().NumFailed == 1);
+}
+
+TOPIA_TEST(HotReload, RejectsCycles)
+{
+    FTestLog Log;
+    FTestReloadable A(Log, "A"), B(Log, "B"), C(Log, "C");
+    FHotReloader Reloader(1);
+    TEST_CHECK(!Reloader.Register(FPath("A"), &A, { FPath("Source.gltf"), FPath("A") }));
+    TEST_CHECK(Reloader.Register(FPath("A"), &A, { FPath("Source.gltf") }));
+    TEST_CHECK(Reloader.Register(FPath("B"), &B, { FPath("A") }));
+    TEST_CHECK(Reloader.Register(FPath("C"), &C, { FPath("B") }));
+
+    // A refused registration keeps the previous one of the name
+    TEST_CHECK(!Reloader.Register(FPath("A"), &A, { FPath("C") }));
+    TEST_CHECK(!Reloader.Register(FPath("B"), &B, { FPath("A"), FPath("C") }));
+    Reloader.NotifyChanged(FPath("Source.gltf"));
+    sTickUntilIdle(Reloader);
+    const std::vector<std::string> Expected = { "A", "B", "C" };
+    TEST_CHECK(Log.Applies == Expected);
+
+    // Once C no longer depends on B, B may depend on C
+    TEST_CHECK(Reloader.Register(FPath("C"), &C, { FPath("Other.gltf") }));
+    TEST_CHECK(Reloader.Register(FPath("B"), &B, { FPath("C") }));
+    Log.Applies.clear();
+    Reloader.NotifyChanged(FPath("Other.gltf"));
+    sTickUntilIdle(Reloader);
+    const std::vector<std::string> ExpectedAfter = { "C", "B" };
+    TEST_CHECK(Log.Applies == ExpectedAfter);
+}
+
+TOPIA_TEST(HotReload, Unregister)
+{
+    FTestLog Log;
+    FTestReloadable Cooked(Log, "Cooked"), Runtime(Log, "Runtime");
+    FHotReloader Reloader(1);
+    TEST_CHECK(Reloader.Register(FPath("Cooked"), &Cooked, { FPath("Source.gltf") }));
+    TEST_CHECK(Reloader.Register(FPath("Runtime"), &Runtime, { FPath("Cooked") }));
+
+    // An unregistered object is not rebuilt, the objects that depend on its name still are
+    Reloader.Unregister(FPath("Cooked"));
+    Reloader.NotifyChanged(FPath("Source.gltf"));
+    Reloader.NotifyChanged(FPath("Cooked"));
+    sTickUntilIdle(Reloader);
+    const std::vector<std::string> Expected = { "Runtime" };
+    TEST_CHECK(Log.Rebuilds == Expected);
+
+    // Unregistering waits for the rebuild in progress, and its result is dropped
+    Log.Rebuilds.clear();
+    Log.Applies.clear();
+    Reloader.NotifyChanged(FPath("Cooked"));
+    Reloader.Tick();
+    Reloader.Unregister(FPath("Runtime"));
+    sTickUntilIdle(Reloader);
+    TEST_CHECK(Log.Applies.empty() && Reloader.IsIdle());
+}
+
+TOPIA_TEST(HotReload, WatchedStaticMesh)
+{
+    const std::string Directory = GetTestTempDirectory() + "HotReload/";
+    FDerivedDataCache CreateDirectory(UTF8ToWide(Directory), ~u64(0));
+    const std::string Source = Directory + "mesh.gltf";
+    FMappedFile GLTF;
+    TEST_CHECK(GLTF.Open(UTF8ToWide(GetTestDataDirectory() + "GLTF/Valid.gltf")));
+
+    FStaticMesh Mesh;
+    FStaticMeshBuildSettings Settings;
+    Settings.LODs.NumLODs = 1;
+    FStaticMeshReloader Reloader(&Mesh, UTF8ToWide(Source), Settings);
+    FHotReloader HotReloader(1);
+    TEST_CHECK(HotReloader.Watch(UTF8ToWide(Directory), 20));
+    TEST_CHECK(HotReloader.Register(FPath("Meshes/Mesh"), &Reloader, { FPath("mesh.gltf") }));
+
+    // Writing the file rebuilds the mesh and swaps it in at a Tick
+    TEST_CHECK(WriteFileAtomic(UTF8ToWide(Source), GLTF.GetData(), GLTF.GetSize()));
+    const auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (HotReloader.GetStats().NumReloads == 0 && std::chrono::steady_clock::now() < Deadline)
+    {
+        HotReloader.Tick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    TEST_CHECK(HotReloader.GetStats().NumReloads == 1 && !Mesh.GetSections().empty());
+}
@@ -0,0 +1,228 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <Matrix.h>
+
+#include <random>
+
+using namespace topia;
+
+template <uint Rows, uint Cols>
+static Matrix<Rows, Cols> sRandomMatrix(std::mt19937& Random)
+{
+    std::uniform_real_distribution<float> Value(-1.0f, 1.0f);
+    Matrix<Rows, Cols> M;
+    for (uint c = 0; c < Cols; ++c)
+        for (uint r = 0; r < Rows; ++r)
+            M(r, c) = Value(Random);
+    return M;
+}
+
+/** Random matrix with a diagonal that dominates its row, which keeps the condition number small */
+template <uint N>
+static Matrix<N, N> sWellConditioned(std::mt19937& Random)
+{
+    Matrix<N, N> M = sRandomMatrix<N, N>(Random);
+    for (uint i = 0; i < N; ++i)
+        M(i, i) += M(i, i) < 0.0f ? -float(N) : float(N);
+    return M;
+}
+
+/** Largest difference of the elements relative to the largest element of Reference */
+template <uint Rows, uint Cols>
+static float sRelativeError(const Matrix<Rows, Cols>& M, const Matrix<Rows, Cols>& Reference)
+{
+    float MaxDifference = 0.0f, MaxElement = 1.0e-30f;
+    for (uint c = 0; c < Cols; ++c)
+        for (uint r = 0; r < Rows; ++r)
+        {
+            MaxDifference = std::max(MaxDifference, std::abs(M(r, c) - Reference(r, c)));
+            MaxElement = std::max(MaxElement, std::abs(Reference(r, c)));
+        }
+    return MaxDifference / MaxElement;
+}
+
+template <uint Rows, uint Inner, uint Cols>
+static Matrix<Rows, Cols> sScalarMultiply(const Matrix<Rows, Inner>& A, const Matrix<Inner, Cols>& B)
+{
+    Matrix<Rows, Cols> M;
+    for (uint c = 0; c < Cols; ++c)
+        for (uint r = 0; r < Rows; ++r)
+        {
+            double Sum = 0.0;
+            for (uint i = 0; i < Inner; ++i)
+                Sum += double(A(r, i)) * double(B(i, c));
+            M(r, c) = float(Sum);
+        }
+    return M;
+}
+
+template <uint Rows, uint Inner, uint Cols>
+static void sCheckMultiply(std::mt19937& Random)
+{
+    const Matrix<Rows, Inner> A = sRandomMatrix<Rows, Inner>(Random);
+    const Matrix<Inner, Cols> B = sRandomMatrix<Inner, Cols>(Random);
+    TEST_CHECK(sRelativeError(A * B, sScalarMultiply(A, B)) < 1.0e-5f);
+
+    // A vector is a matrix of one column
+    Vector<Inner> V;
+    Matrix<Inner, 1> VColumn;
+    for (uint r = 0; r < Inner; ++r)
+        V[r] = VColumn(r, 0) = B(r, 0);
+    const Vector<Rows> AV = A * V;
+    const Matrix<Rows, 1> Reference = sScalarMultiply(A, VColumn);
+    for (uint r = 0; r < Rows; ++r)
+        TEST_CHECK(std::abs(AV[r] - Reference(r, 0)) < 1.0e-5f * float(Inner));
+
+    // Transposed moves every element, the 4x4 blocks and the ones left over
+    const Matrix<Inner, Rows> AT = A.Transposed();
+    bool bTransposed = true;
+    for (uint c = 0; c < Inner; ++c)
+        for (uint r = 0; r < Rows; ++r)
+            bTransposed = bTransposed && AT(c, r) == A(r, c);
+    TEST_CHECK(bTransposed);
+
+    double Dot = 0.0;
+    for (uint r = 0; r < Inner; ++r)
+        Dot += double(V[r]) * double(V[r]);
+    TEST_CHECK(std::abs(V.Dot(V) - float(Dot)) < 1.0e-5f * float(Inner));
+}
+
+/** Solves A x = B with GaussianEliminationBlocked and GaussianElimination and checks they agree and x solves the system */
+template <uint N, uint M>
+static void sCheckSolve(const Matrix<N, N>& A, const Matrix<N, M>& B, float Tolerance)
+{
+    Matrix<N, N> BlockedA(A), ScalarA(A);
+    Matrix<N, M> BlockedX(B), ScalarX(B);
+    TEST_CHECK(GaussianEliminationBlocked(BlockedA, BlockedX));
+    TEST_CHECK(GaussianElimination(ScalarA, ScalarX));
+    TEST_CHECK(sRelativeError(BlockedX, ScalarX) < Tolerance);
+    TEST_CHECK(sRelativeError(sScalarMultiply(A, BlockedX), B) < Tolerance);
+}
+
+template <uint N>
+static void sCheckWellConditioned(std::mt19937& Random)
+{
+    for (uint i = 0; i < 10; ++i)
+    {
+        sCheckSolve(sWellConditioned<N>(Random), sRandomMatrix<N, 3>(Random), 1.0e-5f);
+    }
+}
+
+/** A = U S V with orthogonal-ish U and V from random well conditioned matrices and singular values down to 1e-4 */
+template <uint N>
+static void sCheckNearSingular(std::mt19937& Random)
+{
+    Matrix<N, N> S = Matrix<N, N>::sIdentity();
+    S(N - 1, N - 1) = 1.0e-4f;
+    const Matrix<N, N> A = sScalarMultiply(sScalarMultiply(sWellConditioned<N>(Random), S), sWellConditioned<N>(Random));
+
+    // The error grows with the condition number, the residual stays small
+    Matrix<N, N> BlockedA(A), ScalarA(A);
+    Matrix<N, 1> BlockedX(sRandomMatrix<N, 1>(Random));
+    const Matrix<N, 1> B(BlockedX);
+    Matrix<N, 1> ScalarX(B);
+    TEST_CHECK(GaussianEliminationBlocked(BlockedA, BlockedX));
+    TEST_CHECK(GaussianElimination(ScalarA, ScalarX));
+    TEST_CHECK(sRelativeError(BlockedX, ScalarX) < 1.0e-1f);
+    TEST_CHECK(sRelativeError(sScalarMultiply(A, BlockedX), B) < 1.0e-3f);
+}
+
+template <uint N>
+static void sCheckSingular(std::mt19937& Random)
+{
+    // A zero column and a zero row, the elimination runs out of pivots either way
+    for (uint Case = 0; Case < 2; ++Case)
+    {
+        Matrix<N, N> A = sWellConditioned<N>(Random);
+        for (uint i = 0; i < N; ++i)
+        {
+            (Case == 0 ? A(i, N / 2) : A(N / 2, i)) = 0.0f;
+        }
+        Matrix<N, N> BlockedA(A), ScalarA(A);
+        Matrix<N, 1> BlockedB = sRandomMatrix<N, 1>(Random);
+        Matrix<N, 1> ScalarB(BlockedB);
+        TEST_CHECK(!GaussianEliminationBlocked(BlockedA, BlockedB));
+        TEST_CHECK(!GaussianElimination(ScalarA, ScalarB));
+
+        Matrix<N, N> Inverse = Matrix<N, N>::sZero();
+        TEST_CHECK(!Inverse.SetInversed(A));
+    }
+}
+
+/** SetInversed against the inverse from the scalar GaussianElimination */
+template <uint N>
+static void sCheckInverse(std::mt19937& Random)
+{
+    for (uint i = 0; i < 10; ++i)
+    {
+        const Matrix<N, N> A = sWellConditioned<N>(Random);
+        Matrix<N, N> Inverse = Matrix<N, N>::sZero();
+        TEST_CHECK(Inverse.SetInversed(A));
+
+        Matrix<N, N> ScalarA(A);
+        Matrix<N, N> ScalarInverse = Matrix<N, N>::sIdentity();
+        TEST_CHECK(GaussianElimination(ScalarA, ScalarInverse));
+        TEST_CHECK(sRelativeError(Inverse, ScalarInverse) < 1.0e-5f);
+        TEST_CHECK(sRelativeError(sScalarMultiply(A, Inverse), Matrix<N, N>::sIdentity()) < 1.0e-5f);
+    }
+
+    // Exactly singular: a zero row makes the determinant of the cofactor specializations exactly zero too
+    Matrix<N, N> A = sWellConditioned<N>(Random);
+    for (uint c = 0; c < N; ++c)
+    {
+        A(N - 1, c) = 0.0f;
+    }
+    Matrix<N, N> Inverse = Matrix<N, N>::sZero();
+    TEST_CHECK(!Inverse.SetInversed(A));
+}
+
+TOPIA_TEST(Matrix, MultiplyAndTranspose)
+{
+    std::mt19937 Random(27);
+    sCheckMultiply<4, 4, 4>(Random);
+    sCheckMultiply<6, 6, 6>(Random);
+    sCheckMultiply<12, 12, 12>(Random);
+    sCheckMultiply<3, 5, 2>(Random);
+    sCheckMultiply<5, 3, 7>(Random);
+    sCheckMultiply<9, 7, 13>(Random);
+    sCheckMultiply<16, 8, 16>(Random);
+}
+
+TOPIA_TEST(Matrix, Inverse)
+{
+    std::mt19937 Random(28);
+    sCheckInverse<2>(Random);
+    sCheckInverse<3>(Random);
+    sCheckInverse<4>(Random);
+    sCheckInverse<5>(Random);
+    sCheckInverse<6>(Random);
+    sCheckInverse<12>(Random);
+    sCheckInverse<33>(Random);
+}
+
+TOPIA_TEST(Matrix, GaussianEliminationBlocked)
+{
+    std::mt19937 Random(29);
+    sCheckWellConditioned<1>(Random);
+    sCheckWellConditioned<5>(Random);
+    sCheckWellConditioned<6>(Random);
+    sCheckWellConditioned<12>(Random);
+    sCheckWellConditioned<17>(Random);
+    sCheckWellConditioned<32>(Random);
+    sCheckWellConditioned<64>(Random);
+
+    sCheckNearSingular<6>(Random);
+    sCheckNearSingular<12>(Random);
+    sCheckNearSingular<32>(Random);
+
+    sCheckSingular<5>(Random);
+    sCheckSingular<6>(Random);
+    sCheckSingular<12>(Random);
+    sCheckSingular<64>(Random);
+
+    // Row pivoting: a zero on the diagonal of an otherwise regular system
+    Matrix<6, 6> A = sWellConditioned<6>(Random);
+    A(0, 0) = 0.0f;
+    sCheckSolve(A, sRandomMatrix<6, 2>(Random), 1.0e-4f);
+}
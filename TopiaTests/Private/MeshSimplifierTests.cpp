@@ -0,0 +1,357 @@
+#include "TestFramework.h"
+
+#include <StaticMesh.h>
+#include <DVec3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <utility>
+
+using namespace topia;
+
+struct FSimplifierTestMesh
+{
+    std::vector<Float3> Positions;
+    std::vector<u32> Indices;
+};
+
+static FSimplifierTestMesh sGenerate(const FPrimitiveDesc& Desc)
+{
+    const FPrimitiveCounts Counts = GetPrimitiveCounts(Desc);
+    FSimplifierTestMesh Mesh;
+    Mesh.Positions.resize(Counts.NumVertices);
+    Mesh.Indices.resize(Counts.NumIndices);
+    FPrimitiveStreams Streams;
+    Streams.pPositions = Mesh.Positions.data();
+    Streams.pIndices32 = Mesh.Indices.data();
+    GeneratePrimitive(Desc, Streams);
+    return Mesh;
+}
+
+/** Merge vertices at the same position and drop the triangles that become degenerate, which gives a mesh without seams */
+static FSimplifierTestMesh sWeld(const FSimplifierTestMesh& Mesh)
+{
+    FVertexStreamRef Stream;
+    Stream.pData = Mesh.Positions.data();
+    Stream.Size = sizeof(Float3);
+    Stream.Stride = sizeof(Float3);
+    std::vector<u32> Remap(Mesh.Positions.size());
+    const u32 NumUnique = GenerateVertexRemap(&Stream, 1, u32(Mesh.Positions.size()), Remap.data());
+
+    FSimplifierTestMesh Welded;
+    Welded.Positions.resize(NumUnique);
+    RemapVertexStream(Welded.Positions.data(), Mesh.Positions.data(), sizeof(Float3), u32(Mesh.Positions.size()), Remap.data());
+    for (size_t t = 0; t < Mesh.Indices.size(); t += 3)
+    {
+        const u32 A = Remap[Mesh.Indices[t]], B = Remap[Mesh.Indices[t + 1]], C = Remap[Mesh.Indices[t + 2]];
+        if (A != B && B != C && C != A)
+            Welded.Indices.insert(Welded.Indices.end(), { A, B, C });
+    }
+    return Welded;
+}
+
+static u32 sSimplify(const FSimplifierTestMesh& Mesh, u32 TargetIndices, float MaxError, std::vector<u32>& OutIndices)
+{
+    OutIndices.resize(Mesh.Indices.size());
+    const u32 NumIndices = SimplifyMesh(Mesh.Indices.data(), u32(Mesh.Indices.size()), Mesh.Positions.data(), u32(Mesh.Positions.size()),
+        TargetIndices, MaxError, OutIndices.data());
+    OutIndices.resize(NumIndices);
+    return NumIndices;
+}
+
+/** Every directed edge between two positions has a twin in the other direction: the surface is closed and has no cracks */
+static bool sIsClosed(const std::vector<Float3>& Positions, const std::vector<u32>& Indices)
+{
+    std::map<std::pair<u32, u32>, int> Edges;
+    const auto PositionId = [&Positions](u32 Vertex)
+    {
+        // The first vertex at the same position, meshes in these tests are small enough for a search
+        for (u32 v = 0; v < Positions.size(); ++v)
+            if (memcmp(&Positions[v], &Positions[Vertex], sizeof(Float3)) == 0)
+                return v;
+        return Vertex;
+    };
+    std::vector<u32> Ids(Positions.size());
+    for (u32 v = 0; v < Positions.size(); ++v)
+        Ids[v] = PositionId(v);
+
+    for (size_t i = 0; i < Indices.size(); ++i)
+    {
+        const u32 From = Ids[Indices[i]], To = Ids[Indices[i - i % 3 + (i + 1) % 3]];
+        ++Edges[std::make_pair(From, To)];
+    }
+    for (const auto& Edge : Edges)
+    {
+        const auto Twin = Edges.find(std::make_pair(Edge.first.second, Edge.first.first));
+        if (Edge.second != 1 || Twin == Edges.end() || Twin->second != 1)
+            return false;
+    }
+    return true;
+}
+
+static Vec3 sTriangleNormal(const std::vector<Float3>& Positions, const u32* pTriangle)
+{
+    const Vec3 A(Positions[pTriangle[0]]), B(Positions[pTriangle[1]]), C(Positions[pTriangle[2]]);
+    return (B - A).Cross(C - A);
+}
+
+/** Squared distance from P to the triangle ABC in double precision, by projecting onto the plane and else onto the edges */
+static double sSqDistanceToTriangle(const DVec3& P, const DVec3& A, const DVec3& B, const DVec3& C)
+{
+    const DVec3 Normal = (B - A).Cross(C - A);
+    const double NormalLengthSq = Normal.LengthSq();
+    if (NormalLengthSq > 0.0)
+    {
+        const DVec3 Projected = P - Normal * ((P - A).Dot(Normal) / NormalLengthSq);
+        if ((B - A).Cross(Projected - A).Dot(Normal) >= 0.0 && (C - B).Cross(Projected - B).Dot(Normal) >= 0.0
+            && (A - C).Cross(Projected - C).Dot(Normal) >= 0.0)
+            return (P - Projected).LengthSq();
+    }
+
+    double DistanceSq = std::numeric_limits<double>::max();
+    const DVec3 Corners[] = { A, B, C };
+    for (u32 e = 0; e < 3; ++e)
+    {
+        const DVec3 From = Corners[e], Edge = Corners[(e + 1) % 3] - From;
+        const double EdgeLengthSq = Edge.LengthSq();
+        const double Fraction = EdgeLengthSq > 0.0 ? std::min(std::max((P - From).Dot(Edge) / EdgeLengthSq, 0.0), 1.0) : 0.0;
+        DistanceSq = std::min(DistanceSq, (P - (From + Edge * Fraction)).LengthSq());
+    }
+    return DistanceSq;
+}
+
+TOPIA_TEST(MeshSimplifier, ReachesTargetOnClosedMesh)
+{
+    FPrimitiveDesc SphereDesc(EPrimitiveType::Icosphere);
+    SphereDesc.Subdivisions = 12;
+    FPrimitiveDesc TorusDesc(EPrimitiveType::Torus);
+    for (const FPrimitiveDesc& Desc : { SphereDesc, TorusDesc })
+    {
+        const FSimplifierTestMesh Mesh = sWeld(sGenerate(Desc));
+        TEST_CHECK(sIsClosed(Mesh.Positions, Mesh.Indices));
+        const u32 NumTriangles = u32(Mesh.Indices.size() / 3);
+        for (float Ratio : { 0.5f, 0.2f, 0.1f })
+        {
+            // Without an error limit the target is reached without overshooting it much, and the surface stays closed
+            const u32 TargetIndices = u32(float(NumTriangles) * Ratio) * 3;
+            std::vector<u32> Indices;
+            const u32 NumIndices = sSimplify(Mesh, TargetIndices, 1.0f, Indices);
+            TEST_CHECK(NumIndices <= TargetIndices && NumIndices >= TargetIndices * 8 / 10);
+            TEST_CHECK(sIsClosed(Mesh.Positions, Indices));
+
+            // Nothing turns inside out: on the sphere every triangle faces away from the center, on the torus away from the ring in its middle
+            bool bOutwards = true;
+            for (size_t t = 0; t < Indices.size(); t += 3)
+            {
+                const Vec3 Centroid = (Vec3(Mesh.Positions[Indices[t]]) + Vec3(Mesh.Positions[Indices[t + 1]]) + Vec3(Mesh.Positions[Indices[t + 2]])) / 3.0f;
+                Vec3 Outwards = Centroid;
+                if (Desc.Type == EPrimitiveType::Torus)
+                    Outwards = Centroid - Vec3(Centroid.GetX(), 0.0f, Centroid.GetZ()).Normalized() * Desc.Radius;
+                bOutwards = bOutwards && sTriangleNormal(Mesh.Positions, &Indices[t]).Dot(Outwards) > 0.0f;
+            }
+            TEST_CHECK(bOutwards);
+        }
+    }
+
+    // A target at or above the triangle count keeps the mesh as it is
+    const FSimplifierTestMesh Mesh = sGenerate(FPrimitiveDesc(EPrimitiveType::Sphere));
+    std::vector<u32> Indices;
+    TEST_CHECK(sSimplify(Mesh, u32(Mesh.Indices.size()), 1.0f, Indices) == Mesh.Indices.size() && Indices == Mesh.Indices);
+}
+
+TOPIA_TEST(MeshSimplifier, BordersAndSeamsStayInPlace)
+{
+    // A bumpy square: border vertices only move along their side of the square and the corners never move
+    FPrimitiveDesc PlaneDesc(EPrimitiveType::Plane);
+    PlaneDesc.Subdivisions = 24;
+    FSimplifierTestMesh Plane = sGenerate(PlaneDesc);
+    std::mt19937 Random(40);
+    std::uniform_real_distribution<float> Bump(-0.005f, 0.005f);
+    for (Float3& Position : Plane.Positions)
+        Position.y += Bump(Random);
+
+    std::vector<u32> Indices;
+    sSimplify(Plane, u32(Plane.Indices.size() / 10), 1.0f, Indices);
+    TEST_CHECK(!Indices.empty() && Indices.size() < Plane.Indices.size() / 4);
+
+    std::map<std::pair<u32, u32>, int> Edges;
+    for (size_t i = 0; i < Indices.size(); ++i)
+        ++Edges[std::make_pair(Indices[i], Indices[i - i % 3 + (i + 1) % 3])];
+    const float Half = 0.5f * PlaneDesc.Size.x;
+    const auto SideMask = [Half](const Float3& P)
+    {
+        return u32(P.x == -Half) | (u32(P.x == Half) << 1) | (u32(P.z == -Half) << 2) | (u32(P.z == Half) << 3);
+    };
+    bool bBorderOnSides = true;
+    u32 NumCorners = 0;
+    for (const auto& Edge : Edges)
+    {
+        // An open edge runs along one side of the square
+        if (Edges.count(std::make_pair(Edge.first.second, Edge.first.first)) != 0)
+            continue;
+        const u32 Mask = SideMask(Plane.Positions[Edge.first.first]);
+        bBorderOnSides = bBorderOnSides && (Mask & SideMask(Plane.Positions[Edge.first.second])) != 0;
+        NumCorners += (Mask & 3) != 0 && (Mask & 12) != 0 ? 1 : 0;
+    }
+    TEST_CHECK(bBorderOnSides);
+    TEST_CHECK(NumCorners == 4); // Every corner starts exactly one directed border edge
+
+    bool bUpwards = true;
+    for (size_t t = 0; t < Indices.size(); t += 3)
+        bUpwards = bUpwards && sTriangleNormal(Plane.Positions, &Indices[t]).GetY() > 0.0f;
+    TEST_CHECK(bUpwards);
+
+    // The cube has separate vertices per face, its edges are seams. Both sides of a seam collapse together, so there are no cracks,
+    // and a triangle keeps the normal of its face.
+    FPrimitiveDesc CubeDesc(EPrimitiveType::Cube);
+    CubeDesc.Subdivisions = 10;
+    const FSimplifierTestMesh Cube = sGenerate(CubeDesc);
+    TEST_CHECK(sIsClosed(Cube.Positions, Cube.Indices));
+    for (u32 Divisor : { 4u, 20u })
+    {
+        sSimplify(Cube, u32(Cube.Indices.size() / Divisor), 1.0f, Indices);
+        TEST_CHECK(Indices.size() <= Cube.Indices.size() / 2);
+        TEST_CHECK(sIsClosed(Cube.Positions, Indices));
+        bool bFaceNormals = true;
+        for (size_t t = 0; t < Indices.size(); t += 3)
+        {
+            const Vec3 Normal = sTriangleNormal(Cube.Positions, &Indices[t]).Normalized();
+            bFaceNormals = bFaceNormals && Normal.Abs().ReduceMax() > 0.9999f;
+        }
+        TEST_CHECK(bFaceNormals);
+    }
+}
+
+/** Mesh with the LOD chain of GenerateLODs on a single position only section */
+static FStaticMesh sMeshWithLODs(const FPrimitiveDesc& Desc, const FLODSettings& Settings)
+{
+    FStaticMesh Mesh;
+    Mesh.LoadPrimitive(Desc, EVertexAttributes::Position);
+    Mesh.GenerateLODs(Settings);
+    return Mesh;
+}
+
+static std::vector<u32> sLODIndices(const FStaticMeshSection& Section, u32 Level)
+{
+    const TMeshStream<u16>& Indices16 = Level == 0 ? Section.Indices16 : Section.LODs[Level - 1].Indices16;
+    const TMeshStream<u32>& Indices32 = Level == 0 ? Section.Indices32 : Section.LODs[Level - 1].Indices32;
+    std::vector<u32> Indices(Indices16.GetData(), Indices16.GetData() + Indices16.Num());
+    Indices.insert(Indices.end(), Indices32.GetData(), Indices32.GetData() + Indices32.Num());
+    return Indices;
+}
+
+TOPIA_TEST(MeshSimplifier, LODErrorBoundsDistance)
+{
+    FPrimitiveDesc SphereDesc(EPrimitiveType::Sphere);
+    SphereDesc.Segments = 48;
+    SphereDesc.Rings = 24;
+    FPrimitiveDesc CubeDesc(EPrimitiveType::Cube);
+    CubeDesc.Subdivisions = 12;
+    FLODSettings Settings;
+    Settings.NumLODs = 6;
+    Settings.MaxError = 0.05f;
+    for (const FPrimitiveDesc& Desc : { SphereDesc, FPrimitiveDesc(EPrimitiveType::Torus), FPrimitiveDesc(EPrimitiveType::Capsule), CubeDesc })
+    {
+        const FStaticMesh Mesh = sMeshWithLODs(Desc, Settings);
+        const std::vector<FStaticMeshLODInfo>& LODInfos = Mesh.GetLODInfos();
+        TEST_CHECK(LODInfos.size() >= 3 && LODInfos[0].Error == 0.0f);
+
+        const FStaticMeshSection& Section = Mesh.GetSections()[0];
+        const std::vector<u32> LOD0 = sLODIndices(Section, 0);
+        std::vector<u8> Used(Section.NumVertices, 0);
+        for (u32 Index : LOD0)
+            Used[Index] = 1;
+
+        for (u32 Level = 1; Level < LODInfos.size(); ++Level)
+        {
+            TEST_CHECK(LODInfos[Level].Error >= LODInfos[Level - 1].Error && LODInfos[Level].NumTriangles < LODInfos[Level - 1].NumTriangles);
+
+            // Every vertex of LOD 0 is within the error of the surface of the LOD
+            const std::vector<u32> Indices = sLODIndices(Section, Level);
+            TEST_CHECK(Indices.size() / 3 == LODInfos[Level].NumTriangles);
+            double MaxDistanceSq = 0.0;
+            for (u32 v = 0; v < Section.NumVertices; ++v)
+            {
+                if (!Used[v])
+                    continue;
+                const DVec3 P(Vec3(Section.Positions[v]));
+                double DistanceSq = std::numeric_limits<double>::max();
+                for (size_t t = 0; t < Indices.size() && DistanceSq > 0.0; t += 3)
+                    DistanceSq = std::min(DistanceSq, sSqDistanceToTriangle(P, DVec3(Vec3(Section.Positions[Indices[t]])),
+                        DVec3(Vec3(Section.Positions[Indices[t + 1]])), DVec3(Vec3(Section.Positions[Indices[t + 2]]))));
+                MaxDistanceSq = std::max(MaxDistanceSq, DistanceSq);
+            }
+            TEST_CHECK(std::sqrt(MaxDistanceSq) <= LODInfos[Level].Error * 1.0001 + 1.0e-6);
+            TEST_CHECK(LODInfos[Level].Error > 0.0f || Desc.Type == EPrimitiveType::Cube); // Flat faces can simplify without error
+        }
+    }
+}
+
+TOPIA_TEST(MeshSimplifier, SelectLODIsCoarsestWithinPixelError)
+{
+    FLODSettings Settings;
+    Settings.NumLODs = 6;
+    Settings.MaxError = 0.05f;
+    const FStaticMesh Mesh = sMeshWithLODs(FPrimitiveDesc(EPrimitiveType::Torus), Settings);
+    const std::vector<FStaticMeshLODInfo>& LODInfos = Mesh.GetLODInfos();
+    TEST_CHECK(LODInfos.size() >= 3);
+
+    std::mt19937 Random(41);
+    std::uniform_real_distribution<float> LogDistance(-1.0f, 3.0f), PixelError(0.25f, 4.0f);
+    const float ProjectionScale = 1080.0f / (2.0f * std::tan(0.5f * 1.0f));
+    bool bCoarsest = true;
+    std::vector<u32> Selected(LODInfos.size(), 0);
+    for (u32 i = 0; i < 2000; ++i)
+    {
+        const float Distance = std::pow(10.0f, LogDistance(Random)), MaxPixelError = PixelError(Random);
+        const u32 Level = Mesh.SelectLOD(Distance, ProjectionScale, MaxPixelError);
+        const auto Pixels = [&](u32 L) { return LODInfos[L].Error * ProjectionScale / Distance; };
+        bCoarsest = bCoarsest && Level < LODInfos.size() && Pixels(Level) <= MaxPixelError * 1.0001f
+            && (Level + 1 == LODInfos.size() || Pixels(Level + 1) > MaxPixelError * 0.9999f);
+        ++Selected[Level];
+    }
+    TEST_CHECK(bCoarsest);
+    TEST_CHECK(Selected.front() > 0 && Selected.back() > 0);
+
+    // At the camera only LOD 0 is exact enough, a mesh without LODs always draws LOD 0
+    TEST_CHECK(Mesh.SelectLOD(0.0f, ProjectionScale, 1.0f) == 0);
+    FStaticMesh NoLODs;
+    NoLODs.LoadPrimitive(EPrimitiveType::Torus);
+    TEST_CHECK(NoLODs.SelectLOD(1000.0f, ProjectionScale, 1.0f) == 0);
+}
+
+TOPIA_BENCHMARK(MeshSimplifier, GenerateLODs)
+{
+    FPrimitiveDesc SphereDesc(EPrimitiveType::Sphere);
+    SphereDesc.Segments = 256;
+    SphereDesc.Rings = 128;
+    FPrimitiveDesc TorusDesc(EPrimitiveType::Torus);
+    TorusDesc.Segments = 256;
+    TorusDesc.Rings = 128;
+    FPrimitiveDesc CubeDesc(EPrimitiveType::Cube);
+    CubeDesc.Subdivisions = 96;
+    const char* Names[] = { "Sphere", "Torus", "Cube" };
+    const FPrimitiveDesc Descs[] = { SphereDesc, TorusDesc, CubeDesc };
+
+    FLODSettings Settings;
+    Settings.NumLODs = 8;
+    for (u32 m = 0; m < 3; ++m)
+    {
+        FStaticMesh Mesh;
+        Mesh.LoadPrimitive(Descs[m], EVertexAttributes::Position);
+        const auto Start = std::chrono::steady_clock::now();
+        Mesh.GenerateLODs(Settings);
+        const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+        const std::vector<FStaticMeshLODInfo>& LODInfos = Mesh.GetLODInfos();
+        const float Size = Mesh.GetBounds().GetSize().ReduceMax();
+        printf("  %s: %u triangles, %u LODs in %.1f ms, %.2f M input triangles/s\n", Names[m], LODInfos[0].NumTriangles, u32(LODInfos.size()),
+            Seconds * 1000.0, double(LODInfos[0].NumTriangles) / Seconds * 1.0e-6);
+        for (u32 Level = 1; Level < LODInfos.size(); ++Level)
+            printf("    LOD %u: %7u triangles, error %.5f (%.3f%% of the size)\n", Level, LODInfos[Level].NumTriangles, LODInfos[Level].Error,
+                100.0f * LODInfos[Level].Error / Size);
+    }
+}
@@ -0,0 +1,269 @@
+#include "TestFramework.h"
+
+#include <Meshlets.h>
+#include <PrimitiveGenerator.h>
+#include <TopiaMath.h>
+#include <Frustum.h>
+#include <Quat.h>
+
+#include <algorithm>
+#include <array>
+
+using namespace topia;
+
+struct FMeshletTestMesh
+{
+    std::vector<Float3> Positions;
+    std::vector<u32> Indices;
+};
+
+static FMeshletTestMesh sGenerate(EPrimitiveType Type)
+{
+    FPrimitiveDesc Desc(Type);
+    Desc.Subdivisions = Type == EPrimitiveType::Cube ? 12 : Desc.Subdivisions;
+    const FPrimitiveCounts Counts = GetPrimitiveCounts(Desc);
+    FMeshletTestMesh Mesh;
+    Mesh.Positions.resize(Counts.NumVertices);
+    Mesh.Indices.resize(Counts.NumIndices);
+    FPrimitiveStreams Streams;
+    Streams.pPositions = Mesh.Positions.data();
+    Streams.pIndices32 = Mesh.Indices.data();
+    GeneratePrimitive(Desc, Streams);
+    return Mesh;
+}
+
+/** A bumpy height field, the normals of neighbouring triangles differ so the cones have all kinds of widths */
+static FMeshletTestMesh sHeightField(std::mt19937& Random, u32 Cells)
+{
+    std::uniform_real_distribution<float> Height(-0.15f, 0.15f);
+    FMeshletTestMesh Mesh;
+    for (u32 z = 0; z <= Cells; ++z)
+        for (u32 x = 0; x <= Cells; ++x)
+            Mesh.Positions.push_back(Float3(float(x) / Cells - 0.5f, Height(Random) + 0.3f * std::sin(float(x + z) * 0.4f), float(z) / Cells - 0.5f));
+    for (u32 z = 0; z < Cells; ++z)
+        for (u32 x = 0; x < Cells; ++x)
+        {
+            const u32 V = z * (Cells + 1) + x;
+            for (u32 Index : { V, V + Cells + 1, V + 1, V + 1, V + Cells + 1, V + Cells + 2 })
+                Mesh.Indices.push_back(Index);
+        }
+    return Mesh;
+}
+
+/** Random triangles between random vertices, including degenerate ones that repeat a vertex */
+static FMeshletTestMesh sTriangleSoup(std::mt19937& Random, u32 NumVertices, u32 NumTriangles)
+{
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    FMeshletTestMesh Mesh;
+    for (u32 v = 0; v < NumVertices; ++v)
+        Mesh.Positions.push_back(Float3(Unit(Random), Unit(Random), Unit(Random)));
+    for (u32 t = 0; t < NumTriangles; ++t)
+    {
+        const u32 A = Random() % NumVertices;
+        Mesh.Indices.push_back(A);
+        Mesh.Indices.push_back(t % 17 == 0 ? A : Random() % NumVertices);
+        Mesh.Indices.push_back(Random() % NumVertices);
+    }
+    return Mesh;
+}
+
+/** Sorted triangles, each rotated to start at its smallest index so the winding is kept */
+static std::vector<std::array<u32, 3>> sCanonicalTriangles(const std::vector<u32>& Indices)
+{
+    std::vector<std::array<u32, 3>> Triangles;
+    for (size_t t = 0; t + 2 < Indices.size(); t += 3)
+    {
+        std::array<u32, 3> Triangle = { Indices[t], Indices[t + 1], Indices[t + 2] };
+        std::rotate(Triangle.begin(), std::min_element(Triangle.begin(), Triangle.end()), Triangle.end());
+        Triangles.push_back(Triangle);
+    }
+    std::sort(Triangles.begin(), Triangles.end());
+    return Triangles;
+}
+
+/** Section vertices of triangle t of meshlet m */
+static std::array<u32, 3> sMeshletTriangle(const FMeshletData& Data, u32 m, u32 t)
+{
+    const FMeshlet& Meshlet = Data.Meshlets[m];
+    const u32 Packed = Data.Triangles[Meshlet.TriangleOffset + t];
+    const u32* pVertices = &Data.Vertices[Meshlet.VertexOffset];
+    return { pVertices[Packed & 0xff], pVertices[(Packed >> 8) & 0xff], pVertices[(Packed >> 16) & 0xff] };
+}
+
+/** Meshlets stay within the limits, are packed back to back and hold every input triangle exactly once with its winding */
+static bool sCheckMeshlets(const FMeshletTestMesh& Mesh, const FMeshletData& Data, u32 MaxVertices, u32 MaxTriangles)
+{
+    if (Data.Bounds.Num() != Data.Meshlets.Num())
+        return false;
+
+    u32 VertexOffset = 0, TriangleOffset = 0;
+    std::vector<u32> Rebuilt;
+    std::vector<u8> InMeshlet(Mesh.Positions.size(), 0);
+    for (u32 m = 0; m < Data.Meshlets.Num(); ++m)
+    {
+        const FMeshlet& Meshlet = Data.Meshlets[m];
+        if (Meshlet.NumVertices < 1 || Meshlet.NumVertices > MaxVertices || Meshlet.NumTriangles < 1 || Meshlet.NumTriangles > MaxTriangles
+            || Meshlet.VertexOffset != VertexOffset || Meshlet.TriangleOffset != TriangleOffset)
+            return false;
+        VertexOffset += Meshlet.NumVertices;
+        TriangleOffset += Meshlet.NumTriangles;
+        if (VertexOffset > Data.Vertices.Num() || TriangleOffset > Data.Triangles.Num())
+            return false;
+
+        // Every vertex once per meshlet, and used by one of its triangles
+        for (u32 v = 0; v < Meshlet.NumVertices; ++v)
+        {
+            const u32 Vertex = Data.Vertices[Meshlet.VertexOffset + v];
+            if (Vertex >= Mesh.Positions.size() || InMeshlet[Vertex] != 0)
+                return false;
+            InMeshlet[Vertex] = 1;
+        }
+        std::vector<u8> Used(Meshlet.NumVertices, 0);
+        for (u32 t = 0; t < Meshlet.NumTriangles; ++t)
+        {
+            const u32 Packed = Data.Triangles[Meshlet.TriangleOffset + t];
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const u32 Local = (Packed >> (8 * k)) & 0xff;
+                if (Local >= Meshlet.NumVertices)
+                    return false;
+                Used[Local] = 1;
+            }
+            if ((Packed >> 24) != 0)
+                return false;
+            const std::array<u32, 3> Triangle = sMeshletTriangle(Data, m, t);
+            Rebuilt.insert(Rebuilt.end(), Triangle.begin(), Triangle.end());
+        }
+        for (u32 v = 0; v < Meshlet.NumVertices; ++v)
+        {
+            InMeshlet[Data.Vertices[Meshlet.VertexOffset + v]] = 0;
+            if (!Used[v])
+                return false;
+        }
+    }
+    return VertexOffset == Data.Vertices.Num() && TriangleOffset == Data.Triangles.Num()
+        && sCanonicalTriangles(Rebuilt) == sCanonicalTriangles(Mesh.Indices);
+}
+
+TOPIA_TEST(Meshlets, LimitsAndEveryTriangleOnce)
+{
+    std::mt19937 Random(39);
+    std::vector<FMeshletTestMesh> Meshes;
+    for (EPrimitiveType Type : { EPrimitiveType::Sphere, EPrimitiveType::Cube, EPrimitiveType::Torus, EPrimitiveType::Capsule })
+        Meshes.push_back(sGenerate(Type));
+    Meshes.push_back(sHeightField(Random, 40));
+    Meshes.push_back(sTriangleSoup(Random, 300, 1000));
+
+    // The same mesh in random triangle order, the builder doesn't depend on a cache optimized order
+    FMeshletTestMesh Shuffled = Meshes[0];
+    std::vector<std::array<u32, 3>> Triangles(Shuffled.Indices.size() / 3);
+    memcpy(Triangles.data(), Shuffled.Indices.data(), Shuffled.Indices.size() * sizeof(u32));
+    std::shuffle(Triangles.begin(), Triangles.end(), Random);
+    memcpy(Shuffled.Indices.data(), Triangles.data(), Shuffled.Indices.size() * sizeof(u32));
+    Meshes.push_back(Shuffled);
+
+    const u32 Limits[][2] = { { MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES }, { 3, 1 }, { 3, 255 }, { 254, 1 }, { 32, 16 }, { 128, 255 }, { 254, 255 } };
+    for (const FMeshletTestMesh& Mesh : Meshes)
+        for (const auto& Limit : Limits)
+        {
+            FMeshletData Data;
+            BuildMeshlets(Mesh.Indices.data(), u32(Mesh.Indices.size()), Mesh.Positions.data(), u32(Mesh.Positions.size()), Data, Limit[0], Limit[1]);
+            TEST_CHECK(sCheckMeshlets(Mesh, Data, Limit[0], Limit[1]));
+        }
+
+    // No triangles, no meshlets
+    FMeshletData Empty;
+    BuildMeshlets(nullptr, 0, Meshes[0].Positions.data(), u32(Meshes[0].Positions.size()), Empty);
+    TEST_CHECK(Empty.IsEmpty() && Empty.Vertices.IsEmpty() && Empty.Triangles.IsEmpty());
+}
+
+TOPIA_TEST(Meshlets, BoundsHoldTheirTriangles)
+{
+    std::mt19937 Random(40);
+    for (const FMeshletTestMesh& Mesh : { sGenerate(EPrimitiveType::Torus), sHeightField(Random, 30), sTriangleSoup(Random, 200, 600) })
+    {
+        FMeshletData Data;
+        BuildMeshlets(Mesh.Indices.data(), u32(Mesh.Indices.size()), Mesh.Positions.data(), u32(Mesh.Positions.size()), Data);
+        bool bInside = true;
+        for (u32 m = 0; m < Data.Meshlets.Num(); ++m)
+        {
+            const FMeshletBounds& Bounds = Data.Bounds[m];
+            const Vec3 Axis = Vec3(float(Bounds.ConeAxis[0]), float(Bounds.ConeAxis[1]), float(Bounds.ConeAxis[2])).NormalizedOr(Vec3::sZero());
+            const float Sine = float(Bounds.ConeCutoff) / 127.0f;
+            for (u32 t = 0; t < Data.Meshlets[m].NumTriangles; ++t)
+            {
+                const std::array<u32, 3> Triangle = sMeshletTriangle(Data, m, t);
+                const Vec3 A(Mesh.Positions[Triangle[0]]), B(Mesh.Positions[Triangle[1]]), C(Mesh.Positions[Triangle[2]]);
+                for (Vec3Arg P : { A, B, C })
+                    bInside = bInside && (P - Vec3(Bounds.Center)).Length() <= Bounds.Radius * (1.0f + 1.0e-5f) + 1.0e-6f;
+
+                // Every normal is within the cone: its angle to the axis is at most 90 degrees - the half angle, whose cosine is the cutoff sine
+                const Vec3 Normal = (B - A).Cross(C - A);
+                if (Bounds.ConeCutoff < 127 && Normal.Length() > 0.0f)
+                    bInside = bInside && Normal.Normalized().Dot(Axis) >= std::sqrt(1.0f - Sine * Sine) - 1.0e-5f;
+            }
+        }
+        TEST_CHECK(bInside);
+    }
+}
+
+TOPIA_TEST(Meshlets, CullNeverDropsVisibleTriangles)
+{
+    // D3D style perspective projection looking down +z
+    const float TanHalfFov = 0.7f, Near = 0.05f, Far = 20.0f;
+    const float ZScale = Far / (Far - Near);
+    const Mat44 Projection(Vec4(1.0f / TanHalfFov, 0.0f, 0.0f, 0.0f), Vec4(0.0f, 1.0f / TanHalfFov, 0.0f, 0.0f), Vec4(0.0f, 0.0f, ZScale, 1.0f),
+        Vec4(0.0f, 0.0f, -Near * ZScale, 0.0f));
+
+    std::mt19937 Random(41);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    u32 NumCulledByCone = 0, NumVisibleTotal = 0;
+    for (const FMeshletTestMesh& Mesh : { sGenerate(EPrimitiveType::Sphere), sGenerate(EPrimitiveType::Torus), sGenerate(EPrimitiveType::Cube),
+        sHeightField(Random, 40), sTriangleSoup(Random, 200, 600) })
+    {
+        FMeshletData Data;
+        BuildMeshlets(Mesh.Indices.data(), u32(Mesh.Indices.size()), Mesh.Positions.data(), u32(Mesh.Positions.size()), Data, 32, 32);
+        std::vector<u32> Visible(Data.Meshlets.Num());
+        for (u32 c = 0; c < 100; ++c)
+        {
+            // Cameras around the mesh, some of them inside its bounds, looking near the center so some meshlets are clipped by the sides
+            const Vec3 Camera = Vec3(Unit(Random), Unit(Random), Unit(Random)) * (c % 4 == 0 ? 0.4f : 2.5f);
+            const Vec3 Target = 0.5f * Vec3(Unit(Random), Unit(Random), Unit(Random));
+            const Vec3 Forward = (Target - Camera).NormalizedOr(Vec3::sAxisZ());
+            const Quat Rotation = Quat::sRotation(Forward, 3.0f * Unit(Random)) * Quat::sFromTo(Vec3::sAxisZ(), Forward);
+            const Frustum ViewFrustum(Projection * Mat44::sInverseRotationTranslation(Rotation, Camera));
+            Float3 CameraPosition;
+            Camera.StoreFloat3(&CameraPosition);
+
+            Visible.resize(CullMeshlets(Data, ViewFrustum, CameraPosition, Visible.data()));
+            TEST_CHECK(std::is_sorted(Visible.begin(), Visible.end()) && std::adjacent_find(Visible.begin(), Visible.end()) == Visible.end());
+            NumVisibleTotal += u32(Visible.size());
+
+            // A triangle is visible when it faces the camera and a point of it is inside the frustum
+            bool bConservative = true;
+            for (u32 m = 0; m < Data.Meshlets.Num(); ++m)
+            {
+                bool bHasVisible = false, bHasInFrustum = false;
+                for (u32 t = 0; t < Data.Meshlets[m].NumTriangles && !bHasVisible; ++t)
+                {
+                    const std::array<u32, 3> Triangle = sMeshletTriangle(Data, m, t);
+                    const Vec3 A(Mesh.Positions[Triangle[0]]), B(Mesh.Positions[Triangle[1]]), C(Mesh.Positions[Triangle[2]]);
+                    const bool bInFrustum = ViewFrustum.Contains(A) || ViewFrustum.Contains(B) || ViewFrustum.Contains(C)
+                        || ViewFrustum.Contains((A + B + C) / 3.0f);
+                    const bool bFrontFacing = (B - A).Cross(C - A).Dot(A - Camera) < 0.0f;
+                    bHasVisible = bInFrustum && bFrontFacing;
+                    bHasInFrustum = bHasInFrustum || bInFrustum;
+                }
+
+                const bool bReported = std::binary_search(Visible.begin(), Visible.end(), m);
+                bConservative = bConservative && (bReported || !bHasVisible);
+                NumCulledByCone += (!bReported && bHasInFrustum) ? 1 : 0;
+            }
+            TEST_CHECK(bConservative);
+            Visible.resize(Data.Meshlets.Num());
+        }
+    }
+
+    // Both tests cull something, otherwise the check above proves nothing
+    TEST_CHECK(NumCulledByCone > 0 && NumVisibleTotal > 0);
+}
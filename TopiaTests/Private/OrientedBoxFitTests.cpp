@@ -0,0 +1,116 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <EigenValueSymmetric3x3.h>
+#include <OrientedBoxFit.h>
+#include <Quat.h>
+
+using namespace topia;
+
+TOPIA_TEST(OrientedBoxFit, EigenValueSymmetric3x3x8Residual)
+{
+    std::mt19937 Random(26);
+    std::uniform_real_distribution<float> Value(-10.0f, 10.0f);
+
+    for (u32 Batch = 0; Batch < 1024; ++Batch)
+    {
+        float A[8][6];
+        SymMat33x8 Matrices;
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            for (float& Element : A[Lane])
+            {
+                Element = Value(Random);
+            }
+            // Every 4th batch has diagonal lanes, the rotation must not divide by the zero off diagonal elements
+            if (Batch % 4 == 0)
+            {
+                A[Lane][3] = A[Lane][4] = A[Lane][5] = 0.0f;
+            }
+            Matrices.mXX[Lane] = A[Lane][0];
+            Matrices.mYY[Lane] = A[Lane][1];
+            Matrices.mZZ[Lane] = A[Lane][2];
+            Matrices.mXY[Lane] = A[Lane][3];
+            Matrices.mXZ[Lane] = A[Lane][4];
+            Matrices.mYZ[Lane] = A[Lane][5];
+        }
+
+        Vec8 EigVec[3][3], EigVal[3];
+        EigenValueSymmetric3x3x8(Matrices, EigVec, EigVal);
+
+        for (uint Lane = 0; Lane < 8; ++Lane)
+        {
+            const Mat44 M(Vec4(A[Lane][0], A[Lane][3], A[Lane][4], 0.0f), Vec4(A[Lane][3], A[Lane][1], A[Lane][5], 0.0f),
+                Vec4(A[Lane][4], A[Lane][5], A[Lane][2], 0.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            Mat44 V = Mat44::sIdentity();
+            for (uint c = 0; c < 3; ++c)
+            {
+                const Vec3 v(EigVec[c][0][Lane], EigVec[c][1][Lane], EigVec[c][2][Lane]);
+                V.SetColumn3(c, v);
+
+                // Residual |Av - lv|, the entries are in [-10, 10]
+                TEST_CHECK((M.Multiply3x3(v) - EigVal[c][Lane] * v).Length() < 1.0e-4f);
+                TEST_CHECK_CLOSE(v.Length(), 1.0f, 1.0e-5f);
+            }
+            TEST_CHECK_CLOSE(V.GetDeterminant3x3(), 1.0f, 1.0e-4f);
+        }
+    }
+}
+
+TOPIA_TEST(OrientedBoxFit, BoxesContainTheirPoints)
+{
+    std::mt19937 Random(2026);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+    // 21 sets so the last batch of 8 is partial, set 5 is empty and set 6 has a single point
+    const uint NumSets = 21;
+    std::vector<u32> Offsets = { 0 };
+    std::vector<Vec3> Points;
+    std::vector<Mat44> Rotations;
+    for (uint Set = 0; Set < NumSets; ++Set)
+    {
+        const uint NumPoints = Set == 5 ? 0 : (Set == 6 ? 1 : 50 + Set * 7);
+        const Mat44 Rotation = Mat44::sRotationTranslation(Quat::sRotation(Vec3(Unit(Random), Unit(Random), 0.5f).Normalized(), 3.0f * Unit(Random)),
+            Vec3(10.0f * Unit(Random), 10.0f * Unit(Random), 10.0f * Unit(Random)));
+        const Vec3 Scale(4.0f, 2.0f, 0.5f);
+        for (uint i = 0; i < NumPoints; ++i)
+        {
+            Points.push_back(Rotation * (Scale * Vec3(Unit(Random), Unit(Random), Unit(Random))));
+        }
+        Offsets.push_back(u32(Points.size()));
+        Rotations.push_back(Rotation);
+    }
+
+    std::vector<OrientedBox> Boxes(NumSets);
+    FitOrientedBoxes(Points.data(), Offsets.data(), NumSets, Boxes.data());
+
+    for (uint Set = 0; Set < NumSets; ++Set)
+    {
+        const OrientedBox& Box = Boxes[Set];
+        TEST_CHECK_CLOSE(Box.mOrientation.GetDeterminant3x3(), 1.0f, 1.0e-4f);
+
+        const Mat44 Inverse = Box.mOrientation.InversedRotationTranslation();
+        for (u32 i = Offsets[Set]; i < Offsets[Set + 1]; ++i)
+        {
+            const Vec3 Local = Inverse * Points[i];
+            TEST_CHECK((Local.Abs() - Box.mHalfExtents).ReduceMax() <= 1.0e-4f);
+        }
+
+        // The longest axis of the box follows the direction in which the points were stretched the most
+        if (Offsets[Set + 1] - Offsets[Set] > 1)
+        {
+            const Vec3 Stretched = Rotations[Set].GetAxisX();
+            float Best = 0.0f;
+            for (uint c = 0; c < 3; ++c)
+            {
+                if (Box.mHalfExtents[c] == Box.mHalfExtents.ReduceMax())
+                {
+                    Best = std::abs(Box.mOrientation.GetColumn3(c).Dot(Stretched));
+                }
+            }
+            TEST_CHECK(Best > 0.9f);
+        }
+    }
+    TEST_CHECK(Boxes[5].mHalfExtents == Vec3::sZero());
+    TEST_CHECK(Boxes[6].mHalfExtents.ReduceMax() <= 1.0e-5f);
+}
@@ -0,0 +1,102 @@
+#include "TestFramework.h"
+
+#include <FileSystem/Path.h>
+#include <Hash.h>
+
+#include <thread>
+#include <unordered_set>
+
+using namespace topia;
+
+TOPIA_TEST(Path, NormalizePath)
+{
+    TEST_CHECK(NormalizePath("Shaders\\Common/Lighting.HLSL") == "shaders/common/lighting.hlsl");
+    TEST_CHECK(NormalizePath("./textures/a.ttex") == "textures/a.ttex");
+    TEST_CHECK(NormalizePath("/\\./Textures") == "textures");
+    TEST_CHECK(NormalizePath("") == "" && NormalizePath(".") == "." && NormalizePath(".hidden") == ".hidden");
+
+    // UTF-8 is kept as is, only ASCII letters change case
+    TEST_CHECK(NormalizePath("\xC3\x84pfel/\xC3\xA4.TXT") == "\xC3\x84pfel/\xC3\xA4.txt");
+
+    char Buffer[16];
+    const FStringView Path("./A\\B");
+    TEST_CHECK(NormalizePath(Path, Buffer) == 3 && FStringView(Buffer, 3) == FStringView("a/b"));
+}
+
+TOPIA_TEST(Path, InterningAndParts)
+{
+    const FPath Path("Meshes/Props\\Crate.TMESH");
+    TEST_CHECK(!Path.IsEmpty() && Path == FPath("./meshes/props/crate.tmesh") && Path != FPath("meshes/props/crate2.tmesh"));
+    TEST_CHECK(Path.GetString() == FStringView("meshes/props/crate.tmesh") && Path.ToString() == "meshes/props/crate.tmesh");
+    TEST_CHECK(Path.GetHash() == Hash64("meshes/props/crate.tmesh", 24));
+    TEST_CHECK(std::hash<FPath>()(Path) == size_t(Path.GetHash()));
+    TEST_CHECK(Path.GetDirectory() == FStringView("meshes/props/"));
+    TEST_CHECK(Path.GetFileName() == FStringView("crate.tmesh"));
+    TEST_CHECK(Path.GetExtension() == FStringView("tmesh"));
+
+    // No directory, no extension, a dot in a directory, a hidden file
+    const FPath Name("Readme");
+    TEST_CHECK(Name.GetDirectory().empty() && Name.GetFileName() == FStringView("readme") && Name.GetExtension().empty());
+    const FPath DottedDirectory("shaders.d/common");
+    TEST_CHECK(DottedDirectory.GetFileName() == FStringView("common") && DottedDirectory.GetExtension().empty());
+    TEST_CHECK(FPath("config/.hidden").GetExtension() == FStringView("hidden"));
+
+    // The empty path and paths that normalize to it are id 0
+    const FPath Empty;
+    TEST_CHECK(Empty.IsEmpty() && Empty.GetId() == 0 && Empty.GetString().empty() && FPath("./").IsEmpty() && FPath("").IsEmpty());
+}
+
+TOPIA_TEST(Path, FindDoesNotIntern)
+{
+    const u32 NumPaths = FPath::GetNumInternedPaths();
+    TEST_CHECK(FPath::Find("never/interned/by/any/test.bin").IsEmpty());
+    TEST_CHECK(FPath::GetNumInternedPaths() == NumPaths);
+
+    const FPath Path("Find/Me.bin");
+    TEST_CHECK(FPath::GetNumInternedPaths() == NumPaths + 1);
+    TEST_CHECK(FPath::Find("find\\ME.bin") == Path);
+    TEST_CHECK(FPath("find/me.bin") == Path && FPath::GetNumInternedPaths() == NumPaths + 1);
+
+    // Paths longer than the stack buffer of the lookup
+    const std::string Long = "long/" + std::string(2000, 'X') + ".bin";
+    TEST_CHECK(FPath::Find(Long).IsEmpty());
+    const FPath LongPath(Long);
+    TEST_CHECK(FPath::Find(Long) == LongPath && LongPath.GetString().size() == Long.size() && LongPath.GetExtension() == FStringView("bin"));
+}
+
+TOPIA_TEST(Path, ConcurrentInterning)
+{
+    // Enough paths to add chunks and grow the buckets while other threads look paths up
+    const u32 NumThreads = 4, NumPaths = 20000;
+    std::vector<std::vector<u32>> Ids(NumThreads, std::vector<u32>(NumPaths));
+    std::vector<std::thread> Threads;
+    for (u32 t = 0; t < NumThreads; ++t)
+    {
+        Threads.emplace_back([t, &Ids]()
+        {
+            for (u32 i = 0; i < NumPaths; ++i)
+            {
+                // Every thread interns the same paths in a different order, the multipliers are coprime to NumPaths
+                static const u32 sMultipliers[] = { 1, 3, 7, 9 };
+                const u32 p = (i * sMultipliers[t] + t * 1000) % NumPaths;
+                const FPath Path("concurrent/" + std::to_string(p) + ".bin");
+                Ids[t][p] = Path.GetId();
+                if (Path.GetString() != FStringView("concurrent/" + std::to_string(p) + ".bin"))
+                {
+                    Ids[t][p] = 0;
+                }
+            }
+        });
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    std::unordered_set<u32> Unique(Ids[0].begin(), Ids[0].end());
+    TEST_CHECK(Unique.size() == NumPaths && Unique.count(0) == 0);
+    for (u32 t = 1; t < NumThreads; ++t)
+    {
+        TEST_CHECK(Ids[t] == Ids[0]);
+    }
+}
@@ -0,0 +1,95 @@
+#include "TestFramework.h"
+
+#include <PrimitiveGenerator.h>
+#include <TopiaMath.h>
+#include <Vec3.h>
+
+using namespace topia;
+
+static const EPrimitiveType sTypes[] =
+{
+    EPrimitiveType::Plane,
+    EPrimitiveType::Cube,
+    EPrimitiveType::Sphere,
+    EPrimitiveType::Icosphere,
+    EPrimitiveType::Cylinder,
+    EPrimitiveType::Capsule,
+    EPrimitiveType::Torus,
+};
+
+TOPIA_TEST(PrimitiveGenerator, EveryVertexIsReferenced)
+{
+    for (EPrimitiveType Type : sTypes)
+    {
+        // The defaults and the lowest tessellation each shape accepts
+        FPrimitiveDesc Descs[2] = { FPrimitiveDesc(Type), FPrimitiveDesc(Type) };
+        Descs[1].Segments = 0;
+        Descs[1].Rings = 0;
+        Descs[1].Subdivisions = 0;
+
+        for (const FPrimitiveDesc& Desc : Descs)
+        {
+            const FPrimitiveCounts Counts = GetPrimitiveCounts(Desc);
+            TEST_CHECK(Counts.NumVertices > 0 && Counts.NumIndices % 3 == 0);
+
+            std::vector<Float3> Positions(Counts.NumVertices), Normals(Counts.NumVertices);
+            std::vector<u32> Indices(Counts.NumIndices, ~0u);
+            FPrimitiveStreams Streams;
+            Streams.pPositions = Positions.data();
+            Streams.pNormals = Normals.data();
+            Streams.pIndices32 = Indices.data();
+            GeneratePrimitive(Desc, Streams);
+
+            std::vector<bool> IsReferenced(Counts.NumVertices, false);
+            bool bInRange = true;
+            for (u32 Index : Indices)
+            {
+                bInRange &= Index < Counts.NumVertices;
+                if (Index < Counts.NumVertices)
+                {
+                    IsReferenced[Index] = true;
+                }
+            }
+            TEST_CHECK(bInRange);
+
+            u32 NumUnreferenced = 0;
+            for (bool bReferenced : IsReferenced)
+            {
+                NumUnreferenced += bReferenced ? 0 : 1;
+            }
+            if (NumUnreferenced != 0)
+            {
+                printf("  type %u, segments %u: %u unreferenced vertices\n", u32(Type), Desc.Segments, NumUnreferenced);
+            }
+            TEST_CHECK(NumUnreferenced == 0);
+
+            // Triangles are counter clockwise seen from outside, so their normal agrees with the vertex normals
+            u32 NumFlipped = 0;
+            for (size_t t = 0; t + 2 < Indices.size() && bInRange; t += 3)
+            {
+                const Vec3 P0(Positions[Indices[t]]), P1(Positions[Indices[t + 1]]), P2(Positions[Indices[t + 2]]);
+                const Vec3 Normal = Vec3(Normals[Indices[t]]) + Vec3(Normals[Indices[t + 1]]) + Vec3(Normals[Indices[t + 2]]);
+                NumFlipped += (P1 - P0).Cross(P2 - P0).Dot(Normal) < 0.0f ? 1 : 0;
+            }
+            TEST_CHECK(NumFlipped == 0);
+        }
+    }
+}
+
+TOPIA_TEST(PrimitiveGenerator, UnitSphereVertexCount)
+{
+    // 64 bit counts, level 14 has 2^32 + 2 vectors which a 32 bit count wrapped to 2
+    static_assert(Vec3::sGetUnitSphereVertexCount(Vec3::cMaxUnitSphereLevel + 1) == (u64(1) << 32) + 2, "Unit sphere count must not wrap");
+
+    std::vector<Vec3> Vertices;
+    for (int Level = 0; Level <= 5; ++Level)
+    {
+        Vec3::sCreateUnitSphere(Level, Vertices);
+        TEST_CHECK(Vertices.size() == Vec3::sGetUnitSphereVertexCount(Level));
+        for (Vec3Arg V : Vertices)
+        {
+            TEST_CHECK_CLOSE(V.Length(), 1.0f, 1.0e-5f);
+        }
+    }
+    TEST_CHECK(Vec3::sUnitSphere().size() == Vec3::sGetUnitSphereVertexCount(3));
+}
@@ -0,0 +1,184 @@
+#include "TestFramework.h"
+
+#include <TopiaMath.h>
+#include <RayTriangle.h>
+#include <RayTriangle8.h>
+
+#include <cfloat>
+#include <cstring>
+
+using namespace topia;
+
+static bool sBitEqual(float A, float B)
+{
+    return memcmp(&A, &B, sizeof(float)) == 0;
+}
+
+TOPIA_TEST(RayTriangle, KernelsAgreeBitwise)
+{
+    std::mt19937 Random(34);
+    std::uniform_real_distribution<float> Coordinate(-1.0f, 1.0f);
+    auto RandomVec3 = [&]() { return Vec3(Coordinate(Random), Coordinate(Random), Coordinate(Random)); };
+
+    for (uint Iteration = 0; Iteration < 5000; ++Iteration)
+    {
+        Vec3 V[8][3];
+        TriangleBlock4 Block4[2];
+        TriangleBlock8 Block8;
+        for (uint t = 0; t < 8; ++t)
+        {
+            for (Vec3& Vertex : V[t])
+            {
+                Vertex = RandomVec3();
+            }
+            Block4[t / 4].SetTriangle(t % 4, V[t][0], V[t][1], V[t][2]);
+            Block8.SetTriangle(t, V[t][0], V[t][1], V[t][2]);
+        }
+
+        // Rays start outside the unit cube and point roughly at it so a good part of them hit
+        WatertightRay Rays[8];
+        for (WatertightRay& Ray : Rays)
+        {
+            const Vec3 Origin = 3.0f * RandomVec3();
+            Ray.Set(Origin, 0.5f * RandomVec3() - Origin);
+        }
+
+        for (uint r = 0; r < 8; ++r)
+        {
+            const Vec4 Hit4[2] = { RayTriangle4(Rays[r], Block4[0]), RayTriangle4(Rays[r], Block4[1]) };
+            const Vec8 Hit8 = RayTriangle8(Rays[r], Block8);
+            float Closest = FLT_MAX;
+            uint ClosestLane = cNoTriangleHit;
+            for (uint t = 0; t < 8; ++t)
+            {
+                const float Hit = RayTriangle(Rays[r], V[t][0], V[t][1], V[t][2]);
+                TEST_CHECK(sBitEqual(Hit, Hit4[t / 4][t % 4]));
+                TEST_CHECK(sBitEqual(Hit, Hit8[t]));
+                if (Hit < Closest)
+                {
+                    Closest = Hit;
+                    ClosestLane = t;
+                }
+            }
+
+            float Current = FLT_MAX;
+            TEST_CHECK(RayTriangle8Closest(Rays[r], Block8, Current) == ClosestLane);
+            TEST_CHECK(sBitEqual(Current, Closest));
+            TEST_CHECK(RayTriangle8Any(Rays[r], Block8, FLT_MAX) == (Closest != FLT_MAX));
+        }
+
+        // 8 rays against one triangle
+        const WatertightRay8 Packet(Rays);
+        for (uint t = 0; t < 8; ++t)
+        {
+            const Vec8 Hit = RayTriangle8(Packet, V[t][0], V[t][1], V[t][2]);
+            for (uint r = 0; r < 8; ++r)
+            {
+                TEST_CHECK(sBitEqual(Hit[r], RayTriangle(Rays[r], V[t][0], V[t][1], V[t][2])));
+            }
+        }
+
+        // A coherent packet (same axis permutation for every ray) takes the path without per lane permutation
+        WatertightRay Coherent[8];
+        for (uint r = 0; r < 8; ++r)
+        {
+            Coherent[r].Set(Vec3(Coordinate(Random), Coordinate(Random), -3.0f), Vec3(0.2f * Coordinate(Random), 0.2f * Coordinate(Random), 1.0f));
+        }
+        const WatertightRay8 CoherentPacket(Coherent);
+        TEST_CHECK(CoherentPacket.mSameAxis);
+        for (uint t = 0; t < 8; ++t)
+        {
+            const Vec8 Hit = RayTriangle8(CoherentPacket, V[t][0], V[t][1], V[t][2]);
+            for (uint r = 0; r < 8; ++r)
+            {
+                TEST_CHECK(sBitEqual(Hit[r], RayTriangle(Coherent[r], V[t][0], V[t][1], V[t][2])));
+            }
+        }
+    }
+}
+
+TOPIA_TEST(RayTriangle, BarycentricsReconstructTheHit)
+{
+    std::mt19937 Random(3434);
+    std::uniform_real_distribution<float> Coordinate(-1.0f, 1.0f), Weight(0.05f, 0.45f);
+    for (uint i = 0; i < 10000; ++i)
+    {
+        const Vec3 V0(Coordinate(Random), Coordinate(Random), Coordinate(Random));
+        const Vec3 V1(Coordinate(Random), Coordinate(Random), Coordinate(Random));
+        const Vec3 V2(Coordinate(Random), Coordinate(Random), Coordinate(Random));
+        const float U = Weight(Random), V = Weight(Random);
+        const Vec3 Target = V0 + U * (V1 - V0) + V * (V2 - V0);
+        const Vec3 Origin = Target + 2.0f * Vec3(Coordinate(Random), Coordinate(Random), Coordinate(Random));
+
+        // Nearly degenerate triangles make the barycentrics ill conditioned
+        if ((V1 - V0).Cross(V2 - V0).Length() < 1.0e-2f)
+        {
+            continue;
+        }
+
+        float HitU = 0.0f, HitV = 0.0f;
+        const float Fraction = RayTriangle(WatertightRay(Origin, Target - Origin), V0, V1, V2, &HitU, &HitV);
+        TEST_CHECK(Fraction != FLT_MAX);
+        TEST_CHECK_CLOSE(Fraction, 1.0f, 1.0e-3f);
+        TEST_CHECK_CLOSE(HitU, U, 1.0e-3f);
+        TEST_CHECK_CLOSE(HitV, V, 1.0e-3f);
+    }
+}
+
+TOPIA_TEST(RayTriangle, NoLeaksThroughSharedVertices)
+{
+    // A bumpy 64 x 64 grid, every ray is aimed exactly at a shared vertex or edge midpoint and must hit at least one triangle
+    const uint Size = 64;
+    std::vector<Vec3> Vertices;
+    for (uint y = 0; y <= Size; ++y)
+    {
+        for (uint x = 0; x <= Size; ++x)
+        {
+            Vertices.push_back(Vec3(float(x), float(y), 0.25f * std::sin(0.7f * x) * std::cos(0.3f * y)));
+        }
+    }
+    // Static storage: heap allocations are not 32 byte aligned before C++17, Vec8 needs that
+    const uint NumBlocks = Size * Size * 2 / 8;
+    static TriangleBlock8 sBlocks[NumBlocks];
+    uint Triangle = 0;
+    for (uint y = 0; y < Size; ++y)
+    {
+        for (uint x = 0; x < Size; ++x)
+        {
+            const Vec3& V00 = Vertices[y * (Size + 1) + x];
+            const Vec3& V10 = Vertices[y * (Size + 1) + x + 1];
+            const Vec3& V01 = Vertices[(y + 1) * (Size + 1) + x];
+            const Vec3& V11 = Vertices[(y + 1) * (Size + 1) + x + 1];
+            sBlocks[Triangle / 8].SetTriangle(Triangle % 8, V00, V10, V11);
+            ++Triangle;
+            sBlocks[Triangle / 8].SetTriangle(Triangle % 8, V00, V11, V01);
+            ++Triangle;
+        }
+    }
+
+    std::mt19937 Random(343434);
+    std::uniform_real_distribution<float> Offset(-20.0f, 20.0f);
+    uint NumLeaks = 0, NumRays = 0;
+    for (uint y = 1; y < Size; ++y)
+    {
+        for (uint x = 1; x < Size; ++x)
+        {
+            const Vec3 Vertex = Vertices[y * (Size + 1) + x];
+            const Vec3 Targets[] = { Vertex, 0.5f * (Vertex + Vertices[y * (Size + 1) + x + 1]), 0.5f * (Vertex + Vertices[(y + 1) * (Size + 1) + x + 1]) };
+            for (const Vec3& Target : Targets)
+            {
+                const Vec3 Origin = Target + Vec3(Offset(Random), Offset(Random), 30.0f);
+                const WatertightRay Ray(Origin, Target - Origin);
+                bool bHit = false;
+                for (uint b = 0; b < NumBlocks && !bHit; ++b)
+                {
+                    bHit = RayTriangle8Any(Ray, sBlocks[b], FLT_MAX);
+                }
+                NumLeaks += bHit ? 0 : 1;
+                ++NumRays;
+            }
+        }
+    }
+    TEST_CHECK(NumRays == 3 * 63 * 63);
+    TEST_CHECK(NumLeaks == 0);
+}
@@ -0,0 +1,274 @@
+#include "TestFramework.h"
+
+#include <RHI.h>
+#include <RecordingRHI.h>
+
+#include <cstring>
+
+using namespace topia;
+
+static const u8 sShaderBytecode[4] = {};
+
+/** Vertex and index buffers filled through the copy queue, and the pipeline that draws them to the back buffer */
+struct FTestScene
+{
+    explicit FTestScene(FRHIDevice& Device)
+    {
+        FBufferDesc UploadDesc;
+        UploadDesc.Size = 1024;
+        UploadDesc.Memory = EMemoryType::Upload;
+        Upload = Device.CreateBuffer(UploadDesc);
+
+        FBufferDesc VertexDesc;
+        VertexDesc.Size = 3 * 12;
+        VertexDesc.Stride = 12;
+        VertexDesc.Usage = EBufferUsage::Vertex;
+        Vertices = Device.CreateBuffer(VertexDesc);
+
+        FBufferDesc IndexDesc;
+        IndexDesc.Size = 3 * 2;
+        IndexDesc.Usage = EBufferUsage::Index;
+        Indices = Device.CreateBuffer(IndexDesc);
+
+        FGraphicsPipelineDesc PipelineDesc;
+        PipelineDesc.VertexShader = { sShaderBytecode, sizeof(sShaderBytecode) };
+        PipelineDesc.VertexElements[0].SemanticName = "POSITION";
+        PipelineDesc.NumVertexElements = 1;
+        PipelineDesc.RenderTargetFormats[0] = EPixelFormat::R8G8B8A8_UNORM;
+        PipelineDesc.bDepthTest = false;
+        PipelineDesc.bDepthWrite = false;
+        Pipeline = Device.CreateGraphicsPipeline(PipelineDesc);
+    }
+
+    void RecordUpload(FRHICommandList& List)
+    {
+        List.Transition(Vertices, EResourceState::Common, EResourceState::CopyDest);
+        List.Transition(Indices, EResourceState::Common, EResourceState::CopyDest);
+        List.CopyBuffer(Vertices, 0, Upload, 0, Vertices->GetDesc().Size);
+        List.CopyBuffer(Indices, 0, Upload, 256, Indices->GetDesc().Size);
+    }
+
+    /** Draws the triangle with the buffers in the states RecordUpload left them in */
+    void RecordFrame(FRHICommandList& List, FRHITexture* pBackBuffer)
+    {
+        const float Color[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const u32 Constants[4] = { 1, 2, 3, 4 };
+        List.Transition(Vertices, EResourceState::CopyDest, EResourceState::VertexBuffer);
+        List.Transition(Indices, EResourceState::CopyDest, EResourceState::IndexBuffer);
+        List.Transition(pBackBuffer, EResourceState::Present, EResourceState::RenderTarget);
+        List.SetRenderTargets(&pBackBuffer, 1, nullptr);
+        List.ClearRenderTarget(pBackBuffer, Color);
+        List.SetViewport(0.0f, 0.0f, float(pBackBuffer->GetDesc().Width), float(pBackBuffer->GetDesc().Height));
+        List.SetScissor(0, 0, pBackBuffer->GetDesc().Width, pBackBuffer->GetDesc().Height);
+        List.SetPipeline(Pipeline);
+        List.SetVertexBuffer(0, Vertices);
+        List.SetIndexBuffer(Indices, EIndexFormat::UInt16);
+        List.SetConstants(Constants, 4);
+        List.DrawIndexed(3);
+        List.Transition(pBackBuffer, EResourceState::RenderTarget, EResourceState::Present);
+    }
+
+    TRefCountPtr<FRHIBuffer> Upload;
+    TRefCountPtr<FRHIBuffer> Vertices;
+    TRefCountPtr<FRHIBuffer> Indices;
+    TRefCountPtr<FRHIGraphicsPipeline> Pipeline;
+};
+
+static FRecordingRHISettings sSettings(bool bCapture)
+{
+    FRecordingRHISettings Settings;
+    Settings.bCapture = bCapture;
+    Settings.bPrintErrors = false;
+    return Settings;
+}
+
+/** Submits the list and returns the errors found in it */
+static std::vector<FRHIValidationError> sSubmit(FRecordingDevice& Device, ERHIQueueType Queue, FRHICommandList& List)
+{
+    Device.ClearErrors();
+    Device.GetQueue(Queue)->Submit(List);
+    return Device.GetErrors();
+}
+
+TOPIA_TEST(RecordingRHI, UploadAndFrame)
+{
+    InitializeGfxSettings(nullptr, 320, 200, false, false);
+    FRecordingDevice Device(sSettings(true));
+    FTestScene Scene(Device);
+    TEST_CHECK(Device.GetBackend() == ERHIBackend::Recording && Scene.Upload && Scene.Vertices && Scene.Indices && Scene.Pipeline);
+    TEST_CHECK(Device.GetBackBuffer()->GetDesc().Width == 320 && Device.GetBackBuffer()->GetDesc().Height == 200);
+
+    // Only upload and readback buffers have CPU memory
+    TEST_CHECK(Scene.Upload->Map() != nullptr);
+    memset(Scene.Upload->Map(), 0, Scene.Upload->GetDesc().Size);
+    Scene.Upload->Unmap();
+
+    // The graphics queue waits for the upload of the copy queue
+    FRHICommandList UploadList;
+    Scene.RecordUpload(UploadList);
+    TRefCountPtr<FRHIFence> Fence = Device.CreateFence();
+    Device.GetQueue(ERHIQueueType::Copy)->Submit(UploadList);
+    Device.GetQueue(ERHIQueueType::Copy)->Signal(Fence, 1);
+    Device.GetQueue(ERHIQueueType::Graphics)->Wait(Fence, 1);
+
+    FRHICommandList FrameList;
+    Scene.RecordFrame(FrameList, Device.GetBackBuffer());
+    Device.GetQueue(ERHIQueueType::Graphics)->Submit(FrameList);
+    Device.Present();
+    Fence->Wait(1);
+    TEST_CHECK(Fence->GetCompletedValue() == 1 && Device.GetErrors().empty());
+
+    const FRecordingRHIStats Stats = Device.GetStats();
+    TEST_CHECK(Stats.NumSubmits == 2 && Stats.NumCommandLists == 2 && Stats.NumErrors == 0 && Stats.NumDraws == 1);
+    TEST_CHECK(Stats.NumCommands == UploadList.GetNumCommands() + FrameList.GetNumCommands() && Stats.NumTransitions == 6);
+    TEST_CHECK(Stats.NumBytes == UploadList.GetSize() + FrameList.GetSize());
+
+    // The capture is the submitted stream as it was recorded
+    const std::vector<u8>& Capture = Device.GetCapture(ERHIQueueType::Graphics);
+    TEST_CHECK(Capture.size() == FrameList.GetSize() && memcmp(Capture.data(), FrameList.GetData(), Capture.size()) == 0);
+    TEST_CHECK(Device.GetCapture(ERHIQueueType::Copy).size() == UploadList.GetSize() && Device.GetCapture(ERHIQueueType::Compute).empty());
+    Device.ClearCapture();
+    TEST_CHECK(Device.GetCapture(ERHIQueueType::Graphics).empty());
+
+    // A reset list records again into the memory it has
+    const u64 Size = FrameList.GetSize();
+    FrameList.Reset();
+    TEST_CHECK(FrameList.GetSize() == 0 && FrameList.GetNumCommands() == 0);
+    Scene.RecordFrame(FrameList, Device.GetBackBuffer());
+    TEST_CHECK(FrameList.GetSize() == Size);
+
+    u32 NumCommands = 0;
+    for (FRHICommandReader Reader(FrameList); Reader.IsValid(); Reader.Next())
+    {
+        ++NumCommands;
+    }
+    TEST_CHECK(NumCommands == FrameList.GetNumCommands());
+}
+
+TOPIA_TEST(RecordingRHI, ValidationErrors)
+{
+    InitializeGfxSettings(nullptr, 64, 64, false, false);
+    FRecordingDevice Device(sSettings(false));
+    FTestScene Scene(Device);
+    FRHICommandList List;
+    Scene.RecordUpload(List);
+    TEST_CHECK(sSubmit(Device, ERHIQueueType::Copy, List).empty());
+
+    // A transition from another state than the one the resource is in, reported at its command
+    List.Reset();
+    List.Transition(Scene.Vertices, EResourceState::Common, EResourceState::VertexBuffer);
+    std::vector<FRHIValidationError> Errors = sSubmit(Device, ERHIQueueType::Graphics, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Queue == ERHIQueueType::Graphics && Errors[0].Command == ERHICommand::Transition && Errors[0].CommandIndex == 0);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Message.find("CopyDest") != std::string::npos);
+
+    // The state after a wrong transition is tracked, so the transition of the frame is the one that is wrong now
+    List.Reset();
+    Scene.RecordFrame(List, Device.GetBackBuffer());
+    Errors = sSubmit(Device, ERHIQueueType::Graphics, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Command == ERHICommand::Transition && Errors[0].CommandIndex == 0);
+
+    // A usage the buffer wasn't created with
+    List.Reset();
+    List.Transition(Scene.Indices, EResourceState::IndexBuffer, EResourceState::ConstantBuffer);
+    Errors = sSubmit(Device, ERHIQueueType::Graphics, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Message.find("usage") != std::string::npos);
+    List.Reset();
+    List.Transition(Scene.Indices, EResourceState::ConstantBuffer, EResourceState::IndexBuffer);
+    TEST_CHECK(sSubmit(Device, ERHIQueueType::Graphics, List).empty());
+
+    // A draw without a pipeline, and indices past the end of their buffer
+    List.Reset();
+    List.Draw(3);
+    Errors = sSubmit(Device, ERHIQueueType::Graphics, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Command == ERHICommand::Draw);
+    List.Reset();
+    FRHITexture* pBackBuffer = Device.GetBackBuffer();
+    List.SetRenderTargets(&pBackBuffer, 1, nullptr);
+    List.SetViewport(0.0f, 0.0f, 64.0f, 64.0f);
+    List.SetScissor(0, 0, 64, 64);
+    List.SetPipeline(Scene.Pipeline);
+    List.SetVertexBuffer(0, Scene.Vertices);
+    List.SetIndexBuffer(Scene.Indices, EIndexFormat::UInt16);
+    List.Transition(pBackBuffer, EResourceState::Present, EResourceState::RenderTarget);
+    List.DrawIndexed(3, 1, 1);
+    List.Transition(pBackBuffer, EResourceState::RenderTarget, EResourceState::Present);
+    Errors = sSubmit(Device, ERHIQueueType::Graphics, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Command == ERHICommand::DrawIndexed && Errors[0].CommandIndex == 7);
+
+    // Graphics commands on the copy queue
+    List.Reset();
+    List.SetViewport(0.0f, 0.0f, 64.0f, 64.0f);
+    Errors = sSubmit(Device, ERHIQueueType::Copy, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Queue == ERHIQueueType::Copy && Errors[0].Command == ERHICommand::SetViewport);
+
+    // Misaligned copies to textures
+    FTextureDesc TextureDesc;
+    TextureDesc.Width = 4;
+    TextureDesc.Height = 4;
+    TRefCountPtr<FRHITexture> Texture = Device.CreateTexture(TextureDesc);
+    List.Reset();
+    List.Transition(Texture, EResourceState::Common, EResourceState::CopyDest);
+    List.CopyBufferToTexture(Texture, Scene.Upload, 0, 16);
+    Errors = sSubmit(Device, ERHIQueueType::Copy, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Command == ERHICommand::CopyBufferToTexture);
+
+    // A resource released before the list is submitted
+    FBufferDesc ConstantDesc;
+    ConstantDesc.Size = 256;
+    ConstantDesc.Usage = EBufferUsage::Constant;
+    TRefCountPtr<FRHIBuffer> Constants = Device.CreateBuffer(ConstantDesc);
+    List.Reset();
+    List.SetConstantBuffer(0, Constants);
+    Constants = nullptr;
+    Errors = sSubmit(Device, ERHIQueueType::Graphics, List);
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Message.find("released") != std::string::npos);
+
+    // A CPU wait for a value nothing signals would never return, and a Present of a back buffer still being rendered to
+    Device.ClearErrors();
+    TRefCountPtr<FRHIFence> Fence = Device.CreateFence(1);
+    Fence->Wait(1);
+    TEST_CHECK(Device.GetErrors().empty());
+    Fence->Wait(2);
+    Errors = Device.GetErrors();
+    TEST_CHECK(Errors.size() == 1 && Errors[0].Queue == ERHIQueueType::Num);
+    Device.ClearErrors();
+    List.Reset();
+    List.Transition(Device.GetBackBuffer(), EResourceState::Present, EResourceState::RenderTarget);
+    TEST_CHECK(sSubmit(Device, ERHIQueueType::Graphics, List).empty());
+    Device.Present();
+    TEST_CHECK(Device.GetErrors().size() == 1);
+
+    // Errors are counted in the stats after they are cleared
+    TEST_CHECK(Device.GetStats().NumErrors == 10);
+}
+
+TOPIA_TEST(RecordingRHI, CreateDevice)
+{
+    InitializeGfxSettings(nullptr, 128, 96, false, false);
+
+    // Descs that can't be created give null
+    FRecordingDevice Device(sSettings(false));
+    TEST_CHECK(!Device.CreateBuffer(FBufferDesc()));
+    FTextureDesc TextureDesc;
+    TextureDesc.Format = EPixelFormat::Unknown;
+    TEST_CHECK(!Device.CreateTexture(TextureDesc));
+    TEST_CHECK(!Device.CreateGraphicsPipeline(FGraphicsPipelineDesc()));
+
+    // Present flips between two back buffers
+    FRHITexture* pFirst = Device.GetBackBuffer();
+    Device.Present();
+    TEST_CHECK(Device.GetBackBuffer() != pFirst);
+    Device.Present();
+    TEST_CHECK(Device.GetBackBuffer() == pFirst && Device.GetErrors().empty());
+
+#if !ENABLE_RHI_D3D12
+    // Not compiled in, so there is nothing to create
+    TEST_CHECK(CreateRHIDevice(ERHIBackend::D3D12) == nullptr);
+#endif
+
+    Initialize_RHI(ERHIBackend::Recording);
+    TEST_CHECK(GfxDevice != nullptr && GfxDevice->GetBackend() == ERHIBackend::Recording);
+    TEST_CHECK(GfxDevice->GetBackBuffer()->GetDesc().Width == 128 && GfxDevice->GetBackBuffer()->GetDesc().Height == 96);
+    Shutdown_RHI();
+    TEST_CHECK(GfxDevice == nullptr);
+}
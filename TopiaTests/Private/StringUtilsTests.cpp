@@ -0,0 +1,214 @@
+#include "TestFramework.h"
+
+#include <StringUtils.h>
+
+#include <random>
+
+using namespace topia;
+
+/** The code points as UTF-16 where wchar_t is 16 bits and UTF-32 elsewhere */
+static std::wstring sWide(std::initializer_list<u32> CodePoints)
+{
+    std::wstring Wide;
+    for (u32 CodePoint : CodePoints)
+    {
+        if (sizeof(wchar_t) == 2 && CodePoint >= 0x10000)
+        {
+            Wide += wchar_t(0xD800 + ((CodePoint - 0x10000) >> 10));
+            Wide += wchar_t(0xDC00 + ((CodePoint - 0x10000) & 0x3FF));
+        }
+        else
+        {
+            Wide += wchar_t(CodePoint);
+        }
+    }
+    return Wide;
+}
+
+/** Reference encoder, one code point at a time */
+static std::string sUTF8(u32 CodePoint)
+{
+    std::string UTF8;
+    if (CodePoint < 0x80)
+    {
+        UTF8 += char(CodePoint);
+    }
+    else if (CodePoint < 0x800)
+    {
+        UTF8 += char(0xC0 | (CodePoint >> 6));
+        UTF8 += char(0x80 | (CodePoint & 0x3F));
+    }
+    else if (CodePoint < 0x10000)
+    {
+        UTF8 += char(0xE0 | (CodePoint >> 12));
+        UTF8 += char(0x80 | ((CodePoint >> 6) & 0x3F));
+        UTF8 += char(0x80 | (CodePoint & 0x3F));
+    }
+    else
+    {
+        UTF8 += char(0xF0 | (CodePoint >> 18));
+        UTF8 += char(0x80 | ((CodePoint >> 12) & 0x3F));
+        UTF8 += char(0x80 | ((CodePoint >> 6) & 0x3F));
+        UTF8 += char(0x80 | (CodePoint & 0x3F));
+    }
+    return UTF8;
+}
+
+TOPIA_TEST(StringUtils, PathViews)
+{
+    const FStringView Path("Assets/Meshes.d\\Rock.LOD0.tmesh");
+    TEST_CHECK(GetBasePathView(Path) == FStringView("Assets/Meshes.d\\"));
+    TEST_CHECK(RemoveBasePathView(Path) == FStringView("Rock.LOD0.tmesh"));
+    TEST_CHECK(GetFileExtensionView(Path) == FStringView("tmesh"));
+    TEST_CHECK(RemoveExtensionView(Path) == FStringView("Assets/Meshes.d\\Rock.LOD0"));
+
+    // The views point into the path
+    TEST_CHECK(RemoveBasePathView(Path).data() == Path.data() + 16 && GetFileExtensionView(Path).end() == Path.end());
+
+    // A dot in a directory name is not an extension
+    const FStringView Dotted("shaders.d/common");
+    TEST_CHECK(GetFileExtensionView(Dotted).empty() && RemoveExtensionView(Dotted) == Dotted);
+    TEST_CHECK(GetBasePathView("name.ext").empty() && RemoveBasePathView("name.ext") == FStringView("name.ext"));
+    TEST_CHECK(GetBasePathView("dir/") == FStringView("dir/") && RemoveBasePathView("dir/").empty() && GetFileExtensionView("dir/").empty());
+    TEST_CHECK(GetFileExtensionView("name.").empty() && RemoveExtensionView("name.") == FStringView("name"));
+    TEST_CHECK(GetBasePathView(FStringView()).empty() && RemoveExtensionView(FStringView()).empty());
+
+    const FWStringView WidePath(L"C:\\Game/Content\\Crate.ttex");
+    TEST_CHECK(GetBasePathView(WidePath) == FWStringView(L"C:\\Game/Content\\") && RemoveBasePathView(WidePath) == FWStringView(L"Crate.ttex"));
+    TEST_CHECK(GetFileExtensionView(WidePath) == FWStringView(L"ttex") && RemoveExtensionView(WidePath) == FWStringView(L"C:\\Game/Content\\Crate"));
+
+    // The std::string versions wrap the views
+    TEST_CHECK(GetBasePath(std::string("a/b/c.d")) == "a/b/" && RemoveBasePath(std::string("a/b/c.d")) == "c.d");
+    TEST_CHECK(GetFileExtension(std::string("a.b/c")) == "" && RemoveExtension(std::wstring(L"a.b/c.d")) == L"a.b/c");
+}
+
+TOPIA_TEST(StringUtils, ToLower)
+{
+    // Longer than a vector so both the 16 byte steps and the remainder run, with every byte value
+    std::string All;
+    for (u32 i = 0; i < 2; ++i)
+    {
+        for (u32 c = 1; c < 256; ++c)
+        {
+            All += char(c);
+        }
+    }
+    std::string Expected = All;
+    for (char& c : Expected)
+    {
+        c = (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+    }
+    std::string Lower(All.size(), '\0');
+    ToLowerASCII(All, &Lower[0]);
+    TEST_CHECK(Lower == Expected && ToLower(All) == Expected);
+
+    // In place, and UTF-8 text stays as it is apart from the ASCII letters
+    std::string Text = "\xC3\x84PFEL/Stra\xC3\x9F" "E.TXT";
+    ToLowerASCII(Text, &Text[0]);
+    TEST_CHECK(Text == "\xC3\x84pfel/stra\xC3\x9F" "e.txt");
+
+    std::wstring Wide = sWide({ 'A', 'b', 'Z', '@', '[', 0xC4, 0x0130, 0x8041, 0xFF21 }) + L"ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    ToLowerASCII(Wide, &Wide[0]);
+    TEST_CHECK(Wide == sWide({ 'a', 'b', 'z', '@', '[', 0xC4, 0x0130, 0x8041, 0xFF21 }) + L"abcdefghijklmnopqrstuvwxyz");
+    TEST_CHECK(ToLower(std::wstring(L"MiXeD")) == L"mixed");
+}
+
+TOPIA_TEST(StringUtils, UTF8ToWide)
+{
+    TEST_CHECK(UTF8ToWide("").empty() && WideToUTF8(L"").empty());
+
+    // One, two, three and four byte sequences, after a run of ASCII long enough for the 16 character steps
+    const std::string ASCII = "textures/terrain/";
+    const std::string Text = ASCII + "\xC3\xA4" "b\xE2\x82\xAC" "c\xF0\x9F\x98\x80";
+    const std::wstring Wide = UTF8ToWide(Text);
+    TEST_CHECK(Wide == std::wstring(ASCII.begin(), ASCII.end()) + sWide({ 0xE4, 'b', 0x20AC, 'c', 0x1F600 }));
+    TEST_CHECK(WideToUTF8(Wide) == Text);
+    TEST_CHECK(UTF8ToWide(ASCII + ASCII) == std::wstring(ASCII.begin(), ASCII.end()) + std::wstring(ASCII.begin(), ASCII.end()));
+
+    // Invalid sequences become U+FFFD, a truncated sequence byte by byte so the character after it is kept
+    TEST_CHECK(UTF8ToWide("a\x80" "b") == sWide({ 'a', 0xFFFD, 'b' }));
+    TEST_CHECK(UTF8ToWide("\xFF\xFE") == sWide({ 0xFFFD, 0xFFFD }));
+    TEST_CHECK(UTF8ToWide("\xE2\x82" "A") == sWide({ 0xFFFD, 0xFFFD, 'A' }));
+    TEST_CHECK(UTF8ToWide("\xF0\x9F\x98") == sWide({ 0xFFFD, 0xFFFD, 0xFFFD }));
+    TEST_CHECK(UTF8ToWide("\xC3\xA4\xC3") == sWide({ 0xE4, 0xFFFD }));
+
+    // Overlong encodings, encoded surrogates and code points past U+10FFFF
+    TEST_CHECK(UTF8ToWide("\xC0\x80" "x") == sWide({ 0xFFFD, 'x' }));
+    TEST_CHECK(UTF8ToWide("\xE0\x80\xAF") == sWide({ 0xFFFD }));
+    TEST_CHECK(UTF8ToWide("\xF0\x80\x80\xAF") == sWide({ 0xFFFD }));
+    TEST_CHECK(UTF8ToWide("\xED\xA0\x80" "\xED\xBF\xBF") == sWide({ 0xFFFD, 0xFFFD }));
+    TEST_CHECK(UTF8ToWide("\xF4\x8F\xBF\xBF" "\xF4\x90\x80\x80") == sWide({ 0x10FFFF, 0xFFFD }));
+
+    // The buffer version writes at most one character per byte and returns the count
+    const std::string Invalid = ASCII + "\xE2\x82\xF0\x9F\x98\x80\x80";
+    std::vector<wchar_t> Buffer(Invalid.size() + 1, L'#');
+    const size_t Count = UTF8ToWide(Invalid, Buffer.data());
+    TEST_CHECK(std::wstring(Buffer.data(), Count) == std::wstring(ASCII.begin(), ASCII.end()) + sWide({ 0xFFFD, 0xFFFD, 0x1F600, 0xFFFD }));
+    TEST_CHECK(Buffer.back() == L'#');
+}
+
+TOPIA_TEST(StringUtils, WideToUTF8)
+{
+    TEST_CHECK(WideToUTF8(sWide({ 'a', 0x7F, 0x80, 0x7FF, 0x800, 0xFFFF, 0x10000, 0x10FFFF })) ==
+        "a\x7F" "\xC2\x80" "\xDF\xBF" "\xE0\xA0\x80" "\xEF\xBF\xBF" "\xF0\x90\x80\x80" "\xF4\x8F\xBF\xBF");
+
+    // Unpaired surrogates become U+FFFD
+    const std::string Replacement = "\xEF\xBF\xBD";
+    TEST_CHECK(WideToUTF8(sWide({ 0xD800 })) == Replacement);
+    TEST_CHECK(WideToUTF8(sWide({ 0xDC00, 'a' })) == Replacement + "a");
+    TEST_CHECK(WideToUTF8(sWide({ 0xD83D, 'a', 0xDE00 })) == Replacement + "a" + Replacement);
+    if (sizeof(wchar_t) == 4)
+    {
+        TEST_CHECK(WideToUTF8(sWide({ 0x110000, 'a' })) == Replacement + "a");
+    }
+
+    // A run of ASCII interrupted by other characters at every position of the 16 character steps
+    for (u32 Position = 0; Position < 40; ++Position)
+    {
+        std::wstring Wide(40, L'x');
+        Wide[Position] = wchar_t(0xE9);
+        std::string Expected(40, 'x');
+        Expected.replace(Position, 1, "\xC3\xA9");
+        TEST_CHECK(WideToUTF8(Wide) == Expected && UTF8ToWide(Expected) == Wide);
+    }
+
+    // The buffer version writes at most UTF8_PER_WIDE_CHAR bytes per character
+    const std::wstring Wide = sWide({ 0xFFFF, 0xFFFF, 0xD800 });
+    std::vector<char> Buffer(Wide.size() * UTF8_PER_WIDE_CHAR + 1, '#');
+    const size_t Count = WideToUTF8(Wide, Buffer.data());
+    TEST_CHECK(std::string(Buffer.data(), Count) == "\xEF\xBF\xBF\xEF\xBF\xBF" + Replacement && Buffer.back() == '#');
+}
+
+TOPIA_TEST(StringUtils, RandomRoundTrips)
+{
+    std::mt19937 Random(48);
+    for (u32 Iteration = 0; Iteration < 1000; ++Iteration)
+    {
+        // Valid text, mostly ASCII with runs of every encoded length
+        std::string UTF8;
+        std::wstring Expected;
+        const u32 NumCodePoints = Random() % 64;
+        for (u32 i = 0; i < NumCodePoints; ++i)
+        {
+            static const u32 sLimits[] = { 0x80, 0x80, 0x800, 0x10000, 0x110000 };
+            u32 CodePoint = Random() % sLimits[Random() % 5];
+            CodePoint = (CodePoint >= 0xD800 && CodePoint <= 0xDFFF) ? 'S' : CodePoint;
+            UTF8 += sUTF8(CodePoint);
+            Expected += sWide({ CodePoint });
+        }
+        const std::wstring Wide = UTF8ToWide(UTF8);
+        TEST_CHECK(Wide == Expected && WideToUTF8(Wide) == UTF8);
+
+        // Random bytes, the output stays within the buffer bound and converts back to the same characters
+        std::string Bytes(Random() % 64, '\0');
+        for (char& c : Bytes)
+        {
+            c = char(Random() % 3 == 0 ? 'a' + Random() % 26 : Random());
+        }
+        std::vector<wchar_t> Buffer(Bytes.size() + 1, L'#');
+        const size_t Count = UTF8ToWide(Bytes, Buffer.data());
+        TEST_CHECK(Count <= Bytes.size() && Buffer.back() == L'#');
+        const std::wstring Converted(Buffer.data(), Count);
+        TEST_CHECK(UTF8ToWide(WideToUTF8(Converted)) == Converted);
+    }
+}
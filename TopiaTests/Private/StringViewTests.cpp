@@ -0,0 +1,90 @@
+#include "TestFramework.h"
+
+#include <StringView.h>
+
+using namespace topia;
+
+TOPIA_TEST(StringView, ConstructionAndAccess)
+{
+    const std::string String = "textures/crate.ttex";
+    const FStringView FromString(String);
+    const FStringView FromPointer("textures/crate.ttex");
+    TEST_CHECK(FromString.data() == String.data() && FromString.size() == String.size() && FromString.length() == String.size());
+    TEST_CHECK(FromPointer == FromString && std::string(FromPointer) == String);
+    TEST_CHECK(FromString.front() == 't' && FromString.back() == 'x' && FromString[8] == '/' && FromString[9] == 'c');
+    TEST_CHECK(std::string(FromString.begin(), FromString.end()) == String);
+
+    // The view ends where the size says, not at a null character
+    const FStringView Prefix(String.data(), 8);
+    TEST_CHECK(Prefix == FStringView("textures") && Prefix != FromString);
+
+    const FStringView Empty;
+    TEST_CHECK(Empty.empty() && Empty.size() == 0 && Empty == FStringView("") && Empty.begin() == Empty.end());
+
+    FStringView Trimmed = FromString;
+    Trimmed.remove_prefix(9);
+    Trimmed.remove_suffix(5);
+    TEST_CHECK(Trimmed == FStringView("crate"));
+}
+
+TOPIA_TEST(StringView, Substr)
+{
+    const FStringView View("meshes/rock.tmesh");
+    TEST_CHECK(View.substr(7) == FStringView("rock.tmesh"));
+    TEST_CHECK(View.substr(7, 4) == FStringView("rock"));
+    TEST_CHECK(View.substr(12, 100) == FStringView("tmesh"));
+    TEST_CHECK(View.substr(0) == View && View.substr(0, 0).empty());
+
+    // Past the end gives an empty view instead of throwing
+    TEST_CHECK(View.substr(View.size()).empty() && View.substr(View.size() + 10, 3).empty());
+    TEST_CHECK(FStringView().substr(0).empty() && FStringView().substr(5).empty());
+}
+
+TOPIA_TEST(StringView, Find)
+{
+    const FStringView View("a/b.c/d.e");
+    TEST_CHECK(View.find('/') == 1 && View.find('/', 2) == 5 && View.find('/', 6) == FStringView::npos);
+    TEST_CHECK(View.find('a', 1) == FStringView::npos && View.find('x') == FStringView::npos);
+    TEST_CHECK(View.find('e', View.size()) == FStringView::npos && View.find('a', FStringView::npos) == FStringView::npos);
+
+    TEST_CHECK(View.rfind('.') == 7 && View.rfind('.', 6) == 3 && View.rfind('.', 7) == 7 && View.rfind('.', 2) == FStringView::npos);
+    TEST_CHECK(View.rfind('a') == 0 && View.rfind('a', 0) == 0 && View.rfind('e', 100) == 8);
+
+    TEST_CHECK(View.find_last_of("/\\") == 5 && View.find_last_of("/\\", 4) == 1 && View.find_last_of("/\\", 0) == FStringView::npos);
+    TEST_CHECK(View.find_last_of("xyz") == FStringView::npos && View.find_last_of("") == FStringView::npos);
+    TEST_CHECK(FStringView("dir\\name").find_last_of("/\\") == 3);
+
+    // An empty view finds nothing in any direction
+    const FStringView Empty;
+    TEST_CHECK(Empty.find('a') == FStringView::npos && Empty.rfind('a') == FStringView::npos);
+    TEST_CHECK(Empty.find_last_of("a") == FStringView::npos);
+}
+
+TOPIA_TEST(StringView, CompareAndAffixes)
+{
+    TEST_CHECK(FStringView("abc").compare("abc") == 0);
+    TEST_CHECK(FStringView("abc").compare("abd") < 0 && FStringView("abd").compare("abc") > 0);
+    TEST_CHECK(FStringView("ab").compare("abc") < 0 && FStringView("abc").compare("ab") > 0);
+    TEST_CHECK(FStringView().compare("") == 0 && FStringView().compare("a") < 0);
+    TEST_CHECK(FStringView("ab") < FStringView("abc") && !(FStringView("abc") < FStringView("abc")) && FStringView("B") < FStringView("a"));
+
+    // The view of a string with an embedded null compares all its characters
+    const std::string Embedded("a\0b", 3);
+    TEST_CHECK(FStringView(Embedded) != FStringView("a") && FStringView(Embedded).compare(FStringView("a\0c", 3)) < 0);
+
+    const FStringView Path("shaders/common.hlsl");
+    TEST_CHECK(Path.starts_with("shaders/") && Path.starts_with("") && Path.starts_with(Path) && !Path.starts_with("shaders/common.hlsl2"));
+    TEST_CHECK(!Path.starts_with("textures/") && !FStringView().starts_with("a"));
+    TEST_CHECK(Path.ends_with(".hlsl") && Path.ends_with("") && Path.ends_with(Path) && !Path.ends_with(".hlsli"));
+    TEST_CHECK(!Path.ends_with("xshaders/common.hlsl") && !FStringView().ends_with("a"));
+}
+
+TOPIA_TEST(StringView, Wide)
+{
+    const std::wstring String = L"Textures\\Crate.ttex";
+    const FWStringView View(String);
+    TEST_CHECK(View == FWStringView(L"Textures\\Crate.ttex") && std::wstring(View) == String);
+    TEST_CHECK(View.find(L'\\') == 8 && View.rfind(L'.') == 14 && View.find_last_of(L"/\\") == 8);
+    TEST_CHECK(View.substr(9) == FWStringView(L"Crate.ttex") && View.starts_with(L"Textures") && View.ends_with(L".ttex"));
+    TEST_CHECK(View.compare(L"Textures") > 0 && FWStringView(L"A") < FWStringView(L"B"));
+}
@@ -0,0 +1,241 @@
+#include "TestFramework.h"
+
+#include <PrimitiveGenerator.h>
+#include <TangentGenerator.h>
+#include <TopiaMath.h>
+#include <Vec3.h>
+
+#include <cstring>
+
+#ifdef TOPIA_TESTS_MIKKTSPACE
+#include <mikktspace.h>
+#endif
+
+using namespace topia;
+
+struct FTangentTestMesh
+{
+    std::vector<Float3> Positions;
+    std::vector<Float3> Normals;
+    std::vector<Float4> Tangents;   // Of the generator, per vertex
+    std::vector<Float2> TexCoords;
+    std::vector<u32> Indices;
+};
+
+static FTangentTestMesh sGenerate(const FPrimitiveDesc& Desc)
+{
+    const FPrimitiveCounts Counts = GetPrimitiveCounts(Desc);
+    FTangentTestMesh Mesh;
+    Mesh.Positions.resize(Counts.NumVertices);
+    Mesh.Normals.resize(Counts.NumVertices);
+    Mesh.Tangents.resize(Counts.NumVertices);
+    Mesh.TexCoords.resize(Counts.NumVertices);
+    Mesh.Indices.resize(Counts.NumIndices);
+    FPrimitiveStreams Streams;
+    Streams.pPositions = Mesh.Positions.data();
+    Streams.pNormals = Mesh.Normals.data();
+    Streams.pTangents = Mesh.Tangents.data();
+    Streams.pTexCoords = Mesh.TexCoords.data();
+    Streams.pIndices32 = Mesh.Indices.data();
+    GeneratePrimitive(Desc, Streams);
+    return Mesh;
+}
+
+static std::vector<Float4> sGenerateTangents(const FTangentTestMesh& Mesh)
+{
+    std::vector<Float4> Tangents(Mesh.Indices.size());
+    GenerateTangents(Mesh.Indices.data(), u32(Mesh.Indices.size()), Mesh.Positions.data(), Mesh.Normals.data(), Mesh.TexCoords.data(),
+        u32(Mesh.Positions.size()), Tangents.data());
+    return Tangents;
+}
+
+/**
+ * Meshes that exercise the different paths of MikkTSpace: smooth shapes with texture seams, hard edges, mirrored texture
+ * coordinates, degenerate and duplicated triangles, vertices with -0 and a triangle soup with random attributes.
+ */
+static std::vector<FTangentTestMesh> sTestMeshes()
+{
+    std::vector<FTangentTestMesh> Meshes;
+    for (EPrimitiveType Type : { EPrimitiveType::Sphere, EPrimitiveType::Icosphere, EPrimitiveType::Cube, EPrimitiveType::Cylinder,
+        EPrimitiveType::Capsule, EPrimitiveType::Torus })
+    {
+        FPrimitiveDesc Desc(Type);
+        Desc.Subdivisions = Type == EPrimitiveType::Icosphere ? 4 : 3;
+        Meshes.push_back(sGenerate(Desc));
+    }
+
+    // The left half of the sphere mirrored in u
+    FTangentTestMesh Mirrored = sGenerate(FPrimitiveDesc(EPrimitiveType::Sphere));
+    for (Float2& TexCoord : Mirrored.TexCoords)
+    {
+        TexCoord.x = TexCoord.x > 0.5f ? 1.0f - TexCoord.x : TexCoord.x;
+    }
+    Meshes.push_back(Mirrored);
+
+    // Degenerate triangles (repeated index, zero uv area, collinear) and every triangle twice
+    FTangentTestMesh Degenerate = sGenerate(FPrimitiveDesc(EPrimitiveType::Torus));
+    const size_t NumIndices = Degenerate.Indices.size();
+    for (size_t i = 0; i < NumIndices; ++i)
+    {
+        Degenerate.Indices.push_back(Degenerate.Indices[i]);
+    }
+    for (size_t t = 0; t < NumIndices; t += 3 * 7)
+    {
+        Degenerate.Indices[t + 1] = Degenerate.Indices[t];
+    }
+    for (size_t t = 3; t < NumIndices; t += 3 * 11)
+    {
+        Degenerate.TexCoords[Degenerate.Indices[t + 1]] = Degenerate.TexCoords[Degenerate.Indices[t]];
+    }
+    Meshes.push_back(Degenerate);
+
+    // Random soup where some vertices are equal and some positions are -0
+    FTangentTestMesh Soup;
+    std::mt19937 Random(42);
+    std::uniform_real_distribution<float> Value(-1.0f, 1.0f);
+    std::uniform_int_distribution<u32> Pick(0, 63);
+    for (u32 v = 0; v < 64; ++v)
+    {
+        const Vec3 Normal = Vec3(Value(Random), Value(Random), Value(Random)).NormalizedOr(Vec3::sAxisY());
+        Soup.Positions.push_back(v % 9 == 0 ? Float3(-0.0f, Value(Random), 0.0f) : Float3(Value(Random), Value(Random), Value(Random)));
+        Soup.Normals.push_back(Float3(Normal.GetX(), Normal.GetY(), Normal.GetZ()));
+        Soup.TexCoords.push_back(Float2(Value(Random), Value(Random)));
+    }
+    Soup.Positions[63] = Soup.Positions[62];
+    Soup.Normals[63] = Soup.Normals[62];
+    Soup.TexCoords[63] = Soup.TexCoords[62];
+    for (u32 i = 0; i < 3 * 200; ++i)
+    {
+        Soup.Indices.push_back(Pick(Random));
+    }
+    Meshes.push_back(Soup);
+    return Meshes;
+}
+
+TOPIA_TEST(TangentGenerator, MatchesAnalyticTangents)
+{
+    // Away from the poles the tangent of a UV sphere is the direction of increasing u. The handedness is the opposite of the
+    // generator's: MikkTSpace's bitangent points towards increasing v, the glTF convention of the generator towards decreasing v.
+    FPrimitiveDesc Desc(EPrimitiveType::Sphere);
+    const FTangentTestMesh Mesh = sGenerate(Desc);
+    const std::vector<Float4> Tangents = sGenerateTangents(Mesh);
+    for (size_t c = 0; c < Mesh.Indices.size(); ++c)
+    {
+        const u32 Vertex = Mesh.Indices[c];
+        const Vec3 Normal(Mesh.Normals[Vertex]), Tangent(Tangents[c].x, Tangents[c].y, Tangents[c].z);
+        TEST_CHECK_CLOSE(Tangent.Length(), 1.0f, 1.0e-5f);
+        TEST_CHECK(std::abs(Tangent.Dot(Normal)) < 1.0e-4f);
+        if (std::abs(Normal.GetY()) < 0.9f)
+        {
+            const Float4& Expected = Mesh.Tangents[Vertex];
+            TEST_CHECK(Tangent.Dot(Vec3(Expected.x, Expected.y, Expected.z)) > 0.99f);
+            TEST_CHECK(Tangents[c].w == -Expected.w);
+        }
+    }
+}
+
+TOPIA_TEST(TangentGenerator, MirroredTexCoordsFlipTheTangent)
+{
+    // u -> 1 - u reverses the direction of the tangent and the handedness of the bitangent
+    const FTangentTestMesh Mesh = sGenerate(FPrimitiveDesc(EPrimitiveType::Torus));
+    FTangentTestMesh Mirrored = Mesh;
+    for (Float2& TexCoord : Mirrored.TexCoords)
+    {
+        TexCoord.x = 1.0f - TexCoord.x;
+    }
+    const std::vector<Float4> Tangents = sGenerateTangents(Mesh), MirroredTangents = sGenerateTangents(Mirrored);
+    for (size_t c = 0; c < Tangents.size(); ++c)
+    {
+        const Vec3 Tangent(Tangents[c].x, Tangents[c].y, Tangents[c].z), MirroredTangent(MirroredTangents[c].x, MirroredTangents[c].y, MirroredTangents[c].z);
+        TEST_CHECK(Tangent.Dot(MirroredTangent) < -0.99f);
+        TEST_CHECK(Tangents[c].w == -MirroredTangents[c].w);
+    }
+}
+
+TOPIA_TEST(TangentGenerator, OutputIsFiniteForEveryMesh)
+{
+    for (const FTangentTestMesh& Mesh : sTestMeshes())
+    {
+        for (const Float4& Tangent : sGenerateTangents(Mesh))
+        {
+            TEST_CHECK(std::isfinite(Tangent.x) && std::isfinite(Tangent.y) && std::isfinite(Tangent.z));
+            TEST_CHECK(Tangent.w == 1.0f || Tangent.w == -1.0f);
+        }
+    }
+}
+
+// Optional comparison with the reference implementation, only built when TopiaTests is configured with TOPIA_MIKKTSPACE_DIR
+#ifdef TOPIA_TESTS_MIKKTSPACE
+
+/** Callbacks of the reference implementation for a triangle list */
+struct FMikkTSpaceMesh
+{
+    const FTangentTestMesh* pMesh;
+    std::vector<Float4> Tangents;
+
+    static const FMikkTSpaceMesh& sGet(const SMikkTSpaceContext* pContext) { return *static_cast<const FMikkTSpaceMesh*>(pContext->m_pUserData); }
+    static u32 sIndex(const SMikkTSpaceContext* pContext, int Face, int Corner) { return sGet(pContext).pMesh->Indices[size_t(Face) * 3 + Corner]; }
+
+    static int sGetNumFaces(const SMikkTSpaceContext* pContext) { return int(sGet(pContext).pMesh->Indices.size() / 3); }
+    static int sGetNumVerticesOfFace(const SMikkTSpaceContext*, int) { return 3; }
+
+    static void sGetPosition(const SMikkTSpaceContext* pContext, float Out[], int Face, int Corner)
+    {
+        memcpy(Out, &sGet(pContext).pMesh->Positions[sIndex(pContext, Face, Corner)], sizeof(Float3));
+    }
+
+    static void sGetNormal(const SMikkTSpaceContext* pContext, float Out[], int Face, int Corner)
+    {
+        memcpy(Out, &sGet(pContext).pMesh->Normals[sIndex(pContext, Face, Corner)], sizeof(Float3));
+    }
+
+    static void sGetTexCoord(const SMikkTSpaceContext* pContext, float Out[], int Face, int Corner)
+    {
+        memcpy(Out, &sGet(pContext).pMesh->TexCoords[sIndex(pContext, Face, Corner)], sizeof(Float2));
+    }
+
+    static void sSetTSpaceBasic(const SMikkTSpaceContext* pContext, const float Tangent[], float Sign, int Face, int Corner)
+    {
+        FMikkTSpaceMesh& Self = *static_cast<FMikkTSpaceMesh*>(pContext->m_pUserData);
+        Self.Tangents[size_t(Face) * 3 + Corner] = Float4(Tangent[0], Tangent[1], Tangent[2], Sign);
+    }
+};
+
+TOPIA_TEST(MikkTSpaceReference, MatchesBitwise)
+{
+    SMikkTSpaceInterface Interface = {};
+    Interface.m_getNumFaces = &FMikkTSpaceMesh::sGetNumFaces;
+    Interface.m_getNumVerticesOfFace = &FMikkTSpaceMesh::sGetNumVerticesOfFace;
+    Interface.m_getPosition = &FMikkTSpaceMesh::sGetPosition;
+    Interface.m_getNormal = &FMikkTSpaceMesh::sGetNormal;
+    Interface.m_getTexCoord = &FMikkTSpaceMesh::sGetTexCoord;
+    Interface.m_setTSpaceBasic = &FMikkTSpaceMesh::sSetTSpaceBasic;
+
+    u32 MeshIndex = 0;
+    for (const FTangentTestMesh& Mesh : sTestMeshes())
+    {
+        FMikkTSpaceMesh Reference;
+        Reference.pMesh = &Mesh;
+        Reference.Tangents.resize(Mesh.Indices.size());
+        SMikkTSpaceContext Context = {};
+        Context.m_pInterface = &Interface;
+        Context.m_pUserData = &Reference;
+        TEST_CHECK(genTangSpaceDefault(&Context) != 0);
+
+        const std::vector<Float4> Tangents = sGenerateTangents(Mesh);
+        u32 NumDifferent = 0;
+        for (size_t c = 0; c < Tangents.size(); ++c)
+        {
+            if (memcmp(&Tangents[c], &Reference.Tangents[c], sizeof(Float4)) != 0 && NumDifferent++ == 0)
+            {
+                printf("  mesh %u corner %u: (%a %a %a %g), reference (%a %a %a %g)\n", MeshIndex, u32(c),
+                    Tangents[c].x, Tangents[c].y, Tangents[c].z, Tangents[c].w,
+                    Reference.Tangents[c].x, Reference.Tangents[c].y, Reference.Tangents[c].z, Reference.Tangents[c].w);
+            }
+        }
+        TEST_CHECK(NumDifferent == 0);
+        ++MeshIndex;
+    }
+}
+
+#endif // TOPIA_TESTS_MIKKTSPACE
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Topia.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal test registry for TopiaTests. TOPIA_TEST(Suite, Name) defines and registers a test function, TEST_CHECK records a
+ * failed expectation and keeps going so one run reports every broken check. The suite name is what ctest filters on.
+ * TOPIA_BENCHMARK(Suite, Name) registers a benchmark instead, which only runs with --bench and prints its own measurements.
+ */
+
+namespace topia
+{
+    struct FTestCase
+    {
+        const char* Suite;
+        const char* Name;
+        void (*Function)();
+        bool bBenchmark;
+    };
+
+    /** All registered tests in registration order */
+    std::vector<FTestCase>& GetTestCases();
+
+    /** Counts a failure of the running test and prints where it happened */
+    void ReportTestFailure(const char* File, int Line, const char* Expression);
+
+    /** Directory with the test input files, ends with a separator */
+    std::string GetTestDataDirectory();
+
+    /** Directory the tests may write to, ends with a separator. Every suite uses a subdirectory named after it. */
+    std::string GetTestTempDirectory();
+
+    struct FTestRegistrar
+    {
+        FTestRegistrar(const char* Suite, const char* Name, void (*Function)(), bool bBenchmark = false)
+        {
+            GetTestCases().push_back({ Suite, Name, Function, bBenchmark });
+        }
+    };
+}
+
+#define TOPIA_TEST(Suite, Name)                                                                                \
+    static void sTest_##Suite##_##Name();                                                                      \
+    static const topia::FTestRegistrar sTestRegistrar_##Suite##_##Name(#Suite, #Name, &sTest_##Suite##_##Name); \
+    static void sTest_##Suite##_##Name()
+
+#define TOPIA_BENCHMARK(Suite, Name)                                                                                        \
+    static void sBenchmark_##Suite##_##Name();                                                                                  \
+    static const topia::FTestRegistrar sBenchmarkRegistrar_##Suite##_##Name(#Suite, #Name, &sBenchmark_##Suite##_##Name, true); \
+    static void sBenchmark_##Suite##_##Name()
+
+#define TEST_CHECK(Condition)                                                \
+    do                                                                       \
+    {                                                                        \
+        if (!(Condition))                                                    \
+        {                                                                    \
+            topia::ReportTestFailure(__FILE__, __LINE__, #Condition);        \
+        }                                                                    \
+    } while (false)
+
+#define TEST_CHECK_CLOSE(A, B, Tolerance)                                                        \
+    do                                                                                           \
+    {                                                                                            \
+        if (!(std::abs(double(A) - double(B)) <= double(Tolerance)))                             \
+        {                                                                                        \
+            topia::ReportTestFailure(__FILE__, __LINE__, #A " == " #B " within " #Tolerance);    \
+        }                                                                                        \
+    } while (false)
@@ -0,0 +1,45 @@
+#include "TestFramework.h"
+
+#include <ThreadPool.h>
+
+#include <atomic>
+
+using namespace topia;
+
+TOPIA_TEST(ThreadPool, EveryItemOnce)
+{
+    for (u32 NumThreads : { 1u, 3u, 8u })
+    {
+        FThreadPool Pool(NumThreads);
+        TEST_CHECK(Pool.GetNumThreads() == NumThreads);
+        for (u32 NumItems : { 0u, 1u, 2u, 7u, 1000u })
+        {
+            std::vector<std::atomic<u32>> Calls(NumItems);
+            Pool.ParallelFor(NumItems, [&Calls](u32 Index) { ++Calls[Index]; });
+            bool bOnce = true;
+            for (const std::atomic<u32>& Count : Calls)
+                bOnce = bOnce && Count.load() == 1;
+            TEST_CHECK(bOnce);
+        }
+    }
+
+    // Without a pool the items run in order on the calling thread
+    std::vector<u32> Order;
+    ParallelFor(nullptr, 5, [&Order](u32 Index) { Order.push_back(Index); });
+    TEST_CHECK((Order == std::vector<u32>{ 0, 1, 2, 3, 4 }));
+}
+
+TOPIA_TEST(ThreadPool, Nested)
+{
+    // Every item of the outer loop runs an inner loop on the same pool, which must not wait for workers that are waiting themselves
+    FThreadPool Pool(3);
+    std::atomic<u32> Sum{ 0 };
+    for (u32 Repeat = 0; Repeat < 20; ++Repeat)
+    {
+        Pool.ParallelFor(16, [&Pool, &Sum](u32 Outer)
+        {
+            Pool.ParallelFor(16, [&Sum, Outer](u32 Inner) { Sum += Outer * 16 + Inner; });
+        });
+    }
+    TEST_CHECK(Sum.load() == 20 * (255 * 256 / 2));
+}
@@ -0,0 +1,99 @@
+#include "TestFramework.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace topia;
+
+/**
+ * Runs the tests registered with TOPIA_TEST. Without arguments every test runs, otherwise only the suites named on the
+ * command line. With --bench the benchmarks registered with TOPIA_BENCHMARK run instead, filtered the same way.
+ * The exit code is the number of failed tests.
+ */
+
+static u32 sNumFailures = 0;
+
+std::vector<FTestCase>& topia::GetTestCases()
+{
+    static std::vector<FTestCase> sTestCases;
+    return sTestCases;
+}
+
+void topia::ReportTestFailure(const char* File, int Line, const char* Expression)
+{
+    printf("  %s(%d): check failed: %s\n", File, Line, Expression);
+    ++sNumFailures;
+}
+
+std::string topia::GetTestDataDirectory()
+{
+#ifdef TOPIA_TEST_DATA_DIR
+    return TOPIA_TEST_DATA_DIR "/";
+#else
+    return "Data/";
+#endif
+}
+
+std::string topia::GetTestTempDirectory()
+{
+#ifdef TOPIA_TEST_TEMP_DIR
+    return TOPIA_TEST_TEMP_DIR "/";
+#else
+    return "Temp/";
+#endif
+}
+
+static bool sIsSelected(const FTestCase& Test, const std::vector<const char*>& Suites)
+{
+    if (Suites.empty())
+    {
+        return true;
+    }
+    for (const char* pSuite : Suites)
+    {
+        if (strcmp(pSuite, Test.Suite) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    bool bBenchmarks = false;
+    std::vector<const char*> Suites;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bench") == 0)
+        {
+            bBenchmarks = true;
+        }
+        else
+        {
+            Suites.push_back(argv[i]);
+        }
+    }
+
+    u32 NumRun = 0, NumFailed = 0;
+    for (const FTestCase& Test : GetTestCases())
+    {
+        if (Test.bBenchmark != bBenchmarks || !sIsSelected(Test, Suites))
+        {
+            continue;
+        }
+
+        printf("%s.%s\n", Test.Suite, Test.Name);
+        const u32 FailuresBefore = sNumFailures;
+        Test.Function();
+        ++NumRun;
+        if (sNumFailures != FailuresBefore)
+        {
+            printf("  FAILED\n");
+            ++NumFailed;
+        }
+    }
+
+    printf("%u tests, %u failed\n", NumRun, NumFailed);
+    return NumRun == 0 ? 1 : int(NumFailed);
+}
@@ -0,0 +1,241 @@
+#include "TestFramework.h"
+
+#include <VertexQuantization.h>
+#include <TopiaMath.h>
+
+#include <cfloat>
+#include <cstring>
+
+using namespace topia;
+
+/** Through atan2, acos of a dot product close to 1 can't resolve the hundredths of a degree 16 bit encodings are tested for */
+static float sAngleDegrees(Vec3Arg A, Vec3Arg B)
+{
+    return RadiansToDegrees(std::atan2(A.Cross(B).Length(), A.Dot(B)));
+}
+
+/** Random unit vectors plus the poles, the fold of the lower hemisphere and the diagonals between the octahedron's faces */
+static std::vector<Float3> sTestDirections(std::mt19937& Random)
+{
+    std::vector<Float3> Directions = {
+        Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f), Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f),
+        Float3(0.0f, -1.0f, 0.0f), Float3(1.0e-4f, -1.0e-4f, -1.0f), Float3(-1.0e-7f, 1.0e-7f, -1.0f) };
+    for (float Z : { -1.0e-6f, 1.0e-6f, -0.5f, 0.5f })
+        for (float X : { 0.6f, -0.6f })
+            for (float Y : { 0.8f, -0.8f })
+                Directions.push_back(Float3(X * std::sqrt(1.0f - Z * Z), Y * std::sqrt(1.0f - Z * Z), Z));
+
+    std::normal_distribution<float> Normal;
+    while (Directions.size() < 1003) // Not a multiple of 4, so the last iteration of the kernels is partial
+    {
+        const Vec3 Direction(Normal(Random), Normal(Random), Normal(Random));
+        if (Direction.LengthSq() > 1.0e-6f)
+        {
+            Float3 Unit;
+            Direction.Normalized().StoreFloat3(&Unit);
+            Directions.push_back(Unit);
+        }
+    }
+    return Directions;
+}
+
+TOPIA_TEST(VertexQuantization, OctahedralNormals)
+{
+    std::mt19937 Random(41);
+    const std::vector<Float3> Normals = sTestDirections(Random);
+    const u32 NumVertices = u32(Normals.size());
+
+    for (EOctahedralPrecision Precision : { EOctahedralPrecision::Bits8, EOctahedralPrecision::Bits16 })
+    {
+        // The guard bytes after the last element must stay untouched
+        const u32 Size = GetOctahedralNormalSize(Precision);
+        std::vector<u8> Encoded(NumVertices * Size + 16, 0xcd);
+        EncodeOctahedralNormals(Normals.data(), NumVertices, Precision, Encoded.data());
+        bool bGuardIntact = true;
+        for (u32 i = NumVertices * Size; i < Encoded.size(); ++i)
+            bGuardIntact = bGuardIntact && Encoded[i] == 0xcd;
+        TEST_CHECK(bGuardIntact);
+
+        std::vector<Float3> Decoded(NumVertices);
+        DecodeOctahedralNormals(Encoded.data(), NumVertices, Precision, Decoded.data());
+        float MaxAngle = 0.0f, MaxLengthError = 0.0f;
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            MaxAngle = std::max(MaxAngle, sAngleDegrees(Vec3(Decoded[v]), Vec3(Normals[v])));
+            MaxLengthError = std::max(MaxLengthError, std::abs(Vec3(Decoded[v]).Length() - 1.0f));
+        }
+        TEST_CHECK(MaxAngle <= (Precision == EOctahedralPrecision::Bits8 ? 1.0f : 0.005f));
+        TEST_CHECK(MaxLengthError <= 1.0e-5f);
+
+        // The axes are exact, both poles included: +Z is the center of the square, -Z all four corners
+        for (u32 v = 0; v < 6; ++v)
+            TEST_CHECK(Vec3(Decoded[v]) == Vec3(Normals[v]));
+    }
+}
+
+TOPIA_TEST(VertexQuantization, OctahedralTangents)
+{
+    std::mt19937 Random(42);
+    const std::vector<Float3> Directions = sTestDirections(Random);
+    const u32 NumVertices = u32(Directions.size());
+
+    // The sign of w is all that is kept of it, 0 counts as positive
+    const float Handedness[] = { 1.0f, -1.0f, 0.5f, -0.25f, 0.0f, -FLT_MIN };
+    std::vector<Float4> Tangents(NumVertices);
+    for (u32 v = 0; v < NumVertices; ++v)
+        Tangents[v] = Float4(Directions[v].x, Directions[v].y, Directions[v].z, Handedness[v % 6]);
+
+    for (EOctahedralPrecision Precision : { EOctahedralPrecision::Bits8, EOctahedralPrecision::Bits16 })
+    {
+        const u32 Size = GetOctahedralTangentSize(Precision);
+        std::vector<u8> Encoded(NumVertices * Size + 16, 0xcd);
+        EncodeOctahedralTangents(Tangents.data(), NumVertices, Precision, Encoded.data());
+        bool bGuardIntact = true;
+        for (u32 i = NumVertices * Size; i < Encoded.size(); ++i)
+            bGuardIntact = bGuardIntact && Encoded[i] == 0xcd;
+        TEST_CHECK(bGuardIntact);
+
+        std::vector<Float4> Decoded(NumVertices);
+        DecodeOctahedralTangents(Encoded.data(), NumVertices, Precision, Decoded.data());
+        float MaxAngle = 0.0f;
+        bool bHandedness = true;
+        for (u32 v = 0; v < NumVertices; ++v)
+        {
+            MaxAngle = std::max(MaxAngle, sAngleDegrees(Vec3(Decoded[v].x, Decoded[v].y, Decoded[v].z), Vec3(Directions[v])));
+            bHandedness = bHandedness && Decoded[v].w == (Tangents[v].w < 0.0f ? -1.0f : 1.0f);
+        }
+        TEST_CHECK(MaxAngle <= (Precision == EOctahedralPrecision::Bits8 ? 1.0f : 0.005f));
+        TEST_CHECK(bHandedness);
+
+        // Normals and tangents share the direction encoding
+        std::vector<u8> EncodedNormals(NumVertices * GetOctahedralNormalSize(Precision));
+        EncodeOctahedralNormals(Directions.data(), NumVertices, Precision, EncodedNormals.data());
+        const u32 ComponentSize = Precision == EOctahedralPrecision::Bits8 ? 1 : 2;
+        bool bSameDirections = true;
+        for (u32 v = 0; v < NumVertices; ++v)
+            bSameDirections = bSameDirections && memcmp(&Encoded[v * Size], &EncodedNormals[v * 2 * ComponentSize], 2 * ComponentSize) == 0;
+        TEST_CHECK(bSameDirections);
+    }
+}
+
+TOPIA_TEST(VertexQuantization, Positions)
+{
+    std::mt19937 Random(43);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+    // A flat mesh far from the origin: Y has no extent, X and Z have very different ones
+    std::vector<Float3> Positions(101);
+    for (Float3& Position : Positions)
+        Position = Float3(1000.0f + 250.0f * Unit(Random), -3.5f, 0.01f * Unit(Random));
+    Positions[0].x = 750.0f;
+    Positions[1].x = 1250.0f;
+
+    const FPositionQuantization Quantization = ComputePositionQuantization(Positions.data(), u32(Positions.size()));
+    TEST_CHECK(Quantization.Offset.y == -3.5f && Quantization.Scale.y == 0.0f);
+    TEST_CHECK(Quantization.Offset.x == 750.0f && Quantization.Scale.x == 500.0f);
+
+    std::vector<FQuantizedPosition> Quantized(Positions.size());
+    QuantizePositions(Positions.data(), u32(Positions.size()), Quantization, Quantized.data());
+    std::vector<Float3> Decoded(Positions.size());
+    DequantizePositions(Quantized.data(), u32(Positions.size()), Quantization, Decoded.data());
+
+    // Half a step of the grid per axis, plus the rounding of the floats around 1000
+    bool bWithinStep = true, bFlatExact = true, bUnusedW = true;
+    for (size_t v = 0; v < Positions.size(); ++v)
+    {
+        bWithinStep = bWithinStep && std::abs(Decoded[v].x - Positions[v].x) <= 0.5f * Quantization.Scale.x / 65535.0f + 1.0e-4f
+            && std::abs(Decoded[v].z - Positions[v].z) <= 0.5f * Quantization.Scale.z / 65535.0f + 1.0e-9f;
+        bFlatExact = bFlatExact && Quantized[v].Y == 0 && Decoded[v].y == -3.5f;
+        bUnusedW = bUnusedW && Quantized[v].W == 0;
+    }
+    TEST_CHECK(bWithinStep);
+    TEST_CHECK(bFlatExact);
+    TEST_CHECK(bUnusedW);
+    TEST_CHECK(Quantized[0].X == 0 && Quantized[1].X == 65535);
+
+    // Every axis without extent, a single vertex
+    const Float3 Single(1.0f, 2.0f, 3.0f);
+    const FPositionQuantization SingleQuantization = ComputePositionQuantization(&Single, 1);
+    FQuantizedPosition SingleQuantized;
+    Float3 SingleDecoded;
+    QuantizePositions(&Single, 1, SingleQuantization, &SingleQuantized);
+    DequantizePositions(&SingleQuantized, 1, SingleQuantization, &SingleDecoded);
+    TEST_CHECK(Vec3(SingleDecoded) == Vec3(Single));
+
+    // Positions outside the range clamp to its ends
+    const Float3 Outside[2] = { Float3(0.0f, -3.5f, -1.0f), Float3(2000.0f, -3.5f, 1.0f) };
+    FQuantizedPosition OutsideQuantized[2];
+    QuantizePositions(Outside, 2, Quantization, OutsideQuantized);
+    TEST_CHECK(OutsideQuantized[0].X == 0 && OutsideQuantized[0].Z == 0 && OutsideQuantized[1].X == 65535 && OutsideQuantized[1].Z == 65535);
+}
+
+TOPIA_TEST(VertexQuantization, HalfTexCoords)
+{
+    // Exactly representable values, values outside [0, 1], half denormals and floats too small for a half
+    std::vector<Float2> TexCoords = {
+        Float2(0.0f, 1.0f), Float2(0.5f, -0.0f), Float2(-3.75f, 1000.5f), Float2(-65504.0f, 65504.0f), Float2(1.0e-5f, -3.0e-7f),
+        Float2(5.9604645e-8f, 6.0975552e-5f), Float2(1.0e-40f, -1.0e-9f) };
+    std::mt19937 Random(44);
+    std::uniform_real_distribution<float> Wide(-40.0f, 40.0f);
+    while (TexCoords.size() < 301) // Odd, the last element takes the path for a single texture coordinate
+        TexCoords.push_back(Float2(Wide(Random), Wide(Random)));
+    const u32 NumVertices = u32(TexCoords.size());
+
+    std::vector<HalfFloat> Encoded(NumVertices * 2 + 4, 0xcdcd);
+    EncodeHalfTexCoords(TexCoords.data(), NumVertices, Encoded.data());
+    TEST_CHECK(Encoded[NumVertices * 2] == 0xcdcd && Encoded[NumVertices * 2 + 3] == 0xcdcd);
+    std::vector<Float2> Decoded(NumVertices);
+    DecodeHalfTexCoords(Encoded.data(), NumVertices, Decoded.data());
+
+    // Round to nearest: half an ulp of the half, which is 2^-25 in the denormal range
+    const auto WithinHalfUlp = [](float Original, float Value)
+    {
+        const float Ulp = std::abs(Original) < 6.1035156e-5f ? 5.9604645e-8f : std::ldexp(1.0f, std::ilogb(Original) - 10);
+        return std::abs(Value - Original) <= 0.5f * Ulp;
+    };
+    bool bWithinHalfUlp = true;
+    for (u32 v = 0; v < NumVertices; ++v)
+        bWithinHalfUlp = bWithinHalfUlp && WithinHalfUlp(TexCoords[v].x, Decoded[v].x) && WithinHalfUlp(TexCoords[v].y, Decoded[v].y);
+    TEST_CHECK(bWithinHalfUlp);
+
+    // Values a half holds exactly survive bit for bit
+    for (u32 v = 0; v < 4; ++v)
+        TEST_CHECK(memcmp(&Decoded[v], &TexCoords[v], sizeof(Float2)) == 0);
+    TEST_CHECK(Decoded[5].x == 5.9604645e-8f && Decoded[5].y == 6.0975552e-5f); // Smallest and largest denormal
+    TEST_CHECK(Encoded[5 * 2] == 0x0001 && Encoded[5 * 2 + 1] == 0x03ff);
+    TEST_CHECK(Decoded[6].x == 0.0f && Decoded[6].y == -0.0f);
+}
+
+TOPIA_TEST(VertexQuantization, UnormColors)
+{
+    std::vector<Float4> Colors;
+    for (u32 i = 0; i < 256; ++i)
+        Colors.push_back(Float4(float(i) / 255.0f, float(255 - i) / 255.0f, (float(i) + 0.49f) / 255.0f, (float(i) + 0.51f) / 255.0f));
+    Colors.push_back(Float4(-0.5f, 1.5f, -FLT_MAX, 100.0f));
+    const u32 NumVertices = u32(Colors.size());
+
+    std::vector<u32> Encoded(NumVertices);
+    EncodeUnormColors(Colors.data(), NumVertices, Encoded.data());
+    std::vector<Float4> Decoded(NumVertices);
+    DecodeUnormColors(Encoded.data(), NumVertices, Decoded.data());
+
+    // R in the lowest byte, steps encode to themselves again after decoding, everything else goes to the nearest step
+    std::vector<u32> Reencoded(NumVertices);
+    EncodeUnormColors(Decoded.data(), NumVertices, Reencoded.data());
+    TEST_CHECK(Reencoded == Encoded);
+    bool bLayout = true, bExact = true, bNearest = true;
+    for (u32 i = 0; i < 256; ++i)
+    {
+        const u32 A = std::min(i + 1, 255u);
+        bLayout = bLayout && Encoded[i] == (i | ((255 - i) << 8) | (i << 16) | (A << 24));
+        bExact = bExact && std::abs(Decoded[i].x - Colors[i].x) <= 1.0e-7f && std::abs(Decoded[i].y - Colors[i].y) <= 1.0e-7f;
+        bNearest = bNearest && std::abs(Decoded[i].z - Colors[i].z) <= 0.5f / 255.0f && std::abs(Decoded[i].w - std::min(Colors[i].w, 1.0f)) <= 0.5f / 255.0f;
+    }
+    TEST_CHECK(bLayout);
+    TEST_CHECK(bExact);
+    TEST_CHECK(bNearest);
+
+    // Outside [0, 1] clamps
+    TEST_CHECK(Encoded[256] == 0xff00ff00u);
+    TEST_CHECK(Vec4::sLoadFloat4(&Decoded[256]) == Vec4(0.0f, 1.0f, 0.0f, 1.0f));
+}
@@ -0,0 +1,125 @@
+#include "TestFramework.h"
+
+#include <FileSystem/Archive.h>
+#include <FileSystem/VirtualFileSystem.h>
+
+#include <cstring>
+#include <thread>
+
+using namespace topia;
+
+static std::vector<u8> sBytes(const char* pText)
+{
+    return std::vector<u8>(pText, pText + strlen(pText));
+}
+
+static bool sReadsAs(const FVirtualFileSystem& FileSystem, const char* pPath, const char* pExpected)
+{
+    std::vector<u8> Data;
+    u64 Size = 0;
+    return FileSystem.Read(FPath(pPath), Data) && Data == sBytes(pExpected) && FileSystem.GetSize(FPath(pPath), Size) && Size == Data.size();
+}
+
+/** Loose files of the test data, the names are lower case so case sensitive file systems find them under their normalized path */
+static std::unique_ptr<IMountPoint> sLooseMount()
+{
+    return std::unique_ptr<IMountPoint>(new FLooseDirectoryMount(UTF8ToWide(GetTestDataDirectory() + "VirtualFileSystem")));
+}
+
+static std::wstring sWriteArchive()
+{
+    FArchiveWriter Writer(64);
+    Writer.AddFile("Shaders/Common.hlsl", sBytes("float4 Packed;\n"));
+    Writer.AddFile("Textures/Packed.ttex", sBytes("packed texture, long enough to use a few blocks of the archive"));
+    const std::wstring Path = UTF8ToWide(GetTestTempDirectory() + "VirtualFileSystem.tpak");
+    TEST_CHECK(Writer.Write(Path));
+    return Path;
+}
+
+TOPIA_TEST(VirtualFileSystem, MemoryMountsAndPrefixes)
+{
+    std::unique_ptr<FMemoryMount> Root(new FMemoryMount());
+    Root->AddFile("Shaders/Common.hlsl", sBytes("root common"));
+    Root->AddFile("Shaders/Only.hlsl", sBytes("root only"));
+    Root->AddFile("ShadersX/Common.hlsl", sBytes("not below shaders/"));
+    std::unique_ptr<FMemoryMount> Shaders(new FMemoryMount());
+    Shaders->AddFile("common.hlsl", sBytes("shaders common"));
+    Shaders->AddFile("Empty.hlsl", std::vector<u8>());
+
+    FVirtualFileSystem FileSystem;
+    FileSystem.Mount("", std::move(Root));
+    FileSystem.Mount("Shaders", std::move(Shaders));
+
+    // The later mount overrides, files it doesn't have come from the earlier one, the prefix only matches whole directories
+    TEST_CHECK(sReadsAs(FileSystem, "shaders/common.hlsl", "shaders common"));
+    TEST_CHECK(sReadsAs(FileSystem, "SHADERS\\Common.HLSL", "shaders common"));
+    TEST_CHECK(sReadsAs(FileSystem, "shaders/only.hlsl", "root only"));
+    TEST_CHECK(sReadsAs(FileSystem, "shadersx/common.hlsl", "not below shaders/"));
+    TEST_CHECK(sReadsAs(FileSystem, "shaders/empty.hlsl", ""));
+
+    u64 Size = 1;
+    std::vector<u8> Data;
+    TEST_CHECK(!FileSystem.Exists(FPath("shaders/missing.hlsl")) && !FileSystem.Read(FPath("missing"), Data));
+    TEST_CHECK(!FileSystem.Exists(FPath()) && !FileSystem.GetSize(FPath(), Size) && Size == 1);
+    TEST_CHECK(!FileSystem.Exists(FPath("shaders/")) && !FileSystem.Exists(FPath("shaders")));
+
+    FileSystem.UnmountAll();
+    TEST_CHECK(!FileSystem.Exists(FPath("shaders/common.hlsl")));
+}
+
+TOPIA_TEST(VirtualFileSystem, LooseDirectoriesAndArchives)
+{
+    const std::wstring ArchivePath = sWriteArchive();
+
+    // The loose directory is mounted after the archive, its files override the packed ones
+    FVirtualFileSystem FileSystem;
+    std::unique_ptr<FArchiveMount> Archive(new FArchiveMount(ArchivePath));
+    TEST_CHECK(Archive->IsOpen());
+    FileSystem.Mount("", std::move(Archive));
+    FileSystem.Mount("Packed/", std::unique_ptr<IMountPoint>(new FArchiveMount(ArchivePath)));
+    FileSystem.Mount("", sLooseMount());
+    FileSystem.Mount("Missing/", std::unique_ptr<IMountPoint>(new FArchiveMount(ArchivePath + L".missing")));
+
+    TEST_CHECK(sReadsAs(FileSystem, "shaders/common.hlsl", "float4 Loose;\n"));
+    TEST_CHECK(sReadsAs(FileSystem, "textures/checker.ttex", "loose checker\n"));
+    TEST_CHECK(sReadsAs(FileSystem, "Textures/Packed.ttex", "packed texture, long enough to use a few blocks of the archive"));
+
+    // Below a prefix the archive is searched with the hash of the relative path instead of the one of the interned path
+    TEST_CHECK(sReadsAs(FileSystem, "packed/shaders/common.hlsl", "float4 Packed;\n"));
+    TEST_CHECK(sReadsAs(FileSystem, "packed/textures/packed.ttex", "packed texture, long enough to use a few blocks of the archive"));
+    TEST_CHECK(!FileSystem.Exists(FPath("packed/textures/checker.ttex")));
+    TEST_CHECK(!FileSystem.Exists(FPath("missing/shaders/common.hlsl")));
+    TEST_CHECK(!FileSystem.Exists(FPath("textures")));
+}
+
+TOPIA_TEST(VirtualFileSystem, ConcurrentReads)
+{
+    const std::wstring ArchivePath = sWriteArchive();
+    FVirtualFileSystem FileSystem;
+    FileSystem.Mount("packed", std::unique_ptr<IMountPoint>(new FArchiveMount(ArchivePath)));
+    FileSystem.Mount("", sLooseMount());
+    std::unique_ptr<FMemoryMount> Memory(new FMemoryMount());
+    Memory->AddFile("generated.bin", sBytes("generated"));
+    FileSystem.Mount("memory", std::move(Memory));
+
+    std::atomic<u32> NumFailed(0);
+    std::vector<std::thread> Threads;
+    for (u32 t = 0; t < 4; ++t)
+    {
+        Threads.emplace_back([&FileSystem, &NumFailed]()
+        {
+            for (u32 i = 0; i < 200; ++i)
+            {
+                const bool bRead = sReadsAs(FileSystem, "packed/shaders/common.hlsl", "float4 Packed;\n")
+                    && sReadsAs(FileSystem, "shaders/common.hlsl", "float4 Loose;\n") && sReadsAs(FileSystem, "memory/generated.bin", "generated")
+                    && !FileSystem.Exists(FPath("memory/missing.bin"));
+                NumFailed += bRead ? 0 : 1;
+            }
+        });
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    TEST_CHECK(NumFailed == 0);
+}